@@ -0,0 +1,143 @@
+/*
+ * bench.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+#include "bitec_hal.h"
+#include "bench.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#ifdef CONFIG_BENCH_RUNS
+#define BENCH_RUNS		CONFIG_BENCH_RUNS
+#else
+#define BENCH_RUNS		9
+#endif
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static double measure(const bench_case_t * bench);
+static bool baseline_get(const char * baseline, const char * name, double * cost);
+
+/* external functions definition ---------------------------------------------*/
+
+int bench_run(const bench_case_t * cases, size_t cases_num, const char * baseline, uint32_t threshold, bool missing_fail)
+{
+	int regressions = 0;
+	int missing = 0;
+	double * costs = malloc(cases_num * sizeof(double));
+
+	if(costs == NULL)
+		return -1;
+
+	printf("bench: %u runs, cost per call in %s, threshold %" PRIu32 " %%\n", BENCH_RUNS, BENCH_UNIT, threshold);
+
+	for(size_t i = 0; i < cases_num; i++)
+	{
+		double reference;
+
+		costs[i] = measure(&cases[i]);
+
+		/* A case without a baseline could never fail, it has to be recorded first */
+		if(!baseline_get(baseline, cases[i].name, &reference) || reference <= 0)
+		{
+			missing++;
+			printf("bench: %-24s %10.1f %10s %8s  %s, no baseline\n", cases[i].name, costs[i], "-", "",
+					missing_fail ? "FAIL" : "skipped");
+			continue;
+		}
+
+		double delta = (costs[i] - reference) * 100 / reference;
+		bool regression = delta > threshold;
+
+		if(regression)
+			regressions++;
+
+		printf("bench: %-24s %10.1f %10.1f %+6.1f %%  %s\n", cases[i].name, costs[i], reference, delta,
+				regression ? "FAIL" : "ok");
+	}
+
+	for(size_t i = 0; i < cases_num; i++)
+	{
+		if(cases[i].items > 0 && costs[i] > 0)
+			printf("bench: %-24s %10.3f Mitems/s\n", cases[i].name, cases[i].items * BENCH_UNIT_HZ / costs[i] / 1e6);
+	}
+
+	/* Ready to be stored as the new baseline when a change is expected */
+	printf("bench: baseline\n");
+
+	for(size_t i = 0; i < cases_num; i++)
+		printf("%s %.1f\n", cases[i].name, costs[i]);
+
+	printf("bench: %d regressions, %d cases without baseline%s\n", regressions, missing, missing_fail || missing == 0 ? "" : ", skipped");
+
+	free(costs);
+
+	return regressions + (missing_fail ? missing : 0);
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static double measure(const bench_case_t * bench)
+{
+	uint32_t best = UINT32_MAX;
+
+	/* Warm up caches and lazy initializations */
+	bench->fn(bench->arg);
+
+	/* The fastest run is the least disturbed by interrupts and other tasks */
+	for(uint8_t run = 0; run < BENCH_RUNS; run++)
+	{
+		uint32_t start = hal_cycle_count();
+
+		for(uint32_t i = 0; i < bench->iterations; i++)
+			bench->fn(bench->arg);
+
+		uint32_t cost = hal_cycle_count() - start;
+
+		if(cost < best)
+			best = cost;
+	}
+
+	return (double)best / bench->iterations;
+}
+
+static bool baseline_get(const char * baseline, const char * name, double * cost)
+{
+	size_t len = strlen(name);
+
+	while(baseline != NULL && * baseline != '\0')
+	{
+		/* Lines are "<name> <cost>", everything after a # is a comment */
+		if(!strncmp(baseline, name, len) && (baseline[len] == ' ' || baseline[len] == '\t'))
+		{
+			* cost = strtod(baseline + len, NULL);
+			return true;
+		}
+
+		baseline = strchr(baseline, '\n');
+
+		if(baseline != NULL)
+			baseline++;
+	}
+
+	return false;
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,69 @@
+/*
+ * bench.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+#define BENCH_UNIT		"ns"
+#define BENCH_UNIT_HZ	1000000000.0
+#else
+#define BENCH_UNIT		"cycles"
+#ifdef CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+#define BENCH_UNIT_HZ	(CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1000000.0)
+#else
+#define BENCH_UNIT_HZ	(CONFIG_ESP32S2_DEFAULT_CPU_FREQ_MHZ * 1000000.0)
+#endif
+#endif
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef void (* bench_fn_t)(void * arg);
+
+typedef struct
+{
+	const char * name;		/*!< Name in the baseline, without spaces */
+	bench_fn_t fn;			/*!< Code path to time, called iterations times per run */
+	void * arg;
+	uint32_t iterations;
+	uint32_t items;			/*!< Items processed per call to report a throughput, 0 for none */
+} bench_case_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Run every case and compare it with the baseline text, lines of "<name> <cost>".
+ * Returns the number of cases slower than their baseline by more than threshold percent,
+ * plus the ones missing from it if missing_fail is set. Otherwise those are only reported */
+int bench_run(const bench_case_t * cases, size_t cases_num, const char * baseline, uint32_t threshold, bool missing_fail);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BENCH_H_ */
@@ -0,0 +1,480 @@
+/*
+ * bench_main.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "esp_log.h"
+#include "cJSON.h"
+
+#include "bitec_hal.h"
+#include "bitec_payload.h"
+#include "bitec_input.h"
+#include "bitec_rules.h"
+#include "bitec_settings.h"
+#include "bitec_trace.h"
+#include "bl0937.h"
+#include "ws2812_led.h"
+#include "ws2812_anim.h"
+#include "led_strip.h"
+#include "bench.h"
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+#include "bitec_hal_linux.h"
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#ifdef CONFIG_BENCH_THRESHOLD
+#define BENCH_THRESHOLD		CONFIG_BENCH_THRESHOLD
+#elif defined(CONFIG_IDF_TARGET_LINUX)
+#define BENCH_THRESHOLD		150
+#else
+#define BENCH_THRESHOLD		15
+#endif
+
+#ifdef CONFIG_BENCH_MISSING_FAIL
+#define BENCH_MISSING_FAIL	true
+#else
+#define BENCH_MISSING_FAIL	false
+#endif
+
+/* Same values as the firmware */
+#define LDR_CHANNEL			6			/*!< Light sensor ADC1 channel */
+#define NO_OF_SAMPLES		64			/*!< Light sensor multisampling */
+#define DEVICE_ID			"fc97e0d4-1623-49e4-950f-3fb3594ea8ba"
+#define INPUT_PIN			8			/*!< PIR sensor input GPIO */
+
+#define LED_BYTES			3			/*!< GRB bytes of one LED */
+#define FRAME_LEDS			60			/*!< LEDs of the longest strip in use */
+#define ANIM_FRAME_MS		20			/*!< Frame time of the default frame rate */
+#define INPUT_EDGES			16			/*!< Edges dispatched per call */
+#define LOG_LINE_SIZE		128			/*!< Longest log line formatted */
+
+/* Slowest program, blocks of 12 bytes running every instruction filling the program size, the
+ * remaining bytes are empty rules */
+#define RULES_BLOCK_SIZE	12
+#define RULES_BLOCKS		((RULES_SIZE - RULES_HEADER_SIZE - 1) / RULES_BLOCK_SIZE)
+#define RULES_WORST			(RULES_BLOCKS + (RULES_SIZE - RULES_HEADER_SIZE - 1) % RULES_BLOCK_SIZE)
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static const char * TAG = "bench";
+
+static bl0937_t bl0937;
+static bitec_input_t input;
+static bitec_rules_t rules;
+static bitec_rules_t rules_worst;
+static bitec_settings_t settings;
+static uint8_t led_bytes[LED_BYTES * FRAME_LEDS];
+static hal_rmt_item_t led_items[LED_BYTES * FRAME_LEDS * 8];
+static ws2812_led_hsv_t led_hsv[FRAME_LEDS];
+static ws2812_led_rgb_t led_rgb[FRAME_LEDS];
+static bitec_payload_t payload =
+{
+	.light = true,
+	.illumination = 1834,
+	.presence = true,
+	.voltage = 221,
+	.current = 0.45,
+	.power = 99.45,
+};
+
+/* Publish on high power, presence in the dark switches the relay on, blue LED while it is on */
+static const uint8_t rules_program[] =
+{
+	RULES_VERSION, 3,
+	RULES_OP_RULE, RULES_OP_LOAD, RULES_VAR_POWER, RULES_OP_PUSH16, 100, 0, RULES_OP_GT,
+	RULES_OP_SKIPZ, 2, RULES_OP_PUBLISH, 1,
+	RULES_OP_RULE, RULES_OP_LOAD, RULES_VAR_PRESENCE, RULES_OP_LOAD, RULES_VAR_ILLUMINATION,
+	RULES_OP_PUSH16, 0xac, 0x0d, RULES_OP_LT, RULES_OP_AND, RULES_OP_RELAY,
+	RULES_OP_RULE, RULES_OP_LOAD, RULES_VAR_LIGHT, RULES_OP_SKIPZ, 4, RULES_OP_LED, 0, 0, 64,
+	RULES_OP_END
+};
+static const int32_t rules_vars[RULES_VAR_MAX] =
+{
+	[RULES_VAR_ILLUMINATION] = 1834,
+	[RULES_VAR_PRESENCE] = 1,
+	[RULES_VAR_POWER] = 99,
+	[RULES_VAR_VOLTAGE] = 221,
+	[RULES_VAR_CURRENT] = 450,
+	[RULES_VAR_MINUTE] = 1110,
+	[RULES_VAR_LIGHT] = 1,
+};
+
+/* Part of the firmware settings, a message sets two of them */
+static const bitec_settings_entry_t settings_entries[] =
+{
+	{ "id", SETTINGS_STRING, 0, 36, 0, DEVICE_ID, SETTINGS_RESTART },
+	{ "measure_time", SETTINGS_INT, 100, 60000, 500, NULL, 0 },
+	{ "dark_level", SETTINGS_INT, 0, 8191, 2000, NULL, 0 },
+	{ "bright_level", SETTINGS_INT, 0, 8191, 4000, NULL, 0 },
+	{ "hold_time", SETTINGS_INT, 0, 3600000, 30000, NULL, 0 },
+	{ "max_power", SETTINGS_INT, 1, 100000, 2200, NULL, 0 },
+};
+static const char settings_message[] = "{\"dark_level\":3500,\"hold_time\":10000}";
+
+static ws2812_anim_t breathe = WS2812_ANIM_DEFAULT(WS2812_ANIM_BREATHE, 0, 0, 255, 2000);
+static ws2812_anim_t chase =
+{
+	.type = WS2812_ANIM_CHASE,
+	.ease = WS2812_EASE_IN_OUT,
+	.green = 255,
+	.width = 8,
+	.period_ms = 1500,
+};
+static ws2812_anim_t fade = WS2812_ANIM_DEFAULT(WS2812_ANIM_FADE_TO, 255, 128, 0, 600000);
+
+/* external data declaration -------------------------------------------------*/
+
+extern const char baseline_start[] asm("_binary_baseline_txt_start");
+
+/* internal functions declaration --------------------------------------------*/
+
+static int bench_main(const char * baseline);
+static void bl0937_setup(void);
+static void bl0937_multipliers_bench(void * arg);
+static void bl0937_getters_bench(void * arg);
+static void hsv2rgb_bench(void * arg);
+static void hsv2rgb_batch_bench(void * arg);
+static void rmt_adapter_bench(void * arg);
+static void rmt_adapter_frame_bench(void * arg);
+static void json_bench(void * arg);
+static void adc_average_bench(void * arg);
+static void anim_render_bench(void * arg);
+static void anim_frame_bench(void * arg);
+static void input_dispatch_bench(void * arg);
+static esp_err_t rules_setup(void);
+static void rules_eval_bench(void * arg);
+static void settings_parse_bench(void * arg);
+static void trace_record_bench(void * arg);
+static void esp_logi_bench(void * arg);
+#ifdef CONFIG_IDF_TARGET_LINUX
+static int log_sink(const char * format, va_list args);
+#endif
+
+/* Cases run in this order, names are the keys of the baselines */
+static const bench_case_t cases[] =
+{
+	{ "bl0937_multipliers", bl0937_multipliers_bench, NULL, 1000, 0 },
+	{ "bl0937_getters", bl0937_getters_bench, NULL, 1000, 0 },
+	{ "ws2812_hsv2rgb", hsv2rgb_bench, NULL, 360, 0 },
+	{ "ws2812_hsv2rgb_batch", hsv2rgb_batch_bench, NULL, 100, FRAME_LEDS },
+	{ "ws2812_rmt_adapter", rmt_adapter_bench, NULL, 1000, LED_BYTES * 8 },
+	{ "ws2812_rmt_adapter_frame", rmt_adapter_frame_bench, NULL, 100, LED_BYTES * FRAME_LEDS * 8 },
+	{ "payload_json", json_bench, NULL, 100, 0 },
+	{ "adc_average", adc_average_bench, NULL, 10, 0 },
+	{ "ws2812_anim_breathe", anim_render_bench, &breathe, 100, CONFIG_WS2812_LED_LENGTH },
+	{ "ws2812_anim_chase", anim_render_bench, &chase, 100, CONFIG_WS2812_LED_LENGTH },
+	{ "ws2812_anim_fade_to", anim_render_bench, &fade, 100, CONFIG_WS2812_LED_LENGTH },
+	{ "ws2812_anim_frame", anim_frame_bench, &chase, 100, CONFIG_WS2812_LED_LENGTH },
+	{ "input_dispatch", input_dispatch_bench, NULL, 100, INPUT_EDGES },
+	{ "rules_eval", rules_eval_bench, &rules, 1000, 3 },
+	{ "rules_eval_worst", rules_eval_bench, &rules_worst, 100, RULES_WORST },
+	{ "settings_parse", settings_parse_bench, NULL, 100, 2 },
+	{ "trace_record", trace_record_bench, NULL, 10000, 0 },
+	{ "esp_logi", esp_logi_bench, NULL, 100, 0 },
+};
+
+/* external functions definition ---------------------------------------------*/
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+int main(int argc, char * argv[])
+{
+	/* Host runs can compare against another baseline file, such as one of a CI machine */
+	char * baseline = NULL;
+
+	if(argc > 1)
+	{
+		FILE * file = fopen(argv[1], "r");
+
+		if(file == NULL)
+		{
+			fprintf(stderr, "Unable to open %s\n", argv[1]);
+			return EXIT_FAILURE;
+		}
+
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		rewind(file);
+
+		baseline = calloc(1, size + 1);
+
+		if(baseline != NULL)
+			fread(baseline, 1, size, file);
+
+		fclose(file);
+	}
+
+	hal_linux_reset();
+	hal_linux_adc_set(LDR_CHANNEL, 1834);
+
+	int regressions = bench_main(baseline != NULL ? baseline : baseline_start);
+
+	free(baseline);
+
+	return regressions == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+#else
+void app_main(void)
+{
+	int regressions = bench_main(baseline_start);
+
+	ESP_LOGI(TAG, "%s", regressions == 0 ? "PASS" : "FAIL");
+}
+#endif
+
+/* internal functions definition ---------------------------------------------*/
+
+static int bench_main(const char * baseline)
+{
+	bl0937_setup();
+
+	/* Mixed bits, every nibble value is used */
+	for(size_t i = 0; i < sizeof(led_bytes); i++)
+		led_bytes[i] = (uint8_t)(i * 37);
+
+	/* A rainbow along the strip, every hue sector is used */
+	for(size_t i = 0; i < FRAME_LEDS; i++)
+	{
+		led_hsv[i].hue = i * 360 / FRAME_LEDS;
+		led_hsv[i].saturation = 255;
+		led_hsv[i].value = 128;
+	}
+
+	if(ws2812_led_init() != ESP_OK || hal_adc_config(LDR_CHANNEL) != ESP_OK)
+	{
+		ESP_LOGE(TAG, "Unable to initialize the peripherals");
+		return -1;
+	}
+
+	/* Input service without its task, the case dispatches the edges */
+	input.edges = xQueueCreate(INPUT_EDGES, sizeof(bitec_input_edge_t));
+	input.queue = xQueueCreate(INPUT_EDGES, sizeof(bitec_input_event_t));
+
+	if(input.edges == NULL || input.queue == NULL || bitec_input_add(&input, INPUT_PIN, HAL_GPIO_PULL_DOWN, 0, NULL) != ESP_OK)
+	{
+		ESP_LOGE(TAG, "Unable to initialize the inputs");
+		return -1;
+	}
+
+	if(rules_setup() != ESP_OK)
+	{
+		ESP_LOGE(TAG, "Unable to load the rules");
+		return -1;
+	}
+
+	if(bitec_settings_init(&settings, settings_entries, sizeof(settings_entries) / sizeof(settings_entries[0]), 1) != ESP_OK)
+	{
+		ESP_LOGE(TAG, "Unable to register the settings");
+		return -1;
+	}
+
+	bitec_trace_init();
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+	/* No UART on the host, the log lines are formatted and dropped instead of
+	 * flooding the output. On the board they go through the UART and its
+	 * transmission is part of the esp_logi cost */
+	vprintf_like_t vprintf_func = esp_log_set_vprintf(log_sink);
+	int regressions = bench_run(cases, sizeof(cases) / sizeof(cases[0]), baseline, BENCH_THRESHOLD, BENCH_MISSING_FAIL);
+
+	esp_log_set_vprintf(vprintf_func);
+
+	return regressions;
+#else
+	return bench_run(cases, sizeof(cases) / sizeof(cases[0]), baseline, BENCH_THRESHOLD, BENCH_MISSING_FAIL);
+#endif
+}
+
+static void bl0937_setup(void)
+{
+	/* No interrupts, fixed pulse widths of a 221 V 0.45 A load */
+	bl0937.sel_pin = CONFIG_BL0937_SEL_PIN;
+	bl0937.current_resistor = (float)CONFIG_BL0937_R_CURRENT / 1000;
+	bl0937.voltage_resistor = CONFIG_BL0937_R_VOLTAGE;
+	bl0937.vref = V_REF;
+	bl0937.pulse_timeout = UINT32_MAX;
+	bl0937.voltage_pulse_width = 1280;
+	bl0937.current_pulse_width = 9810;
+	bl0937.power_pulse_width = 72400;
+	bl0937.current_mode = MODE_CURRENT;
+	bl0937.mode = MODE_CURRENT;
+	bl0937.last_cf_interrupt = bl0937.last_cf1_interrupt = bl0937.first_cf1_interrupt = hal_time_us();
+
+	bl0937_reset_multipliers(&bl0937);
+}
+
+static void bl0937_multipliers_bench(void * arg)
+{
+	bl0937_reset_multipliers(&bl0937);
+}
+
+static void bl0937_getters_bench(void * arg)
+{
+	/* The getters of a status message */
+	bl0937_get_voltage(&bl0937);
+	bl0937_get_current(&bl0937);
+	bl0937_get_apparent_power(&bl0937);
+}
+
+static void hsv2rgb_bench(void * arg)
+{
+	static uint32_t hue = 0;
+	uint32_t red, green, blue;
+
+	ws2812_led_hsv2rgb(hue++, 100, 25, &red, &green, &blue);
+}
+
+static void hsv2rgb_batch_bench(void * arg)
+{
+	/* Rainbow frame with gamma correction */
+	ws2812_led_hsv2rgb_batch(led_hsv, led_rgb, FRAME_LEDS, true);
+}
+
+static void rmt_adapter_bench(void * arg)
+{
+	size_t translated_size, item_num;
+
+	ws2812_rmt_adapter(led_bytes, led_items, LED_BYTES, LED_BYTES * 8, &translated_size, &item_num);
+}
+
+static void rmt_adapter_frame_bench(void * arg)
+{
+	size_t translated_size, item_num;
+
+	ws2812_rmt_adapter(led_bytes, led_items, sizeof(led_bytes), sizeof(led_items) / sizeof(led_items[0]), &translated_size, &item_num);
+}
+
+static void json_bench(void * arg)
+{
+	char * string = bitec_payload_print(DEVICE_ID, &payload);
+
+	cJSON_free(string);
+}
+
+static void adc_average_bench(void * arg)
+{
+	bitec_payload_adc_average(LDR_CHANNEL, NO_OF_SAMPLES);
+}
+
+static void anim_render_bench(void * arg)
+{
+	/* A new frame every call, as paced by the render task */
+	static uint32_t elapsed = 0;
+
+	ws2812_anim_render((const ws2812_anim_t *)arg, elapsed += ANIM_FRAME_MS);
+}
+
+static void anim_frame_bench(void * arg)
+{
+	/* Whole frame time of the render task, from the render until the strip got it */
+	static uint32_t elapsed = 0;
+
+	ws2812_anim_render((const ws2812_anim_t *)arg, elapsed += ANIM_FRAME_MS);
+	ws2812_led_present();
+	ws2812_led_wait(100);
+}
+
+static void input_dispatch_bench(void * arg)
+{
+	bitec_input_event_t event;
+
+	/* Pulse train with no filter, every edge is an event */
+	for(uint32_t i = 0; i < INPUT_EDGES; i++)
+	{
+#ifdef CONFIG_IDF_TARGET_LINUX
+		/* Through the interrupt handler */
+		hal_linux_gpio_drive(INPUT_PIN, i % 2 == 0);
+#else
+		bitec_input_edge_t edge = { .index = 0, .level = i % 2 == 0, .time = hal_time_us() };
+
+		xQueueSend(input.edges, &edge, 0);
+#endif
+	}
+
+	bitec_input_dispatch(&input, 0);
+
+	while(xQueueReceive(input.queue, &event, 0) == pdTRUE)
+		;
+}
+
+static esp_err_t rules_setup(void)
+{
+	uint8_t code[RULES_SIZE];
+	size_t size = RULES_HEADER_SIZE;
+
+	esp_err_t ret = bitec_rules_load(&rules, rules_program, sizeof(rules_program));
+
+	if(ret != ESP_OK)
+		return ret;
+
+	/* Conditions true for rules_vars, no instruction is skipped */
+	for(uint32_t i = 0; i < RULES_BLOCKS; i++)
+	{
+		const uint8_t block[RULES_BLOCK_SIZE] =
+		{
+			RULES_OP_RULE, RULES_OP_LOAD, RULES_VAR_ILLUMINATION, RULES_OP_PUSH8, 0, RULES_OP_GT,
+			RULES_OP_NOT, RULES_OP_NOT, RULES_OP_SKIPZ, 2, RULES_OP_PUBLISH, i % 32
+		};
+
+		memcpy(&code[size], block, sizeof(block));
+		size += sizeof(block);
+	}
+
+	while(size < RULES_SIZE - 1)
+		code[size++] = RULES_OP_RULE;
+
+	code[0] = RULES_VERSION;
+	code[1] = RULES_WORST;
+	code[size++] = RULES_OP_END;
+
+	return bitec_rules_load(&rules_worst, code, size);
+}
+
+static void rules_eval_bench(void * arg)
+{
+	bitec_rules_output_t output;
+
+	bitec_rules_eval((bitec_rules_t *)arg, rules_vars, &output);
+}
+
+static void settings_parse_bench(void * arg)
+{
+	/* Checked and set in the cache, without the commit */
+	bitec_settings_parse(&settings, settings_message, sizeof(settings_message) - 1);
+}
+
+static void trace_record_bench(void * arg)
+{
+	/* A status publish with the trace enabled */
+	bitec_trace_record(TRACE_APP_PUBLISH_STATUS, 312, 42);
+}
+
+static void esp_logi_bench(void * arg)
+{
+	/* The same publish with the trace disabled, written to the UART on the board */
+	ESP_LOGI(TAG, "Published to status topic, len=%d, msg_id=%d", 312, 42);
+}
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+static int log_sink(const char * format, va_list args)
+{
+	/* Formatted as for the UART, then dropped */
+	char line[LOG_LINE_SIZE];
+
+	return vsnprintf(line, sizeof(line), format, args);
+}
+#endif
+
+/* end of file ---------------------------------------------------------------*/
@@ -12,9 +12,7 @@
 
 /* macros --------------------------------------------------------------------*/
 
-#define SHORT_TIME	pdMS_TO_TICKS(CONFIG_BITEC_BUTTON_DEBOUNCE_SHORT_TIME)
-#define MEDIUM_TIME	pdMS_TO_TICKS(CONFIG_BITEC_BUTTON_DEBOUNCE_MEDIUM_TIME)
-#define LONG_TIME	pdMS_TO_TICKS(CONFIG_BITEC_BUTTON_DEBOUNCE_LONG_TIME)
+#define SAMPLE_TIME	pdMS_TO_TICKS(CONFIG_BITEC_BUTTON_SAMPLE_TIME)
 
 /* typedef -------------------------------------------------------------------*/
 
@@ -27,6 +25,9 @@ static const char * TAG = "digihome_button";
 /* internal functions declaration --------------------------------------------*/
 
 static void isr_handler(void * arg);
+static void sample_timer(TimerHandle_t timer);
+static bool is_pressed(bitec_button_t * const me);
+static uint32_t now_ms(void);
 
 /* external functions definition ---------------------------------------------*/
 
@@ -36,49 +37,38 @@ esp_err_t bitec_button_init(bitec_button_t * const me)
 
 	ESP_LOGI(TAG, "Initializing button...");
 
-	/* Create Wi-Fi event group */
-	me->event_group = xEventGroupCreate();
-
-	/* Initialize button GPIO */
-	gpio_config_t gpio_conf;
-	gpio_conf.pin_bit_mask = 1ULL << CONFIG_BITEC_BUTTON_PIN;
-	gpio_conf.mode = GPIO_MODE_INPUT;
+	me->pin = CONFIG_BITEC_BUTTON_PIN;
+	me->dropped = 0;
 
-	if(me->mode == FALLING_MODE)
-	{
-		gpio_conf.pull_up_en = GPIO_PULLUP_ENABLE;
-		gpio_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
-		me->state = FALLING_STATE;
-	}
-	else if(me->mode == RISING_MODE)
-	{
-		gpio_conf.pull_up_en = GPIO_PULLUP_DISABLE;
-		gpio_conf.pull_down_en = GPIO_PULLDOWN_ENABLE;
-		me->state = RISING_STATE;
-	}
+	/* Create button events queue */
+	me->queue = xQueueCreate(CONFIG_BITEC_BUTTON_QUEUE_LEN, sizeof(bitec_button_event_t));
 
-	gpio_conf.intr_type = GPIO_INTR_ANYEDGE;
-	ret = gpio_config(&gpio_conf);
+	if(me->queue == NULL)
+		return ESP_ERR_NO_MEM;
 
-	if(ret != ESP_OK)
-		return ret;
+	/* Create sampling timer, it only runs from the first edge until the button is idle again */
+	me->timer = xTimerCreate("Button Timer", SAMPLE_TIME > 0 ? SAMPLE_TIME : 1, pdTRUE, (void *)me, sample_timer);
 
-	/* Install ISR service and add ISR handler */
-	gpio_install_isr_service(0);
+	if(me->timer == NULL)
+		return ESP_ERR_NO_MEM;
 
-	if(ret != ESP_OK)
-			return ret;
+	/* Initialize button GPIO */
+	hal_gpio_pull_e pull = me->mode == FALLING_MODE ? HAL_GPIO_PULL_UP : HAL_GPIO_PULL_DOWN;
 
-	ret = gpio_isr_handler_add(CONFIG_BITEC_BUTTON_PIN, isr_handler, (void *)me);
+	ret = hal_gpio_config_input(1ULL << me->pin, pull, HAL_GPIO_INTR_ANYEDGE);
 
 	if(ret != ESP_OK)
 		return ret;
 
-	/*  */
-	me->pin = CONFIG_BITEC_BUTTON_PIN;
-	me->tick_counter = 0;
+	/* Initialize gestures engine */
+	me->gesture.debounce_time = CONFIG_BITEC_BUTTON_DEBOUNCE_TIME;
+	me->gesture.double_click_time = CONFIG_BITEC_BUTTON_DOUBLE_CLICK_TIME;
+	me->gesture.hold_time = CONFIG_BITEC_BUTTON_HOLD_TIME;
+	me->gesture.repeat_time = CONFIG_BITEC_BUTTON_REPEAT_TIME;
+	bitec_gesture_init(&me->gesture, is_pressed(me), now_ms());
 
-	return ESP_OK;
+	/* Add ISR handler */
+	return hal_gpio_isr_add(me->pin, isr_handler, (void *)me);
 }
 
 /* internal functions definition ---------------------------------------------*/
@@ -86,40 +76,51 @@ esp_err_t bitec_button_init(bitec_button_t * const me)
 static void isr_handler(void * arg)
 {
 	bitec_button_t * button = (bitec_button_t *)arg;
+	BaseType_t task_woken = pdFALSE;
+
+	/* Bounces are filtered by sampling, the interrupt stays masked until the button is idle */
+	hal_gpio_intr_enable(button->pin, false);
+	xTimerStartFromISR(button->timer, &task_woken);
 
-	TickType_t elapsed_time = 0;
+	if(task_woken == pdTRUE)
+		portYIELD_FROM_ISR();
+}
 
-	switch(button->state)
+static void sample_timer(TimerHandle_t timer)
+{
+	bitec_button_t * button = (bitec_button_t *)pvTimerGetTimerID(timer);
+	bitec_button_event_t events[BITEC_GESTURE_EVENTS_MAX];
+
+	size_t events_num = bitec_gesture_update(&button->gesture, is_pressed(button), now_ms(), events, BITEC_GESTURE_EVENTS_MAX);
+
+	for(size_t i = 0; i < events_num; i++)
 	{
-		case FALLING_STATE:
-			if(gpio_get_level(button->pin) == button->mode)
-			{
-				button->tick_counter = xTaskGetTickCountFromISR();
-				button->state = RISING_STATE;
-			}
-
-			break;
-		case RISING_STATE:
-			if(gpio_get_level(button->pin ) == !button->mode)
-			{
-				elapsed_time = xTaskGetTickCountFromISR() - button->tick_counter;
-
-				if(elapsed_time >= SHORT_TIME && elapsed_time <= MEDIUM_TIME)
-					xEventGroupSetBits(button->event_group, BUTTON_SHORT_PRESS_BIT);
-				else if((elapsed_time >= MEDIUM_TIME && elapsed_time <= LONG_TIME))
-					xEventGroupSetBits(button->event_group, BUTTON_MEDIUM_PRESS_BIT);
-				else if ( elapsed_time >= LONG_TIME)
-					xEventGroupSetBits(button->event_group, BUTTON_LONG_PRESS_BIT);
-			}
-			button->state = FALLING_STATE;
-
-			break;
-
-		default:
-			break;
+		if(xQueueSend(button->queue, &events[i], 0) != pdTRUE)
+			button->dropped++;
 	}
 
-	portYIELD_FROM_ISR();
+	if(!bitec_gesture_idle(&button->gesture))
+		return;
+
+	xTimerStop(timer, 0);
+	hal_gpio_intr_enable(button->pin, true);
+
+	/* An edge between the last sample and the unmask raised no interrupt */
+	if(is_pressed(button) != button->gesture.stable)
+	{
+		hal_gpio_intr_enable(button->pin, false);
+		xTimerStart(timer, 0);
+	}
+}
+
+static bool is_pressed(bitec_button_t * const me)
+{
+	return hal_gpio_get_level(me->pin) == (me->mode == FALLING_MODE ? 0 : 1);
+}
+
+static uint32_t now_ms(void)
+{
+	return (uint32_t)(hal_time_us() / 1000);
 }
 
 /* end of file ---------------------------------------------------------------*/
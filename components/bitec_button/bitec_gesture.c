@@ -0,0 +1,181 @@
+/*
+ * bitec_gesture.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include "bitec_gesture.h"
+
+/* macros --------------------------------------------------------------------*/
+
+/* Wrap safe comparison of ms times */
+#define TIME_REACHED(now, time)		((int32_t)((now) - (time)) >= 0)
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef struct
+{
+	bitec_button_event_t * events;
+	size_t size;
+	size_t num;
+} output_t;
+
+/* internal data declaration -------------------------------------------------*/
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static void edge(bitec_gesture_t * const me, bool pressed, uint32_t time, output_t * output);
+static void timeouts(bitec_gesture_t * const me, uint32_t now, output_t * output);
+static void emit(output_t * output, bitec_button_event_e type, uint32_t duration, uint32_t time);
+
+/* external functions definition ---------------------------------------------*/
+
+void bitec_gesture_init(bitec_gesture_t * const me, bool pressed, uint32_t now)
+{
+	me->state = GESTURE_IDLE_STATE;
+	me->raw = pressed;
+	me->raw_time = now;
+	me->stable = pressed;
+	me->press_time = now;
+	me->release_time = now;
+	me->click_duration = 0;
+	me->next_hold = now;
+}
+
+size_t bitec_gesture_update(bitec_gesture_t * const me, bool pressed, uint32_t now, bitec_button_event_t * events, size_t size)
+{
+	output_t output = { .events = events, .size = size, .num = 0 };
+
+	if(pressed != me->raw)
+	{
+		me->raw = pressed;
+		me->raw_time = now;
+	}
+
+	/* Bounces restart the wait, the new level is dated from its first edge */
+	if(me->raw != me->stable && TIME_REACHED(now, me->raw_time + me->debounce_time))
+	{
+		me->stable = me->raw;
+		edge(me, me->stable, me->raw_time, &output);
+	}
+
+	timeouts(me, now, &output);
+
+	return output.num;
+}
+
+bool bitec_gesture_idle(const bitec_gesture_t * const me)
+{
+	return me->state == GESTURE_IDLE_STATE && me->raw == me->stable;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static void edge(bitec_gesture_t * const me, bool pressed, uint32_t time, output_t * output)
+{
+	if(pressed)
+	{
+		me->state = me->state == GESTURE_WAIT_STATE ? GESTURE_SECOND_STATE : GESTURE_DOWN_STATE;
+		me->press_time = time;
+		me->next_hold = time + me->hold_time;
+		emit(output, BITEC_BUTTON_PRESS, 0, time);
+
+		return;
+	}
+
+	emit(output, BITEC_BUTTON_RELEASE, time - me->press_time, time);
+
+	switch(me->state)
+	{
+		case GESTURE_DOWN_STATE:
+			if(me->double_click_time > 0)
+			{
+				me->state = GESTURE_WAIT_STATE;
+				me->release_time = time;
+				me->click_duration = time - me->press_time;
+			}
+			else
+			{
+				emit(output, BITEC_BUTTON_CLICK, time - me->press_time, time);
+				me->state = GESTURE_IDLE_STATE;
+			}
+
+			break;
+
+		case GESTURE_SECOND_STATE:
+			emit(output, BITEC_BUTTON_DOUBLE_CLICK, time - me->press_time, time);
+			me->state = GESTURE_IDLE_STATE;
+
+			break;
+
+		default:
+			me->state = GESTURE_IDLE_STATE;
+
+			break;
+	}
+}
+
+static void timeouts(bitec_gesture_t * const me, uint32_t now, output_t * output)
+{
+	switch(me->state)
+	{
+		case GESTURE_WAIT_STATE:
+			if(TIME_REACHED(now, me->release_time + me->double_click_time))
+			{
+				emit(output, BITEC_BUTTON_CLICK, me->click_duration, me->release_time + me->double_click_time);
+				me->state = GESTURE_IDLE_STATE;
+			}
+
+			break;
+
+		case GESTURE_DOWN_STATE:
+		case GESTURE_SECOND_STATE:
+			/* A release still being debounced ends the press before the hold */
+			if(me->hold_time == 0 || !me->raw || !TIME_REACHED(now, me->next_hold))
+				break;
+
+			/* The first press of a pair that turned into a hold was a click */
+			if(me->state == GESTURE_SECOND_STATE)
+				emit(output, BITEC_BUTTON_CLICK, me->click_duration, me->next_hold);
+
+			emit(output, BITEC_BUTTON_HOLD, me->hold_time, me->next_hold);
+			me->state = GESTURE_HELD_STATE;
+			me->next_hold += me->repeat_time;
+
+			break;
+
+		case GESTURE_HELD_STATE:
+			if(me->repeat_time == 0 || !me->raw)
+				break;
+
+			/* Late samples catch up with every repeat they missed, as far as events fit */
+			while(TIME_REACHED(now, me->next_hold) && output->num < output->size)
+			{
+				emit(output, BITEC_BUTTON_HOLD_REPEAT, me->next_hold - me->press_time, me->next_hold);
+				me->next_hold += me->repeat_time;
+			}
+
+			break;
+
+		default:
+			break;
+	}
+}
+
+static void emit(output_t * output, bitec_button_event_e type, uint32_t duration, uint32_t time)
+{
+	if(output->num == output->size)
+		return;
+
+	output->events[output->num].type = type;
+	output->events[output->num].duration = duration;
+	output->events[output->num].time = time;
+	output->num++;
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -15,9 +15,13 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/event_groups.h"
+#include "freertos/queue.h"
+#include "freertos/timers.h"
 
-#include "driver/gpio.h"
+#include "esp_err.h"
+
+#include "bitec_hal.h"
+#include "bitec_gesture.h"
 
 /* cplusplus -----------------------------------------------------------------*/
 
@@ -27,10 +31,6 @@ extern "C" {
 
 /* macros --------------------------------------------------------------------*/
 
-#define BUTTON_SHORT_PRESS_BIT	BIT0
-#define BUTTON_MEDIUM_PRESS_BIT	BIT1
-#define BUTTON_LONG_PRESS_BIT	BIT2
-
 /* typedef -------------------------------------------------------------------*/
 
 typedef enum
@@ -39,31 +39,14 @@ typedef enum
 	RISING_MODE
 } button_mode_e;
 
-/* Button states */
-typedef enum
-{
-	UP_STATE,
-	DOWN_STATE,
-	FALLING_STATE,
-	RISING_STATE
-} button_state_e;
-
 typedef struct
 {
-
-	button_state_e state;
 	button_mode_e mode;
-	gpio_num_t pin;
-	TickType_t tick_counter;
-	uint8_t falling_counter;
-	uint8_t rising_counter;
-	void (* short_function)(void *);
-	void (* medium_function)(void *);
-	void (* long_function)(void *);
-	void * short_arg;
-	void * medium_arg;
-	void * long_arg;
-	EventGroupHandle_t event_group;		/*!< todo: set description */
+	int pin;
+	bitec_gesture_t gesture;
+	TimerHandle_t timer;		/*!< Samples the button from the first edge until it is idle */
+	QueueHandle_t queue;		/*!< Button events, bitec_button_event_t */
+	uint32_t dropped;			/*!< Events lost because the queue was full */
 } bitec_button_t;
 
 /* external data declaration -------------------------------------------------*/
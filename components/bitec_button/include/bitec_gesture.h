@@ -0,0 +1,98 @@
+/*
+ * bitec_gesture.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_GESTURE_H_
+#define _BITEC_GESTURE_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#define BITEC_GESTURE_EVENTS_MAX	4	/*!< Most events a single update can produce */
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef enum
+{
+	BITEC_BUTTON_PRESS = 0,		/*!< Debounced press */
+	BITEC_BUTTON_RELEASE,		/*!< Debounced release, duration is the press length */
+	BITEC_BUTTON_CLICK,			/*!< Press shorter than the hold time, not followed by a second one */
+	BITEC_BUTTON_DOUBLE_CLICK,	/*!< Second press within the double click time */
+	BITEC_BUTTON_HOLD,			/*!< Press reached the hold time */
+	BITEC_BUTTON_HOLD_REPEAT,	/*!< Every repeat time after the hold, duration is the progress of the press */
+} bitec_button_event_e;
+
+typedef struct
+{
+	bitec_button_event_e type;
+	uint32_t duration;			/*!< Time since the press in ms */
+	uint32_t time;				/*!< Time of the event in ms, dated from the first edge of a debounced change */
+} bitec_button_event_t;
+
+typedef enum
+{
+	GESTURE_IDLE_STATE = 0,
+	GESTURE_DOWN_STATE,			/*!< First press */
+	GESTURE_WAIT_STATE,			/*!< Released, waiting for a second press */
+	GESTURE_SECOND_STATE,		/*!< Second press */
+	GESTURE_HELD_STATE			/*!< Press past the hold time */
+} bitec_gesture_state_e;
+
+typedef struct
+{
+	/* Configuration, times in ms, 0 disables the double click, the hold or its repeat */
+	uint32_t debounce_time;		/*!< A level is taken once stable for this time */
+	uint32_t double_click_time;	/*!< Maximum time from a release to the second press */
+	uint32_t hold_time;
+	uint32_t repeat_time;
+
+	/* State */
+	bitec_gesture_state_e state;
+	bool raw;					/*!< Last sampled level, true when pressed */
+	uint32_t raw_time;			/*!< Time of the last change of the sampled level */
+	bool stable;				/*!< Debounced level */
+	uint32_t press_time;
+	uint32_t release_time;
+	uint32_t click_duration;	/*!< Length of a press waiting for a second one */
+	uint32_t next_hold;			/*!< Time of the next hold or hold repeat event */
+} bitec_gesture_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Start from a stable level, the configuration must be set */
+void bitec_gesture_init(bitec_gesture_t * const me, bool pressed, uint32_t now);
+
+/* Feed a sample of the button, pressed or not, taken at now ms. Fills events and returns how many.
+ * Works on samples alone so recorded traces can be replayed on host */
+size_t bitec_gesture_update(bitec_gesture_t * const me, bool pressed, uint32_t now, bitec_button_event_t * events, size_t size);
+
+/* No gesture in progress and the level is stable, sampling can stop until the next edge */
+bool bitec_gesture_idle(const bitec_gesture_t * const me);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_GESTURE_H_ */
@@ -0,0 +1,130 @@
+/*
+ * bitec_clock.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <math.h>
+
+#include "bitec_clock.h"
+#include "esp_log.h"
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static const char * TAG = "bitec_clock";
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static int64_t clock_map(const bitec_clock_t * const me, int64_t uptime);
+
+/* external functions definition ---------------------------------------------*/
+
+void bitec_clock_init(bitec_clock_t * const me)
+{
+	memset(me, 0, sizeof(bitec_clock_t));
+}
+
+void bitec_clock_sync(bitec_clock_t * const me, int64_t uptime, int64_t time)
+{
+	int64_t offset = me->synced ? time - clock_map(me, uptime) : 0;
+
+	me->syncs++;
+	me->offset = offset;
+
+	/* The server time is taken as it is, the drift measure starts again from it */
+	if(!me->synced || llabs(offset) > CLOCK_STEP * 1000LL)
+	{
+		if(me->synced)
+		{
+			me->steps++;
+			ESP_LOGW(TAG, "Stepped by %" PRId64 " ms", offset / 1000);
+		}
+
+		me->synced = true;
+		me->anchor_uptime = uptime;
+		me->anchor_time = time;
+		me->slew = 0;
+		me->reference_uptime = uptime;
+		me->reference_time = time;
+
+		return;
+	}
+
+	if(llabs(offset) > me->offset_max)
+		me->offset_max = llabs(offset);
+
+	/* Same time at the sync, the offset is made up from it on */
+	me->anchor_time = clock_map(me, uptime);
+	me->anchor_uptime = uptime;
+	me->slew = offset;
+
+	/* Over a long interval the error of the syncs is a small part of the drift */
+	if(uptime - me->reference_uptime >= CLOCK_DRIFT_INTERVAL * 1000000LL)
+	{
+		double drift = ((double)(time - me->reference_time) / (uptime - me->reference_uptime) - 1) * 1e6;
+
+		if(fabs(drift) <= CLOCK_DRIFT_MAX)
+		{
+			me->drift = (me->drifts == 0) ? drift : me->drift + (drift - me->drift) / CLOCK_DRIFT_WEIGHT;
+			me->drifts++;
+		}
+		else
+			ESP_LOGW(TAG, "Drift of %.0f ppm ignored", drift);
+
+		me->reference_uptime = uptime;
+		me->reference_time = time;
+	}
+}
+
+int64_t bitec_clock_time(const bitec_clock_t * const me, int64_t uptime)
+{
+	if(!me->synced)
+		return -1;
+
+	return clock_map(me, uptime) / 1000;
+}
+
+int bitec_clock_print_metrics(const bitec_clock_t * const me, int64_t uptime, char * buf, size_t size)
+{
+	int len = snprintf(buf, size, "{\"synced\":%d,\"syncs\":%" PRIu32 ",\"steps\":%" PRIu32 ",\"drift\":%.2f,\"drifts\":%" PRIu32
+			",\"offset\":%" PRId64 ",\"offset_max\":%" PRId64 ",\"age\":%" PRId64 "}", me->synced, me->syncs, me->steps, me->drift,
+			me->drifts, me->offset, me->offset_max, me->synced ? (uptime - me->anchor_uptime) / 1000000 : -1);
+
+	if(len < 0 || (size_t)len >= size)
+		return -1;
+
+	return len;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* Unix time in us of an uptime, the slew is less than 1 so it never goes back */
+static int64_t clock_map(const bitec_clock_t * const me, int64_t uptime)
+{
+	int64_t elapsed = uptime - me->anchor_uptime;
+	int64_t time = me->anchor_time + elapsed + (int64_t)(elapsed * me->drift / 1e6);
+
+	if(elapsed > 0)
+	{
+		int64_t slewed = elapsed * CLOCK_SLEW / 1000000;
+
+		time += (me->slew >= 0) ? (slewed < me->slew ? slewed : me->slew) : (-slewed > me->slew ? -slewed : me->slew);
+	}
+
+	return time;
+}
+
+/* end of file ---------------------------------------------------------------*/
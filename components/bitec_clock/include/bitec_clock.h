@@ -0,0 +1,102 @@
+/*
+ * bitec_clock.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_CLOCK_H_
+#define _BITEC_CLOCK_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#ifdef CONFIG_BITEC_CLOCK_STEP
+#define CLOCK_STEP				CONFIG_BITEC_CLOCK_STEP
+#else
+#define CLOCK_STEP				1000
+#endif
+
+#ifdef CONFIG_BITEC_CLOCK_SLEW
+#define CLOCK_SLEW				CONFIG_BITEC_CLOCK_SLEW
+#else
+#define CLOCK_SLEW				500
+#endif
+
+#ifdef CONFIG_BITEC_CLOCK_DRIFT_INTERVAL
+#define CLOCK_DRIFT_INTERVAL	CONFIG_BITEC_CLOCK_DRIFT_INTERVAL
+#else
+#define CLOCK_DRIFT_INTERVAL	600
+#endif
+
+#define CLOCK_DRIFT_MAX			200			/*!< Largest drift in ppm taken, a crystal is within 50 */
+#define CLOCK_DRIFT_WEIGHT		4			/*!< Of the drift against a new measure of it */
+
+/* typedef -------------------------------------------------------------------*/
+
+/* The unix time of an uptime is the one of the anchor plus the uptime since it corrected by the drift,
+ * plus the offset of the last sync slewed in at CLOCK_SLEW. Uptimes before the anchor are not slewed */
+typedef struct
+{
+	/* Mapping */
+	bool synced;
+	int64_t anchor_uptime;		/*!< In us, of the last sync */
+	int64_t anchor_time;		/*!< Unix time in us the mapping gave it or the server on a step */
+	int64_t slew;				/*!< Offset to the server at the anchor in us, made up from it on */
+	double drift;				/*!< Of the uptime in ppm, positive when it runs slow */
+
+	/* Drift measure, from the sync it started at */
+	int64_t reference_uptime;
+	int64_t reference_time;
+
+	/* Metrics */
+	uint32_t syncs;
+	uint32_t steps;
+	uint32_t drifts;			/*!< Measures of the drift taken */
+	int64_t offset;				/*!< Of the last sync in us */
+	int64_t offset_max;			/*!< Largest one not stepped, absolute */
+} bitec_clock_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Not synced, the drift is 0 */
+void bitec_clock_init(bitec_clock_t * const me);
+
+/* Take the unix time in us of the server at an uptime of hal_time_us(), syncs have to be in uptime
+ * order. The first one and any other more than CLOCK_STEP from the time kept step it */
+void bitec_clock_sync(bitec_clock_t * const me, int64_t uptime, int64_t time);
+
+/* Unix time in ms of an uptime, before the last sync too, -1 until synced. Never goes back for a
+ * later uptime but on a step */
+int64_t bitec_clock_time(const bitec_clock_t * const me, int64_t uptime);
+
+/* Print the metrics as JSON, age is the time since the last sync. Returns its length or -1 if it
+ * does not fit */
+int bitec_clock_print_metrics(const bitec_clock_t * const me, int64_t uptime, char * buf, size_t size);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_CLOCK_H_ */
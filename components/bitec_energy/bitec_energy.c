@@ -0,0 +1,435 @@
+/*
+ * bitec_energy.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include "bitec_energy.h"
+#include "bitec_hal.h"
+#include "esp_log.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define NVS_PARTITION		"settings"
+#define NVS_NAMESPACE		"energy"
+#define NVS_KEY				"state"
+#define STATE_VERSION		1
+#define QUARTER_TIME		900			/*!< In s */
+#define PRINT_RESERVE		24			/*!< Closing the arrays of the registers after a full one */
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static const char * TAG = "bitec_energy";
+
+static const char * const names[ENERGY_REGISTER_MAX] =
+{
+	[ENERGY_QUARTER] = "quarter",
+	[ENERGY_HOUR] = "hour",
+	[ENERGY_DAY] = "day",
+};
+
+static const uint16_t sizes[ENERGY_REGISTER_MAX] = { ENERGY_QUARTERS, ENERGY_HOURS, ENERGY_DAYS };
+static const uint16_t offsets[ENERGY_REGISTER_MAX] = { 0, ENERGY_QUARTERS, ENERGY_QUARTERS + ENERGY_HOURS };
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static void records_add(bitec_energy_t * const me, uint32_t time, double energy, uint8_t flags);
+static void ring_close(bitec_energy_t * const me, bitec_energy_register_e reg);
+static bool schedule_valid(const char * schedule);
+
+/* external functions definition ---------------------------------------------*/
+
+esp_err_t bitec_energy_init(bitec_energy_t * const me)
+{
+	memset(me, 0, sizeof(bitec_energy_t));
+
+	me->jump = ENERGY_JUMP;
+	me->last_time = -1;
+	me->flags = ENERGY_PARTIAL;
+	me->state.version = STATE_VERSION;
+
+	return bitec_energy_set_schedule(me, ENERGY_WEEKDAY, ENERGY_WEEKEND);
+}
+
+esp_err_t bitec_energy_set_schedule(bitec_energy_t * const me, const char * weekday, const char * weekend)
+{
+	if(!schedule_valid(weekday) || !schedule_valid(weekend))
+		return ESP_ERR_INVALID_ARG;
+
+	for(int i = 0; i < 24; i++)
+	{
+		me->schedule[0][i] = weekday[i] - '0';
+		me->schedule[1][i] = weekend[i] - '0';
+	}
+
+	return ESP_OK;
+}
+
+void bitec_energy_update(bitec_energy_t * const me, int64_t time, int64_t uptime, double energy)
+{
+	uint8_t flags = 0;
+
+	/* Kept until the records have a time */
+	if(time < 0)
+	{
+		me->pending += energy;
+		return;
+	}
+
+	if(me->pending > 0)
+	{
+		energy += me->pending;
+		me->pending = 0;
+		flags |= ENERGY_UNSYNCED;
+	}
+
+	if(me->last_time >= 0 && llabs((time - me->last_time) - (uptime - me->last_uptime) / 1000) > me->jump)
+	{
+		/* Stepped, the open records end here and the next ones start late */
+		for(int i = 0; i < ENERGY_REGISTER_MAX; i++)
+		{
+			if(me->state.rings[i].open.start != 0)
+			{
+				me->state.rings[i].open.flags |= ENERGY_CLOCK_JUMP;
+				ring_close(me, i);
+			}
+		}
+
+		me->flags |= ENERGY_PARTIAL | ENERGY_CLOCK_JUMP;
+		me->jumps++;
+		ESP_LOGW(TAG, "Clock stepped by %" PRId64 " ms", (time - me->last_time) - (uptime - me->last_uptime) / 1000);
+	}
+	else if(me->last_time >= 0 && time > me->last_time && time - me->last_time <= ENERGY_GAP)
+	{
+		/* Over a quarter boundary, the part before it is of the records it closes */
+		int64_t boundary = (int64_t)bitec_energy_start(ENERGY_QUARTER, time / 1000) * 1000;
+
+		if(boundary > me->last_time)
+		{
+			double before = energy * (boundary - me->last_time) / (time - me->last_time);
+
+			records_add(me, me->last_time / 1000, before, flags);
+			energy -= before;
+		}
+	}
+
+	records_add(me, time / 1000, energy, flags);
+
+	me->last_time = time;
+	me->last_uptime = uptime;
+}
+
+uint8_t bitec_energy_tariff(const bitec_energy_t * const me, uint32_t time)
+{
+	time_t now = time;
+	struct tm timeinfo;
+
+	localtime_r(&now, &timeinfo);
+
+	return me->schedule[(timeinfo.tm_wday == 0 || timeinfo.tm_wday == 6) ? 1 : 0][timeinfo.tm_hour];
+}
+
+uint32_t bitec_energy_start(bitec_energy_register_e reg, uint32_t time)
+{
+	time_t now = time;
+	struct tm timeinfo;
+
+	localtime_r(&now, &timeinfo);
+
+	/* Minutes and seconds of the local time, an offset of half an hour moves the hours too */
+	uint32_t seconds = timeinfo.tm_min * 60 + timeinfo.tm_sec;
+
+	switch(reg)
+	{
+		case ENERGY_QUARTER:
+			return time - seconds % QUARTER_TIME;
+
+		case ENERGY_HOUR:
+			return time - seconds;
+
+		default:
+			/* Local midnight, the DST rules of the day apply */
+			timeinfo.tm_hour = 0;
+			timeinfo.tm_min = 0;
+			timeinfo.tm_sec = 0;
+			timeinfo.tm_isdst = -1;
+
+			return (uint32_t)mktime(&timeinfo);
+	}
+}
+
+esp_err_t bitec_energy_save(bitec_energy_t * const me)
+{
+	hal_nvs_handle_t handle;
+	esp_err_t ret = hal_nvs_open(NVS_PARTITION, NVS_NAMESPACE, true, &handle);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	ret = hal_nvs_set_blob(handle, NVS_KEY, &me->state, sizeof(bitec_energy_state_t));
+
+	if(ret == ESP_OK)
+		ret = hal_nvs_commit(handle);
+
+	hal_nvs_close(handle);
+
+	if(ret == ESP_OK)
+		me->saves++;
+
+	return ret;
+}
+
+esp_err_t bitec_energy_restore(bitec_energy_t * const me)
+{
+	hal_nvs_handle_t handle;
+	bitec_energy_state_t * state = malloc(sizeof(bitec_energy_state_t));
+	size_t size = sizeof(bitec_energy_state_t);
+
+	if(state == NULL)
+		return ESP_ERR_NO_MEM;
+
+	esp_err_t ret = hal_nvs_open(NVS_PARTITION, NVS_NAMESPACE, false, &handle);
+
+	if(ret == ESP_OK)
+	{
+		ret = hal_nvs_get_blob(handle, NVS_KEY, state, &size);
+		hal_nvs_close(handle);
+	}
+
+	/* The sizes of the rings may have been set to others since */
+	if(ret == ESP_OK && (size != sizeof(bitec_energy_state_t) || state->version != STATE_VERSION))
+	{
+		ESP_LOGW(TAG, "Discarding the stored state");
+		ret = ESP_ERR_INVALID_SIZE;
+	}
+
+	if(ret == ESP_OK)
+	{
+		me->state = *state;
+
+		for(int i = 0; i < ENERGY_REGISTER_MAX; i++)
+		{
+			if(me->state.rings[i].open.start != 0)
+				me->state.rings[i].open.flags |= ENERGY_RESTART;
+		}
+
+		/* The uptime starts again, the next records start late */
+		me->last_time = -1;
+		me->flags = ENERGY_PARTIAL;
+		me->fraction = 0;
+	}
+
+	free(state);
+
+	return ret;
+}
+
+int bitec_energy_print(const bitec_energy_t * const me, char * buf, size_t size, bitec_energy_batch_t * batch)
+{
+	int len = snprintf(buf, size, "{\"tariffs\":[");
+	int ret;
+	bool full = false;
+
+	memset(batch, 0, sizeof(bitec_energy_batch_t));
+
+	if(len < 0 || (size_t)len >= size)
+		return -1;
+
+	for(int i = 0; i < ENERGY_TARIFFS; i++)
+	{
+		ret = snprintf(buf + len, size - len, "%s%.3f", i > 0 ? "," : "", me->state.totals[i] / 1000.0);
+
+		if(ret < 0 || (size_t)ret >= size - len)
+			return -1;
+
+		len += ret;
+	}
+
+	ret = snprintf(buf + len, size - len, "]");
+
+	if(ret < 0 || (size_t)ret >= size - len)
+		return -1;
+
+	len += ret;
+
+	for(int i = 0; i < ENERGY_REGISTER_MAX; i++)
+	{
+		const bitec_energy_ring_t * ring = &me->state.rings[i];
+		uint16_t first = (ring->head + sizes[i] - ring->unsent) % sizes[i];
+
+		ret = snprintf(buf + len, size - len, ",\"%s\":[", names[i]);
+
+		if(ret < 0 || (size_t)ret >= size - len)
+			return -1;
+
+		len += ret;
+
+		/* The oldest first, as many as fit leaving room to close every array */
+		for(uint16_t j = 0; j < ring->unsent && !full; j++)
+		{
+			const bitec_energy_record_t * record = &me->state.records[offsets[i] + (first + j) % sizes[i]];
+
+			ret = snprintf(buf + len, size - len, "%s[%" PRIu32 ",%" PRIu32 ",%u]", j > 0 ? "," : "",
+					record->start, (uint32_t)record->energy, (unsigned)record->flags);
+
+			if(ret < 0 || (size_t)ret + PRINT_RESERVE >= size - len)
+			{
+				full = true;
+				break;
+			}
+
+			len += ret;
+			batch->counts[i]++;
+		}
+
+		ret = snprintf(buf + len, size - len, "]");
+
+		if(ret < 0 || (size_t)ret >= size - len)
+			return -1;
+
+		len += ret;
+	}
+
+	ret = snprintf(buf + len, size - len, "}");
+
+	if(ret < 0 || (size_t)ret >= size - len)
+		return -1;
+
+	return len + ret;
+}
+
+void bitec_energy_sent(bitec_energy_t * const me, const bitec_energy_batch_t * batch)
+{
+	/* The oldest ones, later records may have been closed since */
+	for(int i = 0; i < ENERGY_REGISTER_MAX; i++)
+	{
+		bitec_energy_ring_t * ring = &me->state.rings[i];
+
+		ring->unsent -= (batch->counts[i] < ring->unsent) ? batch->counts[i] : ring->unsent;
+	}
+}
+
+uint16_t bitec_energy_unsent(const bitec_energy_t * const me, bitec_energy_register_e reg)
+{
+	return me->state.rings[reg].unsent;
+}
+
+double bitec_energy_total(const bitec_energy_t * const me)
+{
+	uint64_t total = 0;
+
+	for(int i = 0; i < ENERGY_TARIFFS; i++)
+		total += me->state.totals[i];
+
+	return total / 1000.0;
+}
+
+int bitec_energy_print_metrics(const bitec_energy_t * const me, char * buf, size_t size)
+{
+	int len = snprintf(buf, size, "{\"total\":%.3f,\"unsent\":[%u,%u,%u],\"jumps\":%" PRIu32 ",\"dropped\":%" PRIu32 ",\"saves\":%" PRIu32 "}",
+			bitec_energy_total(me), me->state.rings[ENERGY_QUARTER].unsent, me->state.rings[ENERGY_HOUR].unsent,
+			me->state.rings[ENERGY_DAY].unsent, me->jumps, me->dropped, me->saves);
+
+	if(len < 0 || (size_t)len >= size)
+		return -1;
+
+	return len;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* Add energy at a unix time in s to the records holding it, the ones before are closed */
+static void records_add(bitec_energy_t * const me, uint32_t time, double energy, uint8_t flags)
+{
+	for(int i = 0; i < ENERGY_REGISTER_MAX; i++)
+	{
+		bitec_energy_record_t * open = &me->state.rings[i].open;
+		uint32_t start = bitec_energy_start(i, time);
+
+		if(open->start != 0 && open->start != start)
+			ring_close(me, i);
+
+		if(open->start == 0)
+		{
+			open->start = start;
+			open->energy = 0;
+			open->flags = me->flags;
+
+			/* The tariff changes on the hour, a quarter is of one */
+			if(i == ENERGY_QUARTER)
+				me->state.tariff = bitec_energy_tariff(me, start);
+		}
+
+		open->flags |= flags;
+	}
+
+	me->flags = 0;
+
+	/* Whole mWh only, the rest is carried to the next update */
+	me->fraction += energy;
+
+	if(me->fraction < 1)
+		return;
+
+	uint32_t whole = (uint32_t)me->fraction;
+
+	me->fraction -= whole;
+	me->state.totals[me->state.tariff] += whole;
+
+	for(int i = 0; i < ENERGY_REGISTER_MAX; i++)
+	{
+		bitec_energy_record_t * open = &me->state.rings[i].open;
+		uint32_t sum = open->energy + whole;
+
+		open->energy = (sum < ENERGY_MAX) ? sum : ENERGY_MAX;
+	}
+}
+
+/* Move the open record of a register to its ring, over the oldest one if full */
+static void ring_close(bitec_energy_t * const me, bitec_energy_register_e reg)
+{
+	bitec_energy_ring_t * ring = &me->state.rings[reg];
+
+	me->state.records[offsets[reg] + ring->head] = ring->open;
+	ring->head = (ring->head + 1) % sizes[reg];
+
+	if(ring->count < sizes[reg])
+		ring->count++;
+
+	if(ring->unsent < sizes[reg])
+		ring->unsent++;
+	else
+		me->dropped++;
+
+	ring->open.start = 0;
+}
+
+/* 24 tariff digits, one of every hour */
+static bool schedule_valid(const char * schedule)
+{
+	if(schedule == NULL || strlen(schedule) != 24)
+		return false;
+
+	for(int i = 0; i < 24; i++)
+	{
+		if(schedule[i] < '0' || schedule[i] >= '0' + ENERGY_TARIFFS)
+			return false;
+	}
+
+	return true;
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,187 @@
+/*
+ * bitec_energy.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_ENERGY_H_
+#define _BITEC_ENERGY_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#ifdef CONFIG_BITEC_ENERGY_QUARTERS
+#define ENERGY_QUARTERS			CONFIG_BITEC_ENERGY_QUARTERS
+#else
+#define ENERGY_QUARTERS			96
+#endif
+
+#ifdef CONFIG_BITEC_ENERGY_HOURS
+#define ENERGY_HOURS			CONFIG_BITEC_ENERGY_HOURS
+#else
+#define ENERGY_HOURS			48
+#endif
+
+#ifdef CONFIG_BITEC_ENERGY_DAYS
+#define ENERGY_DAYS				CONFIG_BITEC_ENERGY_DAYS
+#else
+#define ENERGY_DAYS				31
+#endif
+
+#ifdef CONFIG_BITEC_ENERGY_WEEKDAY
+#define ENERGY_WEEKDAY			CONFIG_BITEC_ENERGY_WEEKDAY
+#else
+#define ENERGY_WEEKDAY			"000000011111111122221110"
+#endif
+
+#ifdef CONFIG_BITEC_ENERGY_WEEKEND
+#define ENERGY_WEEKEND			CONFIG_BITEC_ENERGY_WEEKEND
+#else
+#define ENERGY_WEEKEND			"000000001111111111111100"
+#endif
+
+#ifdef CONFIG_BITEC_ENERGY_JUMP
+#define ENERGY_JUMP				CONFIG_BITEC_ENERGY_JUMP
+#else
+#define ENERGY_JUMP				2000
+#endif
+
+#define ENERGY_TARIFFS			4			/*!< Tariffs of a schedule, digits 0 to 3 */
+#define ENERGY_GAP				300000		/*!< Longest time between updates split over a boundary in ms */
+#define ENERGY_MAX				((1UL << 28) - 1)	/*!< Largest energy of a record in mWh */
+
+/* Flags of a record */
+#define ENERGY_PARTIAL			(1 << 0)	/*!< Opened after its start, at power on or once the clock was set */
+#define ENERGY_CLOCK_JUMP		(1 << 1)	/*!< The clock was stepped during it */
+#define ENERGY_RESTART			(1 << 2)	/*!< Restored after a restart, the energy since the last save is lost */
+#define ENERGY_UNSYNCED			(1 << 3)	/*!< Holds energy measured before the clock was set */
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef enum
+{
+	ENERGY_QUARTER = 0,			/*!< 15 minutes */
+	ENERGY_HOUR,
+	ENERGY_DAY,					/*!< From the local midnight, 23 or 25 hours on a DST change */
+	ENERGY_REGISTER_MAX
+} bitec_energy_register_e;
+
+/* Energy of an interval, of local time */
+typedef struct
+{
+	uint32_t start;				/*!< Unix time of its start */
+	uint32_t energy : 28;		/*!< In mWh */
+	uint32_t flags : 4;			/*!< ENERGY_PARTIAL and others */
+} bitec_energy_record_t;
+
+/* Ring of the closed records of a register and the one open */
+typedef struct
+{
+	uint16_t head;				/*!< Next record written */
+	uint16_t count;
+	uint16_t unsent;			/*!< The last ones not published yet */
+	bitec_energy_record_t open;	/*!< Start 0 while none */
+} bitec_energy_ring_t;
+
+/* Stored state, the rings of every register and the totals */
+typedef struct
+{
+	uint32_t version;
+	bitec_energy_ring_t rings[ENERGY_REGISTER_MAX];
+	bitec_energy_record_t records[ENERGY_QUARTERS + ENERGY_HOURS + ENERGY_DAYS];
+	uint64_t totals[ENERGY_TARIFFS];	/*!< In mWh, of every tariff */
+	uint8_t tariff;				/*!< Of the open quarter */
+} bitec_energy_state_t;
+
+/* Records of a batch, of every register */
+typedef struct
+{
+	uint16_t counts[ENERGY_REGISTER_MAX];
+} bitec_energy_batch_t;
+
+typedef struct
+{
+	/* Configuration, set from Kconfig by bitec_energy_init() */
+	uint8_t schedule[2][24];	/*!< Tariff of every local hour of the weekdays and the weekends */
+	uint32_t jump;				/*!< Difference of the clock to the uptime flagged as a jump in ms */
+
+	/* State */
+	bitec_energy_state_t state;
+	int64_t last_time;			/*!< Unix time of the last update in ms, -1 for none */
+	int64_t last_uptime;		/*!< In us */
+	double fraction;			/*!< Energy of less than 1 mWh not in the records yet */
+	double pending;				/*!< Measured before the clock was set in mWh */
+	uint8_t flags;				/*!< To set on the next records opened */
+
+	/* Metrics */
+	uint32_t jumps;
+	uint32_t dropped;			/*!< Records overwritten before they were published */
+	uint32_t saves;
+} bitec_energy_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Set the configuration from Kconfig and clear the state. Returns ESP_ERR_INVALID_ARG for a schedule
+ * not of 24 tariff digits, the ones of Kconfig are kept then */
+esp_err_t bitec_energy_init(bitec_energy_t * const me);
+esp_err_t bitec_energy_set_schedule(bitec_energy_t * const me, const char * weekday, const char * weekend);
+
+/* Add the energy in mWh measured since the last update. time is the unix time in ms, -1 while the
+ * clock is not set, and uptime the monotonic time in us. A record is closed at the first update past
+ * its end, the energy of an update up to ENERGY_GAP long is split over the boundary. A step of the
+ * clock against the uptime closes the open records with ENERGY_CLOCK_JUMP and the next ones start
+ * from the new time, a backward step may repeat a start */
+void bitec_energy_update(bitec_energy_t * const me, int64_t time, int64_t uptime, double energy);
+
+/* Tariff of a unix time, from the local time of the TZ variable */
+uint8_t bitec_energy_tariff(const bitec_energy_t * const me, uint32_t time);
+
+/* Start of the interval of a register holding a unix time */
+uint32_t bitec_energy_start(bitec_energy_register_e reg, uint32_t time);
+
+/* State in the settings NVS partition, restoring it flags the open records with ENERGY_RESTART */
+esp_err_t bitec_energy_save(bitec_energy_t * const me);
+esp_err_t bitec_energy_restore(bitec_energy_t * const me);
+
+/* Print the totals of every tariff in Wh and the records not published yet, the oldest first, as
+ * JSON of [start, mWh, flags] arrays. Returns its length or -1 if not even the totals fit, batch gets
+ * the records printed to pass to bitec_energy_sent() once published */
+int bitec_energy_print(const bitec_energy_t * const me, char * buf, size_t size, bitec_energy_batch_t * batch);
+void bitec_energy_sent(bitec_energy_t * const me, const bitec_energy_batch_t * batch);
+
+/* Records of a register not published yet */
+uint16_t bitec_energy_unsent(const bitec_energy_t * const me, bitec_energy_register_e reg);
+
+/* Total of every tariff in Wh */
+double bitec_energy_total(const bitec_energy_t * const me);
+
+/* Print the metrics as JSON. Returns its length or -1 if it does not fit */
+int bitec_energy_print_metrics(const bitec_energy_t * const me, char * buf, size_t size);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_ENERGY_H_ */
@@ -0,0 +1,201 @@
+/*
+ * bitec_hal.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_HAL_H_
+#define _BITEC_HAL_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+
+#ifndef CONFIG_IDF_TARGET_LINUX
+#include "driver/rmt.h"
+#include "esp_timer.h"
+#endif
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#define HAL_GPIO_MAX		64			/*!< Number of GPIOs handled by the HAL */
+#define HAL_RMT_CHANNEL_MAX	8			/*!< Number of RMT channels handled by the HAL */
+#define HAL_PARTITION_MAX	4			/*!< Number of data partitions open at once */
+#define HAL_PARTITION_SECTOR	4096	/*!< Erase size of a data partition in bytes */
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef void (* hal_isr_t)(void * arg);
+
+typedef enum
+{
+	HAL_GPIO_PULL_NONE = 0,
+	HAL_GPIO_PULL_UP,
+	HAL_GPIO_PULL_DOWN
+} hal_gpio_pull_e;
+
+typedef enum
+{
+	HAL_GPIO_INTR_DISABLE = 0,
+	HAL_GPIO_INTR_POSEDGE,
+	HAL_GPIO_INTR_NEGEDGE,
+	HAL_GPIO_INTR_ANYEDGE
+} hal_gpio_intr_e;
+
+/* RMT items are the ESP-IDF ones on target and a layout compatible copy on Linux */
+#ifdef CONFIG_IDF_TARGET_LINUX
+typedef struct
+{
+	union
+	{
+		struct
+		{
+			uint32_t duration0 :15;
+			uint32_t level0 :1;
+			uint32_t duration1 :15;
+			uint32_t level1 :1;
+		};
+		uint32_t val;
+	};
+} hal_rmt_item_t;
+#else
+typedef rmt_item32_t hal_rmt_item_t;
+#endif
+
+typedef void (* hal_rmt_translator_t)(const void * src, hal_rmt_item_t * dest, size_t src_size,
+		size_t wanted_num, size_t * translated_size, size_t * item_num);
+
+/* Called from interrupt context when a transfer of the channel is done */
+typedef void (* hal_rmt_tx_end_t)(int channel, void * arg);
+
+/* Called on every SNTP sync with the hal_time_us() it was taken at and the unix time of the server in us */
+typedef void (* hal_sntp_sync_t)(int64_t uptime, int64_t time);
+
+typedef uint32_t hal_nvs_handle_t;
+
+typedef uint32_t hal_ota_handle_t;
+
+typedef uint32_t hal_partition_t;
+
+/* One shot timers are esp_timer ones on target and fakes fired by the host on Linux */
+#ifdef CONFIG_IDF_TARGET_LINUX
+typedef struct hal_timer * hal_timer_t;
+#else
+typedef esp_timer_handle_t hal_timer_t;
+#endif
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* GPIO */
+esp_err_t hal_gpio_config_output(uint64_t pin_mask);
+esp_err_t hal_gpio_config_input(uint64_t pin_mask, hal_gpio_pull_e pull, hal_gpio_intr_e intr);
+esp_err_t hal_gpio_set_level(int pin, uint32_t level);
+int hal_gpio_get_level(int pin);
+esp_err_t hal_gpio_isr_add(int pin, hal_isr_t isr, void * arg);
+esp_err_t hal_gpio_isr_remove(int pin);
+
+/* Mask or unmask the interrupt of a pin, allowed from its ISR */
+esp_err_t hal_gpio_intr_enable(int pin, bool enable);
+
+/* Clock */
+int64_t hal_time_us(void);
+
+/* Free running counter to time short code paths, CPU cycles on target and nanoseconds on host */
+uint32_t hal_cycle_count(void);
+
+/* Timers, one shot with microsecond resolution, the callback runs in the timer task on target.
+ * Starting a running timer restarts it */
+esp_err_t hal_timer_create(hal_isr_t callback, void * arg, hal_timer_t * timer);
+esp_err_t hal_timer_start(hal_timer_t timer, uint64_t timeout_us);
+esp_err_t hal_timer_stop(hal_timer_t timer);
+
+/* ADC */
+esp_err_t hal_adc_config(int channel);
+int hal_adc_read(int channel);
+
+/* Temperature sensor inside the chip, ESP_ERR_NOT_SUPPORTED on targets without one */
+esp_err_t hal_temp_init(void);
+esp_err_t hal_temp_read(float * celsius);
+
+/* RMT */
+esp_err_t hal_rmt_tx_init(int channel, int pin, uint8_t clk_div);
+esp_err_t hal_rmt_get_counter_clock(int channel, uint32_t * hz);
+esp_err_t hal_rmt_translator_init(int channel, hal_rmt_translator_t translator);
+esp_err_t hal_rmt_write(int channel, const uint8_t * src, size_t size, bool wait);
+esp_err_t hal_rmt_wait(int channel, uint32_t timeout_ms);
+esp_err_t hal_rmt_tx_end_callback(int channel, hal_rmt_tx_end_t callback, void * arg);
+
+/* System */
+void hal_restart(void);
+
+/* Heap in use in bytes, to measure the memory taken by a code path */
+size_t hal_heap_used(void);
+
+/* NVS, a NULL partition selects the default one. Missing keys return ESP_ERR_NOT_FOUND */
+esp_err_t hal_nvs_init(const char * partition);
+esp_err_t hal_nvs_open(const char * partition, const char * name, bool write, hal_nvs_handle_t * handle);
+esp_err_t hal_nvs_get_blob(hal_nvs_handle_t handle, const char * key, void * value, size_t * size);
+esp_err_t hal_nvs_set_blob(hal_nvs_handle_t handle, const char * key, const void * value, size_t size);
+esp_err_t hal_nvs_erase_key(hal_nvs_handle_t handle, const char * key);
+esp_err_t hal_nvs_erase_all(hal_nvs_handle_t handle);
+esp_err_t hal_nvs_commit(hal_nvs_handle_t handle);
+void hal_nvs_close(hal_nvs_handle_t handle);
+
+/* OTA, the image is written to the app partition after the running one, erased as it is written.
+ * hal_ota_end() checks the image and boots it on the next restart, where it waits for its self test
+ * with hal_ota_pending() true. An image restarted before hal_ota_mark_valid() is rolled back */
+esp_err_t hal_ota_begin(size_t size, hal_ota_handle_t * handle);
+esp_err_t hal_ota_write(hal_ota_handle_t handle, const void * data, size_t size);
+esp_err_t hal_ota_end(hal_ota_handle_t handle);
+void hal_ota_abort(hal_ota_handle_t handle);
+bool hal_ota_pending(void);
+esp_err_t hal_ota_mark_valid(void);
+
+/* Read the running app image, the base of delta updates */
+esp_err_t hal_ota_read_running(size_t offset, void * data, size_t size);
+
+/* Version in the app description of the running image, empty if it is unknown */
+const char * hal_ota_running_version(void);
+
+/* Mark the running image invalid and restart into the previous one, returns only on failure */
+esp_err_t hal_ota_rollback(void);
+
+/* Check a secure boot v2 signature block against the SHA-256 digest of the image it signs */
+esp_err_t hal_ota_verify_signature(const void * block, const uint8_t * digest);
+
+/* Raw data partitions, found by their label. Erases are of whole HAL_PARTITION_SECTOR sectors and set
+ * every byte to 0xFF, writes only clear bits as on flash */
+esp_err_t hal_partition_open(const char * label, hal_partition_t * partition, size_t * size);
+esp_err_t hal_partition_read(hal_partition_t partition, size_t offset, void * data, size_t size);
+esp_err_t hal_partition_write(hal_partition_t partition, size_t offset, const void * data, size_t size);
+esp_err_t hal_partition_erase(hal_partition_t partition, size_t offset, size_t size);
+
+/* SNTP, polling a server every interval ms once the network is up, the system time is set on every
+ * sync too. The server name is kept, not copied. Starting it again does nothing */
+esp_err_t hal_sntp_start(const char * server, uint32_t interval, hal_sntp_sync_t callback);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_HAL_H_ */
@@ -0,0 +1,522 @@
+/*
+ * bitec_hal_esp_idf.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include "bitec_hal.h"
+
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "driver/gpio.h"
+#include "driver/adc.h"
+#include "driver/rmt.h"
+#include "soc/soc_caps.h"
+#if SOC_TEMP_SENSOR_SUPPORTED
+#include "driver/temp_sensor.h"
+#endif
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "esp_secure_boot.h"
+#include "esp_sntp.h"
+#include "nvs_flash.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#ifdef CONFIG_IDF_TARGET_ESP32S2
+#define ADC_WIDTH	ADC_WIDTH_BIT_13
+#else
+#define ADC_WIDTH	ADC_WIDTH_BIT_12
+#endif
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static bool isr_service_installed = false;
+
+/* The RMT driver has a single end of transfer callback, it is dispatched by channel */
+static hal_rmt_tx_end_t rmt_tx_end_callbacks[HAL_RMT_CHANNEL_MAX];
+static void * rmt_tx_end_args[HAL_RMT_CHANNEL_MAX];
+
+/* Partition of the image being written */
+static const esp_partition_t * ota_partition = NULL;
+
+/* Data partitions open, a handle is its index plus one */
+static const esp_partition_t * partitions[HAL_PARTITION_MAX];
+
+static hal_sntp_sync_t sntp_callback = NULL;
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static void IRAM_ATTR rmt_tx_end(rmt_channel_t channel, void * arg);
+static esp_err_t nvs_error(esp_err_t err);
+static void sntp_sync(struct timeval * tv);
+
+/* external functions definition ---------------------------------------------*/
+
+/* GPIO */
+esp_err_t hal_gpio_config_output(uint64_t pin_mask)
+{
+	gpio_config_t gpio_conf;
+	gpio_conf.intr_type = GPIO_INTR_DISABLE;
+	gpio_conf.mode = GPIO_MODE_OUTPUT;
+	gpio_conf.pin_bit_mask = pin_mask;
+	gpio_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
+	gpio_conf.pull_up_en = GPIO_PULLUP_DISABLE;
+
+	return gpio_config(&gpio_conf);
+}
+
+esp_err_t hal_gpio_config_input(uint64_t pin_mask, hal_gpio_pull_e pull, hal_gpio_intr_e intr)
+{
+	gpio_config_t gpio_conf;
+	gpio_conf.mode = GPIO_MODE_INPUT;
+	gpio_conf.pin_bit_mask = pin_mask;
+	gpio_conf.pull_up_en = pull == HAL_GPIO_PULL_UP ? GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE;
+	gpio_conf.pull_down_en = pull == HAL_GPIO_PULL_DOWN ? GPIO_PULLDOWN_ENABLE : GPIO_PULLDOWN_DISABLE;
+
+	switch(intr)
+	{
+		case HAL_GPIO_INTR_POSEDGE:
+			gpio_conf.intr_type = GPIO_INTR_POSEDGE;
+			break;
+
+		case HAL_GPIO_INTR_NEGEDGE:
+			gpio_conf.intr_type = GPIO_INTR_NEGEDGE;
+			break;
+
+		case HAL_GPIO_INTR_ANYEDGE:
+			gpio_conf.intr_type = GPIO_INTR_ANYEDGE;
+			break;
+
+		default:
+			gpio_conf.intr_type = GPIO_INTR_DISABLE;
+			break;
+	}
+
+	return gpio_config(&gpio_conf);
+}
+
+esp_err_t IRAM_ATTR hal_gpio_set_level(int pin, uint32_t level)
+{
+	return gpio_set_level((gpio_num_t)pin, level);
+}
+
+int IRAM_ATTR hal_gpio_get_level(int pin)
+{
+	return gpio_get_level((gpio_num_t)pin);
+}
+
+esp_err_t hal_gpio_isr_add(int pin, hal_isr_t isr, void * arg)
+{
+	esp_err_t ret;
+
+	/* The ISR service is shared by every component */
+	if(!isr_service_installed)
+	{
+		ret = gpio_install_isr_service(0);
+
+		if(ret != ESP_OK && ret != ESP_ERR_INVALID_STATE)
+			return ret;
+
+		isr_service_installed = true;
+	}
+
+	return gpio_isr_handler_add((gpio_num_t)pin, isr, arg);
+}
+
+esp_err_t hal_gpio_isr_remove(int pin)
+{
+	return gpio_isr_handler_remove((gpio_num_t)pin);
+}
+
+esp_err_t IRAM_ATTR hal_gpio_intr_enable(int pin, bool enable)
+{
+	return enable ? gpio_intr_enable((gpio_num_t)pin) : gpio_intr_disable((gpio_num_t)pin);
+}
+
+/* Clock */
+int64_t IRAM_ATTR hal_time_us(void)
+{
+	return esp_timer_get_time();
+}
+
+uint32_t IRAM_ATTR hal_cycle_count(void)
+{
+	return esp_cpu_get_ccount();
+}
+
+/* Timers */
+esp_err_t hal_timer_create(hal_isr_t callback, void * arg, hal_timer_t * timer)
+{
+	const esp_timer_create_args_t args =
+	{
+		.callback = callback,
+		.arg = arg,
+		.dispatch_method = ESP_TIMER_TASK,
+		.name = "hal_timer",
+	};
+
+	return esp_timer_create(&args, timer);
+}
+
+esp_err_t hal_timer_start(hal_timer_t timer, uint64_t timeout_us)
+{
+	/* Only fails if the timer is not running */
+	esp_timer_stop(timer);
+
+	return esp_timer_start_once(timer, timeout_us);
+}
+
+esp_err_t hal_timer_stop(hal_timer_t timer)
+{
+	esp_err_t ret = esp_timer_stop(timer);
+
+	return ret == ESP_ERR_INVALID_STATE ? ESP_OK : ret;
+}
+
+/* ADC */
+esp_err_t hal_adc_config(int channel)
+{
+	esp_err_t ret = adc1_config_width(ADC_WIDTH);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	return adc1_config_channel_atten((adc1_channel_t)channel, ADC_ATTEN_DB_11);
+}
+
+int hal_adc_read(int channel)
+{
+	return adc1_get_raw((adc1_channel_t)channel);
+}
+
+/* Temperature sensor */
+esp_err_t hal_temp_init(void)
+{
+#if SOC_TEMP_SENSOR_SUPPORTED
+	temp_sensor_config_t config = TSENS_CONFIG_DEFAULT();
+
+	esp_err_t ret = temp_sensor_set_config(config);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	return temp_sensor_start();
+#else
+	return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t hal_temp_read(float * celsius)
+{
+#if SOC_TEMP_SENSOR_SUPPORTED
+	return temp_sensor_read_celsius(celsius);
+#else
+	return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+/* RMT */
+esp_err_t hal_rmt_tx_init(int channel, int pin, uint8_t clk_div)
+{
+	esp_err_t ret;
+
+	rmt_config_t config = RMT_DEFAULT_CONFIG_TX(pin, (rmt_channel_t)channel);
+	config.clk_div = clk_div;
+
+	ret = rmt_config(&config);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	return rmt_driver_install(config.channel, 0, 0);
+}
+
+esp_err_t hal_rmt_get_counter_clock(int channel, uint32_t * hz)
+{
+	return rmt_get_counter_clock((rmt_channel_t)channel, hz);
+}
+
+esp_err_t hal_rmt_translator_init(int channel, hal_rmt_translator_t translator)
+{
+	return rmt_translator_init((rmt_channel_t)channel, translator);
+}
+
+esp_err_t hal_rmt_write(int channel, const uint8_t * src, size_t size, bool wait)
+{
+	return rmt_write_sample((rmt_channel_t)channel, src, size, wait);
+}
+
+esp_err_t hal_rmt_wait(int channel, uint32_t timeout_ms)
+{
+	return rmt_wait_tx_done((rmt_channel_t)channel, pdMS_TO_TICKS(timeout_ms));
+}
+
+esp_err_t hal_rmt_tx_end_callback(int channel, hal_rmt_tx_end_t callback, void * arg)
+{
+	if(channel < 0 || channel >= HAL_RMT_CHANNEL_MAX)
+		return ESP_ERR_INVALID_ARG;
+
+	rmt_tx_end_callbacks[channel] = NULL;
+	rmt_tx_end_args[channel] = arg;
+	rmt_tx_end_callbacks[channel] = callback;
+
+	rmt_register_tx_end_callback(rmt_tx_end, NULL);
+
+	return ESP_OK;
+}
+
+/* System */
+void hal_restart(void)
+{
+	esp_restart();
+}
+
+size_t hal_heap_used(void)
+{
+	return heap_caps_get_total_size(MALLOC_CAP_DEFAULT) - heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+}
+
+/* NVS */
+esp_err_t hal_nvs_init(const char * partition)
+{
+	/* NVS partitions are encrypted with the keys stored in the nvs_keys partition */
+	const esp_partition_t * keys = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_NVS_KEYS, NULL);
+
+	if(keys == NULL)
+		return ESP_FAIL;
+
+	nvs_sec_cfg_t nvs_sec_cfg;
+	esp_err_t ret = nvs_flash_read_security_cfg(keys, &nvs_sec_cfg);
+
+	if(ret != ESP_OK)
+	{
+		ret = nvs_flash_generate_keys(keys, &nvs_sec_cfg);
+
+		if(ret != ESP_OK)
+			return ret;
+	}
+
+	if(partition == NULL)
+		return nvs_flash_secure_init(&nvs_sec_cfg);
+
+	return nvs_flash_secure_init_partition(partition, &nvs_sec_cfg);
+}
+
+esp_err_t hal_nvs_open(const char * partition, const char * name, bool write, hal_nvs_handle_t * handle)
+{
+	nvs_open_mode_t mode = write ? NVS_READWRITE : NVS_READONLY;
+
+	if(partition == NULL)
+		return nvs_error(nvs_open(name, mode, handle));
+
+	return nvs_error(nvs_open_from_partition(partition, name, mode, handle));
+}
+
+esp_err_t hal_nvs_get_blob(hal_nvs_handle_t handle, const char * key, void * value, size_t * size)
+{
+	return nvs_error(nvs_get_blob(handle, key, value, size));
+}
+
+esp_err_t hal_nvs_set_blob(hal_nvs_handle_t handle, const char * key, const void * value, size_t size)
+{
+	return nvs_error(nvs_set_blob(handle, key, value, size));
+}
+
+esp_err_t hal_nvs_erase_key(hal_nvs_handle_t handle, const char * key)
+{
+	return nvs_error(nvs_erase_key(handle, key));
+}
+
+esp_err_t hal_nvs_erase_all(hal_nvs_handle_t handle)
+{
+	return nvs_error(nvs_erase_all(handle));
+}
+
+esp_err_t hal_nvs_commit(hal_nvs_handle_t handle)
+{
+	return nvs_error(nvs_commit(handle));
+}
+
+void hal_nvs_close(hal_nvs_handle_t handle)
+{
+	nvs_close(handle);
+}
+
+/* OTA */
+esp_err_t hal_ota_begin(size_t size, hal_ota_handle_t * handle)
+{
+	ota_partition = esp_ota_get_next_update_partition(NULL);
+
+	if(ota_partition == NULL)
+		return ESP_ERR_NOT_FOUND;
+
+	if(size > ota_partition->size)
+		return ESP_ERR_INVALID_SIZE;
+
+	/* Sectors are erased as they are written, there is no long erase before the download */
+	return esp_ota_begin(ota_partition, OTA_WITH_SEQUENTIAL_WRITES, handle);
+}
+
+esp_err_t hal_ota_write(hal_ota_handle_t handle, const void * data, size_t size)
+{
+	return esp_ota_write(handle, data, size);
+}
+
+esp_err_t hal_ota_end(hal_ota_handle_t handle)
+{
+	esp_err_t ret = esp_ota_end(handle);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	return esp_ota_set_boot_partition(ota_partition);
+}
+
+void hal_ota_abort(hal_ota_handle_t handle)
+{
+	esp_ota_abort(handle);
+}
+
+bool hal_ota_pending(void)
+{
+	esp_ota_img_states_t state;
+
+	if(esp_ota_get_state_partition(esp_ota_get_running_partition(), &state) != ESP_OK)
+		return false;
+
+	return state == ESP_OTA_IMG_PENDING_VERIFY;
+}
+
+esp_err_t hal_ota_mark_valid(void)
+{
+	return esp_ota_mark_app_valid_cancel_rollback();
+}
+
+esp_err_t hal_ota_read_running(size_t offset, void * data, size_t size)
+{
+	const esp_partition_t * partition = esp_ota_get_running_partition();
+
+	if(offset + size > partition->size)
+		return ESP_ERR_INVALID_SIZE;
+
+	/* Decrypted if flash encryption is enabled */
+	return esp_partition_read(partition, offset, data, size);
+}
+
+const char * hal_ota_running_version(void)
+{
+	return esp_ota_get_app_description()->version;
+}
+
+esp_err_t hal_ota_rollback(void)
+{
+	return esp_ota_mark_app_invalid_rollback_and_reboot();
+}
+
+esp_err_t hal_ota_verify_signature(const void * block, const uint8_t * digest)
+{
+#if defined(CONFIG_SECURE_SIGNED_ON_UPDATE) && defined(CONFIG_SECURE_BOOT_V2_ENABLED)
+	uint8_t verified[32];
+
+	return esp_secure_boot_verify_sbv2_signature_block((const ets_secure_boot_signature_t *)block, digest, verified);
+#else
+	return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+/* Data partitions */
+esp_err_t hal_partition_open(const char * label, hal_partition_t * partition, size_t * size)
+{
+	const esp_partition_t * found = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+
+	if(found == NULL)
+		return ESP_ERR_NOT_FOUND;
+
+	for(int i = 0; i < HAL_PARTITION_MAX; i++)
+	{
+		if(partitions[i] == NULL || partitions[i] == found)
+		{
+			partitions[i] = found;
+			* partition = i + 1;
+			* size = found->size;
+
+			return ESP_OK;
+		}
+	}
+
+	return ESP_ERR_NO_MEM;
+}
+
+esp_err_t hal_partition_read(hal_partition_t partition, size_t offset, void * data, size_t size)
+{
+	if(partition == 0 || partition > HAL_PARTITION_MAX || partitions[partition - 1] == NULL)
+		return ESP_ERR_INVALID_ARG;
+
+	return esp_partition_read(partitions[partition - 1], offset, data, size);
+}
+
+esp_err_t hal_partition_write(hal_partition_t partition, size_t offset, const void * data, size_t size)
+{
+	if(partition == 0 || partition > HAL_PARTITION_MAX || partitions[partition - 1] == NULL)
+		return ESP_ERR_INVALID_ARG;
+
+	return esp_partition_write(partitions[partition - 1], offset, data, size);
+}
+
+esp_err_t hal_partition_erase(hal_partition_t partition, size_t offset, size_t size)
+{
+	if(partition == 0 || partition > HAL_PARTITION_MAX || partitions[partition - 1] == NULL)
+		return ESP_ERR_INVALID_ARG;
+
+	return esp_partition_erase_range(partitions[partition - 1], offset, size);
+}
+
+/* SNTP */
+esp_err_t hal_sntp_start(const char * server, uint32_t interval, hal_sntp_sync_t callback)
+{
+	if(sntp_enabled())
+		return ESP_OK;
+
+	sntp_callback = callback;
+	sntp_setoperatingmode(SNTP_OPMODE_POLL);
+	sntp_setservername(0, server);
+	sntp_set_sync_interval(interval);
+	sntp_set_time_sync_notification_cb(sntp_sync);
+	sntp_init();
+
+	return ESP_OK;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static void IRAM_ATTR rmt_tx_end(rmt_channel_t channel, void * arg)
+{
+	if(channel < HAL_RMT_CHANNEL_MAX && rmt_tx_end_callbacks[channel] != NULL)
+		rmt_tx_end_callbacks[channel](channel, rmt_tx_end_args[channel]);
+}
+
+static esp_err_t nvs_error(esp_err_t err)
+{
+	/* Report missing namespaces and keys the same way on every port */
+	return err == ESP_ERR_NVS_NOT_FOUND ? ESP_ERR_NOT_FOUND : err;
+}
+
+/* Runs in the lwIP task right after the system time was set to the time received */
+static void sntp_sync(struct timeval * tv)
+{
+	if(sntp_callback != NULL)
+		sntp_callback(hal_time_us(), (int64_t)tv->tv_sec * 1000000 + tv->tv_usec);
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,979 @@
+/*
+ * bitec_hal_linux.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <malloc.h>
+
+#include "bitec_hal_linux.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define ADC_CHANNEL_MAX		10			/*!< Number of simulated ADC channels */
+#define TEMP_DEFAULT		25.0f		/*!< Chip temperature in Celsius after a reset */
+#define NVS_HANDLE_MAX		16			/*!< Maximum number of open NVS handles */
+#define NVS_NAME_SIZE		16			/*!< NVS partition, namespace and key size, as in ESP-IDF */
+#define NVS_DEFAULT_PART	"nvs"		/*!< Partition used when none is given */
+#define RMT_CLOCK			80000000	/*!< RMT source clock in Hz */
+#define TIMER_MAX			8			/*!< Number of one shot timers */
+#define OTA_SLOT_SIZE		0x100000	/*!< App partition size, as in partitions.csv */
+#define OTA_SLOT_MAX		2			/*!< ota_0 and ota_1, the factory app is slot -1 */
+#define OTA_FACTORY			-1
+#define OTA_VERSION_OFFSET	48			/*!< Version of the app description in an image */
+#define OTA_VERSION_SIZE	32
+#define PARTITION_SIZE		0x80000		/*!< Data partitions size, as the series one in partitions.csv */
+#define PARTITION_LABEL_SIZE	17		/*!< As in ESP-IDF */
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef struct
+{
+	bool output;
+	bool driven;		/*!< Level set by hal_linux_gpio_drive(), pulls no longer apply */
+	uint32_t level;
+	hal_gpio_intr_e intr;
+	bool masked;		/*!< Interrupt masked by hal_gpio_intr_enable() */
+	hal_isr_t isr;
+	void * arg;
+} gpio_fake_t;
+
+typedef struct
+{
+	uint8_t clk_div;
+	hal_rmt_translator_t translator;
+	hal_rmt_tx_end_t tx_end;
+	void * tx_end_arg;
+	hal_rmt_item_t * items;
+	size_t item_num;
+} rmt_fake_t;
+
+struct hal_timer
+{
+	bool used;
+	bool active;
+	int64_t due;
+	hal_isr_t callback;
+	void * arg;
+};
+
+typedef struct nvs_entry
+{
+	char partition[NVS_NAME_SIZE];
+	char name[NVS_NAME_SIZE];
+	char key[NVS_NAME_SIZE];
+	size_t size;
+	uint8_t * value;
+	struct nvs_entry * next;
+} nvs_entry_t;
+
+typedef struct
+{
+	bool used;
+	bool write;
+	char partition[NVS_NAME_SIZE];
+	char name[NVS_NAME_SIZE];
+} nvs_fake_handle_t;
+
+typedef enum
+{
+	OTA_SLOT_EMPTY = 0,
+	OTA_SLOT_NEW,			/*!< Written, not booted yet */
+	OTA_SLOT_PENDING,		/*!< Booted, waiting for its self test */
+	OTA_SLOT_VALID,
+	OTA_SLOT_INVALID		/*!< Failed its self test, never booted again */
+} ota_slot_state_e;
+
+typedef struct
+{
+	uint8_t * data;
+	size_t size;			/*!< Bytes written */
+	ota_slot_state_e state;
+} ota_slot_t;
+
+typedef struct
+{
+	char label[PARTITION_LABEL_SIZE];
+	uint8_t * data;			/*!< NULL for none */
+} partition_fake_t;
+
+/* internal data declaration -------------------------------------------------*/
+
+static int64_t now_us = 0;
+static gpio_fake_t gpios[HAL_GPIO_MAX];
+static int adc_values[ADC_CHANNEL_MAX];
+static float temp_value = TEMP_DEFAULT;
+static rmt_fake_t rmts[HAL_RMT_CHANNEL_MAX];
+static nvs_entry_t * nvs_entries = NULL;
+static nvs_fake_handle_t nvs_handles[NVS_HANDLE_MAX];
+static uint32_t nvs_commits = 0;
+static hal_linux_gpio_hook_t gpio_hook = NULL;
+static void * gpio_hook_arg = NULL;
+static struct hal_timer timers[TIMER_MAX];
+static hal_linux_timer_hook_t timer_hook = NULL;
+static void * timer_hook_arg = NULL;
+static ota_slot_t ota_slots[OTA_SLOT_MAX];
+static int ota_running = OTA_FACTORY;
+static int ota_previous = OTA_FACTORY;	/*!< Slot a rollback boots */
+static int ota_boot = OTA_FACTORY;		/*!< Slot booted on the next restart */
+static int ota_writing = OTA_FACTORY;
+static partition_fake_t partitions[HAL_PARTITION_MAX];
+static uint32_t partition_erases = 0;
+static hal_sntp_sync_t sntp_callback = NULL;	/*!< NULL until SNTP is started */
+static hal_linux_sntp_hook_t sntp_hook = NULL;
+static void * sntp_hook_arg = NULL;
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static partition_fake_t * partition_get(hal_partition_t partition, size_t offset, size_t size);
+static nvs_fake_handle_t * nvs_get_handle(hal_nvs_handle_t handle);
+static nvs_entry_t * * nvs_find(const nvs_fake_handle_t * h, const char * key);
+
+/* external functions definition ---------------------------------------------*/
+
+/* GPIO */
+esp_err_t hal_gpio_config_output(uint64_t pin_mask)
+{
+	for(int pin = 0; pin < HAL_GPIO_MAX; pin++)
+	{
+		if(pin_mask & (1ULL << pin))
+		{
+			gpios[pin].output = true;
+			gpios[pin].intr = HAL_GPIO_INTR_DISABLE;
+		}
+	}
+
+	return ESP_OK;
+}
+
+esp_err_t hal_gpio_config_input(uint64_t pin_mask, hal_gpio_pull_e pull, hal_gpio_intr_e intr)
+{
+	for(int pin = 0; pin < HAL_GPIO_MAX; pin++)
+	{
+		if(pin_mask & (1ULL << pin))
+		{
+			gpios[pin].output = false;
+			gpios[pin].intr = intr;
+
+			/* Floating inputs read low */
+			if(!gpios[pin].driven)
+				gpios[pin].level = pull == HAL_GPIO_PULL_UP ? 1 : 0;
+		}
+	}
+
+	return ESP_OK;
+}
+
+esp_err_t hal_gpio_set_level(int pin, uint32_t level)
+{
+	if(pin < 0 || pin >= HAL_GPIO_MAX)
+		return ESP_ERR_INVALID_ARG;
+
+	if(!gpios[pin].output)
+		return ESP_OK;
+
+	uint32_t previous = gpios[pin].level;
+	gpios[pin].level = level ? 1 : 0;
+
+	if(gpios[pin].level != previous && gpio_hook != NULL)
+		gpio_hook(pin, gpios[pin].level, gpio_hook_arg);
+
+	return ESP_OK;
+}
+
+int hal_gpio_get_level(int pin)
+{
+	if(pin < 0 || pin >= HAL_GPIO_MAX)
+		return 0;
+
+	return gpios[pin].level;
+}
+
+esp_err_t hal_gpio_isr_add(int pin, hal_isr_t isr, void * arg)
+{
+	if(pin < 0 || pin >= HAL_GPIO_MAX)
+		return ESP_ERR_INVALID_ARG;
+
+	gpios[pin].isr = isr;
+	gpios[pin].arg = arg;
+
+	return ESP_OK;
+}
+
+esp_err_t hal_gpio_isr_remove(int pin)
+{
+	return hal_gpio_isr_add(pin, NULL, NULL);
+}
+
+esp_err_t hal_gpio_intr_enable(int pin, bool enable)
+{
+	if(pin < 0 || pin >= HAL_GPIO_MAX)
+		return ESP_ERR_INVALID_ARG;
+
+	gpios[pin].masked = !enable;
+
+	return ESP_OK;
+}
+
+/* Clock */
+int64_t hal_time_us(void)
+{
+	return now_us;
+}
+
+uint32_t hal_cycle_count(void)
+{
+	/* Host time, not the virtual clock, code is timed on the host CPU */
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint32_t)((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+/* Timers */
+esp_err_t hal_timer_create(hal_isr_t callback, void * arg, hal_timer_t * timer)
+{
+	for(int i = 0; i < TIMER_MAX; i++)
+	{
+		if(timers[i].used)
+			continue;
+
+		timers[i].used = true;
+		timers[i].active = false;
+		timers[i].callback = callback;
+		timers[i].arg = arg;
+		* timer = &timers[i];
+
+		return ESP_OK;
+	}
+
+	return ESP_ERR_NO_MEM;
+}
+
+esp_err_t hal_timer_start(hal_timer_t timer, uint64_t timeout_us)
+{
+	timer->active = true;
+	timer->due = now_us + timeout_us;
+
+	if(timer_hook != NULL)
+		timer_hook(timer->due, timer_hook_arg);
+
+	return ESP_OK;
+}
+
+esp_err_t hal_timer_stop(hal_timer_t timer)
+{
+	timer->active = false;
+
+	return ESP_OK;
+}
+
+/* ADC */
+esp_err_t hal_adc_config(int channel)
+{
+	return (channel >= 0 && channel < ADC_CHANNEL_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+int hal_adc_read(int channel)
+{
+	return (channel >= 0 && channel < ADC_CHANNEL_MAX) ? adc_values[channel] : 0;
+}
+
+/* Temperature sensor */
+esp_err_t hal_temp_init(void)
+{
+	return ESP_OK;
+}
+
+esp_err_t hal_temp_read(float * celsius)
+{
+	*celsius = temp_value;
+
+	return ESP_OK;
+}
+
+/* RMT */
+esp_err_t hal_rmt_tx_init(int channel, int pin, uint8_t clk_div)
+{
+	if(channel < 0 || channel >= HAL_RMT_CHANNEL_MAX || clk_div == 0)
+		return ESP_ERR_INVALID_ARG;
+
+	rmts[channel].clk_div = clk_div;
+
+	return hal_gpio_config_output(1ULL << pin);
+}
+
+esp_err_t hal_rmt_get_counter_clock(int channel, uint32_t * hz)
+{
+	if(channel < 0 || channel >= HAL_RMT_CHANNEL_MAX || rmts[channel].clk_div == 0)
+		return ESP_ERR_INVALID_STATE;
+
+	* hz = RMT_CLOCK / rmts[channel].clk_div;
+
+	return ESP_OK;
+}
+
+esp_err_t hal_rmt_translator_init(int channel, hal_rmt_translator_t translator)
+{
+	if(channel < 0 || channel >= HAL_RMT_CHANNEL_MAX)
+		return ESP_ERR_INVALID_ARG;
+
+	rmts[channel].translator = translator;
+
+	return ESP_OK;
+}
+
+esp_err_t hal_rmt_write(int channel, const uint8_t * src, size_t size, bool wait)
+{
+	if(channel < 0 || channel >= HAL_RMT_CHANNEL_MAX || rmts[channel].translator == NULL)
+		return ESP_ERR_INVALID_STATE;
+
+	rmt_fake_t * rmt = &rmts[channel];
+	size_t translated_size = 0;
+	size_t item_num = 0;
+
+	/* Translate the whole buffer at once, the transfer completes and calls its end callback immediately */
+	free(rmt->items);
+	rmt->items = calloc(size * 8 + 1, sizeof(hal_rmt_item_t));
+	rmt->item_num = 0;
+
+	if(rmt->items == NULL)
+		return ESP_ERR_NO_MEM;
+
+	rmt->translator(src, rmt->items, size, size * 8, &translated_size, &item_num);
+	rmt->item_num = item_num;
+
+	if(translated_size != size)
+		return ESP_FAIL;
+
+	if(rmt->tx_end != NULL)
+		rmt->tx_end(channel, rmt->tx_end_arg);
+
+	return ESP_OK;
+}
+
+esp_err_t hal_rmt_wait(int channel, uint32_t timeout_ms)
+{
+	return (channel >= 0 && channel < HAL_RMT_CHANNEL_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t hal_rmt_tx_end_callback(int channel, hal_rmt_tx_end_t callback, void * arg)
+{
+	if(channel < 0 || channel >= HAL_RMT_CHANNEL_MAX)
+		return ESP_ERR_INVALID_ARG;
+
+	rmts[channel].tx_end = callback;
+	rmts[channel].tx_end_arg = arg;
+
+	return ESP_OK;
+}
+
+/* System */
+void hal_restart(void)
+{
+	/* There is nothing to reboot into on the host */
+	exit(0);
+}
+
+size_t hal_heap_used(void)
+{
+	return mallinfo2().uordblks;
+}
+
+/* NVS */
+esp_err_t hal_nvs_init(const char * partition)
+{
+	return ESP_OK;
+}
+
+esp_err_t hal_nvs_open(const char * partition, const char * name, bool write, hal_nvs_handle_t * handle)
+{
+	if(name == NULL || strlen(name) >= NVS_NAME_SIZE)
+		return ESP_ERR_INVALID_ARG;
+
+	for(hal_nvs_handle_t i = 0; i < NVS_HANDLE_MAX; i++)
+	{
+		if(!nvs_handles[i].used)
+		{
+			nvs_handles[i].used = true;
+			nvs_handles[i].write = write;
+			strncpy(nvs_handles[i].partition, partition != NULL ? partition : NVS_DEFAULT_PART, NVS_NAME_SIZE - 1);
+			strncpy(nvs_handles[i].name, name, NVS_NAME_SIZE - 1);
+
+			/* Handles are never 0, as in ESP-IDF */
+			* handle = i + 1;
+
+			return ESP_OK;
+		}
+	}
+
+	return ESP_ERR_NO_MEM;
+}
+
+esp_err_t hal_nvs_get_blob(hal_nvs_handle_t handle, const char * key, void * value, size_t * size)
+{
+	nvs_fake_handle_t * h = nvs_get_handle(handle);
+
+	if(h == NULL)
+		return ESP_ERR_INVALID_ARG;
+
+	nvs_entry_t * entry = * nvs_find(h, key);
+
+	if(entry == NULL)
+		return ESP_ERR_NOT_FOUND;
+
+	/* A NULL value only queries the size, as in ESP-IDF */
+	if(value == NULL)
+	{
+		* size = entry->size;
+		return ESP_OK;
+	}
+
+	if(* size < entry->size)
+		return ESP_ERR_INVALID_SIZE;
+
+	memcpy(value, entry->value, entry->size);
+	* size = entry->size;
+
+	return ESP_OK;
+}
+
+esp_err_t hal_nvs_set_blob(hal_nvs_handle_t handle, const char * key, const void * value, size_t size)
+{
+	nvs_fake_handle_t * h = nvs_get_handle(handle);
+
+	if(h == NULL || !h->write || key == NULL || strlen(key) >= NVS_NAME_SIZE)
+		return ESP_ERR_INVALID_ARG;
+
+	uint8_t * copy = malloc(size ? size : 1);
+
+	if(copy == NULL)
+		return ESP_ERR_NO_MEM;
+
+	memcpy(copy, value, size);
+
+	nvs_entry_t * entry = * nvs_find(h, key);
+
+	if(entry == NULL)
+	{
+		entry = calloc(1, sizeof(nvs_entry_t));
+
+		if(entry == NULL)
+		{
+			free(copy);
+			return ESP_ERR_NO_MEM;
+		}
+
+		strncpy(entry->partition, h->partition, NVS_NAME_SIZE - 1);
+		strncpy(entry->name, h->name, NVS_NAME_SIZE - 1);
+		strncpy(entry->key, key, NVS_NAME_SIZE - 1);
+		entry->next = nvs_entries;
+		nvs_entries = entry;
+	}
+	else
+		free(entry->value);
+
+	entry->value = copy;
+	entry->size = size;
+
+	return ESP_OK;
+}
+
+esp_err_t hal_nvs_erase_key(hal_nvs_handle_t handle, const char * key)
+{
+	nvs_fake_handle_t * h = nvs_get_handle(handle);
+
+	if(h == NULL || !h->write)
+		return ESP_ERR_INVALID_ARG;
+
+	nvs_entry_t * * link = nvs_find(h, key);
+
+	if(* link == NULL)
+		return ESP_ERR_NOT_FOUND;
+
+	nvs_entry_t * entry = * link;
+	* link = entry->next;
+	free(entry->value);
+	free(entry);
+
+	return ESP_OK;
+}
+
+esp_err_t hal_nvs_erase_all(hal_nvs_handle_t handle)
+{
+	nvs_fake_handle_t * h = nvs_get_handle(handle);
+
+	if(h == NULL || !h->write)
+		return ESP_ERR_INVALID_ARG;
+
+	nvs_entry_t * * link = &nvs_entries;
+
+	while(* link != NULL)
+	{
+		nvs_entry_t * entry = * link;
+
+		if(!strcmp(entry->partition, h->partition) && !strcmp(entry->name, h->name))
+		{
+			* link = entry->next;
+			free(entry->value);
+			free(entry);
+		}
+		else
+			link = &entry->next;
+	}
+
+	return ESP_OK;
+}
+
+esp_err_t hal_nvs_commit(hal_nvs_handle_t handle)
+{
+	if(nvs_get_handle(handle) == NULL)
+		return ESP_ERR_INVALID_ARG;
+
+	nvs_commits++;
+
+	return ESP_OK;
+}
+
+void hal_nvs_close(hal_nvs_handle_t handle)
+{
+	nvs_fake_handle_t * h = nvs_get_handle(handle);
+
+	if(h != NULL)
+		h->used = false;
+}
+
+/* OTA */
+esp_err_t hal_ota_begin(size_t size, hal_ota_handle_t * handle)
+{
+	int slot = ota_running == 0 ? 1 : 0;
+
+	if(ota_writing != OTA_FACTORY)
+		return ESP_ERR_INVALID_STATE;
+
+	if(size > OTA_SLOT_SIZE)
+		return ESP_ERR_INVALID_SIZE;
+
+	if(ota_slots[slot].data == NULL)
+	{
+		ota_slots[slot].data = malloc(OTA_SLOT_SIZE);
+
+		if(ota_slots[slot].data == NULL)
+			return ESP_ERR_NO_MEM;
+	}
+
+	memset(ota_slots[slot].data, 0xFF, OTA_SLOT_SIZE);
+	ota_slots[slot].size = 0;
+	ota_slots[slot].state = OTA_SLOT_EMPTY;
+	ota_writing = slot;
+	* handle = slot + 1;
+
+	return ESP_OK;
+}
+
+esp_err_t hal_ota_write(hal_ota_handle_t handle, const void * data, size_t size)
+{
+	if(handle == 0 || (int)handle - 1 != ota_writing)
+		return ESP_ERR_INVALID_ARG;
+
+	ota_slot_t * slot = &ota_slots[handle - 1];
+
+	if(slot->size + size > OTA_SLOT_SIZE)
+		return ESP_ERR_INVALID_SIZE;
+
+	memcpy(slot->data + slot->size, data, size);
+	slot->size += size;
+
+	return ESP_OK;
+}
+
+esp_err_t hal_ota_end(hal_ota_handle_t handle)
+{
+	if(handle == 0 || (int)handle - 1 != ota_writing)
+		return ESP_ERR_INVALID_ARG;
+
+	ota_slots[ota_writing].state = OTA_SLOT_NEW;
+	ota_boot = ota_writing;
+	ota_writing = OTA_FACTORY;
+
+	return ESP_OK;
+}
+
+void hal_ota_abort(hal_ota_handle_t handle)
+{
+	if(handle == 0 || (int)handle - 1 != ota_writing)
+		return;
+
+	ota_slots[ota_writing].state = OTA_SLOT_EMPTY;
+	ota_writing = OTA_FACTORY;
+}
+
+bool hal_ota_pending(void)
+{
+	return ota_running != OTA_FACTORY && ota_slots[ota_running].state == OTA_SLOT_PENDING;
+}
+
+esp_err_t hal_ota_mark_valid(void)
+{
+	if(ota_running != OTA_FACTORY)
+		ota_slots[ota_running].state = OTA_SLOT_VALID;
+
+	return ESP_OK;
+}
+
+esp_err_t hal_ota_read_running(size_t offset, void * data, size_t size)
+{
+	/* The factory app is not faked, only images written by updates can be read */
+	if(ota_running == OTA_FACTORY)
+		return ESP_ERR_NOT_FOUND;
+
+	if(offset + size > OTA_SLOT_SIZE)
+		return ESP_ERR_INVALID_SIZE;
+
+	memcpy(data, ota_slots[ota_running].data + offset, size);
+
+	return ESP_OK;
+}
+
+const char * hal_ota_running_version(void)
+{
+	static char version[OTA_VERSION_SIZE + 1];
+
+	/* Nor is the version of the factory app */
+	if(ota_running == OTA_FACTORY)
+		return "";
+
+	memcpy(version, ota_slots[ota_running].data + OTA_VERSION_OFFSET, OTA_VERSION_SIZE);
+	version[OTA_VERSION_SIZE] = '\0';
+
+	return version;
+}
+
+esp_err_t hal_ota_rollback(void)
+{
+	if(!hal_ota_pending())
+		return ESP_ERR_INVALID_STATE;
+
+	ota_slots[ota_running].state = OTA_SLOT_INVALID;
+	ota_boot = ota_previous;
+	hal_restart();
+
+	return ESP_FAIL;
+}
+
+esp_err_t hal_ota_verify_signature(const void * block, const uint8_t * digest)
+{
+	/* There are no secure boot keys on the host, the caller already checked the digest in the block */
+	return ESP_OK;
+}
+
+/* Data partitions */
+esp_err_t hal_partition_open(const char * label, hal_partition_t * partition, size_t * size)
+{
+	for(int i = 0; i < HAL_PARTITION_MAX; i++)
+	{
+		/* Created erased on its first use, any label is found */
+		if(partitions[i].data == NULL)
+		{
+			partitions[i].data = malloc(PARTITION_SIZE);
+
+			if(partitions[i].data == NULL)
+				return ESP_ERR_NO_MEM;
+
+			memset(partitions[i].data, 0xFF, PARTITION_SIZE);
+			snprintf(partitions[i].label, PARTITION_LABEL_SIZE, "%s", label);
+		}
+
+		if(!strcmp(partitions[i].label, label))
+		{
+			* partition = i + 1;
+			* size = PARTITION_SIZE;
+
+			return ESP_OK;
+		}
+	}
+
+	return ESP_ERR_NO_MEM;
+}
+
+esp_err_t hal_partition_read(hal_partition_t partition, size_t offset, void * data, size_t size)
+{
+	partition_fake_t * p = partition_get(partition, offset, size);
+
+	if(p == NULL)
+		return ESP_ERR_INVALID_ARG;
+
+	memcpy(data, p->data + offset, size);
+
+	return ESP_OK;
+}
+
+esp_err_t hal_partition_write(hal_partition_t partition, size_t offset, const void * data, size_t size)
+{
+	partition_fake_t * p = partition_get(partition, offset, size);
+
+	if(p == NULL)
+		return ESP_ERR_INVALID_ARG;
+
+	/* Bits are only cleared, writing over data without an erase corrupts it as on flash */
+	for(size_t i = 0; i < size; i++)
+		p->data[offset + i] &= ((const uint8_t *)data)[i];
+
+	return ESP_OK;
+}
+
+esp_err_t hal_partition_erase(hal_partition_t partition, size_t offset, size_t size)
+{
+	partition_fake_t * p = partition_get(partition, offset, size);
+
+	if(p == NULL || offset % HAL_PARTITION_SECTOR != 0 || size % HAL_PARTITION_SECTOR != 0)
+		return ESP_ERR_INVALID_ARG;
+
+	memset(p->data + offset, 0xFF, size);
+	partition_erases += size / HAL_PARTITION_SECTOR;
+
+	return ESP_OK;
+}
+
+/* SNTP */
+esp_err_t hal_sntp_start(const char * server, uint32_t interval, hal_sntp_sync_t callback)
+{
+	if(sntp_callback != NULL)
+		return ESP_OK;
+
+	sntp_callback = callback;
+
+	if(sntp_hook != NULL)
+		sntp_hook(interval, sntp_hook_arg);
+
+	return ESP_OK;
+}
+
+/* Fakes control */
+void hal_linux_reset(void)
+{
+	now_us = 0;
+	memset(gpios, 0, sizeof(gpios));
+	memset(adc_values, 0, sizeof(adc_values));
+	temp_value = TEMP_DEFAULT;
+
+	for(int i = 0; i < HAL_RMT_CHANNEL_MAX; i++)
+		free(rmts[i].items);
+
+	memset(rmts, 0, sizeof(rmts));
+
+	while(nvs_entries != NULL)
+	{
+		nvs_entry_t * entry = nvs_entries;
+		nvs_entries = entry->next;
+		free(entry->value);
+		free(entry);
+	}
+
+	memset(nvs_handles, 0, sizeof(nvs_handles));
+	nvs_commits = 0;
+	gpio_hook = NULL;
+	gpio_hook_arg = NULL;
+	memset(timers, 0, sizeof(timers));
+	timer_hook = NULL;
+	timer_hook_arg = NULL;
+
+	for(int i = 0; i < OTA_SLOT_MAX; i++)
+		free(ota_slots[i].data);
+
+	memset(ota_slots, 0, sizeof(ota_slots));
+	ota_running = OTA_FACTORY;
+	ota_previous = OTA_FACTORY;
+	ota_boot = OTA_FACTORY;
+	ota_writing = OTA_FACTORY;
+
+	for(int i = 0; i < HAL_PARTITION_MAX; i++)
+		free(partitions[i].data);
+
+	memset(partitions, 0, sizeof(partitions));
+	partition_erases = 0;
+	sntp_callback = NULL;
+	sntp_hook = NULL;
+	sntp_hook_arg = NULL;
+}
+
+void hal_linux_time_set(int64_t now)
+{
+	now_us = now;
+}
+
+void hal_linux_time_advance(int64_t delta)
+{
+	now_us += delta;
+}
+
+void hal_linux_gpio_drive(int pin, uint32_t level)
+{
+	if(pin < 0 || pin >= HAL_GPIO_MAX || gpios[pin].output)
+		return;
+
+	gpio_fake_t * gpio = &gpios[pin];
+	uint32_t previous = gpio->level;
+	gpio->driven = true;
+	gpio->level = level ? 1 : 0;
+
+	if(gpio->level == previous || gpio->isr == NULL || gpio->masked)
+		return;
+
+	/* Call the ISR as the GPIO interrupt would */
+	if(gpio->intr == HAL_GPIO_INTR_ANYEDGE ||
+	   (gpio->intr == HAL_GPIO_INTR_POSEDGE && gpio->level) ||
+	   (gpio->intr == HAL_GPIO_INTR_NEGEDGE && !gpio->level))
+		gpio->isr(gpio->arg);
+}
+
+void hal_linux_gpio_set_hook(hal_linux_gpio_hook_t hook, void * arg)
+{
+	gpio_hook = hook;
+	gpio_hook_arg = arg;
+}
+
+void hal_linux_timer_set_hook(hal_linux_timer_hook_t hook, void * arg)
+{
+	timer_hook = hook;
+	timer_hook_arg = arg;
+}
+
+void hal_linux_timer_run(void)
+{
+	for(int i = 0; i < TIMER_MAX; i++)
+	{
+		/* Inactive before the callback, it can start the timer again */
+		if(timers[i].active && timers[i].due <= now_us)
+		{
+			timers[i].active = false;
+			timers[i].callback(timers[i].arg);
+		}
+	}
+}
+
+void hal_linux_adc_set(int channel, int value)
+{
+	if(channel >= 0 && channel < ADC_CHANNEL_MAX)
+		adc_values[channel] = value;
+}
+
+void hal_linux_temp_set(float celsius)
+{
+	temp_value = celsius;
+}
+
+size_t hal_linux_rmt_items(int channel, const hal_rmt_item_t * * items)
+{
+	if(channel < 0 || channel >= HAL_RMT_CHANNEL_MAX)
+		return 0;
+
+	* items = rmts[channel].items;
+
+	return rmts[channel].item_num;
+}
+
+uint32_t hal_linux_nvs_commits(void)
+{
+	return nvs_commits;
+}
+
+void hal_linux_ota_restart(void)
+{
+	ota_writing = OTA_FACTORY;
+
+	/* The bootloader rolls back an image restarted while waiting for its self test */
+	if(hal_ota_pending())
+	{
+		ota_slots[ota_running].state = OTA_SLOT_INVALID;
+
+		if(ota_boot == ota_running)
+			ota_boot = ota_previous;
+	}
+
+	if(ota_boot != ota_running)
+	{
+		ota_previous = ota_running;
+		ota_running = ota_boot;
+
+		if(ota_running != OTA_FACTORY && ota_slots[ota_running].state == OTA_SLOT_NEW)
+			ota_slots[ota_running].state = OTA_SLOT_PENDING;
+	}
+}
+
+int hal_linux_ota_running(void)
+{
+	return ota_running;
+}
+
+size_t hal_linux_ota_slot(int slot, const uint8_t * * data)
+{
+	if(slot < 0 || slot >= OTA_SLOT_MAX)
+		return 0;
+
+	* data = ota_slots[slot].data;
+
+	return ota_slots[slot].size;
+}
+
+uint32_t hal_linux_partition_erases(void)
+{
+	return partition_erases;
+}
+
+void hal_linux_sntp_set_hook(hal_linux_sntp_hook_t hook, void * arg)
+{
+	sntp_hook = hook;
+	sntp_hook_arg = arg;
+}
+
+void hal_linux_sntp_sync(int64_t time)
+{
+	if(sntp_callback != NULL)
+		sntp_callback(now_us, time);
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* Partition of a handle if the range is within it */
+static partition_fake_t * partition_get(hal_partition_t partition, size_t offset, size_t size)
+{
+	if(partition == 0 || partition > HAL_PARTITION_MAX || partitions[partition - 1].data == NULL ||
+			offset > PARTITION_SIZE || size > PARTITION_SIZE - offset)
+		return NULL;
+
+	return &partitions[partition - 1];
+}
+
+static nvs_fake_handle_t * nvs_get_handle(hal_nvs_handle_t handle)
+{
+	if(handle == 0 || handle > NVS_HANDLE_MAX || !nvs_handles[handle - 1].used)
+		return NULL;
+
+	return &nvs_handles[handle - 1];
+}
+
+static nvs_entry_t * * nvs_find(const nvs_fake_handle_t * h, const char * key)
+{
+	nvs_entry_t * * link = &nvs_entries;
+
+	while(* link != NULL)
+	{
+		if(!strcmp((* link)->partition, h->partition) && !strcmp((* link)->name, h->name) && !strcmp((* link)->key, key))
+			break;
+
+		link = &(* link)->next;
+	}
+
+	return link;
+}
+
+/* end of file ---------------------------------------------------------------*/
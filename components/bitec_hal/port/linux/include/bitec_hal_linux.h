@@ -0,0 +1,94 @@
+/*
+ * bitec_hal_linux.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_HAL_LINUX_H_
+#define _BITEC_HAL_LINUX_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include "bitec_hal.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef void (* hal_linux_gpio_hook_t)(int pin, uint32_t level, void * arg);
+typedef void (* hal_linux_timer_hook_t)(int64_t due, void * arg);
+typedef void (* hal_linux_sntp_hook_t)(uint32_t interval, void * arg);
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Fakes control for host builds. They are not thread safe, drive them from a single thread */
+
+/* Restore every fake to its power on state */
+void hal_linux_reset(void);
+
+/* Virtual clock, hal_time_us() only moves when told to */
+void hal_linux_time_set(int64_t now);
+void hal_linux_time_advance(int64_t delta);
+
+/* Drive an input pin. Edges matching the configured interrupt type call the ISR synchronously */
+void hal_linux_gpio_drive(int pin, uint32_t level);
+
+/* Called every time the firmware changes the level of an output pin */
+void hal_linux_gpio_set_hook(hal_linux_gpio_hook_t hook, void * arg);
+
+/* Called every time a timer is started with the virtual time it is due at */
+void hal_linux_timer_set_hook(hal_linux_timer_hook_t hook, void * arg);
+
+/* Call the callbacks of the timers due at the virtual time */
+void hal_linux_timer_run(void);
+
+/* Value returned by hal_adc_read() for a channel */
+void hal_linux_adc_set(int channel, int value);
+
+/* Value returned by hal_temp_read() in Celsius, 25 after a reset */
+void hal_linux_temp_set(float celsius);
+
+/* RMT items produced by the translator on the last write of a channel */
+size_t hal_linux_rmt_items(int channel, const hal_rmt_item_t * * items);
+
+/* Number of hal_nvs_commit() calls since the last reset */
+uint32_t hal_linux_nvs_commits(void);
+
+/* Restart into the boot image as the bootloader would, rolling back an image waiting for its self test */
+void hal_linux_ota_restart(void);
+
+/* Running app slot, 0 or 1, -1 for the factory app */
+int hal_linux_ota_running(void);
+
+/* Bytes written to an app slot by the last update */
+size_t hal_linux_ota_slot(int slot, const uint8_t * * data);
+
+/* Sectors erased in the data partitions since the last reset */
+uint32_t hal_linux_partition_erases(void);
+
+/* Called when SNTP is started with its poll interval in ms, the host delivers the syncs */
+void hal_linux_sntp_set_hook(hal_linux_sntp_hook_t hook, void * arg);
+
+/* Sync to a unix time of the server in us at the virtual time, once SNTP is started */
+void hal_linux_sntp_sync(int64_t time);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_HAL_LINUX_H_ */
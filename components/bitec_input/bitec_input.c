@@ -0,0 +1,229 @@
+/*
+ * bitec_input.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include "include/bitec_input.h"
+#include "esp_log.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define TICK_US			(portTICK_PERIOD_MS * 1000)
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static const char * TAG = "bitec_input";
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static void input_task(void * arg);
+static void isr_handler(void * arg);
+static size_t take_edge(bitec_input_t * const me, const bitec_input_edge_t * edge);
+static size_t deliver(bitec_input_t * const me, int64_t now, TickType_t * wait);
+static size_t emit(bitec_input_t * const me, bitec_input_pin_t * const entry);
+
+/* external functions definition ---------------------------------------------*/
+
+esp_err_t bitec_input_init(bitec_input_t * const me)
+{
+	ESP_LOGI(TAG, "Initializing inputs...");
+
+	me->pins_num = 0;
+	me->dropped = 0;
+	me->glitches = 0;
+	me->overflows = 0;
+
+	me->edges = xQueueCreate(CONFIG_BITEC_INPUT_EDGES_LEN, sizeof(bitec_input_edge_t));
+
+	if(me->edges == NULL)
+		return ESP_ERR_NO_MEM;
+
+	me->queue = xQueueCreate(CONFIG_BITEC_INPUT_QUEUE_LEN, sizeof(bitec_input_event_t));
+
+	if(me->queue == NULL)
+		return ESP_ERR_NO_MEM;
+
+	if(xTaskCreate(input_task, "Input Task", configMINIMAL_STACK_SIZE * 2, (void *)me, CONFIG_BITEC_INPUT_TASK_PRIORITY, &me->task) != pdPASS)
+		return ESP_ERR_NO_MEM;
+
+	return ESP_OK;
+}
+
+esp_err_t bitec_input_add(bitec_input_t * const me, int pin, hal_gpio_pull_e pull, uint32_t filter_us, void * arg)
+{
+	esp_err_t ret;
+
+	if(me->pins_num >= INPUT_PINS_MAX)
+		return ESP_ERR_NO_MEM;
+
+	ret = hal_gpio_config_input(1ULL << pin, pull, HAL_GPIO_INTR_ANYEDGE);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	bitec_input_pin_t * entry = &me->pins[me->pins_num];
+
+	entry->input = me;
+	entry->pin = pin;
+	entry->index = me->pins_num;
+	entry->filter = filter_us;
+	entry->arg = arg;
+	entry->level = hal_gpio_get_level(pin);
+	entry->pending = false;
+
+	/* Only the dispatcher reads the entries, the ISR is added once the entry is complete */
+	me->pins_num++;
+
+	return hal_gpio_isr_add(pin, isr_handler, (void *)entry);
+}
+
+int bitec_input_get_level(bitec_input_t * const me, int pin)
+{
+	for(size_t i = 0; i < me->pins_num; i++)
+	{
+		if(me->pins[i].pin == pin)
+			return me->pins[i].level;
+	}
+
+	return -1;
+}
+
+size_t bitec_input_dispatch(bitec_input_t * const me, TickType_t ticks)
+{
+	bitec_input_edge_t edge;
+	TickType_t wait = ticks;
+
+	/* Levels that became stable while no edge came still have to be delivered */
+	size_t events_num = deliver(me, hal_time_us(), &wait);
+
+	if(xQueueReceive(me->edges, &edge, wait) == pdTRUE)
+	{
+		do
+		{
+			events_num += take_edge(me, &edge);
+		} while(xQueueReceive(me->edges, &edge, 0) == pdTRUE);
+	}
+
+	wait = 0;
+
+	return events_num + deliver(me, hal_time_us(), &wait);
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static void input_task(void * arg)
+{
+	bitec_input_t * input = (bitec_input_t *)arg;
+
+	for(;;)
+		bitec_input_dispatch(input, portMAX_DELAY);
+}
+
+static void isr_handler(void * arg)
+{
+	bitec_input_pin_t * entry = (bitec_input_pin_t *)arg;
+	BaseType_t task_woken = pdFALSE;
+	bitec_input_edge_t edge =
+	{
+		.index = entry->index,
+		.level = hal_gpio_get_level(entry->pin),
+		.time = hal_time_us(),
+	};
+
+	/* Edges carry the level, the next one that fits resynchronizes the input */
+	if(xQueueSendFromISR(entry->input->edges, &edge, &task_woken) != pdTRUE)
+		entry->input->dropped++;
+
+	if(task_woken == pdTRUE)
+		portYIELD_FROM_ISR();
+}
+
+static size_t take_edge(bitec_input_t * const me, const bitec_input_edge_t * edge)
+{
+	bitec_input_pin_t * entry = &me->pins[edge->index];
+	size_t events_num = 0;
+
+	/* The pending level held until this edge, it is stable even if the edges were queued */
+	if(entry->pending && edge->time - entry->pending_time >= entry->filter)
+		events_num = emit(me, entry);
+
+	if(edge->level == entry->level)
+	{
+		/* Back to the delivered level before the filter time */
+		if(entry->pending)
+		{
+			entry->pending = false;
+			me->glitches++;
+		}
+	}
+	/* Bounces keep the time of the first edge */
+	else if(!entry->pending)
+	{
+		entry->pending = true;
+		entry->pending_time = edge->time;
+	}
+
+	return events_num;
+}
+
+static size_t deliver(bitec_input_t * const me, int64_t now, TickType_t * wait)
+{
+	size_t events_num = 0;
+
+	for(size_t i = 0; i < me->pins_num; i++)
+	{
+		bitec_input_pin_t * entry = &me->pins[i];
+
+		if(!entry->pending)
+			continue;
+
+		int64_t left = entry->pending_time + entry->filter - now;
+
+		if(left > 0)
+		{
+			/* Wake up when the level is stable to deliver it */
+			TickType_t ticks = (left + TICK_US - 1) / TICK_US;
+
+			if(ticks < * wait)
+				* wait = ticks;
+
+			continue;
+		}
+
+		events_num += emit(me, entry);
+	}
+
+	return events_num;
+}
+
+static size_t emit(bitec_input_t * const me, bitec_input_pin_t * const entry)
+{
+	entry->pending = false;
+	entry->level = !entry->level;
+
+	bitec_input_event_t event =
+	{
+		.pin = entry->pin,
+		.level = entry->level,
+		.time = entry->pending_time,
+		.arg = entry->arg,
+	};
+
+	if(xQueueSend(me->queue, &event, 0) != pdTRUE)
+	{
+		me->overflows++;
+		return 0;
+	}
+
+	return 1;
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,110 @@
+/*
+ * bitec_input.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_INPUT_H_
+#define _BITEC_INPUT_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#include "esp_err.h"
+#include "bitec_hal.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#ifdef CONFIG_BITEC_INPUT_PINS_MAX
+#define INPUT_PINS_MAX		CONFIG_BITEC_INPUT_PINS_MAX
+#else
+#define INPUT_PINS_MAX		8
+#endif
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef struct
+{
+	int pin;
+	uint32_t level;				/*!< Level after the filter */
+	int64_t time;				/*!< Time of the first edge of the level in microseconds */
+	void * arg;					/*!< Argument given to bitec_input_add() */
+} bitec_input_event_t;
+
+/* Edge as seen by the interrupt */
+typedef struct
+{
+	uint8_t index;				/*!< Input index in the service */
+	uint8_t level;
+	int64_t time;
+} bitec_input_edge_t;
+
+typedef struct bitec_input bitec_input_t;
+
+typedef struct
+{
+	bitec_input_t * input;		/*!< Service the pin belongs to, for the ISR */
+	int pin;
+	uint8_t index;
+	uint32_t filter;			/*!< A level is taken once stable for this time in microseconds */
+	void * arg;
+	uint32_t level;				/*!< Last level delivered */
+	bool pending;				/*!< A new level waits for the filter time */
+	int64_t pending_time;		/*!< First edge of the pending level */
+} bitec_input_pin_t;
+
+struct bitec_input
+{
+	bitec_input_pin_t pins[INPUT_PINS_MAX];
+	size_t pins_num;
+	QueueHandle_t edges;		/*!< Raw edges from the interrupts, bitec_input_edge_t */
+	QueueHandle_t queue;		/*!< Filtered events of every input, bitec_input_event_t */
+	TaskHandle_t task;
+	uint32_t dropped;			/*!< Edges lost because the edges queue was full */
+	uint32_t glitches;			/*!< Pulses shorter than the filter time */
+	uint32_t overflows;			/*!< Events lost because the events queue was full */
+};
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Create the queues and the dispatcher task, inputs can be added afterwards */
+esp_err_t bitec_input_init(bitec_input_t * const me);
+
+/* Configure a pin as an input with interrupts on both edges. Its events carry arg, filter_us is
+ * the time a level must hold to be delivered, 0 to deliver every edge */
+esp_err_t bitec_input_add(bitec_input_t * const me, int pin, hal_gpio_pull_e pull, uint32_t filter_us, void * arg);
+
+/* Last level delivered of a pin, -1 if the pin was not added */
+int bitec_input_get_level(bitec_input_t * const me, int pin);
+
+/* Filter the queued edges into events, waiting up to ticks for the first one. The dispatcher task
+ * runs it forever, exposed to drive the service without the task. Returns the events delivered */
+size_t bitec_input_dispatch(bitec_input_t * const me, TickType_t ticks);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_INPUT_H_ */
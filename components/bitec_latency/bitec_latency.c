@@ -0,0 +1,229 @@
+/*
+ * bitec_latency.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <string.h>
+#include <inttypes.h>
+
+#include "include/bitec_latency.h"
+#include "esp_log.h"
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static const char * TAG = "bitec_latency";
+
+/* Histogram names in the exported JSON, LATENCY_STAGE_SAMPLE holds the end-to-end interval */
+static const char * const stage_names[LATENCY_STAGE_MAX] =
+{
+	"e2e",
+	"notify",
+	"serialize",
+	"enqueue",
+	"ack"
+};
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static void record(bitec_latency_t * const me, bitec_latency_stage_e stage, int64_t now);
+
+/* external functions definition ---------------------------------------------*/
+
+esp_err_t bitec_latency_init(bitec_latency_t * const me)
+{
+	ESP_LOGI(TAG, "Initializing latency probes...");
+
+	portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+	me->lock = lock;
+
+	bitec_latency_reset(me);
+
+	return ESP_OK;
+}
+
+void bitec_latency_stamp(bitec_latency_t * const me, bitec_latency_stage_e stage)
+{
+	int64_t now = hal_time_us();
+
+	portENTER_CRITICAL(&me->lock);
+	record(me, stage, now);
+	portEXIT_CRITICAL(&me->lock);
+}
+
+void bitec_latency_enqueued(bitec_latency_t * const me, int msg_id)
+{
+	int64_t now = hal_time_us();
+
+	portENTER_CRITICAL(&me->lock);
+	record(me, LATENCY_STAGE_ENQUEUE, now);
+
+	/* QoS 0 messages (msg_id 0) and failed publishes are never acknowledged */
+	me->msg_id = msg_id > 0 ? msg_id : LATENCY_NO_MSG_ID;
+	portEXIT_CRITICAL(&me->lock);
+}
+
+void bitec_latency_ack(bitec_latency_t * const me, int msg_id)
+{
+	int64_t now = hal_time_us();
+
+	portENTER_CRITICAL(&me->lock);
+
+	if(msg_id > 0 && msg_id == me->msg_id)
+	{
+		record(me, LATENCY_STAGE_ACK, now);
+
+		if(me->stamps[LATENCY_STAGE_SAMPLE] > 0 && now >= me->stamps[LATENCY_STAGE_SAMPLE])
+			bitec_latency_histogram_add(&me->stages[LATENCY_STAGE_SAMPLE], (uint32_t)(now - me->stamps[LATENCY_STAGE_SAMPLE]));
+
+		me->msg_id = LATENCY_NO_MSG_ID;
+	}
+
+	portEXIT_CRITICAL(&me->lock);
+}
+
+void bitec_latency_overrun(bitec_latency_t * const me, uint32_t lateness)
+{
+	portENTER_CRITICAL(&me->lock);
+	bitec_latency_histogram_add(&me->overrun, lateness);
+	portEXIT_CRITICAL(&me->lock);
+}
+
+void bitec_latency_reset(bitec_latency_t * const me)
+{
+	portENTER_CRITICAL(&me->lock);
+	memset(me->stamps, 0, sizeof(me->stamps));
+	memset(me->stages, 0, sizeof(me->stages));
+	memset(&me->overrun, 0, sizeof(me->overrun));
+	me->msg_id = LATENCY_NO_MSG_ID;
+	portEXIT_CRITICAL(&me->lock);
+}
+
+int bitec_latency_print(bitec_latency_t * const me, char * buf, size_t size)
+{
+	bitec_latency_histogram_t histogram;
+	int len = 0;
+	int ret;
+
+	ret = snprintf(buf, size, "{");
+
+	if(ret < 0 || (size_t)ret >= size)
+		return -1;
+
+	len += ret;
+
+	/* Copy one histogram at a time to keep the critical sections short */
+	for(uint8_t i = 0; i <= LATENCY_STAGE_MAX; i++)
+	{
+		portENTER_CRITICAL(&me->lock);
+		histogram = (i < LATENCY_STAGE_MAX) ? me->stages[i] : me->overrun;
+		portEXIT_CRITICAL(&me->lock);
+
+		ret = snprintf(buf + len, size - len, "%s\"%s\":", i ? "," : "", (i < LATENCY_STAGE_MAX) ? stage_names[i] : "overrun");
+
+		if(ret < 0 || (size_t)ret >= size - len)
+			return -1;
+
+		len += ret;
+
+		ret = bitec_latency_histogram_print(&histogram, buf + len, size - len);
+
+		if(ret < 0)
+			return -1;
+
+		len += ret;
+	}
+
+	ret = snprintf(buf + len, size - len, "}");
+
+	if(ret < 0 || (size_t)ret >= size - len)
+		return -1;
+
+	return len + ret;
+}
+
+uint8_t bitec_latency_bucket(uint32_t value)
+{
+	/* Bucket n holds [2^(n-1), 2^n), bucket 0 holds 0 */
+	uint8_t bucket = value ? 32 - __builtin_clz(value) : 0;
+
+	return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+void bitec_latency_histogram_add(bitec_latency_histogram_t * const histogram, uint32_t value)
+{
+	histogram->buckets[bitec_latency_bucket(value)]++;
+	histogram->count++;
+	histogram->sum += value;
+
+	if(value > histogram->max)
+		histogram->max = value;
+}
+
+int bitec_latency_histogram_print(const bitec_latency_histogram_t * const histogram, char * buf, size_t size)
+{
+	int len = 0;
+	int ret;
+	uint8_t used = LATENCY_BUCKETS;
+
+	/* Trailing empty buckets are not exported */
+	while(used > 0 && histogram->buckets[used - 1] == 0)
+		used--;
+
+	ret = snprintf(buf, size, "{\"count\":%" PRIu32 ",\"max\":%" PRIu32 ",\"mean\":%" PRIu32 ",\"buckets\":[",
+			histogram->count,
+			histogram->max,
+			histogram->count ? (uint32_t)(histogram->sum / histogram->count) : 0);
+
+	if(ret < 0 || (size_t)ret >= size)
+		return -1;
+
+	len += ret;
+
+	for(uint8_t i = 0; i < used; i++)
+	{
+		ret = snprintf(buf + len, size - len, "%s%" PRIu32, i ? "," : "", histogram->buckets[i]);
+
+		if(ret < 0 || (size_t)ret >= size - len)
+			return -1;
+
+		len += ret;
+	}
+
+	ret = snprintf(buf + len, size - len, "]}");
+
+	if(ret < 0 || (size_t)ret >= size - len)
+		return -1;
+
+	return len + ret;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static void record(bitec_latency_t * const me, bitec_latency_stage_e stage, int64_t now)
+{
+	if(stage >= LATENCY_STAGE_MAX)
+		return;
+
+	/* Every stage but the first one measures the interval from the previous stage */
+	if(stage > LATENCY_STAGE_SAMPLE)
+	{
+		int64_t previous = me->stamps[stage - 1];
+
+		if(previous > 0 && now >= previous)
+			bitec_latency_histogram_add(&me->stages[stage], (uint32_t)(now - previous));
+	}
+
+	me->stamps[stage] = now;
+}
+
+/* end of file ---------------------------------------------------------------*/
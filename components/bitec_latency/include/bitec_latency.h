@@ -0,0 +1,95 @@
+/*
+ * bitec_latency.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_LATENCY_H_
+#define _BITEC_LATENCY_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "esp_err.h"
+#include "bitec_hal.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#ifdef CONFIG_BITEC_LATENCY_BUCKETS
+#define LATENCY_BUCKETS		CONFIG_BITEC_LATENCY_BUCKETS
+#else
+#define LATENCY_BUCKETS		24
+#endif
+
+#define LATENCY_NO_MSG_ID	-1		/*!< No publish is waiting for its acknowledge */
+
+/* typedef -------------------------------------------------------------------*/
+
+/* Probes along the sensor to publish path, in the order they are hit */
+typedef enum
+{
+	LATENCY_STAGE_SAMPLE = 0,	/*!< Sensors sampled in get_sensors_task */
+	LATENCY_STAGE_NOTIFY,		/*!< send_data_task notified */
+	LATENCY_STAGE_SERIALIZE,	/*!< JSON message built */
+	LATENCY_STAGE_ENQUEUE,		/*!< esp_mqtt_client_publish returned */
+	LATENCY_STAGE_ACK,			/*!< MQTT_EVENT_PUBLISHED received */
+	LATENCY_STAGE_MAX
+} bitec_latency_stage_e;
+
+typedef struct
+{
+	uint32_t buckets[LATENCY_BUCKETS];	/*!< Log2 buckets in microseconds */
+	uint32_t count;						/*!< Number of recorded intervals */
+	uint32_t max;						/*!< Longest recorded interval in microseconds */
+	uint64_t sum;						/*!< Sum of recorded intervals in microseconds */
+} bitec_latency_histogram_t;
+
+typedef struct
+{
+	int64_t stamps[LATENCY_STAGE_MAX];						/*!< Last timestamp of every stage */
+	int msg_id;												/*!< Message id waiting for LATENCY_STAGE_ACK */
+	bitec_latency_histogram_t stages[LATENCY_STAGE_MAX];	/*!< Interval from the previous stage, LATENCY_STAGE_SAMPLE holds sample to ack */
+	bitec_latency_histogram_t overrun;						/*!< Lateness of overrun periodic loops */
+	portMUX_TYPE lock;										/*!< Protects stamps and histograms */
+} bitec_latency_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+esp_err_t bitec_latency_init(bitec_latency_t * const me);
+void bitec_latency_stamp(bitec_latency_t * const me, bitec_latency_stage_e stage);
+void bitec_latency_enqueued(bitec_latency_t * const me, int msg_id);
+void bitec_latency_ack(bitec_latency_t * const me, int msg_id);
+void bitec_latency_overrun(bitec_latency_t * const me, uint32_t lateness);
+void bitec_latency_reset(bitec_latency_t * const me);
+int bitec_latency_print(bitec_latency_t * const me, char * buf, size_t size);
+
+/* Histogram primitives, free of any RTOS dependency */
+uint8_t bitec_latency_bucket(uint32_t value);
+void bitec_latency_histogram_add(bitec_latency_histogram_t * const histogram, uint32_t value);
+int bitec_latency_histogram_print(const bitec_latency_histogram_t * const histogram, char * buf, size_t size);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_LATENCY_H_ */
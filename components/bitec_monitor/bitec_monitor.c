@@ -0,0 +1,185 @@
+/*
+ * bitec_monitor.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "bitec_monitor.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define MEAN_SHIFT			4			/*!< Weight of a reading in the learnt load, 1/16 */
+#define POWER_LIMIT			(1L << 22)	/*!< Readings are clamped to keep the Q8 sums in range */
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static const char * const names[MONITOR_MAX] =
+{
+	[MONITOR_OVERCURRENT] = "overcurrent",
+	[MONITOR_OVERPOWER] = "overpower",
+	[MONITOR_SAG] = "sag",
+	[MONITOR_SWELL] = "swell",
+	[MONITOR_STUCK] = "stuck",
+	[MONITOR_LOAD_STEP] = "load_step",
+};
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static bool load_step(bitec_monitor_t * const me, int32_t power);
+
+/* external functions definition ---------------------------------------------*/
+
+void bitec_monitor_init(bitec_monitor_t * const me)
+{
+	memset(me, 0, sizeof(bitec_monitor_t));
+
+	me->max_current = MONITOR_MAX_CURRENT;
+	me->max_power = MONITOR_MAX_POWER;
+	me->sag_voltage = MONITOR_SAG_VOLTAGE;
+	me->swell_voltage = MONITOR_SWELL_VOLTAGE;
+	me->stuck_current = MONITOR_STUCK_CURRENT;
+	me->persistence = MONITOR_PERSISTENCE;
+	me->step_drift = MONITOR_STEP_DRIFT;
+	me->step_threshold = MONITOR_STEP_THRESHOLD;
+	me->learning = true;
+}
+
+uint32_t bitec_monitor_update(bitec_monitor_t * const me, const bitec_monitor_sample_t * sample)
+{
+	bool beyond[MONITOR_LOAD_STEP];
+	uint32_t raised = 0;
+
+	beyond[MONITOR_OVERCURRENT] = sample->current > me->max_current;
+	beyond[MONITOR_OVERPOWER] = sample->power > me->max_power;
+	beyond[MONITOR_SAG] = sample->voltage != 0 && sample->voltage < me->sag_voltage;
+	beyond[MONITOR_SWELL] = sample->voltage > me->swell_voltage;
+	beyond[MONITOR_STUCK] = !sample->relay && sample->current > me->stuck_current;
+
+	for(int i = 0; i < MONITOR_LOAD_STEP; i++)
+	{
+		uint32_t bit = 1UL << i;
+
+		if(me->active & bit)
+		{
+			/* Cleared after persistence readings within the limit */
+			if(beyond[i])
+				me->counts[i] = 0;
+			else if(++me->counts[i] >= me->persistence)
+			{
+				me->active &= ~bit;
+				me->counts[i] = 0;
+			}
+		}
+		else if(!beyond[i])
+			me->counts[i] = 0;
+		else if((bit & MONITOR_OVERLOAD) || ++me->counts[i] >= me->persistence)
+		{
+			/* An overload can not wait for another reading */
+			me->active |= bit;
+			me->counts[i] = 0;
+			me->events[i]++;
+			raised |= bit;
+		}
+	}
+
+	/* The load follows the relay, it is learnt again once the reading settles */
+	if(sample->relay != me->relay)
+	{
+		me->relay = sample->relay;
+		me->settle = me->persistence;
+	}
+
+	if(me->settle > 0)
+	{
+		me->settle--;
+		me->learning = true;
+	}
+	else if(raised & MONITOR_OVERLOAD)
+		me->learning = true;
+	else if(load_step(me, sample->power < POWER_LIMIT ? sample->power : POWER_LIMIT))
+	{
+		me->events[MONITOR_LOAD_STEP]++;
+		raised |= 1UL << MONITOR_LOAD_STEP;
+	}
+
+	return raised;
+}
+
+const char * bitec_monitor_name(bitec_monitor_anomaly_e anomaly)
+{
+	return anomaly < MONITOR_MAX ? names[anomaly] : "unknown";
+}
+
+int bitec_monitor_print(const bitec_monitor_t * const me, char * buf, size_t size)
+{
+	int len = 0;
+
+	for(int i = 0; i < MONITOR_MAX; i++)
+	{
+		int ret = snprintf(buf + len, size - len, "%s\"%s\":%" PRIu32, i == 0 ? "{" : ",", names[i], me->events[i]);
+
+		if(ret < 0 || (size_t)ret >= size - len)
+			return -1;
+
+		len += ret;
+	}
+
+	int ret = snprintf(buf + len, size - len, "}");
+
+	if(ret < 0 || (size_t)ret >= size - len)
+		return -1;
+
+	return len + ret;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* Two sided CUSUM of the power around the learnt load, the learnt load follows slow drifts */
+static bool load_step(bitec_monitor_t * const me, int32_t power)
+{
+	if(me->learning)
+	{
+		me->learning = false;
+		me->mean = power << 8;
+		me->cusum_up = 0;
+		me->cusum_down = 0;
+		return false;
+	}
+
+	int32_t deviation = power - (me->mean >> 8);
+
+	me->cusum_up += deviation - (int32_t)me->step_drift;
+	me->cusum_down += -deviation - (int32_t)me->step_drift;
+
+	if(me->cusum_up < 0)
+		me->cusum_up = 0;
+
+	if(me->cusum_down < 0)
+		me->cusum_down = 0;
+
+	/* The new load is the one to watch from now on */
+	if(me->cusum_up > (int32_t)me->step_threshold || me->cusum_down > (int32_t)me->step_threshold)
+	{
+		me->mean = power << 8;
+		me->cusum_up = 0;
+		me->cusum_down = 0;
+		return true;
+	}
+
+	me->mean += ((power << 8) - me->mean) >> MEAN_SHIFT;
+
+	return false;
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,150 @@
+/*
+ * bitec_monitor.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_MONITOR_H_
+#define _BITEC_MONITOR_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#ifdef CONFIG_BITEC_MONITOR_MAX_CURRENT
+#define MONITOR_MAX_CURRENT		CONFIG_BITEC_MONITOR_MAX_CURRENT
+#else
+#define MONITOR_MAX_CURRENT		10000
+#endif
+
+#ifdef CONFIG_BITEC_MONITOR_MAX_POWER
+#define MONITOR_MAX_POWER		CONFIG_BITEC_MONITOR_MAX_POWER
+#else
+#define MONITOR_MAX_POWER		2200
+#endif
+
+#ifdef CONFIG_BITEC_MONITOR_SAG_VOLTAGE
+#define MONITOR_SAG_VOLTAGE		CONFIG_BITEC_MONITOR_SAG_VOLTAGE
+#else
+#define MONITOR_SAG_VOLTAGE		190
+#endif
+
+#ifdef CONFIG_BITEC_MONITOR_SWELL_VOLTAGE
+#define MONITOR_SWELL_VOLTAGE	CONFIG_BITEC_MONITOR_SWELL_VOLTAGE
+#else
+#define MONITOR_SWELL_VOLTAGE	250
+#endif
+
+#ifdef CONFIG_BITEC_MONITOR_STUCK_CURRENT
+#define MONITOR_STUCK_CURRENT	CONFIG_BITEC_MONITOR_STUCK_CURRENT
+#else
+#define MONITOR_STUCK_CURRENT	50
+#endif
+
+#ifdef CONFIG_BITEC_MONITOR_PERSISTENCE
+#define MONITOR_PERSISTENCE		CONFIG_BITEC_MONITOR_PERSISTENCE
+#else
+#define MONITOR_PERSISTENCE		3
+#endif
+
+#ifdef CONFIG_BITEC_MONITOR_STEP_DRIFT
+#define MONITOR_STEP_DRIFT		CONFIG_BITEC_MONITOR_STEP_DRIFT
+#else
+#define MONITOR_STEP_DRIFT		20
+#endif
+
+#ifdef CONFIG_BITEC_MONITOR_STEP_THRESHOLD
+#define MONITOR_STEP_THRESHOLD	CONFIG_BITEC_MONITOR_STEP_THRESHOLD
+#else
+#define MONITOR_STEP_THRESHOLD	200
+#endif
+
+/* Anomalies that call for the load to be disconnected */
+#define MONITOR_OVERLOAD		((1UL << MONITOR_OVERCURRENT) | (1UL << MONITOR_OVERPOWER))
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef enum
+{
+	MONITOR_OVERCURRENT = 0,
+	MONITOR_OVERPOWER,
+	MONITOR_SAG,
+	MONITOR_SWELL,
+	MONITOR_STUCK,			/*!< Current flowing with the relay off */
+	MONITOR_LOAD_STEP,		/*!< Sudden load change, an event with no duration */
+	MONITOR_MAX
+} bitec_monitor_anomaly_e;
+
+typedef struct
+{
+	uint16_t voltage;		/*!< RMS voltage in V, 0 while unknown */
+	uint32_t current;		/*!< RMS current in mA */
+	uint32_t power;			/*!< Apparent power in VA */
+	bool relay;				/*!< Relay on */
+} bitec_monitor_sample_t;
+
+typedef struct
+{
+	/* Configuration, set from Kconfig by bitec_monitor_init() */
+	uint32_t max_current;
+	uint32_t max_power;
+	uint16_t sag_voltage;
+	uint16_t swell_voltage;
+	uint32_t stuck_current;
+	uint8_t persistence;		/*!< Readings to flag a sag, a swell or a stuck load, and to clear any */
+	uint32_t step_drift;		/*!< CUSUM allowance in VA */
+	uint32_t step_threshold;	/*!< CUSUM decision threshold in VA */
+
+	/* State */
+	uint32_t active;			/*!< Anomalies flagged and not cleared, bits of bitec_monitor_anomaly_e */
+	uint8_t counts[MONITOR_MAX];/*!< Consecutive readings beyond the limit if clear, within it if active */
+	bool learning;				/*!< The next reading is the load to watch */
+	uint8_t settle;				/*!< Readings ignored before learning the load after a relay switch */
+	bool relay;
+	int32_t mean;				/*!< Learnt load in VA, Q8 */
+	int32_t cusum_up;
+	int32_t cusum_down;
+
+	/* Metrics */
+	uint32_t events[MONITOR_MAX];
+} bitec_monitor_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Set the configuration from Kconfig and clear the state, it can be changed afterwards */
+void bitec_monitor_init(bitec_monitor_t * const me);
+
+/* Process a reading, returns the anomalies it raised. Works on readings alone so traces can be
+ * replayed on host */
+uint32_t bitec_monitor_update(bitec_monitor_t * const me, const bitec_monitor_sample_t * sample);
+
+/* Name of an anomaly in the alarms and metrics */
+const char * bitec_monitor_name(bitec_monitor_anomaly_e anomaly);
+
+/* Print the events count of every anomaly as JSON. Returns its length or -1 if it does not fit */
+int bitec_monitor_print(const bitec_monitor_t * const me, char * buf, size_t size);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_MONITOR_H_ */
@@ -7,14 +7,21 @@
 
 /* inclusions ----------------------------------------------------------------*/
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "include/bitec_mqtt.h"
 #include "mqtt_client.h"
 #include "esp_log.h"
+#include "bitec_trace.h"
 
 /* macros --------------------------------------------------------------------*/
 
-#ifdef CONFIG_BITEC_MQTT_LWT_ENABLE
-#define MQTT_LWT_TOPIC	CONFIG_BITEC_MQTT_LWT_TOPIC CONFIG_APPLICATION_DEVICE_ID
+#ifdef CONFIG_APPLICATION_DEVICE_ID
+#define MQTT_DEVICE		CONFIG_APPLICATION_DEVICE_ID
+#else
+#define MQTT_DEVICE		""
 #endif
 
 /* typedef -------------------------------------------------------------------*/
@@ -28,6 +35,7 @@ static const char * TAG = "digihome_mqtt";
 /* internal functions declaration --------------------------------------------*/
 
 static void mqtt_event_handler(void * handler_args, esp_event_base_t base, int32_t event_id, void * event_data);
+static void message_queue(bitec_mqtt_t * const me, esp_mqtt_event_handle_t event);
 
 /* external functions definition ---------------------------------------------*/
 
@@ -38,6 +46,12 @@ esp_err_t bitec_mqtt_init(bitec_mqtt_t * const me)
 	/* Create Wi-Fi event group */
 	me->event_group = xEventGroupCreate();
 
+	/* The events are only valid during the handler call, incoming messages are copied to the queue */
+	me->queue = xQueueCreate(MQTT_QUEUE_LENGTH, sizeof(bitec_mqtt_message_t));
+
+	if(me->event_group == NULL || me->queue == NULL)
+		return ESP_ERR_NO_MEM;
+
 	if(me->config.uri == NULL)
 	{
 		me->config.uri = CONFIG_BITEC_MQTT_BROKER_URL;
@@ -45,7 +59,9 @@ esp_err_t bitec_mqtt_init(bitec_mqtt_t * const me)
 		me->config.client_key_pem = (const char *)client_key_pem_start;
 		me->config.cert_pem = (const char *)server_cert_pem_start;
 #ifdef CONFIG_BITEC_MQTT_LWT_ENABLE
-		me->config.lwt_topic = MQTT_LWT_TOPIC;
+		/* The id can be changed by the settings, the topic is built from the one in use */
+		snprintf(me->lwt_topic, sizeof(me->lwt_topic), "%s%s", CONFIG_BITEC_MQTT_LWT_TOPIC, me->device != NULL ? me->device : MQTT_DEVICE);
+		me->config.lwt_topic = me->lwt_topic;
 		me->config.lwt_msg = CONFIG_BITEC_MQTT_LWT_MESSAGE;
 		me->config.lwt_msg_len = CONFIG_BITEC_MQTT_LWT_LENGHT;
 		me->config.lwt_qos = CONFIG_BITEC_MQTT_LWT_QOS;
@@ -63,26 +79,39 @@ esp_err_t bitec_mqtt_init(bitec_mqtt_t * const me)
 	return ret;
 }
 
+/* Take the next incoming message without waiting. Returns false when there is none */
+bool bitec_mqtt_receive(bitec_mqtt_t * const me, bitec_mqtt_message_t * const message)
+{
+	return xQueueReceive(me->queue, message, 0) == pdTRUE;
+}
+
+void bitec_mqtt_message_free(bitec_mqtt_message_t * const message)
+{
+	/* The data is in the same block as the topic */
+	free(message->topic);
+	message->topic = NULL;
+	message->data = NULL;
+}
+
 /* internal functions definition ---------------------------------------------*/
 
 static void mqtt_event_handler(void * handler_args, esp_event_base_t base, int32_t event_id, void * event_data)
 {
 	esp_mqtt_event_handle_t event = (esp_mqtt_event_handle_t)event_data;
 	bitec_mqtt_t * mqtt = (bitec_mqtt_t *)event->user_context;
-	mqtt->event_data = event;
 
 	// your_context_t *context = event->context;
-	switch (mqtt->event_data->event_id)
+	switch (event->event_id)
 	{
 		case MQTT_EVENT_CONNECTED:
-			ESP_LOGI(TAG, "MQTT_EVENT_CONNECTED");
+			BITEC_TRACE(TAG, TRACE_MQTT_CONNECTED, 0, 0, "MQTT_EVENT_CONNECTED");
 
 			xEventGroupSetBits(mqtt->event_group, MQTT_EVENT_CONNECTED_BIT);
 
 			break;
 
 		case MQTT_EVENT_DISCONNECTED:
-			ESP_LOGI(TAG, "MQTT_EVENT_DISCONNECTED");
+			BITEC_TRACE(TAG, TRACE_MQTT_DISCONNECTED, 0, 0, "MQTT_EVENT_DISCONNECTED");
 
 			xEventGroupSetBits(mqtt->event_group, MQTT_EVENT_DISCONNECTED_BIT);
 
@@ -90,49 +119,90 @@ static void mqtt_event_handler(void * handler_args, esp_event_base_t base, int32
 
 
 		case MQTT_EVENT_SUBSCRIBED:
-			ESP_LOGI(TAG, "MQTT_EVENT_SUBSCRIBED, msg_id=%d", event->msg_id);
+			BITEC_TRACE(TAG, TRACE_MQTT_SUBSCRIBED, event->msg_id, 0, "MQTT_EVENT_SUBSCRIBED, msg_id=%d", event->msg_id);
 
 			xEventGroupSetBits(mqtt->event_group, MQTT_EVENT_SUBSCRIBED_BIT);
 
 			break;
 
 		case MQTT_EVENT_UNSUBSCRIBED:
-			ESP_LOGI(TAG, "MQTT_EVENT_UNSUBSCRIBED, msg_id=%d", event->msg_id);
+			BITEC_TRACE(TAG, TRACE_MQTT_UNSUBSCRIBED, event->msg_id, 0, "MQTT_EVENT_UNSUBSCRIBED, msg_id=%d", event->msg_id);
 
 			xEventGroupSetBits(mqtt->event_group, MQTT_EVENT_UNSUBSCRIBED_BIT);
 
 			break;
 
 		case MQTT_EVENT_PUBLISHED:
-			ESP_LOGI(TAG, "MQTT_EVENT_PUBLISHED, msg_id=%d", event->msg_id);
+			BITEC_TRACE(TAG, TRACE_MQTT_PUBLISHED, event->msg_id, 0, "MQTT_EVENT_PUBLISHED, msg_id=%d", event->msg_id);
+
+#ifdef CONFIG_BITEC_LATENCY_ENABLE
+			/* The event is only valid during this call, the acknowledge is taken here */
+			if(mqtt->latency != NULL)
+				bitec_latency_ack(mqtt->latency, event->msg_id);
+#endif
 
 			xEventGroupSetBits(mqtt->event_group, MQTT_EVENT_PUBLISHED_BIT);
 
 			break;
 
 		case MQTT_EVENT_DATA:
-			ESP_LOGI(TAG, "MQTT_EVENT_DATA");
-
 			/* Print MQTT incoming messages */
-			ESP_LOGI(TAG, "topic=%.*s\r", event->topic_len, event->topic);
-			ESP_LOGI(TAG, "data=%.*s\r\n", event->data_len, event->data);
+			BITEC_TRACE(TAG, TRACE_MQTT_DATA, event->topic_len, event->data_len, "MQTT_EVENT_DATA, topic=%.*s, data=%.*s",
+					event->topic_len, event->topic, event->data_len, event->data);
 
-			xEventGroupSetBits(mqtt->event_group, MQTT_EVENT_DATA_BIT);
+			message_queue(mqtt, event);
 
 			break;
 
 		case MQTT_EVENT_ERROR:
-			ESP_LOGI(TAG, "MQTT_EVENT_ERROR");
+			BITEC_TRACE(TAG, TRACE_MQTT_ERROR, 0, 0, "MQTT_EVENT_ERROR");
 
 			xEventGroupSetBits(mqtt->event_group, MQTT_EVENT_ERROR_BIT);
 
 			break;
 
 		default:
-			ESP_LOGI(TAG, "Other event id:%d", event->event_id);
+			BITEC_TRACE(TAG, TRACE_MQTT_OTHER, event->event_id, 0, "Other event id:%d", event->event_id);
 
 			break;
 	}
 }
 
+/* Copy an incoming message to the queue and tell the receiver */
+static void message_queue(bitec_mqtt_t * const me, esp_mqtt_event_handle_t event)
+{
+	bitec_mqtt_message_t message;
+
+	/* Messages longer than the client buffer come in chunks, none is expected */
+	if(event->data_len != event->total_data_len)
+	{
+		ESP_LOGW(TAG, "Message of %d bytes dropped, longer than the buffer", event->total_data_len);
+		return;
+	}
+
+	message.topic = malloc(event->topic_len + event->data_len + 2);
+
+	if(message.topic == NULL)
+	{
+		ESP_LOGW(TAG, "Message dropped, no memory");
+		return;
+	}
+
+	memcpy(message.topic, event->topic, event->topic_len);
+	message.topic[event->topic_len] = '\0';
+	message.data = message.topic + event->topic_len + 1;
+	memcpy(message.data, event->data, event->data_len);
+	message.data[event->data_len] = '\0';
+	message.data_len = event->data_len;
+
+	if(xQueueSend(me->queue, &message, 0) != pdTRUE)
+	{
+		ESP_LOGW(TAG, "Message on %s dropped, queue full", message.topic);
+		bitec_mqtt_message_free(&message);
+		return;
+	}
+
+	xEventGroupSetBits(me->event_group, MQTT_EVENT_DATA_BIT);
+}
+
 /* end of file ---------------------------------------------------------------*/
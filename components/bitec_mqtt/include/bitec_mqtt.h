@@ -14,8 +14,10 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
+#include "freertos/queue.h"
 
 #include "mqtt_client.h"
+#include "bitec_latency.h"
 
 /* cplusplus -----------------------------------------------------------------*/
 
@@ -34,17 +36,40 @@ extern "C" {
 #define MQTT_EVENT_DATA_BIT			BIT5
 #define MQTT_EVENT_ERROR_BIT		BIT6
 
+#ifdef CONFIG_BITEC_MQTT_QUEUE_LENGTH
+#define MQTT_QUEUE_LENGTH			CONFIG_BITEC_MQTT_QUEUE_LENGTH
+#else
+#define MQTT_QUEUE_LENGTH			8
+#endif
+
+#define MQTT_LWT_TOPIC_SIZE			128		/*!< LWT topic with the device id in bytes */
+
 /* typedef -------------------------------------------------------------------*/
 
 typedef void (* mqtt_event_handler_t)(void *, esp_event_base_t, int32_t, void *);
 
+/* Incoming message, a copy owned by the receiver until bitec_mqtt_message_free() */
+typedef struct
+{
+	char * topic;						/*!< Null terminated */
+	char * data;						/*!< Null terminated after its data_len bytes */
+	int data_len;
+} bitec_mqtt_message_t;
+
 typedef struct
 {
 	esp_mqtt_client_handle_t client;	/*!< MQTT client handle */
 	esp_mqtt_client_config_t config;	/*!< MQTT configuration */
 	mqtt_event_handler_t event_handler;	/*!< MQTT pointer to event handler function */
-	esp_mqtt_event_handle_t event_data;	/*!< todo: set description */
 	EventGroupHandle_t event_group;		/*!< todo: set description */
+	QueueHandle_t queue;				/*!< Incoming messages, MQTT_EVENT_DATA_BIT is set once one is queued */
+	const char * device;				/*!< Device id the LWT topic ends with, the configured one if NULL */
+#ifdef CONFIG_BITEC_MQTT_LWT_ENABLE
+	char lwt_topic[MQTT_LWT_TOPIC_SIZE];
+#endif
+#ifdef CONFIG_BITEC_LATENCY_ENABLE
+	bitec_latency_t * latency;			/*!< Probes taking the publish acknowledges, NULL for none */
+#endif
 } bitec_mqtt_t;
 
 /* external data declaration -------------------------------------------------*/
@@ -64,6 +89,8 @@ extern const uint8_t client_key_pem_end[] asm("_binary_private_pem_key_end");
 /* external functions declaration --------------------------------------------*/
 
 esp_err_t bitec_mqtt_init(bitec_mqtt_t * const me);
+bool bitec_mqtt_receive(bitec_mqtt_t * const me, bitec_mqtt_message_t * const message);
+void bitec_mqtt_message_free(bitec_mqtt_message_t * const message);
 
 /* cplusplus -----------------------------------------------------------------*/
 
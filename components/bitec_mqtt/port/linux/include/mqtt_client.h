@@ -0,0 +1,119 @@
+/*
+ * mqtt_client.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ *
+ * Loopback stand-in of the ESP-MQTT client for host builds. It keeps the
+ * subset of the ESP-MQTT API used by the firmware: messages published to a
+ * subscribed topic are delivered back as MQTT_EVENT_DATA and QoS 1/2
+ * publishes are acknowledged with MQTT_EVENT_PUBLISHED, at once or when the
+ * test tells so.
+ */
+
+#ifndef _MQTT_CLIENT_H_
+#define _MQTT_CLIENT_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "esp_event.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef struct esp_mqtt_client * esp_mqtt_client_handle_t;
+
+typedef enum
+{
+	MQTT_EVENT_ANY = -1,
+	MQTT_EVENT_ERROR = 0,
+	MQTT_EVENT_CONNECTED,
+	MQTT_EVENT_DISCONNECTED,
+	MQTT_EVENT_SUBSCRIBED,
+	MQTT_EVENT_UNSUBSCRIBED,
+	MQTT_EVENT_PUBLISHED,
+	MQTT_EVENT_DATA,
+	MQTT_EVENT_BEFORE_CONNECT
+} esp_mqtt_event_id_t;
+
+typedef struct
+{
+	esp_mqtt_event_id_t event_id;
+	esp_mqtt_client_handle_t client;
+	void * user_context;
+	char * data;
+	int data_len;
+	int total_data_len;
+	int current_data_offset;
+	char * topic;
+	int topic_len;
+	int msg_id;
+	int session_present;
+	int qos;
+	int retain;
+} esp_mqtt_event_t;
+
+typedef esp_mqtt_event_t * esp_mqtt_event_handle_t;
+
+typedef struct
+{
+	const char * uri;
+	const char * client_cert_pem;
+	const char * client_key_pem;
+	const char * cert_pem;
+	const char * lwt_topic;
+	const char * lwt_msg;
+	int lwt_qos;
+	int lwt_retain;
+	int lwt_msg_len;
+	void * user_context;
+} esp_mqtt_client_config_t;
+
+/* Called for every message published by any client, as the broker would see it */
+typedef void (* esp_mqtt_loopback_sink_t)(esp_mqtt_client_handle_t client, int msg_id, const char * topic, const char * data, int len, int qos, void * arg);
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t * config);
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event, esp_event_handler_t event_handler, void * event_handler_arg);
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client);
+esp_err_t esp_mqtt_client_stop(esp_mqtt_client_handle_t client);
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char * topic, const char * data, int len, int qos, int retain);
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t client, const char * topic, int qos);
+int esp_mqtt_client_unsubscribe(esp_mqtt_client_handle_t client, const char * topic);
+esp_err_t esp_mqtt_client_destroy(esp_mqtt_client_handle_t client);
+
+/* Loopback control, shared by every client */
+void esp_mqtt_loopback_set_sink(esp_mqtt_loopback_sink_t sink, void * arg);
+
+/* When manual, QoS 1/2 publishes wait for esp_mqtt_loopback_ack() instead of being acknowledged at once */
+void esp_mqtt_loopback_set_manual_ack(bool manual);
+esp_err_t esp_mqtt_loopback_ack(esp_mqtt_client_handle_t client, int msg_id);
+
+/* Deliver a message to a client, or to every client when NULL, if it is subscribed to the topic */
+esp_err_t esp_mqtt_loopback_deliver(esp_mqtt_client_handle_t client, const char * topic, const char * data, int len);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _MQTT_CLIENT_H_ */
@@ -0,0 +1,332 @@
+/*
+ * mqtt_client_loopback.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mqtt_client.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define SUBSCRIPTIONS_MAX	8		/*!< Maximum number of subscribed topics */
+#define TOPIC_SIZE			128		/*!< Maximum topic filter size in bytes */
+#define BUFFER_SIZE			1024	/*!< Receive buffer, ESP-MQTT default buffer size */
+
+/* typedef -------------------------------------------------------------------*/
+
+struct esp_mqtt_client
+{
+	esp_mqtt_client_config_t config;
+	esp_event_handler_t event_handler;
+	void * event_handler_arg;
+	bool connected;
+	int msg_id;
+	char subscriptions[SUBSCRIPTIONS_MAX][TOPIC_SIZE];
+	esp_mqtt_event_t event;
+	char buffer[BUFFER_SIZE];		/*!< Topic and data of the last received message */
+	struct esp_mqtt_client * next;
+};
+
+/* internal data declaration -------------------------------------------------*/
+
+static esp_mqtt_client_handle_t clients = NULL;
+static esp_mqtt_loopback_sink_t sink = NULL;
+static void * sink_arg = NULL;
+static bool manual_ack = false;
+
+/* external data declaration -------------------------------------------------*/
+
+/* The loopback has no TLS, empty certificates stand in for the ones the firmware project embeds */
+const uint8_t server_cert_pem_start[] asm("_binary_ca_pem_start") = "";
+const uint8_t server_cert_pem_end[] asm("_binary_ca_pem_end") = "";
+const uint8_t client_cert_pem_start[] asm("_binary_certificate_pem_crt_start") = "";
+const uint8_t client_cert_pem_end[] asm("_binary_certificate_pem_crt_end") = "";
+const uint8_t client_key_pem_start[] asm("_binary_private_pem_key_start") = "";
+const uint8_t client_key_pem_end[] asm("_binary_private_pem_key_end") = "";
+
+/* internal functions declaration --------------------------------------------*/
+
+static void dispatch(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event_id, int msg_id, const char * topic, const char * data, int len);
+static bool topic_matches(const char * filter, const char * topic);
+static int next_msg_id(esp_mqtt_client_handle_t client);
+static void deliver(esp_mqtt_client_handle_t client, const char * topic, const char * data, int len);
+
+/* external functions definition ---------------------------------------------*/
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t * config)
+{
+	esp_mqtt_client_handle_t client = calloc(1, sizeof(struct esp_mqtt_client));
+
+	if(client == NULL)
+		return NULL;
+
+	if(config != NULL)
+		client->config = * config;
+
+	client->next = clients;
+	clients = client;
+
+	return client;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event, esp_event_handler_t event_handler, void * event_handler_arg)
+{
+	if(client == NULL)
+		return ESP_ERR_INVALID_ARG;
+
+	/* Only MQTT_EVENT_ANY registrations are used by the firmware */
+	client->event_handler = event_handler;
+	client->event_handler_arg = event_handler_arg;
+
+	return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client)
+{
+	if(client == NULL)
+		return ESP_ERR_INVALID_ARG;
+
+	client->connected = true;
+	dispatch(client, MQTT_EVENT_CONNECTED, 0, NULL, NULL, 0);
+
+	return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_stop(esp_mqtt_client_handle_t client)
+{
+	if(client == NULL)
+		return ESP_ERR_INVALID_ARG;
+
+	if(client->connected)
+	{
+		client->connected = false;
+		dispatch(client, MQTT_EVENT_DISCONNECTED, 0, NULL, NULL, 0);
+	}
+
+	return ESP_OK;
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char * topic, const char * data, int len, int qos, int retain)
+{
+	if(client == NULL || topic == NULL || !client->connected)
+		return -1;
+
+	if(len <= 0)
+		len = data != NULL ? strlen(data) : 0;
+
+	/* QoS 0 messages have no id, as in ESP-MQTT */
+	int msg_id = qos > 0 ? next_msg_id(client) : 0;
+
+	if(sink != NULL)
+		sink(client, msg_id, topic, data, len, qos, sink_arg);
+
+	if(qos > 0 && !manual_ack)
+		dispatch(client, MQTT_EVENT_PUBLISHED, msg_id, NULL, NULL, 0);
+
+	deliver(client, topic, data, len);
+
+	return msg_id;
+}
+
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t client, const char * topic, int qos)
+{
+	if(client == NULL || topic == NULL || !client->connected || strlen(topic) >= TOPIC_SIZE)
+		return -1;
+
+	for(uint8_t i = 0; i < SUBSCRIPTIONS_MAX; i++)
+	{
+		if(client->subscriptions[i][0] == '\0' || !strcmp(client->subscriptions[i], topic))
+		{
+			strcpy(client->subscriptions[i], topic);
+
+			int msg_id = next_msg_id(client);
+			dispatch(client, MQTT_EVENT_SUBSCRIBED, msg_id, NULL, NULL, 0);
+
+			return msg_id;
+		}
+	}
+
+	return -1;
+}
+
+int esp_mqtt_client_unsubscribe(esp_mqtt_client_handle_t client, const char * topic)
+{
+	if(client == NULL || topic == NULL || !client->connected)
+		return -1;
+
+	for(uint8_t i = 0; i < SUBSCRIPTIONS_MAX; i++)
+	{
+		if(!strcmp(client->subscriptions[i], topic))
+		{
+			client->subscriptions[i][0] = '\0';
+
+			int msg_id = next_msg_id(client);
+			dispatch(client, MQTT_EVENT_UNSUBSCRIBED, msg_id, NULL, NULL, 0);
+
+			return msg_id;
+		}
+	}
+
+	return -1;
+}
+
+esp_err_t esp_mqtt_client_destroy(esp_mqtt_client_handle_t client)
+{
+	if(client == NULL)
+		return ESP_ERR_INVALID_ARG;
+
+	for(esp_mqtt_client_handle_t * c = &clients; * c != NULL; c = &(* c)->next)
+	{
+		if(* c == client)
+		{
+			* c = client->next;
+			break;
+		}
+	}
+
+	free(client);
+
+	return ESP_OK;
+}
+
+void esp_mqtt_loopback_set_sink(esp_mqtt_loopback_sink_t new_sink, void * arg)
+{
+	sink = new_sink;
+	sink_arg = arg;
+}
+
+void esp_mqtt_loopback_set_manual_ack(bool manual)
+{
+	manual_ack = manual;
+}
+
+esp_err_t esp_mqtt_loopback_ack(esp_mqtt_client_handle_t client, int msg_id)
+{
+	if(client == NULL || msg_id <= 0)
+		return ESP_ERR_INVALID_ARG;
+
+	/* Acknowledges of a previous connection are lost, as on a real broker without session */
+	if(!client->connected)
+		return ESP_ERR_INVALID_STATE;
+
+	dispatch(client, MQTT_EVENT_PUBLISHED, msg_id, NULL, NULL, 0);
+
+	return ESP_OK;
+}
+
+esp_err_t esp_mqtt_loopback_deliver(esp_mqtt_client_handle_t client, const char * topic, const char * data, int len)
+{
+	if(topic == NULL)
+		return ESP_ERR_INVALID_ARG;
+
+	if(client != NULL)
+	{
+		if(!client->connected)
+			return ESP_ERR_INVALID_STATE;
+
+		deliver(client, topic, data, len);
+
+		return ESP_OK;
+	}
+
+	for(esp_mqtt_client_handle_t c = clients; c != NULL; c = c->next)
+	{
+		if(c->connected)
+			deliver(c, topic, data, len);
+	}
+
+	return ESP_OK;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static void dispatch(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event_id, int msg_id, const char * topic, const char * data, int len)
+{
+	if(client->event_handler == NULL)
+		return;
+
+	/* The event is reused as ESP-MQTT does, it is only valid during the handler call */
+	memset(&client->event, 0, sizeof(esp_mqtt_event_t));
+	client->event.event_id = event_id;
+	client->event.client = client;
+	client->event.user_context = client->config.user_context;
+	client->event.msg_id = msg_id;
+	client->event.topic = (char *)topic;
+	client->event.topic_len = topic != NULL ? strlen(topic) : 0;
+	client->event.data = (char *)data;
+	client->event.data_len = len;
+	client->event.total_data_len = len;
+
+	client->event_handler(client->event_handler_arg, "MQTT_EVENTS", event_id, &client->event);
+}
+
+static bool topic_matches(const char * filter, const char * topic)
+{
+	while(* filter != '\0')
+	{
+		if(* filter == '#')
+			return true;
+
+		if(* filter == '+')
+		{
+			/* Single level wildcard */
+			while(* topic != '\0' && * topic != '/')
+				topic++;
+
+			filter++;
+			continue;
+		}
+
+		if(* filter != * topic)
+			return false;
+
+		filter++;
+		topic++;
+	}
+
+	return * topic == '\0';
+}
+
+static int next_msg_id(esp_mqtt_client_handle_t client)
+{
+	/* Message ids are 16 bit and never 0 */
+	client->msg_id = (client->msg_id % 0xFFFF) + 1;
+
+	return client->msg_id;
+}
+
+static void deliver(esp_mqtt_client_handle_t client, const char * topic, const char * data, int len)
+{
+	if(len <= 0)
+		len = data != NULL ? strlen(data) : 0;
+
+	size_t topic_len = strlen(topic);
+
+	if(topic_len + len + 2 > BUFFER_SIZE)
+		return;
+
+	for(uint8_t i = 0; i < SUBSCRIPTIONS_MAX; i++)
+	{
+		if(client->subscriptions[i][0] != '\0' && topic_matches(client->subscriptions[i], topic))
+		{
+			/* Like ESP-MQTT the event points to the client buffer, valid until the next message */
+			char * buffer_topic = client->buffer;
+			char * buffer_data = client->buffer + topic_len + 1;
+
+			memcpy(buffer_topic, topic, topic_len + 1);
+			memcpy(buffer_data, data, len);
+			buffer_data[len] = '\0';
+
+			dispatch(client, MQTT_EVENT_DATA, 0, buffer_topic, buffer_data, len);
+			break;
+		}
+	}
+}
+
+/* end of file ---------------------------------------------------------------*/
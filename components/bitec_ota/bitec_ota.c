@@ -0,0 +1,430 @@
+/*
+ * bitec_ota.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "include/bitec_ota.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_http_client.h"
+
+#ifndef CONFIG_IDF_TARGET_LINUX
+#include "esp_crt_bundle.h"
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#define RANGE_SIZE			32			/*!< Range header value size in bytes */
+#define HEADERS_SIZE		1024		/*!< HTTP client buffer, the response headers must fit in it */
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static const char * TAG = "bitec_ota";
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static esp_err_t update(bitec_ota_t * const me, const char * url, bool delta);
+static esp_err_t download(bitec_ota_t * const me, const char * url, uint8_t * buf, size_t heap_start);
+static esp_err_t transfer(bitec_ota_t * const me, esp_http_client_handle_t client, uint8_t * buf, size_t heap_start,
+		bool * resume);
+static esp_err_t image_begin(bitec_ota_t * const me, uint32_t size);
+static esp_err_t image_write(bitec_ota_t * const me, const uint8_t * data, size_t size);
+static esp_err_t delta_read(uint32_t offset, void * data, size_t size, void * arg);
+static esp_err_t delta_write(const uint8_t * data, size_t size, void * arg);
+static void self_test_timer(void * arg);
+static uint32_t now_ms(void);
+
+/* external functions definition ---------------------------------------------*/
+
+esp_err_t bitec_ota_init(bitec_ota_t * const me)
+{
+	me->chunk_size = CONFIG_BITEC_OTA_CHUNK_SIZE;
+	me->retries = CONFIG_BITEC_OTA_RETRIES;
+	me->retry_time = CONFIG_BITEC_OTA_RETRY_TIME;
+	me->timeout = CONFIG_BITEC_OTA_TIMEOUT;
+	me->self_test_time = CONFIG_BITEC_OTA_SELF_TEST_TIME;
+#ifdef CONFIG_BITEC_OTA_SIGNED
+	me->sign = true;
+#else
+	me->sign = false;
+#endif
+	me->digest = NULL;
+	me->progress = NULL;
+	me->arg = NULL;
+
+	me->state = BITEC_OTA_IDLE;
+	me->delta = NULL;
+	me->handle = 0;
+	me->size = 0;
+	me->offset = 0;
+	me->updates = 0;
+	me->failures = 0;
+	me->error = ESP_OK;
+	me->resumes = 0;
+	me->time = 0;
+	me->throughput = 0;
+	me->heap = 0;
+	me->pending = hal_ota_pending();
+
+	if(!me->pending)
+		return ESP_OK;
+
+	ESP_LOGW(TAG, "New image, rolled back unless its self test passes in %" PRIu32 " ms", me->self_test_time);
+
+	esp_err_t ret = hal_timer_create(self_test_timer, (void *)me, &me->timer);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	return hal_timer_start(me->timer, (uint64_t)me->self_test_time * 1000);
+}
+
+esp_err_t bitec_ota_update(bitec_ota_t * const me, const char * url)
+{
+	return update(me, url, false);
+}
+
+esp_err_t bitec_ota_update_delta(bitec_ota_t * const me, const char * url)
+{
+	return update(me, url, true);
+}
+
+void bitec_ota_self_test(bitec_ota_t * const me, bool passed)
+{
+	if(!me->pending)
+		return;
+
+	hal_timer_stop(me->timer);
+
+	if(passed)
+	{
+		ESP_LOGI(TAG, "Self test passed, keeping the new image");
+
+		if(hal_ota_mark_valid() == ESP_OK)
+			me->pending = false;
+
+		return;
+	}
+
+	ESP_LOGE(TAG, "Self test failed, rolling back");
+	hal_ota_rollback();
+}
+
+int bitec_ota_print(const bitec_ota_t * const me, char * buf, size_t size)
+{
+	int len = snprintf(buf, size, "{\"state\":%d,\"pending\":%d,\"updates\":%" PRIu32 ",\"failures\":%" PRIu32 ",\"error\":%d,\"resumes\":%" PRIu32
+			",\"size\":%" PRIu32 ",\"download\":%" PRIu32 ",\"time\":%" PRIu32 ",\"throughput\":%" PRIu32 ",\"heap\":%u}",
+			me->state, me->pending, me->updates, me->failures, me->error, me->resumes, me->image.size, me->size, me->time, me->throughput, (unsigned)me->heap);
+
+	if(len < 0 || (size_t)len >= size)
+		return -1;
+
+	return len;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static esp_err_t update(bitec_ota_t * const me, const char * url, bool delta)
+{
+	esp_err_t ret;
+
+	if(me->state == BITEC_OTA_DOWNLOADING)
+		return ESP_ERR_INVALID_STATE;
+
+	ESP_LOGI(TAG, "Updating from %s%s", url, delta ? ", a patch of the running image" : "");
+
+	me->state = BITEC_OTA_DOWNLOADING;
+	memset(&me->image, 0, sizeof(bitec_ota_image_t));
+	me->handle = 0;
+	me->size = 0;
+	me->offset = 0;
+	me->resumes = 0;
+	me->throughput = 0;
+	me->heap = 0;
+
+	size_t heap_start = hal_heap_used();
+	uint32_t start = now_ms();
+
+	/* The image streams through this buffer to flash, it is never held whole. A patch takes one more
+	 * for the new image and the window of its decoder */
+	uint8_t * buf = malloc(me->chunk_size);
+	uint8_t * out = delta ? malloc(me->chunk_size) : NULL;
+	me->delta = delta ? malloc(sizeof(bitec_ota_delta_t)) : NULL;
+
+	if(buf == NULL || (delta && (out == NULL || me->delta == NULL)))
+		ret = ESP_ERR_NO_MEM;
+	else
+	{
+		if(delta)
+			bitec_ota_delta_init(me->delta, out, me->chunk_size, delta_read, delta_write, (void *)me);
+
+		ret = download(me, url, buf, heap_start);
+	}
+
+	free(buf);
+	free(out);
+	free(me->delta);
+	me->delta = NULL;
+
+	me->time = now_ms() - start;
+	me->error = ret;
+
+	if(ret != ESP_OK)
+	{
+		me->failures++;
+		me->state = BITEC_OTA_FAILED;
+		ESP_LOGE(TAG, "Update failed after %" PRIu32 " ms: %s", me->time, esp_err_to_name(ret));
+
+		return ret;
+	}
+
+	me->updates++;
+	me->state = BITEC_OTA_READY;
+
+	if(me->time > 0)
+		me->throughput = (uint32_t)((uint64_t)me->image.size * 1000 / me->time);
+
+	ESP_LOGI(TAG, "Version %s ready, %" PRIu32 " bytes from %" PRIu32 " downloaded in %" PRIu32 " ms, %u bytes of heap",
+			me->image.version, me->image.size, me->size, me->time, (unsigned)me->heap);
+
+	return ESP_OK;
+}
+
+static esp_err_t download(bitec_ota_t * const me, const char * url, uint8_t * buf, size_t heap_start)
+{
+	esp_err_t ret;
+	bool resume;
+	uint32_t attempts = 0;
+
+	esp_http_client_config_t config =
+	{
+		.url = url,
+		.timeout_ms = me->timeout,
+		.buffer_size = HEADERS_SIZE,
+#ifndef CONFIG_IDF_TARGET_LINUX
+		.crt_bundle_attach = esp_crt_bundle_attach,
+#endif
+	};
+
+	esp_http_client_handle_t client = esp_http_client_init(&config);
+
+	if(client == NULL)
+		return ESP_ERR_INVALID_ARG;
+
+	for(;;)
+	{
+		uint32_t offset = me->offset;
+
+		ret = transfer(me, client, buf, heap_start, &resume);
+		esp_http_client_close(client);
+
+		if(ret == ESP_OK || !resume)
+			break;
+
+		/* Give up after retries connections in a row without progress */
+		if(me->offset > offset)
+			attempts = 0;
+
+		if(++attempts > me->retries)
+			break;
+
+		me->resumes++;
+		ESP_LOGW(TAG, "Connection lost at %" PRIu32 " of %" PRIu32 " bytes, resuming", me->offset, me->size);
+
+		if(me->retry_time > 0)
+			vTaskDelay(pdMS_TO_TICKS(me->retry_time));
+	}
+
+	esp_http_client_cleanup(client);
+
+	if(ret == ESP_OK && me->delta != NULL)
+		ret = bitec_ota_delta_finish(me->delta);
+
+	if(ret == ESP_OK)
+		ret = bitec_ota_image_finish(&me->image);
+
+	if(ret == ESP_OK && me->digest != NULL && memcmp(me->image.digest, me->digest, OTA_IMAGE_DIGEST_SIZE))
+		ret = ESP_ERR_INVALID_CRC;
+
+	if(ret == ESP_OK && me->sign)
+		ret = hal_ota_verify_signature(me->image.block, me->image.digest);
+
+	if(ret == ESP_OK)
+		return hal_ota_end(me->handle);
+
+	if(me->handle != 0)
+		hal_ota_abort(me->handle);
+
+	return ret;
+}
+
+/* One connection, from the first byte not downloaded yet. Sets resume if a new connection can go on */
+static esp_err_t transfer(bitec_ota_t * const me, esp_http_client_handle_t client, uint8_t * buf, size_t heap_start,
+		bool * resume)
+{
+	esp_err_t ret;
+	uint32_t offset = me->offset;
+	uint32_t skip = 0;
+
+	* resume = true;
+
+	if(offset > 0)
+	{
+		char range[RANGE_SIZE];
+		snprintf(range, sizeof(range), "bytes=%" PRIu32 "-", offset);
+		esp_http_client_set_header(client, "Range", range);
+	}
+
+	if(esp_http_client_open(client, 0) != ESP_OK)
+		return ESP_FAIL;
+
+	int length = esp_http_client_fetch_headers(client);
+	int status = esp_http_client_get_status_code(client);
+
+	/* A busy server turns connections away, they are tried again as dropped ones */
+	if(length < 0 || status >= 500 || status == 429)
+		return ESP_FAIL;
+
+	* resume = false;
+
+	if(status == 206 && offset > 0)
+	{
+		if((uint32_t)length != me->size - offset)
+			return ESP_ERR_INVALID_SIZE;
+	}
+	else if(status == 200 && me->size == 0)
+	{
+		/* The size is needed to check the download, chunked responses are refused */
+		if(length == 0)
+			return ESP_ERR_INVALID_SIZE;
+
+		me->size = length;
+
+		/* A patch opens the partition once its header tells the size of the new image */
+		if(me->delta == NULL)
+		{
+			ret = image_begin(me, length);
+
+			if(ret != ESP_OK)
+				return ret;
+		}
+	}
+	else if(status == 200)
+	{
+		/* The server ignored the range, the bytes already downloaded are dropped */
+		if((uint32_t)length != me->size)
+			return ESP_ERR_INVALID_SIZE;
+
+		skip = offset;
+	}
+	else
+		return status == 404 ? ESP_ERR_NOT_FOUND : ESP_ERR_INVALID_RESPONSE;
+
+	while(me->offset < me->size)
+	{
+		int n = esp_http_client_read(client, (char *)buf, me->chunk_size);
+
+		if(n <= 0)
+		{
+			* resume = true;
+			return ESP_FAIL;
+		}
+
+		uint8_t * data = buf;
+
+		if(skip > 0)
+		{
+			uint32_t drop = skip < (uint32_t)n ? skip : (uint32_t)n;
+			skip -= drop;
+			data += drop;
+			n -= drop;
+		}
+
+		if(me->delta != NULL)
+			ret = bitec_ota_delta_feed(me->delta, data, n);
+		else
+			ret = image_write(me, data, n);
+
+		if(ret != ESP_OK)
+			return ret;
+
+		me->offset += n;
+
+		if(me->progress != NULL)
+			me->progress(me->offset, me->size, me->arg);
+
+		size_t heap = hal_heap_used();
+
+		if(heap > heap_start && heap - heap_start > me->heap)
+			me->heap = heap - heap_start;
+	}
+
+	return ESP_OK;
+}
+
+static esp_err_t image_begin(bitec_ota_t * const me, uint32_t size)
+{
+	esp_err_t ret = bitec_ota_image_init(&me->image, size, me->sign);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	return hal_ota_begin(size, &me->handle);
+}
+
+static esp_err_t image_write(bitec_ota_t * const me, const uint8_t * data, size_t size)
+{
+	/* Checked before it is written, a wrong image stops on its first chunk */
+	esp_err_t ret = bitec_ota_image_feed(&me->image, data, size);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	return hal_ota_write(me->handle, data, size);
+}
+
+static esp_err_t delta_read(uint32_t offset, void * data, size_t size, void * arg)
+{
+	return hal_ota_read_running(offset, data, size);
+}
+
+static esp_err_t delta_write(const uint8_t * data, size_t size, void * arg)
+{
+	bitec_ota_t * me = (bitec_ota_t *)arg;
+
+	if(me->handle == 0)
+	{
+		esp_err_t ret = image_begin(me, me->delta->new_size);
+
+		if(ret != ESP_OK)
+			return ret;
+	}
+
+	return image_write(me, data, size);
+}
+
+static void self_test_timer(void * arg)
+{
+	bitec_ota_self_test((bitec_ota_t *)arg, false);
+}
+
+static uint32_t now_ms(void)
+{
+	return (uint32_t)(hal_time_us() / 1000);
+}
+
+/* end of file ---------------------------------------------------------------*/
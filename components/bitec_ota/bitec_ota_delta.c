@@ -0,0 +1,388 @@
+/*
+ * bitec_ota_delta.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "include/bitec_ota_delta.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define HEADER_VERSION			4
+#define HEADER_WINDOW_BITS		5
+#define HEADER_OLD_SIZE			8
+#define HEADER_NEW_SIZE			12
+#define HEADER_OLD_DIGEST		16			/*!< SHA-256 of the whole old image */
+#define HEADER_NEW_DIGEST		48			/*!< SHA-256 of the whole new image */
+
+#define WINDOW_MASK				(OTA_DELTA_WINDOW_SIZE - 1)
+#define MATCH_LONG				15			/*!< Length code followed by a varint */
+#define VARINT_SHIFT_MAX		28			/*!< Varints are 32 bits at most */
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static esp_err_t header_check(bitec_ota_delta_t * const me);
+static esp_err_t copy(bitec_ota_delta_t * const me, uint32_t length);
+static esp_err_t emit(bitec_ota_delta_t * const me, uint8_t byte);
+static esp_err_t put(bitec_ota_delta_t * const me, uint8_t byte);
+static void record_start(bitec_ota_delta_t * const me);
+static void record_end(bitec_ota_delta_t * const me);
+static esp_err_t flush(bitec_ota_delta_t * const me);
+static void next_item(bitec_ota_delta_t * const me);
+static uint32_t load_le32(const uint8_t * p);
+
+/* external functions definition ---------------------------------------------*/
+
+void bitec_ota_delta_init(bitec_ota_delta_t * const me, uint8_t * out, size_t out_size, bitec_ota_delta_read_t read,
+		bitec_ota_delta_write_t write, void * arg)
+{
+	memset(me, 0, sizeof(bitec_ota_delta_t));
+
+	me->out = out;
+	me->out_size = out_size;
+	me->read = read;
+	me->write = write;
+	me->arg = arg;
+	me->lz = OTA_DELTA_LZ_FLAGS;
+	me->record = OTA_DELTA_ADD_SIZE;
+	bitec_ota_sha256_init(&me->sha);
+}
+
+esp_err_t bitec_ota_delta_feed(bitec_ota_delta_t * const me, const uint8_t * data, size_t len)
+{
+	esp_err_t ret = ESP_OK;
+
+	for(size_t i = 0; i < len && ret == ESP_OK; i++)
+	{
+		uint8_t byte = data[i];
+
+		if(me->offset < OTA_DELTA_HEADER_SIZE)
+		{
+			me->header[me->offset++] = byte;
+
+			if(me->offset == OTA_DELTA_HEADER_SIZE)
+				ret = header_check(me);
+
+			continue;
+		}
+
+		me->offset++;
+
+		switch(me->lz)
+		{
+			case OTA_DELTA_LZ_FLAGS:
+				me->flags = byte;
+				me->items = 8;
+				me->lz = OTA_DELTA_LZ_ITEM;
+				break;
+
+			case OTA_DELTA_LZ_ITEM:
+				if(me->flags & 1)
+				{
+					me->distance = byte;
+					me->lz = OTA_DELTA_LZ_MATCH;
+				}
+				else
+				{
+					ret = emit(me, byte);
+					next_item(me);
+				}
+				break;
+
+			case OTA_DELTA_LZ_MATCH:
+				me->distance = (me->distance | (byte & 0xF0) << 4) + 1;
+
+				if((byte & 0x0F) == MATCH_LONG)
+				{
+					me->length = 0;
+					me->shift = 0;
+					me->lz = OTA_DELTA_LZ_LENGTH;
+				}
+				else
+				{
+					ret = copy(me, (byte & 0x0F) + OTA_DELTA_MATCH_MIN);
+					next_item(me);
+				}
+				break;
+
+			case OTA_DELTA_LZ_LENGTH:
+				me->length |= (uint32_t)(byte & 0x7F) << me->shift;
+
+				if(byte & 0x80)
+				{
+					me->shift += 7;
+
+					if(me->shift > VARINT_SHIFT_MAX)
+						ret = ESP_ERR_INVALID_RESPONSE;
+				}
+				else
+				{
+					ret = copy(me, me->length + MATCH_LONG + OTA_DELTA_MATCH_MIN);
+					next_item(me);
+				}
+				break;
+		}
+	}
+
+	return ret;
+}
+
+esp_err_t bitec_ota_delta_finish(bitec_ota_delta_t * const me)
+{
+	uint8_t digest[OTA_IMAGE_DIGEST_SIZE];
+
+	/* A patch cut on a record or a match boundary is caught by the new image size */
+	if(me->offset < OTA_DELTA_HEADER_SIZE || me->lz == OTA_DELTA_LZ_MATCH || me->lz == OTA_DELTA_LZ_LENGTH ||
+			me->record != OTA_DELTA_ADD_SIZE || me->left > 0)
+		return ESP_ERR_INVALID_SIZE;
+
+	esp_err_t ret = flush(me);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	if(me->written != me->new_size)
+		return ESP_ERR_INVALID_SIZE;
+
+	bitec_ota_sha256_finish(&me->sha, digest);
+
+	if(memcmp(digest, me->header + HEADER_NEW_DIGEST, sizeof(digest)))
+		return ESP_ERR_INVALID_CRC;
+
+	return ESP_OK;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static esp_err_t header_check(bitec_ota_delta_t * const me)
+{
+	uint8_t digest[OTA_IMAGE_DIGEST_SIZE];
+	bitec_ota_sha256_t sha;
+
+	if(memcmp(me->header, OTA_DELTA_MAGIC, 4) || me->header[HEADER_VERSION] != OTA_DELTA_VERSION ||
+			me->header[HEADER_WINDOW_BITS] != OTA_DELTA_WINDOW_BITS)
+		return ESP_ERR_INVALID_RESPONSE;
+
+	me->old_size = load_le32(me->header + HEADER_OLD_SIZE);
+	me->new_size = load_le32(me->header + HEADER_NEW_SIZE);
+	me->left = me->new_size;
+
+	if(me->new_size == 0)
+		return ESP_ERR_INVALID_RESPONSE;
+
+	/* The old image is read again through out, before anything is written */
+	bitec_ota_sha256_init(&sha);
+
+	for(uint32_t offset = 0; offset < me->old_size; offset += me->out_size)
+	{
+		size_t n = me->old_size - offset < me->out_size ? me->old_size - offset : me->out_size;
+		esp_err_t ret = me->read(offset, me->out, n, me->arg);
+
+		if(ret != ESP_OK)
+			return ret;
+
+		bitec_ota_sha256_update(&sha, me->out, n);
+	}
+
+	bitec_ota_sha256_finish(&sha, digest);
+
+	if(memcmp(digest, me->header + HEADER_OLD_DIGEST, sizeof(digest)))
+		return ESP_ERR_INVALID_VERSION;
+
+	return ESP_OK;
+}
+
+static esp_err_t copy(bitec_ota_delta_t * const me, uint32_t length)
+{
+	esp_err_t ret = ESP_OK;
+
+	if(me->distance > me->window_pos)
+		return ESP_ERR_INVALID_RESPONSE;
+
+	/* Byte by byte, a match may overlap the bytes it repeats */
+	for(uint32_t i = 0; i < length && ret == ESP_OK; i++)
+		ret = emit(me, me->window[(me->window_pos - me->distance) & WINDOW_MASK]);
+
+	return ret;
+}
+
+static esp_err_t emit(bitec_ota_delta_t * const me, uint8_t byte)
+{
+	me->window[me->window_pos++ & WINDOW_MASK] = byte;
+
+	return put(me, byte);
+}
+
+static esp_err_t put(bitec_ota_delta_t * const me, uint8_t byte)
+{
+	esp_err_t ret;
+
+	switch(me->record)
+	{
+		case OTA_DELTA_ADD:
+			/* The old bytes are read into out, where the differences are added in place */
+			if(me->out_len == me->out_old)
+			{
+				if(me->out_len == me->out_size)
+				{
+					ret = flush(me);
+
+					if(ret != ESP_OK)
+						return ret;
+				}
+
+				size_t n = me->out_size - me->out_len < me->add ? me->out_size - me->out_len : me->add;
+				ret = me->read(me->old_pos, me->out + me->out_len, n, me->arg);
+
+				if(ret != ESP_OK)
+					return ret;
+
+				me->old_pos += n;
+				me->out_old = me->out_len + n;
+			}
+
+			me->out[me->out_len++] += byte;
+
+			if(--me->add == 0)
+			{
+				if(me->insert > 0)
+					me->record = OTA_DELTA_INSERT;
+				else
+					record_end(me);
+			}
+
+			return ESP_OK;
+
+		case OTA_DELTA_INSERT:
+			if(me->out_len == me->out_size)
+			{
+				ret = flush(me);
+
+				if(ret != ESP_OK)
+					return ret;
+			}
+
+			me->out[me->out_len++] = byte;
+
+			if(--me->insert == 0)
+				record_end(me);
+
+			return ESP_OK;
+
+		default:
+			break;
+	}
+
+	/* Record sizes */
+	me->value |= (uint32_t)(byte & 0x7F) << me->value_shift;
+
+	if(byte & 0x80)
+	{
+		me->value_shift += 7;
+
+		return me->value_shift > VARINT_SHIFT_MAX ? ESP_ERR_INVALID_RESPONSE : ESP_OK;
+	}
+
+	uint32_t value = me->value;
+	me->value = 0;
+	me->value_shift = 0;
+
+	switch(me->record)
+	{
+		case OTA_DELTA_ADD_SIZE:
+			if(value > me->left)
+				return ESP_ERR_INVALID_RESPONSE;
+
+			me->add = value;
+			me->left -= value;
+			me->record = OTA_DELTA_INSERT_SIZE;
+			break;
+
+		case OTA_DELTA_INSERT_SIZE:
+			if(value > me->left)
+				return ESP_ERR_INVALID_RESPONSE;
+
+			me->insert = value;
+			me->left -= value;
+			me->record = OTA_DELTA_MOVE;
+			break;
+
+		default:
+		{
+			/* Zigzag, small moves both ways take one byte */
+			int64_t next = (int64_t)me->old_pos + me->add + (int32_t)((value >> 1) ^ -(value & 1));
+
+			if(me->add > me->old_size - me->old_pos || next < 0 || next > me->old_size)
+				return ESP_ERR_INVALID_RESPONSE;
+
+			me->old_next = (uint32_t)next;
+			record_start(me);
+			break;
+		}
+	}
+
+	return ESP_OK;
+}
+
+static void record_start(bitec_ota_delta_t * const me)
+{
+	if(me->add > 0)
+	{
+		me->out_old = me->out_len;
+		me->record = OTA_DELTA_ADD;
+	}
+	else if(me->insert > 0)
+		me->record = OTA_DELTA_INSERT;
+	else
+		record_end(me);
+}
+
+static void record_end(bitec_ota_delta_t * const me)
+{
+	me->old_pos = me->old_next;
+	me->record = OTA_DELTA_ADD_SIZE;
+}
+
+static esp_err_t flush(bitec_ota_delta_t * const me)
+{
+	if(me->out_len == 0)
+		return ESP_OK;
+
+	bitec_ota_sha256_update(&me->sha, me->out, me->out_len);
+
+	esp_err_t ret = me->write(me->out, me->out_len, me->arg);
+
+	me->written += me->out_len;
+	me->out_len = 0;
+	me->out_old = 0;
+
+	return ret;
+}
+
+static void next_item(bitec_ota_delta_t * const me)
+{
+	me->flags >>= 1;
+
+	if(--me->items == 0)
+		me->lz = OTA_DELTA_LZ_FLAGS;
+	else
+		me->lz = OTA_DELTA_LZ_ITEM;
+}
+
+static uint32_t load_le32(const uint8_t * p)
+{
+	return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/* end of file ---------------------------------------------------------------*/
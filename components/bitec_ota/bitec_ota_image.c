@@ -0,0 +1,307 @@
+/*
+ * bitec_ota_image.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "include/bitec_ota_image.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define IMAGE_MAGIC			0xE9		/*!< First byte of an app image */
+#define APP_DESC_OFFSET		32			/*!< esp_app_desc_t, after the image and first segment headers */
+#define APP_DESC_MAGIC		0xABCD5432
+#define VERSION_OFFSET		(APP_DESC_OFFSET + 16)
+
+#define BLOCK_MAGIC			0xE7		/*!< ets_secure_boot_signature_t magic byte */
+#define BLOCK_VERSION		0x02		/*!< RSA-PSS */
+#define BLOCK_DIGEST_OFFSET	4
+#define BLOCK_CRC_OFFSET	1196		/*!< The CRC covers the block up to it */
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+#define ROTR(x, n)			(((x) >> (n)) | ((x) << (32 - (n))))
+#endif
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+static const uint32_t sha256_k[64] =
+{
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+#endif
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static esp_err_t head_check(bitec_ota_image_t * const me);
+#ifdef CONFIG_IDF_TARGET_LINUX
+static void sha256_block(uint32_t * state, const uint8_t * block);
+#endif
+static uint32_t load_le32(const uint8_t * p);
+
+/* external functions definition ---------------------------------------------*/
+
+esp_err_t bitec_ota_image_init(bitec_ota_image_t * const me, uint32_t size, bool sign)
+{
+	memset(me, 0, sizeof(bitec_ota_image_t));
+
+	if(size < OTA_IMAGE_HEAD_SIZE)
+		return ESP_ERR_INVALID_SIZE;
+
+	/* The signature sector follows the image padded to a sector */
+	if(sign && (size % OTA_IMAGE_SECTOR_SIZE != 0 || size < 2 * OTA_IMAGE_SECTOR_SIZE))
+		return ESP_ERR_INVALID_SIZE;
+
+	me->size = size;
+	me->signed_size = sign ? size - OTA_IMAGE_SECTOR_SIZE : size;
+	me->sign = sign;
+	bitec_ota_sha256_init(&me->sha);
+
+	return ESP_OK;
+}
+
+esp_err_t bitec_ota_image_feed(bitec_ota_image_t * const me, const uint8_t * data, size_t len)
+{
+	if(len > me->size - me->offset)
+		return ESP_ERR_INVALID_SIZE;
+
+	if(me->offset < OTA_IMAGE_HEAD_SIZE)
+	{
+		size_t n = OTA_IMAGE_HEAD_SIZE - me->offset < len ? OTA_IMAGE_HEAD_SIZE - me->offset : len;
+		memcpy(me->head + me->offset, data, n);
+
+		if(me->offset + n == OTA_IMAGE_HEAD_SIZE)
+		{
+			esp_err_t ret = head_check(me);
+
+			if(ret != ESP_OK)
+				return ret;
+		}
+	}
+
+	if(me->offset < me->signed_size)
+		bitec_ota_sha256_update(&me->sha, data, me->signed_size - me->offset < len ? me->signed_size - me->offset : len);
+
+	/* Keep the signature block, the rest of the sector is padding */
+	uint32_t end = me->offset + len;
+	uint32_t block_end = me->signed_size + OTA_IMAGE_BLOCK_SIZE;
+
+	if(me->sign && end > me->signed_size && me->offset < block_end)
+	{
+		uint32_t from = me->offset > me->signed_size ? me->offset : me->signed_size;
+		uint32_t to = end < block_end ? end : block_end;
+		memcpy(me->block + from - me->signed_size, data + from - me->offset, to - from);
+	}
+
+	me->offset = end;
+
+	return ESP_OK;
+}
+
+esp_err_t bitec_ota_image_finish(bitec_ota_image_t * const me)
+{
+	if(me->offset != me->size)
+		return ESP_ERR_INVALID_SIZE;
+
+	bitec_ota_sha256_finish(&me->sha, me->digest);
+
+	if(!me->sign)
+		return ESP_OK;
+
+	if(me->block[0] != BLOCK_MAGIC || me->block[1] != BLOCK_VERSION)
+		return ESP_ERR_INVALID_RESPONSE;
+
+	if(bitec_ota_crc32(me->block, BLOCK_CRC_OFFSET) != load_le32(me->block + BLOCK_CRC_OFFSET))
+		return ESP_ERR_INVALID_CRC;
+
+	if(memcmp(me->block + BLOCK_DIGEST_OFFSET, me->digest, OTA_IMAGE_DIGEST_SIZE))
+		return ESP_ERR_INVALID_CRC;
+
+	return ESP_OK;
+}
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+void bitec_ota_sha256_init(bitec_ota_sha256_t * const me)
+{
+	static const uint32_t init[8] =
+	{
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+	};
+
+	memcpy(me->state, init, sizeof(init));
+	me->bytes = 0;
+	me->buf_len = 0;
+}
+
+void bitec_ota_sha256_update(bitec_ota_sha256_t * const me, const uint8_t * data, size_t len)
+{
+	me->bytes += len;
+
+	/* Complete a partial block first */
+	if(me->buf_len > 0)
+	{
+		size_t n = sizeof(me->buf) - me->buf_len < len ? sizeof(me->buf) - me->buf_len : len;
+		memcpy(me->buf + me->buf_len, data, n);
+		me->buf_len += n;
+		data += n;
+		len -= n;
+
+		if(me->buf_len < sizeof(me->buf))
+			return;
+
+		sha256_block(me->state, me->buf);
+		me->buf_len = 0;
+	}
+
+	/* Whole blocks straight from the data */
+	for(; len >= sizeof(me->buf); data += sizeof(me->buf), len -= sizeof(me->buf))
+		sha256_block(me->state, data);
+
+	memcpy(me->buf, data, len);
+	me->buf_len = len;
+}
+
+void bitec_ota_sha256_finish(bitec_ota_sha256_t * const me, uint8_t * digest)
+{
+	uint64_t bits = me->bytes * 8;
+
+	me->buf[me->buf_len++] = 0x80;
+
+	if(me->buf_len > sizeof(me->buf) - 8)
+	{
+		memset(me->buf + me->buf_len, 0, sizeof(me->buf) - me->buf_len);
+		sha256_block(me->state, me->buf);
+		me->buf_len = 0;
+	}
+
+	memset(me->buf + me->buf_len, 0, sizeof(me->buf) - 8 - me->buf_len);
+
+	for(int i = 0; i < 8; i++)
+		me->buf[sizeof(me->buf) - 1 - i] = (uint8_t)(bits >> (8 * i));
+
+	sha256_block(me->state, me->buf);
+
+	for(int i = 0; i < 8; i++)
+	{
+		digest[4 * i] = (uint8_t)(me->state[i] >> 24);
+		digest[4 * i + 1] = (uint8_t)(me->state[i] >> 16);
+		digest[4 * i + 2] = (uint8_t)(me->state[i] >> 8);
+		digest[4 * i + 3] = (uint8_t)me->state[i];
+	}
+}
+#else
+/* Hardware accelerated on the ESP32-S2 */
+void bitec_ota_sha256_init(bitec_ota_sha256_t * const me)
+{
+	mbedtls_sha256_init(me);
+	mbedtls_sha256_starts(me, 0);
+}
+
+void bitec_ota_sha256_update(bitec_ota_sha256_t * const me, const uint8_t * data, size_t len)
+{
+	mbedtls_sha256_update(me, data, len);
+}
+
+void bitec_ota_sha256_finish(bitec_ota_sha256_t * const me, uint8_t * digest)
+{
+	mbedtls_sha256_finish(me, digest);
+	mbedtls_sha256_free(me);
+}
+#endif
+
+uint32_t bitec_ota_crc32(const uint8_t * data, size_t len)
+{
+	uint32_t crc = 0xFFFFFFFF;
+
+	/* Bitwise, it runs once per update */
+	for(size_t i = 0; i < len; i++)
+	{
+		crc ^= data[i];
+
+		for(int bit = 0; bit < 8; bit++)
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+	}
+
+	return ~crc;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static esp_err_t head_check(bitec_ota_image_t * const me)
+{
+	/* An error page or a file of another kind is caught on its first bytes */
+	if(me->head[0] != IMAGE_MAGIC || load_le32(me->head + APP_DESC_OFFSET) != APP_DESC_MAGIC)
+		return ESP_ERR_INVALID_RESPONSE;
+
+	memcpy(me->version, me->head + VERSION_OFFSET, OTA_IMAGE_VERSION_SIZE);
+	me->version[OTA_IMAGE_VERSION_SIZE] = '\0';
+
+	return ESP_OK;
+}
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+static void sha256_block(uint32_t * state, const uint8_t * block)
+{
+	uint32_t w[64];
+
+	for(int i = 0; i < 16; i++)
+		w[i] = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 | (uint32_t)block[4 * i + 2] << 8 | block[4 * i + 3];
+
+	for(int i = 16; i < 64; i++)
+	{
+		uint32_t s0 = ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+		uint32_t s1 = ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+
+	uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+	uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+	for(int i = 0; i < 64; i++)
+	{
+		uint32_t t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) + ((e & f) ^ (~e & g)) + sha256_k[i] + w[i];
+		uint32_t t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+	state[5] += f;
+	state[6] += g;
+	state[7] += h;
+}
+#endif
+
+static uint32_t load_le32(const uint8_t * p)
+{
+	return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,347 @@
+/*
+ * bitec_ota_rollout.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "include/bitec_ota_rollout.h"
+#include "esp_log.h"
+#include "cJSON.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define WAIT_MAX				UINT32_MAX	/*!< About 49 days */
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static const char * TAG = "bitec_ota_rollout";
+
+static const char * const names[BITEC_OTA_ROLLOUT_MAX] =
+{
+	"idle", "scheduled", "deferred", "downloading", "ready", "failed", "current", "expired"
+};
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static esp_err_t string_get(const cJSON * root, const char * name, char * value, size_t size, bool required);
+static esp_err_t digest_get(const cJSON * root, const char * name, uint8_t * digest);
+static void defer(bitec_ota_rollout_t * const me);
+static void state_set(bitec_ota_rollout_t * const me, bitec_ota_rollout_state_e state);
+static void progress(uint32_t offset, uint32_t size, void * arg);
+static uint32_t random_next(bitec_ota_rollout_t * const me);
+
+/* external functions definition ---------------------------------------------*/
+
+void bitec_ota_rollout_init(bitec_ota_rollout_t * const me)
+{
+	memset(me, 0, sizeof(bitec_ota_rollout_t));
+
+	me->window = CONFIG_BITEC_OTA_ROLLOUT_WINDOW;
+	me->defer_time = CONFIG_BITEC_OTA_ROLLOUT_DEFER_TIME;
+	me->defer_max = CONFIG_BITEC_OTA_ROLLOUT_DEFER_MAX;
+	me->progress_step = CONFIG_BITEC_OTA_ROLLOUT_PROGRESS_STEP;
+	me->report = NULL;
+	me->arg = NULL;
+	me->state = BITEC_OTA_ROLLOUT_IDLE;
+}
+
+esp_err_t bitec_ota_rollout_parse(bitec_ota_rollout_t * const me, const char * data, size_t len)
+{
+	esp_err_t ret = ESP_OK;
+	char version[OTA_IMAGE_VERSION_SIZE + 1];
+	uint8_t digest[OTA_IMAGE_DIGEST_SIZE];
+
+	/* The download has to end before another rollout can start */
+	if(me->state == BITEC_OTA_ROLLOUT_DOWNLOADING || me->state == BITEC_OTA_ROLLOUT_READY)
+		return ESP_ERR_INVALID_STATE;
+
+	cJSON * root = cJSON_ParseWithLength(data, len);
+
+	if(root == NULL)
+		return ESP_ERR_INVALID_ARG;
+
+	const cJSON * start = cJSON_GetObjectItem(root, "start");
+	const cJSON * end = cJSON_GetObjectItem(root, "end");
+
+	/* Checked whole first, a malformed descriptor leaves the one taken before as it was */
+	if(string_get(root, "version", version, sizeof(version), true) != ESP_OK ||
+			string_get(root, "url", NULL, sizeof(me->url), true) != ESP_OK ||
+			string_get(root, "patch", NULL, sizeof(me->patch), false) != ESP_OK ||
+			digest_get(root, "sha256", digest) != ESP_OK)
+		ret = ESP_ERR_INVALID_ARG;
+	else if((start == NULL) != (end == NULL) ||
+			(start != NULL && (!cJSON_IsNumber(start) || !cJSON_IsNumber(end) || end->valuedouble < start->valuedouble)))
+		ret = ESP_ERR_INVALID_ARG;
+	else if(me->state != BITEC_OTA_ROLLOUT_IDLE && !strcmp(version, me->version) &&
+			!memcmp(digest, me->digest, sizeof(digest)))
+		ret = ESP_ERR_INVALID_STATE;	/* Retained descriptors come again on every connection */
+
+	if(ret == ESP_OK)
+	{
+		string_get(root, "url", me->url, sizeof(me->url), true);
+		string_get(root, "patch", me->patch, sizeof(me->patch), false);
+		strcpy(me->version, version);
+		memcpy(me->digest, digest, sizeof(digest));
+		me->window_set = start != NULL;
+		me->start = me->window_set ? (int64_t)start->valuedouble : 0;
+		me->end = me->window_set ? (int64_t)end->valuedouble : 0;
+		me->state = BITEC_OTA_ROLLOUT_IDLE;
+	}
+
+	cJSON_Delete(root);
+
+	return ret;
+}
+
+void bitec_ota_rollout_schedule(bitec_ota_rollout_t * const me, const char * id, const char * running, int64_t now)
+{
+	bitec_ota_sha256_t sha;
+	uint8_t hash[OTA_IMAGE_DIGEST_SIZE];
+	int64_t from;
+	int64_t span;
+
+	/* Same slot on every delivery, a different one for every release */
+	bitec_ota_sha256_init(&sha);
+	bitec_ota_sha256_update(&sha, (const uint8_t *)id, strlen(id));
+	bitec_ota_sha256_update(&sha, (const uint8_t *)me->version, strlen(me->version));
+	bitec_ota_sha256_finish(&sha, hash);
+
+	uint32_t slot = (uint32_t)hash[0] << 24 | (uint32_t)hash[1] << 16 | (uint32_t)hash[2] << 8 | hash[3];
+
+	me->random = slot != 0 ? slot : 1;
+	me->defers = 0;
+	me->progress = 0;
+	me->error = ESP_OK;
+	me->wait = 0;
+
+	if(!strcmp(running, me->version))
+	{
+		state_set(me, BITEC_OTA_ROLLOUT_CURRENT);
+		return;
+	}
+
+	if(!me->window_set)
+	{
+		from = 0;
+		span = (int64_t)me->window * 1000;
+	}
+	else if(now < 0 || now >= me->end * 1000)
+	{
+		from = 0;
+		span = (me->end - me->start) * 1000;
+	}
+	else if(now < me->start * 1000)
+	{
+		from = me->start * 1000 - now;
+		span = (me->end - me->start) * 1000;
+	}
+	else
+	{
+		from = 0;
+		span = me->end * 1000 - now;
+	}
+
+	int64_t wait = from + (int64_t)(((uint64_t)slot * (uint64_t)span) >> 32);
+	me->wait = wait < WAIT_MAX ? (uint32_t)wait : WAIT_MAX;
+
+	ESP_LOGI(TAG, "Version %s scheduled in %" PRIu32 " s", me->version, me->wait / 1000);
+	state_set(me, BITEC_OTA_ROLLOUT_SCHEDULED);
+}
+
+bool bitec_ota_rollout_check(bitec_ota_rollout_t * const me, bool ready)
+{
+	if(me->state != BITEC_OTA_ROLLOUT_SCHEDULED && me->state != BITEC_OTA_ROLLOUT_DEFERRED)
+		return false;
+
+	if(!ready)
+	{
+		defer(me);
+		return false;
+	}
+
+	me->progress = 0;
+	state_set(me, BITEC_OTA_ROLLOUT_DOWNLOADING);
+
+	return true;
+}
+
+esp_err_t bitec_ota_rollout_update(bitec_ota_rollout_t * const me, bitec_ota_t * const ota)
+{
+	esp_err_t ret = ESP_ERR_NOT_FOUND;
+
+	if(me->state != BITEC_OTA_ROLLOUT_DOWNLOADING)
+		return ESP_ERR_INVALID_STATE;
+
+	ota->digest = me->digest;
+	ota->progress = progress;
+	ota->arg = (void *)me;
+
+	if(me->patch[0] != '\0')
+		ret = bitec_ota_update_delta(ota, me->patch);
+
+	/* A patch of another image or a running image that can not be read take the whole image */
+	if(ret == ESP_ERR_NOT_FOUND || ret == ESP_ERR_INVALID_VERSION)
+	{
+		if(me->patch[0] != '\0')
+			ESP_LOGW(TAG, "Patch not applicable, downloading the image");
+
+		me->progress = 0;
+		ret = bitec_ota_update(ota, me->url);
+	}
+
+	ota->digest = NULL;
+	ota->progress = NULL;
+	ota->arg = NULL;
+	bitec_ota_rollout_end(me, ret);
+
+	return ret;
+}
+
+void bitec_ota_rollout_end(bitec_ota_rollout_t * const me, esp_err_t ret)
+{
+	if(me->state != BITEC_OTA_ROLLOUT_DOWNLOADING)
+		return;
+
+	me->error = ret;
+
+	if(ret == ESP_OK)
+		state_set(me, BITEC_OTA_ROLLOUT_READY);
+	else if(ret == ESP_FAIL)
+		defer(me);	/* The server is busy or out of reach */
+	else
+		state_set(me, BITEC_OTA_ROLLOUT_FAILED);
+}
+
+const char * bitec_ota_rollout_name(bitec_ota_rollout_state_e state)
+{
+	if(state >= BITEC_OTA_ROLLOUT_MAX)
+		return "unknown";
+
+	return names[state];
+}
+
+int bitec_ota_rollout_print(const bitec_ota_rollout_t * const me, char * buf, size_t size)
+{
+	int len = snprintf(buf, size, "{\"version\":\"%s\",\"state\":\"%s\",\"wait\":%" PRIu32 ",\"defers\":%" PRIu32 ",\"progress\":%u,\"error\":%d}",
+			me->version, bitec_ota_rollout_name(me->state), me->wait, me->defers, me->progress, me->error);
+
+	if(len < 0 || (size_t)len >= size)
+		return -1;
+
+	return len;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* A string of less than size bytes, only checked if value is NULL */
+static esp_err_t string_get(const cJSON * root, const char * name, char * value, size_t size, bool required)
+{
+	const cJSON * item = cJSON_GetObjectItem(root, name);
+
+	if(value != NULL)
+		value[0] = '\0';
+
+	if(item == NULL)
+		return required ? ESP_ERR_INVALID_ARG : ESP_OK;
+
+	if(!cJSON_IsString(item) || item->valuestring[0] == '\0' || strlen(item->valuestring) >= size)
+		return ESP_ERR_INVALID_ARG;
+
+	if(value != NULL)
+		strcpy(value, item->valuestring);
+
+	return ESP_OK;
+}
+
+static esp_err_t digest_get(const cJSON * root, const char * name, uint8_t * digest)
+{
+	const cJSON * item = cJSON_GetObjectItem(root, name);
+
+	if(!cJSON_IsString(item) || strlen(item->valuestring) != OTA_IMAGE_DIGEST_SIZE * 2)
+		return ESP_ERR_INVALID_ARG;
+
+	for(int i = 0; i < OTA_IMAGE_DIGEST_SIZE * 2; i++)
+	{
+		char c = item->valuestring[i];
+		uint8_t nibble;
+
+		if(c >= '0' && c <= '9')
+			nibble = c - '0';
+		else if(c >= 'a' && c <= 'f')
+			nibble = c - 'a' + 10;
+		else if(c >= 'A' && c <= 'F')
+			nibble = c - 'A' + 10;
+		else
+			return ESP_ERR_INVALID_ARG;
+
+		digest[i / 2] = i % 2 ? digest[i / 2] | nibble : nibble << 4;
+	}
+
+	return ESP_OK;
+}
+
+/* Wait again, with a jitter so devices deferred together do not come back together */
+static void defer(bitec_ota_rollout_t * const me)
+{
+	if(++me->defers > me->defer_max)
+	{
+		ESP_LOGW(TAG, "Version %s given up after %" PRIu32 " deferrals", me->version, me->defer_max);
+		me->wait = 0;
+		state_set(me, BITEC_OTA_ROLLOUT_EXPIRED);
+		return;
+	}
+
+	me->wait = me->defer_time / 2 + (me->defer_time > 0 ? random_next(me) % me->defer_time : 0);
+
+	ESP_LOGI(TAG, "Version %s deferred %" PRIu32 " s", me->version, me->wait / 1000);
+	state_set(me, BITEC_OTA_ROLLOUT_DEFERRED);
+}
+
+static void state_set(bitec_ota_rollout_t * const me, bitec_ota_rollout_state_e state)
+{
+	me->state = state;
+
+	if(me->report != NULL)
+		me->report(me, me->arg);
+}
+
+static void progress(uint32_t offset, uint32_t size, void * arg)
+{
+	bitec_ota_rollout_t * me = (bitec_ota_rollout_t *)arg;
+
+	if(size == 0 || me->progress_step == 0)
+		return;
+
+	uint8_t percent = (uint8_t)((uint64_t)offset * 100 / size);
+
+	if(percent < me->progress + me->progress_step)
+		return;
+
+	me->progress = percent - percent % me->progress_step;
+
+	if(me->report != NULL)
+		me->report(me, me->arg);
+}
+
+/* xorshift32 */
+static uint32_t random_next(bitec_ota_rollout_t * const me)
+{
+	me->random ^= me->random << 13;
+	me->random ^= me->random >> 17;
+	me->random ^= me->random << 5;
+
+	return me->random;
+}
+
+/* end of file ---------------------------------------------------------------*/
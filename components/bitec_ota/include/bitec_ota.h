@@ -0,0 +1,112 @@
+/*
+ * bitec_ota.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_OTA_H_
+#define _BITEC_OTA_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "bitec_hal.h"
+#include "bitec_ota_image.h"
+#include "bitec_ota_delta.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+/* Called after every downloaded chunk with the bytes downloaded out of size */
+typedef void (* bitec_ota_progress_t)(uint32_t offset, uint32_t size, void * arg);
+
+typedef enum
+{
+	BITEC_OTA_IDLE = 0,
+	BITEC_OTA_DOWNLOADING,
+	BITEC_OTA_READY,			/*!< Verified and set to boot, waiting for a restart */
+	BITEC_OTA_FAILED
+} bitec_ota_state_e;
+
+typedef struct
+{
+	/* Configuration, set from Kconfig by bitec_ota_init() */
+	uint32_t chunk_size;		/*!< Download buffer, the only copy of the image in RAM */
+	uint32_t retries;			/*!< Resumes in a row without progress before giving up */
+	uint32_t retry_time;		/*!< Wait before a resume in ms */
+	uint32_t timeout;			/*!< Network timeout in ms */
+	uint32_t self_test_time;	/*!< Time for a new image to pass its self test in ms */
+	bool sign;					/*!< Images end with a secure boot v2 signature sector */
+	const uint8_t * digest;		/*!< SHA-256 the image must have, as bitec_ota_image_t digest, NULL for any */
+	bitec_ota_progress_t progress;	/*!< NULL for none */
+	void * arg;					/*!< Of progress */
+
+	/* State */
+	bitec_ota_state_e state;
+	bitec_ota_image_t image;
+	bitec_ota_delta_t * delta;	/*!< Allocated during delta updates */
+	hal_ota_handle_t handle;	/*!< 0 until the app partition is opened */
+	uint32_t size;				/*!< Bytes to download, the image or the patch */
+	uint32_t offset;			/*!< Bytes downloaded */
+	bool pending;				/*!< The running image waits for its self test */
+	hal_timer_t timer;
+
+	/* Metrics, of the last update */
+	uint32_t updates;
+	uint32_t failures;
+	esp_err_t error;
+	uint32_t resumes;
+	uint32_t time;				/*!< Download and verification time in ms */
+	uint32_t throughput;		/*!< Bytes per second */
+	size_t heap;				/*!< Peak heap taken by the update in bytes */
+} bitec_ota_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Set the configuration from Kconfig, it can be changed afterwards. A running image waiting for its
+ * self test is rolled back if bitec_ota_self_test() does not pass it within self_test_time */
+esp_err_t bitec_ota_init(bitec_ota_t * const me);
+
+/* Download the image at url into the inactive app partition, streamed in chunk_size pieces and
+ * checked as it arrives. Dropped connections resume where they stopped with a range request. On
+ * success the image boots on the next restart. Blocks until the update ends */
+esp_err_t bitec_ota_update(bitec_ota_t * const me, const char * url);
+
+/* Same as bitec_ota_update() with a patch of the running image at url, as bitec_ota_diff() builds it.
+ * The new image is rebuilt from the running one and the patch into the inactive app partition and
+ * checked as a downloaded one. A patch of another image is refused with ESP_ERR_INVALID_VERSION */
+esp_err_t bitec_ota_update_delta(bitec_ota_t * const me, const char * url);
+
+/* Result of the self test of a new image, it is kept if passed and rolled back otherwise. Does
+ * nothing if the running image is not waiting for it */
+void bitec_ota_self_test(bitec_ota_t * const me, bool passed);
+
+/* Print the state and the metrics of the last update as JSON. Returns its length or -1 if it does
+ * not fit */
+int bitec_ota_print(const bitec_ota_t * const me, char * buf, size_t size);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_OTA_H_ */
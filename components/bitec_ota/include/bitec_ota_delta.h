@@ -0,0 +1,132 @@
+/*
+ * bitec_ota_delta.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_OTA_DELTA_H_
+#define _BITEC_OTA_DELTA_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "bitec_ota_image.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+/* A patch is a header followed by LZSS compressed records. Each record is three varints, the bytes to
+ * add to the old image, the new bytes to insert and the signed move in the old image after them,
+ * then the add differences and the inserted bytes. Matches are two bytes, a 12 bit distance and a 4
+ * bit length where 15 is followed by a varint, so long runs of unchanged bytes take a few bytes */
+#define OTA_DELTA_MAGIC			"BDLT"
+#define OTA_DELTA_VERSION		1
+#define OTA_DELTA_HEADER_SIZE	80			/*!< Magic, version, window bits, sizes and digests */
+#define OTA_DELTA_WINDOW_BITS	12
+#define OTA_DELTA_WINDOW_SIZE	(1 << OTA_DELTA_WINDOW_BITS)	/*!< LZSS window, the decoder history */
+#define OTA_DELTA_MATCH_MIN		3			/*!< Shortest match */
+
+/* typedef -------------------------------------------------------------------*/
+
+/* Read size bytes of the old image from offset */
+typedef esp_err_t (* bitec_ota_delta_read_t)(uint32_t offset, void * data, size_t size, void * arg);
+
+/* Take the next size bytes of the new image */
+typedef esp_err_t (* bitec_ota_delta_write_t)(const uint8_t * data, size_t size, void * arg);
+
+typedef enum
+{
+	OTA_DELTA_LZ_FLAGS = 0,
+	OTA_DELTA_LZ_ITEM,
+	OTA_DELTA_LZ_MATCH,		/*!< Second byte of a match */
+	OTA_DELTA_LZ_LENGTH		/*!< Varint of a long match */
+} bitec_ota_delta_lz_e;
+
+typedef enum
+{
+	OTA_DELTA_ADD_SIZE = 0,
+	OTA_DELTA_INSERT_SIZE,
+	OTA_DELTA_MOVE,
+	OTA_DELTA_ADD,
+	OTA_DELTA_INSERT
+} bitec_ota_delta_record_e;
+
+typedef struct
+{
+	/* Header */
+	uint8_t header[OTA_DELTA_HEADER_SIZE];
+	uint32_t old_size;
+	uint32_t new_size;
+	uint32_t offset;			/*!< Patch bytes fed so far */
+
+	/* LZSS decoder */
+	bitec_ota_delta_lz_e lz;
+	uint8_t flags;				/*!< Kinds of the next items, literal or match, LSB first */
+	uint8_t items;				/*!< Items left in flags */
+	uint16_t distance;
+	uint32_t length;
+	uint8_t shift;				/*!< Of the varint being read */
+	uint32_t window_pos;
+	uint8_t window[OTA_DELTA_WINDOW_SIZE];
+
+	/* Records */
+	bitec_ota_delta_record_e record;
+	uint32_t value;				/*!< Varint being read */
+	uint8_t value_shift;
+	uint32_t add;
+	uint32_t insert;
+	uint32_t old_pos;			/*!< Next old image byte to add to */
+	uint32_t old_next;			/*!< Old image position once the record is done */
+	uint32_t left;				/*!< New image bytes not covered by a record yet */
+
+	/* New image, staged in out and written when it fills up */
+	uint8_t * out;
+	size_t out_size;
+	size_t out_len;
+	size_t out_old;				/*!< Bytes of out holding old image bytes to add to */
+	uint32_t written;
+	bitec_ota_sha256_t sha;
+
+	bitec_ota_delta_read_t read;
+	bitec_ota_delta_write_t write;
+	void * arg;
+} bitec_ota_delta_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Start applying a patch. The new image is staged in out, written out_size bytes at a time */
+void bitec_ota_delta_init(bitec_ota_delta_t * const me, uint8_t * out, size_t out_size, bitec_ota_delta_read_t read,
+		bitec_ota_delta_write_t write, void * arg);
+
+/* Feed the next bytes of the patch as they are downloaded, split anywhere. The old image is checked
+ * against the digest of the header once it is complete, nothing is written for a patch of another
+ * image. Returns ESP_ERR_INVALID_RESPONSE for something else than a patch or a malformed one and
+ * ESP_ERR_INVALID_VERSION for a patch of another old image */
+esp_err_t bitec_ota_delta_feed(bitec_ota_delta_t * const me, const uint8_t * data, size_t len);
+
+/* Write the rest of the new image and check its digest, ESP_ERR_INVALID_CRC if it does not match */
+esp_err_t bitec_ota_delta_finish(bitec_ota_delta_t * const me);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_OTA_DELTA_H_ */
@@ -0,0 +1,100 @@
+/*
+ * bitec_ota_image.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_OTA_IMAGE_H_
+#define _BITEC_OTA_IMAGE_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+#ifndef CONFIG_IDF_TARGET_LINUX
+#include "mbedtls/sha256.h"
+#endif
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#define OTA_IMAGE_HEAD_SIZE		80			/*!< Image header, first segment header and app description up to its version */
+#define OTA_IMAGE_VERSION_SIZE	32			/*!< App version string, as in esp_app_desc_t */
+#define OTA_IMAGE_SECTOR_SIZE	4096		/*!< Signed images and their signature sector are multiples of it */
+#define OTA_IMAGE_BLOCK_SIZE	1216		/*!< Secure boot v2 signature block, the first one of the sector */
+#define OTA_IMAGE_DIGEST_SIZE	32			/*!< SHA-256 */
+
+/* typedef -------------------------------------------------------------------*/
+
+/* SHA-256 of the SHA peripheral through mbedtls on target and a software one on Linux */
+#ifdef CONFIG_IDF_TARGET_LINUX
+typedef struct
+{
+	uint32_t state[8];
+	uint64_t bytes;
+	uint8_t buf[64];
+	size_t buf_len;
+} bitec_ota_sha256_t;
+#else
+typedef mbedtls_sha256_context bitec_ota_sha256_t;
+#endif
+
+typedef struct
+{
+	uint32_t size;			/*!< Image size with its signature sector */
+	uint32_t signed_size;	/*!< Bytes covered by the signature */
+	uint32_t offset;		/*!< Bytes fed so far */
+	bool sign;				/*!< The image ends with a signature sector */
+	uint8_t head[OTA_IMAGE_HEAD_SIZE];
+	char version[OTA_IMAGE_VERSION_SIZE + 1];	/*!< App version, empty until the head is fed */
+	uint8_t block[OTA_IMAGE_BLOCK_SIZE];		/*!< Signature block, for the target to check its signature */
+	bitec_ota_sha256_t sha;
+	uint8_t digest[OTA_IMAGE_DIGEST_SIZE];		/*!< SHA-256 of the signed bytes once finished */
+} bitec_ota_image_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Start checking an image of size bytes, a signed one must be sector aligned */
+esp_err_t bitec_ota_image_init(bitec_ota_image_t * const me, uint32_t size, bool sign);
+
+/* Feed the next bytes of the image as they are downloaded, split anywhere. The head is checked as
+ * soon as it is complete so a wrong download stops early. Returns ESP_ERR_INVALID_RESPONSE for
+ * something else than an app image and ESP_ERR_INVALID_SIZE past its size */
+esp_err_t bitec_ota_image_feed(bitec_ota_image_t * const me, const uint8_t * data, size_t len);
+
+/* Check a complete image, the digest of the signed bytes against the one in the signature block.
+ * The block signature itself is checked by the target. Returns ESP_ERR_INVALID_RESPONSE if there is
+ * no signature block and ESP_ERR_INVALID_CRC if it does not match */
+esp_err_t bitec_ota_image_finish(bitec_ota_image_t * const me);
+
+/* SHA-256, fed in any number of parts */
+void bitec_ota_sha256_init(bitec_ota_sha256_t * const me);
+void bitec_ota_sha256_update(bitec_ota_sha256_t * const me, const uint8_t * data, size_t len);
+void bitec_ota_sha256_finish(bitec_ota_sha256_t * const me, uint8_t * digest);
+
+/* CRC-32 of a signature block, as zlib computes it */
+uint32_t bitec_ota_crc32(const uint8_t * data, size_t len);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_OTA_IMAGE_H_ */
@@ -0,0 +1,133 @@
+/*
+ * bitec_ota_rollout.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_OTA_ROLLOUT_H_
+#define _BITEC_OTA_ROLLOUT_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "bitec_ota.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+/* A rollout descriptor is a JSON object sent to every device of the fleet:
+ *
+ *     {"version":"1.2.0","url":"https://...","patch":"https://...","sha256":"<64 hex digits>",
+ *      "start":1792000000,"end":1792003600}
+ *
+ * patch is optional, a patch of the running image tried before url. sha256 is the digest of the
+ * image without its signature sector. start and end are the window in unix time, every device
+ * starts its update at its own slot within it. Without them the window starts on reception */
+#define OTA_ROLLOUT_URL_SIZE	256
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef enum
+{
+	BITEC_OTA_ROLLOUT_IDLE = 0,
+	BITEC_OTA_ROLLOUT_SCHEDULED,	/*!< Waiting for its slot */
+	BITEC_OTA_ROLLOUT_DEFERRED,		/*!< Waiting again, the conditions did not allow the update */
+	BITEC_OTA_ROLLOUT_DOWNLOADING,
+	BITEC_OTA_ROLLOUT_READY,		/*!< Verified and set to boot, waiting for a restart */
+	BITEC_OTA_ROLLOUT_FAILED,
+	BITEC_OTA_ROLLOUT_CURRENT,		/*!< The version is the running one */
+	BITEC_OTA_ROLLOUT_EXPIRED,		/*!< Deferred too many times */
+	BITEC_OTA_ROLLOUT_MAX
+} bitec_ota_rollout_state_e;
+
+typedef struct bitec_ota_rollout bitec_ota_rollout_t;
+
+/* Called on every state change and every progress step of a download */
+typedef void (* bitec_ota_rollout_report_t)(const bitec_ota_rollout_t * const me, void * arg);
+
+struct bitec_ota_rollout
+{
+	/* Configuration, set from Kconfig by bitec_ota_rollout_init() */
+	uint32_t window;			/*!< Window in s of descriptors without one */
+	uint32_t defer_time;		/*!< Mean wait in ms before the conditions are checked again */
+	uint32_t defer_max;			/*!< Deferrals before the rollout is given up */
+	uint8_t progress_step;		/*!< Download progress reported in steps of this percent */
+	bitec_ota_rollout_report_t report;	/*!< NULL for none */
+	void * arg;					/*!< Of report */
+
+	/* Descriptor */
+	char version[OTA_IMAGE_VERSION_SIZE + 1];
+	char url[OTA_ROLLOUT_URL_SIZE];
+	char patch[OTA_ROLLOUT_URL_SIZE];	/*!< Empty without a patch */
+	uint8_t digest[OTA_IMAGE_DIGEST_SIZE];
+	int64_t start;				/*!< Window in unix time in s, if window_set */
+	int64_t end;
+	bool window_set;
+
+	/* State */
+	bitec_ota_rollout_state_e state;
+	uint32_t wait;				/*!< Time in ms to wait before bitec_ota_rollout_check() */
+	uint32_t random;			/*!< Jitter of the deferrals, seeded from the device */
+	uint32_t defers;
+	uint8_t progress;			/*!< Download progress in percent, in steps */
+	esp_err_t error;
+};
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Set the configuration from Kconfig and clear the state, it can be changed afterwards */
+void bitec_ota_rollout_init(bitec_ota_rollout_t * const me);
+
+/* Take a descriptor of len bytes. Returns ESP_ERR_INVALID_ARG for a malformed one and
+ * ESP_ERR_INVALID_STATE for the one already taken, delivered again, or while downloading */
+esp_err_t bitec_ota_rollout_parse(bitec_ota_rollout_t * const me, const char * data, size_t len);
+
+/* Pick the slot of the device in the window, from a hash of its id and the version, so it is the same
+ * every time the descriptor is delivered and spread evenly over the fleet. now is the unix time in
+ * ms, negative while the clock is not set. A window already started is spread over what is left of
+ * it, a window already over or an unknown time starts it now. Sets wait, nothing is waited for if
+ * running is the descriptor version */
+void bitec_ota_rollout_schedule(bitec_ota_rollout_t * const me, const char * id, const char * running, int64_t now);
+
+/* Once wait is over, take ready, whether the load and the power allow an update now. Returns true to
+ * update, otherwise the rollout is deferred by about defer_time and wait is set again */
+bool bitec_ota_rollout_check(bitec_ota_rollout_t * const me, bool ready);
+
+/* Update to the descriptor image, from the patch if there is one and it applies to the running image.
+ * A download the server turns away or that does not get through is deferred as by
+ * bitec_ota_rollout_check() */
+esp_err_t bitec_ota_rollout_update(bitec_ota_rollout_t * const me, bitec_ota_t * const ota);
+
+/* Take the result of an update allowed by bitec_ota_rollout_check(), as bitec_ota_rollout_update()
+ * does. For updates run some other way, ESP_FAIL defers the rollout */
+void bitec_ota_rollout_end(bitec_ota_rollout_t * const me, esp_err_t ret);
+
+/* Name of a state in the reports */
+const char * bitec_ota_rollout_name(bitec_ota_rollout_state_e state);
+
+/* Print the state as JSON. Returns its length or -1 if it does not fit */
+int bitec_ota_rollout_print(const bitec_ota_rollout_t * const me, char * buf, size_t size);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_OTA_ROLLOUT_H_ */
@@ -0,0 +1,509 @@
+/*
+ * bitec_ota_diff.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ *
+ * Patches in the way of bsdiff: the old image is suffix sorted, the new one
+ * is matched against it allowing mismatches, so code moved by a few bytes
+ * becomes a run of small differences, and bytes not found are inserted. The
+ * records are then compressed with LZSS in a window the device can afford.
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bitec_ota_diff.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define WINDOW_MASK			(OTA_DELTA_WINDOW_SIZE - 1)
+#define MATCH_LONG			15			/*!< Length code followed by a varint */
+#define HASH_BITS			16
+#define CHAIN_MAX			64			/*!< Candidates tried per position */
+#define MATCH_NICE			1024		/*!< A match this long ends the search */
+#define MISMATCH_MAX		8			/*!< Bytes a new exact match must win by to start a record */
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef struct
+{
+	uint8_t * data;
+	size_t len;
+	size_t size;
+	bool failed;			/*!< An allocation failed */
+} buffer_t;
+
+/* internal data declaration -------------------------------------------------*/
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static int32_t * suffix_sort(const uint8_t * data, int32_t size);
+static uint32_t search(const int32_t * sa, const uint8_t * old, uint32_t old_size, const uint8_t * new,
+		uint32_t new_size, uint32_t * pos);
+static uint32_t match_len(const uint8_t * a, uint32_t a_size, const uint8_t * b, uint32_t b_size);
+static void records(const int32_t * sa, const uint8_t * old, uint32_t old_size, const uint8_t * new,
+		uint32_t new_size, buffer_t * raw);
+static void compress(const uint8_t * data, size_t size, buffer_t * out);
+static void put_byte(buffer_t * buf, uint8_t byte);
+static void put_varint(buffer_t * buf, uint32_t value);
+static void put_le32(buffer_t * buf, uint32_t value);
+static void put_digest(buffer_t * buf, const uint8_t * data, uint32_t size);
+
+/* external functions definition ---------------------------------------------*/
+
+esp_err_t bitec_ota_diff(const uint8_t * old, uint32_t old_size, const uint8_t * new, uint32_t new_size,
+		uint8_t ** patch, size_t * patch_size)
+{
+	buffer_t raw = { 0 };
+	buffer_t out = { 0 };
+	int32_t * sa = NULL;
+
+	if(new_size == 0 || old_size > INT32_MAX)
+		return ESP_ERR_INVALID_SIZE;
+
+	if(old_size > 0)
+	{
+		sa = suffix_sort(old, old_size);
+
+		if(sa == NULL)
+			return ESP_ERR_NO_MEM;
+	}
+
+	records(sa, old, old_size, new, new_size, &raw);
+	free(sa);
+
+	put_byte(&out, OTA_DELTA_MAGIC[0]);
+	put_byte(&out, OTA_DELTA_MAGIC[1]);
+	put_byte(&out, OTA_DELTA_MAGIC[2]);
+	put_byte(&out, OTA_DELTA_MAGIC[3]);
+	put_byte(&out, OTA_DELTA_VERSION);
+	put_byte(&out, OTA_DELTA_WINDOW_BITS);
+	put_byte(&out, 0);
+	put_byte(&out, 0);
+	put_le32(&out, old_size);
+	put_le32(&out, new_size);
+	put_digest(&out, old, old_size);
+	put_digest(&out, new, new_size);
+
+	if(!raw.failed)
+		compress(raw.data, raw.len, &out);
+
+	free(raw.data);
+
+	if(raw.failed || out.failed)
+	{
+		free(out.data);
+		return ESP_ERR_NO_MEM;
+	}
+
+	* patch = out.data;
+	* patch_size = out.len;
+
+	return ESP_OK;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* Prefix doubling with counting sorts, ranks of the first k bytes become ranks of the first 2k */
+static int32_t * suffix_sort(const uint8_t * data, int32_t size)
+{
+	int32_t * sa = malloc(size * sizeof(int32_t));
+	int32_t * rank = malloc(size * sizeof(int32_t));
+	int32_t * tmp = malloc(size * sizeof(int32_t));
+	int32_t * count = malloc((size > 256 ? size : 256) * sizeof(int32_t));
+	int32_t classes = 256;
+
+	if(sa == NULL || rank == NULL || tmp == NULL || count == NULL)
+	{
+		free(sa);
+		sa = NULL;
+		goto end;
+	}
+
+	memset(count, 0, 256 * sizeof(int32_t));
+
+	for(int32_t i = 0; i < size; i++)
+	{
+		rank[i] = data[i];
+		count[data[i]]++;
+	}
+
+	for(int32_t i = 1; i < 256; i++)
+		count[i] += count[i - 1];
+
+	for(int32_t i = size - 1; i >= 0; i--)
+		sa[--count[data[i]]] = i;
+
+	for(int32_t k = 1; k < size; k <<= 1)
+	{
+		int32_t n = 0;
+
+		/* By the second key, suffixes shorter than k first */
+		for(int32_t i = size - k; i < size; i++)
+			tmp[n++] = i;
+
+		for(int32_t i = 0; i < size; i++)
+		{
+			if(sa[i] >= k)
+				tmp[n++] = sa[i] - k;
+		}
+
+		/* Then stable by the first one */
+		memset(count, 0, classes * sizeof(int32_t));
+
+		for(int32_t i = 0; i < size; i++)
+			count[rank[i]]++;
+
+		for(int32_t i = 1; i < classes; i++)
+			count[i] += count[i - 1];
+
+		for(int32_t i = size - 1; i >= 0; i--)
+			sa[--count[rank[tmp[i]]]] = tmp[i];
+
+		tmp[sa[0]] = 0;
+		classes = 1;
+
+		for(int32_t i = 1; i < size; i++)
+		{
+			int32_t a = sa[i - 1];
+			int32_t b = sa[i];
+			bool same = rank[a] == rank[b] && (a + k < size ? rank[a + k] : -1) == (b + k < size ? rank[b + k] : -1);
+
+			tmp[b] = same ? classes - 1 : classes++;
+		}
+
+		int32_t * swap = rank;
+		rank = tmp;
+		tmp = swap;
+
+		if(classes == size)
+			break;
+	}
+
+end:
+	free(rank);
+	free(tmp);
+	free(count);
+
+	return sa;
+}
+
+/* Longest exact match of new in old, by binary search of the sorted suffixes */
+static uint32_t search(const int32_t * sa, const uint8_t * old, uint32_t old_size, const uint8_t * new,
+		uint32_t new_size, uint32_t * pos)
+{
+	uint32_t st = 0;
+	uint32_t en = old_size - 1;
+
+	if(old_size == 0)
+	{
+		* pos = 0;
+		return 0;
+	}
+
+	while(en - st >= 2)
+	{
+		uint32_t x = st + (en - st) / 2;
+		uint32_t n = old_size - sa[x] < new_size ? old_size - sa[x] : new_size;
+
+		if(memcmp(old + sa[x], new, n) < 0)
+			st = x;
+		else
+			en = x;
+	}
+
+	uint32_t x = match_len(old + sa[st], old_size - sa[st], new, new_size);
+	uint32_t y = match_len(old + sa[en], old_size - sa[en], new, new_size);
+
+	* pos = x > y ? sa[st] : sa[en];
+
+	return x > y ? x : y;
+}
+
+static uint32_t match_len(const uint8_t * a, uint32_t a_size, const uint8_t * b, uint32_t b_size)
+{
+	uint32_t i = 0;
+
+	while(i < a_size && i < b_size && a[i] == b[i])
+		i++;
+
+	return i;
+}
+
+/* The bsdiff scan, a record ends where an exact match beats the current alignment by enough */
+static void records(const int32_t * sa, const uint8_t * old, uint32_t old_size, const uint8_t * new,
+		uint32_t new_size, buffer_t * raw)
+{
+	uint32_t scan = 0;
+	uint32_t len = 0;
+	uint32_t pos = 0;
+	uint32_t last_scan = 0;
+	uint32_t last_pos = 0;
+	int64_t last_offset = 0;
+
+	while(scan < new_size)
+	{
+		uint32_t old_score = 0;
+		uint32_t sc;
+
+		for(sc = scan += len; scan < new_size; scan++)
+		{
+			len = search(sa, old, old_size, new + scan, new_size - scan, &pos);
+
+			for(; sc < scan + len; sc++)
+			{
+				if(sc + last_offset < old_size && old[sc + last_offset] == new[sc])
+					old_score++;
+			}
+
+			if((len == old_score && len != 0) || len > old_score + MISMATCH_MAX)
+				break;
+
+			if(scan + last_offset < old_size && old[scan + last_offset] == new[scan])
+				old_score--;
+		}
+
+		if(len == old_score && scan != new_size)
+			continue;
+
+		/* Extend the last alignment forwards and the new one backwards while half the bytes match */
+		int64_t s = 0;
+		int64_t best = 0;
+		uint32_t len_f = 0;
+
+		for(uint32_t i = 0; last_scan + i < scan && last_pos + i < old_size;)
+		{
+			if(old[last_pos + i] == new[last_scan + i])
+				s++;
+
+			i++;
+
+			if(s * 2 - i > best * 2 - len_f)
+			{
+				best = s;
+				len_f = i;
+			}
+		}
+
+		uint32_t len_b = 0;
+
+		if(scan < new_size)
+		{
+			s = 0;
+			best = 0;
+
+			for(uint32_t i = 1; scan >= last_scan + i && pos >= i; i++)
+			{
+				if(old[pos - i] == new[scan - i])
+					s++;
+
+				if(s * 2 - i > best * 2 - len_b)
+				{
+					best = s;
+					len_b = i;
+				}
+			}
+		}
+
+		/* Split an overlap where it keeps the most matching bytes */
+		if(last_scan + len_f > scan - len_b)
+		{
+			uint32_t overlap = (last_scan + len_f) - (scan - len_b);
+			uint32_t len_s = 0;
+
+			s = 0;
+			best = 0;
+
+			for(uint32_t i = 0; i < overlap; i++)
+			{
+				if(new[last_scan + len_f - overlap + i] == old[last_pos + len_f - overlap + i])
+					s++;
+
+				if(new[scan - len_b + i] == old[pos - len_b + i])
+					s--;
+
+				if(s > best)
+				{
+					best = s;
+					len_s = i + 1;
+				}
+			}
+
+			len_f += len_s - overlap;
+			len_b -= len_s;
+		}
+
+		uint32_t insert = (scan - len_b) - (last_scan + len_f);
+		int32_t move = (int32_t)((int64_t)(pos - len_b) - (last_pos + len_f));
+
+		put_varint(raw, len_f);
+		put_varint(raw, insert);
+		put_varint(raw, ((uint32_t)move << 1) ^ (uint32_t)(move >> 31));
+
+		for(uint32_t i = 0; i < len_f; i++)
+			put_byte(raw, new[last_scan + i] - old[last_pos + i]);
+
+		for(uint32_t i = 0; i < insert; i++)
+			put_byte(raw, new[last_scan + len_f + i]);
+
+		last_scan = scan - len_b;
+		last_pos = pos - len_b;
+		last_offset = (int64_t)pos - scan;
+	}
+}
+
+/* Greedy LZSS with hash chains, long matches such as runs of unchanged bytes end in a varint */
+static void compress(const uint8_t * data, size_t size, buffer_t * out)
+{
+	int32_t * head = malloc((1 << HASH_BITS) * sizeof(int32_t));
+	int32_t * prev = malloc(OTA_DELTA_WINDOW_SIZE * sizeof(int32_t));
+	size_t flags = 0;
+	uint8_t items = 8;
+
+	if(head == NULL || prev == NULL)
+	{
+		out->failed = true;
+		goto end;
+	}
+
+	memset(head, 0xFF, (1 << HASH_BITS) * sizeof(int32_t));
+
+	for(size_t i = 0; i < size;)
+	{
+		size_t best_len = 0;
+		size_t best_dist = 0;
+
+		if(i + OTA_DELTA_MATCH_MIN <= size)
+		{
+			uint32_t h = ((data[i] << 16 | data[i + 1] << 8 | data[i + 2]) * 2654435761u) >> (32 - HASH_BITS);
+			int32_t p = head[h];
+
+			/* Chains are cut where they leave the window or were overwritten by a newer position */
+			for(int depth = 0; p >= 0 && i - p <= OTA_DELTA_WINDOW_SIZE && depth < CHAIN_MAX; depth++)
+			{
+				size_t n = 0;
+
+				while(i + n < size && data[p + n] == data[i + n])
+					n++;
+
+				if(n > best_len)
+				{
+					best_len = n;
+					best_dist = i - p;
+
+					if(n >= MATCH_NICE)
+						break;
+				}
+
+				int32_t next = prev[p & WINDOW_MASK];
+
+				if(next >= p)
+					break;
+
+				p = next;
+			}
+		}
+
+		if(items == 8)
+		{
+			flags = out->len;
+			put_byte(out, 0);
+			items = 0;
+		}
+
+		if(best_len < OTA_DELTA_MATCH_MIN)
+			best_len = 1;
+		else
+		{
+			size_t code = best_len - OTA_DELTA_MATCH_MIN < MATCH_LONG ? best_len - OTA_DELTA_MATCH_MIN : MATCH_LONG;
+
+			if(!out->failed)
+				out->data[flags] |= 1 << items;
+
+			put_byte(out, (best_dist - 1) & 0xFF);
+			put_byte(out, ((best_dist - 1) >> 8) << 4 | code);
+
+			if(code == MATCH_LONG)
+				put_varint(out, best_len - MATCH_LONG - OTA_DELTA_MATCH_MIN);
+		}
+
+		if(best_len == 1)
+			put_byte(out, data[i]);
+
+		items++;
+
+		for(size_t end = i + best_len; i < end; i++)
+		{
+			if(i + OTA_DELTA_MATCH_MIN <= size)
+			{
+				uint32_t h = ((data[i] << 16 | data[i + 1] << 8 | data[i + 2]) * 2654435761u) >> (32 - HASH_BITS);
+				prev[i & WINDOW_MASK] = head[h];
+				head[h] = i;
+			}
+		}
+	}
+
+end:
+	free(head);
+	free(prev);
+}
+
+static void put_byte(buffer_t * buf, uint8_t byte)
+{
+	if(buf->failed)
+		return;
+
+	if(buf->len == buf->size)
+	{
+		size_t size = buf->size > 0 ? buf->size * 2 : 4096;
+		uint8_t * data = realloc(buf->data, size);
+
+		if(data == NULL)
+		{
+			buf->failed = true;
+			return;
+		}
+
+		buf->data = data;
+		buf->size = size;
+	}
+
+	buf->data[buf->len++] = byte;
+}
+
+static void put_varint(buffer_t * buf, uint32_t value)
+{
+	while(value >= 0x80)
+	{
+		put_byte(buf, (value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+
+	put_byte(buf, value);
+}
+
+static void put_le32(buffer_t * buf, uint32_t value)
+{
+	for(int i = 0; i < 4; i++)
+		put_byte(buf, (uint8_t)(value >> (8 * i)));
+}
+
+static void put_digest(buffer_t * buf, const uint8_t * data, uint32_t size)
+{
+	bitec_ota_sha256_t sha;
+	uint8_t digest[OTA_IMAGE_DIGEST_SIZE];
+
+	bitec_ota_sha256_init(&sha);
+	bitec_ota_sha256_update(&sha, data, size);
+	bitec_ota_sha256_finish(&sha, digest);
+
+	for(size_t i = 0; i < sizeof(digest); i++)
+		put_byte(buf, digest[i]);
+}
+
+/* end of file ---------------------------------------------------------------*/
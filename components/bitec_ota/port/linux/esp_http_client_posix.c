@@ -0,0 +1,313 @@
+/*
+ * esp_http_client_posix.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "esp_http_client.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define HOST_SIZE			64			/*!< Maximum host name size in bytes */
+#define PATH_SIZE			256			/*!< Maximum path and query size in bytes */
+#define HEADERS_SIZE		256			/*!< Extra request headers in bytes */
+#define BUFFER_SIZE			512			/*!< ESP-IDF default buffer size */
+#define TIMEOUT				5000		/*!< ESP-IDF default timeout in ms */
+#define HTTP_PORT			"80"
+
+/* typedef -------------------------------------------------------------------*/
+
+struct esp_http_client
+{
+	char host[HOST_SIZE];
+	char port[8];
+	char path[PATH_SIZE];
+	char headers[HEADERS_SIZE];	/*!< Set by esp_http_client_set_header(), one line each */
+	int timeout_ms;
+	int fd;
+	int status;
+	int64_t content_length;		/*!< -1 while unknown */
+	int64_t received;
+	char * buffer;				/*!< Headers, then the body bytes read along with them */
+	int buffer_size;
+	int buffer_len;
+	int buffer_pos;
+};
+
+/* internal data declaration -------------------------------------------------*/
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static esp_err_t parse_url(esp_http_client_handle_t client, const char * url);
+static bool send_all(int fd, const char * data, size_t len);
+
+/* external functions definition ---------------------------------------------*/
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t * config)
+{
+	esp_http_client_handle_t client = calloc(1, sizeof(struct esp_http_client));
+
+	if(client == NULL)
+		return NULL;
+
+	client->fd = -1;
+	client->timeout_ms = config->timeout_ms > 0 ? config->timeout_ms : TIMEOUT;
+	client->buffer_size = config->buffer_size > 0 ? config->buffer_size : BUFFER_SIZE;
+	client->buffer = malloc(client->buffer_size);
+
+	/* There is no TLS on the host, https:// is refused */
+	if(client->buffer == NULL || parse_url(client, config->url) != ESP_OK)
+	{
+		free(client->buffer);
+		free(client);
+		return NULL;
+	}
+
+	return client;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char * key, const char * value)
+{
+	char * line = client->headers;
+	size_t key_len = strlen(key);
+
+	/* Replace a header set before */
+	while(* line != '\0')
+	{
+		char * end = strstr(line, "\r\n") + 2;
+
+		if(!strncasecmp(line, key, key_len) && line[key_len] == ':')
+			memmove(line, end, strlen(end) + 1);
+		else
+			line = end;
+	}
+
+	size_t len = strlen(client->headers);
+	int ret = snprintf(client->headers + len, sizeof(client->headers) - len, "%s: %s\r\n", key, value);
+
+	if(ret < 0 || (size_t)ret >= sizeof(client->headers) - len)
+	{
+		client->headers[len] = '\0';
+		return ESP_ERR_NO_MEM;
+	}
+
+	return ESP_OK;
+}
+
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len)
+{
+	struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+	struct addrinfo * addr;
+
+	esp_http_client_close(client);
+
+	if(getaddrinfo(client->host, client->port, &hints, &addr) != 0)
+		return ESP_FAIL;
+
+	client->fd = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+
+	if(client->fd < 0 || connect(client->fd, addr->ai_addr, addr->ai_addrlen) != 0)
+	{
+		freeaddrinfo(addr);
+		esp_http_client_close(client);
+		return ESP_FAIL;
+	}
+
+	freeaddrinfo(addr);
+
+	struct timeval timeout = { .tv_sec = client->timeout_ms / 1000, .tv_usec = (client->timeout_ms % 1000) * 1000 };
+	setsockopt(client->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(client->fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+	char request[HOST_SIZE + PATH_SIZE + HEADERS_SIZE + 64];
+	int len = snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: %s\r\n%sConnection: close\r\n\r\n",
+			client->path, client->host, client->headers);
+
+	if(!send_all(client->fd, request, len))
+	{
+		esp_http_client_close(client);
+		return ESP_FAIL;
+	}
+
+	return ESP_OK;
+}
+
+int esp_http_client_fetch_headers(esp_http_client_handle_t client)
+{
+	char * end = NULL;
+
+	client->buffer_len = 0;
+
+	/* Read until the blank line, the body bytes after it are kept for esp_http_client_read() */
+	while(end == NULL)
+	{
+		if(client->fd < 0 || client->buffer_len == client->buffer_size - 1)
+			return ESP_FAIL;
+
+		ssize_t n = recv(client->fd, client->buffer + client->buffer_len, client->buffer_size - 1 - client->buffer_len, 0);
+
+		if(n <= 0)
+			return ESP_FAIL;
+
+		client->buffer_len += n;
+		client->buffer[client->buffer_len] = '\0';
+		end = strstr(client->buffer, "\r\n\r\n");
+	}
+
+	client->buffer_pos = end + 4 - client->buffer;
+	client->content_length = -1;
+	client->received = 0;
+
+	if(sscanf(client->buffer, "HTTP/%*d.%*d %d", &client->status) != 1)
+		return ESP_FAIL;
+
+	for(char * line = strstr(client->buffer, "\r\n"); line != NULL && line < end; line = strstr(line + 2, "\r\n"))
+	{
+		if(!strncasecmp(line + 2, "Content-Length:", 15))
+			client->content_length = strtoll(line + 17, NULL, 10);
+	}
+
+	return client->content_length > 0 ? (int)client->content_length : 0;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client)
+{
+	return client->status;
+}
+
+int esp_http_client_read(esp_http_client_handle_t client, char * buffer, int len)
+{
+	int total = 0;
+
+	if(client->content_length >= 0 && len > client->content_length - client->received)
+		len = client->content_length - client->received;
+
+	/* Body bytes read with the headers first */
+	if(client->buffer_pos < client->buffer_len)
+	{
+		int n = client->buffer_len - client->buffer_pos < len ? client->buffer_len - client->buffer_pos : len;
+		memcpy(buffer, client->buffer + client->buffer_pos, n);
+		client->buffer_pos += n;
+		total = n;
+	}
+
+	while(total < len)
+	{
+		if(client->fd < 0)
+			return -1;
+
+		ssize_t n = recv(client->fd, buffer + total, len - total, 0);
+
+		if(n < 0)
+			return -1;
+
+		if(n == 0)
+			break;
+
+		total += n;
+	}
+
+	client->received += total;
+
+	return total;
+}
+
+bool esp_http_client_is_complete_data_received(esp_http_client_handle_t client)
+{
+	return client->content_length >= 0 && client->received == client->content_length;
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client)
+{
+	if(client->fd >= 0)
+		close(client->fd);
+
+	client->fd = -1;
+	client->buffer_len = 0;
+	client->buffer_pos = 0;
+
+	return ESP_OK;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
+{
+	if(client == NULL)
+		return ESP_FAIL;
+
+	esp_http_client_close(client);
+	free(client->buffer);
+	free(client);
+
+	return ESP_OK;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static esp_err_t parse_url(esp_http_client_handle_t client, const char * url)
+{
+	const char * scheme = "http://";
+
+	if(url == NULL || strncmp(url, scheme, strlen(scheme)))
+		return ESP_ERR_NOT_SUPPORTED;
+
+	const char * host = url + strlen(scheme);
+	const char * path = strchr(host, '/');
+	const char * port = memchr(host, ':', path != NULL ? (size_t)(path - host) : strlen(host));
+	size_t host_len = port != NULL ? (size_t)(port - host) : path != NULL ? (size_t)(path - host) : strlen(host);
+
+	if(host_len == 0 || host_len >= sizeof(client->host))
+		return ESP_ERR_INVALID_ARG;
+
+	memcpy(client->host, host, host_len);
+	client->host[host_len] = '\0';
+
+	if(port != NULL)
+	{
+		size_t port_len = (path != NULL ? (size_t)(path - port) : strlen(port)) - 1;
+
+		if(port_len == 0 || port_len >= sizeof(client->port))
+			return ESP_ERR_INVALID_ARG;
+
+		memcpy(client->port, port + 1, port_len);
+		client->port[port_len] = '\0';
+	}
+	else
+		strcpy(client->port, HTTP_PORT);
+
+	if(snprintf(client->path, sizeof(client->path), "%s", path != NULL ? path : "/") >= (int)sizeof(client->path))
+		return ESP_ERR_INVALID_ARG;
+
+	return ESP_OK;
+}
+
+static bool send_all(int fd, const char * data, size_t len)
+{
+	while(len > 0)
+	{
+		ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+
+		if(n <= 0)
+			return false;
+
+		data += n;
+		len -= n;
+	}
+
+	return true;
+}
+
+/* end of file ---------------------------------------------------------------*/
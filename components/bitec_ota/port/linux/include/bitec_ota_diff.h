@@ -0,0 +1,48 @@
+/*
+ * bitec_ota_diff.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_OTA_DIFF_H_
+#define _BITEC_OTA_DIFF_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+#include "bitec_ota_delta.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Build the patch turning old into new, as bitec_ota_delta_feed() applies it. Host only, it takes
+ * about 16 bytes of memory per byte of the old image. The patch is allocated, the caller frees it */
+esp_err_t bitec_ota_diff(const uint8_t * old, uint32_t old_size, const uint8_t * new, uint32_t new_size,
+		uint8_t ** patch, size_t * patch_size);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_OTA_DIFF_H_ */
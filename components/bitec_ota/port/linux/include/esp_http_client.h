@@ -0,0 +1,69 @@
+/*
+ * esp_http_client.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ *
+ * POSIX sockets stand-in of the ESP-IDF HTTP client for host builds. It keeps
+ * the subset of the API used by the firmware for plain http:// GET requests,
+ * one per connection, so updates can be run against a local server.
+ */
+
+#ifndef _ESP_HTTP_CLIENT_H_
+#define _ESP_HTTP_CLIENT_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef struct esp_http_client * esp_http_client_handle_t;
+
+typedef struct
+{
+	const char * url;
+	int timeout_ms;
+	int buffer_size;			/*!< Receive buffer, the response headers must fit in it */
+} esp_http_client_config_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t * config);
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char * key, const char * value);
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len);
+
+/* Returns the content length, 0 if there is none and ESP_FAIL on error */
+int esp_http_client_fetch_headers(esp_http_client_handle_t client);
+int esp_http_client_get_status_code(esp_http_client_handle_t client);
+
+/* Fill the buffer unless the body ends first. Returns the bytes read, 0 at the end and -1 on error */
+int esp_http_client_read(esp_http_client_handle_t client, char * buffer, int len);
+bool esp_http_client_is_complete_data_received(esp_http_client_handle_t client);
+esp_err_t esp_http_client_close(esp_http_client_handle_t client);
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _ESP_HTTP_CLIENT_H_ */
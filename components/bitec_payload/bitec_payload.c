@@ -0,0 +1,71 @@
+/*
+ * bitec_payload.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include "include/bitec_payload.h"
+#include "cJSON.h"
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+/* external functions definition ---------------------------------------------*/
+
+int bitec_payload_adc_average(int channel, uint16_t samples)
+{
+	int32_t sum = 0;
+
+	if(samples == 0)
+		return 0;
+
+	for(uint16_t i = 0; i < samples; i++)
+		sum += hal_adc_read(channel);
+
+	return sum / samples;
+}
+
+char * bitec_payload_print(const char * device, const bitec_payload_t * const payload)
+{
+	char * string = NULL;
+	cJSON * data = cJSON_CreateObject();
+
+	if(data == NULL)
+		return NULL;
+
+	cJSON * object = NULL;
+
+	/* Every add returns NULL when out of memory, the whole message is dropped then */
+	if(cJSON_AddStringToObject(data, "device", device) != NULL &&
+			((payload->time >= 0) ? cJSON_AddNumberToObject(data, "time", payload->time) : cJSON_AddNullToObject(data, "time")) != NULL &&
+			(object = cJSON_AddObjectToObject(data, "payload")) != NULL &&
+			cJSON_AddNumberToObject(object, "light", payload->light) != NULL &&
+			cJSON_AddNumberToObject(object, "illumination", payload->illumination) != NULL &&
+			cJSON_AddNumberToObject(object, "presence", payload->presence) != NULL &&
+			cJSON_AddNumberToObject(object, "voltage", payload->voltage) != NULL &&
+			cJSON_AddNumberToObject(object, "current", payload->current) != NULL &&
+			cJSON_AddNumberToObject(object, "power", payload->power) != NULL &&
+			cJSON_AddNumberToObject(object, "active", payload->active) != NULL &&
+			cJSON_AddNumberToObject(object, "pf", payload->power_factor) != NULL &&
+			cJSON_AddNumberToObject(object, "confidence", payload->confidence) != NULL &&
+			cJSON_AddNumberToObject(object, "energy", payload->energy) != NULL)
+		string = cJSON_Print(data);
+
+	cJSON_Delete(data);
+
+	return string;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,65 @@
+/*
+ * bitec_payload.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_PAYLOAD_H_
+#define _BITEC_PAYLOAD_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "bitec_hal.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef struct
+{
+	int64_t time;		/*!< Unix time of the readings in ms, -1 while the clock is not synced */
+	bool light;			/*!< Relay state */
+	int illumination;	/*!< Averaged light sensor reading */
+	bool presence;		/*!< PIR sensor state */
+	float voltage;		/*!< Mains RMS voltage in V */
+	float current;		/*!< Load RMS current in A */
+	float power;		/*!< Apparent power in VA */
+	float active;		/*!< Active power in W */
+	float power_factor;	/*!< 0 to 1 */
+	float confidence;	/*!< Of the power factor, 0 to 1 */
+	double energy;		/*!< Total of every tariff in Wh */
+} bitec_payload_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Average of samples consecutive readings of an ADC channel */
+int bitec_payload_adc_average(int channel, uint16_t samples);
+
+/* Status message of a device as JSON, the time null while not known. NULL if out of memory. Free it
+ * with cJSON_free() */
+char * bitec_payload_print(const char * device, const bitec_payload_t * const payload);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_PAYLOAD_H_ */
@@ -0,0 +1,411 @@
+/*
+ * bitec_relay.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "include/bitec_relay.h"
+#include "esp_log.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define SWITCH_MARGIN		500			/*!< Time in us for the switch timer to start */
+#define FEEDBACK_TIMEOUT	100			/*!< Maximum wait for the contacts in ms while calibrating */
+#define CALIBRATE_DWELL		500			/*!< Time in ms between switches while calibrating */
+#define CALIBRATE_SHIFT		2			/*!< Weight of a new actuation time outside a calibration, 1/4 */
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static const char * TAG = "bitec_relay";
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static void update(bitec_relay_t * const me);
+static void relay_switch(bitec_relay_t * const me, bool level);
+static void dwell_timer(TimerHandle_t timer);
+static void switch_timer(void * arg);
+static void zc_isr(void * arg);
+static void sense_isr(void * arg);
+static uint32_t now_ms(void);
+
+/* external functions definition ---------------------------------------------*/
+
+esp_err_t bitec_relay_init(bitec_relay_t * const me)
+{
+	esp_err_t ret;
+
+	ESP_LOGI(TAG, "Initializing relay...");
+
+	me->mutex = xSemaphoreCreateMutex();
+
+	if(me->mutex == NULL)
+		return ESP_ERR_NO_MEM;
+
+	/* The period is set on every start */
+	me->timer = xTimerCreate("Relay Timer", 1, pdFALSE, (void *)me, dwell_timer);
+
+	if(me->timer == NULL)
+		return ESP_ERR_NO_MEM;
+
+	ret = hal_gpio_config_output(1ULL << me->pin);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	me->logic.dark_level = CONFIG_BITEC_RELAY_DARK_LEVEL;
+	me->logic.bright_level = CONFIG_BITEC_RELAY_BRIGHT_LEVEL;
+	me->logic.min_on_time = CONFIG_BITEC_RELAY_MIN_ON_TIME;
+	me->logic.min_off_time = CONFIG_BITEC_RELAY_MIN_OFF_TIME;
+	me->logic.hold_time = CONFIG_BITEC_RELAY_HOLD_TIME;
+	me->logic.trip_time = CONFIG_BITEC_RELAY_TRIP_TIME;
+	bitec_relay_logic_init(&me->logic, now_ms());
+
+	/* Initialize zero crossing switching */
+	bitec_zc_init(&me->zc, CONFIG_BITEC_RELAY_MAINS_FREQUENCY);
+	me->operate_time = CONFIG_BITEC_RELAY_OPERATE_TIME;
+	me->release_time = CONFIG_BITEC_RELAY_RELEASE_TIME;
+	me->level = false;
+	me->in_flight = false;
+	me->calibrating = false;
+	me->phase_sum = 0;
+	memset(&me->phase_error, 0, sizeof(me->phase_error));
+	portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+	me->lock = lock;
+
+	ret = hal_gpio_set_level(me->pin, 0);
+
+	if(ret != ESP_OK || me->zc_pin < 0)
+		return ret;
+
+	ret = hal_timer_create(switch_timer, (void *)me, &me->switch_timer);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	ret = hal_gpio_config_input(1ULL << me->zc_pin, HAL_GPIO_PULL_NONE, HAL_GPIO_INTR_ANYEDGE);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	ret = hal_gpio_isr_add(me->zc_pin, zc_isr, (void *)me);
+
+	if(ret != ESP_OK || me->sense_pin < 0)
+		return ret;
+
+	me->feedback = xSemaphoreCreateBinary();
+
+	if(me->feedback == NULL)
+		return ESP_ERR_NO_MEM;
+
+	ret = hal_gpio_config_input(1ULL << me->sense_pin, HAL_GPIO_PULL_NONE, HAL_GPIO_INTR_ANYEDGE);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	return hal_gpio_isr_add(me->sense_pin, sense_isr, (void *)me);
+}
+
+void bitec_relay_set_presence(bitec_relay_t * const me, bool presence)
+{
+	xSemaphoreTake(me->mutex, portMAX_DELAY);
+	bitec_relay_logic_presence(&me->logic, presence, now_ms());
+	update(me);
+	xSemaphoreGive(me->mutex);
+}
+
+void bitec_relay_set_illumination(bitec_relay_t * const me, uint32_t illumination)
+{
+	xSemaphoreTake(me->mutex, portMAX_DELAY);
+	bitec_relay_logic_illumination(&me->logic, illumination);
+	update(me);
+	xSemaphoreGive(me->mutex);
+}
+
+void bitec_relay_set_force(bitec_relay_t * const me, int8_t force)
+{
+	xSemaphoreTake(me->mutex, portMAX_DELAY);
+
+	if(force != me->logic.force)
+	{
+		bitec_relay_logic_force(&me->logic, force);
+		update(me);
+	}
+
+	xSemaphoreGive(me->mutex);
+}
+
+void bitec_relay_trip(bitec_relay_t * const me)
+{
+	xSemaphoreTake(me->mutex, portMAX_DELAY);
+	bitec_relay_logic_trip(&me->logic, now_ms());
+	update(me);
+	xSemaphoreGive(me->mutex);
+
+	ESP_LOGW(TAG, "Relay tripped");
+}
+
+bool bitec_relay_get_state(bitec_relay_t * const me)
+{
+	return me->logic.output;
+}
+
+esp_err_t bitec_relay_calibrate(bitec_relay_t * const me, uint32_t cycles)
+{
+	uint32_t sums[2] = { 0, 0 };
+	esp_err_t ret = ESP_OK;
+
+	if(me->zc_pin < 0 || me->sense_pin < 0 || cycles == 0)
+		return ESP_ERR_NOT_SUPPORTED;
+
+	xSemaphoreTake(me->mutex, portMAX_DELAY);
+
+	if(me->calibrating)
+	{
+		xSemaphoreGive(me->mutex);
+		return ESP_ERR_INVALID_STATE;
+	}
+
+	/* The inputs keep updating the logic meanwhile, only its switches wait. The mutex is not held
+	 * through the waits below, nothing else switches the relay until the flag is cleared */
+	me->calibrating = true;
+	bool output = me->logic.output;
+	xSemaphoreGive(me->mutex);
+
+	/* Away from the state at the start and back, cycles times */
+	for(uint32_t i = 0; i < cycles * 2; i++)
+	{
+		bool level = (i % 2 == 0) != output;
+
+		if(!bitec_zc_locked(&me->zc, hal_time_us()))
+		{
+			ret = ESP_ERR_NOT_SUPPORTED;
+			break;
+		}
+
+		xSemaphoreTake(me->feedback, 0);
+		relay_switch(me, level);
+
+		if(xSemaphoreTake(me->feedback, pdMS_TO_TICKS(FEEDBACK_TIMEOUT)) != pdTRUE)
+		{
+			ret = ESP_ERR_TIMEOUT;
+			break;
+		}
+
+		sums[level] += me->measured;
+		vTaskDelay(pdMS_TO_TICKS(CALIBRATE_DWELL));
+	}
+
+	xSemaphoreTake(me->mutex, portMAX_DELAY);
+	me->calibrating = false;
+
+	/* The relay as the logic wants it now, a failed calibration may have left it anyhow and the
+	 * inputs may have changed */
+	if(ret != ESP_OK || me->level != me->logic.output)
+		relay_switch(me, me->logic.output);
+
+	if(ret == ESP_OK)
+	{
+		portENTER_CRITICAL(&me->lock);
+		me->release_time = sums[0] / cycles;
+		me->operate_time = sums[1] / cycles;
+		portEXIT_CRITICAL(&me->lock);
+
+		ESP_LOGI(TAG, "Calibrated, operate %" PRIu32 " us, release %" PRIu32 " us", me->operate_time, me->release_time);
+	}
+
+	xSemaphoreGive(me->mutex);
+
+	return ret;
+}
+
+int bitec_relay_print(bitec_relay_t * const me, char * buf, size_t size)
+{
+	int len;
+	int ret;
+
+	xSemaphoreTake(me->mutex, portMAX_DELAY);
+
+	/* On time up to now, not to the last switch */
+	uint64_t on_time = me->logic.on_time + (me->logic.output ? now_ms() - me->logic.update_time : 0);
+
+	len = snprintf(buf, size, "{\"state\":%d,\"switches\":%" PRIu32 ",\"deferred\":%" PRIu32 ",\"cancelled\":%" PRIu32 ",\"trips\":%" PRIu32 ",\"on_time\":%" PRIu32,
+			me->logic.output, me->logic.switches, me->logic.deferred, me->logic.cancelled, me->logic.trips, (uint32_t)(on_time / 1000));
+
+	xSemaphoreGive(me->mutex);
+
+	if(len < 0 || (size_t)len >= size)
+		return -1;
+
+	if(me->zc_pin >= 0)
+	{
+		/* Zero crossing switching, a bias away from 0 shows a wrong actuation time */
+		portENTER_CRITICAL(&me->lock);
+		bitec_latency_histogram_t histogram = me->phase_error;
+		int32_t bias = histogram.count ? (int32_t)(me->phase_sum / histogram.count) : 0;
+		uint32_t operate_time = me->operate_time;
+		uint32_t release_time = me->release_time;
+		portEXIT_CRITICAL(&me->lock);
+
+		ret = snprintf(buf + len, size - len, ",\"zc\":{\"locked\":%d,\"half_period\":%" PRIu32 ",\"rejected\":%" PRIu32 "},\"operate\":%" PRIu32 ",\"release\":%" PRIu32 ",\"phase_bias\":%" PRId32 ",\"phase_error\":",
+				bitec_zc_locked(&me->zc, hal_time_us()), me->zc.half_period, me->zc.rejected, operate_time, release_time, bias);
+
+		if(ret < 0 || (size_t)ret >= size - len)
+			return -1;
+
+		len += ret;
+		ret = bitec_latency_histogram_print(&histogram, buf + len, size - len);
+
+		if(ret < 0)
+			return -1;
+
+		len += ret;
+	}
+
+	ret = snprintf(buf + len, size - len, "}");
+
+	if(ret < 0 || (size_t)ret >= size - len)
+		return -1;
+
+	return len + ret;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* Called with the mutex taken */
+static void update(bitec_relay_t * const me)
+{
+	uint32_t wait;
+	uint32_t switches = me->logic.switches;
+	bool output = bitec_relay_logic_update(&me->logic, now_ms(), &wait);
+
+	if(me->logic.switches != switches)
+	{
+		ESP_LOGI(TAG, "Relay %s", output ? "on" : "off");
+
+		/* A calibration running switches it to this output when it ends */
+		if(!me->calibrating)
+			relay_switch(me, output);
+	}
+
+	if(wait == 0)
+	{
+		xTimerStop(me->timer, 0);
+		return;
+	}
+
+	/* Rounded up, an early expiry would only arm the timer again */
+	xTimerChangePeriod(me->timer, (wait + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS, 0);
+}
+
+static void relay_switch(bitec_relay_t * const me, bool level)
+{
+	int64_t now = hal_time_us();
+
+	me->level = level;
+
+	/* No mains reference, switch at once */
+	if(me->zc_pin < 0 || !bitec_zc_locked(&me->zc, now))
+	{
+		me->in_flight = false;
+		hal_gpio_set_level(me->pin, level);
+		return;
+	}
+
+	/* First crossing the contacts can reach, the GPIO changes the actuation time before it */
+	uint32_t actuation = level ? me->operate_time : me->release_time;
+
+	me->target_time = bitec_zc_next(&me->zc, now + actuation + SWITCH_MARGIN);
+	hal_timer_start(me->switch_timer, me->target_time - actuation - now);
+}
+
+static void dwell_timer(TimerHandle_t timer)
+{
+	bitec_relay_t * relay = (bitec_relay_t *)pvTimerGetTimerID(timer);
+
+	/* Never block the timer service task, with the mutex taken try again on the next tick */
+	if(xSemaphoreTake(relay->mutex, 0) != pdTRUE)
+	{
+		xTimerChangePeriod(timer, 1, 0);
+		return;
+	}
+
+	update(relay);
+	xSemaphoreGive(relay->mutex);
+}
+
+static void switch_timer(void * arg)
+{
+	bitec_relay_t * relay = (bitec_relay_t *)arg;
+	bool level = relay->level;
+
+	relay->fire_time = hal_time_us();
+	relay->in_flight = relay->sense_pin >= 0;
+	hal_gpio_set_level(relay->pin, level);
+
+	if(relay->sense_pin >= 0)
+		return;
+
+	/* No contacts feedback, only the timer lateness is known */
+	int32_t error = (int32_t)(relay->fire_time + (level ? relay->operate_time : relay->release_time) - relay->target_time);
+
+	portENTER_CRITICAL(&relay->lock);
+	bitec_latency_histogram_add(&relay->phase_error, error < 0 ? -error : error);
+	relay->phase_sum += error;
+	portEXIT_CRITICAL(&relay->lock);
+}
+
+static void zc_isr(void * arg)
+{
+	bitec_relay_t * relay = (bitec_relay_t *)arg;
+
+	bitec_zc_edge(&relay->zc, hal_time_us());
+}
+
+static void sense_isr(void * arg)
+{
+	bitec_relay_t * relay = (bitec_relay_t *)arg;
+	BaseType_t task_woken = pdFALSE;
+	int64_t now = hal_time_us();
+
+	/* Only the first edge after a switch, the next ones are contact bounces */
+	if(!relay->in_flight)
+		return;
+
+	relay->in_flight = false;
+
+	uint32_t measured = (uint32_t)(now - relay->fire_time);
+	int32_t error = (int32_t)(now - relay->target_time);
+
+	portENTER_CRITICAL_ISR(&relay->lock);
+	bitec_latency_histogram_add(&relay->phase_error, error < 0 ? -error : error);
+	relay->phase_sum += error;
+
+	/* Track the wear of the contacts between calibrations */
+	uint32_t * actuation = relay->level ? &relay->operate_time : &relay->release_time;
+	* actuation += (int32_t)(measured - * actuation) >> CALIBRATE_SHIFT;
+	portEXIT_CRITICAL_ISR(&relay->lock);
+
+	relay->measured = measured;
+	xSemaphoreGiveFromISR(relay->feedback, &task_woken);
+
+	if(task_woken == pdTRUE)
+		portYIELD_FROM_ISR();
+}
+
+static uint32_t now_ms(void)
+{
+	return (uint32_t)(hal_time_us() / 1000);
+}
+
+/* end of file ---------------------------------------------------------------*/
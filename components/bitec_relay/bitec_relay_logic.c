@@ -0,0 +1,143 @@
+/*
+ * bitec_relay_logic.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include "bitec_relay_logic.h"
+
+/* macros --------------------------------------------------------------------*/
+
+/* Wrap safe comparison of ms times */
+#define TIME_REACHED(now, time)		((int32_t)((now) - (time)) >= 0)
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static void wait_until(uint32_t * wait, uint32_t now, uint32_t time);
+
+/* external functions definition ---------------------------------------------*/
+
+void bitec_relay_logic_init(bitec_relay_logic_t * const me, uint32_t now)
+{
+	me->presence = false;
+	me->clear_time = now - me->hold_time;
+	me->dark = false;
+	me->force = -1;
+	me->output = false;
+	me->switch_time = now - me->min_off_time;
+	me->waiting = false;
+	me->tripped = false;
+	me->trip_end = now;
+	me->update_time = now;
+	me->switches = 0;
+	me->deferred = 0;
+	me->cancelled = 0;
+	me->trips = 0;
+	me->on_time = 0;
+}
+
+void bitec_relay_logic_presence(bitec_relay_logic_t * const me, bool presence, uint32_t now)
+{
+	if(me->presence && !presence)
+		me->clear_time = now;
+
+	me->presence = presence;
+}
+
+void bitec_relay_logic_illumination(bitec_relay_logic_t * const me, uint32_t illumination)
+{
+	/* Between both levels the last state is kept */
+	if(illumination < me->dark_level)
+		me->dark = true;
+	else if(illumination > me->bright_level)
+		me->dark = false;
+}
+
+void bitec_relay_logic_force(bitec_relay_logic_t * const me, int8_t force)
+{
+	/* The dwell times still apply to forced switches */
+	me->force = force < 0 ? -1 : force > 0;
+}
+
+void bitec_relay_logic_trip(bitec_relay_logic_t * const me, uint32_t now)
+{
+	me->tripped = true;
+	me->trip_end = now + me->trip_time;
+	me->trips++;
+}
+
+bool bitec_relay_logic_update(bitec_relay_logic_t * const me, uint32_t now, uint32_t * wait)
+{
+	bool held = !me->presence && !TIME_REACHED(now, me->clear_time + me->hold_time);
+	bool request = me->force >= 0 ? me->force : (me->presence || held) && me->dark;
+
+	if(me->tripped && TIME_REACHED(now, me->trip_end))
+		me->tripped = false;
+
+	if(me->tripped)
+		request = false;
+
+	if(me->output)
+		me->on_time += now - me->update_time;
+
+	me->update_time = now;
+	* wait = 0;
+
+	if(request == me->output)
+	{
+		if(me->waiting)
+			me->cancelled++;
+
+		me->waiting = false;
+	}
+	else
+	{
+		uint32_t dwell_end = me->switch_time + (me->output ? me->min_on_time : me->min_off_time);
+
+		if(me->tripped || TIME_REACHED(now, dwell_end))
+		{
+			me->output = request;
+			me->switch_time = now;
+			me->switches++;
+			me->waiting = false;
+		}
+		else
+		{
+			if(!me->waiting)
+				me->deferred++;
+
+			me->waiting = true;
+			wait_until(wait, now, dwell_end);
+		}
+	}
+
+	/* The end of the hold switches the relay off, the end of a trip may switch it on */
+	if(held)
+		wait_until(wait, now, me->clear_time + me->hold_time);
+
+	if(me->tripped)
+		wait_until(wait, now, me->trip_end);
+
+	return me->output;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static void wait_until(uint32_t * wait, uint32_t now, uint32_t time)
+{
+	uint32_t left = time - now;
+
+	if(* wait == 0 || left < * wait)
+		* wait = left;
+}
+
+/* end of file ---------------------------------------------------------------*/
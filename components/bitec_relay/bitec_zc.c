@@ -0,0 +1,95 @@
+/*
+ * bitec_zc.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include "bitec_zc.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define TOLERANCE_SHIFT		3		/*!< Accepted interval error, 1/8 of the half period */
+#define AVERAGE_SHIFT		3		/*!< Weight of a new interval in the half period, 1/8 */
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+/* external functions definition ---------------------------------------------*/
+
+void bitec_zc_init(bitec_zc_t * const me, uint32_t frequency)
+{
+	me->nominal = 500000 / frequency;
+	me->half_period = me->nominal;
+	me->last = 0;
+	me->count = 0;
+	me->rejected = 0;
+}
+
+void bitec_zc_edge(bitec_zc_t * const me, int64_t time)
+{
+	int64_t interval = time - me->last;
+	int32_t error = (int32_t)(interval - me->half_period);
+	int32_t tolerance = me->half_period >> TOLERANCE_SHIFT;
+
+	/* Noise inside a half period, the crossing it follows is kept */
+	if(me->count > 0 && interval < me->half_period - tolerance)
+	{
+		me->rejected++;
+		return;
+	}
+
+	if(me->count == 0 || interval > me->half_period + tolerance)
+	{
+		/* First edge or crossings missed, start again from the nominal frequency */
+		if(me->count > 0)
+			me->rejected++;
+
+		me->half_period = me->nominal;
+		me->count = 1;
+	}
+	else
+	{
+		me->half_period += error >> AVERAGE_SHIFT;
+		me->count++;
+	}
+
+	me->last = time;
+}
+
+bool bitec_zc_locked(const bitec_zc_t * const me, int64_t now)
+{
+	return me->count >= BITEC_ZC_LOCK_COUNT && now - me->last < (int64_t)me->half_period * BITEC_ZC_HOLDOVER;
+}
+
+int64_t bitec_zc_next(const bitec_zc_t * const me, int64_t time)
+{
+	if(time <= me->last)
+		return me->last;
+
+	int64_t periods = (time - me->last + me->half_period - 1) / me->half_period;
+
+	return me->last + periods * me->half_period;
+}
+
+int32_t bitec_zc_offset(const bitec_zc_t * const me, int64_t time)
+{
+	int64_t offset = (time - me->last) % me->half_period;
+
+	if(offset < 0)
+		offset += me->half_period;
+
+	if(offset > me->half_period / 2)
+		offset -= me->half_period;
+
+	return (int32_t)offset;
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,103 @@
+/*
+ * bitec_relay.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_RELAY_H_
+#define _BITEC_RELAY_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/timers.h"
+
+#include "esp_err.h"
+
+#include "bitec_hal.h"
+#include "bitec_latency.h"
+#include "bitec_relay_logic.h"
+#include "bitec_zc.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef struct
+{
+	int pin;
+	int zc_pin;								/*!< Zero crossing detector input, -1 to switch at once */
+	int sense_pin;							/*!< Contacts feedback input, -1 for none */
+	bitec_relay_logic_t logic;
+	SemaphoreHandle_t mutex;				/*!< Inputs come from several tasks and the timer */
+	TimerHandle_t timer;					/*!< Runs until the next dwell or hold time ends */
+
+	/* Zero crossing switching */
+	bitec_zc_t zc;
+	hal_timer_t switch_timer;				/*!< Sets the GPIO the actuation time ahead of the crossing */
+	uint32_t operate_time;					/*!< GPIO set to contacts closed in us, calibrated */
+	uint32_t release_time;					/*!< GPIO cleared to contacts open in us, calibrated */
+	volatile bool level;					/*!< Level the switch timer sets */
+	volatile int64_t target_time;			/*!< Crossing the contacts should move at */
+	volatile int64_t fire_time;				/*!< Time the GPIO changed */
+	volatile bool in_flight;				/*!< Contacts feedback expected */
+	bool calibrating;						/*!< Switches of the logic wait for the calibration to end */
+	volatile uint32_t measured;				/*!< Actuation time of the last switch in us */
+	SemaphoreHandle_t feedback;				/*!< Given on every contacts feedback */
+	bitec_latency_histogram_t phase_error;	/*!< Distance of the contacts from the crossing in us */
+	int64_t phase_sum;						/*!< Signed sum of the phase errors, for the bias */
+	portMUX_TYPE lock;						/*!< Protects the statistics and the calibration */
+} bitec_relay_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Configure the relay GPIO, off. The pins must be set */
+esp_err_t bitec_relay_init(bitec_relay_t * const me);
+
+/* Update an input, the relay is switched at once if the dwell times allow it */
+void bitec_relay_set_presence(bitec_relay_t * const me, bool presence);
+void bitec_relay_set_illumination(bitec_relay_t * const me, uint32_t illumination);
+
+/* Request the relay on (1) or off (0) whatever the inputs, -1 returns to the automatic control */
+void bitec_relay_set_force(bitec_relay_t * const me, int8_t force);
+
+/* Switch the relay off at once on an overload and keep it off for CONFIG_BITEC_RELAY_TRIP_TIME */
+void bitec_relay_trip(bitec_relay_t * const me);
+
+bool bitec_relay_get_state(bitec_relay_t * const me);
+
+/* Switch the relay on and off cycles times at zero crossings and set the actuation times from the
+ * contacts feedback. The inputs are taken meanwhile and the relay follows them when it ends. Needs
+ * the zero crossing detector locked and the contacts feedback, ESP_ERR_NOT_SUPPORTED otherwise,
+ * ESP_ERR_INVALID_STATE if a calibration is running */
+esp_err_t bitec_relay_calibrate(bitec_relay_t * const me, uint32_t cycles);
+
+/* Print the switching metrics as a JSON object. Returns its length or -1 if it does not fit */
+int bitec_relay_print(bitec_relay_t * const me, char * buf, size_t size);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_RELAY_H_ */
@@ -0,0 +1,89 @@
+/*
+ * bitec_relay_logic.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_RELAY_LOGIC_H_
+#define _BITEC_RELAY_LOGIC_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef struct
+{
+	/* Configuration, times in ms, 0 disables a dwell or the hold */
+	uint32_t dark_level;		/*!< Illumination below which it is dark */
+	uint32_t bright_level;		/*!< Illumination above which it is bright, not below dark_level */
+	uint32_t min_on_time;
+	uint32_t min_off_time;
+	uint32_t hold_time;			/*!< Presence kept after the sensor clears */
+	uint32_t trip_time;			/*!< Time kept off after a trip */
+
+	/* Inputs */
+	bool presence;
+	uint32_t clear_time;		/*!< Time the presence cleared */
+	bool dark;					/*!< Illumination with hysteresis */
+	int8_t force;				/*!< Output requested by a rule in place of the automatic one, -1 for none */
+
+	/* State */
+	bool output;
+	uint32_t switch_time;
+	bool waiting;				/*!< A switch waits for its dwell time */
+	bool tripped;
+	uint32_t trip_end;
+	uint32_t update_time;
+
+	/* Metrics */
+	uint32_t switches;
+	uint32_t deferred;			/*!< Switches delayed by a dwell time */
+	uint32_t cancelled;			/*!< Switches withdrawn before their dwell time elapsed */
+	uint32_t trips;
+	uint64_t on_time;			/*!< Time on in ms until the last update */
+} bitec_relay_logic_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Start off and not dark, the configuration must be set. The first switch has no dwell time */
+void bitec_relay_logic_init(bitec_relay_logic_t * const me, uint32_t now);
+
+/* Set the inputs, bitec_relay_logic_update() applies them */
+void bitec_relay_logic_presence(bitec_relay_logic_t * const me, bool presence, uint32_t now);
+void bitec_relay_logic_illumination(bitec_relay_logic_t * const me, uint32_t illumination);
+void bitec_relay_logic_force(bitec_relay_logic_t * const me, int8_t force);
+
+/* Switch off on the next update whatever the dwell times, and keep off for the trip time */
+void bitec_relay_logic_trip(bitec_relay_logic_t * const me, uint32_t now);
+
+/* Decide the output at now ms and return it. Sets wait to the time in ms after which it must be
+ * called again for a pending dwell or hold time, 0 if nothing is pending. Works on times alone so
+ * input sequences can be replayed on host */
+bool bitec_relay_logic_update(bitec_relay_logic_t * const me, uint32_t now, uint32_t * wait);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_RELAY_LOGIC_H_ */
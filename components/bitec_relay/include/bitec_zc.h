@@ -0,0 +1,67 @@
+/*
+ * bitec_zc.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_ZC_H_
+#define _BITEC_ZC_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#define BITEC_ZC_LOCK_COUNT		8		/*!< Crossings in a row at the expected interval to lock */
+#define BITEC_ZC_HOLDOVER		4		/*!< Half periods extrapolated after the last crossing */
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef struct
+{
+	uint32_t nominal;			/*!< Half period of the mains frequency in us */
+	uint32_t half_period;		/*!< Measured half period in us */
+	int64_t last;				/*!< Time of the last crossing in us */
+	uint32_t count;				/*!< Crossings in a row at the expected interval */
+	uint32_t rejected;			/*!< Edges off the expected interval */
+} bitec_zc_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+void bitec_zc_init(bitec_zc_t * const me, uint32_t frequency);
+
+/* Feed the time of a crossing, every edge of a zero crossing detector. Allowed from an ISR */
+void bitec_zc_edge(bitec_zc_t * const me, int64_t time);
+
+/* The crossings are regular and recent enough to be extrapolated to now */
+bool bitec_zc_locked(const bitec_zc_t * const me, int64_t now);
+
+/* First crossing at or after time, extrapolated from the last one */
+int64_t bitec_zc_next(const bitec_zc_t * const me, int64_t time);
+
+/* Signed distance in us of time from its nearest crossing, positive after it */
+int32_t bitec_zc_offset(const bitec_zc_t * const me, int64_t time);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_ZC_H_ */
@@ -0,0 +1,330 @@
+/*
+ * bitec_rules.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "bitec_rules.h"
+#include "bitec_hal.h"
+#include "esp_log.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define NVS_PARTITION		"settings"
+#define NVS_NAMESPACE		"rules"
+#define NVS_KEY				"program"
+
+#define MARK_TARGET			0x80		/*!< A jump lands here, the low bits hold the stack depth */
+#define MARK_OPERAND		0x40		/*!< Operand byte, no jump may land here */
+
+#define PUBLISH_MAX			32
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static const char * TAG = "bitec_rules";
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static esp_err_t verify(const uint8_t * code, size_t size);
+static int32_t read_le(const uint8_t * code, size_t bytes);
+
+/* external functions definition ---------------------------------------------*/
+
+esp_err_t bitec_rules_load(bitec_rules_t * const me, const uint8_t * code, size_t size)
+{
+	esp_err_t ret = verify(code, size);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	memcpy(me->code, code, size);
+	me->size = size;
+	me->raised = 0;
+
+	ESP_LOGI(TAG, "Loaded %d rules in %d bytes", code[1], (int)size);
+
+	return ESP_OK;
+}
+
+void bitec_rules_clear(bitec_rules_t * const me)
+{
+	me->size = 0;
+	me->raised = 0;
+}
+
+void bitec_rules_eval(bitec_rules_t * const me, const int32_t * vars, bitec_rules_output_t * output)
+{
+	int32_t stack[RULES_STACK];
+	int sp = 0;
+	uint32_t raised = 0;
+	size_t pc = RULES_HEADER_SIZE;
+
+	output->relay = -1;
+	output->led = false;
+	output->publish = 0;
+
+	if(me->size == 0)
+		return;
+
+	/* The program was verified when loaded, no bounds or depth check is needed here */
+	for(;;)
+	{
+		uint8_t op = me->code[pc++];
+		int32_t a, b;
+
+		switch(op)
+		{
+			case RULES_OP_END:
+				output->publish = raised & ~me->raised;
+				me->raised = raised;
+				me->evaluations++;
+				return;
+			case RULES_OP_RULE:
+				break;
+			case RULES_OP_PUSH8:
+				stack[sp++] = (int8_t)me->code[pc];
+				pc += 1;
+				break;
+			case RULES_OP_PUSH16:
+				stack[sp++] = (int16_t)read_le(&me->code[pc], 2);
+				pc += 2;
+				break;
+			case RULES_OP_PUSH32:
+				stack[sp++] = read_le(&me->code[pc], 4);
+				pc += 4;
+				break;
+			case RULES_OP_LOAD:
+				stack[sp++] = vars[me->code[pc++]];
+				break;
+			case RULES_OP_NOT:
+				stack[sp - 1] = !stack[sp - 1];
+				break;
+			case RULES_OP_WITHIN:
+				b = stack[--sp];
+				a = stack[--sp];
+
+				/* A range from a late to an early time of the day wraps at midnight */
+				if(a <= b)
+					stack[sp - 1] = stack[sp - 1] >= a && stack[sp - 1] <= b;
+				else
+					stack[sp - 1] = stack[sp - 1] >= a || stack[sp - 1] <= b;
+
+				break;
+			case RULES_OP_SKIPZ:
+				if(stack[--sp] == 0)
+					pc += me->code[pc];
+
+				pc++;
+				break;
+			case RULES_OP_RELAY:
+				output->relay = stack[--sp] != 0;
+				break;
+			case RULES_OP_LED:
+				output->led = true;
+				output->red = me->code[pc];
+				output->green = me->code[pc + 1];
+				output->blue = me->code[pc + 2];
+				pc += 3;
+				break;
+			case RULES_OP_PUBLISH:
+				raised |= 1UL << me->code[pc++];
+				break;
+			default:
+				/* Binary comparisons and logic */
+				b = stack[--sp];
+				a = stack[sp - 1];
+
+				switch(op)
+				{
+					case RULES_OP_LT: a = a < b; break;
+					case RULES_OP_LE: a = a <= b; break;
+					case RULES_OP_GT: a = a > b; break;
+					case RULES_OP_GE: a = a >= b; break;
+					case RULES_OP_EQ: a = a == b; break;
+					case RULES_OP_NE: a = a != b; break;
+					case RULES_OP_AND: a = a && b; break;
+					default: a = a || b; break;
+				}
+
+				stack[sp - 1] = a;
+				break;
+		}
+	}
+}
+
+uint8_t bitec_rules_count(const bitec_rules_t * const me)
+{
+	return me->size > 0 ? me->code[1] : 0;
+}
+
+esp_err_t bitec_rules_restore(bitec_rules_t * const me)
+{
+	hal_nvs_handle_t handle;
+	size_t size = sizeof(me->code);
+	esp_err_t ret = hal_nvs_open(NVS_PARTITION, NVS_NAMESPACE, false, &handle);
+
+	me->size = 0;
+	me->raised = 0;
+
+	if(ret != ESP_OK)
+		return ret;
+
+	ret = hal_nvs_get_blob(handle, NVS_KEY, me->code, &size);
+	hal_nvs_close(handle);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	/* The stored program may come from a build with other limits */
+	ret = verify(me->code, size);
+
+	if(ret != ESP_OK)
+	{
+		ESP_LOGW(TAG, "Discarding the stored program");
+		return ret;
+	}
+
+	me->size = size;
+
+	ESP_LOGI(TAG, "Restored %d rules", me->code[1]);
+
+	return ESP_OK;
+}
+
+esp_err_t bitec_rules_save(const bitec_rules_t * const me)
+{
+	hal_nvs_handle_t handle;
+	esp_err_t ret = hal_nvs_open(NVS_PARTITION, NVS_NAMESPACE, true, &handle);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	if(me->size > 0)
+		ret = hal_nvs_set_blob(handle, NVS_KEY, me->code, me->size);
+	else
+		ret = hal_nvs_erase_key(handle, NVS_KEY);
+
+	if(ret == ESP_OK || ret == ESP_ERR_NOT_FOUND)
+		ret = hal_nvs_commit(handle);
+
+	hal_nvs_close(handle);
+
+	return ret;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static esp_err_t verify(const uint8_t * code, size_t size)
+{
+	/* One pass in program order. Jumps only go forward, so the stack depth expected where a jump
+	 * lands is known before getting there and both paths must agree on it */
+	uint8_t marks[RULES_SIZE] = { 0 };
+	size_t pc = RULES_HEADER_SIZE;
+	int depth = 0;
+	int rules = 0;
+
+	if(size <= RULES_HEADER_SIZE || size > RULES_SIZE || code[0] != RULES_VERSION)
+		return ESP_ERR_INVALID_ARG;
+
+	while(pc < size)
+	{
+		size_t at = pc;
+		uint8_t op = code[pc++];
+		size_t operands = 0;
+		int pops = 0;
+		int pushes = 0;
+
+		if((marks[at] & MARK_OPERAND) || ((marks[at] & MARK_TARGET) && (marks[at] & ~MARK_TARGET) != depth))
+			return ESP_ERR_INVALID_ARG;
+
+		switch(op)
+		{
+			case RULES_OP_END:
+				if(pc != size || depth != 0 || rules != code[1])
+					return ESP_ERR_INVALID_ARG;
+
+				return ESP_OK;
+			case RULES_OP_RULE:
+				if(depth != 0)
+					return ESP_ERR_INVALID_ARG;
+
+				rules++;
+				break;
+			case RULES_OP_PUSH8: operands = 1; pushes = 1; break;
+			case RULES_OP_PUSH16: operands = 2; pushes = 1; break;
+			case RULES_OP_PUSH32: operands = 4; pushes = 1; break;
+			case RULES_OP_LOAD: operands = 1; pushes = 1; break;
+			case RULES_OP_LT:
+			case RULES_OP_LE:
+			case RULES_OP_GT:
+			case RULES_OP_GE:
+			case RULES_OP_EQ:
+			case RULES_OP_NE:
+			case RULES_OP_AND:
+			case RULES_OP_OR: pops = 2; pushes = 1; break;
+			case RULES_OP_NOT: pops = 1; pushes = 1; break;
+			case RULES_OP_WITHIN: pops = 3; pushes = 1; break;
+			case RULES_OP_SKIPZ: operands = 1; pops = 1; break;
+			case RULES_OP_RELAY: pops = 1; break;
+			case RULES_OP_LED: operands = 3; break;
+			case RULES_OP_PUBLISH: operands = 1; break;
+			default:
+				return ESP_ERR_INVALID_ARG;
+		}
+
+		if(pc + operands >= size || depth < pops || depth - pops + pushes > RULES_STACK)
+			return ESP_ERR_INVALID_ARG;
+
+		for(size_t i = 0; i < operands; i++)
+		{
+			if(marks[pc + i] != 0)
+				return ESP_ERR_INVALID_ARG;
+
+			marks[pc + i] = MARK_OPERAND;
+		}
+
+		if(op == RULES_OP_LOAD && code[pc] >= RULES_VAR_MAX)
+			return ESP_ERR_INVALID_ARG;
+
+		if(op == RULES_OP_PUBLISH && code[pc] >= PUBLISH_MAX)
+			return ESP_ERR_INVALID_ARG;
+
+		depth += pushes - pops;
+
+		if(op == RULES_OP_SKIPZ)
+		{
+			size_t target = pc + operands + code[pc];
+
+			if(target >= size || ((marks[target] & MARK_TARGET) && (marks[target] & ~MARK_TARGET) != depth))
+				return ESP_ERR_INVALID_ARG;
+
+			marks[target] = MARK_TARGET | depth;
+		}
+
+		pc += operands;
+	}
+
+	/* No END */
+	return ESP_ERR_INVALID_ARG;
+}
+
+static int32_t read_le(const uint8_t * code, size_t bytes)
+{
+	uint32_t value = 0;
+
+	for(size_t i = 0; i < bytes; i++)
+		value |= (uint32_t)code[i] << (8 * i);
+
+	return (int32_t)value;
+}
+
+/* end of file ---------------------------------------------------------------*/
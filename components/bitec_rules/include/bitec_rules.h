@@ -0,0 +1,133 @@
+/*
+ * bitec_rules.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_RULES_H_
+#define _BITEC_RULES_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#ifdef CONFIG_BITEC_RULES_SIZE
+#define RULES_SIZE			CONFIG_BITEC_RULES_SIZE
+#else
+#define RULES_SIZE			256
+#endif
+
+#ifdef CONFIG_BITEC_RULES_STACK
+#define RULES_STACK			CONFIG_BITEC_RULES_STACK
+#else
+#define RULES_STACK			8
+#endif
+
+#define RULES_VERSION		1			/*!< First byte of a program */
+#define RULES_HEADER_SIZE	2			/*!< Version and number of rules */
+
+/* typedef -------------------------------------------------------------------*/
+
+/* Instructions, one byte followed by their immediate operands in little endian. Values are int32,
+ * comparisons and logic push 1 or 0. Jumps only go forward, every instruction runs at most once */
+typedef enum
+{
+	RULES_OP_END = 0,		/*!< End of the program, its last byte */
+	RULES_OP_RULE,			/*!< Start of a rule, with an empty stack */
+	RULES_OP_PUSH8,			/*!< int8 operand */
+	RULES_OP_PUSH16,		/*!< int16 operand */
+	RULES_OP_PUSH32,		/*!< int32 operand */
+	RULES_OP_LOAD,			/*!< uint8 operand, bitec_rules_var_e */
+	RULES_OP_LT = 0x10,		/*!< a b -- a < b */
+	RULES_OP_LE,
+	RULES_OP_GT,
+	RULES_OP_GE,
+	RULES_OP_EQ,
+	RULES_OP_NE,
+	RULES_OP_AND,
+	RULES_OP_OR,
+	RULES_OP_NOT,			/*!< a -- !a */
+	RULES_OP_WITHIN,		/*!< x lo hi -- lo <= x <= hi, a range across the wrap when lo > hi */
+	RULES_OP_SKIPZ = 0x20,	/*!< uint8 operand, a -- and skip as many bytes if a is 0 */
+	RULES_OP_RELAY = 0x30,	/*!< a -- and request the relay on if a is not 0, off otherwise */
+	RULES_OP_LED,			/*!< Red, green and blue uint8 operands, set the LED color */
+	RULES_OP_PUBLISH,		/*!< uint8 operand below 32, raise an event published once per raise */
+} bitec_rules_op_e;
+
+typedef enum
+{
+	RULES_VAR_ILLUMINATION = 0,	/*!< Light sensor reading */
+	RULES_VAR_PRESENCE,			/*!< 1 while presence is detected */
+	RULES_VAR_POWER,			/*!< Apparent power in VA */
+	RULES_VAR_VOLTAGE,			/*!< RMS voltage in V */
+	RULES_VAR_CURRENT,			/*!< RMS current in mA */
+	RULES_VAR_MINUTE,			/*!< Minute of the day, -1 while the time is unknown */
+	RULES_VAR_LIGHT,			/*!< 1 while the relay is on */
+	RULES_VAR_MAX
+} bitec_rules_var_e;
+
+typedef struct
+{
+	int8_t relay;				/*!< -1 if no rule acted on the relay, else the last request */
+	bool led;					/*!< A rule set the LED color */
+	uint8_t red;
+	uint8_t green;
+	uint8_t blue;
+	uint32_t publish;			/*!< Events raised by this evaluation and not by the previous one */
+} bitec_rules_output_t;
+
+typedef struct
+{
+	uint8_t code[RULES_SIZE];
+	size_t size;				/*!< 0 while no program is loaded */
+	uint32_t raised;			/*!< Events raised by the last evaluation */
+	uint32_t evaluations;
+} bitec_rules_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Check a program and load it in place of the current one. Returns ESP_ERR_INVALID_ARG and keeps
+ * the current one if it is malformed, uses an unknown variable, jumps backwards or out of it, or
+ * needs more than RULES_STACK values */
+esp_err_t bitec_rules_load(bitec_rules_t * const me, const uint8_t * code, size_t size);
+
+/* Unload the program, no rule acts until another one is loaded */
+void bitec_rules_clear(bitec_rules_t * const me);
+
+/* Run the program once with the variables indexed by bitec_rules_var_e. Its time is bounded by the
+ * program size */
+void bitec_rules_eval(bitec_rules_t * const me, const int32_t * vars, bitec_rules_output_t * output);
+
+/* Number of rules of the loaded program */
+uint8_t bitec_rules_count(const bitec_rules_t * const me);
+
+/* Program in the settings NVS partition, ESP_ERR_NOT_FOUND if none was saved */
+esp_err_t bitec_rules_restore(bitec_rules_t * const me);
+esp_err_t bitec_rules_save(const bitec_rules_t * const me);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_RULES_H_ */
@@ -0,0 +1,713 @@
+/*
+ * bitec_series.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <math.h>
+
+#include "bitec_series.h"
+#include "esp_log.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define SERIES_VERSION		1
+#define SEQUENCE_ERASED		0xFFFFFFFF
+#define LEADING_NONE		0xFF
+#define SAMPLE_BITS_MAX(channels)	(4 + 32 + (2 + 5 + 5 + 32) * (channels))	/*!< Longest sample encoded */
+#define RAW_SIZE(channels)	(sizeof(int64_t) + sizeof(float) * (channels))	/*!< Of a sample as it is */
+#define PRINT_RESERVE		40			/*!< Closing the samples and the next time */
+
+_Static_assert(sizeof(bitec_series_header_t) == SERIES_HEADER_SIZE, "Header of a block changed");
+_Static_assert(HAL_PARTITION_SECTOR % SERIES_BLOCK_SIZE == 0, "Blocks have to fill the flash sectors");
+
+/* typedef -------------------------------------------------------------------*/
+
+/* Samples of the blocks in time order, the ones only in flash first */
+typedef struct
+{
+	uint32_t index;				/*!< Of the block */
+	uint32_t total;
+	uint32_t flash;				/*!< Blocks read from flash, older than the ones in RAM */
+	const bitec_series_block_t * block;	/*!< NULL past the last one */
+	uint16_t sample;			/*!< Next one of the block */
+	uint32_t position;			/*!< In bits */
+	bitec_series_codec_t codec;
+	bitec_series_block_t buffer;	/*!< Of a block read from flash */
+} cursor_t;
+
+/* internal data declaration -------------------------------------------------*/
+
+static const char * TAG = "bitec_series";
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static void block_open(bitec_series_t * const me, uint32_t sequence);
+static void block_seal(bitec_series_t * const me);
+static void block_spill(bitec_series_t * const me, const bitec_series_block_t * block);
+static bool block_valid(const bitec_series_t * const me, const bitec_series_header_t * header);
+static bitec_series_block_t * ram_block(const bitec_series_t * const me, uint32_t index);
+static esp_err_t flash_header(const bitec_series_t * const me, uint32_t index, bitec_series_header_t * header);
+static uint32_t flash_before_ram(const bitec_series_t * const me);
+static bool cursor_init(bitec_series_t * const me, cursor_t * cursor, int64_t from);
+static bool cursor_load(bitec_series_t * const me, cursor_t * cursor);
+static bool cursor_next(bitec_series_t * const me, cursor_t * cursor, int64_t * time, uint32_t * values);
+static void codec_reset(bitec_series_codec_t * codec);
+static void sample_encode(bitec_series_block_t * block, bitec_series_codec_t * codec, int64_t time, const uint32_t * values, uint8_t channels);
+static void sample_decode(const bitec_series_block_t * block, bitec_series_codec_t * codec, uint32_t * position, uint16_t index, uint8_t channels);
+static uint32_t quantize(float value, int8_t precision);
+static void bits_put(bitec_series_block_t * block, uint32_t value, uint8_t bits);
+static uint32_t bits_get(const uint8_t * data, uint32_t * position, uint8_t bits);
+static int print_sample(char * buf, size_t size, bool first, int64_t time, const uint32_t * values, uint8_t channels);
+
+/* external functions definition ---------------------------------------------*/
+
+esp_err_t bitec_series_init(bitec_series_t * const me, uint8_t channels, const int8_t * precisions)
+{
+	if(channels == 0 || channels > SERIES_CHANNELS_MAX)
+		return ESP_ERR_INVALID_ARG;
+
+	memset(me, 0, sizeof(bitec_series_t));
+
+	me->channels = channels;
+	memcpy(me->precisions, precisions, channels);
+	me->count = 1;
+	me->last = -1;
+	block_open(me, 0);
+
+	return ESP_OK;
+}
+
+esp_err_t bitec_series_spill(bitec_series_t * const me, const char * label)
+{
+	bitec_series_header_t header;
+	uint32_t newest = 0;
+	uint32_t sequence = SEQUENCE_ERASED;
+	size_t size;
+
+	/* The next samples have to be later than the ones already in flash */
+	if(me->count > 1 || me->blocks[me->head].header.count > 0)
+		return ESP_ERR_INVALID_STATE;
+
+	esp_err_t ret = hal_partition_open(label, &me->partition, &size);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	me->slots = size / SERIES_BLOCK_SIZE;
+	me->flash_head = 0;
+	me->flash_count = 0;
+
+	for(uint32_t i = 0; i < me->slots; i++)
+	{
+		if(hal_partition_read(me->partition, i * SERIES_BLOCK_SIZE, &header, sizeof(header)) == ESP_OK &&
+				block_valid(me, &header) && (sequence == SEQUENCE_ERASED || header.sequence > sequence))
+		{
+			newest = i;
+			sequence = header.sequence;
+		}
+	}
+
+	if(sequence == SEQUENCE_ERASED)
+		return ESP_OK;
+
+	/* Back from the newest one while the sequence goes down, a sector erased ends the ring */
+	me->flash_head = (newest + 1) % me->slots;
+	me->flash_count = 1;
+
+	for(uint32_t previous = sequence; me->flash_count < me->slots; me->flash_count++)
+	{
+		uint32_t slot = (newest + me->slots - me->flash_count) % me->slots;
+
+		if(hal_partition_read(me->partition, slot * SERIES_BLOCK_SIZE, &header, sizeof(header)) != ESP_OK ||
+				!block_valid(me, &header) || header.sequence >= previous)
+			break;
+
+		previous = header.sequence;
+	}
+
+	hal_partition_read(me->partition, newest * SERIES_BLOCK_SIZE, &header, sizeof(header));
+	me->last = header.first + header.span;
+	block_open(me, sequence + 1);
+	ESP_LOGI(TAG, "%" PRIu32 " blocks in flash, the last one %" PRIu32, me->flash_count, sequence);
+
+	return ESP_OK;
+}
+
+esp_err_t bitec_series_add(bitec_series_t * const me, int64_t time, const float * values)
+{
+	uint32_t quantized[SERIES_CHANNELS_MAX];
+	bitec_series_block_t * block = &me->blocks[me->head];
+
+	if(me->last >= 0 && time <= me->last)
+	{
+		me->rejected++;
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	for(int i = 0; i < me->channels; i++)
+		quantized[i] = quantize(values[i], me->precisions[i]);
+
+	/* A new block once the longest sample may not fit or the time differences would not */
+	if(block->header.count > 0 && (block->header.bits + SAMPLE_BITS_MAX(me->channels) > SERIES_DATA_SIZE * 8 ||
+			block->header.count == UINT16_MAX || time - block->header.first > UINT32_MAX || time - me->encoder.time > INT32_MAX))
+	{
+		block_seal(me);
+		block = &me->blocks[me->head];
+	}
+
+	if(block->header.count == 0)
+		block->header.first = time;
+
+	sample_encode(block, &me->encoder, time, quantized, me->channels);
+	block->header.count++;
+	block->header.span = time - block->header.first;
+	me->last = time;
+	me->samples++;
+
+	return ESP_OK;
+}
+
+void bitec_series_flush(bitec_series_t * const me)
+{
+	if(me->blocks[me->head].header.count > 0)
+		block_seal(me);
+}
+
+int bitec_series_print(bitec_series_t * const me, int64_t from, int64_t to, uint16_t limit, char * buf, size_t size,
+		int64_t * next)
+{
+	cursor_t * cursor = malloc(sizeof(cursor_t));
+	uint32_t values[SERIES_CHANNELS_MAX];
+	uint16_t printed = 0;
+	int64_t time;
+	int ret;
+
+	* next = -1;
+
+	if(cursor == NULL || size <= PRINT_RESERVE)
+	{
+		free(cursor);
+		return -1;
+	}
+
+	int len = snprintf(buf, size, "{\"from\":%" PRId64 ",\"to\":%" PRId64 ",\"samples\":[", from, to);
+
+	if(len < 0 || (size_t)len >= size - PRINT_RESERVE)
+	{
+		free(cursor);
+		return -1;
+	}
+
+	me->queries++;
+
+	for(bool more = cursor_init(me, cursor, from); more && cursor_next(me, cursor, &time, values);)
+	{
+		if(time < from)
+			continue;
+
+		if(time > to)
+			break;
+
+		ret = (printed < limit) ? print_sample(buf + len, size - len - PRINT_RESERVE, printed == 0, time, values, me->channels) : -1;
+
+		/* The next page starts on it */
+		if(ret < 0)
+		{
+			* next = time;
+			break;
+		}
+
+		len += ret;
+		printed++;
+	}
+
+	free(cursor);
+
+	if(printed == 0 && * next >= 0)
+		return -1;
+
+	ret = (* next >= 0) ? snprintf(buf + len, size - len, "],\"next\":%" PRId64 "}", * next) :
+			snprintf(buf + len, size - len, "],\"next\":null}");
+
+	if(ret < 0 || (size_t)ret >= size - len)
+		return -1;
+
+	return len + ret;
+}
+
+int64_t bitec_series_oldest(const bitec_series_t * const me)
+{
+	bitec_series_header_t header;
+
+	if(me->flash_count > 0 && flash_before_ram(me) > 0 && flash_header(me, 0, &header) == ESP_OK)
+		return header.first;
+
+	/* Only the open one may be empty */
+	for(uint32_t i = 0; i < me->count; i++)
+	{
+		const bitec_series_block_t * block = ram_block(me, i);
+
+		if(block->header.count > 0)
+			return block->header.first;
+	}
+
+	return -1;
+}
+
+void bitec_series_usage(const bitec_series_t * const me, size_t * stored, size_t * raw)
+{
+	* stored = 0;
+	* raw = 0;
+
+	for(uint32_t i = 0; i < me->count; i++)
+	{
+		const bitec_series_block_t * block = ram_block(me, i);
+
+		if(block->header.count == 0)
+			continue;
+
+		* stored += SERIES_HEADER_SIZE + (block->header.bits + 7) / 8;
+		* raw += block->header.count * RAW_SIZE(me->channels);
+	}
+}
+
+int bitec_series_print_metrics(const bitec_series_t * const me, char * buf, size_t size)
+{
+	size_t stored;
+	size_t raw;
+
+	bitec_series_usage(me, &stored, &raw);
+
+	int len = snprintf(buf, size, "{\"samples\":%" PRIu32 ",\"oldest\":%" PRId64 ",\"blocks\":%u,\"stored\":%u,\"ratio\":%.2f,\"flash\":%" PRIu32
+			",\"spilled\":%" PRIu32 ",\"errors\":%" PRIu32 ",\"evicted\":%" PRIu32 ",\"rejected\":%" PRIu32 ",\"queries\":%" PRIu32 "}",
+			me->samples, bitec_series_oldest(me), me->count, (unsigned)stored, stored > 0 ? (double)raw / stored : 0.0, me->flash_count,
+			me->spilled, me->spill_errors, me->evicted, me->rejected, me->queries);
+
+	if(len < 0 || (size_t)len >= size)
+		return -1;
+
+	return len;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* Empty block at head, the encoder starts again */
+static void block_open(bitec_series_t * const me, uint32_t sequence)
+{
+	bitec_series_block_t * block = &me->blocks[me->head];
+
+	memset(block, 0, sizeof(bitec_series_block_t));
+	block->header.sequence = sequence;
+	block->header.channels = me->channels;
+	block->header.version = SERIES_VERSION;
+	codec_reset(&me->encoder);
+}
+
+/* Close the block at head and open the next one, over the oldest if the ring is full */
+static void block_seal(bitec_series_t * const me)
+{
+	uint32_t sequence = me->blocks[me->head].header.sequence + 1;
+
+	if(me->partition != 0)
+		block_spill(me, &me->blocks[me->head]);
+
+	me->head = (me->head + 1) % SERIES_BLOCKS;
+
+	if(me->count < SERIES_BLOCKS)
+		me->count++;
+	else if(me->partition == 0)
+		me->evicted++;
+
+	block_open(me, sequence);
+}
+
+/* Write a block to the next slot, its sector is erased first if the block is the first of it */
+static void block_spill(bitec_series_t * const me, const bitec_series_block_t * block)
+{
+	size_t offset = me->flash_head * SERIES_BLOCK_SIZE;
+	uint32_t per_sector = HAL_PARTITION_SECTOR / SERIES_BLOCK_SIZE;
+	esp_err_t ret = ESP_OK;
+
+	if(offset % HAL_PARTITION_SECTOR == 0)
+	{
+		ret = hal_partition_erase(me->partition, offset, HAL_PARTITION_SECTOR);
+
+		/* The oldest blocks were in it */
+		if(me->flash_count > me->slots - per_sector)
+			me->flash_count = me->slots - per_sector;
+	}
+
+	if(ret == ESP_OK)
+		ret = hal_partition_write(me->partition, offset, block, SERIES_BLOCK_SIZE);
+
+	if(ret != ESP_OK)
+	{
+		me->spill_errors++;
+		ESP_LOGW(TAG, "Block %" PRIu32 " not written: %s", block->header.sequence, esp_err_to_name(ret));
+		return;
+	}
+
+	me->flash_head = (me->flash_head + 1) % me->slots;
+	me->flash_count++;
+	me->spilled++;
+}
+
+/* Written by this format with the same channels */
+static bool block_valid(const bitec_series_t * const me, const bitec_series_header_t * header)
+{
+	return header->version == SERIES_VERSION && header->channels == me->channels && header->sequence != SEQUENCE_ERASED &&
+			header->count > 0 && header->bits <= SERIES_DATA_SIZE * 8;
+}
+
+/* Block in RAM by age, the oldest one is 0 */
+static bitec_series_block_t * ram_block(const bitec_series_t * const me, uint32_t index)
+{
+	return (bitec_series_block_t *)&me->blocks[(me->head + SERIES_BLOCKS + 1 - me->count + index) % SERIES_BLOCKS];
+}
+
+/* Header of a block in flash by age, the oldest one is 0 */
+static esp_err_t flash_header(const bitec_series_t * const me, uint32_t index, bitec_series_header_t * header)
+{
+	uint32_t slot = (me->flash_head + me->slots - me->flash_count + index) % me->slots;
+
+	return hal_partition_read(me->partition, slot * SERIES_BLOCK_SIZE, header, sizeof(bitec_series_header_t));
+}
+
+/* Blocks in flash older than the ones still in RAM, by their sequence */
+static uint32_t flash_before_ram(const bitec_series_t * const me)
+{
+	bitec_series_header_t header;
+	uint32_t sequence = ram_block(me, 0)->header.sequence;
+	uint32_t low = 0;
+	uint32_t high = me->flash_count;
+
+	while(low < high)
+	{
+		uint32_t middle = low + (high - low) / 2;
+
+		if(flash_header(me, middle, &header) != ESP_OK)
+			return 0;
+
+		if(header.sequence < sequence)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	return low;
+}
+
+/* On the first block that may hold samples from a time, the last ones of every block are later */
+static bool cursor_init(bitec_series_t * const me, cursor_t * cursor, int64_t from)
+{
+	bitec_series_header_t header;
+	uint32_t low = 0;
+
+	cursor->flash = (me->partition != 0) ? flash_before_ram(me) : 0;
+	cursor->total = cursor->flash + me->count;
+
+	for(uint32_t high = cursor->total; low < high;)
+	{
+		uint32_t middle = low + (high - low) / 2;
+
+		if(middle < cursor->flash)
+		{
+			if(flash_header(me, middle, &header) != ESP_OK)
+				return false;
+		}
+		else
+			header = ram_block(me, middle - cursor->flash)->header;
+
+		/* The open block is the last one, empty it holds any later sample */
+		if(header.count > 0 && header.first + header.span < from)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	cursor->index = low;
+
+	return cursor_load(me, cursor);
+}
+
+/* Block at index, read from flash if not in RAM. Returns false past the last one or on a read error */
+static bool cursor_load(bitec_series_t * const me, cursor_t * cursor)
+{
+	cursor->block = NULL;
+	cursor->sample = 0;
+	cursor->position = 0;
+
+	if(cursor->index >= cursor->total)
+		return false;
+
+	if(cursor->index >= cursor->flash)
+		cursor->block = ram_block(me, cursor->index - cursor->flash);
+	else
+	{
+		uint32_t slot = (me->flash_head + me->slots - me->flash_count + cursor->index) % me->slots;
+
+		if(hal_partition_read(me->partition, slot * SERIES_BLOCK_SIZE, &cursor->buffer, SERIES_BLOCK_SIZE) != ESP_OK ||
+				!block_valid(me, &cursor->buffer.header))
+			return false;
+
+		cursor->block = &cursor->buffer;
+	}
+
+	return true;
+}
+
+/* Decode the next sample. Returns false once there are none */
+static bool cursor_next(bitec_series_t * const me, cursor_t * cursor, int64_t * time, uint32_t * values)
+{
+	while(cursor->block != NULL && cursor->sample >= cursor->block->header.count)
+	{
+		cursor->index++;
+
+		if(!cursor_load(me, cursor))
+			return false;
+	}
+
+	if(cursor->block == NULL)
+		return false;
+
+	sample_decode(cursor->block, &cursor->codec, &cursor->position, cursor->sample++, me->channels);
+	* time = cursor->codec.time;
+	memcpy(values, cursor->codec.values, me->channels * sizeof(uint32_t));
+
+	return true;
+}
+
+static void codec_reset(bitec_series_codec_t * codec)
+{
+	memset(codec, 0, sizeof(bitec_series_codec_t));
+	memset(codec->leading, LEADING_NONE, sizeof(codec->leading));
+}
+
+/* A sample after the last one of the codec, the first one of a block only has its values */
+static void sample_encode(bitec_series_block_t * block, bitec_series_codec_t * codec, int64_t time, const uint32_t * values, uint8_t channels)
+{
+	if(block->header.count == 0)
+	{
+		codec_reset(codec);
+		codec->time = time;
+
+		for(int i = 0; i < channels; i++)
+		{
+			bits_put(block, values[i], 32);
+			codec->values[i] = values[i];
+		}
+
+		return;
+	}
+
+	int64_t delta = time - codec->time;
+	int64_t dod = delta - codec->delta;
+
+	if(dod == 0)
+		bits_put(block, 0, 1);
+	else if(dod >= -63 && dod <= 64)
+	{
+		bits_put(block, 2, 2);
+		bits_put(block, dod + 63, 7);
+	}
+	else if(dod >= -255 && dod <= 256)
+	{
+		bits_put(block, 6, 3);
+		bits_put(block, dod + 255, 9);
+	}
+	else if(dod >= -2047 && dod <= 2048)
+	{
+		bits_put(block, 14, 4);
+		bits_put(block, dod + 2047, 12);
+	}
+	else
+	{
+		bits_put(block, 15, 4);
+		bits_put(block, (uint32_t)(int32_t)dod, 32);
+	}
+
+	codec->time = time;
+	codec->delta = delta;
+
+	for(int i = 0; i < channels; i++)
+	{
+		uint32_t xor = values[i] ^ codec->values[i];
+
+		if(xor == 0)
+		{
+			bits_put(block, 0, 1);
+			continue;
+		}
+
+		uint8_t leading = __builtin_clz(xor);
+		uint8_t trailing = __builtin_ctz(xor);
+
+		/* Within the window of the last one, its length is not repeated */
+		if(codec->leading[i] != LEADING_NONE && leading >= codec->leading[i] && trailing >= codec->trailing[i])
+		{
+			bits_put(block, 2, 2);
+			bits_put(block, xor >> codec->trailing[i], 32 - codec->leading[i] - codec->trailing[i]);
+		}
+		else
+		{
+			uint8_t length = 32 - leading - trailing;
+
+			bits_put(block, 3, 2);
+			bits_put(block, leading, 5);
+			bits_put(block, length - 1, 5);
+			bits_put(block, xor >> trailing, length);
+			codec->leading[i] = leading;
+			codec->trailing[i] = trailing;
+		}
+
+		codec->values[i] = values[i];
+	}
+}
+
+/* Sample index of a block from position, after the one before it */
+static void sample_decode(const bitec_series_block_t * block, bitec_series_codec_t * codec, uint32_t * position, uint16_t index, uint8_t channels)
+{
+	const uint8_t * data = block->data;
+
+	if(index == 0)
+	{
+		codec_reset(codec);
+		codec->time = block->header.first;
+
+		for(int i = 0; i < channels; i++)
+			codec->values[i] = bits_get(data, position, 32);
+
+		return;
+	}
+
+	int64_t dod;
+
+	if(bits_get(data, position, 1) == 0)
+		dod = 0;
+	else if(bits_get(data, position, 1) == 0)
+		dod = (int64_t)bits_get(data, position, 7) - 63;
+	else if(bits_get(data, position, 1) == 0)
+		dod = (int64_t)bits_get(data, position, 9) - 255;
+	else if(bits_get(data, position, 1) == 0)
+		dod = (int64_t)bits_get(data, position, 12) - 2047;
+	else
+		dod = (int32_t)bits_get(data, position, 32);
+
+	codec->delta += dod;
+	codec->time += codec->delta;
+
+	for(int i = 0; i < channels; i++)
+	{
+		if(bits_get(data, position, 1) == 0)
+			continue;
+
+		if(bits_get(data, position, 1) == 0)
+		{
+			uint8_t length = 32 - codec->leading[i] - codec->trailing[i];
+
+			codec->values[i] ^= bits_get(data, position, length) << codec->trailing[i];
+		}
+		else
+		{
+			codec->leading[i] = bits_get(data, position, 5);
+
+			uint8_t length = bits_get(data, position, 5) + 1;
+
+			codec->trailing[i] = 32 - codec->leading[i] - length;
+			codec->values[i] ^= bits_get(data, position, length) << codec->trailing[i];
+		}
+	}
+}
+
+/* Bits of a float rounded to precision binary fraction digits */
+static uint32_t quantize(float value, int8_t precision)
+{
+	uint32_t bits;
+
+	if(isfinite(value))
+	{
+		value = ldexpf(roundf(ldexpf(value, precision)), -precision);
+
+		/* No negative zero, it would differ from a positive one in the sign bit */
+		if(value == 0)
+			value = 0;
+	}
+
+	memcpy(&bits, &value, sizeof(bits));
+
+	return bits;
+}
+
+/* Append the low bits of value, the most significant first */
+static void bits_put(bitec_series_block_t * block, uint32_t value, uint8_t bits)
+{
+	while(bits > 0)
+	{
+		uint32_t position = block->header.bits;
+		uint8_t room = 8 - (position & 7);
+		uint8_t n = bits < room ? bits : room;
+
+		block->data[position >> 3] |= ((value >> (bits - n)) & ((1U << n) - 1)) << (room - n);
+		block->header.bits += n;
+		bits -= n;
+	}
+}
+
+static uint32_t bits_get(const uint8_t * data, uint32_t * position, uint8_t bits)
+{
+	uint32_t value = 0;
+
+	while(bits > 0)
+	{
+		uint8_t room = 8 - (* position & 7);
+		uint8_t n = bits < room ? bits : room;
+
+		value = (value << n) | ((data[* position >> 3] >> (room - n)) & ((1U << n) - 1));
+		* position += n;
+		bits -= n;
+	}
+
+	return value;
+}
+
+/* A sample as an array of its time and values, null for the ones not finite */
+static int print_sample(char * buf, size_t size, bool first, int64_t time, const uint32_t * values, uint8_t channels)
+{
+	int len = snprintf(buf, size, "%s[%" PRId64, first ? "" : ",", time);
+	int ret;
+
+	if(len < 0 || (size_t)len >= size)
+		return -1;
+
+	for(int i = 0; i < channels; i++)
+	{
+		float value;
+
+		memcpy(&value, &values[i], sizeof(value));
+		ret = isfinite(value) ? snprintf(buf + len, size - len, ",%.7g", value) : snprintf(buf + len, size - len, ",null");
+
+		if(ret < 0 || (size_t)ret >= size - len)
+			return -1;
+
+		len += ret;
+	}
+
+	ret = snprintf(buf + len, size - len, "]");
+
+	if(ret < 0 || (size_t)ret >= size - len)
+		return -1;
+
+	return len + ret;
+}
+
+/* end of file ---------------------------------------------------------------*/
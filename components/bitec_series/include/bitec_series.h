@@ -0,0 +1,160 @@
+/*
+ * bitec_series.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_SERIES_H_
+#define _BITEC_SERIES_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "bitec_hal.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#ifdef CONFIG_BITEC_SERIES_BLOCK_SIZE
+#define SERIES_BLOCK_SIZE		CONFIG_BITEC_SERIES_BLOCK_SIZE
+#else
+#define SERIES_BLOCK_SIZE		512
+#endif
+
+#ifdef CONFIG_BITEC_SERIES_BLOCKS
+#define SERIES_BLOCKS			CONFIG_BITEC_SERIES_BLOCKS
+#else
+#define SERIES_BLOCKS			32
+#endif
+
+#define SERIES_CHANNELS_MAX		8			/*!< Values of a sample */
+#define SERIES_HEADER_SIZE		24
+#define SERIES_DATA_SIZE		(SERIES_BLOCK_SIZE - SERIES_HEADER_SIZE)
+
+/* Samples are stored in blocks, each one decoded on its own. The time of the first sample is in the
+ * header and its values as they are, the next times are the difference to the last difference and
+ * the next values the XOR to the last value, with fewer bits the more alike they are:
+ *
+ *     time:  0                     same difference as the last one
+ *            10 + 7 bits           difference within -63 to 64 ms of it
+ *            110 + 9 bits          -255 to 256 ms
+ *            1110 + 12 bits        -2047 to 2048 ms
+ *            1111 + 32 bits        any other
+ *     value: 0                     same as the last one
+ *            10 + meaningful bits  XOR within the leading and trailing zeros of the last one
+ *            11 + 5 bits leading zeros + 5 bits length - 1 + meaningful bits
+ *
+ * Values are rounded to a binary fraction first, the fewer bits of precision the more trailing zeros */
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef struct
+{
+	uint32_t sequence;			/*!< Blocks sealed before it since the store was empty, 0xFFFFFFFF erased */
+	uint16_t count;				/*!< Samples */
+	uint16_t bits;				/*!< Of data in use */
+	int64_t first;				/*!< Unix time of the first sample in ms */
+	uint32_t span;				/*!< From the first sample to the last one in ms */
+	uint8_t channels;
+	uint8_t version;
+	uint16_t reserved;
+} bitec_series_header_t;
+
+typedef struct
+{
+	bitec_series_header_t header;
+	uint8_t data[SERIES_DATA_SIZE];
+} bitec_series_block_t;
+
+/* State of the last sample, of the encoder or of a decoder */
+typedef struct
+{
+	int64_t time;
+	int64_t delta;
+	uint32_t values[SERIES_CHANNELS_MAX];
+	uint8_t leading[SERIES_CHANNELS_MAX];	/*!< Zeros of the last XOR stored with a length, 0xFF for none */
+	uint8_t trailing[SERIES_CHANNELS_MAX];
+} bitec_series_codec_t;
+
+typedef struct
+{
+	/* Configuration, set by bitec_series_init() */
+	uint8_t channels;
+	int8_t precisions[SERIES_CHANNELS_MAX];	/*!< Binary fraction digits kept of every value */
+
+	/* State, the blocks in RAM are a ring with the open one at head */
+	bitec_series_block_t blocks[SERIES_BLOCKS];
+	uint16_t head;
+	uint16_t count;				/*!< Blocks in RAM, the open one too */
+	bitec_series_codec_t encoder;
+	int64_t last;				/*!< Time of the last sample, -1 for none */
+
+	/* Flash, a ring of blocks written as they are sealed */
+	hal_partition_t partition;	/*!< 0 for none */
+	uint32_t slots;				/*!< Blocks of the partition */
+	uint32_t flash_head;		/*!< Next slot written */
+	uint32_t flash_count;
+
+	/* Metrics */
+	uint32_t samples;
+	uint32_t rejected;			/*!< Samples not later than the last one */
+	uint32_t evicted;			/*!< Blocks out of RAM and not in flash */
+	uint32_t spilled;
+	uint32_t spill_errors;
+	uint32_t queries;
+} bitec_series_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Empty the store for samples of channels values, each rounded to precisions binary fraction digits,
+ * 0 for integers. Returns ESP_ERR_INVALID_ARG for more than SERIES_CHANNELS_MAX channels */
+esp_err_t bitec_series_init(bitec_series_t * const me, uint8_t channels, const int8_t * precisions);
+
+/* Write every block to a data partition once sealed, the blocks already in it are queried too and the
+ * next samples have to be later than them. Blocks of other channels or versions are ignored */
+esp_err_t bitec_series_spill(bitec_series_t * const me, const char * label);
+
+/* Add a sample at a unix time in ms. Returns ESP_ERR_INVALID_ARG if not later than the last one */
+esp_err_t bitec_series_add(bitec_series_t * const me, int64_t time, const float * values);
+
+/* Seal the open block, written to flash if spilled. Before a restart, the open block is lost otherwise */
+void bitec_series_flush(bitec_series_t * const me);
+
+/* Print the samples from time from to time to as JSON, as [time, values...] arrays, limit of them at
+ * most and as many as fit. next gets the time of the first one left, -1 if none, to print the next
+ * page from. Returns its length or -1 if not even one sample fits */
+int bitec_series_print(bitec_series_t * const me, int64_t from, int64_t to, uint16_t limit, char * buf, size_t size,
+		int64_t * next);
+
+/* Time of the oldest sample stored, -1 for none */
+int64_t bitec_series_oldest(const bitec_series_t * const me);
+
+/* Bytes of the samples in RAM as stored and as floats with a 64 bit time */
+void bitec_series_usage(const bitec_series_t * const me, size_t * stored, size_t * raw);
+
+/* Print the metrics as JSON. Returns its length or -1 if it does not fit */
+int bitec_series_print_metrics(const bitec_series_t * const me, char * buf, size_t size);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_SERIES_H_ */
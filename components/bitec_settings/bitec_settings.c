@@ -0,0 +1,436 @@
+/*
+ * bitec_settings.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "include/bitec_settings.h"
+#include "bitec_hal.h"
+#include "esp_log.h"
+#include "cJSON.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define NVS_PARTITION		"settings"
+#define NVS_NAMESPACE		"settings"
+#define NVS_VERSION			"_version"	/*!< Schema version, keys of the entries do not start with _ */
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static const char * TAG = "bitec_settings";
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static esp_err_t load(bitec_settings_t * const me, hal_nvs_handle_t handle, int id);
+static esp_err_t check(const bitec_settings_entry_t * entry, const cJSON * item);
+static bool string_valid(const char * value, size_t size, int32_t max);
+static bool is_default(const bitec_settings_t * const me, int id);
+
+/* external functions definition ---------------------------------------------*/
+
+esp_err_t bitec_settings_init(bitec_settings_t * const me, const bitec_settings_entry_t * entries, size_t count, uint32_t version)
+{
+	size_t offset = 0;
+
+	memset(me, 0, sizeof(bitec_settings_t));
+
+	if(count > SETTINGS_ENTRIES)
+		return ESP_ERR_INVALID_SIZE;
+
+	for(size_t i = 0; i < count; i++)
+	{
+		const bitec_settings_entry_t * entry = &entries[i];
+
+		if(entry->key == NULL || entry->key[0] == '_' || strlen(entry->key) >= SETTINGS_KEY_SIZE || entry->type >= SETTINGS_TYPE_MAX)
+			return ESP_ERR_INVALID_ARG;
+
+		if(entry->type == SETTINGS_STRING)
+		{
+			if(entry->max < 0 || entry->string == NULL || !string_valid(entry->string, strlen(entry->string), entry->max))
+				return ESP_ERR_INVALID_ARG;
+
+			/* Every string gets room for its longest value */
+			if(offset + entry->max + 1 > SETTINGS_STRINGS_SIZE)
+				return ESP_ERR_INVALID_SIZE;
+
+			me->offsets[i] = offset;
+			strcpy(me->strings + offset, entry->string);
+			offset += entry->max + 1;
+		}
+		else
+		{
+			if((entry->type == SETTINGS_BOOL && entry->value != 0 && entry->value != 1) ||
+					(entry->type == SETTINGS_INT && (entry->value < entry->min || entry->value > entry->max)))
+				return ESP_ERR_INVALID_ARG;
+
+			me->values[i] = entry->value;
+		}
+	}
+
+	me->entries = entries;
+	me->count = count;
+	me->version = version;
+	me->migrate = NULL;
+	me->arg = NULL;
+
+	return ESP_OK;
+}
+
+esp_err_t bitec_settings_restore(bitec_settings_t * const me)
+{
+	hal_nvs_handle_t handle;
+	uint32_t version = 0;
+	size_t size = sizeof(version);
+	int loaded = 0;
+	esp_err_t ret = hal_nvs_open(NVS_PARTITION, NVS_NAMESPACE, false, &handle);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	/* Written by every commit, there are no values without it */
+	ret = hal_nvs_get_blob(handle, NVS_VERSION, &version, &size);
+
+	if(ret != ESP_OK || size != sizeof(version))
+	{
+		hal_nvs_close(handle);
+		return ret != ESP_OK ? ret : ESP_ERR_INVALID_SIZE;
+	}
+
+	for(int i = 0; i < me->count; i++)
+	{
+		ret = load(me, handle, i);
+
+		if(ret == ESP_OK)
+			loaded++;
+		else if(ret != ESP_ERR_NOT_FOUND)
+		{
+			/* Left at its default, the commit erases the stored value */
+			ESP_LOGW(TAG, "Discarding the stored %s", me->entries[i].key);
+			me->dirty |= 1UL << i;
+		}
+	}
+
+	hal_nvs_close(handle);
+
+	ESP_LOGI(TAG, "Restored %d settings of version %" PRIu32, loaded, version);
+
+	if(version < me->version && me->migrate != NULL)
+		me->migrate(me, version, me->arg);
+
+	ret = ESP_OK;
+
+	if(me->dirty != 0 || version != me->version)
+		ret = bitec_settings_commit(me);
+
+	/* The values restored are the ones running */
+	me->restart = 0;
+
+	return ret;
+}
+
+int32_t bitec_settings_get(const bitec_settings_t * const me, int id)
+{
+	return me->values[id];
+}
+
+const char * bitec_settings_get_string(const bitec_settings_t * const me, int id)
+{
+	return me->strings + me->offsets[id];
+}
+
+esp_err_t bitec_settings_set(bitec_settings_t * const me, int id, int32_t value)
+{
+	const bitec_settings_entry_t * entry = &me->entries[id];
+
+	if(entry->type == SETTINGS_STRING || (entry->type == SETTINGS_BOOL && value != 0 && value != 1) ||
+			(entry->type == SETTINGS_INT && (value < entry->min || value > entry->max)))
+		return ESP_ERR_INVALID_ARG;
+
+	if(me->values[id] != value)
+	{
+		me->values[id] = value;
+		me->dirty |= 1UL << id;
+	}
+
+	return ESP_OK;
+}
+
+esp_err_t bitec_settings_set_string(bitec_settings_t * const me, int id, const char * value)
+{
+	const bitec_settings_entry_t * entry = &me->entries[id];
+	char * string = me->strings + me->offsets[id];
+
+	if(entry->type != SETTINGS_STRING || !string_valid(value, strlen(value), entry->max))
+		return ESP_ERR_INVALID_ARG;
+
+	if(strcmp(string, value))
+	{
+		strcpy(string, value);
+		me->dirty |= 1UL << id;
+	}
+
+	return ESP_OK;
+}
+
+void bitec_settings_reset(bitec_settings_t * const me, int id)
+{
+	const bitec_settings_entry_t * entry = &me->entries[id];
+
+	if(entry->type == SETTINGS_STRING)
+		strcpy(me->strings + me->offsets[id], entry->string);
+	else
+		me->values[id] = entry->value;
+
+	me->dirty |= 1UL << id;
+}
+
+int bitec_settings_find(const bitec_settings_t * const me, const char * key)
+{
+	for(int i = 0; i < me->count; i++)
+	{
+		if(!strcmp(me->entries[i].key, key))
+			return i;
+	}
+
+	return -1;
+}
+
+esp_err_t bitec_settings_parse(bitec_settings_t * const me, const char * data, size_t len)
+{
+	esp_err_t ret = ESP_OK;
+	cJSON * root = cJSON_ParseWithLength(data, len);
+
+	if(!cJSON_IsObject(root))
+	{
+		cJSON_Delete(root);
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	/* Checked whole first, a message sets all its values or none */
+	for(const cJSON * item = root->child; item != NULL && ret == ESP_OK; item = item->next)
+	{
+		int id = bitec_settings_find(me, item->string);
+
+		if(id < 0)
+			ret = ESP_ERR_INVALID_ARG;
+		else
+			ret = check(&me->entries[id], item);
+	}
+
+	for(const cJSON * item = root->child; item != NULL && ret == ESP_OK; item = item->next)
+	{
+		int id = bitec_settings_find(me, item->string);
+
+		if(cJSON_IsNull(item))
+			bitec_settings_reset(me, id);
+		else if(me->entries[id].type == SETTINGS_STRING)
+			bitec_settings_set_string(me, id, item->valuestring);
+		else if(me->entries[id].type == SETTINGS_BOOL)
+			bitec_settings_set(me, id, cJSON_IsTrue(item));
+		else
+			bitec_settings_set(me, id, (int32_t)item->valuedouble);
+	}
+
+	cJSON_Delete(root);
+
+	return ret;
+}
+
+esp_err_t bitec_settings_commit(bitec_settings_t * const me)
+{
+	hal_nvs_handle_t handle;
+	esp_err_t ret = hal_nvs_open(NVS_PARTITION, NVS_NAMESPACE, true, &handle);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	ret = hal_nvs_set_blob(handle, NVS_VERSION, &me->version, sizeof(me->version));
+
+	for(int i = 0; i < me->count && ret == ESP_OK; i++)
+	{
+		if(!(me->dirty & (1UL << i)))
+			continue;
+
+		const bitec_settings_entry_t * entry = &me->entries[i];
+
+		/* Defaults are not stored, the one of the running build applies */
+		if(is_default(me, i))
+		{
+			ret = hal_nvs_erase_key(handle, entry->key);
+
+			if(ret == ESP_ERR_NOT_FOUND)
+				ret = ESP_OK;
+		}
+		else if(entry->type == SETTINGS_STRING)
+		{
+			const char * string = me->strings + me->offsets[i];
+			ret = hal_nvs_set_blob(handle, entry->key, string, strlen(string) + 1);
+		}
+		else
+			ret = hal_nvs_set_blob(handle, entry->key, &me->values[i], sizeof(int32_t));
+
+		me->writes++;
+
+		if(ret == ESP_OK && (entry->flags & SETTINGS_RESTART))
+			me->restart |= 1UL << i;
+	}
+
+	if(ret == ESP_OK)
+		ret = hal_nvs_commit(handle);
+
+	hal_nvs_close(handle);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	me->dirty = 0;
+	me->commits++;
+
+	return ESP_OK;
+}
+
+int bitec_settings_print(const bitec_settings_t * const me, char * buf, size_t size)
+{
+	int len = snprintf(buf, size, "{\"version\":%" PRIu32, me->version);
+
+	for(int i = 0; i < me->count && len >= 0 && (size_t)len < size; i++)
+	{
+		const bitec_settings_entry_t * entry = &me->entries[i];
+
+		/* Strings have nothing to escape */
+		if(entry->type == SETTINGS_STRING)
+			len += snprintf(buf + len, size - len, ",\"%s\":\"%s\"", entry->key, me->strings + me->offsets[i]);
+		else if(entry->type == SETTINGS_BOOL)
+			len += snprintf(buf + len, size - len, ",\"%s\":%s", entry->key, me->values[i] ? "true" : "false");
+		else
+			len += snprintf(buf + len, size - len, ",\"%s\":%" PRId32, entry->key, me->values[i]);
+	}
+
+	if(len >= 0 && (size_t)len < size)
+		len += snprintf(buf + len, size - len, ",\"restart\":%s}", me->restart != 0 ? "true" : "false");
+
+	if(len < 0 || (size_t)len >= size)
+		return -1;
+
+	return len;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* Load the stored value of a setting in the cache. Returns ESP_ERR_NOT_FOUND if there is none and
+ * ESP_ERR_INVALID_SIZE or ESP_ERR_INVALID_ARG if it does not fit the entry */
+static esp_err_t load(bitec_settings_t * const me, hal_nvs_handle_t handle, int id)
+{
+	const bitec_settings_entry_t * entry = &me->entries[id];
+	size_t size = 0;
+	esp_err_t ret = hal_nvs_get_blob(handle, entry->key, NULL, &size);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	if(entry->type == SETTINGS_STRING)
+	{
+		char * string = me->strings + me->offsets[id];
+
+		if(size == 0 || size > entry->max + 1)
+			return ESP_ERR_INVALID_SIZE;
+
+		ret = hal_nvs_get_blob(handle, entry->key, string, &size);
+
+		if(ret == ESP_OK && (string[size - 1] != '\0' || !string_valid(string, size - 1, entry->max)))
+			ret = ESP_ERR_INVALID_ARG;
+
+		if(ret != ESP_OK)
+			strcpy(string, entry->string);
+
+		return ret;
+	}
+
+	int32_t value;
+
+	if(size != sizeof(value))
+		return ESP_ERR_INVALID_SIZE;
+
+	ret = hal_nvs_get_blob(handle, entry->key, &value, &size);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	if((entry->type == SETTINGS_BOOL && value != 0 && value != 1) ||
+			(entry->type == SETTINGS_INT && (value < entry->min || value > entry->max)))
+		return ESP_ERR_INVALID_ARG;
+
+	me->values[id] = value;
+
+	return ESP_OK;
+}
+
+/* Whether a JSON value can be set to an entry */
+static esp_err_t check(const bitec_settings_entry_t * entry, const cJSON * item)
+{
+	if(cJSON_IsNull(item))
+		return ESP_OK;
+
+	switch(entry->type)
+	{
+		case SETTINGS_STRING:
+			if(!cJSON_IsString(item) || !string_valid(item->valuestring, strlen(item->valuestring), entry->max))
+				return ESP_ERR_INVALID_ARG;
+
+			break;
+
+		case SETTINGS_BOOL:
+			if(!cJSON_IsBool(item))
+				return ESP_ERR_INVALID_ARG;
+
+			break;
+
+		default:
+			if(!cJSON_IsNumber(item) || item->valuedouble < entry->min || item->valuedouble > entry->max ||
+					item->valuedouble != (int32_t)item->valuedouble)
+				return ESP_ERR_INVALID_ARG;
+
+			break;
+	}
+
+	return ESP_OK;
+}
+
+/* Strings are printed and stored as they are, so they are kept to printable characters with nothing
+ * to escape */
+static bool string_valid(const char * value, size_t size, int32_t max)
+{
+	if(size > max)
+		return false;
+
+	for(size_t i = 0; i < size; i++)
+	{
+		if(value[i] < ' ' || value[i] > '~' || value[i] == '"' || value[i] == '\\')
+			return false;
+	}
+
+	return true;
+}
+
+static bool is_default(const bitec_settings_t * const me, int id)
+{
+	const bitec_settings_entry_t * entry = &me->entries[id];
+
+	if(entry->type == SETTINGS_STRING)
+		return !strcmp(me->strings + me->offsets[id], entry->string);
+
+	return me->values[id] == entry->value;
+}
+
+/* end of file ---------------------------------------------------------------*/
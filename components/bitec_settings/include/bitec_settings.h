@@ -0,0 +1,141 @@
+/*
+ * bitec_settings.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_SETTINGS_H_
+#define _BITEC_SETTINGS_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#ifdef CONFIG_BITEC_SETTINGS_ENTRIES
+#define SETTINGS_ENTRIES		CONFIG_BITEC_SETTINGS_ENTRIES
+#else
+#define SETTINGS_ENTRIES		24
+#endif
+
+#ifdef CONFIG_BITEC_SETTINGS_STRINGS_SIZE
+#define SETTINGS_STRINGS_SIZE	CONFIG_BITEC_SETTINGS_STRINGS_SIZE
+#else
+#define SETTINGS_STRINGS_SIZE	256
+#endif
+
+#define SETTINGS_KEY_SIZE		16			/*!< NVS key size, with the terminating null */
+
+#define SETTINGS_RESTART		(1 << 0)	/*!< Read once at start, a new value applies after a restart */
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef enum
+{
+	SETTINGS_INT = 0,
+	SETTINGS_BOOL,
+	SETTINGS_STRING,			/*!< Printable, without quotes or backslashes */
+	SETTINGS_TYPE_MAX
+} bitec_settings_type_e;
+
+/* A setting, the application keeps a constant table of them indexed by its own ids */
+typedef struct
+{
+	const char * key;			/*!< NVS key and JSON name */
+	bitec_settings_type_e type;
+	int32_t min;				/*!< Range of an INT, maximum length of a STRING in max */
+	int32_t max;
+	int32_t value;				/*!< Default of an INT or a BOOL */
+	const char * string;		/*!< Default of a STRING */
+	uint8_t flags;
+} bitec_settings_entry_t;
+
+typedef struct bitec_settings bitec_settings_t;
+
+/* Called by bitec_settings_restore() with the schema version the values were stored with, when it is
+ * older than the one of the table. The values are loaded, the ones it sets are committed */
+typedef void (* bitec_settings_migrate_t)(bitec_settings_t * const me, uint32_t version, void * arg);
+
+struct bitec_settings
+{
+	/* Configuration, set by bitec_settings_init() */
+	const bitec_settings_entry_t * entries;
+	size_t count;
+	uint32_t version;			/*!< Schema version of entries, stored with the values */
+	bitec_settings_migrate_t migrate;	/*!< NULL for none */
+	void * arg;					/*!< Of migrate */
+
+	/* Cache */
+	int32_t values[SETTINGS_ENTRIES];
+	uint16_t offsets[SETTINGS_ENTRIES];	/*!< Of the STRING values in strings */
+	char strings[SETTINGS_STRINGS_SIZE];
+	uint32_t dirty;				/*!< Settings changed and not committed */
+	uint32_t restart;			/*!< SETTINGS_RESTART settings committed since the start */
+
+	/* Metrics */
+	uint32_t commits;
+	uint32_t writes;			/*!< Keys written or erased */
+};
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Register count entries and set them to their defaults. Returns ESP_ERR_INVALID_ARG for a table with
+ * a key too long or a default out of its range, ESP_ERR_INVALID_SIZE if it does not fit the cache */
+esp_err_t bitec_settings_init(bitec_settings_t * const me, const bitec_settings_entry_t * entries, size_t count, uint32_t version);
+
+/* Load the values from the settings NVS partition. A value stored by a build with other limits is
+ * replaced by its default, and the version stored along. Returns ESP_ERR_NOT_FOUND if none was saved */
+esp_err_t bitec_settings_restore(bitec_settings_t * const me);
+
+/* Values from the RAM cache, set by another task between two reads is fine for an INT or a BOOL. A
+ * STRING is meant for SETTINGS_RESTART settings, read at start before any can be set */
+int32_t bitec_settings_get(const bitec_settings_t * const me, int id);
+const char * bitec_settings_get_string(const bitec_settings_t * const me, int id);
+
+/* Set the cache, bitec_settings_commit() stores the changes. Returns ESP_ERR_INVALID_ARG for a value
+ * of another type or out of its range */
+esp_err_t bitec_settings_set(bitec_settings_t * const me, int id, int32_t value);
+esp_err_t bitec_settings_set_string(bitec_settings_t * const me, int id, const char * value);
+
+/* Back to the default, its key is erased so a new default applies after an update */
+void bitec_settings_reset(bitec_settings_t * const me, int id);
+
+/* Id of a key, -1 if it is not registered */
+int bitec_settings_find(const bitec_settings_t * const me, const char * key);
+
+/* Take a JSON object of keys and values, a null value resets its setting. Returns ESP_ERR_INVALID_ARG
+ * and sets none if any key is unknown or any value invalid */
+esp_err_t bitec_settings_parse(bitec_settings_t * const me, const char * data, size_t len);
+
+/* Store every setting changed since the last commit with a single NVS commit */
+esp_err_t bitec_settings_commit(bitec_settings_t * const me);
+
+/* Print every value as JSON, with the version and whether a restart is pending. Returns its length or
+ * -1 if it does not fit */
+int bitec_settings_print(const bitec_settings_t * const me, char * buf, size_t size);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_SETTINGS_H_ */
@@ -0,0 +1,120 @@
+/*
+ * bitec_trace.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <string.h>
+#include <inttypes.h>
+
+#include "include/bitec_trace.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "bitec_hal.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define TRACE_MASK	(TRACE_RECORDS - 1)
+
+_Static_assert((TRACE_RECORDS & TRACE_MASK) == 0, "TRACE_RECORDS must be a power of two");
+_Static_assert(sizeof(bitec_trace_record_t) == 16, "trace records must be 16 bytes long");
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static const char * TAG = "bitec_trace";
+
+static bitec_trace_record_t ring[TRACE_RECORDS];	/*!< Trace records */
+static uint32_t head = 0;							/*!< Index of the next record to write */
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;	/*!< Protects the ring and its head */
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+/* external functions definition ---------------------------------------------*/
+
+esp_err_t bitec_trace_init(void)
+{
+	ESP_LOGI(TAG, "Initializing trace ring of %d records...", TRACE_RECORDS);
+
+	/* A zeroed slot never matches the sequence expected for its first index */
+	portENTER_CRITICAL(&lock);
+	memset(ring, 0, sizeof(ring));
+	head = 0;
+	portEXIT_CRITICAL(&lock);
+
+	return ESP_OK;
+}
+
+void IRAM_ATTR bitec_trace_record(uint16_t event, uint32_t arg0, uint32_t arg1)
+{
+	uint32_t timestamp = (uint32_t)hal_time_us();
+	bitec_trace_record_t * record;
+
+	/* A spinlock rather than __atomic builtins, which are libatomic calls in
+	 * flash on the ESP32-S2. Safe from any task or ISR */
+	portENTER_CRITICAL_SAFE(&lock);
+	record = &ring[head & TRACE_MASK];
+	record->timestamp = timestamp;
+	record->event = event;
+	record->sequence = (uint16_t)(head + 1);
+	record->args[0] = arg0;
+	record->args[1] = arg1;
+	head++;
+	portEXIT_CRITICAL_SAFE(&lock);
+}
+
+bool bitec_trace_read(uint32_t index, bitec_trace_record_t * const record)
+{
+	const bitec_trace_record_t * slot = &ring[index & TRACE_MASK];
+	bool read;
+
+	/* The slot holds the record of the index unless a later lap overwrote it */
+	portENTER_CRITICAL(&lock);
+	read = slot->sequence == (uint16_t)(index + 1);
+
+	if(read)
+		memcpy(record, slot, sizeof(bitec_trace_record_t));
+
+	portEXIT_CRITICAL(&lock);
+
+	return read;
+}
+
+uint32_t bitec_trace_head(void)
+{
+	uint32_t index;
+
+	portENTER_CRITICAL(&lock);
+	index = head;
+	portEXIT_CRITICAL(&lock);
+
+	return index;
+}
+
+void bitec_trace_dump(void)
+{
+	bitec_trace_record_t record;
+	uint32_t end = bitec_trace_head();
+	uint32_t start = end > TRACE_RECORDS ? end - TRACE_RECORDS : 0;
+
+	/* Header: index of the first and one past the last record, the records before the first one were overwritten */
+	ESP_LOGI(TAG, TRACE_DUMP_MARKER "begin %" PRIu32 " %" PRIu32, start, end);
+
+	for(uint32_t i = start; i < end; i++)
+	{
+		if(bitec_trace_read(i, &record))
+			ESP_LOGI(TAG, TRACE_DUMP_MARKER "%08" PRIx32 " %04x %08" PRIx32 " %08" PRIx32, record.timestamp, record.event, record.args[0], record.args[1]);
+	}
+
+	ESP_LOGI(TAG, TRACE_DUMP_MARKER "end");
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* end of file ---------------------------------------------------------------*/
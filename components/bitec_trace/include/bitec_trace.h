@@ -0,0 +1,90 @@
+/*
+ * bitec_trace.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_TRACE_H_
+#define _BITEC_TRACE_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "bitec_trace_events.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#ifdef CONFIG_BITEC_TRACE_RECORDS
+#define TRACE_RECORDS		CONFIG_BITEC_TRACE_RECORDS
+#else
+#define TRACE_RECORDS		256
+#endif
+
+#define TRACE_DUMP_MARKER	"trace:"	/*!< Prefix of the dumped lines, searched by trace_decode.py */
+
+/* Log an event either as a binary trace record or, when the trace is disabled,
+ * with the original ESP_LOGI format string. BITEC_TRACE_W for an ESP_LOGW */
+#ifdef CONFIG_BITEC_TRACE_ENABLE
+#define BITEC_TRACE(tag, event, arg0, arg1, format, ...)	\
+	do { (void)(tag); bitec_trace_record(event, (uint32_t)(arg0), (uint32_t)(arg1)); } while(0)
+#define BITEC_TRACE_W(tag, event, arg0, arg1, format, ...)	\
+	BITEC_TRACE(tag, event, arg0, arg1, format, ##__VA_ARGS__)
+#else
+#define BITEC_TRACE(tag, event, arg0, arg1, format, ...)	\
+	ESP_LOGI(tag, format, ##__VA_ARGS__)
+#define BITEC_TRACE_W(tag, event, arg0, arg1, format, ...)	\
+	ESP_LOGW(tag, format, ##__VA_ARGS__)
+#endif
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef enum
+{
+#define TRACE_EVENT_ID(id, format)	id,
+	BITEC_TRACE_EVENTS(TRACE_EVENT_ID)
+#undef TRACE_EVENT_ID
+	TRACE_EVENT_MAX
+} bitec_trace_event_e;
+
+typedef struct
+{
+	uint32_t timestamp;		/*!< Low 32 bits of hal_time_us() */
+	uint16_t event;			/*!< Event id, see bitec_trace_events.h */
+	uint16_t sequence;		/*!< Low 16 bits of the write index plus one */
+	uint32_t args[2];		/*!< Event arguments */
+} bitec_trace_record_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+esp_err_t bitec_trace_init(void);
+void bitec_trace_record(uint16_t event, uint32_t arg0, uint32_t arg1);
+bool bitec_trace_read(uint32_t index, bitec_trace_record_t * const record);
+uint32_t bitec_trace_head(void);
+void bitec_trace_dump(void);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_TRACE_H_ */
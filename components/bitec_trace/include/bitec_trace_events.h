@@ -0,0 +1,45 @@
+/*
+ * bitec_trace_events.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BITEC_TRACE_EVENTS_H_
+#define _BITEC_TRACE_EVENTS_H_
+
+/* macros --------------------------------------------------------------------*/
+
+/* Trace event catalogue. The position in the list is the event id stored in
+ * every record and trace_decode.py parses this list to format the records, so
+ * new events must be appended at the end and each entry kept in a single line */
+#define BITEC_TRACE_EVENTS(X) \
+	X(TRACE_MQTT_CONNECTED,			"MQTT_EVENT_CONNECTED") \
+	X(TRACE_MQTT_DISCONNECTED,		"MQTT_EVENT_DISCONNECTED") \
+	X(TRACE_MQTT_SUBSCRIBED,		"MQTT_EVENT_SUBSCRIBED, msg_id=%d") \
+	X(TRACE_MQTT_UNSUBSCRIBED,		"MQTT_EVENT_UNSUBSCRIBED, msg_id=%d") \
+	X(TRACE_MQTT_PUBLISHED,			"MQTT_EVENT_PUBLISHED, msg_id=%d") \
+	X(TRACE_MQTT_DATA,				"MQTT_EVENT_DATA, topic_len=%d, data_len=%d") \
+	X(TRACE_MQTT_ERROR,				"MQTT_EVENT_ERROR") \
+	X(TRACE_MQTT_OTHER,				"Other event id:%d") \
+	X(TRACE_APP_MQTT_CONNECTED,		"MQTT_EVENT_CONNECTED_BIT set!") \
+	X(TRACE_APP_MQTT_DISCONNECTED,	"MQTT_EVENT_DISCONNECTED_BIT set!") \
+	X(TRACE_APP_MQTT_DATA,			"MQTT_EVENT_DATA_BIT set!, topic_len=%d, data_len=%d") \
+	X(TRACE_APP_MQTT_UNEXPECTED,	"MQTT unexpected Event") \
+	X(TRACE_APP_PUBLISH_CONNECT,	"Published to connected topic, msg_id=%d") \
+	X(TRACE_APP_PUBLISH_STATUS,		"Published to status topic, len=%d, msg_id=%d") \
+	X(TRACE_APP_PUBLISH_REPLY,		"Published reply to status topic, len=%d, msg_id=%d") \
+	X(TRACE_APP_PUBLISH_METRICS,	"Published to metrics topic, len=%d, msg_id=%d") \
+	X(TRACE_APP_SUBSCRIBE,			"Subscribed to user defined topic %d, msg_id=%d") \
+	X(TRACE_APP_PUBLISH_RULE_EVENT,	"Rule event %d published to events topic, msg_id=%d") \
+	X(TRACE_APP_PUBLISH_SETTINGS,	"Published to settings topic, len=%d, msg_id=%d") \
+	X(TRACE_APP_PUBLISH_CALIBRATION,	"Calibration result %d published to events topic, msg_id=%d") \
+	X(TRACE_APP_PUBLISH_ROLLOUT,	"Rollout state %d published to rollout topic, msg_id=%d") \
+	X(TRACE_APP_PUBLISH_ALARM,		"Alarm %d published to events topic, msg_id=%d") \
+	X(TRACE_APP_PUBLISH_ENERGY,		"Energy records published to energy topic, records=%d, msg_id=%d") \
+	X(TRACE_APP_PUBLISH_SERIES,		"Series page published to series topic, len=%d, msg_id=%d") \
+	X(TRACE_APP_PRESENCE,			"Presence %d")
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BITEC_TRACE_EVENTS_H_ */
@@ -0,0 +1,109 @@
+#!/usr/bin/env python
+#
+# trace_decode.py
+#
+# Created on: Oct 18, 2026
+# Author: Mauricio Barroso Benavides
+#
+# Decode the binary trace records dumped by bitec_trace_dump() from a serial
+# log. Event names and formats are taken from bitec_trace_events.h.
+#
+# usage: trace_decode.py [-e bitec_trace_events.h] [log file]
+
+import argparse
+import os
+import re
+import sys
+
+MARKER = 'trace:'
+EVENT_RE = re.compile(r'X\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+RECORD_RE = re.compile(r'([0-9a-fA-F]{8}) ([0-9a-fA-F]{4}) ([0-9a-fA-F]{8}) ([0-9a-fA-F]{8})')
+
+
+def load_events(path):
+    with open(path) as f:
+        return EVENT_RE.findall(f.read())
+
+
+def signed(value):
+    return value - (1 << 32) if value & (1 << 31) else value
+
+
+def format_event(events, event, args):
+    if event >= len(events):
+        return 'UNKNOWN_EVENT_%d args=%d,%d' % (event, args[0], args[1])
+
+    name, fmt = events[event]
+    count = len(re.findall(r'%[^%]', fmt))
+
+    try:
+        text = fmt % tuple(args[:count])
+    except (TypeError, ValueError):
+        text = fmt
+
+    return '%s: %s' % (name, text)
+
+
+def decode(lines, events, out):
+    base = None
+    previous = 0
+    overflow = 0
+
+    for line in lines:
+        position = line.rfind(MARKER)
+
+        if position < 0:
+            continue
+
+        body = line[position + len(MARKER):].strip()
+
+        if body.startswith('begin'):
+            start, end = (int(x) for x in body.split()[1:3])
+            base = None
+            overflow = 0
+            out.write('# records %d to %d, %d lost\n' % (start, end, start))
+            continue
+
+        if body.startswith('end'):
+            continue
+
+        match = RECORD_RE.match(body)
+
+        if match is None:
+            continue
+
+        timestamp, event, arg0, arg1 = (int(x, 16) for x in match.groups())
+
+        # Timestamps are the low 32 bits of hal_time_us()
+        if base is not None and timestamp < previous:
+            overflow += 1 << 32
+
+        previous = timestamp
+        timestamp += overflow
+
+        if base is None:
+            base = timestamp
+
+        out.write('%12.6f +%10.6f  %s\n' % (timestamp / 1e6, (timestamp - base) / 1e6,
+                                           format_event(events, event, [signed(arg0), signed(arg1)])))
+
+
+def main():
+    default_events = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'include', 'bitec_trace_events.h')
+
+    parser = argparse.ArgumentParser(description='Decode bitec_trace dumps')
+    parser.add_argument('-e', '--events', default=default_events, help='event catalogue header')
+    parser.add_argument('log', nargs='?', help='serial log, standard input if missing')
+    args = parser.parse_args()
+
+    events = load_events(args.events)
+
+    if args.log:
+        with open(args.log, errors='replace') as f:
+            decode(f, events, sys.stdout)
+    else:
+        decode(sys.stdin, events, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()
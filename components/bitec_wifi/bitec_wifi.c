@@ -113,6 +113,11 @@ esp_err_t bitec_wifi_init(bitec_wifi_t * const me)
 	return ESP_OK;
 }
 
+esp_err_t bitec_wifi_reconnect(bitec_wifi_t * const me)
+{
+	return esp_wifi_connect();
+}
+
 /* internal functions definition ---------------------------------------------*/
 
 static void get_device_service_name(char *service_name, size_t max)
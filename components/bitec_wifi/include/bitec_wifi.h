@@ -20,12 +20,15 @@
 #include "esp_err.h"
 
 #include "esp_log.h"
-#include "esp_wifi.h"
 #include "esp_event.h"
+
+#ifndef CONFIG_IDF_TARGET_LINUX
+#include "esp_wifi.h"
 #include "nvs_flash.h"
 
 #include "wifi_provisioning/manager.h"
 #include "wifi_provisioning/scheme_softap.h"
+#endif
 
 /* cplusplus -----------------------------------------------------------------*/
 
@@ -69,6 +72,7 @@ typedef struct
 /* external functions declaration --------------------------------------------*/
 
 esp_err_t bitec_wifi_init(bitec_wifi_t * const me);
+esp_err_t bitec_wifi_reconnect(bitec_wifi_t * const me);
 
 /* cplusplus -----------------------------------------------------------------*/
 
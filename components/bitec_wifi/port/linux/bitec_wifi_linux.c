@@ -0,0 +1,52 @@
+/*
+ * bitec_wifi_linux.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include "bitec_wifi.h"
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static const char * TAG = "bitec_wifi";
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+/* external functions definition ---------------------------------------------*/
+
+esp_err_t bitec_wifi_init(bitec_wifi_t * const me)
+{
+	/* Create Wi-Fi event group */
+	me->event_group = xEventGroupCreate();
+
+	if(me->event_group == NULL)
+		return ESP_ERR_NO_MEM;
+
+	/* The host network is always up, report an already provisioned station that got its IP */
+	ESP_LOGI(TAG, "Already provisioned. Connecting to AP...");
+
+	xEventGroupSetBits(me->event_group, WIFI_EVENT_STA_CONNECTED_BIT);
+	xEventGroupSetBits(me->event_group, IP_EVENT_STA_GOT_IP_BIT);
+
+	return ESP_OK;
+}
+
+esp_err_t bitec_wifi_reconnect(bitec_wifi_t * const me)
+{
+	xEventGroupSetBits(me->event_group, WIFI_EVENT_STA_CONNECTED_BIT);
+
+	return ESP_OK;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* end of file ---------------------------------------------------------------*/
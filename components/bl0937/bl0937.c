@@ -7,12 +7,30 @@
 
 /* inclusions ----------------------------------------------------------------*/
 
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+#include <inttypes.h>
+
 #include "bl0937.h"
 
 /* macros --------------------------------------------------------------------*/
 
+#define NVS_PARTITION		"settings"
+#define NVS_NAMESPACE		"bl0937"
+#define NVS_KEY				"calibration"
+#define PROFILE_VERSION		2		/*!< 1 had no temperature */
+
 /* typedef -------------------------------------------------------------------*/
 
+/* Stored calibration */
+typedef struct
+{
+	uint32_t version;
+	float multipliers[BL0937_CHANNEL_MAX];	/*!< Indexed by bl0937_channel_e */
+	float temperature;
+} profile_t;
+
 /* internal data declaration -------------------------------------------------*/
 
 static const char * TAG = "bl0937";
@@ -22,6 +40,12 @@ static const char * TAG = "bl0937";
 /* internal functions declaration --------------------------------------------*/
 
 static void calculate_default_multipliers(bl0937_t * const me);
+static bool multipliers_valid(bl0937_t * const me, const float * multipliers);
+static void stats_add(bl0937_stats_t * stats, double value);
+static double stats_error(const bl0937_stats_t * stats);
+static bool window_read(bl0937_t * const me, uint32_t sequence, bl0937_window_t * window);
+static float window_reading(const bl0937_t * const me, const bl0937_window_t * window);
+static float timing_error(uint32_t time);
 static void check_cf_signal(bl0937_t * const me);
 static void check_cf1_signal(bl0937_t * const me);
 static void IRAM_ATTR cf_isr(void * arg);
@@ -36,24 +60,13 @@ esp_err_t bl0937_init(bl0937_t * const me)
 	esp_err_t ret;
 
 	/* Configure SEL pin */
-	gpio_config_t gpio_conf;
-	gpio_conf.intr_type = GPIO_INTR_DISABLE;
-	gpio_conf.mode = GPIO_MODE_OUTPUT;
-	gpio_conf.pin_bit_mask = (1ULL << me->sel_pin);
-	gpio_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
-	gpio_conf.pull_up_en = GPIO_PULLUP_DISABLE;
-	ret = gpio_config(&gpio_conf);
+	ret = hal_gpio_config_output(1ULL << me->sel_pin);
 
 	if(ret != ESP_OK)
 		return ret;
 
 	/* Configure CF1 and CF pins */
-	gpio_conf.intr_type = GPIO_INTR_ANYEDGE;
-	gpio_conf.mode = GPIO_MODE_INPUT;
-	gpio_conf.pin_bit_mask = (1ULL << me->cf_pin) | (1ULL << me->cf1_pin);
-	gpio_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
-	gpio_conf.pull_up_en = GPIO_PULLUP_ENABLE;
-	ret = gpio_config(&gpio_conf);
+	ret = hal_gpio_config_input((1ULL << me->cf_pin) | (1ULL << me->cf1_pin), HAL_GPIO_PULL_UP, HAL_GPIO_INTR_ANYEDGE);
 
 	if(ret != ESP_OK)
 		return ret;
@@ -72,29 +85,36 @@ esp_err_t bl0937_init(bl0937_t * const me)
 	me->last_cf_interrupt = 0;
 	me->last_cf1_interrupt = 0;
 	me->first_cf1_interrupt = 0;
+	me->cf1_edges = 0;
+	me->cf_period_count = 0;
+	me->cf_period_time = 0;
+	me->sequence = 0;
+	me->calibrated = false;
+	me->temperature = NAN;
 	me->mode = me->current_mode;
 
 	if(ret != ESP_OK)
 		return ret;
 
-	/* Calculate default multipliers */
+	/* Calculate default multipliers, a stored calibration replaces them */
 	calculate_default_multipliers(me);
 
-	/* Set pin level according the mode */
-	ret = gpio_set_level(me->sel_pin, me->mode);
+	if(bl0937_calibration_restore(me) == ESP_OK)
+		ESP_LOGI(TAG, "Calibrated multipliers restored");
 
-	/* Install ISR service and configure interrupts handlers */
-	ret = gpio_install_isr_service(0);
+	/* Set pin level according the mode */
+	ret = hal_gpio_set_level(me->sel_pin, me->mode);
 
 	if(ret != ESP_OK)
 			return ret;
 
-	ret = gpio_isr_handler_add(me->cf_pin, cf_isr, (void *)me);
+	/* Configure interrupts handlers */
+	ret = hal_gpio_isr_add(me->cf_pin, cf_isr, (void *)me);
 
 	if(ret != ESP_OK)
 			return ret;
 
-	ret = gpio_isr_handler_add(me->cf1_pin, cf1_isr, (void *)me);
+	ret = hal_gpio_isr_add(me->cf1_pin, cf1_isr, (void *)me);
 
 	if(ret != ESP_OK)
 			return ret;
@@ -105,9 +125,10 @@ esp_err_t bl0937_init(bl0937_t * const me)
 void bl0937_set_mode(bl0937_t * const me, bl0937_mode_e mode)
 {
     me->mode = (mode == MODE_CURRENT) ? me->current_mode : 1 - me->current_mode;
-    gpio_set_level(me->sel_pin, me->mode);
+    hal_gpio_set_level(me->sel_pin, me->mode);
 
-    me->last_cf1_interrupt = me->first_cf1_interrupt = esp_timer_get_time();
+    me->last_cf1_interrupt = me->first_cf1_interrupt = hal_time_us();
+    me->cf1_edges = 0;
 }
 
 bl0937_mode_e bl0937_get_mode(bl0937_t * const me)
@@ -159,23 +180,20 @@ uint16_t bl0937_get_active_power(bl0937_t * const me)
 
 uint16_t bl0937_get_apparent_power(bl0937_t * const me)
 {
-    float current = bl0937_get_current(me);
-    uint16_t voltage = bl0937_get_voltage(me);
+	bl0937_estimate_t estimate;
+
+	bl0937_estimate(me, &estimate);
 
-    return voltage * current;
+	return (uint16_t)lroundf(estimate.apparent);
 }
 
 float bl0937_get_power_factor(bl0937_t * const me)
 {
-    uint16_t active = bl0937_get_active_power(me);
-    uint16_t apparent = bl0937_get_apparent_power(me);
-    if(active > apparent)
-    	return 1;
+	bl0937_estimate_t estimate;
 
-    if(apparent == 0)
-    	return 0;
+	bl0937_estimate(me, &estimate);
 
-    return (float) active / apparent;
+	return estimate.power_factor;
 }
 
 void bl0937_reset_energy(bl0937_t * const me)
@@ -213,6 +231,8 @@ void bl0937_expected_active_power(bl0937_t * const me, uint16_t value)
 void bl0937_reset_multipliers(bl0937_t * const me)
 {
 	calculate_default_multipliers(me);
+	me->calibrated = false;
+	me->temperature = NAN;
 }
 
 void bl0937_set_resistors(bl0937_t * const me, float current, float voltage_upstream, float voltage_downstream)
@@ -255,6 +275,332 @@ void bl0937_set_power_multiplier(bl0937_t * const me, float power_multiplier)
 	me->power_multiplier = power_multiplier;
 }
 
+esp_err_t bl0937_estimate(bl0937_t * const me, bl0937_estimate_t * const estimate)
+{
+	bl0937_window_t windows[4];		/* The last ones, the latest first */
+	uint32_t count = 0;
+
+	memset(estimate, 0, sizeof(bl0937_estimate_t));
+
+	/* Same checks as the readings, the mode is switched if CF1 stopped */
+	check_cf_signal(me);
+	check_cf1_signal(me);
+
+	uint32_t sequence = me->sequence;
+
+	while(count < 4 && count < sequence && window_read(me, sequence - 1 - count, &windows[count]))
+		count++;
+
+	if(count == 0)
+		return ESP_ERR_INVALID_STATE;
+
+	/* The latest window and the one of the other mode before it. Without it the other mode read
+	 * nothing for two windows */
+	const bl0937_window_t * latest = &windows[0];
+	const bl0937_window_t * other = (count > 1 && windows[1].channel != latest->channel) ? &windows[1] : NULL;
+	float readings[BL0937_CHANNEL_MAX] = { 0 };
+	float errors[BL0937_CHANNEL_MAX] = { 0 };	/* Relative */
+
+	readings[latest->channel] = window_reading(me, latest);
+	errors[latest->channel] = timing_error(latest->time);
+
+	if(other != NULL)
+	{
+		readings[other->channel] = window_reading(me, other);
+		errors[other->channel] = timing_error(other->time);
+	}
+
+	/* CF whole periods over the current window, the power follows the current and the mains voltage
+	 * hardly moves. From earlier windows on while too slow for it */
+	uint32_t last = (other != NULL && other->channel == BL0937_CURRENT) ? 1 : 0;
+	const bl0937_window_t * window = &windows[last];
+	uint32_t edges = 0;
+	uint32_t time = 0;
+	uint32_t start = 0;
+	float misalignment = 1;		/* Time of the pulses out of the window, relative to it */
+
+	for(uint32_t i = last; i < count && edges < 2; i++)
+	{
+		if(windows[i].pulses == 0)
+			continue;
+
+		start = windows[i].cf_time[0];
+		edges = window->cf_count[1] - windows[i].cf_count[0];
+		time = window->cf_time[1] - start;
+	}
+
+	if(edges >= 2 && time > 0)
+	{
+		readings[BL0937_POWER] = me->power_multiplier * edges / time;
+		errors[BL0937_POWER] = timing_error(time);
+
+		if(window->end != window->start)
+			misalignment = fminf(1, (float)((window->start - start) + (window->end - window->cf_time[1])) / (window->end - window->start));
+	}
+	else if(me->power_pulse_width > 0)
+	{
+		/* Slower than the history, the last pulse is not of the same time */
+		readings[BL0937_POWER] = me->power_multiplier / me->power_pulse_width;
+		errors[BL0937_POWER] = timing_error(me->power_pulse_width) + ESTIMATE_TOLERANCE / 2;
+	}
+
+	/* Change of the load across the windows, from the previous ones of each mode. It only matters
+	 * for the pulses out of the window */
+	float change = (count < 4) ? ESTIMATE_TOLERANCE : 0;
+
+	for(uint32_t i = 2; i < count && other != NULL; i++)
+	{
+		float reading = window_reading(me, &windows[i]);
+		float current = readings[windows[i].channel];
+
+		if(windows[i].channel == windows[i - 2].channel && reading > 0 && current > 0)
+			change = fmaxf(change, fabsf(current - reading) / current);
+	}
+
+	estimate->voltage = readings[BL0937_VOLTAGE];
+	estimate->current = readings[BL0937_CURRENT];
+	estimate->active = readings[BL0937_POWER];
+	estimate->apparent = estimate->voltage * estimate->current;
+
+	if(estimate->apparent <= 0 || estimate->active <= 0)
+		return ESP_OK;
+
+	float power_factor = estimate->active / estimate->apparent;
+	float error = sqrtf(errors[BL0937_VOLTAGE] * errors[BL0937_VOLTAGE] + errors[BL0937_CURRENT] * errors[BL0937_CURRENT] +
+			errors[BL0937_POWER] * errors[BL0937_POWER] + change * change * misalignment * misalignment);
+
+	/* Above 1 by more than the error, the error is larger */
+	error = fmaxf(error, power_factor - 1);
+
+	estimate->power_factor = fminf(power_factor, 1);
+	estimate->confidence = fmaxf(0, 1 - error / ESTIMATE_TOLERANCE);
+
+	return ESP_OK;
+}
+
+void bl0937_calibration_start(bl0937_calibration_t * const cal, float voltage, float current, float power)
+{
+	memset(cal, 0, sizeof(bl0937_calibration_t));
+
+	cal->reference[BL0937_VOLTAGE] = voltage;
+	cal->reference[BL0937_CURRENT] = current;
+	cal->reference[BL0937_POWER] = power;
+	cal->min_samples = CALIBRATION_SAMPLES;
+	cal->max_samples = CALIBRATION_TIMEOUT;
+	cal->precision = CALIBRATION_PRECISION / 1000000.0;
+	cal->done = false;
+	cal->error = ESP_OK;
+}
+
+bool bl0937_calibration_update(bl0937_t * const me, bl0937_calibration_t * const cal)
+{
+	if(cal->done)
+		return true;
+
+	/* Same check as the readings, the mode is switched if CF1 stopped */
+	check_cf1_signal(me);
+
+	/* CF1 windows closed since the last update, the ones the ISR already overwrote are lost */
+	uint32_t sequence = me->sequence;
+
+	if(cal->updates > 0)
+	{
+		uint32_t first = (sequence - cal->sequence > WINDOW_HISTORY) ? sequence - WINDOW_HISTORY : cal->sequence;
+		bl0937_window_t window;
+
+		for(uint32_t i = first; i != sequence; i++)
+		{
+			if(window_read(me, i, &window) && window.pulses >= 2)
+				stats_add(&cal->stats[window.channel], (double)window.time / window.pulses);
+		}
+	}
+
+	cal->sequence = sequence;
+
+	/* CF pulses since the last update, whole periods as in the CF1 windows */
+	uint32_t count, time;
+
+	do
+	{
+		count = me->pulse_count;
+		time = me->last_cf_interrupt;
+	} while(count != me->pulse_count);
+
+	uint32_t pulses = count - cal->pulse_count;
+
+	/* Periods are counted from a pulse of a running signal, not across a stop of the load */
+	if(!cal->pulse_running || count < cal->pulse_count)
+	{
+		cal->pulse_count = count;
+		cal->pulse_time = time;
+		cal->pulse_running = cal->updates > 0 && pulses > 0;
+	}
+	else if(pulses == 0)
+		cal->pulse_running = false;
+	else if(pulses >= 2 && pulses % 2 == 0)
+	{
+		stats_add(&cal->stats[BL0937_POWER], (double)(time - cal->pulse_time) / pulses);
+		cal->pulse_count = count;
+		cal->pulse_time = time;
+	}
+
+	cal->updates++;
+
+	/* Ends once every mean is as precise as asked */
+	bool converged = true;
+	bool pulses_seen = true;
+
+	for(int i = 0; i < BL0937_CHANNEL_MAX; i++)
+	{
+		if(cal->stats[i].n < cal->min_samples || stats_error(&cal->stats[i]) > cal->precision)
+			converged = false;
+
+		if(cal->stats[i].n < 2)
+			pulses_seen = false;
+	}
+
+	if(converged)
+		cal->error = ESP_OK;
+	else if(cal->updates >= cal->max_samples)
+		cal->error = pulses_seen ? ESP_ERR_TIMEOUT : ESP_ERR_INVALID_RESPONSE;
+	else
+		return false;
+
+	cal->done = true;
+
+	return true;
+}
+
+esp_err_t bl0937_calibration_apply(bl0937_t * const me, const bl0937_calibration_t * const cal)
+{
+	float multipliers[BL0937_CHANNEL_MAX];
+
+	if(!cal->done || cal->error != ESP_OK)
+		return ESP_ERR_INVALID_STATE;
+
+	/* A reading is its multiplier over the pulse width */
+	for(int i = 0; i < BL0937_CHANNEL_MAX; i++)
+		multipliers[i] = cal->reference[i] * cal->stats[i].mean;
+
+	if(!multipliers_valid(me, multipliers))
+		return ESP_ERR_INVALID_RESPONSE;
+
+	me->voltage_multiplier = multipliers[BL0937_VOLTAGE];
+	me->current_multiplier = multipliers[BL0937_CURRENT];
+	me->power_multiplier = multipliers[BL0937_POWER];
+	me->temperature = NAN;
+	me->calibrated = true;
+
+	ESP_LOGI(TAG, "Calibrated in %" PRIu32 " updates", cal->updates);
+
+	return ESP_OK;
+}
+
+esp_err_t bl0937_calibration_save(bl0937_t * const me)
+{
+	hal_nvs_handle_t handle;
+	profile_t profile;
+
+	if(!me->calibrated)
+		return ESP_ERR_INVALID_STATE;
+
+	profile.version = PROFILE_VERSION;
+	profile.multipliers[BL0937_VOLTAGE] = me->voltage_multiplier;
+	profile.multipliers[BL0937_CURRENT] = me->current_multiplier;
+	profile.multipliers[BL0937_POWER] = me->power_multiplier;
+	profile.temperature = me->temperature;
+
+	esp_err_t ret = hal_nvs_open(NVS_PARTITION, NVS_NAMESPACE, true, &handle);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	ret = hal_nvs_set_blob(handle, NVS_KEY, &profile, sizeof(profile));
+
+	if(ret == ESP_OK)
+		ret = hal_nvs_commit(handle);
+
+	hal_nvs_close(handle);
+
+	return ret;
+}
+
+esp_err_t bl0937_calibration_restore(bl0937_t * const me)
+{
+	hal_nvs_handle_t handle;
+	profile_t profile;
+	size_t size = sizeof(profile);
+	esp_err_t ret = hal_nvs_open(NVS_PARTITION, NVS_NAMESPACE, false, &handle);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	ret = hal_nvs_get_blob(handle, NVS_KEY, &profile, &size);
+	hal_nvs_close(handle);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	if(profile.version == 1 && size == offsetof(profile_t, temperature))
+	{
+		profile.version = PROFILE_VERSION;
+		profile.temperature = NAN;
+		size = sizeof(profile);
+	}
+
+	/* The resistors may have been set to others since */
+	if(size != sizeof(profile) || profile.version != PROFILE_VERSION || !multipliers_valid(me, profile.multipliers))
+	{
+		ESP_LOGW(TAG, "Discarding the stored calibration");
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	me->voltage_multiplier = profile.multipliers[BL0937_VOLTAGE];
+	me->current_multiplier = profile.multipliers[BL0937_CURRENT];
+	me->power_multiplier = profile.multipliers[BL0937_POWER];
+	me->temperature = profile.temperature;
+	me->calibrated = true;
+
+	return ESP_OK;
+}
+
+esp_err_t bl0937_calibration_erase(bl0937_t * const me)
+{
+	hal_nvs_handle_t handle;
+	esp_err_t ret = hal_nvs_open(NVS_PARTITION, NVS_NAMESPACE, true, &handle);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	ret = hal_nvs_erase_key(handle, NVS_KEY);
+
+	if(ret == ESP_OK || ret == ESP_ERR_NOT_FOUND)
+		ret = hal_nvs_commit(handle);
+
+	hal_nvs_close(handle);
+
+	if(ret == ESP_OK)
+		bl0937_reset_multipliers(me);
+
+	return ret;
+}
+
+int bl0937_calibration_print(const bl0937_t * const me, const bl0937_calibration_t * const cal, char * buf, size_t size)
+{
+	int len = snprintf(buf, size, "{\"calibration\":\"%s\",\"updates\":%" PRIu32 ",\"samples\":[%" PRIu32 ",%" PRIu32 ",%" PRIu32 "],"
+			"\"precision\":[%.0f,%.0f,%.0f],\"multipliers\":[%.1f,%.1f,%.1f],\"calibrated\":%s}",
+			esp_err_to_name(cal->error), cal->updates,
+			cal->stats[BL0937_VOLTAGE].n, cal->stats[BL0937_CURRENT].n, cal->stats[BL0937_POWER].n,
+			stats_error(&cal->stats[BL0937_VOLTAGE]) * 1000000, stats_error(&cal->stats[BL0937_CURRENT]) * 1000000,
+			stats_error(&cal->stats[BL0937_POWER]) * 1000000,
+			me->voltage_multiplier, me->current_multiplier, me->power_multiplier, me->calibrated ? "true" : "false");
+
+	if(len < 0 || (size_t)len >= size)
+		return -1;
+
+	return len;
+}
+
 /* internal functions definition ---------------------------------------------*/
 
 static void calculate_default_multipliers(bl0937_t * const me)
@@ -264,15 +610,83 @@ static void calculate_default_multipliers(bl0937_t * const me)
     me->current_multiplier = (531500000.0 * me->vref / me->current_resistor / 24.0 / F_OSC) / 1.166666f; //
 }
 
+/* Multipliers within CALIBRATION_RANGE of the nominal ones of the resistors */
+static bool multipliers_valid(bl0937_t * const me, const float * multipliers)
+{
+	bl0937_t nominal;
+
+	nominal.vref = me->vref;
+	nominal.voltage_resistor = me->voltage_resistor;
+	nominal.current_resistor = me->current_resistor;
+	calculate_default_multipliers(&nominal);
+
+	const float nominals[BL0937_CHANNEL_MAX] =
+	{
+		nominal.voltage_multiplier, nominal.current_multiplier, nominal.power_multiplier
+	};
+
+	for(int i = 0; i < BL0937_CHANNEL_MAX; i++)
+	{
+		if(!(multipliers[i] >= nominals[i] / CALIBRATION_RANGE && multipliers[i] <= nominals[i] * CALIBRATION_RANGE))
+			return false;
+	}
+
+	return true;
+}
+
+/* Welford's running mean and variance */
+static void stats_add(bl0937_stats_t * stats, double value)
+{
+	double delta = value - stats->mean;
+
+	stats->n++;
+	stats->mean += delta / stats->n;
+	stats->m2 += delta * (value - stats->mean);
+}
+
+/* Standard error of the mean relative to it, 1 with less than two samples */
+static double stats_error(const bl0937_stats_t * stats)
+{
+	if(stats->n < 2 || stats->mean <= 0)
+		return 1;
+
+	return sqrt(stats->m2 / (stats->n - 1) / stats->n) / stats->mean;
+}
+
+/* Copy a window of the history. Returns false if the ISR overwrote it meanwhile */
+static bool window_read(bl0937_t * const me, uint32_t sequence, bl0937_window_t * window)
+{
+	*window = me->history[sequence % WINDOW_HISTORY];
+
+	return me->sequence - sequence <= WINDOW_HISTORY - 1;
+}
+
+/* Reading of a window, its multiplier over the mean pulse width */
+static float window_reading(const bl0937_t * const me, const bl0937_window_t * window)
+{
+	if(window->pulses == 0 || window->time == 0)
+		return 0;
+
+	float multiplier = (window->channel == BL0937_VOLTAGE) ? me->voltage_multiplier : me->current_multiplier;
+
+	return multiplier * window->pulses / window->time;
+}
+
+/* Relative error of a time measured between two edges */
+static float timing_error(uint32_t time)
+{
+	return (time > 0) ? 1.41421356f * ESTIMATE_JITTER / time : 1;
+}
+
 static void check_cf_signal(bl0937_t * const me)
 {
-	if ((esp_timer_get_time() - me->last_cf_interrupt) > me->pulse_timeout)
+	if ((hal_time_us() - me->last_cf_interrupt) > me->pulse_timeout)
 		me->power_pulse_width = 0;
 }
 
 static void check_cf1_signal(bl0937_t * const me)
 {
-    if ((esp_timer_get_time() - me->last_cf1_interrupt) > me->pulse_timeout)
+    if ((hal_time_us() - me->last_cf1_interrupt) > me->pulse_timeout)
     {
         if(me->mode == me->current_mode)
         	me->current_pulse_width = 0;
@@ -286,19 +700,25 @@ static void check_cf1_signal(bl0937_t * const me)
 static void IRAM_ATTR cf_isr(void * arg)
 {
 	bl0937_t * me = (bl0937_t *)arg;
-	uint32_t now = esp_timer_get_time();
+	uint32_t now = hal_time_us();
 
 	me->power_pulse_width = now - me->last_cf_interrupt;
 	me->last_cf_interrupt = now;
 	me->pulse_count++;
 
+	if((me->pulse_count & 1) == 0)
+	{
+		me->cf_period_count = me->pulse_count;
+		me->cf_period_time = now;
+	}
+
 	portYIELD_FROM_ISR();
 }
 
 static void IRAM_ATTR cf1_isr(void * arg)
 {
 	bl0937_t * me = (bl0937_t *)arg;
-    uint32_t now = esp_timer_get_time();
+    uint32_t now = hal_time_us();
 
     if((now - me->first_cf1_interrupt) > me->pulse_timeout)
     {
@@ -314,10 +734,35 @@ static void IRAM_ATTR cf1_isr(void * arg)
         else
             me->voltage_pulse_width = pulse_width;
 
+        /* Whole periods of the window from its second edge, the first one follows the mode switch
+         * and the high and low times may differ */
+        int channel = (me->mode == me->current_mode) ? BL0937_CURRENT : BL0937_VOLTAGE;
+        uint32_t pulses = (me->cf1_edges > 0) ? (me->cf1_edges - 1) & ~1UL : 0;
+
+        volatile bl0937_window_t * window = &me->history[me->sequence % WINDOW_HISTORY];
+
+        window->channel = channel;
+        window->start = me->cf1_window_start;
+        window->end = now;
+        window->time = (pulses >= 2) ? ((me->cf1_edges % 2 == 1) ? now : me->last_cf1_interrupt) - me->cf1_window_start : 0;
+        window->pulses = (pulses >= 2) ? pulses : 0;
+        window->cf_count[0] = me->cf1_window_cf_count;
+        window->cf_time[0] = me->cf1_window_cf_time;
+        window->cf_count[1] = me->cf_period_count;
+        window->cf_time[1] = me->cf_period_time;
+        me->sequence++;
+
         me->mode = 1 - me->mode;
 
-        gpio_set_level(me->sel_pin, me->mode);
+        hal_gpio_set_level(me->sel_pin, me->mode);
         me->first_cf1_interrupt = now;
+        me->cf1_edges = 0;
+    }
+    else if(++me->cf1_edges == 2)
+    {
+    	me->cf1_window_start = now;
+    	me->cf1_window_cf_count = me->cf_period_count;
+    	me->cf1_window_cf_time = me->cf_period_time;
     }
 
     me->last_cf1_interrupt = now;
@@ -0,0 +1,340 @@
+/*
+ * bl0937_drift.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <inttypes.h>
+
+#include "include/bl0937_drift.h"
+#include "bitec_hal.h"
+#include "esp_log.h"
+#include "cJSON.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define NVS_PARTITION		"settings"
+#define NVS_NAMESPACE		"bl0937"
+#define NVS_KEY				"drift"
+#define CURVE_VERSION		1
+#define TEMPERATURE_MIN		-40			/*!< Range of the chip sensor in Celsius */
+#define TEMPERATURE_MAX		125
+
+/* typedef -------------------------------------------------------------------*/
+
+/* Stored curve, the version and then its points */
+typedef struct
+{
+	float temperature;
+	int32_t corrections[2];
+} point_t;
+
+typedef struct
+{
+	uint32_t version;
+	point_t points[DRIFT_POINTS];
+} curve_t;
+
+/* internal data declaration -------------------------------------------------*/
+
+static const char * TAG = "bl0937_drift";
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static double factor(const bl0937_drift_t * const drift, bl0937_channel_e channel, float celsius);
+static int print_temperature(char * buf, size_t size, float celsius);
+
+/* external functions definition ---------------------------------------------*/
+
+void bl0937_drift_init(bl0937_drift_t * const drift)
+{
+	memset(drift, 0, sizeof(bl0937_drift_t));
+
+	drift->step = DRIFT_STEP;
+	drift->filter = DRIFT_FILTER;
+	drift->temperature = NAN;
+	drift->applied = NAN;
+	drift->base_temperature = NAN;
+}
+
+esp_err_t bl0937_drift_parse(bl0937_drift_t * const drift, const char * data, size_t len)
+{
+	float temperatures[DRIFT_POINTS];
+	int32_t corrections[2][DRIFT_POINTS];
+	esp_err_t ret = ESP_OK;
+	cJSON * root = cJSON_ParseWithLength(data, len);
+	const cJSON * temperature = cJSON_GetObjectItem(root, "temperature");
+	const cJSON * arrays[2] =
+	{
+		cJSON_GetObjectItem(root, "voltage"), cJSON_GetObjectItem(root, "current")
+	};
+
+	int points = cJSON_IsArray(temperature) ? cJSON_GetArraySize(temperature) : -1;
+
+	if(points < 0 || points > DRIFT_POINTS)
+		ret = ESP_ERR_INVALID_ARG;
+
+	/* Both corrections at every temperature, an empty curve needs none */
+	for(int i = 0; i < 2 && ret == ESP_OK && points > 0; i++)
+	{
+		if(!cJSON_IsArray(arrays[i]) || cJSON_GetArraySize(arrays[i]) != points)
+			ret = ESP_ERR_INVALID_ARG;
+	}
+
+	for(int i = 0; i < points && ret == ESP_OK; i++)
+	{
+		const cJSON * item = cJSON_GetArrayItem(temperature, i);
+
+		if(!cJSON_IsNumber(item) || !(item->valuedouble >= TEMPERATURE_MIN && item->valuedouble <= TEMPERATURE_MAX) ||
+				(i > 0 && item->valuedouble <= temperatures[i - 1]))
+		{
+			ret = ESP_ERR_INVALID_ARG;
+			break;
+		}
+
+		temperatures[i] = item->valuedouble;
+
+		for(int j = 0; j < 2; j++)
+		{
+			item = cJSON_GetArrayItem(arrays[j], i);
+
+			if(!cJSON_IsNumber(item) || !(fabs(item->valuedouble) <= DRIFT_CORRECTION_MAX))
+			{
+				ret = ESP_ERR_INVALID_ARG;
+				break;
+			}
+
+			corrections[j][i] = (int32_t)item->valuedouble;
+		}
+	}
+
+	cJSON_Delete(root);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	memcpy(drift->temperatures, temperatures, points * sizeof(float));
+	memcpy(drift->corrections[BL0937_VOLTAGE], corrections[BL0937_VOLTAGE], points * sizeof(int32_t));
+	memcpy(drift->corrections[BL0937_CURRENT], corrections[BL0937_CURRENT], points * sizeof(int32_t));
+	drift->points = points;
+	drift->applied = NAN;
+
+	return ESP_OK;
+}
+
+void bl0937_drift_clear(bl0937_drift_t * const drift)
+{
+	drift->points = 0;
+	drift->applied = NAN;
+}
+
+esp_err_t bl0937_drift_save(const bl0937_drift_t * const drift)
+{
+	hal_nvs_handle_t handle;
+	curve_t curve;
+	esp_err_t ret = hal_nvs_open(NVS_PARTITION, NVS_NAMESPACE, true, &handle);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	if(drift->points == 0)
+	{
+		ret = hal_nvs_erase_key(handle, NVS_KEY);
+
+		if(ret == ESP_ERR_NOT_FOUND)
+			ret = ESP_OK;
+	}
+	else
+	{
+		curve.version = CURVE_VERSION;
+
+		for(int i = 0; i < drift->points; i++)
+		{
+			curve.points[i].temperature = drift->temperatures[i];
+			curve.points[i].corrections[BL0937_VOLTAGE] = drift->corrections[BL0937_VOLTAGE][i];
+			curve.points[i].corrections[BL0937_CURRENT] = drift->corrections[BL0937_CURRENT][i];
+		}
+
+		/* Only the points of the curve */
+		ret = hal_nvs_set_blob(handle, NVS_KEY, &curve, offsetof(curve_t, points) + drift->points * sizeof(point_t));
+	}
+
+	if(ret == ESP_OK)
+		ret = hal_nvs_commit(handle);
+
+	hal_nvs_close(handle);
+
+	return ret;
+}
+
+esp_err_t bl0937_drift_restore(bl0937_drift_t * const drift)
+{
+	hal_nvs_handle_t handle;
+	curve_t curve;
+	size_t size = sizeof(curve);
+	esp_err_t ret = hal_nvs_open(NVS_PARTITION, NVS_NAMESPACE, false, &handle);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	ret = hal_nvs_get_blob(handle, NVS_KEY, &curve, &size);
+	hal_nvs_close(handle);
+
+	if(ret != ESP_OK)
+		return ret;
+
+	size_t points = (size > offsetof(curve_t, points)) ? (size - offsetof(curve_t, points)) / sizeof(point_t) : 0;
+
+	if(curve.version != CURVE_VERSION || points == 0 || offsetof(curve_t, points) + points * sizeof(point_t) != size)
+	{
+		ESP_LOGW(TAG, "Discarding the stored curve");
+		return ESP_ERR_INVALID_SIZE;
+	}
+
+	for(size_t i = 0; i < points; i++)
+	{
+		drift->temperatures[i] = curve.points[i].temperature;
+		drift->corrections[BL0937_VOLTAGE][i] = curve.points[i].corrections[BL0937_VOLTAGE];
+		drift->corrections[BL0937_CURRENT][i] = curve.points[i].corrections[BL0937_CURRENT];
+	}
+
+	drift->points = points;
+	drift->applied = NAN;
+
+	return ESP_OK;
+}
+
+void bl0937_drift_rebase(bl0937_t * const me, bl0937_drift_t * const drift)
+{
+	drift->base[BL0937_VOLTAGE] = me->voltage_multiplier;
+	drift->base[BL0937_CURRENT] = me->current_multiplier;
+	drift->base[BL0937_POWER] = me->power_multiplier;
+	drift->base_temperature = me->temperature;
+	drift->applied = NAN;
+}
+
+bool bl0937_drift_update(bl0937_t * const me, bl0937_drift_t * const drift, float celsius)
+{
+	if(isnan(celsius))
+		return false;
+
+	drift->samples++;
+
+	/* Moving average, the sensor is noisy and the enclosure slow */
+	if(isnan(drift->temperature))
+		drift->temperature = celsius;
+	else
+		drift->temperature += (celsius - drift->temperature) / drift->filter;
+
+	if(!isnan(drift->applied) && fabsf(drift->temperature - drift->applied) < drift->step)
+		return false;
+
+	double voltage = factor(drift, BL0937_VOLTAGE, drift->temperature);
+	double current = factor(drift, BL0937_CURRENT, drift->temperature);
+
+	me->voltage_multiplier = drift->base[BL0937_VOLTAGE] * voltage;
+	me->current_multiplier = drift->base[BL0937_CURRENT] * current;
+	me->power_multiplier = drift->base[BL0937_POWER] * voltage * current;
+
+	drift->applied = drift->temperature;
+	drift->updates++;
+
+	return true;
+}
+
+int32_t bl0937_drift_correction(const bl0937_drift_t * const drift, bl0937_channel_e channel, float celsius)
+{
+	if(channel == BL0937_POWER)
+	{
+		double voltage = bl0937_drift_correction(drift, BL0937_VOLTAGE, celsius) / 1e6;
+		double current = bl0937_drift_correction(drift, BL0937_CURRENT, celsius) / 1e6;
+
+		return lround(((1 + voltage) * (1 + current) - 1) * 1e6);
+	}
+
+	if(drift->points == 0 || isnan(celsius))
+		return 0;
+
+	const int32_t * corrections = drift->corrections[channel];
+
+	if(celsius <= drift->temperatures[0])
+		return corrections[0];
+
+	for(int i = 1; i < drift->points; i++)
+	{
+		if(celsius <= drift->temperatures[i])
+		{
+			float t = (celsius - drift->temperatures[i - 1]) / (drift->temperatures[i] - drift->temperatures[i - 1]);
+
+			return lroundf(corrections[i - 1] + t * (corrections[i] - corrections[i - 1]));
+		}
+	}
+
+	return corrections[drift->points - 1];
+}
+
+int bl0937_drift_print(const bl0937_drift_t * const drift, char * buf, size_t size)
+{
+	int len = snprintf(buf, size, "{\"temperature\":");
+	int ret;
+
+	if(len < 0 || (size_t)len >= size)
+		return -1;
+
+	ret = print_temperature(buf + len, size - len, drift->temperature);
+
+	if(ret < 0)
+		return -1;
+
+	len += ret;
+	ret = snprintf(buf + len, size - len, ",\"applied\":");
+
+	if(ret < 0 || (size_t)ret >= size - len)
+		return -1;
+
+	len += ret;
+	ret = print_temperature(buf + len, size - len, drift->applied);
+
+	if(ret < 0)
+		return -1;
+
+	len += ret;
+	ret = snprintf(buf + len, size - len, ",\"voltage\":%" PRId32 ",\"current\":%" PRId32 ",\"points\":%u,\"samples\":%" PRIu32 ",\"updates\":%" PRIu32 "}",
+			bl0937_drift_correction(drift, BL0937_VOLTAGE, drift->applied), bl0937_drift_correction(drift, BL0937_CURRENT, drift->applied),
+			drift->points, drift->samples, drift->updates);
+
+	if(ret < 0 || (size_t)ret >= size - len)
+		return -1;
+
+	return len + ret;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* Of a base multiplier to its value at a temperature */
+static double factor(const bl0937_drift_t * const drift, bl0937_channel_e channel, float celsius)
+{
+	return (1 + bl0937_drift_correction(drift, channel, celsius) / 1e6) /
+			(1 + bl0937_drift_correction(drift, channel, drift->base_temperature) / 1e6);
+}
+
+/* A temperature in JSON, null while unknown */
+static int print_temperature(char * buf, size_t size, float celsius)
+{
+	int len = isnan(celsius) ? snprintf(buf, size, "null") : snprintf(buf, size, "%.1f", celsius);
+
+	if(len < 0 || (size_t)len >= size)
+		return -1;
+
+	return len;
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -18,9 +18,9 @@
 
 #include "esp_log.h"
 #include "esp_err.h"
-#include "esp_timer.h"
+#include "esp_attr.h"
 
-#include "driver/gpio.h"
+#include "bitec_hal.h"
 
 /* cplusplus -----------------------------------------------------------------*/
 
@@ -35,6 +35,35 @@ extern "C" {
 #define READING_INTERVAL	3000			/*!< Minimum delay between selecting a mode and reading a sample */
 #define PULSE_TIMEOUT		200000			/*!< Maximum pulse with in microseconds */
 
+#ifdef CONFIG_BL0937_CALIBRATION_SAMPLES
+#define CALIBRATION_SAMPLES		CONFIG_BL0937_CALIBRATION_SAMPLES
+#else
+#define CALIBRATION_SAMPLES		8
+#endif
+
+#ifdef CONFIG_BL0937_CALIBRATION_TIMEOUT
+#define CALIBRATION_TIMEOUT		CONFIG_BL0937_CALIBRATION_TIMEOUT
+#else
+#define CALIBRATION_TIMEOUT		120
+#endif
+
+#ifdef CONFIG_BL0937_CALIBRATION_PRECISION
+#define CALIBRATION_PRECISION	CONFIG_BL0937_CALIBRATION_PRECISION
+#else
+#define CALIBRATION_PRECISION	200
+#endif
+
+#define CALIBRATION_RANGE		4.0				/*!< Calibrated multipliers are within this factor of the nominal ones */
+
+#ifdef CONFIG_BL0937_ESTIMATE_TOLERANCE
+#define ESTIMATE_TOLERANCE		(CONFIG_BL0937_ESTIMATE_TOLERANCE / 1000.0f)
+#else
+#define ESTIMATE_TOLERANCE		0.02f
+#endif
+
+#define ESTIMATE_JITTER			20				/*!< Timing error of a pulse edge in us, the interrupt latency */
+#define WINDOW_HISTORY			8				/*!< CF1 windows kept, of both modes */
+
 /* typedef -------------------------------------------------------------------*/
 
 typedef enum
@@ -43,11 +72,71 @@ typedef enum
 	MODE_VOLTAGE		/*!<  */
 } bl0937_mode_e;
 
+typedef enum
+{
+	BL0937_VOLTAGE = 0,
+	BL0937_CURRENT,
+	BL0937_POWER,
+	BL0937_CHANNEL_MAX
+} bl0937_channel_e;
+
+/* A CF1 window, from its second edge to the mode switch, and the CF pulses meanwhile */
+typedef struct
+{
+	uint8_t channel;			/*!< BL0937_VOLTAGE or BL0937_CURRENT */
+	uint32_t start;				/*!< Time of its second edge in us */
+	uint32_t end;				/*!< Time of the mode switch */
+	uint32_t time;				/*!< Of its whole periods */
+	uint32_t pulses;			/*!< Pulse widths in them, 0 for a window without a whole period */
+	uint32_t cf_count[2];		/*!< CF edges of whole periods at its start and end */
+	uint32_t cf_time[2];		/*!< Time of the last of them */
+} bl0937_window_t;
+
+/* Readings of a voltage and a current window next to each other, and of the CF pulses over both. The
+ * BL0937 outputs are of the true RMS and active power, the power factor is their ratio whatever the
+ * harmonics of the load */
+typedef struct
+{
+	float voltage;				/*!< RMS in V */
+	float current;				/*!< RMS in A */
+	float active;				/*!< In W */
+	float apparent;				/*!< In VA */
+	float power_factor;			/*!< 0 to 1, 0 without a load */
+	float confidence;			/*!< 0 to 1, 0 at an uncertainty of the power factor of ESTIMATE_TOLERANCE */
+} bl0937_estimate_t;
+
+/* Running mean and variance of the pulse widths of a channel */
+typedef struct
+{
+	uint32_t n;
+	double mean;
+	double m2;
+} bl0937_stats_t;
+
+typedef struct
+{
+	/* Configuration, set by bl0937_calibration_start() */
+	float reference[BL0937_CHANNEL_MAX];	/*!< Reference load in V, A and W */
+	uint32_t min_samples;		/*!< Pulse widths averaged at least, per channel */
+	uint32_t max_samples;		/*!< Updates before the calibration is given up */
+	float precision;			/*!< Relative standard error of every mean to end at */
+
+	/* State */
+	bl0937_stats_t stats[BL0937_CHANNEL_MAX];
+	uint32_t updates;
+	uint32_t sequence;			/*!< CF1 windows already taken */
+	uint32_t pulse_count;		/*!< CF edges and time of the last one already taken */
+	uint32_t pulse_time;
+	bool pulse_running;			/*!< CF pulses seen by the last update, from pulse_count on */
+	bool done;
+	esp_err_t error;			/*!< Of an ended calibration */
+} bl0937_calibration_t;
+
 typedef struct
 {
-	gpio_num_t sel_pin;
-	gpio_num_t cf_pin;
-	gpio_num_t cf1_pin;
+	int sel_pin;
+	int cf_pin;
+	int cf1_pin;
 	float current_resistor;
 	float voltage_resistor;
 	float vref;
@@ -67,6 +156,16 @@ typedef struct
 	volatile uint32_t last_cf_interrupt;
 	volatile uint32_t last_cf1_interrupt;
 	volatile uint32_t first_cf1_interrupt;
+	volatile uint32_t cf1_edges;			/*!< Edges since the mode switch */
+	volatile uint32_t cf1_window_start;		/*!< Second of them, the start of the window */
+	volatile uint32_t cf_period_count;		/*!< CF edges ending a whole period, and time of the last one */
+	volatile uint32_t cf_period_time;
+	volatile uint32_t cf1_window_cf_count;	/*!< Of them at the start of the window */
+	volatile uint32_t cf1_window_cf_time;
+	volatile bl0937_window_t history[WINDOW_HISTORY];	/*!< Windows closed, the last one at sequence - 1 */
+	volatile uint32_t sequence;				/*!< Windows closed */
+	bool calibrated;						/*!< Multipliers of a stored calibration */
+	float temperature;						/*!< Of the chip the multipliers hold at in Celsius, NAN if unknown */
 } bl0937_t;
 
 /* external data declaration -------------------------------------------------*/
@@ -95,6 +194,34 @@ void bl0937_set_current_multiplier(bl0937_t * const me, float current_multiplier
 void bl0937_set_voltage_multiplier(bl0937_t * const me, float voltage_multiplier);
 void bl0937_set_power_multiplier(bl0937_t * const me, float power_multiplier);
 
+/* Readings of the last voltage and current windows, and of the CF pulses over the same time. A mode
+ * without a signal for two windows of the other reads 0. The confidence falls with the timing error
+ * of the windows and with the change of the load across them. Returns ESP_ERR_INVALID_STATE with
+ * every reading 0 before the first windows */
+esp_err_t bl0937_estimate(bl0937_t * const me, bl0937_estimate_t * const estimate);
+
+/* Calibration against a reference load of voltage in V, current in A and active power in W. Every
+ * update, once per reading period, averages the widths of the CF1 windows closed since the last one,
+ * the last WINDOW_HISTORY of them at most, and of the CF pulses between them. Returns true once it
+ * ended: error is ESP_OK once every mean reached the precision, ESP_ERR_TIMEOUT if one did not within
+ * max_samples updates and ESP_ERR_INVALID_RESPONSE for a channel without pulses */
+void bl0937_calibration_start(bl0937_calibration_t * const cal, float voltage, float current, float power);
+bool bl0937_calibration_update(bl0937_t * const me, bl0937_calibration_t * const cal);
+
+/* Set the multipliers of a calibration ended with ESP_OK, their temperature is left to be set. Returns
+ * ESP_ERR_INVALID_RESPONSE if one is not within CALIBRATION_RANGE of the nominal, as with a wrong
+ * reference */
+esp_err_t bl0937_calibration_apply(bl0937_t * const me, const bl0937_calibration_t * const cal);
+
+/* Multipliers in the settings NVS partition, with the temperature they hold at. bl0937_init() restores
+ * them, erasing them goes back to the nominal ones */
+esp_err_t bl0937_calibration_save(bl0937_t * const me);
+esp_err_t bl0937_calibration_restore(bl0937_t * const me);
+esp_err_t bl0937_calibration_erase(bl0937_t * const me);
+
+/* Print the result of a calibration as JSON. Returns its length or -1 if it does not fit */
+int bl0937_calibration_print(const bl0937_t * const me, const bl0937_calibration_t * const cal, char * buf, size_t size);
+
 /* cplusplus -----------------------------------------------------------------*/
 
 #ifdef __cplusplus
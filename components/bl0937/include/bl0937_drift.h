@@ -0,0 +1,123 @@
+/*
+ * bl0937_drift.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _BL0937_DRIFT_H_
+#define _BL0937_DRIFT_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "bl0937.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#ifdef CONFIG_BL0937_DRIFT_POINTS
+#define DRIFT_POINTS			CONFIG_BL0937_DRIFT_POINTS
+#else
+#define DRIFT_POINTS			8
+#endif
+
+#ifdef CONFIG_BL0937_DRIFT_STEP
+#define DRIFT_STEP				(CONFIG_BL0937_DRIFT_STEP / 10.0f)
+#else
+#define DRIFT_STEP				0.5f
+#endif
+
+#ifdef CONFIG_BL0937_DRIFT_FILTER
+#define DRIFT_FILTER			CONFIG_BL0937_DRIFT_FILTER
+#else
+#define DRIFT_FILTER			8
+#endif
+
+#define DRIFT_CORRECTION_MAX	100000		/*!< Largest correction in ppm */
+
+/* A correction curve is a JSON object of the chip temperatures in Celsius, ascending, and the
+ * corrections in ppm of the voltage and current multipliers at them:
+ *
+ *     {"temperature":[25,45,65],"voltage":[0,-1200,-2600],"current":[0,3600,7500]}
+ *
+ * Between two points the correction is interpolated, beyond the ends it is the one of the end. The
+ * power multiplier takes both. An empty temperature array removes the curve */
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef struct
+{
+	/* Curve, of the device */
+	float temperatures[DRIFT_POINTS];
+	int32_t corrections[2][DRIFT_POINTS];	/*!< Of the voltage and the current, indexed by bl0937_channel_e */
+	uint8_t points;				/*!< 0 for none, the multipliers are not corrected */
+
+	/* Configuration, set from Kconfig by bl0937_drift_init() */
+	float step;					/*!< Change of the temperature in Celsius the multipliers are corrected again at */
+	uint32_t filter;			/*!< Samples of the temperature average */
+
+	/* State */
+	float temperature;			/*!< Average of the samples, NAN before the first one */
+	float applied;				/*!< Temperature of the correction in use, NAN to correct on the next sample */
+	float base[BL0937_CHANNEL_MAX];	/*!< Multipliers as set */
+	float base_temperature;		/*!< They hold at, NAN for no correction */
+
+	/* Metrics */
+	uint32_t samples;
+	uint32_t updates;			/*!< Corrections of the multipliers */
+} bl0937_drift_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Set the configuration from Kconfig, without a curve */
+void bl0937_drift_init(bl0937_drift_t * const drift);
+
+/* Take a correction curve of len bytes. Returns ESP_ERR_INVALID_ARG and keeps the curve in use for a
+ * malformed one, temperatures not ascending or a correction beyond DRIFT_CORRECTION_MAX */
+esp_err_t bl0937_drift_parse(bl0937_drift_t * const drift, const char * data, size_t len);
+
+/* Remove the curve, the base multipliers are back on the next sample */
+void bl0937_drift_clear(bl0937_drift_t * const drift);
+
+/* Curve in the settings NVS partition, saving none erases it */
+esp_err_t bl0937_drift_save(const bl0937_drift_t * const drift);
+esp_err_t bl0937_drift_restore(bl0937_drift_t * const drift);
+
+/* Take the multipliers in use as the base ones, at the temperature of the instance or at no correction
+ * if it is unknown, as the nominal ones. To call after they are set otherwise, by a calibration or an
+ * erase. They are corrected again on the next sample, as after a new curve */
+void bl0937_drift_rebase(bl0937_t * const me, bl0937_drift_t * const drift);
+
+/* Take a sample of the chip temperature. The multipliers are only corrected once the average moved
+ * by step since the last correction, the readings take them as they are. Returns true if corrected */
+bool bl0937_drift_update(bl0937_t * const me, bl0937_drift_t * const drift, float celsius);
+
+/* Correction of a multiplier in ppm at a temperature */
+int32_t bl0937_drift_correction(const bl0937_drift_t * const drift, bl0937_channel_e channel, float celsius);
+
+/* Print the state as JSON. Returns its length or -1 if it does not fit */
+int bl0937_drift_print(const bl0937_drift_t * const drift, char * buf, size_t size);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _BL0937_DRIFT_H_ */
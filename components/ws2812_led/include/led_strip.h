@@ -18,6 +18,7 @@ extern "C" {
 #endif
 
 #include "esp_err.h"
+#include "bitec_hal.h"
 
 /**
 * @brief LED Strip Type
@@ -31,6 +32,12 @@ typedef struct led_strip_s led_strip_t;
 */
 typedef void *led_strip_dev_t;
 
+/**
+* @brief Called from interrupt context when the pixels started by present() reached the strip
+*
+*/
+typedef void (*led_strip_present_cb_t)(led_strip_t *strip, void *arg);
+
 /**
 * @brief Declare of LED Strip Type
 *
@@ -52,6 +59,46 @@ struct led_strip_s {
     */
     esp_err_t (*set_pixel)(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue);
 
+    /**
+    * @brief Start sending the pixels set since the last present and return at once
+    *
+    * @param strip: LED strip
+    *
+    * @return
+    *      - ESP_OK: Transfer started, or no pixel changed and there is nothing to send
+    *      - ESP_ERR_INVALID_STATE: The previous transfer is still running
+    *      - ESP_FAIL: Transfer failed because some other error occurred
+    *
+    * @note:
+    *      Pixels are set on a back buffer while the front one is sent, both are swapped here.
+    *      Only the strip up to the last changed pixel is sent, the following LEDs keep their color.
+    */
+    esp_err_t (*present)(led_strip_t *strip);
+
+    /**
+    * @brief Wait until the last present transfer is done
+    *
+    * @param strip: LED strip
+    * @param timeout_ms: timeout value for waiting
+    *
+    * @return
+    *      - ESP_OK: No transfer running
+    *      - ESP_ERR_TIMEOUT: The transfer is still running
+    */
+    esp_err_t (*wait)(led_strip_t *strip, uint32_t timeout_ms);
+
+    /**
+    * @brief Set the function called when a present transfer is done
+    *
+    * @param strip: LED strip
+    * @param callback: function called from interrupt context, NULL for none
+    * @param arg: argument of the callback
+    *
+    * @return
+    *      - ESP_OK: Callback set successfully
+    */
+    esp_err_t (*set_present_callback)(led_strip_t *strip, led_strip_present_cb_t callback, void *arg);
+
     /**
     * @brief Refresh memory colors to LEDs
     *
@@ -65,6 +112,7 @@ struct led_strip_s {
     *
     * @note:
     *      After updating the LED colors in the memory, a following invocation of this API is needed to flush colors to strip.
+    *      This is present() followed by wait().
     */
     esp_err_t (*refresh)(led_strip_t *strip, uint32_t timeout_ms);
 
@@ -121,6 +169,14 @@ typedef struct {
 */
 led_strip_t *led_strip_new_rmt_ws2812(const led_strip_config_t *config);
 
+/**
+* @brief RMT translator of the ws2812 driver, converts GRB bytes to RMT items
+*
+* @note Bit timings are set by led_strip_new_rmt_ws2812()
+*/
+void ws2812_rmt_adapter(const void *src, hal_rmt_item_t *dest, size_t src_size,
+        size_t wanted_num, size_t *translated_size, size_t *item_num);
+
 #ifdef __cplusplus
 }
 #endif
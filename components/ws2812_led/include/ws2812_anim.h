@@ -0,0 +1,115 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#pragma once
+#include <stdint.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Animation effects
+ *
+ */
+typedef enum {
+    WS2812_ANIM_SOLID = 0,  /*!< Whole strip in the color */
+    WS2812_ANIM_BLINK,      /*!< Color the first half of the period, off the second half */
+    WS2812_ANIM_BREATHE,    /*!< Brightness up and down once per period */
+    WS2812_ANIM_CHASE,      /*!< Block of width LEDs fading at its tail, one pass along the strip per period */
+    WS2812_ANIM_FADE_TO,    /*!< Fade from the current frame to the color in one period, then hold it */
+} ws2812_anim_type_t;
+
+/**
+ * @brief Easing curves, applied to the position in the period
+ *
+ */
+typedef enum {
+    WS2812_EASE_LINEAR = 0, /*!< Constant speed */
+    WS2812_EASE_IN,         /*!< Quadratic, slow start */
+    WS2812_EASE_OUT,        /*!< Quadratic, slow end */
+    WS2812_EASE_IN_OUT,     /*!< Smoothstep, slow start and end */
+} ws2812_anim_ease_t;
+
+/**
+ * @brief Animation descriptor, copied by ws2812_anim_post()
+ *
+ */
+typedef struct {
+    ws2812_anim_type_t type; /*!< Effect */
+    ws2812_anim_ease_t ease; /*!< Easing of breathe, chase and fade to */
+    uint8_t red;             /*!< Intensity of Red color (0-255), before gamma correction */
+    uint8_t green;           /*!< Intensity of Green color (0-255), before gamma correction */
+    uint8_t blue;            /*!< Intensity of Blue color (0-255), before gamma correction */
+    uint16_t width;          /*!< Lit LEDs of chase */
+    uint32_t period_ms;      /*!< Cycle of blink, breathe and chase, length of fade to */
+    uint32_t duration_ms;    /*!< Time after which the next posted animation starts, 0 to run until one is posted */
+} ws2812_anim_t;
+
+/**
+ * @brief Default descriptor of an animation
+ *
+ */
+#define WS2812_ANIM_DEFAULT(anim_type, r, g, b, period) \
+    {                                                   \
+        .type = anim_type,                              \
+        .ease = WS2812_EASE_IN_OUT,                     \
+        .red = r,                                       \
+        .green = g,                                     \
+        .blue = b,                                      \
+        .width = 1,                                     \
+        .period_ms = period,                            \
+        .duration_ms = 0,                               \
+    }
+
+/** Start the render task of the animations
+ *
+ * @note ws2812_led_init() must be called first.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_NO_MEM if the task or its queue cannot be created.
+ */
+esp_err_t ws2812_anim_init(void);
+
+/** Queue an animation
+ *
+ * It starts when the running one ends, at once if the running one has no duration.
+ *
+ * @param[in] anim Animation descriptor
+ * @param[in] timeout_ms Maximum time to wait for room in the queue in milliseconds
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_STATE if the engine is not initialized.
+ * @return ESP_ERR_TIMEOUT if the queue is full.
+ */
+esp_err_t ws2812_anim_post(const ws2812_anim_t *anim, uint32_t timeout_ms);
+
+/** Set the LEDs of the next frame of an animation, without presenting it
+ *
+ * Used by the render task, exposed to time a frame.
+ *
+ * @param[in] anim Animation descriptor
+ * @param[in] elapsed_ms Time since the animation started in milliseconds
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t ws2812_anim_render(const ws2812_anim_t *anim, uint32_t elapsed_ms);
+
+/** Apply an easing curve
+ *
+ * @param[in] ease Easing curve
+ * @param[in] x Position in Q16, 0 to 65536
+ *
+ * @return Eased position in Q16, 0 to 65536
+ */
+uint32_t ws2812_anim_ease(ws2812_anim_ease_t ease, uint32_t x);
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,8 +6,31 @@
    CONDITIONS OF ANY KIND, either express or implied.
 */
 #pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <esp_err.h>
 
+/** HSV color with 8-bit saturation and value */
+typedef struct {
+    uint16_t hue;       /*!< Hue in arc degrees (0-359) */
+    uint8_t saturation; /*!< Saturation (0-255) */
+    uint8_t value;      /*!< Value (also called Intensity) (0-255) */
+} ws2812_led_hsv_t;
+
+/** RGB color */
+typedef struct {
+    uint8_t red;        /*!< Intensity of Red color (0-255) */
+    uint8_t green;      /*!< Intensity of Green color (0-255) */
+    uint8_t blue;       /*!< Intensity of Blue color (0-255) */
+} ws2812_led_rgb_t;
+
+/** Gamma 2.2 correction of an intensity (0-255), from the perceived brightness to the one to send */
+extern const uint8_t ws2812_led_gamma_lut[256];
+
+/** Called from interrupt context when a frame started by ws2812_led_present() reached the strip */
+typedef void (*ws2812_led_present_cb_t)(void *arg);
+
 /** Initialize the WS2812 RGB LED
  *
  * @return ESP_OK on success.
@@ -15,7 +38,9 @@
  */
 esp_err_t ws2812_led_init(void);
 
-/** Set RGB value for the WS2812 LED
+/** Set RGB value for every LED of the strip and start sending it
+ *
+ * @note Waits for a previous frame to be sent, not for this one.
  *
  * @param[in] red Intensity of Red color (0-100)
  * @param[in] green Intensity of Green color (0-100)
@@ -26,7 +51,7 @@ esp_err_t ws2812_led_init(void);
  */
 esp_err_t ws2812_led_set_rgb(uint32_t red, uint32_t green, uint32_t blue);
 
-/** Set HSV value for the WS2812 LED
+/** Set HSV value for every LED of the strip and start sending it
  *
  * @param[in] hue Value of hue in arc degrees (0-360)
  * @param[in] saturation Saturation in percentage (0-100)
@@ -37,6 +62,74 @@ esp_err_t ws2812_led_set_rgb(uint32_t red, uint32_t green, uint32_t blue);
  */
 esp_err_t ws2812_led_set_hsv(uint32_t hue, uint32_t saturation, uint32_t value);
 
+/** Set RGB value of one LED of the next frame
+ *
+ * @param[in] index LED position in the strip, from 0
+ * @param[in] red Intensity of Red color (0-255)
+ * @param[in] green Intensity of Green color (0-255)
+ * @param[in] blue Intensity of Blue color (0-255)
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_ARG if index is out of the strip.
+ */
+esp_err_t ws2812_led_set_pixel(uint32_t index, uint32_t red, uint32_t green, uint32_t blue);
+
+/** Start sending the LEDs set since the last frame and return at once
+ *
+ * The frame is double buffered, LEDs of the next one can be set while it is sent.
+ * Only the strip up to the last changed LED is sent.
+ *
+ * @return ESP_OK on success, or if no LED changed.
+ * @return ESP_ERR_INVALID_STATE if the previous frame is still being sent.
+ */
+esp_err_t ws2812_led_present(void);
+
+/** Wait until the last frame is sent
+ *
+ * @param[in] timeout_ms Maximum time to wait in milliseconds
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_TIMEOUT if the frame is still being sent.
+ */
+esp_err_t ws2812_led_wait(uint32_t timeout_ms);
+
+/** Set the function called when a frame is sent
+ *
+ * @param[in] callback Function called from interrupt context, NULL for none
+ * @param[in] arg Argument of the callback
+ *
+ * @return ESP_OK on success.
+ */
+esp_err_t ws2812_led_set_present_callback(ws2812_led_present_cb_t callback, void *arg);
+
+/** Number of LEDs of the strip
+ *
+ * @return CONFIG_WS2812_LED_LENGTH, 0 if the LED is disabled.
+ */
+uint32_t ws2812_led_length(void);
+
+/** Convert HSV color space to RGB color space
+ *
+ * @param[in] h Value of hue in arc degrees (0-360)
+ * @param[in] s Saturation in percentage (0-100)
+ * @param[in] v Value (also called Intensity) in percentage (0-100)
+ * @param[out] r Intensity of Red color (0-255)
+ * @param[out] g Intensity of Green color (0-255)
+ * @param[out] b Intensity of Blue color (0-255)
+ */
+void ws2812_led_hsv2rgb(uint32_t h, uint32_t s, uint32_t v, uint32_t *r, uint32_t *g, uint32_t *b);
+
+/** Convert an array of 8-bit HSV colors to RGB, such as the LEDs of a frame
+ *
+ * Integer only, each channel is within 1 of the rounded floating point conversion.
+ *
+ * @param[in] hsv HSV colors
+ * @param[out] rgb RGB colors, count elements
+ * @param[in] count Number of colors
+ * @param[in] gamma Gamma correct the RGB colors with ws2812_led_gamma_lut
+ */
+void ws2812_led_hsv2rgb_batch(const ws2812_led_hsv_t *hsv, ws2812_led_rgb_t *rgb, size_t count, bool gamma);
+
 /** Clear (turn off) the WS2812 LED
  * @return ESP_OK on success.
  * @return error in case of failure.
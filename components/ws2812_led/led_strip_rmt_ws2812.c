@@ -13,11 +13,12 @@
 // limitations under the License.
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <sys/cdefs.h>
 #include "esp_log.h"
 #include "esp_attr.h"
 #include "led_strip.h"
-#include "driver/rmt.h"
+#include "bitec_hal.h"
 
 static const char *TAG = "ws2812";
 #define STRIP_CHECK(a, str, goto_tag, ret_value, ...)                             \
@@ -44,15 +45,43 @@ static uint32_t ws2812_t1l_ticks = 0;
 
 typedef struct {
     led_strip_t parent;
-    rmt_channel_t rmt_channel;
+    int rmt_channel;
     uint32_t strip_len;
-    uint8_t buffer[0];
+    uint8_t *front;                     // Frame being sent
+    uint8_t *back;                      // Frame set by set_pixel
+    uint32_t dirty_start;               // Bytes of the back frame changed since the last present
+    uint32_t dirty_end;
+    volatile bool busy;                 // A present transfer is running
+    led_strip_present_cb_t present_cb;
+    void *present_arg;
+    uint8_t buffer[0];                  // Storage of both frames
 } ws2812_t;
 
+/**
+ * @brief RMT items of every nibble, MSB first. DRAM_ATTR as the adapter
+ * reads it from the RMT interrupt
+ */
+static DRAM_ATTR uint32_t ws2812_nibble_items[16][4];
+
+/**
+ * @brief Build the nibble table from the bit timings
+ */
+static void ws2812_build_nibble_items(void)
+{
+    const hal_rmt_item_t bit0 = {{{ ws2812_t0h_ticks, 1, ws2812_t0l_ticks, 0 }}}; //Logical 0
+    const hal_rmt_item_t bit1 = {{{ ws2812_t1h_ticks, 1, ws2812_t1l_ticks, 0 }}}; //Logical 1
+    for (int nibble = 0; nibble < 16; nibble++) {
+        for (int i = 0; i < 4; i++) {
+            ws2812_nibble_items[nibble][i] = (nibble & (1 << (3 - i))) ? bit1.val : bit0.val;
+        }
+    }
+}
+
 /**
  * @brief Conver RGB data to RMT format.
  *
  * @note For WS2812, R,G,B each contains 256 different choices (i.e. uint8_t)
+ * @note Every byte is two copies of 4 items from the nibble table, no branch per bit
  *
  * @param[in] src: source data, to converted to RMT format
  * @param[in] dest: place where to store the convert result
@@ -61,7 +90,7 @@ typedef struct {
  * @param[out] translated_size: number of source data that got converted
  * @param[out] item_num: number of RMT items which are converted from source data
  */
-static void IRAM_ATTR ws2812_rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
+void IRAM_ATTR ws2812_rmt_adapter(const void *src, hal_rmt_item_t *dest, size_t src_size,
         size_t wanted_num, size_t *translated_size, size_t *item_num)
 {
     if (src == NULL || dest == NULL) {
@@ -69,23 +98,15 @@ static void IRAM_ATTR ws2812_rmt_adapter(const void *src, rmt_item32_t *dest, si
         *item_num = 0;
         return;
     }
-    const rmt_item32_t bit0 = {{{ ws2812_t0h_ticks, 1, ws2812_t0l_ticks, 0 }}}; //Logical 0
-    const rmt_item32_t bit1 = {{{ ws2812_t1h_ticks, 1, ws2812_t1l_ticks, 0 }}}; //Logical 1
     size_t size = 0;
     size_t num = 0;
-    uint8_t *psrc = (uint8_t *)src;
-    rmt_item32_t *pdest = dest;
+    const uint8_t *psrc = (const uint8_t *)src;
+    hal_rmt_item_t *pdest = dest;
     while (size < src_size && num < wanted_num) {
-        for (int i = 0; i < 8; i++) {
-            // MSB first
-            if (*psrc & (1 << (7 - i))) {
-                pdest->val =  bit1.val;
-            } else {
-                pdest->val =  bit0.val;
-            }
-            num++;
-            pdest++;
-        }
+        memcpy(pdest, ws2812_nibble_items[*psrc >> 4], sizeof(ws2812_nibble_items[0]));
+        memcpy(pdest + 4, ws2812_nibble_items[*psrc & 0x0F], sizeof(ws2812_nibble_items[0]));
+        num += 8;
+        pdest += 8;
         size++;
         psrc++;
     }
@@ -100,21 +121,82 @@ static esp_err_t ws2812_set_pixel(led_strip_t *strip, uint32_t index, uint32_t r
     STRIP_CHECK(index < ws2812->strip_len, "index out of the maximum number of leds", err, ESP_ERR_INVALID_ARG);
     uint32_t start = index * 3;
     // In thr order of GRB
-    ws2812->buffer[start + 0] = green & 0xFF;
-    ws2812->buffer[start + 1] = red & 0xFF;
-    ws2812->buffer[start + 2] = blue & 0xFF;
+    uint8_t grb[3] = { green & 0xFF, red & 0xFF, blue & 0xFF };
+    if (memcmp(&ws2812->back[start], grb, sizeof(grb)) == 0) {
+        return ESP_OK;
+    }
+    memcpy(&ws2812->back[start], grb, sizeof(grb));
+    if (ws2812->dirty_start >= ws2812->dirty_end) {
+        ws2812->dirty_start = start;
+        ws2812->dirty_end = start + 3;
+    } else {
+        ws2812->dirty_start = start < ws2812->dirty_start ? start : ws2812->dirty_start;
+        ws2812->dirty_end = start + 3 > ws2812->dirty_end ? start + 3 : ws2812->dirty_end;
+    }
     return ESP_OK;
 err:
     return ret;
 }
 
+static esp_err_t ws2812_present(led_strip_t *strip)
+{
+    ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
+    if (ws2812->busy) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (ws2812->dirty_start >= ws2812->dirty_end) {
+        return ESP_OK;
+    }
+    // The back frame is sent, the old front one catches up on the changed bytes to become the back frame
+    uint8_t *frame = ws2812->back;
+    ws2812->back = ws2812->front;
+    ws2812->front = frame;
+    memcpy(&ws2812->back[ws2812->dirty_start], &ws2812->front[ws2812->dirty_start], ws2812->dirty_end - ws2812->dirty_start);
+    // LEDs after the last changed one keep their color, the rest of the strip is not sent
+    uint32_t size = ws2812->dirty_end;
+    ws2812->dirty_start = ws2812->dirty_end = 0;
+    ws2812->busy = true;
+    esp_err_t ret = hal_rmt_write(ws2812->rmt_channel, ws2812->front, size, false);
+    if (ret != ESP_OK) {
+        ws2812->busy = false;
+        ESP_LOGE(TAG, "%s(%d): transmit RMT samples failed", __FUNCTION__, __LINE__);
+    }
+    return ret;
+}
+
+static esp_err_t ws2812_wait(led_strip_t *strip, uint32_t timeout_ms)
+{
+    ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
+    if (!ws2812->busy) {
+        return ESP_OK;
+    }
+    return hal_rmt_wait(ws2812->rmt_channel, timeout_ms);
+}
+
+static esp_err_t ws2812_set_present_callback(led_strip_t *strip, led_strip_present_cb_t callback, void *arg)
+{
+    ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
+    ws2812->present_cb = NULL;
+    ws2812->present_arg = arg;
+    ws2812->present_cb = callback;
+    return ESP_OK;
+}
+
+static void IRAM_ATTR ws2812_tx_end(int channel, void *arg)
+{
+    ws2812_t *ws2812 = (ws2812_t *)arg;
+    ws2812->busy = false;
+    if (ws2812->present_cb) {
+        ws2812->present_cb(&ws2812->parent, ws2812->present_arg);
+    }
+}
+
 static esp_err_t ws2812_refresh(led_strip_t *strip, uint32_t timeout_ms)
 {
     esp_err_t ret = ESP_OK;
-    ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
-    STRIP_CHECK(rmt_write_sample(ws2812->rmt_channel, ws2812->buffer, ws2812->strip_len * 3, true) == ESP_OK,
-                "transmit RMT samples failed", err, ESP_FAIL);
-    return rmt_wait_tx_done(ws2812->rmt_channel, pdMS_TO_TICKS(timeout_ms));
+    STRIP_CHECK(ws2812_wait(strip, timeout_ms) == ESP_OK, "previous transfer not done", err, ESP_ERR_TIMEOUT);
+    STRIP_CHECK(ws2812_present(strip) == ESP_OK, "transmit RMT samples failed", err, ESP_FAIL);
+    return ws2812_wait(strip, timeout_ms);
 err:
     return ret;
 }
@@ -122,14 +204,17 @@ err:
 static esp_err_t ws2812_clear(led_strip_t *strip, uint32_t timeout_ms)
 {
     ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
-    // Write zero to turn off all leds
-    memset(ws2812->buffer, 0, ws2812->strip_len * 3);
+    // Write zero to turn off all leds, the whole strip is sent as its state is unknown at power on
+    memset(ws2812->back, 0, ws2812->strip_len * 3);
+    ws2812->dirty_start = 0;
+    ws2812->dirty_end = ws2812->strip_len * 3;
     return ws2812_refresh(strip, timeout_ms);
 }
 
 static esp_err_t ws2812_del(led_strip_t *strip)
 {
     ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
+    hal_rmt_tx_end_callback(ws2812->rmt_channel, NULL, NULL);
     free(ws2812);
     return ESP_OK;
 }
@@ -139,13 +224,13 @@ led_strip_t *led_strip_new_rmt_ws2812(const led_strip_config_t *config)
     led_strip_t *ret = NULL;
     STRIP_CHECK(config, "configuration can't be null", err, NULL);
 
-    // 24 bits per led
-    uint32_t ws2812_size = sizeof(ws2812_t) + config->max_leds * 3;
+    // 24 bits per led, front and back frames
+    uint32_t ws2812_size = sizeof(ws2812_t) + config->max_leds * 3 * 2;
     ws2812_t *ws2812 = calloc(1, ws2812_size);
     STRIP_CHECK(ws2812, "request memory for ws2812 failed", err, NULL);
 
     uint32_t counter_clk_hz = 0;
-    STRIP_CHECK(rmt_get_counter_clock((rmt_channel_t)config->dev, &counter_clk_hz) == ESP_OK,
+    STRIP_CHECK(hal_rmt_get_counter_clock((int)(intptr_t)config->dev, &counter_clk_hz) == ESP_OK,
                 "get rmt counter clock failed", err, NULL);
     // ns -> ticks
     float ratio = (float)counter_clk_hz / 1e9;
@@ -153,14 +238,22 @@ led_strip_t *led_strip_new_rmt_ws2812(const led_strip_config_t *config)
     ws2812_t0l_ticks = (uint32_t)(ratio * WS2812_T0L_NS);
     ws2812_t1h_ticks = (uint32_t)(ratio * WS2812_T1H_NS);
     ws2812_t1l_ticks = (uint32_t)(ratio * WS2812_T1L_NS);
+    ws2812_build_nibble_items();
 
     // set ws2812 to rmt adapter
-    rmt_translator_init((rmt_channel_t)config->dev, ws2812_rmt_adapter);
+    hal_rmt_translator_init((int)(intptr_t)config->dev, ws2812_rmt_adapter);
 
-    ws2812->rmt_channel = (rmt_channel_t)config->dev;
+    ws2812->rmt_channel = (int)(intptr_t)config->dev;
     ws2812->strip_len = config->max_leds;
+    ws2812->front = ws2812->buffer;
+    ws2812->back = ws2812->buffer + config->max_leds * 3;
+    STRIP_CHECK(hal_rmt_tx_end_callback(ws2812->rmt_channel, ws2812_tx_end, ws2812) == ESP_OK,
+                "set rmt end of transfer callback failed", err, NULL);
 
     ws2812->parent.set_pixel = ws2812_set_pixel;
+    ws2812->parent.present = ws2812_present;
+    ws2812->parent.wait = ws2812_wait;
+    ws2812->parent.set_present_callback = ws2812_set_present_callback;
     ws2812->parent.refresh = ws2812_refresh;
     ws2812->parent.clear = ws2812_clear;
     ws2812->parent.del = ws2812_del;
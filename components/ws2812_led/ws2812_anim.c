@@ -0,0 +1,213 @@
+/*  WS2812 RGB LED animations
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <esp_err.h>
+#include <esp_log.h>
+#include "ws2812_led.h"
+#include "ws2812_anim.h"
+
+#define Q16_ONE (1U << 16)
+
+static const char *TAG = "ws2812_anim";
+
+uint32_t ws2812_anim_ease(ws2812_anim_ease_t ease, uint32_t x)
+{
+    uint64_t x2 = (uint64_t)x * x;
+
+    if (x >= Q16_ONE) {
+        return Q16_ONE;
+    }
+    switch (ease) {
+    case WS2812_EASE_IN:
+        return x2 >> 16;
+    case WS2812_EASE_OUT:
+        // 1 - (1 - x)^2 = 2x - x^2
+        return 2 * x - (uint32_t)(x2 >> 16);
+    case WS2812_EASE_IN_OUT:
+        // x^2 * (3 - 2x), the product needs 50 bits
+        return (uint32_t)((x2 * (3 * Q16_ONE - 2 * x)) >> 32);
+    default:
+        return x;
+    }
+}
+
+#ifdef CONFIG_WS2812_LED_ENABLE
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#define ANIM_QUEUE_LEN 4
+#define ANIM_FRAME_TICKS (pdMS_TO_TICKS(1000 / CONFIG_WS2812_LED_ANIM_FPS) ? pdMS_TO_TICKS(1000 / CONFIG_WS2812_LED_ANIM_FPS) : 1)
+
+static QueueHandle_t g_queue;
+// Colors of the last frame before gamma correction, where a fade starts from
+static uint8_t g_frame[CONFIG_WS2812_LED_LENGTH][3];
+static uint8_t g_from[CONFIG_WS2812_LED_LENGTH][3];
+
+static void ws2812_anim_task(void *arg);
+
+static inline esp_err_t ws2812_anim_pixel(uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    g_frame[index][0] = red;
+    g_frame[index][1] = green;
+    g_frame[index][2] = blue;
+    return ws2812_led_set_pixel(index, ws2812_led_gamma_lut[red], ws2812_led_gamma_lut[green], ws2812_led_gamma_lut[blue]);
+}
+
+static uint32_t ws2812_anim_progress(uint32_t elapsed_ms, uint32_t period_ms)
+{
+    if (elapsed_ms >= period_ms) {
+        return Q16_ONE;
+    }
+    return (uint32_t)(((uint64_t)elapsed_ms << 16) / period_ms);
+}
+
+// The frame does not change any more, no need to render it again
+static bool ws2812_anim_is_static(const ws2812_anim_t *anim, uint32_t elapsed_ms)
+{
+    return anim->type == WS2812_ANIM_SOLID || (anim->type == WS2812_ANIM_FADE_TO && elapsed_ms >= anim->period_ms);
+}
+
+esp_err_t ws2812_anim_render(const ws2812_anim_t *anim, uint32_t elapsed_ms)
+{
+    esp_err_t ret = ESP_OK;
+    uint32_t length = CONFIG_WS2812_LED_LENGTH;
+    uint32_t period_ms = anim->period_ms ? anim->period_ms : 1;
+    uint32_t phase = ws2812_anim_progress(elapsed_ms % period_ms, period_ms);
+    uint32_t level = Q16_ONE;
+
+    switch (anim->type) {
+    case WS2812_ANIM_CHASE: {
+        uint32_t width = anim->width ? anim->width : 1;
+        uint32_t step = Q16_ONE / width;
+        uint32_t head = (ws2812_anim_ease(anim->ease, phase) * length) >> 16;
+        for (uint32_t i = 0; i < length && ret == ESP_OK; i++) {
+            // LEDs behind the head, dimmer the further they are
+            uint32_t distance = (head + length - i) % length;
+            level = distance < width ? Q16_ONE - distance * step : 0;
+            ret = ws2812_anim_pixel(i, (anim->red * level) >> 16, (anim->green * level) >> 16, (anim->blue * level) >> 16);
+        }
+        return ret;
+    }
+    case WS2812_ANIM_FADE_TO: {
+        uint32_t x = ws2812_anim_ease(anim->ease, ws2812_anim_progress(elapsed_ms, period_ms));
+        uint32_t y = Q16_ONE - x;
+        for (uint32_t i = 0; i < length && ret == ESP_OK; i++) {
+            ret = ws2812_anim_pixel(i, (anim->red * x + g_from[i][0] * y) >> 16,
+                                    (anim->green * x + g_from[i][1] * y) >> 16,
+                                    (anim->blue * x + g_from[i][2] * y) >> 16);
+        }
+        return ret;
+    }
+    case WS2812_ANIM_BLINK:
+        level = phase < Q16_ONE / 2 ? Q16_ONE : 0;
+        break;
+    case WS2812_ANIM_BREATHE:
+        // Triangle wave, up the first half of the period and down the second one
+        level = ws2812_anim_ease(anim->ease, phase < Q16_ONE / 2 ? phase * 2 : (Q16_ONE - phase) * 2);
+        break;
+    default:
+        break;
+    }
+
+    uint32_t red = (anim->red * level) >> 16;
+    uint32_t green = (anim->green * level) >> 16;
+    uint32_t blue = (anim->blue * level) >> 16;
+    for (uint32_t i = 0; i < length && ret == ESP_OK; i++) {
+        ret = ws2812_anim_pixel(i, red, green, blue);
+    }
+    return ret;
+}
+
+esp_err_t ws2812_anim_post(const ws2812_anim_t *anim, uint32_t timeout_ms)
+{
+    if (!g_queue) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xQueueSend(g_queue, anim, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+esp_err_t ws2812_anim_init(void)
+{
+    if (g_queue) {
+        return ESP_OK;
+    }
+    g_queue = xQueueCreate(ANIM_QUEUE_LEN, sizeof(ws2812_anim_t));
+    if (!g_queue) {
+        ESP_LOGE(TAG, "Create animation queue failed.");
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(ws2812_anim_task, "WS2812 Anim Task", configMINIMAL_STACK_SIZE * 2, NULL, CONFIG_WS2812_LED_ANIM_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Create render task failed.");
+        vQueueDelete(g_queue);
+        g_queue = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+static void ws2812_anim_task(void *arg)
+{
+    ws2812_anim_t anim;
+    TickType_t start;
+    TickType_t last_wake;
+    bool held = false;
+
+    // Nothing to render until the first animation
+    xQueueReceive(g_queue, &anim, portMAX_DELAY);
+    start = last_wake = xTaskGetTickCount();
+
+    for (;;) {
+        uint32_t elapsed_ms = (xTaskGetTickCount() - start) * portTICK_PERIOD_MS;
+        bool ended = anim.duration_ms && elapsed_ms >= anim.duration_ms;
+
+        if (ended || !anim.duration_ms) {
+            // Sleep until the next animation if the frame can not change any more
+            if (xQueueReceive(g_queue, &anim, ended || held ? portMAX_DELAY : 0) == pdTRUE) {
+                memcpy(g_from, g_frame, sizeof(g_frame));
+                start = last_wake = xTaskGetTickCount();
+                elapsed_ms = 0;
+                held = false;
+            }
+        }
+
+        if (!held) {
+            ws2812_anim_render(&anim, elapsed_ms);
+            // A frame still being sent drops this one, a static frame is sent on the next tick then
+            held = ws2812_led_present() == ESP_OK && ws2812_anim_is_static(&anim, elapsed_ms);
+        }
+
+        vTaskDelayUntil(&last_wake, ANIM_FRAME_TICKS);
+    }
+}
+#else /* !CONFIG_WS2812_LED_ENABLE */
+esp_err_t ws2812_anim_render(const ws2812_anim_t *anim, uint32_t elapsed_ms)
+{
+    /* Empty function, since WS2812 RGB LED has been disabled.  */
+    return ESP_OK;
+}
+
+esp_err_t ws2812_anim_post(const ws2812_anim_t *anim, uint32_t timeout_ms)
+{
+    /* Empty function, since WS2812 RGB LED has been disabled.  */
+    return ESP_OK;
+}
+
+esp_err_t ws2812_anim_init(void)
+{
+    ESP_LOGW(TAG, "WS2812 LED is disabled");
+    return ESP_OK;
+}
+#endif /* !CONFIG_WS2812_LED_ENABLE */
@@ -13,18 +13,33 @@
 
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <esp_err.h>
 #include <esp_log.h>
 #include "ws2812_led.h"
 
 static const char *TAG = "ws2812_led";
 
-#ifdef CONFIG_WS2812_LED_ENABLE
-#include <driver/rmt.h>
-#include "led_strip.h"
-#define RMT_TX_CHANNEL RMT_CHANNEL_0
-
-static led_strip_t *g_strip;
+// Gamma 2.2, round(255 * (i / 255) ^ 2.2)
+const uint8_t ws2812_led_gamma_lut[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+      6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+     12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+     20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+     30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+     42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+     56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+     73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+     91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255,
+};
 
 /**
  * @brief Simple helper function, converting HSV color space to RGB color space
@@ -32,11 +47,11 @@ static led_strip_t *g_strip;
  * Wiki: https://en.wikipedia.org/wiki/HSL_and_HSV
  *
  */
-static void ws2812_led_hsv2rgb(uint32_t h, uint32_t s, uint32_t v, uint32_t *r, uint32_t *g, uint32_t *b)
+void ws2812_led_hsv2rgb(uint32_t h, uint32_t s, uint32_t v, uint32_t *r, uint32_t *g, uint32_t *b)
 {
     h %= 360; // h -> [0,360]
-    uint32_t rgb_max = v * 2.55f;
-    uint32_t rgb_min = rgb_max * (100 - s) / 100.0f;
+    uint32_t rgb_max = v * 255 / 100;
+    uint32_t rgb_min = rgb_max * (100 - s) / 100;
 
     uint32_t i = h / 60;
     uint32_t diff = h % 60;
@@ -78,16 +93,146 @@ static void ws2812_led_hsv2rgb(uint32_t h, uint32_t s, uint32_t v, uint32_t *r,
     }
 }
 
+/**
+ * @brief 8-bit HSV to RGB conversion, rounded to the nearest value
+ *
+ * With x the position of the hue in its 60 degrees sector, the sector colors are
+ * p = v * (1 - s), q = v * (1 - s * x / 60) and t = v * (1 - s * (60 - x) / 60),
+ * computed on integers scaled by 255 * 60 so no fraction is lost before the division.
+ *
+ */
+static inline void ws2812_led_hsv2rgb8(const ws2812_led_hsv_t *hsv, ws2812_led_rgb_t *rgb)
+{
+    uint32_t h = hsv->hue % 360;
+    uint32_t s = hsv->saturation;
+    uint32_t v = hsv->value;
+    uint32_t i = h / 60;
+    uint32_t x = h - i * 60;
+
+    uint8_t p = (v * (255 - s) + 127) / 255;
+    uint8_t q = (v * (255 * 60 - s * x) + 255 * 30) / (255 * 60);
+    uint8_t t = (v * (255 * 60 - s * (60 - x)) + 255 * 30) / (255 * 60);
+
+    switch (i) {
+    case 0:
+        rgb->red = v;
+        rgb->green = t;
+        rgb->blue = p;
+        break;
+    case 1:
+        rgb->red = q;
+        rgb->green = v;
+        rgb->blue = p;
+        break;
+    case 2:
+        rgb->red = p;
+        rgb->green = v;
+        rgb->blue = t;
+        break;
+    case 3:
+        rgb->red = p;
+        rgb->green = q;
+        rgb->blue = v;
+        break;
+    case 4:
+        rgb->red = t;
+        rgb->green = p;
+        rgb->blue = v;
+        break;
+    default:
+        rgb->red = v;
+        rgb->green = p;
+        rgb->blue = q;
+        break;
+    }
+}
+
+void ws2812_led_hsv2rgb_batch(const ws2812_led_hsv_t *hsv, ws2812_led_rgb_t *rgb, size_t count, bool gamma)
+{
+    for (size_t i = 0; i < count; i++) {
+        ws2812_led_hsv2rgb8(&hsv[i], &rgb[i]);
+    }
+    // Separate pass, the conversion loop stays free of table loads when gamma is off
+    if (gamma) {
+        for (size_t i = 0; i < count; i++) {
+            rgb[i].red = ws2812_led_gamma_lut[rgb[i].red];
+            rgb[i].green = ws2812_led_gamma_lut[rgb[i].green];
+            rgb[i].blue = ws2812_led_gamma_lut[rgb[i].blue];
+        }
+    }
+}
+
+#ifdef CONFIG_WS2812_LED_ENABLE
+#include "bitec_hal.h"
+#include "led_strip.h"
+#define RMT_TX_CHANNEL 0
+#define PRESENT_TIMEOUT_MS 100
+
+static led_strip_t *g_strip;
+static ws2812_led_present_cb_t g_present_cb;
+static void *g_present_arg;
+
+static void ws2812_led_present_done(led_strip_t *strip, void *arg)
+{
+    if (g_present_cb) {
+        g_present_cb(g_present_arg);
+    }
+}
+
 esp_err_t ws2812_led_set_rgb(uint32_t red, uint32_t green, uint32_t blue)
 {
     if (!g_strip) {
         return ESP_ERR_INVALID_STATE;
     }
-    g_strip->set_pixel(g_strip, 0, red, green, blue);
-    g_strip->refresh(g_strip, 100);
+    for (uint32_t i = 0; i < CONFIG_WS2812_LED_LENGTH; i++) {
+        g_strip->set_pixel(g_strip, i, red, green, blue);
+    }
+    // Only wait for a previous frame, this one is sent in the background
+    esp_err_t ret = g_strip->wait(g_strip, PRESENT_TIMEOUT_MS);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return g_strip->present(g_strip);
+}
+
+esp_err_t ws2812_led_set_pixel(uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    if (!g_strip) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return g_strip->set_pixel(g_strip, index, red, green, blue);
+}
+
+esp_err_t ws2812_led_present(void)
+{
+    if (!g_strip) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return g_strip->present(g_strip);
+}
+
+esp_err_t ws2812_led_wait(uint32_t timeout_ms)
+{
+    if (!g_strip) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return g_strip->wait(g_strip, timeout_ms);
+}
+
+esp_err_t ws2812_led_set_present_callback(ws2812_led_present_cb_t callback, void *arg)
+{
+    // The callback runs in interrupt context, never let it see the new arg with the old callback
+    g_present_cb = NULL;
+    g_present_arg = arg;
+    g_present_cb = callback;
     return ESP_OK;
 }
 
+uint32_t ws2812_led_length(void)
+{
+    return CONFIG_WS2812_LED_LENGTH;
+}
+
 esp_err_t ws2812_led_set_hsv(uint32_t hue, uint32_t saturation, uint32_t value)
 {
     if (!g_strip) {
@@ -105,32 +250,25 @@ esp_err_t ws2812_led_clear(void)
     if (!g_strip) {
         return ESP_ERR_INVALID_STATE;
     }
-    g_strip->clear(g_strip, 100);
-    return ESP_OK;
+    return g_strip->clear(g_strip, PRESENT_TIMEOUT_MS);
 }
 
 esp_err_t ws2812_led_init(void)
 {
-    rmt_config_t config = RMT_DEFAULT_CONFIG_TX(CONFIG_WS2812_LED_GPIO, RMT_TX_CHANNEL);
     // set counter clock to 40MHz
-    config.clk_div = 2;
-
-    if (rmt_config(&config) != ESP_OK) {
-        ESP_LOGE(TAG, "RMT Config failed.");
-        return ESP_FAIL;
-    }
-    if (rmt_driver_install(config.channel, 0, 0) != ESP_OK) {
+    if (hal_rmt_tx_init(RMT_TX_CHANNEL, CONFIG_WS2812_LED_GPIO, 2) != ESP_OK) {
         ESP_LOGE(TAG, "RMT Driver install failed.");
         return ESP_FAIL;
     }
 
     // install ws2812 driver
-    led_strip_config_t strip_config = LED_STRIP_DEFAULT_CONFIG(1, (led_strip_dev_t)config.channel);
+    led_strip_config_t strip_config = LED_STRIP_DEFAULT_CONFIG(CONFIG_WS2812_LED_LENGTH, (led_strip_dev_t)RMT_TX_CHANNEL);
     g_strip = led_strip_new_rmt_ws2812(&strip_config);
     if (!g_strip) {
         ESP_LOGE(TAG, "Install WS2812 driver failed.");
         return ESP_FAIL;
     }
+    g_strip->set_present_callback(g_strip, ws2812_led_present_done, NULL);
     return ESP_OK;
 }
 #else /* !CONFIG_WS2812_LED_ENABLE */
@@ -146,6 +284,35 @@ esp_err_t ws2812_led_set_hsv(uint32_t hue, uint32_t saturation, uint32_t value)
     return ESP_OK;
 }
 
+esp_err_t ws2812_led_set_pixel(uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    /* Empty function, since WS2812 RGB LED has been disabled.  */
+    return ESP_OK;
+}
+
+esp_err_t ws2812_led_present(void)
+{
+    /* Empty function, since WS2812 RGB LED has been disabled.  */
+    return ESP_OK;
+}
+
+esp_err_t ws2812_led_wait(uint32_t timeout_ms)
+{
+    /* Empty function, since WS2812 RGB LED has been disabled.  */
+    return ESP_OK;
+}
+
+esp_err_t ws2812_led_set_present_callback(ws2812_led_present_cb_t callback, void *arg)
+{
+    /* Empty function, since WS2812 RGB LED has been disabled.  */
+    return ESP_OK;
+}
+
+uint32_t ws2812_led_length(void)
+{
+    return 0;
+}
+
 esp_err_t ws2812_led_clear(void)
 {
     /* Empty function, since WS2812 RGB LED has been disabled.  */
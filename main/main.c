@@ -9,77 +9,287 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
+#include <math.h>
+#include <time.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
+#include "freertos/semphr.h"
 
 
 #include "esp_log.h"
 #include "esp_event.h"
-#include "driver/adc.h"
-#include "nvs_flash.h"
 #include "cJSON.h"
 
 #include "bitec_wifi.h"
 #include "bitec_mqtt.h"
 #include "bitec_button.h"
+#include "bitec_input.h"
+#include "bitec_relay.h"
+#include "bitec_rules.h"
+#include "bitec_monitor.h"
+#include "bitec_ota.h"
+#include "bitec_ota_rollout.h"
 #include "ws2812_led.h"
+#include "ws2812_anim.h"
 #include "bl0937.h"
+#include "bl0937_drift.h"
+#include "bitec_hal.h"
+#include "bitec_latency.h"
+#include "bitec_trace.h"
+#include "bitec_payload.h"
+#include "bitec_settings.h"
+#include "bitec_energy.h"
+#include "bitec_series.h"
+#include "bitec_clock.h"
 
 /* macros --------------------------------------------------------------------*/
 
+/* Topics end with the device id, they are built at start from the id setting */
 #ifdef CONFIG_APPLICATION_USER_DEFINED_SUBSCRIPTION_1_ENABLE
-#define MQTT_SUBSCRIBE_1	CONFIG_APPLICATION_USER_DEFINED_SUBSCRIPTION_1_TOPIC CONFIG_APPLICATION_DEVICE_ID
+#define MQTT_SUBSCRIBE_1	topics[TOPIC_SUBSCRIBE_1]
 #endif
 
 #ifdef CONFIG_APPLICATION_USER_DEFINED_SUBSCRIPTION_2_ENABLE
-#define MQTT_SUBSCRIBE_2	CONFIG_APPLICATION_USER_DEFINED_SUBSCRIPTION_2_TOPIC CONFIG_APPLICATION_DEVICE_ID
+#define MQTT_SUBSCRIBE_2	topics[TOPIC_SUBSCRIBE_2]
 #endif
 
 #ifdef CONFIG_APPLICATION_CONNECT_PUBLISHING_ENABLE
-#define MQTT_CONNECT	CONFIG_APPLICATION_CONNECT_PUBLISHING_TOPIC CONFIG_APPLICATION_DEVICE_ID
+#define MQTT_CONNECT	topics[TOPIC_CONNECT]
 #endif
 
+#ifdef CONFIG_APPLICATION_METRICS_PUBLISHING_ENABLE
+#define MQTT_METRICS	topics[TOPIC_METRICS]
+#define METRICS_SIZE		2048		/*!< Maximum metrics message size in bytes */
+#endif
+
+#define MQTT_RULES		topics[TOPIC_RULES]
+#define MQTT_EVENTS		topics[TOPIC_EVENTS]
+#define EVENT_SIZE			128			/*!< Maximum event or alarm message size in bytes */
+#define MQTT_ROLLOUT	topics[TOPIC_ROLLOUT]
+#define MQTT_SETTINGS	topics[TOPIC_SETTINGS]
+#define MQTT_SETTINGS_SET	topics[TOPIC_SETTINGS_SET]
+#define MQTT_CALIBRATE	topics[TOPIC_CALIBRATE]
+#define MQTT_ENERGY		topics[TOPIC_ENERGY]
+#define MQTT_SERIES		topics[TOPIC_SERIES]
+#define MQTT_SERIES_QUERY	topics[TOPIC_SERIES_QUERY]
+
+#ifdef CONFIG_APPLICATION_DRIFT_COMPENSATION
+#define MQTT_DRIFT		topics[TOPIC_DRIFT]
+#define DRIFT_PERIOD		CONFIG_APPLICATION_DRIFT_PERIOD	/*!< Chip temperature sampling period in ms */
+#endif
+
+#define TOPIC_SIZE			(UUID_SIZE * 2)	/*!< Maximum topic size in bytes, as the incoming ones */
+#define ROLLOUT_SIZE		160			/*!< Maximum rollout report size in bytes */
+#define ROLLOUT_WAIT_STEP	3600000		/*!< Longest single wait of a rollout in ms, ticks do not overflow */
+#define ROLLOUT_RESTART_TIME	1000	/*!< Wait for the ready report to go out before restarting in ms */
+#define SNTP_INTERVAL		(CONFIG_APPLICATION_SNTP_INTERVAL * 60000)	/*!< SNTP poll period in ms */
+#define SETTINGS_VERSION	1			/*!< Schema version of the settings table */
+#define SETTINGS_SIZE		384			/*!< Maximum settings message size in bytes */
+#define SETTINGS_RESTART_TIME	1000	/*!< Wait for the settings to go out before restarting in ms */
+#define CALIBRATION_SIZE	192			/*!< Maximum calibration result size in bytes */
+#define ENERGY_SIZE			1024		/*!< Maximum energy message size in bytes */
+#define ENERGY_BATCHES		4			/*!< Energy messages published at most per reading */
+#define ENERGY_SAVE_PERIOD	(CONFIG_APPLICATION_ENERGY_SAVE_PERIOD * 60000)	/*!< Energy registers save period in ms */
+#define SERIES_PAGE_SIZE	4096		/*!< Maximum recent readings page size in bytes */
+#define SERIES_PAGE_LIMIT	100			/*!< Readings of a page at most */
+#define SERIES_EMPTY_SIZE	128			/*!< Page without readings in bytes */
+#define SETTINGS_PARTITION	"settings"	/*!< NVS partition of the settings, rules, calibration, drift and energy */
+#define SERIES_PARTITION	"series"	/*!< Data partition the recent readings are spilled to */
+
 #define WIFI_RECONNECT_TIME	30000		/*!<  */
 #define SEND_DATA_TIME		5000		/*!<  */
+#define FIRMWARE_URL		CONFIG_APPLICATION_FIRMWARE_UPG_URL	/*!< Image downloaded by a firmware update */
 #define NO_OF_TIMES			12			/*!<  */
 
 #define UUID_SIZE			36 			/*!< UUID size in bytes */
 
 #define MQTT_DEVICE_STATUS	"status"	/*!<  */
 
+/* Button macros */
+#define BUTTON_MEDIUM_TIME	CONFIG_BITEC_BUTTON_DEBOUNCE_MEDIUM_TIME	/*!< Press time in ms to erase the Wi-Fi credentials */
+#define BUTTON_LONG_TIME	CONFIG_BITEC_BUTTON_DEBOUNCE_LONG_TIME		/*!< Press time in ms of a long press */
+
+/* Relay macros */
+#define RELAY_CALIBRATE_CYCLES	4		/*!< On and off switches averaged by a calibration */
+
+/* Power meter macros, reference load of the calibrations started with the button or an empty message */
+#define CALIBRATION_VOLTAGE	CONFIG_APPLICATION_CALIBRATION_VOLTAGE	/*!< In V */
+#define CALIBRATION_CURRENT	(CONFIG_APPLICATION_CALIBRATION_CURRENT / 1000.0)	/*!< In A */
+#define CALIBRATION_POWER	CONFIG_APPLICATION_CALIBRATION_POWER	/*!< In W, 0 for a resistive load */
+
+/* RGB LED macros */
+#define LED_INTENSITY		127			/*!< Color intensity before gamma correction */
+#define LED_BREATHE_TIME	2000		/*!< Provisioning breathe period in ms */
+#define LED_BLINK_TIME		1000		/*!< Reconnecting blink period in ms */
+#define LED_FADE_TIME		500			/*!< Connected fade time in ms */
+#define LED_POST_TIME		100			/*!< Maximum wait for the animations queue in ms */
+
 /* ADC macros */
 #define NO_OF_SAMPLES   	64      	/*!< Multisampling */
 
+/* Board pins */
+#define RELAY_PIN			CONFIG_APPLICATION_RELAY_PIN	/*!< Relay output GPIO */
+#define PIR_PIN				CONFIG_APPLICATION_PIR_PIN		/*!< PIR sensor input GPIO */
+#define LDR_CHANNEL			CONFIG_APPLICATION_LDR_CHANNEL	/*!< Light sensor ADC1 channel */
+#define PIR_FILTER_TIME		(CONFIG_APPLICATION_PIR_FILTER_TIME * 1000)	/*!< PIR level stable time in us */
+
 /* typedef -------------------------------------------------------------------*/
 
-typedef struct
+typedef enum
 {
-	bool light;
-	int illumination;
-	bool presence;
-	float voltage;
-	float current;
-	float power;
-} payload_t;
+	TOPIC_SUBSCRIBE_1 = 0,
+	TOPIC_SUBSCRIBE_2,
+	TOPIC_CONNECT,
+	TOPIC_METRICS,
+	TOPIC_RULES,
+	TOPIC_EVENTS,
+	TOPIC_ROLLOUT,
+	TOPIC_SETTINGS,
+	TOPIC_SETTINGS_SET,
+	TOPIC_CALIBRATE,
+	TOPIC_DRIFT,
+	TOPIC_ENERGY,
+	TOPIC_SERIES,
+	TOPIC_SERIES_QUERY,
+	TOPIC_MAX
+} topic_e;
+
+/* Settings stored in the settings NVS partition, the Kconfig values are their defaults */
+typedef enum
+{
+	SETTING_ID = 0,				/*!< Device identifier in UUID form */
+	SETTING_MEASURE_TIME,		/*!< Power readings period in ms */
+	SETTING_R_CURRENT,			/*!< BL0937 current resistor in mOhm */
+	SETTING_R_VOLTAGE,			/*!< BL0937 voltage divider resistors */
+	SETTING_DARK_LEVEL,
+	SETTING_BRIGHT_LEVEL,
+	SETTING_HOLD_TIME,
+	SETTING_MAX_CURRENT,
+	SETTING_MAX_POWER,
+	SETTING_SAG_VOLTAGE,
+	SETTING_SWELL_VOLTAGE,
+	SETTING_MAX
+} setting_e;
+
+/* Values of the recent readings, stored every sensors cycle */
+typedef enum
+{
+	SERIES_VOLTAGE = 0,
+	SERIES_CURRENT,
+	SERIES_POWER,
+	SERIES_ACTIVE,
+	SERIES_POWER_FACTOR,
+	SERIES_ILLUMINATION,
+	SERIES_LIGHT,
+	SERIES_PRESENCE,
+	SERIES_MAX
+} series_channel_e;
 
 typedef struct
 {
-	char * device;		/*!< Device identifier in UUID form */
-	payload_t payload;	/*!< Data to send to MQTT broker */
+	const char * device;		/*!< Device identifier in UUID form */
+	int64_t uptime;				/*!< Of the last sensors readings in us, the payload time is taken from it */
+	bitec_payload_t payload;	/*!< Data to send to MQTT broker */
 } json_message_t;
 
 /* data declaration ----------------------------------------------------------*/
 
 static const char * TAG = "app";
 
+static const char * const topic_prefixes[TOPIC_MAX] =
+{
+#ifdef CONFIG_APPLICATION_USER_DEFINED_SUBSCRIPTION_1_ENABLE
+	[TOPIC_SUBSCRIBE_1] = CONFIG_APPLICATION_USER_DEFINED_SUBSCRIPTION_1_TOPIC,
+#endif
+#ifdef CONFIG_APPLICATION_USER_DEFINED_SUBSCRIPTION_2_ENABLE
+	[TOPIC_SUBSCRIBE_2] = CONFIG_APPLICATION_USER_DEFINED_SUBSCRIPTION_2_TOPIC,
+#endif
+#ifdef CONFIG_APPLICATION_CONNECT_PUBLISHING_ENABLE
+	[TOPIC_CONNECT] = CONFIG_APPLICATION_CONNECT_PUBLISHING_TOPIC,
+#endif
+#ifdef CONFIG_APPLICATION_METRICS_PUBLISHING_ENABLE
+	[TOPIC_METRICS] = CONFIG_APPLICATION_METRICS_PUBLISHING_TOPIC,
+#endif
+	[TOPIC_RULES] = CONFIG_APPLICATION_RULES_TOPIC,
+	[TOPIC_EVENTS] = CONFIG_APPLICATION_EVENTS_TOPIC,
+	[TOPIC_ROLLOUT] = CONFIG_APPLICATION_ROLLOUT_TOPIC,
+	[TOPIC_SETTINGS] = CONFIG_APPLICATION_SETTINGS_TOPIC,
+	[TOPIC_SETTINGS_SET] = CONFIG_APPLICATION_SETTINGS_SET_TOPIC,
+	[TOPIC_CALIBRATE] = CONFIG_APPLICATION_CALIBRATION_TOPIC,
+#ifdef CONFIG_APPLICATION_DRIFT_COMPENSATION
+	[TOPIC_DRIFT] = CONFIG_APPLICATION_DRIFT_TOPIC,
+#endif
+	[TOPIC_ENERGY] = CONFIG_APPLICATION_ENERGY_TOPIC,
+	[TOPIC_SERIES] = CONFIG_APPLICATION_SERIES_TOPIC,
+	[TOPIC_SERIES_QUERY] = CONFIG_APPLICATION_SERIES_QUERY_TOPIC,
+};
+
+static const bitec_settings_entry_t settings_entries[SETTING_MAX] =
+{
+	[SETTING_ID] = { "id", SETTINGS_STRING, 0, UUID_SIZE, 0, CONFIG_APPLICATION_DEVICE_ID, SETTINGS_RESTART },
+	[SETTING_MEASURE_TIME] = { "measure_time", SETTINGS_INT, 100, 60000, CONFIG_APPLICATION_MEASURE_TIME, NULL, 0 },
+	[SETTING_R_CURRENT] = { "r_current", SETTINGS_INT, 1, 1000, CONFIG_BL0937_R_CURRENT, NULL, SETTINGS_RESTART },
+	[SETTING_R_VOLTAGE] = { "r_voltage", SETTINGS_INT, 1, 100000, CONFIG_BL0937_R_VOLTAGE, NULL, SETTINGS_RESTART },
+	[SETTING_DARK_LEVEL] = { "dark_level", SETTINGS_INT, 0, 8191, CONFIG_BITEC_RELAY_DARK_LEVEL, NULL, 0 },
+	[SETTING_BRIGHT_LEVEL] = { "bright_level", SETTINGS_INT, 0, 8191, CONFIG_BITEC_RELAY_BRIGHT_LEVEL, NULL, 0 },
+	[SETTING_HOLD_TIME] = { "hold_time", SETTINGS_INT, 0, 3600000, CONFIG_BITEC_RELAY_HOLD_TIME, NULL, 0 },
+	[SETTING_MAX_CURRENT] = { "max_current", SETTINGS_INT, 1, 100000, CONFIG_BITEC_MONITOR_MAX_CURRENT, NULL, 0 },
+	[SETTING_MAX_POWER] = { "max_power", SETTINGS_INT, 1, 100000, CONFIG_BITEC_MONITOR_MAX_POWER, NULL, 0 },
+	[SETTING_SAG_VOLTAGE] = { "sag_voltage", SETTINGS_INT, 0, 500, CONFIG_BITEC_MONITOR_SAG_VOLTAGE, NULL, 0 },
+	[SETTING_SWELL_VOLTAGE] = { "swell_voltage", SETTINGS_INT, 0, 500, CONFIG_BITEC_MONITOR_SWELL_VOLTAGE, NULL, 0 },
+};
+
+/* Binary fraction digits kept of the recent readings, below the resolution of each one */
+static const int8_t series_precisions[SERIES_MAX] =
+{
+	[SERIES_VOLTAGE] = 3,		/* 0.125 V */
+	[SERIES_CURRENT] = 10,		/* 1 mA */
+	[SERIES_POWER] = 2,
+	[SERIES_ACTIVE] = 2,
+	[SERIES_POWER_FACTOR] = 7,
+	[SERIES_ILLUMINATION] = 0,
+	[SERIES_LIGHT] = 0,
+	[SERIES_PRESENCE] = 0,
+};
+
+static char topics[TOPIC_MAX][TOPIC_SIZE];
+
 static TaskHandle_t reconnect_handle = NULL;
 static TaskHandle_t send_data_handle = NULL;
+static TaskHandle_t ota_handle = NULL;
+static TaskHandle_t rollout_handle = NULL;
 static bitec_wifi_t wifi;
 static bitec_mqtt_t mqtt;
 static bitec_button_t button;
+static bitec_input_t input;
+static bitec_relay_t relay;
+static bitec_rules_t rules;
+static bitec_monitor_t monitor;
+static bitec_monitor_sample_t sample;	/*!< Last power reading */
+static bitec_ota_t ota;
+static bitec_ota_rollout_t rollout;
+static SemaphoreHandle_t rollout_mutex;
+static SemaphoreHandle_t rules_mutex;
 static bl0937_t bl0937;
+static bl0937_calibration_t calibration;
+static volatile bool calibrating = false;	/*!< Set while measure_task runs the calibration, the relay is on */
+#ifdef CONFIG_APPLICATION_DRIFT_COMPENSATION
+static bl0937_drift_t drift;
+static SemaphoreHandle_t drift_mutex;	/*!< Protects the curve and the multipliers it corrects */
+#endif
+static bitec_energy_t energy;
+static SemaphoreHandle_t energy_mutex;	/*!< Protects the registers, measure_task adds to them */
+static bitec_series_t series;
+static SemaphoreHandle_t series_mutex;	/*!< Protects the recent readings, queried from the MQTT task */
+static bitec_clock_t sntp_clock;
+static SemaphoreHandle_t clock_mutex;	/*!< Protects the mapping of the uptime, synced from the lwIP task */
+static bitec_settings_t settings;
+#ifdef CONFIG_BITEC_LATENCY_ENABLE
+static bitec_latency_t latency;
+#endif
 
 /* Application variables */
 static json_message_t message;
@@ -89,75 +299,213 @@ static json_message_t message;
 static void wifi_events_task(void * arg);
 static void mqtt_events_task(void * arg);
 static void button_events_task(void * arg);
+static void input_events_task(void * arg);
 
 static void reconnect_task(void * arg);
 static void send_data_task(void * arg);
 static void get_sensors_task(void * arg);
+static void measure_task(void * arg);
+static void ota_task(void * arg);
+static void rollout_task(void * arg);
+
+#ifdef CONFIG_APPLICATION_METRICS_PUBLISHING_ENABLE
+static int metrics_add(char * buf, int len, size_t size, const char * name, int (* print)(char * buf, size_t size));
+static int metrics_print_relay(char * buf, size_t size);
+static int metrics_print_monitor(char * buf, size_t size);
+static int metrics_print_ota(char * buf, size_t size);
+static int metrics_print_energy(char * buf, size_t size);
+static int metrics_print_series(char * buf, size_t size);
+static int metrics_print_clock(char * buf, size_t size);
+#ifdef CONFIG_APPLICATION_DRIFT_COMPENSATION
+static int metrics_print_drift(char * buf, size_t size);
+#endif
+#endif
+
+static void alarm_publish(bitec_monitor_anomaly_e anomaly, int64_t uptime);
+static void energy_add(uint32_t pulses, int64_t uptime);
+static void energy_publish(void);
+static void restart(void);
+
+static void series_sample(int64_t uptime);
+static void series_receive(const char * data, int len);
+
+static void rules_apply(void);
+static void rules_receive(const char * data, int len);
+
+static void settings_apply(void);
+static void settings_receive(const char * data, int len);
+static void settings_publish(void);
+
+static void calibration_start(float voltage, float current, float power);
+static void calibration_receive(const char * data, int len);
+static void calibration_end(void);
 
+#ifdef CONFIG_APPLICATION_DRIFT_COMPENSATION
+static void drift_sample(void);
+static void drift_rebase(bool calibrated);
+static void drift_receive(const char * data, int len);
+#endif
+
+static void rollout_receive(const char * data, int len);
+static bool rollout_ready(void);
+static void rollout_report(const bitec_ota_rollout_t * const me, void * arg);
+static int64_t clock_ms(void);
+static int64_t clock_at(int64_t uptime);
+static void clock_sync(int64_t uptime, int64_t time);
 
 /**/
-static esp_err_t nvs_init(void);
 
 /* main ----------------------------------------------------------------------*/
 
 void app_main(void)
 {
-	message.device = CONFIG_APPLICATION_DEVICE_ID;
-
 	ESP_LOGI(TAG, "Initializing device...");
 
-	/* Initialize Relay GPIO */
-	gpio_config_t gpio_conf;
-	gpio_conf.intr_type = GPIO_INTR_DISABLE;
-	gpio_conf.mode = GPIO_MODE_OUTPUT;
-	gpio_conf.pin_bit_mask = (1ULL << GPIO_NUM_6);
-	gpio_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
-	gpio_conf.pull_up_en = GPIO_PULLUP_DISABLE;
-	ESP_ERROR_CHECK(gpio_config(&gpio_conf));
-
-	/* Configure PIR pin */
-	gpio_conf.intr_type = GPIO_INTR_DISABLE;
-	gpio_conf.mode = GPIO_MODE_INPUT;
-	gpio_conf.pin_bit_mask = (1ULL << GPIO_NUM_8);
-	gpio_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
-	gpio_conf.pull_up_en = GPIO_PULLUP_DISABLE;
-	gpio_config(&gpio_conf);
+#ifdef CONFIG_BITEC_TRACE_ENABLE
+	/* Initialize trace ring before any component can record on it */
+	ESP_ERROR_CHECK(bitec_trace_init());
+#endif
+
+	/* Initizalize NVS storage */
+	ESP_ERROR_CHECK(hal_nvs_init(NULL));
+
+	/* The stores of the settings partition start from their defaults without it */
+	esp_err_t ret = hal_nvs_init(SETTINGS_PARTITION);
+
+	if(ret != ESP_OK)
+		ESP_LOGW(TAG, "Settings partition unavailable, running on defaults: %s", esp_err_to_name(ret));
+
+	/* Restore the settings before they are used, defaults until some are stored */
+	ESP_ERROR_CHECK(bitec_settings_init(&settings, settings_entries, SETTING_MAX, SETTINGS_VERSION));
+	bitec_settings_restore(&settings);
+	message.device = bitec_settings_get_string(&settings, SETTING_ID);
+
+	for(int i = 0; i < TOPIC_MAX; i++)
+	{
+		if(topic_prefixes[i] != NULL)
+			snprintf(topics[i], TOPIC_SIZE, "%s%s", topic_prefixes[i], message.device);
+	}
+
+	/* Initialize relay controller */
+	relay.pin = RELAY_PIN;
+	relay.zc_pin = CONFIG_BITEC_RELAY_ZC_PIN;
+	relay.sense_pin = CONFIG_BITEC_RELAY_SENSE_PIN;
+	ESP_ERROR_CHECK(bitec_relay_init(&relay));
+
+	/* Initialize digital inputs and add the PIR sensor, presence changes are events */
+	ESP_ERROR_CHECK(bitec_input_init(&input));
+	ESP_ERROR_CHECK(bitec_input_add(&input, PIR_PIN, HAL_GPIO_PULL_NONE, PIR_FILTER_TIME, NULL));
+	message.payload.presence = bitec_input_get_level(&input, PIR_PIN);
+	bitec_relay_set_presence(&relay, message.payload.presence);
 
 	/* Configure ADC */
-	adc1_config_width(ADC_WIDTH_BIT_13);
-	adc1_config_channel_atten(ADC_CHANNEL_6, ADC_ATTEN_DB_11);
+	hal_adc_config(LDR_CHANNEL);
 
 
 	/* Initialize BL0937 instance */
 	bl0937.cf_pin = CONFIG_BL0937_CF_PIN;
 	bl0937.cf1_pin = CONFIG_BL0937_CF1_PIN;
 	bl0937.sel_pin = CONFIG_BL0937_SEL_PIN;
-	bl0937.current_resistor = (float)CONFIG_BL0937_R_CURRENT / 1000;
-	bl0937.voltage_resistor = CONFIG_BL0937_R_VOLTAGE;
+	bl0937.current_resistor = (float)bitec_settings_get(&settings, SETTING_R_CURRENT) / 1000;
+	bl0937.voltage_resistor = bitec_settings_get(&settings, SETTING_R_VOLTAGE);
 
 	ESP_ERROR_CHECK(bl0937_init(&bl0937));
 
+#ifdef CONFIG_APPLICATION_DRIFT_COMPENSATION
+	/* Correct the multipliers with the chip temperature, along the curve of the device */
+	ESP_ERROR_CHECK(hal_temp_init());
+	bl0937_drift_init(&drift);
+	bl0937_drift_restore(&drift);
+	bl0937_drift_rebase(&bl0937, &drift);
+	drift_mutex = xSemaphoreCreateMutex();
+
+	if(drift_mutex == NULL)
+		ESP_ERROR_CHECK(ESP_ERR_NO_MEM);
+#endif
+
+	/* Every time is of the uptime, mapped to the unix time once SNTP syncs */
+	bitec_clock_init(&sntp_clock);
+	clock_mutex = xSemaphoreCreateMutex();
+
+	if(clock_mutex == NULL)
+		ESP_ERROR_CHECK(ESP_ERR_NO_MEM);
+
+	/* Restore the energy registers, their intervals and tariffs are of the local time */
+	setenv("TZ", CONFIG_APPLICATION_TIMEZONE, 1);
+	tzset();
+	ESP_ERROR_CHECK(bitec_energy_init(&energy));
+	bitec_energy_restore(&energy);
+	energy_mutex = xSemaphoreCreateMutex();
+
+	if(energy_mutex == NULL)
+		ESP_ERROR_CHECK(ESP_ERR_NO_MEM);
+
+	/* Keep the readings of every sensors cycle, in flash too once a block of them is full */
+	ESP_ERROR_CHECK(bitec_series_init(&series, SERIES_MAX, series_precisions));
+#ifdef CONFIG_APPLICATION_SERIES_SPILL
+	if(bitec_series_spill(&series, SERIES_PARTITION) != ESP_OK)
+		ESP_LOGW(TAG, "Recent readings kept in RAM only");
+#endif
+	series_mutex = xSemaphoreCreateMutex();
+
+	if(series_mutex == NULL)
+		ESP_ERROR_CHECK(ESP_ERR_NO_MEM);
+
+	/* Initialize the power readings monitor */
+	bitec_monitor_init(&monitor);
+
+	/* Relay and monitor limits from the settings */
+	settings_apply();
+
+#ifdef CONFIG_BITEC_LATENCY_ENABLE
+	/* Initialize latency probes */
+	ESP_ERROR_CHECK(bitec_latency_init(&latency));
+#endif
+
 	/* Initialize WS2812B LED */
 	ESP_ERROR_CHECK(ws2812_led_init());
+	ESP_ERROR_CHECK(ws2812_anim_init());
 
 	/* Initialize button instance */
 	ESP_ERROR_CHECK(bitec_button_init(&button));
 
-	/* Initizalize NVS storage */
-	ESP_ERROR_CHECK(nvs_init());
+	/* Initialize firmware updates, a new image starts its self test */
+	ESP_ERROR_CHECK(bitec_ota_init(&ota));
+
+	/* Initialize firmware rollouts, their state is published as it changes */
+	bitec_ota_rollout_init(&rollout);
+	rollout.report = rollout_report;
+	rollout_mutex = xSemaphoreCreateMutex();
+
+	if(rollout_mutex == NULL)
+		ESP_ERROR_CHECK(ESP_ERR_NO_MEM);
+
+	/* Restore the rules, they run without connection */
+	rules_mutex = xSemaphoreCreateMutex();
+
+	if(rules_mutex == NULL)
+		ESP_ERROR_CHECK(ESP_ERR_NO_MEM);
+
+	bitec_rules_restore(&rules);
 
     /* Initialize Wi-Fi component */
     ESP_ERROR_CHECK(bitec_wifi_init(&wifi));
 
     /* Initialize MQTT component */
+#ifdef CONFIG_BITEC_LATENCY_ENABLE
+	mqtt.latency = &latency;
+#endif
+	mqtt.device = message.device;
 	ESP_ERROR_CHECK(bitec_mqtt_init(&mqtt));
 
 	/* Create RTOS tasks */
 	/* Create FreeRTOS tasks */
 	xTaskCreate(wifi_events_task, "Wi-Fi Events Task", configMINIMAL_STACK_SIZE * 4, NULL, configMAX_PRIORITIES - 2, NULL);
 	xTaskCreate(button_events_task, "Buton Events Task", configMINIMAL_STACK_SIZE * 4, NULL, configMAX_PRIORITIES - 3, NULL);
+	xTaskCreate(input_events_task, "Input Events Task", configMINIMAL_STACK_SIZE * 2, NULL, configMAX_PRIORITIES - 3, NULL);
 	xTaskCreate(mqtt_events_task, "MQTT Events Task", configMINIMAL_STACK_SIZE * 4, NULL, configMAX_PRIORITIES - 1, NULL);
 	xTaskCreate(get_sensors_task, "Get Sensors Task", configMINIMAL_STACK_SIZE * 2, NULL, tskIDLE_PRIORITY + 3, NULL);
+	xTaskCreate(measure_task, "Measure Task", configMINIMAL_STACK_SIZE * 3, NULL, tskIDLE_PRIORITY + 4, NULL);
 }
 
 /* function definition -------------------------------------------------------*/
@@ -172,7 +520,7 @@ static void reconnect_task(void * arg)
 		/* Try connecting to Wi-Fi router using stored credentials. If connection is successful
 		 * then the task delete itself, in other cases this function is executed again*/
 		ESP_LOGI(TAG, "Unable to connect. Retrying...");
-		esp_wifi_connect();
+		bitec_wifi_reconnect(&wifi);
 
 		/* Wait 30 sec to try reconnecting */
 		vTaskDelayUntil(&last_time_wake, pdMS_TO_TICKS(WIFI_RECONNECT_TIME));
@@ -186,30 +534,23 @@ static void get_sensors_task(void * arg)
 
 	for(;;)
 	{
-		/* Get ADC samples */
-		for(uint8_t i = 0; i < NO_OF_SAMPLES; i++)
-			message.payload.illumination += adc1_get_raw((adc1_channel_t)ADC_CHANNEL_6);
-
-		/* Get ADC and PIR values, and print them */
-		message.payload.illumination /= NO_OF_SAMPLES;
-		message.payload.presence = gpio_get_level(GPIO_NUM_8);
+		/* Get ADC value, presence comes from the input events */
+		message.uptime = hal_time_us();
+		message.payload.illumination = bitec_payload_adc_average(LDR_CHANNEL, NO_OF_SAMPLES);
 
 		/* Set Relay value */
-		if(message.payload.illumination < 2000 && message.payload.presence)
-		{
-			message.payload.light = true;
-			gpio_set_level(GPIO_NUM_6, message.payload.light);
-		}
-		else if(message.payload.illumination >= 4000 && !message.payload.light)
-		{
-			message.payload.light = false;
-			gpio_set_level(GPIO_NUM_6, message.payload.light);
-		}
-		else if(!message.payload.presence)
-		{
-			message.payload.light = false;
-			gpio_set_level(GPIO_NUM_6, message.payload.light);
-		}
+		bitec_relay_set_illumination(&relay, message.payload.illumination);
+
+		/* Run the local rules on the new readings */
+		rules_apply();
+		message.payload.light = bitec_relay_get_state(&relay);
+
+		/* Kept for the queries of the backend */
+		series_sample(message.uptime);
+
+#ifdef CONFIG_BITEC_LATENCY_ENABLE
+		bitec_latency_stamp(&latency, LATENCY_STAGE_SAMPLE);
+#endif
 
 		/* Add 1 to counter and notify send data task when counter is NO_OF_TIMES */
 		counter++;
@@ -222,115 +563,258 @@ static void get_sensors_task(void * arg)
 			counter = 0;
 		}
 
+#ifdef CONFIG_BITEC_LATENCY_ENABLE
+		/* Record how late the loop is when its period has already elapsed */
+		TickType_t elapsed_time = xTaskGetTickCount() - last_time_wake;
+
+		if(elapsed_time >= pdMS_TO_TICKS(SEND_DATA_TIME))
+			bitec_latency_overrun(&latency, (elapsed_time - pdMS_TO_TICKS(SEND_DATA_TIME)) * portTICK_PERIOD_MS * 1000);
+#endif
+
 		/* Wait SEND_DATA_TIME to get sensors values again */
 		vTaskDelayUntil(&last_time_wake, pdMS_TO_TICKS(SEND_DATA_TIME));
 	}
 }
 
-static void send_data_task(void * arg)
+static void measure_task(void * arg)
 {
-	uint32_t event_to_process;
+	TickType_t last_time_wake = xTaskGetTickCount();
+	TickType_t save_time = last_time_wake;
+	uint32_t pulses = bl0937.pulse_count;
+#ifdef CONFIG_APPLICATION_DRIFT_COMPENSATION
+	TickType_t drift_time = last_time_wake - pdMS_TO_TICKS(DRIFT_PERIOD);
+#endif
 
 	for(;;)
 	{
-		event_to_process = ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+		/* The calibration takes the pulse widths the readings below are made of */
+		if(calibrating && bl0937_calibration_update(&bl0937, &calibration))
+			calibration_end();
 
-		if(event_to_process != 0)
+#ifdef CONFIG_APPLICATION_DRIFT_COMPENSATION
+		/* The multipliers only change once the temperature moved, the readings just use them */
+		if(xTaskGetTickCount() - drift_time >= pdMS_TO_TICKS(DRIFT_PERIOD))
 		{
-			/* Get electrical parameter values */
-			message.payload.voltage = (float)bl0937_get_voltage(&bl0937);
-			message.payload.current = (float)bl0937_get_current(&bl0937);
-			message.payload.power = (float)bl0937_get_apparent_power(&bl0937);
+			drift_time = xTaskGetTickCount();
+			drift_sample();
+		}
+#endif
 
-			/* Create JSON message */
-			char * string = NULL;
-			cJSON * device = NULL;
-			cJSON * payload = NULL;
-			cJSON * light = NULL;
-			cJSON * illumination = NULL;
-			cJSON * presence = NULL;
-			cJSON * voltage = NULL;
-			cJSON * current = NULL;
-			cJSON * power = NULL;
-
-			cJSON * data = cJSON_CreateObject();
-			if(data == NULL)
-				break;
+		/* Only reader of the BL0937, the status message gets the last values */
+		bl0937_estimate_t estimate;
 
-			device = cJSON_CreateString(message.device);
-			if(device == NULL)
-				break;
+		bl0937_estimate(&bl0937, &estimate);
+		int64_t uptime = hal_time_us();
+		message.payload.voltage = estimate.voltage;
+		message.payload.current = estimate.current;
+		message.payload.power = estimate.apparent;
+		message.payload.active = estimate.active;
+		message.payload.power_factor = estimate.power_factor;
+		message.payload.confidence = estimate.confidence;
 
-			payload = cJSON_CreateObject();
-			if(payload == NULL)
-				break;
+		sample.voltage = (uint16_t)lroundf(estimate.voltage);
+		sample.current = (uint32_t)lroundf(estimate.current * 1000);
+		sample.power = (uint32_t)lroundf(estimate.apparent);
+		sample.relay = bitec_relay_get_state(&relay);
 
-			light = cJSON_CreateNumber(message.payload.light);
-			if(payload == NULL)
-				break;
+		/* Every CF pulse is the same energy, the pulses since the last reading are counted */
+		uint32_t count = bl0937.pulse_count;
 
-			illumination = cJSON_CreateNumber(message.payload.illumination);
-			if(illumination == NULL)
-				break;
+		energy_add(count - pulses, uptime);
+		pulses = count;
+		message.payload.energy = bitec_energy_total(&energy);
 
-			voltage = cJSON_CreateNumber(message.payload.voltage);
-			if(voltage == NULL)
-				break;
+		/* Closed intervals go out once connected, the registers are saved now and then */
+		if(send_data_handle != NULL)
+			energy_publish();
 
-			current = cJSON_CreateNumber(message.payload.current);
-			if(current == NULL)
-				break;
+		if(xTaskGetTickCount() - save_time >= pdMS_TO_TICKS(ENERGY_SAVE_PERIOD))
+		{
+			save_time = xTaskGetTickCount();
+			xSemaphoreTake(energy_mutex, portMAX_DELAY);
+			bitec_energy_save(&energy);
+			xSemaphoreGive(energy_mutex);
+		}
 
-			power = cJSON_CreateNumber(message.payload.power);
-			if(power == NULL)
-				break;
+		uint32_t raised = bitec_monitor_update(&monitor, &sample);
 
-			presence = cJSON_CreateNumber(message.payload.presence);
-			if(presence == NULL)
-				break;
+#ifdef CONFIG_APPLICATION_OVERLOAD_TRIP
+		/* Disconnect the load before anything else */
+		if(raised & MONITOR_OVERLOAD)
+			bitec_relay_trip(&relay);
+#endif
 
-			cJSON_AddItemToObject(data, "device", device);
-			cJSON_AddItemToObject(data, "payload", payload);
-			cJSON_AddItemToObject(payload, "light", light);
-			cJSON_AddItemToObject(payload, "illumination", illumination);
-			cJSON_AddItemToObject(payload, "presence", presence);
-			cJSON_AddItemToObject(payload, "voltage", voltage);
-			cJSON_AddItemToObject(payload, "current", current);
-			cJSON_AddItemToObject(payload, "power", power);
+		/* Alarms go out at once, not with the next status message */
+		for(int i = 0; i < MONITOR_MAX; i++)
+		{
+			if(raised & (1UL << i))
+				alarm_publish(i, uptime);
+		}
 
-			string = cJSON_Print(data);
+		/* The period can be set at any time */
+		vTaskDelayUntil(&last_time_wake, pdMS_TO_TICKS(bitec_settings_get(&settings, SETTING_MEASURE_TIME)));
+	}
+}
 
-			/* Send json message to broker*/
-			ESP_LOGI(TAG, "Publising %s to %s", string, MQTT_DEVICE_STATUS);
-			esp_mqtt_client_publish(mqtt.client, MQTT_DEVICE_STATUS, string, 0, 0, 0);
+static void ota_task(void * arg)
+{
+	/* Restart into the new image, it is rolled back unless it reaches the broker */
+	if(bitec_ota_update(&ota, FIRMWARE_URL) == ESP_OK)
+		restart();
 
-			/* Delete JSON object */
-			cJSON_Delete(data);
+	ota_handle = NULL;
+	vTaskDelete(NULL);
+}
+
+static void rollout_task(void * arg)
+{
+	for(;;)
+	{
+		xSemaphoreTake(rollout_mutex, portMAX_DELAY);
+
+		/* Done once the rollout no longer waits, a new descriptor starts the task again */
+		if(rollout.state != BITEC_OTA_ROLLOUT_SCHEDULED && rollout.state != BITEC_OTA_ROLLOUT_DEFERRED)
+		{
+			rollout_handle = NULL;
+			xSemaphoreGive(rollout_mutex);
+			vTaskDelete(NULL);
+		}
+
+		uint32_t wait = rollout.wait < ROLLOUT_WAIT_STEP ? rollout.wait : ROLLOUT_WAIT_STEP;
+		xSemaphoreGive(rollout_mutex);
+
+		/* A new descriptor wakes the task up to wait for its own slot */
+		if(ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait)) > 0)
+			continue;
+
+		/* Held during the download, descriptors received meanwhile are not taken */
+		xSemaphoreTake(rollout_mutex, portMAX_DELAY);
+
+		if(rollout.wait > wait)
+			rollout.wait -= wait;
+		else if(bitec_ota_rollout_check(&rollout, rollout_ready()) && bitec_ota_rollout_update(&rollout, &ota) == ESP_OK)
+		{
+			/* Restart into the new image, it is rolled back unless it reaches the broker */
+			vTaskDelay(pdMS_TO_TICKS(ROLLOUT_RESTART_TIME));
+			restart();
 		}
+
+		xSemaphoreGive(rollout_mutex);
 	}
 }
 
-static esp_err_t nvs_init(void)
+static void input_events_task(void * arg)
 {
-	esp_err_t ret;
-
-	const esp_partition_t * partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_NVS_KEYS, NULL);
+	bitec_input_event_t event;
 
-	if(partition != NULL)
+	for(;;)
 	{
-		nvs_sec_cfg_t nvs_sec_cfg;
+		xQueueReceive(input.queue, &event, portMAX_DELAY);
 
-		if(nvs_flash_read_security_cfg(partition, &nvs_sec_cfg) != ESP_OK)
-			ESP_ERROR_CHECK(nvs_flash_generate_keys(partition, &nvs_sec_cfg));
+		if(event.pin == PIR_PIN)
+		{
+			BITEC_TRACE(TAG, TRACE_APP_PRESENCE, event.level, 0, "Presence %s", event.level ? "detected" : "cleared");
 
-		/* Initialize secure NVS */
-//		ESP_ERROR_CHECK(nvs_flash_erase());	/* Erase any stored Wi-Fi credential  */
-		ret = nvs_flash_secure_init(&nvs_sec_cfg);
+			/* Switch the relay on the presence change instead of on the next sensors reading */
+			message.payload.presence = event.level;
+			bitec_relay_set_presence(&relay, event.level);
+			message.payload.light = bitec_relay_get_state(&relay);
+		}
 	}
-	else
-		return ESP_FAIL;
+}
+
+static void send_data_task(void * arg)
+{
+	uint32_t event_to_process;
+#ifdef CONFIG_APPLICATION_METRICS_PUBLISHING_ENABLE
+	uint16_t publish_counter = 0;
+#endif
+
+	for(;;)
+	{
+		event_to_process = ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+		if(event_to_process != 0)
+		{
+#ifdef CONFIG_BITEC_LATENCY_ENABLE
+			bitec_latency_stamp(&latency, LATENCY_STAGE_NOTIFY);
+#endif
+
+			/* Relay may have switched on a dwell or hold time since the last reading */
+			message.payload.light = bitec_relay_get_state(&relay);
+
+			/* Electrical parameter values come from the last reading of the measure task */
+			message.payload.time = clock_at(message.uptime);
+
+			/* Create JSON message */
+			char * string = bitec_payload_print(message.device, &message.payload);
+
+			if(string == NULL)
+				continue;
+
+#ifdef CONFIG_BITEC_LATENCY_ENABLE
+			bitec_latency_stamp(&latency, LATENCY_STAGE_SERIALIZE);
+#endif
+
+			/* Send json message to broker*/
+			int msg_id = esp_mqtt_client_publish(mqtt.client, MQTT_DEVICE_STATUS, string, 0, CONFIG_APPLICATION_STATUS_PUBLISHING_QOS, 0);
+
+#ifdef CONFIG_BITEC_LATENCY_ENABLE
+			bitec_latency_enqueued(&latency, msg_id);
+#endif
+
+			BITEC_TRACE(TAG, TRACE_APP_PUBLISH_STATUS, strlen(string), msg_id, "Published %s to %s, msg_id=%d", string, MQTT_DEVICE_STATUS, msg_id);
+
+#ifdef CONFIG_APPLICATION_METRICS_PUBLISHING_ENABLE
+			/* Send latency histograms every CONFIG_APPLICATION_METRICS_PUBLISHING_INTERVAL status messages */
+			if(++publish_counter >= CONFIG_APPLICATION_METRICS_PUBLISHING_INTERVAL)
+			{
+				char * metrics = malloc(sizeof(char) * METRICS_SIZE);
+
+				if(metrics != NULL)
+				{
+					int len = bitec_latency_print(&latency, metrics, METRICS_SIZE);
+
+					if(len > 0)
+						len = metrics_add(metrics, len, METRICS_SIZE, "relay", metrics_print_relay);
+
+					if(len > 0)
+						len = metrics_add(metrics, len, METRICS_SIZE, "monitor", metrics_print_monitor);
+
+					if(len > 0)
+						len = metrics_add(metrics, len, METRICS_SIZE, "ota", metrics_print_ota);
+
+#ifdef CONFIG_APPLICATION_DRIFT_COMPENSATION
+					if(len > 0)
+						len = metrics_add(metrics, len, METRICS_SIZE, "drift", metrics_print_drift);
+#endif
+
+					if(len > 0)
+						len = metrics_add(metrics, len, METRICS_SIZE, "energy", metrics_print_energy);
+
+					if(len > 0)
+						len = metrics_add(metrics, len, METRICS_SIZE, "series", metrics_print_series);
+
+					if(len > 0)
+						len = metrics_add(metrics, len, METRICS_SIZE, "clock", metrics_print_clock);
 
-	return ret;
+					if(len > 0)
+					{
+						int metrics_msg_id = esp_mqtt_client_publish(mqtt.client, MQTT_METRICS, metrics, len, 0, 0);
+						BITEC_TRACE(TAG, TRACE_APP_PUBLISH_METRICS, len, metrics_msg_id, "Published to %s, msg_id=%d", MQTT_METRICS, metrics_msg_id);
+					}
+
+					free(metrics);
+				}
+
+				publish_counter = 0;
+			}
+#endif
+
+			/* Free JSON message */
+			cJSON_free(string);
+		}
+	}
 }
 
 static void wifi_events_task(void * arg)
@@ -343,13 +827,23 @@ static void wifi_events_task(void * arg)
 		bits = xEventGroupWaitBits(wifi.event_group, 0xFF, pdTRUE, pdFALSE, portMAX_DELAY);
 
 		if(bits & WIFI_PROV_CRED_FAIL_BIT)
-			esp_restart();	/* Restart the device */
+			restart();	/* Restart the device */
 		else if(bits & WIFI_PROV_CRED_RECV_BIT)
-			ws2812_led_set_hsv(240, 100, 25); /* Set RGB LED in blue color*/
+		{
+			/* Breathe RGB LED in blue color */
+			ws2812_anim_t anim = WS2812_ANIM_DEFAULT(WS2812_ANIM_BREATHE, 0, 0, LED_INTENSITY, LED_BREATHE_TIME);
+			ws2812_anim_post(&anim, LED_POST_TIME);
+		}
 		else if(bits & IP_EVENT_STA_GOT_IP_BIT)
 		{
 			esp_mqtt_client_start(mqtt.client);	/* Start MQTT client */
-			ws2812_led_set_hsv(120, 100, 25);	/* Set RGB LED in green color */
+
+			/* Polls on its own once started, the HAL ignores the start of a reconnection */
+			hal_sntp_start(CONFIG_APPLICATION_SNTP_SERVER, SNTP_INTERVAL, clock_sync);
+
+			/* Fade RGB LED to green color */
+			ws2812_anim_t anim = WS2812_ANIM_DEFAULT(WS2812_ANIM_FADE_TO, 0, LED_INTENSITY, 0, LED_FADE_TIME);
+			ws2812_anim_post(&anim, LED_POST_TIME);
 		}
 		else if(bits & WIFI_EVENT_STA_CONNECTED_BIT)
 		{
@@ -362,11 +856,12 @@ static void wifi_events_task(void * arg)
 		}
 		else if(bits & WIFI_EVENT_STA_DISCONNECTED_BIT)
 		{
-			/* Create task to reconnect to AP and set RGB led in blue color */
+			/* Create task to reconnect to AP and blink RGB led in blue color */
 			if(reconnect_handle == NULL)
 				xTaskCreate(reconnect_task, "Reconnect Task", configMINIMAL_STACK_SIZE * 3, NULL, tskIDLE_PRIORITY + 1, &reconnect_handle);
 
-	        ws2812_led_set_hsv(240, 100, 25);
+			ws2812_anim_t anim = WS2812_ANIM_DEFAULT(WS2812_ANIM_BLINK, 0, 0, LED_INTENSITY, LED_BLINK_TIME);
+			ws2812_anim_post(&anim, LED_POST_TIME);
 		}
 		else
 			ESP_LOGI(TAG, "Wi-Fi unexpected Event");
@@ -382,23 +877,52 @@ static void mqtt_events_task(void * arg)
 		/* Wait until some bit is set */
 		bits = xEventGroupWaitBits(mqtt.event_group, MQTT_EVENT_CONNECTED_BIT | MQTT_EVENT_DATA_BIT, pdTRUE, pdFALSE, portMAX_DELAY);
 
+		/* Bits set together are all cleared by the wait, each one is handled */
 		if(bits & MQTT_EVENT_CONNECTED_BIT)
 		{
-			ESP_LOGI(TAG, "MQTT_EVENT_CONNECTED_BIT set!");
+			BITEC_TRACE(TAG, TRACE_APP_MQTT_CONNECTED, 0, 0, "MQTT_EVENT_CONNECTED_BIT set!");
+
+			/* Reaching the broker is the self test of a new image, it can be updated again from here */
+			bitec_ota_self_test(&ota, true);
+
+			int msg_id;
 
 			/* Send connected message */
-			ESP_LOGI(TAG, "Publising to %s", MQTT_CONNECT);
-			esp_mqtt_client_publish(mqtt.client, MQTT_CONNECT, CONFIG_APPLICATION_CONNECT_PUBLISHING_MESSAGE, 0, 0, 0);
+			msg_id = esp_mqtt_client_publish(mqtt.client, MQTT_CONNECT, CONFIG_APPLICATION_CONNECT_PUBLISHING_MESSAGE, 0, 0, 0);
+			BITEC_TRACE(TAG, TRACE_APP_PUBLISH_CONNECT, msg_id, 0, "Published to %s, msg_id=%d", MQTT_CONNECT, msg_id);
 
 			/* Subscribe to user defined topics */
 #ifdef CONFIG_APPLICATION_USER_DEFINED_SUBSCRIPTION_1_ENABLE
-			ESP_LOGI(TAG, "Subscribing to %s", MQTT_SUBSCRIBE_1);
-			esp_mqtt_client_subscribe(mqtt.client, MQTT_SUBSCRIBE_1, 0);
+			msg_id = esp_mqtt_client_subscribe(mqtt.client, MQTT_SUBSCRIBE_1, 1);
+			BITEC_TRACE(TAG, TRACE_APP_SUBSCRIBE, 1, msg_id, "Subscribed to %s, msg_id=%d", MQTT_SUBSCRIBE_1, msg_id);
 #endif
 
 #ifdef CONFIG_APPLICATION_USER_DEFINED_SUBSCRIPTION_2_ENABLE
-			ESP_LOGI(TAG, "Subscribing to %s", MQTT_SUBSCRIBE_2);
-			esp_mqtt_client_subscribe(event->client, MQTT_SUBSCRIBE_2, 0);
+			msg_id = esp_mqtt_client_subscribe(mqtt.client, MQTT_SUBSCRIBE_2, 0);
+			BITEC_TRACE(TAG, TRACE_APP_SUBSCRIBE, 2, msg_id, "Subscribed to %s, msg_id=%d", MQTT_SUBSCRIBE_2, msg_id);
+#endif
+
+			/* Subscribe to the rules of the device */
+			msg_id = esp_mqtt_client_subscribe(mqtt.client, MQTT_RULES, 1);
+			BITEC_TRACE(TAG, TRACE_APP_SUBSCRIBE, 0, msg_id, "Subscribed to %s, msg_id=%d", MQTT_RULES, msg_id);
+
+			/* Subscribe to the settings of the device and publish the ones in use */
+			msg_id = esp_mqtt_client_subscribe(mqtt.client, MQTT_SETTINGS_SET, 1);
+			BITEC_TRACE(TAG, TRACE_APP_SUBSCRIBE, 0, msg_id, "Subscribed to %s, msg_id=%d", MQTT_SETTINGS_SET, msg_id);
+			settings_publish();
+
+			/* Subscribe to the power meter calibrations */
+			msg_id = esp_mqtt_client_subscribe(mqtt.client, MQTT_CALIBRATE, 1);
+			BITEC_TRACE(TAG, TRACE_APP_SUBSCRIBE, 0, msg_id, "Subscribed to %s, msg_id=%d", MQTT_CALIBRATE, msg_id);
+
+			/* Subscribe to the queries of the recent readings */
+			msg_id = esp_mqtt_client_subscribe(mqtt.client, MQTT_SERIES_QUERY, 1);
+			BITEC_TRACE(TAG, TRACE_APP_SUBSCRIBE, 0, msg_id, "Subscribed to %s, msg_id=%d", MQTT_SERIES_QUERY, msg_id);
+
+#ifdef CONFIG_APPLICATION_DRIFT_COMPENSATION
+			/* Subscribe to the drift curve of the device */
+			msg_id = esp_mqtt_client_subscribe(mqtt.client, MQTT_DRIFT, 1);
+			BITEC_TRACE(TAG, TRACE_APP_SUBSCRIBE, 0, msg_id, "Subscribed to %s, msg_id=%d", MQTT_DRIFT, msg_id);
 #endif
 
 			/* Create task to publish the electrical parameters of the devices */
@@ -407,9 +931,9 @@ static void mqtt_events_task(void * arg)
 
 		}
 
-		else if(bits & MQTT_EVENT_DISCONNECTED_BIT)
+		if(bits & MQTT_EVENT_DISCONNECTED_BIT)
 		{
-			ESP_LOGI(TAG, "MQTT_EVENT_DISCONNECTED_BIT set!");
+			BITEC_TRACE(TAG, TRACE_APP_MQTT_DISCONNECTED, 0, 0, "MQTT_EVENT_DISCONNECTED_BIT set!");
 
 			/* Delete task to publish the electrical parameters of the device */
 			if(send_data_handle != NULL)
@@ -419,86 +943,732 @@ static void mqtt_events_task(void * arg)
 			}
 		}
 
-		else if(bits & MQTT_EVENT_DATA_BIT)
+		if(bits & MQTT_EVENT_DATA_BIT)
 		{
-			ESP_LOGI(TAG, "MQTT_EVENT_DATA_BIT set!");
+			bitec_mqtt_message_t received;
 
-			/* Print MQTT incoming messages */
-			ESP_LOGI(TAG, "topic=%.*s\r", mqtt.event_data->topic_len, mqtt.event_data->topic);
-			ESP_LOGI(TAG, "data=%.*s\r\n", mqtt.event_data->data_len, mqtt.event_data->data);
+			/* Every message queued since, they are copies of the client buffer */
+			while(bitec_mqtt_receive(&mqtt, &received))
+			{
+				/* Print MQTT incoming messages */
+				BITEC_TRACE(TAG, TRACE_APP_MQTT_DATA, strlen(received.topic), received.data_len, "MQTT_EVENT_DATA_BIT set!, topic=%s, data=%.*s",
+						received.topic, received.data_len, received.data);
 
-			char * string = NULL;
-			string = malloc(sizeof(char) * UUID_SIZE * 2);
+				/* Rules programs are binary and fit in one message */
+				if(!strcmp(received.topic, MQTT_RULES))
+					rules_receive(received.data, received.data_len);
 
-			if(string != NULL)
-			{
-				sprintf(string, "%.*s", mqtt.event_data->topic_len, mqtt.event_data->topic);
+				if(!strcmp(received.topic, MQTT_SETTINGS_SET))
+					settings_receive(received.data, received.data_len);
 
-#ifdef CONFIG_APPLICATION_USER_DEFINED_SUBSCRIPTION_1_ENABLE
-				if(!strcmp(string, MQTT_SUBSCRIBE_1))
-				{
-					/* Parse incoming json message */
-					sprintf(string, "%.*s", mqtt.event_data->data_len, mqtt.event_data->data);
-//					cJSON * root = cJSON_Parse(string);
+				if(!strcmp(received.topic, MQTT_CALIBRATE))
+					calibration_receive(received.data, received.data_len);
 
-					/* Value obtained of MQTT message */
-//					int json_val = cJSON_GetObjectItem(root, "state")->valueint;
+				if(!strcmp(received.topic, MQTT_SERIES_QUERY))
+					series_receive(received.data, received.data_len);
 
-					/* Reply incoming json message to broker*/
-					ESP_LOGI(TAG, "Publising to %s", MQTT_DEVICE_STATUS);
-					esp_mqtt_client_publish(mqtt.client, MQTT_DEVICE_STATUS, string, 0, 0, 0);
-				}
+#ifdef CONFIG_APPLICATION_DRIFT_COMPENSATION
+				if(!strcmp(received.topic, MQTT_DRIFT))
+					drift_receive(received.data, received.data_len);
 #endif
 
-				free(string);
-			}
+#ifdef CONFIG_APPLICATION_USER_DEFINED_SUBSCRIPTION_1_ENABLE
+				/* Firmware rollout descriptors */
+				if(!strcmp(received.topic, MQTT_SUBSCRIBE_1))
+					rollout_receive(received.data, received.data_len);
+#endif
 
+				bitec_mqtt_message_free(&received);
+			}
 		}
-		else
-			ESP_LOGI(TAG, "MQTT unexpected Event");
 	}
 }
 
 static void button_events_task(void * arg)
 {
-	EventBits_t bits;
+	bitec_button_event_t event;
 
 	for(;;)
 	{
-		/* Wait until some bit is set */
-		bits = xEventGroupWaitBits(button.event_group, BUTTON_SHORT_PRESS_BIT| BUTTON_MEDIUM_PRESS_BIT | BUTTON_LONG_PRESS_BIT, pdTRUE, pdFALSE, portMAX_DELAY);
+		/* Wait until some event is received */
+		xQueueReceive(button.queue, &event, portMAX_DELAY);
+
+		switch(event.type)
+		{
+			case BITEC_BUTTON_CLICK:
+				ESP_LOGI(TAG, "Button click");
+
+#ifdef CONFIG_BITEC_TRACE_ENABLE
+				/* Dump trace ring to be decoded with trace_decode.py */
+				bitec_trace_dump();
+#endif
+				break;
+
+			case BITEC_BUTTON_DOUBLE_CLICK:
+				ESP_LOGI(TAG, "Button double click");
+
+				/* Measure the relay actuation times for the zero crossing switching */
+				if(bitec_relay_calibrate(&relay, RELAY_CALIBRATE_CYCLES) != ESP_OK)
+					ESP_LOGW(TAG, "Unable to calibrate the relay");
+
+				/* Then the power meter, with the reference load plugged */
+				calibration_start(CALIBRATION_VOLTAGE, CALIBRATION_CURRENT, CALIBRATION_POWER);
+
+				break;
 
-		if(bits & BUTTON_SHORT_PRESS_BIT)
-			ESP_LOGI(TAG, "BUTTON_SHORT_PRESS_BIT set!");
+			case BITEC_BUTTON_HOLD:
+			case BITEC_BUTTON_HOLD_REPEAT:
+				/* Progress of the press towards the Wi-Fi credentials erase */
+				if(event.duration < BUTTON_MEDIUM_TIME)
+					ESP_LOGI(TAG, "Button held %" PRIu32 " ms, release after %d ms to erase Wi-Fi credentials", event.duration, BUTTON_MEDIUM_TIME);
+				else if(event.duration < BUTTON_LONG_TIME)
+					ESP_LOGI(TAG, "Button held %" PRIu32 " ms, release now to erase Wi-Fi credentials", event.duration);
 
-		else if(bits & BUTTON_MEDIUM_PRESS_BIT)
+				break;
+
+			case BITEC_BUTTON_RELEASE:
+				if(event.duration >= BUTTON_LONG_TIME)
+				{
+					ESP_LOGI(TAG, "Button long press");
+
+					/* Update the firmware, the device restarts into it once verified */
+					if(ota_handle == NULL)
+						xTaskCreate(ota_task, "OTA Task", configMINIMAL_STACK_SIZE * 4, NULL, tskIDLE_PRIORITY + 1, &ota_handle);
+				}
+				else if(event.duration >= BUTTON_MEDIUM_TIME)
+				{
+					ESP_LOGI(TAG, "Button medium press");
+
+					/* Erase any stored Wi-Fi credential  */
+					ESP_LOGI(TAG, "Erasing Wi-Fi credentials");
+
+					esp_err_t ret;
+
+					hal_nvs_handle_t nvs_handle;
+					ret = hal_nvs_open(NULL, "nvs.net80211", true, &nvs_handle);
+
+					if(ret == ESP_OK)
+					{
+						hal_nvs_erase_all(nvs_handle);
+
+						/* Close NVS */
+						ret = hal_nvs_commit(nvs_handle);
+						hal_nvs_close(nvs_handle);
+					}
+
+					if(ret == ESP_OK)
+						/* Restart device */
+						restart();
+				}
+
+				break;
+
+			default:
+				break;
+		}
+	}
+}
+
+#ifdef CONFIG_APPLICATION_METRICS_PUBLISHING_ENABLE
+/* Add the object printed by print as name to a metrics object of len bytes. Returns its new length or -1 */
+static int metrics_add(char * buf, int len, size_t size, const char * name, int (* print)(char * buf, size_t size))
+{
+	int ret;
+
+	/* In place of the closing brace */
+	len--;
+	ret = snprintf(buf + len, size - len, ",\"%s\":", name);
+
+	if(ret < 0 || (size_t)ret >= size - len)
+		return -1;
+
+	len += ret;
+	ret = print(buf + len, size - len);
+
+	if(ret < 0)
+		return -1;
+
+	len += ret;
+	ret = snprintf(buf + len, size - len, "}");
+
+	if(ret < 0 || (size_t)ret >= size - len)
+		return -1;
+
+	return len + ret;
+}
+
+/* Relay switching metrics */
+static int metrics_print_relay(char * buf, size_t size)
+{
+	return bitec_relay_print(&relay, buf, size);
+}
+
+/* Anomalies seen on the power readings */
+static int metrics_print_monitor(char * buf, size_t size)
+{
+	return bitec_monitor_print(&monitor, buf, size);
+}
+
+/* Firmware update state and the throughput and heap of the last one */
+static int metrics_print_ota(char * buf, size_t size)
+{
+	return bitec_ota_print(&ota, buf, size);
+}
+
+/* Energy registers, records waiting to be published and clock jumps */
+static int metrics_print_energy(char * buf, size_t size)
+{
+	xSemaphoreTake(energy_mutex, portMAX_DELAY);
+	int len = bitec_energy_print_metrics(&energy, buf, size);
+	xSemaphoreGive(energy_mutex);
+
+	return len;
+}
+
+/* Recent readings stored, their compression and flash writes */
+static int metrics_print_series(char * buf, size_t size)
+{
+	xSemaphoreTake(series_mutex, portMAX_DELAY);
+	int len = bitec_series_print_metrics(&series, buf, size);
+	xSemaphoreGive(series_mutex);
+
+	return len;
+}
+
+/* SNTP syncs, the drift of the uptime and the offset of the last sync */
+static int metrics_print_clock(char * buf, size_t size)
+{
+	xSemaphoreTake(clock_mutex, portMAX_DELAY);
+	int len = bitec_clock_print_metrics(&sntp_clock, hal_time_us(), buf, size);
+	xSemaphoreGive(clock_mutex);
+
+	return len;
+}
+
+#ifdef CONFIG_APPLICATION_DRIFT_COMPENSATION
+/* Chip temperature and the corrections in use */
+static int metrics_print_drift(char * buf, size_t size)
+{
+	return bl0937_drift_print(&drift, buf, size);
+}
+#endif
+#endif
+
+/* Evaluate the rules and act on their outputs */
+static void rules_apply(void)
+{
+	static bool led = false;
+	static uint8_t color[3];
+	bitec_rules_output_t output;
+	int32_t vars[RULES_VAR_MAX];
+	int64_t now = clock_ms();
+	time_t seconds = now / 1000;
+	struct tm timeinfo;
+
+	/* Time of the day is unknown until the clock is synced */
+	localtime_r(&seconds, &timeinfo);
+
+	vars[RULES_VAR_ILLUMINATION] = message.payload.illumination;
+	vars[RULES_VAR_PRESENCE] = message.payload.presence;
+	vars[RULES_VAR_POWER] = sample.power;
+	vars[RULES_VAR_VOLTAGE] = sample.voltage;
+	vars[RULES_VAR_CURRENT] = sample.current;
+	vars[RULES_VAR_MINUTE] = now < 0 ? -1 : timeinfo.tm_hour * 60 + timeinfo.tm_min;
+	vars[RULES_VAR_LIGHT] = bitec_relay_get_state(&relay);
+
+	xSemaphoreTake(rules_mutex, portMAX_DELAY);
+	bitec_rules_eval(&rules, vars, &output);
+	xSemaphoreGive(rules_mutex);
+
+	/* Without a rule on the relay it follows presence and illumination, a calibration needs the load */
+	bitec_relay_set_force(&relay, calibrating ? 1 : output.relay);
+
+	/* Only a new color is posted, the animations queue is short */
+	if(output.led && (!led || color[0] != output.red || color[1] != output.green || color[2] != output.blue))
+	{
+		ws2812_anim_t anim = WS2812_ANIM_DEFAULT(WS2812_ANIM_SOLID, output.red, output.green, output.blue, 0);
+
+		if(ws2812_anim_post(&anim, LED_POST_TIME) == ESP_OK)
+		{
+			color[0] = output.red;
+			color[1] = output.green;
+			color[2] = output.blue;
+		}
+	}
+
+	led = output.led;
+
+	/* Raised events */
+	for(int i = 0; output.publish != 0; i++, output.publish >>= 1)
+	{
+		if(output.publish & 1)
 		{
-			ESP_LOGI(TAG, "BUTTON_MEDIUM_PRESS_BIT set!");
+			char event[EVENT_SIZE];
+			int len = snprintf(event, sizeof(event), "{\"rule_event\":%d}", i);
+			int msg_id = esp_mqtt_client_publish(mqtt.client, MQTT_EVENTS, event, len, 1, 0);
+
+			BITEC_TRACE(TAG, TRACE_APP_PUBLISH_RULE_EVENT, i, msg_id, "Rule event %d published to %s, msg_id=%d", i, MQTT_EVENTS, msg_id);
+		}
+	}
+}
+
+/* Load and store a rules program, an empty one erases the stored program */
+static void rules_receive(const char * data, int len)
+{
+	esp_err_t ret = ESP_OK;
+
+	xSemaphoreTake(rules_mutex, portMAX_DELAY);
+
+	if(len == 0)
+		bitec_rules_clear(&rules);
+	else
+		ret = bitec_rules_load(&rules, (const uint8_t *)data, len);
+
+	if(ret == ESP_OK)
+		ret = bitec_rules_save(&rules);
+
+	xSemaphoreGive(rules_mutex);
+
+	if(ret != ESP_OK)
+		ESP_LOGW(TAG, "Rules program rejected: %s", esp_err_to_name(ret));
+}
+
+/* Copy the settings of the relay and the monitor, they apply from their next reading */
+static void settings_apply(void)
+{
+	relay.logic.dark_level = bitec_settings_get(&settings, SETTING_DARK_LEVEL);
+	relay.logic.bright_level = bitec_settings_get(&settings, SETTING_BRIGHT_LEVEL);
+	relay.logic.hold_time = bitec_settings_get(&settings, SETTING_HOLD_TIME);
+	monitor.max_current = bitec_settings_get(&settings, SETTING_MAX_CURRENT);
+	monitor.max_power = bitec_settings_get(&settings, SETTING_MAX_POWER);
+	monitor.sag_voltage = bitec_settings_get(&settings, SETTING_SAG_VOLTAGE);
+	monitor.swell_voltage = bitec_settings_get(&settings, SETTING_SWELL_VOLTAGE);
+}
+
+/* Set the values of a settings message with a single commit, an empty message only asks for them */
+static void settings_receive(const char * data, int len)
+{
+	esp_err_t ret = ESP_OK;
+
+	if(len > 0)
+		ret = bitec_settings_parse(&settings, data, len);
+
+	if(ret == ESP_OK && settings.dirty != 0)
+		ret = bitec_settings_commit(&settings);
+
+	if(ret != ESP_OK)
+		ESP_LOGW(TAG, "Settings rejected: %s", esp_err_to_name(ret));
+
+	settings_apply();
+	settings_publish();
+
+	/* The id and the BL0937 resistors are only read at start */
+	if(settings.restart != 0)
+	{
+		ESP_LOGI(TAG, "Restarting to apply the settings");
+		vTaskDelay(pdMS_TO_TICKS(SETTINGS_RESTART_TIME));
+		restart();
+	}
+}
+
+/* Publish the settings in use, retained so they can be read while the device is offline */
+static void settings_publish(void)
+{
+	char string[SETTINGS_SIZE];
+	int len = bitec_settings_print(&settings, string, sizeof(string));
+
+	if(len < 0)
+		return;
+
+	int msg_id = esp_mqtt_client_publish(mqtt.client, MQTT_SETTINGS, string, len, 1, 1);
+
+	BITEC_TRACE(TAG, TRACE_APP_PUBLISH_SETTINGS, len, msg_id, "Settings published to %s, msg_id=%d", MQTT_SETTINGS, msg_id);
+}
+
+/* Switch the reference load on and calibrate the power meter from the next readings. A power of 0 is
+ * taken as a resistive load */
+static void calibration_start(float voltage, float current, float power)
+{
+	if(calibrating)
+	{
+		ESP_LOGW(TAG, "Calibration already running");
+		return;
+	}
+
+	if(power == 0)
+		power = voltage * current;
+
+	bl0937_calibration_start(&calibration, voltage, current, power);
+	bitec_relay_set_force(&relay, 1);
+	calibrating = true;
+
+	ESP_LOGI(TAG, "Calibrating against %.1f V, %.3f A and %.1f W", voltage, current, power);
+}
+
+/* Take a calibration message: the reference load as {"voltage":V,"current":A,"power":W}, power
+ * optional for a resistive load, {"erase":true} to go back to the nominal multipliers and an empty
+ * message for the Kconfig reference load */
+static void calibration_receive(const char * data, int len)
+{
+	if(len == 0)
+	{
+		calibration_start(CALIBRATION_VOLTAGE, CALIBRATION_CURRENT, CALIBRATION_POWER);
+		return;
+	}
+
+	cJSON * root = cJSON_ParseWithLength(data, len);
+	const cJSON * voltage = cJSON_GetObjectItem(root, "voltage");
+	const cJSON * current = cJSON_GetObjectItem(root, "current");
+	const cJSON * power = cJSON_GetObjectItem(root, "power");
+
+	if(cJSON_IsTrue(cJSON_GetObjectItem(root, "erase")))
+	{
+#ifdef CONFIG_APPLICATION_DRIFT_COMPENSATION
+		xSemaphoreTake(drift_mutex, portMAX_DELAY);
+#endif
+
+		esp_err_t ret = bl0937_calibration_erase(&bl0937);
+
+#ifdef CONFIG_APPLICATION_DRIFT_COMPENSATION
+		drift_rebase(false);
+		xSemaphoreGive(drift_mutex);
+#endif
+
+		ESP_LOGI(TAG, "Calibration erased: %s", esp_err_to_name(ret));
+	}
+	else if(cJSON_IsNumber(voltage) && voltage->valuedouble > 0 && cJSON_IsNumber(current) && current->valuedouble > 0 &&
+			(power == NULL || (cJSON_IsNumber(power) && power->valuedouble > 0)))
+		calibration_start(voltage->valuedouble, current->valuedouble, power == NULL ? 0 : power->valuedouble);
+	else
+		ESP_LOGW(TAG, "Calibration message rejected");
+
+	cJSON_Delete(root);
+}
+
+/* Apply and store the multipliers of a calibration that reached its precision, and publish its result */
+static void calibration_end(void)
+{
+	esp_err_t ret = calibration.error;
 
-			/* Erase any stored Wi-Fi credential  */
-			ESP_LOGI(TAG, "Erasing Wi-Fi credentials");
+#ifdef CONFIG_APPLICATION_DRIFT_COMPENSATION
+	xSemaphoreTake(drift_mutex, portMAX_DELAY);
+#endif
+
+	if(ret == ESP_OK)
+		ret = bl0937_calibration_apply(&bl0937, &calibration);
+
+#ifdef CONFIG_APPLICATION_DRIFT_COMPENSATION
+	/* The multipliers hold at the temperature they were calibrated at */
+	if(ret == ESP_OK)
+		drift_rebase(true);
+
+	xSemaphoreGive(drift_mutex);
+#endif
+
+	if(ret == ESP_OK)
+		ret = bl0937_calibration_save(&bl0937);
+
+	calibration.error = ret;
+	calibrating = false;
+
+	char result[CALIBRATION_SIZE];
+	int len = bl0937_calibration_print(&bl0937, &calibration, result, sizeof(result));
+
+	if(len < 0)
+		return;
+
+	int msg_id = esp_mqtt_client_publish(mqtt.client, MQTT_EVENTS, result, len, 1, 0);
+
+	BITEC_TRACE(TAG, TRACE_APP_PUBLISH_CALIBRATION, ret, msg_id, "Calibration %s published to %s, msg_id=%d", esp_err_to_name(ret), MQTT_EVENTS,
+			msg_id);
+}
+
+#ifdef CONFIG_APPLICATION_DRIFT_COMPENSATION
+/* Take a sample of the chip temperature, the multipliers are corrected if it moved enough */
+static void drift_sample(void)
+{
+	float celsius;
+
+	if(hal_temp_read(&celsius) != ESP_OK)
+		return;
+
+	xSemaphoreTake(drift_mutex, portMAX_DELAY);
+
+	if(bl0937_drift_update(&bl0937, &drift, celsius))
+		ESP_LOGD(TAG, "Multipliers corrected for %.1f C", drift.applied);
+
+	xSemaphoreGive(drift_mutex);
+}
+
+/* Take the multipliers set otherwise as the base of the corrections, calibrated ones at the average
+ * temperature. Called with drift_mutex held */
+static void drift_rebase(bool calibrated)
+{
+	if(calibrated)
+		bl0937.temperature = drift.temperature;
+
+	bl0937_drift_rebase(&bl0937, &drift);
+}
+
+/* Take and store a drift curve, an empty message removes it */
+static void drift_receive(const char * data, int len)
+{
+	esp_err_t ret = ESP_OK;
+
+	xSemaphoreTake(drift_mutex, portMAX_DELAY);
+
+	if(len == 0)
+		bl0937_drift_clear(&drift);
+	else
+		ret = bl0937_drift_parse(&drift, data, len);
 
-			esp_err_t ret;
+	if(ret == ESP_OK)
+		ret = bl0937_drift_save(&drift);
 
-			nvs_handle_t nvs_handle;
-			ret = nvs_open("nvs.net80211", NVS_READWRITE, &nvs_handle);
+	xSemaphoreGive(drift_mutex);
 
-			if(ret == ESP_OK)
-				nvs_erase_all(nvs_handle);
+	if(ret != ESP_OK)
+		ESP_LOGW(TAG, "Drift curve rejected: %s", esp_err_to_name(ret));
+	else
+		ESP_LOGI(TAG, "Drift curve of %u points", drift.points);
+}
+#endif
+
+/* Take a rollout descriptor and schedule its update, a new one replaces the one waiting */
+static void rollout_receive(const char * data, int len)
+{
+	/* Held while downloading, the descriptor is not taken then */
+	if(xSemaphoreTake(rollout_mutex, 0) != pdTRUE)
+	{
+		ESP_LOGW(TAG, "Rollout descriptor ignored, an update is running");
+		return;
+	}
+
+	esp_err_t ret = bitec_ota_rollout_parse(&rollout, data, len);
+
+	if(ret == ESP_OK)
+	{
+		bitec_ota_rollout_schedule(&rollout, message.device, hal_ota_running_version(), clock_ms());
+
+		if(rollout_handle != NULL)
+			xTaskNotifyGive(rollout_handle);
+		else if(rollout.state == BITEC_OTA_ROLLOUT_SCHEDULED)
+			xTaskCreate(rollout_task, "Rollout Task", configMINIMAL_STACK_SIZE * 4, NULL, tskIDLE_PRIORITY + 1, &rollout_handle);
+	}
+
+	xSemaphoreGive(rollout_mutex);
+
+	/* The same descriptor again is not an error, retained ones come on every connection */
+	if(ret == ESP_ERR_INVALID_ARG)
+		ESP_LOGW(TAG, "Rollout descriptor rejected: %s", esp_err_to_name(ret));
+}
+
+/* An update ends in a restart that switches the load off, and flash is not written while the supply is
+ * out of its limits */
+static bool rollout_ready(void)
+{
+	return !bitec_relay_get_state(&relay) && monitor.active == 0;
+}
+
+/* Publish the state of the rollout and its download progress */
+static void rollout_report(const bitec_ota_rollout_t * const me, void * arg)
+{
+	char report[ROLLOUT_SIZE];
+	int len = bitec_ota_rollout_print(me, report, sizeof(report));
+
+	if(len < 0)
+		return;
 
-			/* Close NVS */
-			ret = nvs_commit(nvs_handle);
-			nvs_close(nvs_handle);
+	int msg_id = esp_mqtt_client_publish(mqtt.client, MQTT_ROLLOUT, report, len, 1, 0);
+
+	BITEC_TRACE(TAG, TRACE_APP_PUBLISH_ROLLOUT, me->state, msg_id, "Rollout %s published to %s, msg_id=%d", bitec_ota_rollout_name(me->state),
+			MQTT_ROLLOUT, msg_id);
+}
+
+/* Unix time in ms, -1 until the clock is synced */
+static int64_t clock_ms(void)
+{
+	return clock_at(hal_time_us());
+}
+
+/* Unix time in ms of an uptime of hal_time_us(), as the BL0937 pulses are stamped. -1 until synced */
+static int64_t clock_at(int64_t uptime)
+{
+	xSemaphoreTake(clock_mutex, portMAX_DELAY);
+	int64_t time = bitec_clock_time(&sntp_clock, uptime);
+	xSemaphoreGive(clock_mutex);
 
-			if(ret == ESP_OK)
-				/* Restart device */
-				esp_restart();
+	return time;
+}
+
+/* Take an SNTP sync, the system time was set to it too */
+static void clock_sync(int64_t uptime, int64_t time)
+{
+	xSemaphoreTake(clock_mutex, portMAX_DELAY);
+	bitec_clock_sync(&sntp_clock, uptime, time);
+	int64_t offset = sntp_clock.offset;
+	xSemaphoreGive(clock_mutex);
+
+	ESP_LOGI(TAG, "Clock synced, offset %" PRId64 " us", offset);
+}
+
+/* Publish an anomaly with the reading that raised it and its time, null while not known */
+static void alarm_publish(bitec_monitor_anomaly_e anomaly, int64_t uptime)
+{
+	char alarm[EVENT_SIZE];
+	char time[24] = "null";
+	int64_t now = clock_at(uptime);
+
+	if(now >= 0)
+		snprintf(time, sizeof(time), "%" PRId64, now);
+
+	int len = snprintf(alarm, sizeof(alarm), "{\"alarm\":\"%s\",\"time\":%s,\"voltage\":%u,\"current\":%" PRIu32 ",\"power\":%" PRIu32 "}",
+			bitec_monitor_name(anomaly), time, sample.voltage, sample.current, sample.power);
+	int msg_id = esp_mqtt_client_publish(mqtt.client, MQTT_EVENTS, alarm, len, 1, 0);
+
+	BITEC_TRACE_W(TAG, TRACE_APP_PUBLISH_ALARM, anomaly, msg_id, "Alarm %s published to %s, msg_id=%d", bitec_monitor_name(anomaly), MQTT_EVENTS,
+			msg_id);
+}
+
+/* Add the energy of CF pulses to the registers, at the uptime they were counted */
+static void energy_add(uint32_t pulses, int64_t uptime)
+{
+	double mwh = pulses * (double)bl0937_get_power_multiplier(&bl0937) / 1e6 / 3.6;
+	int64_t time = clock_at(uptime);
+
+	xSemaphoreTake(energy_mutex, portMAX_DELAY);
+	bitec_energy_update(&energy, time, uptime, mwh);
+	xSemaphoreGive(energy_mutex);
+}
+
+/* Publish the records not published yet, they are kept until the broker takes them */
+static void energy_publish(void)
+{
+	for(int i = 0; i < ENERGY_BATCHES; i++)
+	{
+		bitec_energy_batch_t batch;
+		char * string = NULL;
+		int len = -1;
+
+		xSemaphoreTake(energy_mutex, portMAX_DELAY);
+
+		if(bitec_energy_unsent(&energy, ENERGY_QUARTER) + bitec_energy_unsent(&energy, ENERGY_HOUR) +
+				bitec_energy_unsent(&energy, ENERGY_DAY) > 0 && (string = malloc(ENERGY_SIZE)) != NULL)
+			len = bitec_energy_print(&energy, string, ENERGY_SIZE, &batch);
+
+		xSemaphoreGive(energy_mutex);
+
+		if(len < 0)
+		{
+			free(string);
+			return;
 		}
-		else if(bits & BUTTON_LONG_PRESS_BIT)
-			ESP_LOGI(TAG, "BUTTON_LONG_PRESS_BIT set!");
-		else
-			ESP_LOGI(TAG, "Button unexpected Event");
+
+		int msg_id = esp_mqtt_client_publish(mqtt.client, MQTT_ENERGY, string, len, 1, 0);
+
+		free(string);
+		BITEC_TRACE(TAG, TRACE_APP_PUBLISH_ENERGY, batch.counts[ENERGY_QUARTER] + batch.counts[ENERGY_HOUR] + batch.counts[ENERGY_DAY], msg_id,
+				"Energy records %u/%u/%u published to %s, msg_id=%d", batch.counts[ENERGY_QUARTER], batch.counts[ENERGY_HOUR],
+				batch.counts[ENERGY_DAY], MQTT_ENERGY, msg_id);
+
+		if(msg_id < 0)
+			return;
+
+		xSemaphoreTake(energy_mutex, portMAX_DELAY);
+		bitec_energy_sent(&energy, &batch);
+		xSemaphoreGive(energy_mutex);
 	}
 }
 
+/* Restart the device, the energy since the last save and the readings not in flash yet are kept */
+static void restart(void)
+{
+	xSemaphoreTake(series_mutex, portMAX_DELAY);
+	bitec_series_flush(&series);
+	xSemaphoreTake(energy_mutex, portMAX_DELAY);
+	bitec_energy_save(&energy);
+	hal_restart();
+}
+
+/* Add the readings of a sensors cycle to the recent ones at their time, once the clock is synced */
+static void series_sample(int64_t uptime)
+{
+	int64_t now = clock_at(uptime);
+	float values[SERIES_MAX] =
+	{
+		[SERIES_VOLTAGE] = message.payload.voltage,
+		[SERIES_CURRENT] = message.payload.current,
+		[SERIES_POWER] = message.payload.power,
+		[SERIES_ACTIVE] = message.payload.active,
+		[SERIES_POWER_FACTOR] = message.payload.power_factor,
+		[SERIES_ILLUMINATION] = message.payload.illumination,
+		[SERIES_LIGHT] = message.payload.light,
+		[SERIES_PRESENCE] = message.payload.presence,
+	};
+
+	if(now < 0)
+		return;
+
+	xSemaphoreTake(series_mutex, portMAX_DELAY);
+	bitec_series_add(&series, now, values);
+	xSemaphoreGive(series_mutex);
+}
+
+/* Publish a page of the recent readings of a query, every field is optional */
+static void series_receive(const char * data, int len)
+{
+	int64_t now = clock_ms();
+	int64_t from = 0;
+	int64_t to = (now >= 0) ? now : INT64_MAX;
+	int64_t next;
+	int limit = SERIES_PAGE_LIMIT;
+
+	if(len > 0)
+	{
+		cJSON * root = cJSON_ParseWithLength(data, len);
+		const cJSON * item;
+
+		if(cJSON_IsNumber(item = cJSON_GetObjectItem(root, "from")))
+			from = item->valuedouble;
+
+		if(cJSON_IsNumber(item = cJSON_GetObjectItem(root, "to")))
+			to = item->valuedouble;
+
+		if(cJSON_IsNumber(item = cJSON_GetObjectItem(root, "limit")) && item->valueint > 0 && item->valueint <= SERIES_PAGE_LIMIT)
+			limit = item->valueint;
+
+		cJSON_Delete(root);
+	}
+
+	char * page = malloc(SERIES_PAGE_SIZE);
+	char empty[SERIES_EMPTY_SIZE];
+	const char * out = page;
+	int page_len = -1;
+
+	/* No reading matching the query is an empty page with no next one */
+	if(page != NULL)
+	{
+		xSemaphoreTake(series_mutex, portMAX_DELAY);
+		page_len = bitec_series_print(&series, from, to, limit, page, SERIES_PAGE_SIZE, &next);
+		xSemaphoreGive(series_mutex);
+	}
+
+	/* Out of memory, an empty page sending the client to the same query again rather than leaving it
+	 * waiting for an answer */
+	if(page_len < 0)
+	{
+		next = from;
+		out = empty;
+		page_len = snprintf(empty, sizeof(empty), "{\"from\":%" PRId64 ",\"to\":%" PRId64 ",\"samples\":[],\"next\":%" PRId64 "}",
+				from, to, next);
+	}
+
+	int msg_id = esp_mqtt_client_publish(mqtt.client, MQTT_SERIES, out, page_len, 1, 0);
+
+	BITEC_TRACE(TAG, TRACE_APP_PUBLISH_SERIES, page_len, msg_id, "Series page from %" PRId64 " published to %s, next %" PRId64 ", msg_id=%d", from,
+			MQTT_SERIES, next, msg_id);
+
+	free(page);
+}
+
 /* end of file ---------------------------------------------------------------*/
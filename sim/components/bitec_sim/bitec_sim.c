@@ -0,0 +1,590 @@
+/*
+ * bitec_sim.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ *
+ * Deterministic simulator of the firmware. app_main() and every task it
+ * creates run unchanged on the virtual time kernel, fed by a load profile:
+ * BL0937 pulse trains, PIR and light sensor inputs, bouncing button presses, mains
+ * zero crossings, relay contacts, the chip temperature, a broker stand-in that
+ * acknowledges publishes after a set latency and an SNTP server stand-in.
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "mqtt_client.h"
+
+#include "bitec_hal_linux.h"
+#include "bitec_latency.h"
+#include "sim_kernel.h"
+#include "sim_profile.h"
+#include "sim_bl0937.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define DEFAULT_DURATION	"1d"		/*!< Simulated time when -d is not given */
+#define DEFAULT_LATENCY		50			/*!< Broker acknowledge latency in ms */
+#define MAIN_TASK_STACK		3584		/*!< Stack of the task running app_main() */
+#define MAIN_TASK_PRIORITY	1			/*!< Priority of the task running app_main() */
+#define TOPICS_MAX			16			/*!< Number of topics with statistics */
+#define TOPIC_SIZE			128			/*!< Maximum topic size in bytes */
+#define BOUNCE_EDGES		8			/*!< Extra edges of a bouncing contact, even to end at the new level */
+#define DEVICE_ID_TAG		"$ID"		/*!< Replaced by the device id in profile topics, such as updates/$ID */
+#define RELAY_OPERATE_TIME	7300		/*!< Relay GPIO set to contacts closed in us */
+#define RELAY_RELEASE_TIME	3100		/*!< Relay GPIO cleared to contacts open in us */
+#define SNTP_EPOCH			1792368000	/*!< Unix time of the SNTP server at the start, Oct 19, 2026 00:00 UTC */
+#define SNTP_DELAY			500000		/*!< From SNTP started to its first sync in us */
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef struct
+{
+	char topic[TOPIC_SIZE];
+	uint32_t count;
+	uint64_t bytes;
+	int64_t last;							/*!< Time of the last message */
+	bitec_latency_histogram_t interval;		/*!< Time between messages in ms */
+} topic_stats_t;
+
+typedef struct
+{
+	uint32_t transitions;
+	uint32_t level;
+	int64_t since;			/*!< Time of the last transition */
+	int64_t high_time;		/*!< Total time at high level */
+} pin_stats_t;
+
+typedef struct
+{
+	esp_mqtt_client_handle_t client;
+	int msg_id;
+	int64_t published;
+} ack_t;
+
+/* internal data declaration -------------------------------------------------*/
+
+static const char * TAG = "sim";
+
+static sim_bl0937_t bl0937;
+static sim_profile_t profile;
+static int64_t ack_latency = DEFAULT_LATENCY * 1000;
+static topic_stats_t topics[TOPICS_MAX];
+static size_t topics_num = 0;
+static pin_stats_t pins[HAL_GPIO_MAX];
+static bitec_latency_histogram_t acks;
+static char * last_metrics = NULL;
+static FILE * events_file = NULL;
+static int64_t bounce_time = 0;
+static int64_t mains_half_period = 0;
+static bool mains_running = false;
+static double load_current = 0;		/*!< Current of the load when the contacts are closed */
+static bool contacts = false;
+static bool welded = false;
+static int64_t sntp_interval = 0;	/*!< Poll period in us, 0 until SNTP is started */
+static int64_t sntp_base = SNTP_EPOCH * 1000000LL;	/*!< Unix time of the server at sntp_since in us */
+static int64_t sntp_since = 0;
+static double sntp_drift = 0;		/*!< Of the virtual time against the server in ppm */
+static bool sntp_reachable = true;
+static uint32_t sntp_syncs = 0;
+
+/* Edges of a bouncing contact, fractions of the bounce time recorded on a tactile switch.
+ * They come closer then spread out as the contact settles */
+static const double bounce_edges[BOUNCE_EDGES] = { 0.02, 0.05, 0.07, 0.12, 0.18, 0.33, 0.55, 1.0 };
+
+/* external data declaration -------------------------------------------------*/
+
+extern void app_main(void);
+
+/* internal functions declaration --------------------------------------------*/
+
+static void main_task(void * arg);
+static void clock_hook(int64_t now);
+static void gpio_hook(int pin, uint32_t level, void * arg);
+static void broker_sink(esp_mqtt_client_handle_t client, int msg_id, const char * topic, const char * data, int len, int qos, void * arg);
+static void ack_event(void * arg);
+static void apply_step(const sim_step_t * step, void * arg);
+static void button_edge(uint32_t level);
+static void button_release(void * arg);
+static void button_bounce(void * arg);
+static void mains_crossing(void * arg);
+static void relay_contacts(void * arg);
+static void load_update(void);
+static void timer_hook(int64_t due, void * arg);
+static void timer_event(void * arg);
+static void sntp_hook(uint32_t interval, void * arg);
+static void sntp_event(void * arg);
+static int64_t sntp_time(int64_t now);
+static topic_stats_t * topic_stats(const char * topic);
+static void report(int64_t duration, double wall_time);
+static void print_time(const char * prefix, int64_t time);
+static void usage(const char * name);
+
+/* external functions definition ---------------------------------------------*/
+
+int main(int argc, char * argv[])
+{
+	int64_t duration;
+	bool verbose = false;
+	int opt;
+
+	sim_profile_parse_time(DEFAULT_DURATION, &duration);
+
+	while((opt = getopt(argc, argv, "d:l:o:vh")) != -1)
+	{
+		switch(opt)
+		{
+			case 'd':
+				if(sim_profile_parse_time(optarg, &duration) != ESP_OK)
+				{
+					usage(argv[0]);
+					return EXIT_FAILURE;
+				}
+
+				break;
+
+			case 'l':
+				ack_latency = (int64_t)(atof(optarg) * 1000);
+				break;
+
+			case 'o':
+				events_file = fopen(optarg, "w");
+
+				if(events_file == NULL)
+				{
+					fprintf(stderr, "Unable to open %s\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				fprintf(events_file, "time_us,event,name,value\n");
+
+				break;
+
+			case 'v':
+				verbose = true;
+				break;
+
+			default:
+				usage(argv[0]);
+				return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+
+	/* Logs use the host clock and would slow a long run down */
+	esp_log_level_set("*", verbose ? ESP_LOG_INFO : ESP_LOG_WARN);
+
+	if(optind < argc && sim_profile_load(&profile, argv[optind]) != ESP_OK)
+		return EXIT_FAILURE;
+
+	/* Hardware and broker stand-ins */
+	hal_linux_reset();
+	hal_linux_gpio_set_hook(gpio_hook, NULL);
+	hal_linux_timer_set_hook(timer_hook, NULL);
+	hal_linux_sntp_set_hook(sntp_hook, NULL);
+	sim_bl0937_init(&bl0937, CONFIG_BL0937_CF_PIN, CONFIG_BL0937_CF1_PIN, CONFIG_BL0937_SEL_PIN);
+	esp_mqtt_loopback_set_sink(broker_sink, NULL);
+	esp_mqtt_loopback_set_manual_ack(true);
+
+	sim_kernel_init(clock_hook);
+	sim_profile_start(&profile, apply_step, NULL);
+
+	/* app_main() runs in a task, as on the ESP-IDF main task */
+	xTaskCreate(main_task, "main", MAIN_TASK_STACK, NULL, MAIN_TASK_PRIORITY, NULL);
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	sim_kernel_run(duration);
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	report(duration, (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+
+	if(events_file != NULL)
+		fclose(events_file);
+
+	sim_profile_free(&profile);
+	free(last_metrics);
+
+	return EXIT_SUCCESS;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static void main_task(void * arg)
+{
+	app_main();
+
+	vTaskDelete(NULL);
+}
+
+static void clock_hook(int64_t now)
+{
+	/* Pulses are only driven when the clock moves, a whole period between two task wake ups at once */
+	sim_bl0937_advance(&bl0937, now);
+	hal_linux_time_set(now);
+}
+
+static void gpio_hook(int pin, uint32_t level, void * arg)
+{
+	int64_t now = hal_time_us();
+	pin_stats_t * stats = &pins[pin];
+
+	if(stats->level)
+		stats->high_time += now - stats->since;
+
+	stats->level = level;
+	stats->since = now;
+	stats->transitions++;
+
+	if(pin == bl0937.sel_pin)
+	{
+		sim_bl0937_select(&bl0937);
+		return;
+	}
+
+	/* Load connected and load side feedback once the contacts moved */
+	if(pin == CONFIG_APPLICATION_RELAY_PIN)
+		sim_kernel_schedule(now + (level ? RELAY_OPERATE_TIME : RELAY_RELEASE_TIME), relay_contacts, (void *)(intptr_t)level);
+
+	if(events_file != NULL)
+		fprintf(events_file, "%" PRId64 ",gpio,%d,%" PRIu32 "\n", now, pin, level);
+}
+
+static void broker_sink(esp_mqtt_client_handle_t client, int msg_id, const char * topic, const char * data, int len, int qos, void * arg)
+{
+	int64_t now = sim_kernel_now();
+	topic_stats_t * stats = topic_stats(topic);
+
+	if(stats != NULL)
+	{
+		if(stats->count > 0)
+			bitec_latency_histogram_add(&stats->interval, (now - stats->last) / 1000);
+
+		stats->count++;
+		stats->bytes += len;
+		stats->last = now;
+	}
+
+	if(events_file != NULL)
+		fprintf(events_file, "%" PRId64 ",publish,%s,%d\n", now, topic, len);
+
+#ifdef CONFIG_APPLICATION_METRICS_PUBLISHING_ENABLE
+	/* Keep the last latency histograms of the firmware for the report */
+	if(!strncmp(topic, CONFIG_APPLICATION_METRICS_PUBLISHING_TOPIC, strlen(CONFIG_APPLICATION_METRICS_PUBLISHING_TOPIC)))
+	{
+		free(last_metrics);
+		last_metrics = strndup(data, len);
+	}
+#endif
+
+	if(qos == 0)
+		return;
+
+	ack_t * ack = malloc(sizeof(ack_t));
+
+	if(ack == NULL)
+		return;
+
+	ack->client = client;
+	ack->msg_id = msg_id;
+	ack->published = now;
+
+	sim_kernel_schedule(now + ack_latency, ack_event, ack);
+}
+
+static void ack_event(void * arg)
+{
+	ack_t * ack = (ack_t *)arg;
+
+	if(esp_mqtt_loopback_ack(ack->client, ack->msg_id) == ESP_OK)
+		bitec_latency_histogram_add(&acks, sim_kernel_now() - ack->published);
+
+	free(ack);
+}
+
+static void apply_step(const sim_step_t * step, void * arg)
+{
+	int64_t now = sim_kernel_now();
+
+	switch(step->input)
+	{
+		case SIM_INPUT_VOLTAGE:
+			sim_bl0937_set_load(&bl0937, step->value, bl0937.current, bl0937.pf);
+			break;
+
+		case SIM_INPUT_CURRENT:
+			load_current = step->value;
+			load_update();
+			break;
+
+		case SIM_INPUT_WELD:
+			welded = step->value != 0;
+			load_update();
+			break;
+
+		case SIM_INPUT_PF:
+			sim_bl0937_set_load(&bl0937, bl0937.voltage, bl0937.current, step->value);
+			break;
+
+		case SIM_INPUT_LIGHT:
+			hal_linux_adc_set(CONFIG_APPLICATION_LDR_CHANNEL, (int)step->value);
+			break;
+
+		case SIM_INPUT_PRESENCE:
+			hal_linux_gpio_drive(CONFIG_APPLICATION_PIR_PIN, step->value != 0);
+			break;
+
+		case SIM_INPUT_BUTTON:
+			/* Active low button with pull up */
+			button_edge(0);
+			sim_kernel_schedule(now + (int64_t)(step->value * 1000), button_release, NULL);
+			break;
+
+		case SIM_INPUT_BOUNCE:
+			bounce_time = (int64_t)(step->value * 1000);
+			break;
+
+		case SIM_INPUT_MAINS:
+			mains_half_period = step->value > 0 ? (int64_t)(500000 / step->value) : 0;
+
+			if(mains_half_period > 0 && !mains_running)
+			{
+				mains_running = true;
+				sim_kernel_schedule(now, mains_crossing, NULL);
+			}
+
+			break;
+
+		case SIM_INPUT_TEMPERATURE:
+			hal_linux_temp_set(step->value);
+			break;
+
+		case SIM_INPUT_LATENCY:
+			ack_latency = (int64_t)(step->value * 1000);
+			break;
+
+		case SIM_INPUT_CLOCK:
+			sntp_base = (int64_t)(step->value * 1000000);
+			sntp_since = now;
+			break;
+
+		case SIM_INPUT_DRIFT:
+			sntp_base = sntp_time(now);
+			sntp_since = now;
+			sntp_drift = step->value;
+			break;
+
+		case SIM_INPUT_SNTP:
+			sntp_reachable = step->value != 0;
+			break;
+
+		case SIM_INPUT_PUBLISH:
+		{
+			char topic[TOPIC_SIZE];
+			char * tag = strstr(step->topic, DEVICE_ID_TAG);
+
+			if(tag != NULL)
+				snprintf(topic, sizeof(topic), "%.*s%s%s", (int)(tag - step->topic), step->topic, CONFIG_APPLICATION_DEVICE_ID, tag + strlen(DEVICE_ID_TAG));
+			else
+				snprintf(topic, sizeof(topic), "%s", step->topic);
+
+			if(esp_mqtt_loopback_deliver(NULL, topic, step->payload, step->payload_len) != ESP_OK)
+				ESP_LOGW(TAG, "Unable to deliver to %s", topic);
+
+			if(events_file != NULL)
+				fprintf(events_file, "%" PRId64 ",deliver,%s,%zu\n", now, topic, step->payload_len);
+
+			return;
+		}
+
+		default:
+			break;
+	}
+
+	if(events_file != NULL)
+		fprintf(events_file, "%" PRId64 ",input,%s,%g\n", now, sim_profile_input_name(step->input), step->value);
+}
+
+static void button_edge(uint32_t level)
+{
+	int64_t now = sim_kernel_now();
+
+	hal_linux_gpio_drive(CONFIG_BITEC_BUTTON_PIN, level);
+
+	if(bounce_time == 0)
+		return;
+
+	for(int i = 0; i < BOUNCE_EDGES; i++)
+		sim_kernel_schedule(now + (int64_t)(bounce_edges[i] * bounce_time), button_bounce, NULL);
+}
+
+static void button_release(void * arg)
+{
+	button_edge(1);
+}
+
+static void button_bounce(void * arg)
+{
+	hal_linux_gpio_drive(CONFIG_BITEC_BUTTON_PIN, !hal_gpio_get_level(CONFIG_BITEC_BUTTON_PIN));
+}
+
+static void mains_crossing(void * arg)
+{
+	if(mains_half_period == 0)
+	{
+		mains_running = false;
+		return;
+	}
+
+#if CONFIG_BITEC_RELAY_ZC_PIN >= 0
+	/* Detector output toggling at every crossing */
+	hal_linux_gpio_drive(CONFIG_BITEC_RELAY_ZC_PIN, !hal_gpio_get_level(CONFIG_BITEC_RELAY_ZC_PIN));
+#endif
+
+	sim_kernel_schedule(sim_kernel_now() + mains_half_period, mains_crossing, NULL);
+}
+
+static void relay_contacts(void * arg)
+{
+	contacts = (intptr_t)arg != 0;
+	load_update();
+
+#if CONFIG_BITEC_RELAY_SENSE_PIN >= 0
+	hal_linux_gpio_drive(CONFIG_BITEC_RELAY_SENSE_PIN, contacts || welded);
+#endif
+}
+
+static void load_update(void)
+{
+	double current = contacts || welded ? load_current : 0;
+
+	if(current != bl0937.current)
+		sim_bl0937_set_load(&bl0937, bl0937.voltage, current, bl0937.pf);
+}
+
+static void timer_hook(int64_t due, void * arg)
+{
+	sim_kernel_schedule(due, timer_event, NULL);
+}
+
+static void timer_event(void * arg)
+{
+	hal_linux_timer_run();
+}
+
+static void sntp_hook(uint32_t interval, void * arg)
+{
+	sntp_interval = (int64_t)interval * 1000;
+	sim_kernel_schedule(sim_kernel_now() + SNTP_DELAY, sntp_event, NULL);
+}
+
+/* Answer a poll of the firmware with the server time, none while unreachable */
+static void sntp_event(void * arg)
+{
+	int64_t now = sim_kernel_now();
+
+	if(sntp_reachable)
+	{
+		hal_linux_sntp_sync(sntp_time(now));
+		sntp_syncs++;
+
+		if(events_file != NULL)
+			fprintf(events_file, "%" PRId64 ",sntp,sync,%" PRId64 "\n", now, sntp_time(now));
+	}
+
+	sim_kernel_schedule(now + sntp_interval, sntp_event, NULL);
+}
+
+/* Unix time of the server in us at a virtual time */
+static int64_t sntp_time(int64_t now)
+{
+	return sntp_base + (now - sntp_since) - (int64_t)((now - sntp_since) * sntp_drift / 1e6);
+}
+
+static topic_stats_t * topic_stats(const char * topic)
+{
+	for(size_t i = 0; i < topics_num; i++)
+	{
+		if(!strcmp(topics[i].topic, topic))
+			return &topics[i];
+	}
+
+	if(topics_num == TOPICS_MAX || strlen(topic) >= TOPIC_SIZE)
+		return NULL;
+
+	strcpy(topics[topics_num].topic, topic);
+
+	return &topics[topics_num++];
+}
+
+static void report(int64_t duration, double wall_time)
+{
+	print_time("sim: simulated ", duration);
+	printf(" in %.3f s, %.0fx real time\n", wall_time, wall_time > 0 ? duration / 1e6 / wall_time : 0);
+	printf("sim: %" PRIu64 " task switches, %" PRIu64 " BL0937 edges\n", sim_kernel_switches(), bl0937.edges);
+
+	for(size_t i = 0; i < topics_num; i++)
+	{
+		topic_stats_t * stats = &topics[i];
+
+		printf("mqtt: %-48s %8" PRIu32 " messages %10" PRIu64 " bytes", stats->topic, stats->count, stats->bytes);
+
+		if(stats->interval.count > 0)
+			printf(", interval avg %.3f s max %.3f s", (double)stats->interval.sum / stats->interval.count / 1e3, stats->interval.max / 1e3);
+
+		printf("\n");
+	}
+
+	if(acks.count > 0)
+		printf("mqtt: %" PRIu32 " acknowledged, latency avg %.3f ms max %.3f ms\n", acks.count, (double)acks.sum / acks.count / 1e3, acks.max / 1e3);
+
+	for(int pin = 0; pin < HAL_GPIO_MAX; pin++)
+	{
+		pin_stats_t * stats = &pins[pin];
+
+		if(stats->transitions == 0)
+			continue;
+
+		int64_t high_time = stats->high_time + (stats->level ? duration - stats->since : 0);
+
+		printf("gpio: %s%d: %" PRIu32 " transitions, high %.2f %% of the time\n",
+				pin == CONFIG_APPLICATION_RELAY_PIN ? "relay " : "", pin, stats->transitions, 100.0 * high_time / duration);
+	}
+
+	if(sntp_syncs > 0)
+		printf("sntp: %" PRIu32 " syncs, uptime %.1f ppm fast\n", sntp_syncs, sntp_drift);
+
+	if(last_metrics != NULL)
+		printf("metrics: %s\n", last_metrics);
+}
+
+static void print_time(const char * prefix, int64_t time)
+{
+	int64_t seconds = time / 1000000;
+
+	printf("%s%" PRId64 "d %02d:%02d:%02d.%03d", prefix, seconds / 86400, (int)(seconds / 3600 % 24),
+			(int)(seconds / 60 % 60), (int)(seconds % 60), (int)(time / 1000 % 1000));
+}
+
+static void usage(const char * name)
+{
+	fprintf(stderr,
+			"usage: %s [-d duration] [-l latency_ms] [-o events.csv] [-v] [profile]\n"
+			"  -d  simulated time, such as 7d or 12h30m (default " DEFAULT_DURATION ")\n"
+			"  -l  broker acknowledge latency in ms (default %d)\n"
+			"  -o  write every publish, input and output change as CSV\n"
+			"  -v  show the firmware logs\n", name, DEFAULT_LATENCY);
+}
+
+/* end of file ---------------------------------------------------------------*/
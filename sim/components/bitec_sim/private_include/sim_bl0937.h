@@ -0,0 +1,70 @@
+/*
+ * sim_bl0937.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _SIM_BL0937_H_
+#define _SIM_BL0937_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef struct
+{
+	int pin;
+	uint32_t level;
+	double half_period;		/*!< Time between edges in microseconds, INFINITY when stopped */
+	double next;			/*!< Time of the next edge in microseconds */
+} sim_bl0937_output_t;
+
+typedef struct
+{
+	int sel_pin;
+	double voltage;			/*!< Mains RMS voltage in V */
+	double current;			/*!< Load RMS current in A */
+	double pf;				/*!< Load power factor */
+	sim_bl0937_output_t cf;		/*!< Active power pulses */
+	sim_bl0937_output_t cf1;	/*!< Current or voltage pulses, as selected by SEL */
+	uint64_t edges;			/*!< Number of edges driven */
+} sim_bl0937_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+void sim_bl0937_init(sim_bl0937_t * const me, int cf_pin, int cf1_pin, int sel_pin);
+
+/* Change the load, pulses follow at the new frequencies from now on */
+void sim_bl0937_set_load(sim_bl0937_t * const me, double voltage, double current, double pf);
+
+/* The firmware changed the SEL pin */
+void sim_bl0937_select(sim_bl0937_t * const me);
+
+/* Drive every edge up to now, with the virtual clock set to the time of each edge */
+void sim_bl0937_advance(sim_bl0937_t * const me, int64_t now);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _SIM_BL0937_H_ */
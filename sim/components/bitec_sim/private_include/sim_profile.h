@@ -0,0 +1,95 @@
+/*
+ * sim_profile.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _SIM_PROFILE_H_
+#define _SIM_PROFILE_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef enum
+{
+	SIM_INPUT_VOLTAGE = 0,	/*!< Mains RMS voltage in V */
+	SIM_INPUT_CURRENT,		/*!< Load RMS current in A, flowing while the relay contacts are closed */
+	SIM_INPUT_PF,			/*!< Load power factor */
+	SIM_INPUT_LIGHT,		/*!< Light sensor ADC reading */
+	SIM_INPUT_PRESENCE,		/*!< PIR sensor output, 0 or 1 */
+	SIM_INPUT_BUTTON,		/*!< Button press of the given length in ms */
+	SIM_INPUT_BOUNCE,		/*!< Contact bounce after every button edge, length in ms */
+	SIM_INPUT_WELD,			/*!< Relay contacts welded closed, 0 or 1 */
+	SIM_INPUT_MAINS,		/*!< Mains frequency in Hz seen by the zero crossing detector, 0 for none */
+	SIM_INPUT_TEMPERATURE,	/*!< Chip temperature in Celsius */
+	SIM_INPUT_LATENCY,		/*!< Broker acknowledge latency in ms */
+	SIM_INPUT_PUBLISH,		/*!< Message sent by the broker to the device */
+	SIM_INPUT_CLOCK,		/*!< Unix time of the SNTP server in s, a step of its clock */
+	SIM_INPUT_DRIFT,		/*!< Of the device uptime against the SNTP server in ppm, positive when it runs fast */
+	SIM_INPUT_SNTP,			/*!< SNTP server reachable, 0 or 1 */
+	SIM_INPUT_MAX
+} sim_input_e;
+
+typedef struct
+{
+	int64_t time;			/*!< Offset from the start of the period in microseconds */
+	sim_input_e input;
+	double value;
+	char * topic;			/*!< SIM_INPUT_PUBLISH only */
+	char * payload;			/*!< SIM_INPUT_PUBLISH only, written hex:<bytes> for binary ones */
+	size_t payload_len;		/*!< SIM_INPUT_PUBLISH only */
+} sim_step_t;
+
+typedef void (* sim_profile_apply_t)(const sim_step_t * step, void * arg);
+
+typedef struct
+{
+	sim_step_t * steps;		/*!< Steps sorted by time, file order kept for equal times */
+	size_t steps_num;
+	int64_t period;			/*!< The steps repeat every period, 0 to run them once */
+	size_t index;			/*!< Next step to apply */
+	int64_t base;			/*!< Start time of the current period */
+	sim_profile_apply_t apply;
+	void * arg;
+} sim_profile_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+esp_err_t sim_profile_load(sim_profile_t * const me, const char * path);
+esp_err_t sim_profile_start(sim_profile_t * const me, sim_profile_apply_t apply, void * arg);
+void sim_profile_free(sim_profile_t * const me);
+
+/* Name of an input as written in the profiles */
+const char * sim_profile_input_name(sim_input_e input);
+
+/* Parse a time such as 90, 1.5s, 250ms, 7h30m or 1d, seconds if no unit is given */
+esp_err_t sim_profile_parse_time(const char * text, int64_t * time);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _SIM_PROFILE_H_ */
@@ -0,0 +1,120 @@
+/*
+ * sim_bl0937.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <math.h>
+
+#include "sdkconfig.h"
+#include "bitec_hal_linux.h"
+#include "sim_bl0937.h"
+
+/* macros --------------------------------------------------------------------*/
+
+/* Transfer functions of the BL0937 datasheet, frequencies in Hz for RMS input voltages in V */
+#define BL0937_VREF		1.218		/*!< Internal reference voltage */
+#define BL0937_K_CF		1721506.0	/*!< F_CF = K_CF * V(V) * V(I) / VREF^2 */
+#define BL0937_K_CFI	94638.0		/*!< F_CF1 = K_CFI * V(I) / VREF, SEL low */
+#define BL0937_K_CFU	15397.0		/*!< F_CF1 = K_CFU * V(V) / VREF, SEL high */
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static void set_frequency(sim_bl0937_output_t * output, double frequency, double now);
+static double voltage_input(sim_bl0937_t * const me);
+static double current_input(sim_bl0937_t * const me);
+
+/* external functions definition ---------------------------------------------*/
+
+void sim_bl0937_init(sim_bl0937_t * const me, int cf_pin, int cf1_pin, int sel_pin)
+{
+	me->sel_pin = sel_pin;
+	me->voltage = 0;
+	me->current = 0;
+	me->pf = 1;
+	me->edges = 0;
+
+	me->cf.pin = cf_pin;
+	me->cf.level = 1;
+	me->cf.half_period = INFINITY;
+	me->cf.next = INFINITY;
+
+	me->cf1.pin = cf1_pin;
+	me->cf1.level = 1;
+	me->cf1.half_period = INFINITY;
+	me->cf1.next = INFINITY;
+}
+
+void sim_bl0937_set_load(sim_bl0937_t * const me, double voltage, double current, double pf)
+{
+	double now = hal_time_us();
+
+	me->voltage = voltage;
+	me->current = current;
+	me->pf = pf;
+
+	set_frequency(&me->cf, BL0937_K_CF * voltage_input(me) * current_input(me) * pf / (BL0937_VREF * BL0937_VREF), now);
+	sim_bl0937_select(me);
+}
+
+void sim_bl0937_select(sim_bl0937_t * const me)
+{
+	double now = hal_time_us();
+
+	if(hal_gpio_get_level(me->sel_pin))
+		set_frequency(&me->cf1, BL0937_K_CFU * voltage_input(me) / BL0937_VREF, now);
+	else
+		set_frequency(&me->cf1, BL0937_K_CFI * current_input(me) / BL0937_VREF, now);
+}
+
+void sim_bl0937_advance(sim_bl0937_t * const me, int64_t now)
+{
+	for(;;)
+	{
+		sim_bl0937_output_t * output = me->cf.next <= me->cf1.next ? &me->cf : &me->cf1;
+
+		if(output->next > now)
+			break;
+
+		hal_linux_time_set((int64_t)output->next);
+
+		/* The ISR can change SEL, which reschedules CF1 from this edge */
+		output->next += output->half_period;
+		output->level = !output->level;
+		hal_linux_gpio_drive(output->pin, output->level);
+
+		me->edges++;
+	}
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static void set_frequency(sim_bl0937_output_t * output, double frequency, double now)
+{
+	/* 50 % duty cycle, both edges are seen by the firmware */
+	output->half_period = frequency > 0 ? 500000.0 / frequency : INFINITY;
+	output->next = now + output->half_period;
+}
+
+static double voltage_input(sim_bl0937_t * const me)
+{
+	/* Divider ratio of the voltage input */
+	return me->voltage / CONFIG_BL0937_R_VOLTAGE;
+}
+
+static double current_input(sim_bl0937_t * const me)
+{
+	/* Shunt resistor in milliohms */
+	return me->current * CONFIG_BL0937_R_CURRENT / 1000.0;
+}
+
+/* end of file ---------------------------------------------------------------*/
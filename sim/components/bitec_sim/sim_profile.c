@@ -0,0 +1,354 @@
+/*
+ * sim_profile.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "esp_log.h"
+#include "sim_kernel.h"
+#include "sim_profile.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define LINE_SIZE		512		/*!< Longest profile line */
+#define HEX_PREFIX		"hex:"	/*!< Binary payload written in hex digits */
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static const char * TAG = "sim_profile";
+
+static const char * const inputs[SIM_INPUT_MAX] =
+{
+	[SIM_INPUT_VOLTAGE] = "voltage",
+	[SIM_INPUT_CURRENT] = "current",
+	[SIM_INPUT_PF] = "pf",
+	[SIM_INPUT_LIGHT] = "light",
+	[SIM_INPUT_PRESENCE] = "presence",
+	[SIM_INPUT_BUTTON] = "button",
+	[SIM_INPUT_BOUNCE] = "bounce",
+	[SIM_INPUT_WELD] = "weld",
+	[SIM_INPUT_MAINS] = "mains",
+	[SIM_INPUT_TEMPERATURE] = "temperature",
+	[SIM_INPUT_LATENCY] = "latency",
+	[SIM_INPUT_PUBLISH] = "publish",
+	[SIM_INPUT_CLOCK] = "clock",
+	[SIM_INPUT_DRIFT] = "drift",
+	[SIM_INPUT_SNTP] = "sntp",
+};
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static esp_err_t parse_line(sim_profile_t * const me, char * line);
+static esp_err_t add_step(sim_profile_t * const me, const sim_step_t * step);
+static void step_event(void * arg);
+static esp_err_t decode_hex(char * text, size_t * len);
+
+/* external functions definition ---------------------------------------------*/
+
+esp_err_t sim_profile_load(sim_profile_t * const me, const char * path)
+{
+	memset(me, 0, sizeof(sim_profile_t));
+
+	FILE * file = fopen(path, "r");
+
+	if(file == NULL)
+	{
+		ESP_LOGE(TAG, "Unable to open %s", path);
+		return ESP_ERR_NOT_FOUND;
+	}
+
+	char line[LINE_SIZE];
+	int line_num = 0;
+	esp_err_t ret = ESP_OK;
+
+	while(fgets(line, sizeof(line), file) != NULL)
+	{
+		line_num++;
+		ret = parse_line(me, line);
+
+		if(ret != ESP_OK)
+		{
+			ESP_LOGE(TAG, "%s:%d: invalid line", path, line_num);
+			break;
+		}
+	}
+
+	fclose(file);
+
+	if(ret != ESP_OK)
+	{
+		sim_profile_free(me);
+		return ret;
+	}
+
+	for(size_t i = 0; i < me->steps_num; i++)
+	{
+		if(me->period > 0 && me->steps[i].time >= me->period)
+		{
+			ESP_LOGE(TAG, "%s: steps must happen before the end of the period", path);
+			sim_profile_free(me);
+			return ESP_ERR_INVALID_ARG;
+		}
+	}
+
+	return ESP_OK;
+}
+
+esp_err_t sim_profile_start(sim_profile_t * const me, sim_profile_apply_t apply, void * arg)
+{
+	me->apply = apply;
+	me->arg = arg;
+	me->index = 0;
+	me->base = sim_kernel_now();
+
+	if(me->steps_num == 0)
+		return ESP_OK;
+
+	/* Steps due now are applied at once, before any task runs */
+	step_event(me);
+
+	return ESP_OK;
+}
+
+void sim_profile_free(sim_profile_t * const me)
+{
+	for(size_t i = 0; i < me->steps_num; i++)
+	{
+		free(me->steps[i].topic);
+		free(me->steps[i].payload);
+	}
+
+	free(me->steps);
+	me->steps = NULL;
+	me->steps_num = 0;
+}
+
+const char * sim_profile_input_name(sim_input_e input)
+{
+	return input < SIM_INPUT_MAX ? inputs[input] : "unknown";
+}
+
+esp_err_t sim_profile_parse_time(const char * text, int64_t * time)
+{
+	double total = 0;
+
+	if(* text == '\0')
+		return ESP_ERR_INVALID_ARG;
+
+	while(* text != '\0')
+	{
+		char * end;
+		double value = strtod(text, &end);
+
+		if(end == text || value < 0)
+			return ESP_ERR_INVALID_ARG;
+
+		if(!strncmp(end, "ms", 2))
+		{
+			value *= 1e3;
+			end += 2;
+		}
+		else if(* end == 's' || * end == '\0')
+		{
+			value *= 1e6;
+			end += * end == 's';
+		}
+		else if(* end == 'm')
+		{
+			value *= 60e6;
+			end++;
+		}
+		else if(* end == 'h')
+		{
+			value *= 3600e6;
+			end++;
+		}
+		else if(* end == 'd')
+		{
+			value *= 86400e6;
+			end++;
+		}
+		else
+			return ESP_ERR_INVALID_ARG;
+
+		total += value;
+		text = end;
+	}
+
+	* time = (int64_t)total;
+
+	return ESP_OK;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static esp_err_t parse_line(sim_profile_t * const me, char * line)
+{
+	/* Drop comments and the line end */
+	line[strcspn(line, "#\r\n")] = '\0';
+
+	char * save;
+	char * first = strtok_r(line, " \t", &save);
+
+	if(first == NULL)
+		return ESP_OK;
+
+	if(!strcmp(first, "period"))
+	{
+		char * period = strtok_r(NULL, " \t", &save);
+
+		if(period == NULL || sim_profile_parse_time(period, &me->period) != ESP_OK || me->period == 0)
+			return ESP_ERR_INVALID_ARG;
+
+		return ESP_OK;
+	}
+
+	sim_step_t step = { 0 };
+
+	if(sim_profile_parse_time(first, &step.time) != ESP_OK)
+		return ESP_ERR_INVALID_ARG;
+
+	char * input = strtok_r(NULL, " \t", &save);
+
+	if(input == NULL)
+		return ESP_ERR_INVALID_ARG;
+
+	for(step.input = 0; step.input < SIM_INPUT_MAX; step.input++)
+	{
+		if(!strcmp(input, inputs[step.input]))
+			break;
+	}
+
+	if(step.input == SIM_INPUT_MAX)
+		return ESP_ERR_INVALID_ARG;
+
+	if(step.input == SIM_INPUT_PUBLISH)
+	{
+		char * topic = strtok_r(NULL, " \t", &save);
+		char * payload = strtok_r(NULL, "", &save);
+
+		if(topic == NULL)
+			return ESP_ERR_INVALID_ARG;
+
+		while(payload != NULL && isspace((unsigned char)* payload))
+			payload++;
+
+		step.topic = strdup(topic);
+		step.payload = strdup(payload != NULL ? payload : "");
+
+		if(step.topic == NULL || step.payload == NULL)
+		{
+			free(step.topic);
+			free(step.payload);
+			return ESP_ERR_NO_MEM;
+		}
+
+		step.payload_len = strlen(step.payload);
+
+		if(!strncmp(step.payload, HEX_PREFIX, strlen(HEX_PREFIX)) && decode_hex(step.payload, &step.payload_len) != ESP_OK)
+		{
+			free(step.topic);
+			free(step.payload);
+			return ESP_ERR_INVALID_ARG;
+		}
+	}
+	else
+	{
+		char * value = strtok_r(NULL, " \t", &save);
+		char * end;
+
+		if(value == NULL)
+			return ESP_ERR_INVALID_ARG;
+
+		step.value = strtod(value, &end);
+
+		if(* end != '\0')
+			return ESP_ERR_INVALID_ARG;
+	}
+
+	return add_step(me, &step);
+}
+
+static esp_err_t add_step(sim_profile_t * const me, const sim_step_t * step)
+{
+	sim_step_t * steps = realloc(me->steps, (me->steps_num + 1) * sizeof(sim_step_t));
+
+	if(steps == NULL)
+	{
+		free(step->topic);
+		free(step->payload);
+		return ESP_ERR_NO_MEM;
+	}
+
+	me->steps = steps;
+
+	/* Insert sorted by time, after the steps of the same time to keep the file order */
+	size_t i = me->steps_num++;
+
+	while(i > 0 && me->steps[i - 1].time > step->time)
+	{
+		me->steps[i] = me->steps[i - 1];
+		i--;
+	}
+
+	me->steps[i] = * step;
+
+	return ESP_OK;
+}
+
+static void step_event(void * arg)
+{
+	sim_profile_t * me = (sim_profile_t *)arg;
+	int64_t now = sim_kernel_now();
+
+	/* Apply every step due now */
+	while(me->index < me->steps_num && me->base + me->steps[me->index].time <= now)
+		me->apply(&me->steps[me->index++], me->arg);
+
+	if(me->index == me->steps_num)
+	{
+		if(me->period == 0)
+			return;
+
+		me->index = 0;
+		me->base += me->period;
+	}
+
+	sim_kernel_schedule(me->base + me->steps[me->index].time, step_event, me);
+}
+
+/* Replace a hex:<digits> payload by its bytes in place, spaces are not allowed between them */
+static esp_err_t decode_hex(char * text, size_t * len)
+{
+	const char * digits = text + strlen(HEX_PREFIX);
+	size_t i = 0;
+
+	for(; digits[0] != '\0'; digits += 2)
+	{
+		unsigned int byte;
+
+		if(!isxdigit((unsigned char)digits[0]) || !isxdigit((unsigned char)digits[1]) || sscanf(digits, "%2x", &byte) != 1)
+			return ESP_ERR_INVALID_ARG;
+
+		text[i++] = (char)byte;
+	}
+
+	text[i] = '\0';
+	* len = i;
+
+	return ESP_OK;
+}
+
+/* end of file ---------------------------------------------------------------*/
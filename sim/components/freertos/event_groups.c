@@ -0,0 +1,140 @@
+/*
+ * event_groups.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include "sim_kernel_private.h"
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+struct sim_event_group
+{
+	EventBits_t bits;
+};
+
+/* internal data declaration -------------------------------------------------*/
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static bool bits_match(EventBits_t bits, EventBits_t wait_bits, bool wait_all);
+
+/* external functions definition ---------------------------------------------*/
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+	return calloc(1, sizeof(struct sim_event_group));
+}
+
+void vEventGroupDelete(EventGroupHandle_t xEventGroup)
+{
+	free(xEventGroup);
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToWaitFor,
+		const BaseType_t xClearOnExit, const BaseType_t xWaitForAllBits, TickType_t xTicksToWait)
+{
+	EventBits_t bits = xEventGroup->bits;
+
+	if(bits_match(bits, uxBitsToWaitFor, xWaitForAllBits))
+	{
+		if(xClearOnExit)
+			xEventGroup->bits &= ~uxBitsToWaitFor;
+
+		return bits;
+	}
+
+	if(xTicksToWait == 0)
+		return bits;
+
+	sim_task_t * task = sim_kernel_current();
+	task->wait_bits = uxBitsToWaitFor;
+	task->wait_all = xWaitForAllBits;
+	task->wait_clear = xClearOnExit;
+
+	/* The bits are cleared by the task that set them, before this one runs again */
+	if(sim_kernel_block(SIM_WAIT_EVENT_GROUP, xEventGroup, sim_kernel_wake_time(xTicksToWait)))
+		return task->wait_result;
+
+	return xEventGroup->bits;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet)
+{
+	EventBits_t clear = 0;
+
+	xEventGroup->bits |= uxBitsToSet;
+
+	for(sim_task_t * t = sim_kernel_tasks(); t != NULL; t = t->next)
+	{
+		if(t->state != SIM_TASK_BLOCKED || t->wait != SIM_WAIT_EVENT_GROUP || t->wait_object != xEventGroup)
+			continue;
+
+		if(bits_match(xEventGroup->bits, t->wait_bits, t->wait_all))
+		{
+			t->wait_result = xEventGroup->bits;
+
+			if(t->wait_clear)
+				clear |= t->wait_bits;
+
+			sim_kernel_unblock(t);
+		}
+	}
+
+	xEventGroup->bits &= ~clear;
+
+	EventBits_t bits = xEventGroup->bits;
+
+	sim_kernel_preempt();
+
+	return bits;
+}
+
+BaseType_t xEventGroupSetBitsFromISR(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet, BaseType_t * pxHigherPriorityTaskWoken)
+{
+	/* Applied at once instead of through the timer task, the result is the same without the latency */
+	xEventGroupSetBits(xEventGroup, uxBitsToSet);
+
+	if(pxHigherPriorityTaskWoken != NULL)
+		* pxHigherPriorityTaskWoken = pdTRUE;
+
+	return pdPASS;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToClear)
+{
+	EventBits_t bits = xEventGroup->bits;
+
+	xEventGroup->bits &= ~uxBitsToClear;
+
+	return bits;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t xEventGroup)
+{
+	return xEventGroup->bits;
+}
+
+EventBits_t xEventGroupGetBitsFromISR(EventGroupHandle_t xEventGroup)
+{
+	return xEventGroup->bits;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static bool bits_match(EventBits_t bits, EventBits_t wait_bits, bool wait_all)
+{
+	if(wait_all)
+		return (bits & wait_bits) == wait_bits;
+
+	return (bits & wait_bits) != 0;
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,122 @@
+/*
+ * FreeRTOS.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ *
+ * Virtual time stand-in of the FreeRTOS kernel for the firmware simulator.
+ * Tasks are cooperative coroutines scheduled by priority on a single host
+ * thread, time only moves when every task is blocked. The subset of the API
+ * used by the firmware and the ESP-IDF components is kept source compatible.
+ */
+
+#ifndef _FREERTOS_H_
+#define _FREERTOS_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "esp_bit_defs.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#ifdef CONFIG_FREERTOS_HZ
+#define configTICK_RATE_HZ			CONFIG_FREERTOS_HZ
+#else
+#define configTICK_RATE_HZ			100
+#endif
+
+#define configMAX_PRIORITIES		25
+#define configMINIMAL_STACK_SIZE	768
+#define configMAX_TASK_NAME_LEN		16
+#define configTIMER_TASK_PRIORITY	1
+
+#define pdFALSE						((BaseType_t)0)
+#define pdTRUE						((BaseType_t)1)
+#define pdFAIL						pdFALSE
+#define pdPASS						pdTRUE
+#define errQUEUE_EMPTY				pdFALSE
+#define errQUEUE_FULL				pdFALSE
+
+#define portMAX_DELAY				((TickType_t)0xFFFFFFFFUL)
+#define portTICK_PERIOD_MS			((TickType_t)1000 / configTICK_RATE_HZ)
+#define portNUM_PROCESSORS			1
+#define pdMS_TO_TICKS(xTimeInMs)	((TickType_t)(((TickType_t)(xTimeInMs) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+#define pdTICKS_TO_MS(xTicks)		((TickType_t)((uint64_t)(xTicks) * 1000 / configTICK_RATE_HZ))
+
+#define tskIDLE_PRIORITY			((UBaseType_t)0U)
+#define tskNO_AFFINITY				0x7FFFFFFF
+
+/* Only one task runs at a time and ISRs are dispatched between tasks, so critical sections are empty */
+#define portMUX_INITIALIZER_UNLOCKED	{ .owner = 0, .count = 0 }
+#define portENTER_CRITICAL(mux)			((void)(mux))
+#define portEXIT_CRITICAL(mux)			((void)(mux))
+#define portENTER_CRITICAL_ISR(mux)		((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux)		((void)(mux))
+#define portENTER_CRITICAL_SAFE(mux)	((void)(mux))
+#define portEXIT_CRITICAL_SAFE(mux)		((void)(mux))
+#define taskENTER_CRITICAL(mux)			((void)(mux))
+#define taskEXIT_CRITICAL(mux)			((void)(mux))
+#define taskENTER_CRITICAL_ISR(mux)		((void)(mux))
+#define taskEXIT_CRITICAL_ISR(mux)		((void)(mux))
+#define vPortCPUInitializeMutex(mux)	((void)(mux))
+
+/* Tasks woken from ISRs run as soon as the ISR returns to the scheduler */
+#define portYIELD_FROM_ISR(...)			((void)0)
+#define portEND_SWITCHING_ISR(x)		((void)(x))
+#define portYIELD()						vPortYield()
+
+#define configASSERT(x)					do { if(!(x)) abort(); } while(0)
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t StackType_t;
+
+typedef struct
+{
+	uint32_t owner;
+	uint32_t count;
+} portMUX_TYPE;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+void vPortYield(void);
+
+static inline void * pvPortMalloc(size_t size)
+{
+	return malloc(size);
+}
+
+static inline void vPortFree(void * ptr)
+{
+	free(ptr);
+}
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _FREERTOS_H_ */
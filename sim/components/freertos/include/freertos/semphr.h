@@ -0,0 +1,55 @@
+/*
+ * semphr.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _SEMPHR_H_
+#define _SEMPHR_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include "freertos/queue.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+/* Mutexes have no priority inheritance in the simulator */
+#define xSemaphoreCreateBinary()						xQueueGenericCreate(1, 0, queueQUEUE_TYPE_BINARY_SEMAPHORE)
+#define xSemaphoreCreateCounting(uxMaxCount, uxInitialCount)	xQueueCreateCountingSemaphore((uxMaxCount), (uxInitialCount))
+#define xSemaphoreCreateMutex()							xQueueGenericCreate(1, 0, queueQUEUE_TYPE_MUTEX)
+#define xSemaphoreCreateRecursiveMutex()				xQueueGenericCreate(1, 0, queueQUEUE_TYPE_RECURSIVE_MUTEX)
+#define vSemaphoreDelete(xSemaphore)					vQueueDelete((QueueHandle_t)(xSemaphore))
+#define xSemaphoreTake(xSemaphore, xBlockTime)			xQueueSemaphoreTake((xSemaphore), (xBlockTime))
+#define xSemaphoreGive(xSemaphore)						xQueueGenericSend((QueueHandle_t)(xSemaphore), NULL, 0, queueSEND_TO_BACK)
+#define xSemaphoreTakeFromISR(xSemaphore, pxHigherPriorityTaskWoken)	xQueueReceiveFromISR((QueueHandle_t)(xSemaphore), NULL, (pxHigherPriorityTaskWoken))
+#define xSemaphoreGiveFromISR(xSemaphore, pxHigherPriorityTaskWoken)	xQueueGiveFromISR((QueueHandle_t)(xSemaphore), (pxHigherPriorityTaskWoken))
+#define xSemaphoreTakeRecursive(xMutex, xBlockTime)		xQueueTakeMutexRecursive((xMutex), (xBlockTime))
+#define xSemaphoreGiveRecursive(xMutex)					xQueueGiveMutexRecursive((xMutex))
+#define uxSemaphoreGetCount(xSemaphore)					uxQueueMessagesWaiting((QueueHandle_t)(xSemaphore))
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _SEMPHR_H_ */
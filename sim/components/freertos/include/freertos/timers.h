@@ -0,0 +1,59 @@
+/*
+ * timers.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _TIMERS_H_
+#define _TIMERS_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef struct sim_timer * TimerHandle_t;
+typedef void (* TimerCallbackFunction_t)(TimerHandle_t xTimer);
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Callbacks run in the timer service task, as on FreeRTOS. Commands take effect at once,
+ * so the tick to wait for room in the command queue is ignored */
+TimerHandle_t xTimerCreate(const char * const pcTimerName, const TickType_t xTimerPeriodInTicks,
+		const UBaseType_t uxAutoReload, void * const pvTimerID, TimerCallbackFunction_t pxCallbackFunction);
+BaseType_t xTimerStart(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t xTimerStop(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t xTimerReset(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t xTimerChangePeriod(TimerHandle_t xTimer, TickType_t xNewPeriod, TickType_t xTicksToWait);
+BaseType_t xTimerDelete(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t xTimerStartFromISR(TimerHandle_t xTimer, BaseType_t * pxHigherPriorityTaskWoken);
+BaseType_t xTimerStopFromISR(TimerHandle_t xTimer, BaseType_t * pxHigherPriorityTaskWoken);
+BaseType_t xTimerResetFromISR(TimerHandle_t xTimer, BaseType_t * pxHigherPriorityTaskWoken);
+BaseType_t xTimerIsTimerActive(TimerHandle_t xTimer);
+void * pvTimerGetTimerID(const TimerHandle_t xTimer);
+TickType_t xTimerGetPeriod(TimerHandle_t xTimer);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _TIMERS_H_ */
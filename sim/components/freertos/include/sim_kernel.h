@@ -0,0 +1,64 @@
+/*
+ * sim_kernel.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _SIM_KERNEL_H_
+#define _SIM_KERNEL_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#define SIM_KERNEL_FOREVER		INT64_MAX	/*!< Run until every task blocks forever */
+
+/* typedef -------------------------------------------------------------------*/
+
+/* Called from the scheduler, between tasks, as an ISR would be */
+typedef void (* sim_kernel_event_t)(void * arg);
+
+/* Called every time the virtual clock moves */
+typedef void (* sim_kernel_clock_t)(int64_t now);
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Must be called before any other kernel function, tasks can be created right after */
+void sim_kernel_init(sim_kernel_clock_t clock);
+
+/* Schedule an event at an absolute virtual time in microseconds. Events at the same time run in schedule order */
+esp_err_t sim_kernel_schedule(int64_t time, sim_kernel_event_t event, void * arg);
+
+/* Run the tasks until the virtual clock reaches until, or nothing is left to run */
+void sim_kernel_run(int64_t until);
+
+/* Virtual time in microseconds */
+int64_t sim_kernel_now(void);
+
+/* Number of times a task was switched in since sim_kernel_init() */
+uint64_t sim_kernel_switches(void);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _SIM_KERNEL_H_ */
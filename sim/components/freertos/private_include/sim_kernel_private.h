@@ -0,0 +1,117 @@
+/*
+ * sim_kernel_private.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _SIM_KERNEL_PRIVATE_H_
+#define _SIM_KERNEL_PRIVATE_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <ucontext.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "sim_kernel.h"
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#define SIM_TICK_US			(1000000 / configTICK_RATE_HZ)	/*!< Tick period in microseconds */
+#define SIM_STACK_SIZE		(256 * 1024)					/*!< Host stack of every task, libc needs far more than the target */
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef enum
+{
+	SIM_TASK_READY = 0,
+	SIM_TASK_BLOCKED,
+	SIM_TASK_DELETED
+} sim_task_state_e;
+
+typedef enum
+{
+	SIM_WAIT_NONE = 0,
+	SIM_WAIT_DELAY,
+	SIM_WAIT_NOTIFY,
+	SIM_WAIT_EVENT_GROUP,
+	SIM_WAIT_QUEUE_RECEIVE,
+	SIM_WAIT_QUEUE_SEND
+} sim_wait_e;
+
+struct sim_task
+{
+	ucontext_t context;
+	void * stack;
+	TaskFunction_t function;
+	void * arg;
+	char name[configMAX_TASK_NAME_LEN];
+	UBaseType_t priority;
+	sim_task_state_e state;
+	int64_t ready_order;		/*!< Run order among ready tasks of the same priority */
+	int64_t block_order;		/*!< Wake order among tasks blocked on the same object */
+	sim_wait_e wait;			/*!< What the task is blocked on */
+	const void * wait_object;
+	int64_t wake_time;			/*!< Timeout in microseconds, INT64_MAX if none */
+	bool timed_out;
+	EventBits_t wait_bits;		/*!< Event group wait parameters and result */
+	bool wait_all;
+	bool wait_clear;
+	EventBits_t wait_result;
+	uint32_t notify_value;
+	bool notify_pending;
+	struct sim_task * next;
+};
+
+typedef struct sim_task sim_task_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Task running now, NULL from events and before sim_kernel_run() */
+sim_task_t * sim_kernel_current(void);
+
+/* First task of the list of every task, in creation order */
+sim_task_t * sim_kernel_tasks(void);
+
+/* Add a created task to the scheduler, switching to it if its priority is higher */
+void sim_kernel_add(sim_task_t * task);
+
+/* Block the current task, returns false when it was woken by the timeout */
+bool sim_kernel_block(sim_wait_e wait, const void * object, int64_t wake_time);
+
+/* Make a blocked task ready, it runs once the current task blocks or is preempted */
+void sim_kernel_unblock(sim_task_t * task);
+
+/* Highest priority task blocked the longest on an object */
+sim_task_t * sim_kernel_waiter(sim_wait_e wait, const void * object);
+
+/* Switch to a ready task of higher priority than the current one */
+void sim_kernel_preempt(void);
+
+/* Leave the current task for good, the scheduler frees it */
+void sim_kernel_exit(void);
+
+/* Absolute wake time of a timeout in ticks */
+int64_t sim_kernel_wake_time(TickType_t ticks);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _SIM_KERNEL_PRIVATE_H_ */
@@ -0,0 +1,296 @@
+/*
+ * queue.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "freertos/queue.h"
+#include "sim_kernel_private.h"
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+struct sim_queue
+{
+	uint8_t * storage;
+	UBaseType_t length;
+	UBaseType_t item_size;
+	UBaseType_t count;
+	UBaseType_t head;
+	uint8_t type;
+	sim_task_t * holder;		/*!< Mutex holder */
+	UBaseType_t recursion;		/*!< Recursive mutex take count */
+};
+
+/* internal data declaration -------------------------------------------------*/
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static BaseType_t queue_send(QueueHandle_t queue, const void * item, TickType_t ticks, BaseType_t position, BaseType_t * woken);
+static BaseType_t queue_receive(QueueHandle_t queue, void * buffer, TickType_t ticks, bool peek, BaseType_t * woken);
+static bool is_mutex(QueueHandle_t queue);
+static bool wake(QueueHandle_t queue, sim_wait_e wait);
+
+/* external functions definition ---------------------------------------------*/
+
+QueueHandle_t xQueueGenericCreate(const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, const uint8_t ucQueueType)
+{
+	if(uxQueueLength == 0)
+		return NULL;
+
+	QueueHandle_t queue = calloc(1, sizeof(struct sim_queue));
+
+	if(queue == NULL)
+		return NULL;
+
+	if(uxItemSize > 0)
+	{
+		queue->storage = malloc(uxQueueLength * uxItemSize);
+
+		if(queue->storage == NULL)
+		{
+			free(queue);
+			return NULL;
+		}
+	}
+
+	queue->length = uxQueueLength;
+	queue->item_size = uxItemSize;
+	queue->type = ucQueueType;
+
+	/* Mutexes are created available */
+	if(is_mutex(queue))
+		queue->count = 1;
+
+	return queue;
+}
+
+void vQueueDelete(QueueHandle_t xQueue)
+{
+	if(xQueue == NULL)
+		return;
+
+	free(xQueue->storage);
+	free(xQueue);
+}
+
+BaseType_t xQueueGenericSend(QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait, const BaseType_t xCopyPosition)
+{
+	BaseType_t ret = queue_send(xQueue, pvItemToQueue, xTicksToWait, xCopyPosition, NULL);
+
+	sim_kernel_preempt();
+
+	return ret;
+}
+
+BaseType_t xQueueGenericSendFromISR(QueueHandle_t xQueue, const void * const pvItemToQueue, BaseType_t * const pxHigherPriorityTaskWoken, const BaseType_t xCopyPosition)
+{
+	return queue_send(xQueue, pvItemToQueue, 0, xCopyPosition, pxHigherPriorityTaskWoken);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait)
+{
+	BaseType_t ret = queue_receive(xQueue, pvBuffer, xTicksToWait, false, NULL);
+
+	sim_kernel_preempt();
+
+	return ret;
+}
+
+BaseType_t xQueueReceiveFromISR(QueueHandle_t xQueue, void * const pvBuffer, BaseType_t * const pxHigherPriorityTaskWoken)
+{
+	return queue_receive(xQueue, pvBuffer, 0, false, pxHigherPriorityTaskWoken);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait)
+{
+	return queue_receive(xQueue, pvBuffer, xTicksToWait, true, NULL);
+}
+
+BaseType_t xQueueReset(QueueHandle_t xQueue)
+{
+	xQueue->count = 0;
+	xQueue->head = 0;
+
+	/* Every sender blocked on a full queue can go on */
+	while(wake(xQueue, SIM_WAIT_QUEUE_SEND));
+
+	sim_kernel_preempt();
+
+	return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t xQueue)
+{
+	return xQueue->count;
+}
+
+UBaseType_t uxQueueMessagesWaitingFromISR(const QueueHandle_t xQueue)
+{
+	return xQueue->count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(const QueueHandle_t xQueue)
+{
+	return xQueue->length - xQueue->count;
+}
+
+QueueHandle_t xQueueCreateCountingSemaphore(const UBaseType_t uxMaxCount, const UBaseType_t uxInitialCount)
+{
+	if(uxInitialCount > uxMaxCount)
+		return NULL;
+
+	QueueHandle_t queue = xQueueGenericCreate(uxMaxCount, 0, queueQUEUE_TYPE_COUNTING_SEMAPHORE);
+
+	if(queue != NULL)
+		queue->count = uxInitialCount;
+
+	return queue;
+}
+
+BaseType_t xQueueSemaphoreTake(QueueHandle_t xQueue, TickType_t xTicksToWait)
+{
+	return xQueueReceive(xQueue, NULL, xTicksToWait);
+}
+
+BaseType_t xQueueGiveFromISR(QueueHandle_t xQueue, BaseType_t * const pxHigherPriorityTaskWoken)
+{
+	return queue_send(xQueue, NULL, 0, queueSEND_TO_BACK, pxHigherPriorityTaskWoken);
+}
+
+BaseType_t xQueueTakeMutexRecursive(QueueHandle_t xMutex, TickType_t xTicksToWait)
+{
+	if(xMutex->holder != NULL && xMutex->holder == sim_kernel_current())
+	{
+		xMutex->recursion++;
+		return pdPASS;
+	}
+
+	BaseType_t ret = xQueueReceive(xMutex, NULL, xTicksToWait);
+
+	if(ret == pdPASS)
+		xMutex->recursion = 1;
+
+	return ret;
+}
+
+BaseType_t xQueueGiveMutexRecursive(QueueHandle_t xMutex)
+{
+	if(xMutex->holder != sim_kernel_current())
+		return pdFAIL;
+
+	if(--xMutex->recursion > 0)
+		return pdPASS;
+
+	return xQueueGenericSend(xMutex, NULL, 0, queueSEND_TO_BACK);
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static BaseType_t queue_send(QueueHandle_t queue, const void * item, TickType_t ticks, BaseType_t position, BaseType_t * woken)
+{
+	/* Only the holder can give a mutex back */
+	if(is_mutex(queue) && queue->holder != sim_kernel_current())
+		return pdFAIL;
+
+	int64_t wake_time = sim_kernel_wake_time(ticks);
+
+	while(queue->count >= queue->length && position != queueOVERWRITE)
+	{
+		if(ticks == 0 || !sim_kernel_block(SIM_WAIT_QUEUE_SEND, queue, wake_time))
+			return errQUEUE_FULL;
+	}
+
+	if(queue->item_size > 0)
+	{
+		UBaseType_t index;
+
+		if(position == queueOVERWRITE && queue->count > 0)
+		{
+			/* Overwrite is only meant for queues of length one */
+			index = queue->head;
+			queue->count--;
+		}
+		else if(position == queueSEND_TO_FRONT)
+		{
+			queue->head = (queue->head + queue->length - 1) % queue->length;
+			index = queue->head;
+		}
+		else
+			index = (queue->head + queue->count) % queue->length;
+
+		memcpy(queue->storage + index * queue->item_size, item, queue->item_size);
+	}
+	else if(position == queueOVERWRITE && queue->count > 0)
+		queue->count--;
+
+	queue->count++;
+
+	if(is_mutex(queue))
+		queue->holder = NULL;
+
+	if(wake(queue, SIM_WAIT_QUEUE_RECEIVE) && woken != NULL)
+		* woken = pdTRUE;
+
+	return pdPASS;
+}
+
+static BaseType_t queue_receive(QueueHandle_t queue, void * buffer, TickType_t ticks, bool peek, BaseType_t * woken)
+{
+	int64_t wake_time = sim_kernel_wake_time(ticks);
+
+	while(queue->count == 0)
+	{
+		if(ticks == 0 || !sim_kernel_block(SIM_WAIT_QUEUE_RECEIVE, queue, wake_time))
+			return errQUEUE_EMPTY;
+	}
+
+	if(queue->item_size > 0 && buffer != NULL)
+		memcpy(buffer, queue->storage + queue->head * queue->item_size, queue->item_size);
+
+	if(peek)
+	{
+		/* The item is still there for the next receiver */
+		wake(queue, SIM_WAIT_QUEUE_RECEIVE);
+
+		return pdPASS;
+	}
+
+	queue->head = (queue->head + 1) % queue->length;
+	queue->count--;
+
+	if(is_mutex(queue))
+		queue->holder = sim_kernel_current();
+
+	if(wake(queue, SIM_WAIT_QUEUE_SEND) && woken != NULL)
+		* woken = pdTRUE;
+
+	return pdPASS;
+}
+
+static bool is_mutex(QueueHandle_t queue)
+{
+	return queue->type == queueQUEUE_TYPE_MUTEX || queue->type == queueQUEUE_TYPE_RECURSIVE_MUTEX;
+}
+
+static bool wake(QueueHandle_t queue, sim_wait_e wait)
+{
+	sim_task_t * task = sim_kernel_waiter(wait, queue);
+
+	if(task == NULL)
+		return false;
+
+	sim_kernel_unblock(task);
+
+	return true;
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,371 @@
+/*
+ * sim_kernel.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "sim_kernel_private.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define EVENTS_INITIAL_SIZE		64		/*!< Initial size of the event heap */
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef struct
+{
+	int64_t time;
+	uint64_t order;
+	sim_kernel_event_t event;
+	void * arg;
+} event_t;
+
+/* internal data declaration -------------------------------------------------*/
+
+static ucontext_t scheduler_context;
+static sim_task_t * tasks = NULL;
+static sim_task_t * current = NULL;
+static sim_kernel_clock_t clock_hook = NULL;
+static int64_t now = 0;
+static int64_t order = 0;
+static uint64_t switches = 0;
+
+/* Min-heap of pending events ordered by time and then by schedule order */
+static event_t * events = NULL;
+static size_t events_num = 0;
+static size_t events_size = 0;
+static uint64_t events_order = 0;
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static sim_task_t * next_ready(void);
+static int64_t next_wake_time(void);
+static void set_time(int64_t time);
+static void reap(void);
+static bool event_before(const event_t * a, const event_t * b);
+static void events_pop(event_t * event);
+
+/* external functions definition ---------------------------------------------*/
+
+void sim_kernel_init(sim_kernel_clock_t clock)
+{
+	clock_hook = clock;
+	current = NULL;
+	order = 0;
+	switches = 0;
+	events_num = 0;
+	events_order = 0;
+
+	set_time(0);
+}
+
+esp_err_t sim_kernel_schedule(int64_t time, sim_kernel_event_t event, void * arg)
+{
+	if(event == NULL)
+		return ESP_ERR_INVALID_ARG;
+
+	/* Events can not go back in time */
+	if(time < now)
+		time = now;
+
+	if(events_num == events_size)
+	{
+		size_t size = events_size ? events_size * 2 : EVENTS_INITIAL_SIZE;
+		event_t * resized = realloc(events, size * sizeof(event_t));
+
+		if(resized == NULL)
+			return ESP_ERR_NO_MEM;
+
+		events = resized;
+		events_size = size;
+	}
+
+	/* Sift up */
+	size_t i = events_num++;
+	event_t new_event = { .time = time, .order = events_order++, .event = event, .arg = arg };
+
+	while(i > 0 && event_before(&new_event, &events[(i - 1) / 2]))
+	{
+		events[i] = events[(i - 1) / 2];
+		i = (i - 1) / 2;
+	}
+
+	events[i] = new_event;
+
+	return ESP_OK;
+}
+
+void sim_kernel_run(int64_t until)
+{
+	for(;;)
+	{
+		sim_task_t * task = next_ready();
+
+		if(task != NULL)
+		{
+			current = task;
+			switches++;
+			swapcontext(&scheduler_context, &task->context);
+			current = NULL;
+
+			reap();
+			continue;
+		}
+
+		/* Every task is blocked, jump to the next thing that happens */
+		int64_t wake_time = next_wake_time();
+
+		if(events_num > 0 && events[0].time < wake_time)
+			wake_time = events[0].time;
+
+		if(wake_time > until || wake_time == INT64_MAX)
+		{
+			if(until != SIM_KERNEL_FOREVER)
+				set_time(until);
+
+			return;
+		}
+
+		set_time(wake_time);
+
+		/* Events first, a task whose timeout expires at the same time sees what they did */
+		while(events_num > 0 && events[0].time <= now)
+		{
+			event_t event;
+			events_pop(&event);
+			event.event(event.arg);
+		}
+
+		for(sim_task_t * t = tasks; t != NULL; t = t->next)
+		{
+			if(t->state == SIM_TASK_BLOCKED && t->wake_time <= now)
+			{
+				t->timed_out = true;
+				sim_kernel_unblock(t);
+			}
+		}
+	}
+}
+
+int64_t sim_kernel_now(void)
+{
+	return now;
+}
+
+uint64_t sim_kernel_switches(void)
+{
+	return switches;
+}
+
+sim_task_t * sim_kernel_current(void)
+{
+	return current;
+}
+
+sim_task_t * sim_kernel_tasks(void)
+{
+	return tasks;
+}
+
+void sim_kernel_add(sim_task_t * task)
+{
+	sim_task_t * * last = &tasks;
+
+	while(* last != NULL)
+		last = &(* last)->next;
+
+	task->next = NULL;
+	* last = task;
+
+	sim_kernel_unblock(task);
+	sim_kernel_preempt();
+}
+
+bool sim_kernel_block(sim_wait_e wait, const void * object, int64_t wake_time)
+{
+	sim_task_t * task = current;
+
+	/* Blocking is only possible from a task */
+	configASSERT(task != NULL);
+
+	task->state = SIM_TASK_BLOCKED;
+	task->wait = wait;
+	task->wait_object = object;
+	task->wake_time = wake_time;
+	task->block_order = ++order;
+	task->timed_out = false;
+
+	swapcontext(&task->context, &scheduler_context);
+
+	return !task->timed_out;
+}
+
+void sim_kernel_unblock(sim_task_t * task)
+{
+	task->state = SIM_TASK_READY;
+	task->wait = SIM_WAIT_NONE;
+	task->wait_object = NULL;
+	task->wake_time = INT64_MAX;
+	task->ready_order = ++order;
+}
+
+sim_task_t * sim_kernel_waiter(sim_wait_e wait, const void * object)
+{
+	sim_task_t * waiter = NULL;
+
+	for(sim_task_t * t = tasks; t != NULL; t = t->next)
+	{
+		if(t->state != SIM_TASK_BLOCKED || t->wait != wait || t->wait_object != object)
+			continue;
+
+		if(waiter == NULL || t->priority > waiter->priority ||
+				(t->priority == waiter->priority && t->block_order < waiter->block_order))
+			waiter = t;
+	}
+
+	return waiter;
+}
+
+void sim_kernel_preempt(void)
+{
+	if(current == NULL)
+		return;
+
+	sim_task_t * task = next_ready();
+
+	if(task == NULL || task->priority <= current->priority)
+		return;
+
+	/* A preempted task keeps its place ahead of the other ready tasks of its priority */
+	current->ready_order = -(++order);
+
+	swapcontext(&current->context, &scheduler_context);
+}
+
+void sim_kernel_exit(void)
+{
+	current->state = SIM_TASK_DELETED;
+
+	setcontext(&scheduler_context);
+}
+
+int64_t sim_kernel_wake_time(TickType_t ticks)
+{
+	if(ticks == portMAX_DELAY)
+		return INT64_MAX;
+
+	return (now / SIM_TICK_US + ticks) * SIM_TICK_US;
+}
+
+void vPortYield(void)
+{
+	if(current == NULL)
+		return;
+
+	/* Go behind the other ready tasks of the same priority */
+	current->ready_order = ++order;
+
+	swapcontext(&current->context, &scheduler_context);
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static sim_task_t * next_ready(void)
+{
+	sim_task_t * ready = NULL;
+
+	for(sim_task_t * t = tasks; t != NULL; t = t->next)
+	{
+		if(t->state != SIM_TASK_READY)
+			continue;
+
+		if(ready == NULL || t->priority > ready->priority ||
+				(t->priority == ready->priority && t->ready_order < ready->ready_order))
+			ready = t;
+	}
+
+	return ready;
+}
+
+static int64_t next_wake_time(void)
+{
+	int64_t wake_time = INT64_MAX;
+
+	for(sim_task_t * t = tasks; t != NULL; t = t->next)
+	{
+		if(t->state == SIM_TASK_BLOCKED && t->wake_time < wake_time)
+			wake_time = t->wake_time;
+	}
+
+	return wake_time;
+}
+
+static void set_time(int64_t time)
+{
+	now = time;
+
+	if(clock_hook != NULL)
+		clock_hook(now);
+}
+
+static void reap(void)
+{
+	sim_task_t * * t = &tasks;
+
+	while(* t != NULL)
+	{
+		if((* t)->state == SIM_TASK_DELETED)
+		{
+			sim_task_t * deleted = * t;
+			* t = deleted->next;
+
+			free(deleted->stack);
+			free(deleted);
+		}
+		else
+			t = &(* t)->next;
+	}
+}
+
+static bool event_before(const event_t * a, const event_t * b)
+{
+	return a->time < b->time || (a->time == b->time && a->order < b->order);
+}
+
+static void events_pop(event_t * event)
+{
+	* event = events[0];
+
+	/* Sift down the last event from the root */
+	event_t last = events[--events_num];
+	size_t i = 0;
+
+	for(;;)
+	{
+		size_t child = 2 * i + 1;
+
+		if(child >= events_num)
+			break;
+
+		if(child + 1 < events_num && event_before(&events[child + 1], &events[child]))
+			child++;
+
+		if(!event_before(&events[child], &last))
+			break;
+
+		events[i] = events[child];
+		i = child;
+	}
+
+	if(events_num > 0)
+		events[i] = last;
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,263 @@
+/*
+ * tasks.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "sim_kernel_private.h"
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static void task_entry(void);
+
+/* external functions definition ---------------------------------------------*/
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode, const char * const pcName, const uint32_t usStackDepth,
+		void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pvCreatedTask, const BaseType_t xCoreID)
+{
+	sim_task_t * task = calloc(1, sizeof(sim_task_t));
+
+	if(task == NULL)
+		return pdFAIL;
+
+	task->stack = malloc(SIM_STACK_SIZE);
+
+	if(task->stack == NULL)
+	{
+		free(task);
+		return pdFAIL;
+	}
+
+	task->function = pvTaskCode;
+	task->arg = pvParameters;
+	task->priority = uxPriority < configMAX_PRIORITIES ? uxPriority : configMAX_PRIORITIES - 1;
+
+	if(pcName != NULL)
+		strncpy(task->name, pcName, configMAX_TASK_NAME_LEN - 1);
+
+	getcontext(&task->context);
+	task->context.uc_stack.ss_sp = task->stack;
+	task->context.uc_stack.ss_size = SIM_STACK_SIZE;
+	task->context.uc_link = NULL;
+	makecontext(&task->context, task_entry, 0);
+
+	if(pvCreatedTask != NULL)
+		* pvCreatedTask = task;
+
+	sim_kernel_add(task);
+
+	return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pvTaskCode, const char * const pcName, const uint32_t usStackDepth,
+		void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pvCreatedTask)
+{
+	return xTaskCreatePinnedToCore(pvTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pvCreatedTask, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete)
+{
+	sim_task_t * current = sim_kernel_current();
+
+	if(xTaskToDelete == NULL || xTaskToDelete == current)
+		sim_kernel_exit();
+
+	/* Freed by the scheduler once the current task leaves */
+	xTaskToDelete->state = SIM_TASK_DELETED;
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay)
+{
+	if(xTicksToDelay == 0)
+	{
+		vPortYield();
+		return;
+	}
+
+	sim_kernel_block(SIM_WAIT_DELAY, NULL, sim_kernel_wake_time(xTicksToDelay));
+}
+
+void vTaskDelayUntil(TickType_t * const pxPreviousWakeTime, const TickType_t xTimeIncrement)
+{
+	TickType_t now = xTaskGetTickCount();
+	TickType_t wake = * pxPreviousWakeTime + xTimeIncrement;
+
+	* pxPreviousWakeTime = wake;
+
+	/* The wake time already passed when the loop overran its period */
+	if((int32_t)(wake - now) > 0)
+		sim_kernel_block(SIM_WAIT_DELAY, NULL, sim_kernel_wake_time(wake - now));
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+	return (TickType_t)(sim_kernel_now() / SIM_TICK_US);
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+	return xTaskGetTickCount();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+	return sim_kernel_current();
+}
+
+char * pcTaskGetName(TaskHandle_t xTaskToQuery)
+{
+	sim_task_t * task = xTaskToQuery != NULL ? xTaskToQuery : sim_kernel_current();
+
+	return task != NULL ? task->name : NULL;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t xTask)
+{
+	sim_task_t * task = xTask != NULL ? xTask : sim_kernel_current();
+
+	return task != NULL ? task->priority : tskIDLE_PRIORITY;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+	UBaseType_t num = 0;
+
+	for(sim_task_t * t = sim_kernel_tasks(); t != NULL; t = t->next)
+	{
+		if(t->state != SIM_TASK_DELETED)
+			num++;
+	}
+
+	return num;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction)
+{
+	BaseType_t ret = xTaskNotifyFromISR(xTaskToNotify, ulValue, eAction, NULL);
+
+	sim_kernel_preempt();
+
+	return ret;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, BaseType_t * pxHigherPriorityTaskWoken)
+{
+	switch(eAction)
+	{
+		case eSetBits:
+			xTaskToNotify->notify_value |= ulValue;
+			break;
+
+		case eIncrement:
+			xTaskToNotify->notify_value++;
+			break;
+
+		case eSetValueWithoutOverwrite:
+			if(xTaskToNotify->notify_pending)
+				return pdFAIL;
+
+			xTaskToNotify->notify_value = ulValue;
+			break;
+
+		case eSetValueWithOverwrite:
+			xTaskToNotify->notify_value = ulValue;
+			break;
+
+		default:
+			break;
+	}
+
+	xTaskToNotify->notify_pending = true;
+
+	if(xTaskToNotify->state == SIM_TASK_BLOCKED && xTaskToNotify->wait == SIM_WAIT_NOTIFY)
+	{
+		sim_kernel_unblock(xTaskToNotify);
+
+		if(pxHigherPriorityTaskWoken != NULL)
+			* pxHigherPriorityTaskWoken = pdTRUE;
+	}
+
+	return pdPASS;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t * pulNotificationValue, TickType_t xTicksToWait)
+{
+	sim_task_t * task = sim_kernel_current();
+
+	if(!task->notify_pending)
+	{
+		task->notify_value &= ~ulBitsToClearOnEntry;
+
+		if(xTicksToWait != 0)
+			sim_kernel_block(SIM_WAIT_NOTIFY, NULL, sim_kernel_wake_time(xTicksToWait));
+	}
+
+	if(pulNotificationValue != NULL)
+		* pulNotificationValue = task->notify_value;
+
+	if(!task->notify_pending)
+		return pdFALSE;
+
+	task->notify_value &= ~ulBitsToClearOnExit;
+	task->notify_pending = false;
+
+	return pdTRUE;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+	return xTaskNotify(xTaskToNotify, 0, eIncrement);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t * pxHigherPriorityTaskWoken)
+{
+	xTaskNotifyFromISR(xTaskToNotify, 0, eIncrement, pxHigherPriorityTaskWoken);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+	sim_task_t * task = sim_kernel_current();
+	int64_t wake_time = sim_kernel_wake_time(xTicksToWait);
+
+	while(task->notify_value == 0 && xTicksToWait != 0)
+	{
+		if(!sim_kernel_block(SIM_WAIT_NOTIFY, NULL, wake_time))
+			break;
+	}
+
+	uint32_t value = task->notify_value;
+
+	if(value != 0)
+		task->notify_value = xClearCountOnExit ? 0 : value - 1;
+
+	task->notify_pending = false;
+
+	return value;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static void task_entry(void)
+{
+	sim_task_t * task = sim_kernel_current();
+
+	task->function(task->arg);
+
+	/* Returning from a task is an error on FreeRTOS, here it just deletes the task */
+	sim_kernel_exit();
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,263 @@
+/*
+ * timers.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "sim_kernel_private.h"
+#include "freertos/timers.h"
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+struct sim_timer
+{
+	char name[configMAX_TASK_NAME_LEN];
+	TickType_t period;
+	bool auto_reload;
+	void * id;
+	TimerCallbackFunction_t callback;
+	bool active;
+	bool deleted;
+	uint32_t generation;		/*!< Incremented by every command, expiries of older ones are stale */
+	int64_t expiry;				/*!< Virtual time of the next expiry in microseconds */
+	uint32_t pending;			/*!< Expiry events scheduled and not run yet */
+	bool expired;				/*!< Waiting in the expired list for the service task */
+	struct sim_timer * next_expired;
+};
+
+typedef struct
+{
+	struct sim_timer * timer;
+	uint32_t generation;
+} expiry_t;
+
+/* internal data declaration -------------------------------------------------*/
+
+static TaskHandle_t service_task = NULL;
+static struct sim_timer * expired_head = NULL;
+static struct sim_timer * expired_tail = NULL;
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static BaseType_t start(TimerHandle_t timer);
+static void expiry_event(void * arg);
+static void release(TimerHandle_t timer);
+static void service(void * arg);
+
+/* external functions definition ---------------------------------------------*/
+
+TimerHandle_t xTimerCreate(const char * const pcTimerName, const TickType_t xTimerPeriodInTicks,
+		const UBaseType_t uxAutoReload, void * const pvTimerID, TimerCallbackFunction_t pxCallbackFunction)
+{
+	if(xTimerPeriodInTicks == 0 || pxCallbackFunction == NULL)
+		return NULL;
+
+	/* The service task is created with the first timer, as the FreeRTOS scheduler would at start */
+	if(service_task == NULL &&
+	   xTaskCreate(service, "Tmr Svc", configMINIMAL_STACK_SIZE * 2, NULL, configTIMER_TASK_PRIORITY, &service_task) != pdPASS)
+		return NULL;
+
+	struct sim_timer * timer = calloc(1, sizeof(struct sim_timer));
+
+	if(timer == NULL)
+		return NULL;
+
+	if(pcTimerName != NULL)
+		strncpy(timer->name, pcTimerName, configMAX_TASK_NAME_LEN - 1);
+
+	timer->period = xTimerPeriodInTicks;
+	timer->auto_reload = uxAutoReload != pdFALSE;
+	timer->id = pvTimerID;
+	timer->callback = pxCallbackFunction;
+
+	return timer;
+}
+
+BaseType_t xTimerStart(TimerHandle_t xTimer, TickType_t xTicksToWait)
+{
+	return start(xTimer);
+}
+
+BaseType_t xTimerStop(TimerHandle_t xTimer, TickType_t xTicksToWait)
+{
+	xTimer->generation++;
+	xTimer->active = false;
+
+	return pdPASS;
+}
+
+BaseType_t xTimerReset(TimerHandle_t xTimer, TickType_t xTicksToWait)
+{
+	return start(xTimer);
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t xTimer, TickType_t xNewPeriod, TickType_t xTicksToWait)
+{
+	if(xNewPeriod == 0)
+		return pdFAIL;
+
+	/* FreeRTOS starts a dormant timer when its period changes */
+	xTimer->period = xNewPeriod;
+
+	return start(xTimer);
+}
+
+BaseType_t xTimerDelete(TimerHandle_t xTimer, TickType_t xTicksToWait)
+{
+	xTimer->generation++;
+	xTimer->active = false;
+	xTimer->deleted = true;
+	release(xTimer);
+
+	return pdPASS;
+}
+
+BaseType_t xTimerStartFromISR(TimerHandle_t xTimer, BaseType_t * pxHigherPriorityTaskWoken)
+{
+	return start(xTimer);
+}
+
+BaseType_t xTimerStopFromISR(TimerHandle_t xTimer, BaseType_t * pxHigherPriorityTaskWoken)
+{
+	return xTimerStop(xTimer, 0);
+}
+
+BaseType_t xTimerResetFromISR(TimerHandle_t xTimer, BaseType_t * pxHigherPriorityTaskWoken)
+{
+	return start(xTimer);
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t xTimer)
+{
+	return xTimer->active ? pdTRUE : pdFALSE;
+}
+
+void * pvTimerGetTimerID(const TimerHandle_t xTimer)
+{
+	return xTimer->id;
+}
+
+TickType_t xTimerGetPeriod(TimerHandle_t xTimer)
+{
+	return xTimer->period;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static BaseType_t start(TimerHandle_t timer)
+{
+	expiry_t * expiry = malloc(sizeof(expiry_t));
+
+	if(expiry == NULL)
+		return pdFAIL;
+
+	timer->generation++;
+	timer->active = true;
+	timer->expiry = sim_kernel_wake_time(timer->period);
+
+	expiry->timer = timer;
+	expiry->generation = timer->generation;
+
+	if(sim_kernel_schedule(timer->expiry, expiry_event, expiry) != ESP_OK)
+	{
+		free(expiry);
+		timer->active = false;
+		return pdFAIL;
+	}
+
+	timer->pending++;
+
+	return pdPASS;
+}
+
+static void expiry_event(void * arg)
+{
+	expiry_t * expiry = (expiry_t *)arg;
+	struct sim_timer * timer = expiry->timer;
+
+	timer->pending--;
+
+	if(expiry->generation != timer->generation || !timer->active)
+	{
+		free(expiry);
+		release(timer);
+		return;
+	}
+
+	/* Auto reload timers keep their phase, the next expiry is one period after this one */
+	if(timer->auto_reload)
+	{
+		timer->expiry += (int64_t)timer->period * SIM_TICK_US;
+
+		if(sim_kernel_schedule(timer->expiry, expiry_event, expiry) == ESP_OK)
+			timer->pending++;
+		else
+		{
+			free(expiry);
+			timer->active = false;
+		}
+	}
+	else
+	{
+		free(expiry);
+		timer->active = false;
+	}
+
+	/* Hand the callback to the service task, an expiry it did not run yet is not queued twice */
+	if(!timer->expired)
+	{
+		timer->expired = true;
+		timer->next_expired = NULL;
+
+		if(expired_tail != NULL)
+			expired_tail->next_expired = timer;
+		else
+			expired_head = timer;
+
+		expired_tail = timer;
+	}
+
+	vTaskNotifyGiveFromISR(service_task, NULL);
+}
+
+static void release(TimerHandle_t timer)
+{
+	/* Deleted timers are freed once nothing refers to them any more */
+	if(timer->deleted && timer->pending == 0 && !timer->expired)
+		free(timer);
+}
+
+static void service(void * arg)
+{
+	for(;;)
+	{
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+		while(expired_head != NULL)
+		{
+			struct sim_timer * timer = expired_head;
+			expired_head = timer->next_expired;
+
+			if(expired_head == NULL)
+				expired_tail = NULL;
+
+			timer->expired = false;
+
+			if(timer->deleted)
+				release(timer);
+			else
+				timer->callback(timer);
+		}
+	}
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,60 @@
+/*
+ * test.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdarg.h>
+
+#include "test.h"
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static char note_buf[TEST_NOTE_SIZE];
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+/* external functions definition ---------------------------------------------*/
+
+int test_run(const char * suite, const test_case_t * cases, size_t cases_num)
+{
+	int failures = 0;
+
+	for(size_t i = 0; i < cases_num; i++)
+	{
+		const char * note = "";
+		bool passed = cases[i].run(&note);
+
+		printf("%s: %-13s %s\n", suite, cases[i].name, passed ? note : "FAIL");
+
+		if(!passed)
+			failures++;
+	}
+
+	return failures;
+}
+
+const char * test_note(const char * format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	vsnprintf(note_buf, sizeof(note_buf), format, args);
+	va_end(args);
+
+	return note_buf;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* end of file ---------------------------------------------------------------*/
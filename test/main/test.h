@@ -0,0 +1,80 @@
+/*
+ * test.h
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ */
+
+#ifndef _TEST_H_
+#define _TEST_H_
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* macros --------------------------------------------------------------------*/
+
+#define TEST_NOTE_SIZE		160			/*!< Longest note of a case */
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef struct
+{
+	const char * name;
+	bool (* run)(const char * * note);	/*!< Returns true if it passed, the note tells what it checked */
+} test_case_t;
+
+typedef struct
+{
+	const char * name;						/*!< Prefix of its output lines and argument selecting it */
+	int (* run)(int argc, char * argv[]);	/*!< Returns the number of failed cases */
+	bool tool;								/*!< Only run when selected, with its own arguments */
+} test_suite_t;
+
+/* external data declaration -------------------------------------------------*/
+
+/* external functions declaration --------------------------------------------*/
+
+/* Run the cases in order, printing a line per case with its note or FAIL. Returns the number of
+ * failed cases */
+int test_run(const char * suite, const test_case_t * cases, size_t cases_num);
+
+/* Format the note of a case. The buffer is shared, it holds the last note only */
+const char * test_note(const char * format, ...) __attribute__((format(printf, 1, 2)));
+
+/* Suites, one per component */
+int test_latency(int argc, char * argv[]);
+int test_ws2812_led(int argc, char * argv[]);
+int test_button(int argc, char * argv[]);
+int test_input(int argc, char * argv[]);
+int test_relay(int argc, char * argv[]);
+int test_rules(int argc, char * argv[]);
+int test_monitor(int argc, char * argv[]);
+int test_ota(int argc, char * argv[]);
+int test_delta(int argc, char * argv[]);
+int test_fleet(int argc, char * argv[]);
+int test_settings(int argc, char * argv[]);
+int test_meter(int argc, char * argv[]);
+int test_energy(int argc, char * argv[]);
+int test_series(int argc, char * argv[]);
+int test_clock(int argc, char * argv[]);
+
+/* cplusplus -----------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+
+/* end of file ---------------------------------------------------------------*/
+
+#endif /* #ifndef _TEST_H_ */
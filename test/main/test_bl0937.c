@@ -0,0 +1,806 @@
+/*
+ * test_bl0937.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ *
+ * Precision of the BL0937 calibration against a reference load. Every trial is
+ * a device with its own errors on the voltage divider, the shunt, the reference
+ * voltage and the gain of each output, within the component tolerance. Its CF
+ * and CF1 pulses, with noise on their widths and a random phase after every SEL
+ * switch, drive the real ISRs of the bl0937 component through the HAL fakes
+ * with the interrupt latency added, and the readings period calls the
+ * calibration as measure_task does. Each precision reports the trials that
+ * reached it, the time they took and the error of the calibrated multipliers
+ * to the ideal ones of the device, against the error of the nominal ones.
+ *
+ * The drift trials follow the same devices through a day of the chip
+ * temperature, the night ambient, the load heating the enclosure and the noise
+ * of the sensor read through the HAL. Each is calibrated at the morning
+ * temperature, and the error of its readings to its own drift is reported
+ * with the base multipliers and with the bl0937_drift corrections, for a curve
+ * that matches it, one that only matches it on its points, the curve of the
+ * fleet and a BL0937 slower to heat than the sensor.
+ *
+ * The power factor trials take calibrated devices under resistive, inductive
+ * and switch-mode loads, the last ones with a ripple of their current and a
+ * burst mode. Every reading period the power factor of bl0937_estimate() is
+ * compared to the one of the load, as is the one of the separate voltage,
+ * current and active power readings, and its confidence is reported with the
+ * error of the readings it trusted:
+ *
+ *     smartLight_test.elf meter
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+
+#include "esp_log.h"
+#include "bl0937.h"
+#include "bl0937_drift.h"
+#include "bitec_hal_linux.h"
+#include "test.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#ifdef CONFIG_METER_TRIALS
+#define TRIALS				CONFIG_METER_TRIALS
+#else
+#define TRIALS				200
+#endif
+
+#ifdef CONFIG_METER_TOLERANCE
+#define TOLERANCE			(CONFIG_METER_TOLERANCE / 1000.0)
+#else
+#define TOLERANCE			0.01
+#endif
+
+#ifdef CONFIG_METER_NOISE
+#define NOISE				(CONFIG_METER_NOISE / 10000.0)
+#else
+#define NOISE				0.002
+#endif
+
+#ifdef CONFIG_METER_LATENCY
+#define LATENCY				CONFIG_METER_LATENCY
+#else
+#define LATENCY				20
+#endif
+
+#ifdef CONFIG_METER_SENSOR_NOISE
+#define SENSOR_NOISE		(CONFIG_METER_SENSOR_NOISE / 10.0)
+#else
+#define SENSOR_NOISE		0.5
+#endif
+
+#define SEL_PIN				11
+#define CF1_PIN				12
+#define CF_PIN				13
+#define R_VOLTAGE			1981		/*!< As the board */
+#define R_CURRENT			0.001		/*!< In Ohm */
+#define K_CF				1721506.0	/*!< BL0937 datasheet transfer functions */
+#define K_CFI				94638.0
+#define K_CFU				15397.0
+#define VOLTAGE				230.0		/*!< Reference load, as the Kconfig default */
+#define CURRENT				0.435
+#define POWER				(VOLTAGE * CURRENT)
+#define MEASURE_TIME		500000		/*!< Readings period in us, as the measure_time default */
+#define START_TIME			1000000		/*!< Calibration start after power on in us */
+#define LATENCY_LONG		100			/*!< One in this many interrupts is late ten times longer */
+#define DAY					86400		/*!< Drift trial length in s */
+#define SAMPLE_PERIOD		10			/*!< Temperature samples in s, as the drift_period default */
+#define WARM_UP				600			/*!< Before the calibration in s */
+#define AMBIENT				22.0		/*!< Mean and swing of the day in Celsius */
+#define AMBIENT_SWING		6.0
+#define SELF_HEATING		5.0			/*!< Of the chip over the ambient, idle and with the load */
+#define LOAD_HEATING		25.0
+#define CHIP_TAU			1200.0		/*!< Enclosure time constant in s */
+#define SENSOR_OFFSET		1.0			/*!< Largest error of the sensor in Celsius */
+#define LINEAR_VOLTAGE		-60e-6		/*!< Drift of the multipliers per K from 25 Celsius */
+#define LINEAR_CURRENT		180e-6
+#define QUADRATIC_VOLTAGE	-1.5e-6		/*!< And per K squared */
+#define QUADRATIC_CURRENT	3e-6
+#define LOAD_TIME			30			/*!< Power factor trial length in s */
+#define LOAD_START			2			/*!< First reading taken in s */
+#define CONFIDENT			0.5			/*!< Confidence of a trusted reading */
+
+/* typedef -------------------------------------------------------------------*/
+
+/* A load, its current and active power to the ones of the reference */
+typedef struct
+{
+	const char * name;
+	double power_factor;	/*!< Of the fundamental and the harmonics */
+	double ripple;			/*!< Relative swing of the current */
+	double period;			/*!< Of the ripple in s */
+	bool burst;				/*!< A square ripple, not a sine */
+} load_t;
+
+/* A square wave output, both edges reach the ISR */
+typedef struct
+{
+	int pin;
+	int channel;			/*!< Its frequency is of */
+	uint32_t level;
+	double next;			/*!< Time of the next edge in us, INFINITY while stopped */
+} output_t;
+
+/* A device, its outputs and the ideal multipliers of its components */
+typedef struct
+{
+	double frequencies[BL0937_CHANNEL_MAX];	/*!< CF1 with SEL high and low, and CF in Hz */
+	double ideal[BL0937_CHANNEL_MAX];		/*!< Reference value times the mean pulse width */
+	const load_t * load;					/*!< NULL for the reference one */
+	output_t cf;
+	output_t cf1;
+	double now;
+} device_t;
+
+typedef struct
+{
+	uint32_t precision;		/*!< In ppm */
+	uint32_t converged;
+	uint32_t failed;		/*!< Ended with an error, or a multiplier out of range */
+	double time;			/*!< Sum of the calibration times of the converged trials in s */
+	double time_max;
+	double error[BL0937_CHANNEL_MAX];		/*!< Sum of the squared relative errors */
+	double error_max[BL0937_CHANNEL_MAX];
+} result_t;
+
+/* A drift trial, the drift of the devices and the curve they are corrected with */
+typedef struct
+{
+	const char * name;
+	bool quadratic;			/*!< Of the devices, the curve only holds on its points */
+	double mismatch;		/*!< Largest error of the curve to the linear drift of each device */
+	double lag;				/*!< Time constant in s of the BL0937 behind the sensor, 0 for none */
+} scenario_t;
+
+/* The readings error, with the base multipliers and with the corrected ones */
+typedef struct
+{
+	double error[2][BL0937_CHANNEL_MAX];	/*!< Sum of the squared relative errors */
+	double error_max[2][BL0937_CHANNEL_MAX];
+	uint32_t samples;
+	uint32_t updates;
+} drift_result_t;
+
+/* Power factor error of the readings and of the estimate */
+typedef struct
+{
+	double error[2];		/*!< Sum of the squared errors */
+	double error_max[2];
+	double confidence;		/*!< Sum of the confidences */
+	double confident_error;	/*!< Sum of the squared errors of the trusted estimates */
+	uint32_t confident;
+	uint32_t samples;
+} load_result_t;
+
+/* internal data declaration -------------------------------------------------*/
+
+static const uint32_t precisions[] = { 2000, 1000, 500, 200, 100, 50 };
+
+#define PRECISION_MAX		(sizeof(precisions) / sizeof(precisions[0]))
+
+static const char * const channel_names[BL0937_CHANNEL_MAX] = { "voltage", "current", "power" };
+
+static const scenario_t scenarios[] =
+{
+	{ "linear", false, 0, 0 },
+	{ "quadratic", true, 0, 0 },
+	{ "fleet", false, 0.25, 0 },
+	{ "lag", false, 0, 600 },
+};
+
+#define SCENARIO_MAX		(sizeof(scenarios) / sizeof(scenarios[0]))
+
+/* Of the curves, at least two of them below the morning temperature and above the load heating */
+static const float curve_temperatures[] = { 0, 25, 50, 75 };
+
+#define CURVE_POINTS		(sizeof(curve_temperatures) / sizeof(curve_temperatures[0]))
+
+static const load_t loads[] =
+{
+	{ "resistive", 1.0, 0, 0, false },
+	{ "inductive", 0.7, 0.02, 1.7, false },
+	{ "smps", 0.6, 0.05, 0.9, false },
+	{ "burst", 0.6, 0.4, 0.7, true },
+};
+
+#define LOAD_MAX			(sizeof(loads) / sizeof(loads[0]))
+
+static result_t results[PRECISION_MAX];
+static double nominal_error[BL0937_CHANNEL_MAX];	/*!< Largest relative error of the nominal multipliers */
+static bl0937_t bl0937;
+static device_t device;
+static uint32_t seed;
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static esp_err_t run_trial(uint32_t precision, bl0937_calibration_t * cal);
+static void device_init(device_t * me, const load_t * load);
+static double device_frequency(const device_t * me, int channel, double time);
+static void device_run(device_t * me, double until);
+static void output_edge(device_t * me, output_t * output);
+static void sel_hook(int pin, uint32_t level, void * arg);
+static bool profile_check(void);
+static void drift_trial(const scenario_t * scenario, drift_result_t * result);
+static double drift_of(const double linear[2], const double quadratic[2], int channel, double celsius);
+static bool curve_check(void);
+static void load_trial(const load_t * load, load_result_t * result);
+static double uniform_random(double range);
+static double gauss_random(void);
+static uint32_t random_next(void);
+
+/* external functions definition ---------------------------------------------*/
+
+int test_meter(int argc, char * argv[])
+{
+	bl0937_calibration_t cal;
+
+	/* Every trial logs its initialization */
+	esp_log_level_set("*", ESP_LOG_WARN);
+
+	printf("meter: %u trials, %.1f %% tolerance, %.2f %% pulse noise, %u us ISR latency, %.0f V %.3f A %.1f W reference\n",
+			TRIALS, TOLERANCE * 100, NOISE * 100, LATENCY, VOLTAGE, CURRENT, POWER);
+	printf("meter: %-9s %9s %6s %7s %7s %21s %21s %21s\n", "precision", "converged", "failed", "mean s", "max s",
+			"voltage rms/max %", "current rms/max %", "power rms/max %");
+
+	for(size_t i = 0; i < PRECISION_MAX; i++)
+	{
+		result_t * result = &results[i];
+
+		result->precision = precisions[i];
+		seed = 0x2545F491;
+
+		for(uint32_t j = 0; j < TRIALS; j++)
+		{
+			if(run_trial(precisions[i], &cal) != ESP_OK)
+			{
+				result->failed += cal.error != ESP_ERR_TIMEOUT;
+				continue;
+			}
+
+			double time = cal.updates * MEASURE_TIME / 1e6;
+
+			result->converged++;
+			result->time += time;
+			result->time_max = time > result->time_max ? time : result->time_max;
+
+			const float multipliers[BL0937_CHANNEL_MAX] =
+			{
+				bl0937.voltage_multiplier, bl0937.current_multiplier, bl0937.power_multiplier
+			};
+
+			for(int k = 0; k < BL0937_CHANNEL_MAX; k++)
+			{
+				double error = fabs(multipliers[k] / device.ideal[k] - 1);
+
+				result->error[k] += error * error;
+				result->error_max[k] = error > result->error_max[k] ? error : result->error_max[k];
+			}
+		}
+
+		printf("meter: %5" PRIu32 " ppm %8.1f%% %6" PRIu32 " %7.1f %7.1f", result->precision,
+				100.0 * result->converged / TRIALS, result->failed,
+				result->converged > 0 ? result->time / result->converged : 0, result->time_max);
+
+		for(int k = 0; k < BL0937_CHANNEL_MAX; k++)
+		{
+			if(result->converged == 0)
+				printf(" %21s", "-");
+			else
+				printf("       %6.3f / %6.3f", sqrt(result->error[k] / result->converged) * 100, result->error_max[k] * 100);
+		}
+
+		printf("\n");
+	}
+
+	printf("meter: nominal multipliers, largest error");
+
+	for(int k = 0; k < BL0937_CHANNEL_MAX; k++)
+		printf(" %s %.1f %%", channel_names[k], nominal_error[k] * 100);
+
+	printf("\n");
+
+	/* The calibration outlives a restart */
+	bool restored = profile_check();
+
+	printf("meter: profile %s\n", restored ? "saved and restored" : "NOT RESTORED");
+
+	printf("meter: drift, %u trials of a day, %.1f C sensor noise, %.1f C offset, %.0f C load heating\n",
+			TRIALS, SENSOR_NOISE, SENSOR_OFFSET, LOAD_HEATING);
+	printf("meter: %-9s %-11s %21s %21s %21s %9s\n", "curve", "multipliers", "voltage rms/max %", "current rms/max %",
+			"power rms/max %", "updates/h");
+
+	for(size_t i = 0; i < SCENARIO_MAX; i++)
+	{
+		drift_result_t result = { 0 };
+
+		seed = 0x2545F491;
+
+		for(uint32_t j = 0; j < TRIALS; j++)
+			drift_trial(&scenarios[i], &result);
+
+		for(int k = 0; k < 2; k++)
+		{
+			printf("meter: %-9s %-11s", k == 0 ? scenarios[i].name : "", k == 0 ? "base" : "corrected");
+
+			for(int l = 0; l < BL0937_CHANNEL_MAX; l++)
+				printf("       %6.3f / %6.3f", sqrt(result.error[k][l] / result.samples) * 100, result.error_max[k][l] * 100);
+
+			if(k == 0)
+				printf(" %9s\n", "-");
+			else
+				printf(" %9.1f\n", result.updates * 3600.0 / DAY / TRIALS);
+		}
+	}
+
+	/* The curve outlives a restart too */
+	bool curve = curve_check();
+
+	printf("meter: drift curve %s\n", curve ? "saved and restored" : "NOT RESTORED");
+
+	printf("meter: power factor, %u trials of %u s, readings every %u ms\n", TRIALS, LOAD_TIME, MEASURE_TIME / 1000);
+	printf("meter: %-9s %7s %17s %17s %10s %9s %9s\n", "load", "pf", "readings rms/max", "estimate rms/max",
+			"confidence", "trusted", "rms");
+
+	for(size_t i = 0; i < LOAD_MAX; i++)
+	{
+		load_result_t result = { 0 };
+
+		seed = 0x2545F491;
+
+		for(uint32_t j = 0; j < TRIALS; j++)
+			load_trial(&loads[i], &result);
+
+		printf("meter: %-9s %7.2f", loads[i].name, loads[i].power_factor);
+
+		for(int k = 0; k < 2; k++)
+			printf("   %6.4f / %6.4f", sqrt(result.error[k] / result.samples), result.error_max[k]);
+
+		printf(" %10.3f %8.1f%% %9.4f\n", result.confidence / result.samples, 100.0 * result.confident / result.samples,
+				result.confident > 0 ? sqrt(result.confident_error / result.confident) : 0);
+	}
+
+	return !restored + !curve;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* Calibrate a new device, its multipliers are left applied on success */
+static esp_err_t run_trial(uint32_t precision, bl0937_calibration_t * cal)
+{
+	hal_linux_reset();
+	hal_linux_gpio_set_hook(sel_hook, &device);
+	device_init(&device, NULL);
+
+	bl0937.sel_pin = SEL_PIN;
+	bl0937.cf1_pin = CF1_PIN;
+	bl0937.cf_pin = CF_PIN;
+	bl0937.current_resistor = R_CURRENT;
+	bl0937.voltage_resistor = R_VOLTAGE;
+
+	if(bl0937_init(&bl0937) != ESP_OK)
+		return ESP_FAIL;
+
+	const float nominal[BL0937_CHANNEL_MAX] =
+	{
+		bl0937.voltage_multiplier, bl0937.current_multiplier, bl0937.power_multiplier
+	};
+
+	for(int k = 0; k < BL0937_CHANNEL_MAX; k++)
+	{
+		double error = fabs(nominal[k] / device.ideal[k] - 1);
+
+		nominal_error[k] = error > nominal_error[k] ? error : nominal_error[k];
+	}
+
+	/* Readings as measure_task takes them, the calibration from the start time on */
+	double reading = MEASURE_TIME;
+	bool running = false;
+
+	for(;;)
+	{
+		device_run(&device, reading);
+		hal_linux_time_set((int64_t)reading);
+
+		if(!running && reading >= START_TIME)
+		{
+			bl0937_calibration_start(cal, VOLTAGE, CURRENT, POWER);
+			cal->precision = precision / 1e6;
+			running = true;
+		}
+
+		if(running && bl0937_calibration_update(&bl0937, cal))
+			break;
+
+		bl0937_get_voltage(&bl0937);
+		bl0937_get_current(&bl0937);
+		bl0937_get_active_power(&bl0937);
+
+		reading += MEASURE_TIME;
+	}
+
+	if(cal->error != ESP_OK)
+		return cal->error;
+
+	esp_err_t ret = bl0937_calibration_apply(&bl0937, cal);
+
+	if(ret != ESP_OK)
+		cal->error = ret;
+
+	return ret;
+}
+
+/* Component errors within the tolerance, and the output frequencies they give with the reference load */
+static void device_init(device_t * me, const load_t * load)
+{
+	double ratio = R_VOLTAGE * (1 + uniform_random(TOLERANCE));
+	double shunt = R_CURRENT * (1 + uniform_random(TOLERANCE));
+	double vref = 1.218 * (1 + uniform_random(TOLERANCE));
+	double v_voltage = VOLTAGE / ratio;
+	double v_current = CURRENT * shunt;
+
+	me->frequencies[BL0937_VOLTAGE] = K_CFU * v_voltage / vref * (1 + uniform_random(TOLERANCE));
+	me->frequencies[BL0937_CURRENT] = K_CFI * v_current / vref * (1 + uniform_random(TOLERANCE));
+	me->frequencies[BL0937_POWER] = K_CF * v_voltage * v_current / (vref * vref) * (1 + uniform_random(TOLERANCE));
+
+	/* A reading is the multiplier over the width of a pulse, half a period */
+	me->ideal[BL0937_VOLTAGE] = VOLTAGE * 500000.0 / me->frequencies[BL0937_VOLTAGE];
+	me->ideal[BL0937_CURRENT] = CURRENT * 500000.0 / me->frequencies[BL0937_CURRENT];
+	me->ideal[BL0937_POWER] = POWER * 500000.0 / me->frequencies[BL0937_POWER];
+
+	me->load = load;
+	me->now = 0;
+	me->cf.pin = CF_PIN;
+	me->cf.channel = BL0937_POWER;
+	me->cf.level = 1;
+	me->cf.next = (uniform_random(0.5) + 0.5) * 500000.0 / device_frequency(me, BL0937_POWER, 0);
+	me->cf1.pin = CF1_PIN;
+	me->cf1.channel = BL0937_VOLTAGE;
+	me->cf1.level = 1;
+	me->cf1.next = INFINITY;
+
+	hal_linux_gpio_drive(CF_PIN, 1);
+	hal_linux_gpio_drive(CF1_PIN, 1);
+}
+
+/* Of an output at a time in us, the current and the active power follow the ripple of the load */
+static double device_frequency(const device_t * me, int channel, double time)
+{
+	const load_t * load = me->load;
+
+	if(load == NULL || channel == BL0937_VOLTAGE)
+		return me->frequencies[channel];
+
+	double scale = 1;
+
+	if(load->ripple > 0)
+	{
+		double phase = sin(2 * M_PI * time / 1e6 / load->period);
+
+		scale += load->ripple * (load->burst ? (phase >= 0 ? 1 : -1) : phase);
+	}
+
+	return me->frequencies[channel] * scale * (channel == BL0937_POWER ? load->power_factor : 1);
+}
+
+/* Every edge up to until, in order */
+static void device_run(device_t * me, double until)
+{
+	for(;;)
+	{
+		output_t * output = me->cf.next <= me->cf1.next ? &me->cf : &me->cf1;
+
+		if(output->next > until)
+			break;
+
+		output_edge(me, output);
+	}
+
+	me->now = until;
+}
+
+static void output_edge(device_t * me, output_t * output)
+{
+	double latency = uniform_random(0.5) * LATENCY + LATENCY / 2.0;
+
+	if(random_next() % LATENCY_LONG == 0)
+		latency *= 10;
+
+	/* The ISR runs late, the clock does not go back for the edges that follow */
+	double time = output->next + latency;
+
+	if(time > me->now)
+		me->now = time;
+
+	output->level = !output->level;
+	output->next += 500000.0 / device_frequency(me, output->channel, output->next) * (1 + NOISE * gauss_random());
+
+	hal_linux_time_set((int64_t)me->now);
+	hal_linux_gpio_drive(output->pin, output->level);
+}
+
+/* SEL picks the CF1 output, its first edge comes at any phase of the new one */
+static void sel_hook(int pin, uint32_t level, void * arg)
+{
+	device_t * me = (device_t *)arg;
+
+	if(pin != SEL_PIN)
+		return;
+
+	me->cf1.channel = (level == MODE_CURRENT) ? BL0937_CURRENT : BL0937_VOLTAGE;
+	me->cf1.next = me->now + (uniform_random(0.5) + 0.5) * 500000.0 / device_frequency(me, me->cf1.channel, me->now);
+}
+
+/* Calibrate, save and restart, the same multipliers are restored */
+static bool profile_check(void)
+{
+	bl0937_calibration_t cal;
+
+	seed = 0x2545F491;
+
+	if(run_trial(precisions[0], &cal) != ESP_OK || bl0937_calibration_save(&bl0937) != ESP_OK)
+		return false;
+
+	float multipliers[BL0937_CHANNEL_MAX] =
+	{
+		bl0937.voltage_multiplier, bl0937.current_multiplier, bl0937.power_multiplier
+	};
+
+	if(bl0937_init(&bl0937) != ESP_OK || !bl0937.calibrated)
+		return false;
+
+	if(multipliers[BL0937_VOLTAGE] != bl0937.voltage_multiplier || multipliers[BL0937_CURRENT] != bl0937.current_multiplier ||
+			multipliers[BL0937_POWER] != bl0937.power_multiplier)
+		return false;
+
+	/* Erased, back to the nominal ones */
+	return bl0937_calibration_erase(&bl0937) == ESP_OK && !bl0937.calibrated && bl0937_init(&bl0937) == ESP_OK && !bl0937.calibrated;
+}
+
+/* A device through a day, calibrated after the warm up */
+static void drift_trial(const scenario_t * scenario, drift_result_t * result)
+{
+	bl0937_drift_t drift;
+	double linear[2] = { LINEAR_VOLTAGE, LINEAR_CURRENT };
+	double quadratic[2] = { 0, 0 };
+	char buf[256];
+	int len;
+
+	hal_linux_reset();
+	device_init(&device, NULL);
+
+	if(scenario->quadratic)
+	{
+		quadratic[BL0937_VOLTAGE] = QUADRATIC_VOLTAGE;
+		quadratic[BL0937_CURRENT] = QUADRATIC_CURRENT;
+	}
+
+	/* The curve is the one of the device on its points, or the one of the fleet */
+	len = snprintf(buf, sizeof(buf), "{\"temperature\":[");
+
+	for(size_t i = 0; i < CURVE_POINTS; i++)
+		len += snprintf(buf + len, sizeof(buf) - len, "%s%.0f", i > 0 ? "," : "", curve_temperatures[i]);
+
+	for(int k = 0; k < 2; k++)
+	{
+		len += snprintf(buf + len, sizeof(buf) - len, "],\"%s\":[", channel_names[k]);
+
+		for(size_t i = 0; i < CURVE_POINTS; i++)
+			len += snprintf(buf + len, sizeof(buf) - len, "%s%.0f", i > 0 ? "," : "",
+					drift_of(linear, quadratic, k, curve_temperatures[i]) * 1e6);
+	}
+
+	len += snprintf(buf + len, sizeof(buf) - len, "]}");
+
+	bl0937_drift_init(&drift);
+
+	if(bl0937_drift_parse(&drift, buf, len) != ESP_OK)
+		return;
+
+	for(int k = 0; k < 2; k++)
+		linear[k] *= 1 + uniform_random(scenario->mismatch);
+
+	double offset = uniform_random(SENSOR_OFFSET);
+	double ambient = AMBIENT - AMBIENT_SWING;
+	double chip = ambient + SELF_HEATING;
+	double meter = chip;
+	double ideal[BL0937_CHANNEL_MAX];
+	float base[BL0937_CHANNEL_MAX];
+	float celsius;
+
+	for(int t = 0; t < WARM_UP + DAY; t += SAMPLE_PERIOD)
+	{
+		/* Coldest at the start, the load on in the morning and the evening */
+		double hour = (double)t / 3600;
+		bool load = (hour >= 7 && hour < 12) || (hour >= 18 && hour < 23);
+
+		ambient = AMBIENT - AMBIENT_SWING * cos(2 * M_PI * t / DAY);
+		chip += (ambient + (load ? LOAD_HEATING : SELF_HEATING) - chip) * SAMPLE_PERIOD / CHIP_TAU;
+		meter = scenario->lag > 0 ? meter + (chip - meter) * SAMPLE_PERIOD / scenario->lag : chip;
+
+		/* Through the HAL as measure_task reads it */
+		hal_linux_temp_set(chip + offset + SENSOR_NOISE * gauss_random());
+
+		if(hal_temp_read(&celsius) != ESP_OK)
+			return;
+
+		if(bl0937_drift_update(&bl0937, &drift, celsius) && t >= WARM_UP)
+			result->updates++;
+
+		/* The ideal multipliers of the device at its temperature, taken by the calibration */
+		for(int k = 0; k < BL0937_CHANNEL_MAX; k++)
+		{
+			double factor = k == BL0937_POWER ?
+					(1 + drift_of(linear, quadratic, BL0937_VOLTAGE, meter)) * (1 + drift_of(linear, quadratic, BL0937_CURRENT, meter)) :
+					1 + drift_of(linear, quadratic, k, meter);
+
+			ideal[k] = device.ideal[k] * factor;
+		}
+
+		if(t + SAMPLE_PERIOD == WARM_UP)
+		{
+			bl0937.voltage_multiplier = base[BL0937_VOLTAGE] = ideal[BL0937_VOLTAGE];
+			bl0937.current_multiplier = base[BL0937_CURRENT] = ideal[BL0937_CURRENT];
+			bl0937.power_multiplier = base[BL0937_POWER] = ideal[BL0937_POWER];
+			bl0937.temperature = drift.temperature;
+			bl0937_drift_rebase(&bl0937, &drift);
+		}
+
+		if(t < WARM_UP)
+			continue;
+
+		const float multipliers[BL0937_CHANNEL_MAX] =
+		{
+			bl0937.voltage_multiplier, bl0937.current_multiplier, bl0937.power_multiplier
+		};
+
+		result->samples++;
+
+		for(int k = 0; k < BL0937_CHANNEL_MAX; k++)
+		{
+			double errors[2] = { fabs(base[k] / ideal[k] - 1), fabs(multipliers[k] / ideal[k] - 1) };
+
+			for(int l = 0; l < 2; l++)
+			{
+				result->error[l][k] += errors[l] * errors[l];
+				result->error_max[l][k] = errors[l] > result->error_max[l][k] ? errors[l] : result->error_max[l][k];
+			}
+		}
+	}
+}
+
+/* A calibrated device under a load, its readings taken as measure_task does */
+static void load_trial(const load_t * load, load_result_t * result)
+{
+	bl0937_estimate_t estimate;
+
+	hal_linux_reset();
+	hal_linux_gpio_set_hook(sel_hook, &device);
+	device_init(&device, load);
+
+	bl0937.sel_pin = SEL_PIN;
+	bl0937.cf1_pin = CF1_PIN;
+	bl0937.cf_pin = CF_PIN;
+	bl0937.current_resistor = R_CURRENT;
+	bl0937.voltage_resistor = R_VOLTAGE;
+
+	if(bl0937_init(&bl0937) != ESP_OK)
+		return;
+
+	bl0937.voltage_multiplier = device.ideal[BL0937_VOLTAGE];
+	bl0937.current_multiplier = device.ideal[BL0937_CURRENT];
+	bl0937.power_multiplier = device.ideal[BL0937_POWER];
+
+	for(double reading = MEASURE_TIME; reading <= LOAD_TIME * 1e6; reading += MEASURE_TIME)
+	{
+		device_run(&device, reading);
+		hal_linux_time_set((int64_t)reading);
+
+		/* The separate readings, each of its last pulse */
+		uint16_t voltage = bl0937_get_voltage(&bl0937);
+		uint16_t current = bl0937_get_current(&bl0937);
+		uint16_t active = bl0937_get_active_power(&bl0937);
+		double apparent = voltage * current / 100.0;
+		double readings = (apparent > 0) ? fmin(active / apparent, 1) : 0;
+
+		bl0937_estimate(&bl0937, &estimate);
+
+		if(reading < LOAD_START * 1e6)
+			continue;
+
+		double errors[2] = { fabs(readings - load->power_factor), fabs(estimate.power_factor - load->power_factor) };
+
+		for(int k = 0; k < 2; k++)
+		{
+			result->error[k] += errors[k] * errors[k];
+			result->error_max[k] = errors[k] > result->error_max[k] ? errors[k] : result->error_max[k];
+		}
+
+		result->confidence += estimate.confidence;
+		result->samples++;
+
+		if(estimate.confidence >= CONFIDENT)
+		{
+			result->confident_error += errors[1] * errors[1];
+			result->confident++;
+		}
+	}
+}
+
+/* Relative drift of the voltage or current multiplier from 25 Celsius */
+static double drift_of(const double linear[2], const double quadratic[2], int channel, double celsius)
+{
+	double delta = celsius - 25;
+
+	return linear[channel] * delta + quadratic[channel] * delta * delta;
+}
+
+/* Save a curve and restart, the same curve is restored. A malformed one is not taken, an empty one erases it */
+static bool curve_check(void)
+{
+	const char * curve = "{\"temperature\":[25,45,65],\"voltage\":[0,-1200,-2600],\"current\":[0,3600,7500]}";
+	const char * descending = "{\"temperature\":[45,25],\"voltage\":[0,0],\"current\":[0,0]}";
+	bl0937_drift_t drift;
+	bl0937_drift_t restored;
+
+	hal_linux_reset();
+	bl0937_drift_init(&drift);
+	bl0937_drift_init(&restored);
+
+	if(bl0937_drift_parse(&drift, curve, strlen(curve)) != ESP_OK || bl0937_drift_save(&drift) != ESP_OK ||
+			bl0937_drift_restore(&restored) != ESP_OK || restored.points != 3)
+		return false;
+
+	for(int i = 0; i < restored.points; i++)
+	{
+		if(restored.temperatures[i] != drift.temperatures[i] ||
+				restored.corrections[BL0937_VOLTAGE][i] != drift.corrections[BL0937_VOLTAGE][i] ||
+				restored.corrections[BL0937_CURRENT][i] != drift.corrections[BL0937_CURRENT][i])
+			return false;
+	}
+
+	if(bl0937_drift_parse(&drift, descending, strlen(descending)) != ESP_ERR_INVALID_ARG || drift.points != 3)
+		return false;
+
+	bl0937_drift_clear(&drift);
+	bl0937_drift_init(&restored);
+
+	return bl0937_drift_save(&drift) == ESP_OK && bl0937_drift_restore(&restored) != ESP_OK && restored.points == 0;
+}
+
+/* Uniform in [-range, range] */
+static double uniform_random(double range)
+{
+	return range * (2.0 * random_next() / 4294967295.0 - 1);
+}
+
+/* Box-Muller, never 0 in the logarithm */
+static double gauss_random(void)
+{
+	double u = (random_next() + 1.0) / 4294967296.0;
+	double v = random_next() / 4294967296.0;
+
+	return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+/* xorshift32 */
+static uint32_t random_next(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return seed;
+}
+
+/* end of file ---------------------------------------------------------------*/
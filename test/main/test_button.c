@@ -0,0 +1,293 @@
+/*
+ * test_button.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ *
+ * Gestures of bitec_gesture_update() from recorded traces of the button. Every
+ * trace is the edges of the contact, bounces included, replayed a sample at a
+ * time at 1 ms and at the sample time of the firmware. The events must be the
+ * expected ones in order, at their exact times on the 1 ms replay and within a
+ * sample on the other: one press, release and click per press, no event for
+ * the glitches shorter than the debounce time, the hold and its repeats on
+ * time but for a press released as the hold time is reached, and two quick
+ * presses as a double click:
+ *
+ *     smartLight_test.elf button
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "bitec_gesture.h"
+#include "test.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define DEBOUNCE_TIME		30			/*!< As the Kconfig defaults, the expected events depend on them */
+#define DOUBLE_CLICK_TIME	300
+#define HOLD_TIME			1000
+#define REPEAT_TIME			500
+#define SAMPLE_TIME			10			/*!< Of the firmware, in ms */
+#define EVENTS_MAX			32
+
+#define TRACE(edges, end, events)	{ edges, sizeof(edges) / sizeof(edges[0]), end, events, sizeof(events) / sizeof(events[0]) }
+
+/* typedef -------------------------------------------------------------------*/
+
+/* The contact takes the level at the time */
+typedef struct
+{
+	uint32_t time;
+	bool pressed;
+} trace_edge_t;
+
+typedef struct
+{
+	const trace_edge_t * edges;
+	size_t edges_num;
+	uint32_t end;					/*!< Replayed until this time in ms */
+	const bitec_button_event_t * expected;
+	size_t expected_num;
+} trace_t;
+
+/* internal data declaration -------------------------------------------------*/
+
+static bitec_button_event_t events[EVENTS_MAX];
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static bool run_clicks(const char * * note);
+static bool run_glitches(const char * * note);
+static bool run_hold(const char * * note);
+static bool run_short_of_hold(const char * * note);
+static bool run_double(const char * * note);
+static bool trace_check(const trace_t * trace);
+static size_t trace_replay(const trace_t * trace, uint32_t sample, bool * idle);
+
+/* internal data definition --------------------------------------------------*/
+
+/* Three presses, each edge bouncing for a few ms */
+static const trace_edge_t clicks_edges[] =
+{
+	{ 100, true }, { 101, false }, { 102, true }, { 104, false }, { 105, true },
+	{ 220, false }, { 222, true }, { 223, false },
+	{ 1000, true }, { 1001, false }, { 1002, true }, { 1004, false }, { 1005, true },
+	{ 1120, false }, { 1122, true }, { 1123, false },
+	{ 2000, true }, { 2003, false }, { 2004, true },
+	{ 2090, false }, { 2091, true }, { 2093, false },
+};
+
+static const bitec_button_event_t clicks_events[] =
+{
+	{ BITEC_BUTTON_PRESS, 0, 105 },
+	{ BITEC_BUTTON_RELEASE, 118, 223 },
+	{ BITEC_BUTTON_CLICK, 118, 523 },
+	{ BITEC_BUTTON_PRESS, 0, 1005 },
+	{ BITEC_BUTTON_RELEASE, 118, 1123 },
+	{ BITEC_BUTTON_CLICK, 118, 1423 },
+	{ BITEC_BUTTON_PRESS, 0, 2004 },
+	{ BITEC_BUTTON_RELEASE, 89, 2093 },
+	{ BITEC_BUTTON_CLICK, 89, 2393 },
+};
+
+/* Glitches while idle, dropouts while pressed and a glitch while waiting for a second press */
+static const trace_edge_t glitches_edges[] =
+{
+	{ 100, true }, { 105, false },
+	{ 300, true }, { 329, false },
+	{ 600, true },
+	{ 800, false }, { 820, true },
+	{ 1000, false }, { 1029, true },
+	{ 1300, false },
+	{ 1400, true }, { 1410, false },
+};
+
+static const bitec_button_event_t glitches_events[] =
+{
+	{ BITEC_BUTTON_PRESS, 0, 600 },
+	{ BITEC_BUTTON_RELEASE, 700, 1300 },
+	{ BITEC_BUTTON_CLICK, 700, 1600 },
+};
+
+/* A press held for 2.6 s with a dropout in the middle */
+static const trace_edge_t hold_edges[] =
+{
+	{ 100, true }, { 101, false }, { 103, true },
+	{ 1800, false }, { 1802, true },
+	{ 2700, false }, { 2701, true }, { 2702, false },
+};
+
+static const bitec_button_event_t hold_events[] =
+{
+	{ BITEC_BUTTON_PRESS, 0, 103 },
+	{ BITEC_BUTTON_HOLD, 1000, 1103 },
+	{ BITEC_BUTTON_HOLD_REPEAT, 1500, 1603 },
+	{ BITEC_BUTTON_HOLD_REPEAT, 2000, 2103 },
+	{ BITEC_BUTTON_HOLD_REPEAT, 2500, 2603 },
+	{ BITEC_BUTTON_RELEASE, 2599, 2702 },
+};
+
+/* Released 10 ms before the hold time, the release is still debounced when it is reached */
+static const trace_edge_t short_edges[] =
+{
+	{ 100, true },
+	{ 1090, false }, { 1091, true }, { 1092, false },
+};
+
+static const bitec_button_event_t short_events[] =
+{
+	{ BITEC_BUTTON_PRESS, 0, 100 },
+	{ BITEC_BUTTON_RELEASE, 992, 1092 },
+	{ BITEC_BUTTON_CLICK, 992, 1392 },
+};
+
+/* Two presses within the double click time */
+static const trace_edge_t double_edges[] =
+{
+	{ 100, true }, { 102, false }, { 103, true },
+	{ 200, false },
+	{ 300, true }, { 301, false }, { 302, true },
+	{ 380, false }, { 382, true }, { 384, false },
+};
+
+static const bitec_button_event_t double_events[] =
+{
+	{ BITEC_BUTTON_PRESS, 0, 103 },
+	{ BITEC_BUTTON_RELEASE, 97, 200 },
+	{ BITEC_BUTTON_PRESS, 0, 302 },
+	{ BITEC_BUTTON_RELEASE, 82, 384 },
+	{ BITEC_BUTTON_DOUBLE_CLICK, 82, 384 },
+};
+
+static const trace_t clicks = TRACE(clicks_edges, 3000, clicks_events);
+static const trace_t glitches = TRACE(glitches_edges, 2000, glitches_events);
+static const trace_t hold = TRACE(hold_edges, 3500, hold_events);
+static const trace_t short_of_hold = TRACE(short_edges, 2000, short_events);
+static const trace_t double_click = TRACE(double_edges, 1000, double_events);
+
+static const test_case_t cases[] =
+{
+	{ "clicks", run_clicks },
+	{ "glitches", run_glitches },
+	{ "hold", run_hold },
+	{ "short_of_hold", run_short_of_hold },
+	{ "double", run_double },
+};
+
+/* external functions definition ---------------------------------------------*/
+
+int test_button(int argc, char * argv[])
+{
+	return test_run("button", cases, sizeof(cases) / sizeof(cases[0]));
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static bool run_clicks(const char * * note)
+{
+	*note = "3 bouncing presses, a press, release and click each";
+
+	return trace_check(&clicks);
+}
+
+static bool run_glitches(const char * * note)
+{
+	*note = test_note("glitches and dropouts up to %d ms dropped, a single click left", DEBOUNCE_TIME - 1);
+
+	return trace_check(&glitches);
+}
+
+static bool run_hold(const char * * note)
+{
+	*note = test_note("hold at %d ms, repeats every %d ms until the release, no click", HOLD_TIME, REPEAT_TIME);
+
+	return trace_check(&hold);
+}
+
+static bool run_short_of_hold(const char * * note)
+{
+	*note = "released while the hold time is reached, a click and no hold";
+
+	return trace_check(&short_of_hold);
+}
+
+static bool run_double(const char * * note)
+{
+	*note = "2 presses within the double click time, one double click and no click";
+
+	return trace_check(&double_click);
+}
+
+/* The expected events at their times on 1 ms samples, and within a sample on the ones of the firmware */
+static bool trace_check(const trace_t * trace)
+{
+	static const uint32_t samples[] = { 1, SAMPLE_TIME };
+	bool passed = true;
+
+	for(size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++)
+	{
+		bool idle;
+		size_t num = trace_replay(trace, samples[i], &idle);
+
+		passed = passed && idle && num == trace->expected_num;
+
+		for(size_t j = 0; j < num && passed; j++)
+		{
+			const bitec_button_event_t * expected = &trace->expected[j];
+
+			passed = events[j].type == expected->type && (uint32_t)abs((int)(events[j].time - expected->time)) < samples[i] &&
+					(uint32_t)abs((int)(events[j].duration - expected->duration)) < samples[i];
+		}
+
+		if(!passed)
+		{
+			printf("button: %zu events at %" PRIu32 " ms samples:", num, samples[i]);
+
+			for(size_t j = 0; j < num; j++)
+				printf(" %d/%" PRIu32 "/%" PRIu32, events[j].type, events[j].duration, events[j].time);
+
+			printf("\n");
+		}
+	}
+
+	return passed;
+}
+
+/* Every sample of the trace through the gestures as the firmware timer does, the events in order */
+static size_t trace_replay(const trace_t * trace, uint32_t sample, bool * idle)
+{
+	bitec_gesture_t gesture =
+	{
+		.debounce_time = DEBOUNCE_TIME,
+		.double_click_time = DOUBLE_CLICK_TIME,
+		.hold_time = HOLD_TIME,
+		.repeat_time = REPEAT_TIME,
+	};
+	size_t num = 0;
+	size_t edge = 0;
+	bool pressed = false;
+
+	bitec_gesture_init(&gesture, false, 0);
+
+	for(uint32_t now = sample; now <= trace->end; now += sample)
+	{
+		while(edge < trace->edges_num && trace->edges[edge].time <= now)
+			pressed = trace->edges[edge++].pressed;
+
+		num += bitec_gesture_update(&gesture, pressed, now, events + num,
+				EVENTS_MAX - num < BITEC_GESTURE_EVENTS_MAX ? EVENTS_MAX - num : BITEC_GESTURE_EVENTS_MAX);
+	}
+
+	* idle = bitec_gesture_idle(&gesture);
+
+	return num;
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,294 @@
+/*
+ * test_clock.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ *
+ * Mapping of the uptime to the unix time of bitec_clock, synced every SNTP
+ * interval of the firmware from a server with a few ms of error, for an uptime
+ * that runs fast as a crystal does. Every case checks the time of the readings
+ * against the one of the server: before the first sync, between syncs as the
+ * drift is measured, through an outage of the server and as the drift moves
+ * with the temperature. The offset of a sync is slewed in without the time
+ * ever going back, a larger one steps it:
+ *
+ *     smartLight_test.elf clock
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+
+#include "bitec_clock.h"
+#include "esp_log.h"
+#include "test.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define START				1792368000000000LL	/*!< Oct 19, 2026 00:00 UTC in us */
+#define INTERVAL			3600000000LL	/*!< SNTP interval of the firmware in us */
+#define JITTER				5000		/*!< Error of a sync in us, either way */
+#define FAST				50.0		/*!< Of the uptime against the server in ppm */
+#define READING				1000000LL	/*!< Readings period in us */
+#define HOUR				3600000000LL
+#define DAY					(24 * HOUR)
+
+/* typedef -------------------------------------------------------------------*/
+
+/* Readings against the server */
+typedef struct
+{
+	double max;					/*!< In ms, absolute */
+	bool monotonic;				/*!< Never back from a reading to the next one */
+} readings_t;
+
+/* internal data declaration -------------------------------------------------*/
+
+static bitec_clock_t sntp_clock;
+static int64_t uptime;					/*!< In us */
+static int64_t server;					/*!< Unix time of the server at the uptime in us */
+static double fast;						/*!< Of the uptime in ppm */
+static uint32_t seed;
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static bool run_first(const char * * note);
+static bool run_drift(const char * * note);
+static bool run_holdover(const char * * note);
+static bool run_temperature(const char * * note);
+static bool run_slew(const char * * note);
+static bool run_step(const char * * note);
+static void start(double ppm);
+static readings_t run(int64_t duration, bool syncs);
+static void advance(int64_t delta);
+static void sync(int64_t error);
+static double uniform_random(double range);
+static uint32_t random_next(void);
+
+/* internal data definition --------------------------------------------------*/
+
+static const test_case_t cases[] =
+{
+	{ "first", run_first },
+	{ "drift", run_drift },
+	{ "holdover", run_holdover },
+	{ "temperature", run_temperature },
+	{ "slew", run_slew },
+	{ "step", run_step },
+};
+
+/* external functions definition ---------------------------------------------*/
+
+int test_clock(int argc, char * argv[])
+{
+	/* Every step logs a warning */
+	esp_log_level_set("*", ESP_LOG_ERROR);
+
+	printf("clock: syncs every %" PRId64 " s of %u ms error, uptime %.0f ppm fast, %d ppm slew\n", (int64_t)(INTERVAL / 1000000), JITTER / 1000,
+			FAST, CLOCK_SLEW);
+
+	return test_run("clock", cases, sizeof(cases) / sizeof(cases[0]));
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* Readings before the first sync are unknown, stamped from the uptime once synced */
+static bool run_first(const char * * note)
+{
+	bool passed;
+
+	start(FAST);
+	advance(30000000);
+
+	int64_t reading = uptime;
+	int64_t time = server;
+
+	passed = bitec_clock_time(&sntp_clock, reading) == -1;
+	advance(30000000);
+	sync(0);
+	passed = passed && bitec_clock_time(&sntp_clock, uptime) == server / 1000 && llabs(bitec_clock_time(&sntp_clock, reading) - time / 1000) <= 2;
+	*note = "unknown until synced, the readings before it stamped as they are published";
+
+	return passed;
+}
+
+/* The error between syncs once the drift is measured, against the uptime taken as it is */
+static bool run_drift(const char * * note)
+{
+	bool passed;
+
+	start(FAST);
+	sync(0);
+	run(DAY, true);
+
+	readings_t error = run(DAY, true);
+	double drift = sntp_clock.drift;
+
+	/* The same without the drift, only the syncs */
+	start(FAST);
+	sync(0);
+	run(DAY, true);
+
+	readings_t base = { 0 };
+
+	for(int64_t end = uptime + DAY; uptime < end;)
+	{
+		sntp_clock.drift = 0;
+		readings_t hour = run(INTERVAL, true);
+
+		base.max = fmax(base.max, hour.max);
+	}
+
+	passed = fabs(drift + FAST) < 1 && error.max < 10 && error.monotonic && sntp_clock.steps == 0;
+	*note = test_note("%.2f ppm measured, %.1f ms largest error, %.1f ms without it", drift, error.max, base.max);
+
+	return passed;
+}
+
+/* A day without syncs after a day of them, the drift keeps the time */
+static bool run_holdover(const char * * note)
+{
+	bool passed;
+
+	start(FAST);
+	sync(0);
+	run(DAY, true);
+
+	readings_t error = run(DAY, false);
+
+	passed = error.max < 100 && error.monotonic;
+	*note = test_note("%.1f ms off after a day without syncs, %.0f ms without the drift", error.max,
+			FAST * DAY / 1e9);
+
+	return passed;
+}
+
+/* The uptime from 50 to 30 ppm fast as the board warms up, the drift follows in a few syncs */
+static bool run_temperature(const char * * note)
+{
+	bool passed;
+
+	start(FAST);
+	sync(0);
+	run(DAY, true);
+	fast = 30;
+	run(12 * HOUR, true);
+
+	readings_t error = run(DAY, true);
+
+	passed = fabs(sntp_clock.drift + fast) < 1 && error.max < 10 && error.monotonic;
+	*note = test_note("%.2f ppm measured 12 h later, %.1f ms largest error", sntp_clock.drift, error.max);
+
+	return passed;
+}
+
+/* An offset below the step threshold made up at the slew rate, the time goes on */
+static bool run_slew(const char * * note)
+{
+	bool passed;
+	int64_t offset = CLOCK_STEP * 800LL;
+
+	start(0);
+	sync(0);
+	advance(READING);
+	server += offset;
+	sync(0);
+
+	readings_t error = run((int64_t)(offset * 1e6 / CLOCK_SLEW) + READING, false);
+
+	passed = error.monotonic && sntp_clock.steps == 0 && llabs(bitec_clock_time(&sntp_clock, uptime) - server / 1000) <= 1;
+	*note = test_note("%" PRId64 " ms made up in %.0f s, never back", offset / 1000, offset / 1e3 / CLOCK_SLEW * 1e3);
+
+	return passed;
+}
+
+/* An hour ahead on the server, taken as it is */
+static bool run_step(const char * * note)
+{
+	bool passed;
+
+	start(FAST);
+	sync(0);
+	run(DAY, true);
+
+	double drift = sntp_clock.drift;
+
+	server += HOUR;
+	sync(0);
+	passed = sntp_clock.steps == 1 && bitec_clock_time(&sntp_clock, uptime) == server / 1000 && sntp_clock.drift == drift;
+
+	readings_t error = run(DAY, true);
+
+	passed = passed && error.max < 10 && sntp_clock.steps == 1;
+	*note = "stepped on the next sync, the drift measured is kept";
+
+	return passed;
+}
+
+/* Not synced, the server at START and the same random numbers */
+static void start(double ppm)
+{
+	bitec_clock_init(&sntp_clock);
+	uptime = 0;
+	server = START;
+	fast = ppm;
+	seed = 0x2545F491;
+}
+
+/* Readings for a duration, with the syncs of every interval */
+static readings_t run(int64_t duration, bool syncs)
+{
+	readings_t error = { 0, true };
+	int64_t last = bitec_clock_time(&sntp_clock, uptime);
+
+	for(int64_t elapsed = 0; elapsed < duration; elapsed += READING)
+	{
+		advance(READING);
+
+		if(syncs && uptime % INTERVAL == 0)
+			sync((int64_t)uniform_random(JITTER));
+
+		int64_t time = bitec_clock_time(&sntp_clock, uptime);
+
+		error.max = fmax(error.max, fabs(time - server / 1e3));
+		error.monotonic = error.monotonic && time >= last;
+		last = time;
+	}
+
+	return error;
+}
+
+/* The server runs slower than the uptime by fast */
+static void advance(int64_t delta)
+{
+	uptime += delta;
+	server += delta - (int64_t)llround(delta * fast / 1e6);
+}
+
+static void sync(int64_t error)
+{
+	bitec_clock_sync(&sntp_clock, uptime, server + error);
+}
+
+static double uniform_random(double range)
+{
+	return range * (2.0 * random_next() / 4294967295.0 - 1);
+}
+
+/* xorshift32 */
+static uint32_t random_next(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return seed;
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,386 @@
+/*
+ * test_energy.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ *
+ * Interval energy registers of bitec_energy under a constant load, updated at
+ * the readings period as measure_task does. Every case checks the records
+ * closed on the edges of the local time: exact boundaries and readings over
+ * them, the 23 and 25 hour days of the DST changes, steps of the clock forward
+ * and backward against the uptime, energy measured before the clock was set,
+ * a restart between two saves and the totals of every tariff. Last, the rings
+ * are filled past their size and published in batches until none is left:
+ *
+ *     smartLight_test.elf energy
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+#include <time.h>
+
+#include "bitec_energy.h"
+#include "bitec_hal.h"
+#include "bitec_hal_linux.h"
+#include "test.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define UTC					"UTC0"
+#define CET					"CET-1CEST,M3.5.0,M10.5.0/3"
+#define LOAD				1000		/*!< Power in W of the cases but the DST ones */
+#define STEP				1000		/*!< Readings period in ms */
+#define PRINT_SIZE			1024		/*!< As the energy messages of the firmware */
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static bitec_energy_t energy;
+static int64_t now;						/*!< Unix time in ms, -1 while the clock is not set */
+static int64_t uptime;					/*!< In us */
+static double fed;						/*!< Energy of the updates in mWh */
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static bool run_boundary(const char * * note);
+static bool run_split(const char * * note);
+static bool run_dst(const char * * note);
+static bool run_jump_forward(const char * * note);
+static bool run_jump_backward(const char * * note);
+static bool run_unsynced(const char * * note);
+static bool run_restart(const char * * note);
+static bool run_tariffs(const char * * note);
+static bool run_overflow(const char * * note);
+static void start(const char * tz, int year, int month, int day, int hour, int minute, int second);
+static void feed(int64_t duration, int64_t step, double watts);
+static uint32_t local(int year, int month, int day, int hour, int minute, int second);
+static const bitec_energy_record_t * record(bitec_energy_register_e reg, int index);
+static bool conserved(void);
+static bool near(uint32_t value, double expected);
+
+/* internal data definition --------------------------------------------------*/
+
+static const test_case_t cases[] =
+{
+	{ "boundary", run_boundary },
+	{ "split", run_split },
+	{ "dst", run_dst },
+	{ "jump_forward", run_jump_forward },
+	{ "jump_backward", run_jump_backward },
+	{ "unsynced", run_unsynced },
+	{ "restart", run_restart },
+	{ "tariffs", run_tariffs },
+	{ "overflow", run_overflow },
+};
+
+/* external functions definition ---------------------------------------------*/
+
+int test_energy(int argc, char * argv[])
+{
+	return test_run("energy", cases, sizeof(cases) / sizeof(cases[0]));
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* An hour from a reading one period before it, the first quarter is not partial */
+static bool run_boundary(const char * * note)
+{
+	bool passed = true;
+
+	start(UTC, 2026, 10, 19, 9, 59, 58);
+	feed(STEP, STEP, LOAD);
+	feed(3600000, STEP, LOAD);
+	feed(STEP, STEP, LOAD);
+
+	passed = passed && energy.state.rings[ENERGY_QUARTER].count == 5 && energy.state.rings[ENERGY_HOUR].count == 2;
+
+	for(int i = 1; i < 5 && passed; i++)
+	{
+		const bitec_energy_record_t * quarter = record(ENERGY_QUARTER, i);
+
+		passed = quarter->start == local(2026, 10, 19, 10, (i - 1) * 15, 0) && quarter->flags == 0 && near(quarter->energy, LOAD * 250.0);
+	}
+
+	passed = passed && record(ENERGY_HOUR, 1)->start == local(2026, 10, 19, 10, 0, 0) && near(record(ENERGY_HOUR, 1)->energy, LOAD * 1000.0);
+	passed = passed && record(ENERGY_QUARTER, 0)->flags == ENERGY_PARTIAL && conserved();
+	*note = "readings on the boundaries close 4 whole quarters and an hour";
+
+	return passed;
+}
+
+/* Readings of 7 s, one over every boundary but the ones of the whole minute */
+static bool run_split(const char * * note)
+{
+	bool passed = true;
+
+	start(UTC, 2026, 10, 19, 10, 0, 0);
+	feed(7000, 7000, LOAD);
+	feed(3600000 + 7000, 7000, LOAD);
+
+	for(int i = 1; i < energy.state.rings[ENERGY_QUARTER].count && passed; i++)
+		passed = near(record(ENERGY_QUARTER, i)->energy, LOAD * 250.0);
+
+	passed = passed && energy.state.rings[ENERGY_QUARTER].count == 4 && near(record(ENERGY_HOUR, 0)->energy, LOAD * 1000.0) && conserved();
+	*note = "readings over a boundary split in proportion to the time on each side";
+
+	return passed;
+}
+
+/* Both DST changes of the year, the days start on the local midnight */
+static bool run_dst(const char * * note)
+{
+	static const int days[2][3] = { { 2026, 3, 28 }, { 2026, 10, 24 } };
+	static const int hours[2] = { 23, 25 };
+	bool passed = true;
+
+	for(int i = 0; i < 2 && passed; i++)
+	{
+		start(CET, days[i][0], days[i][1], days[i][2], 0, 0, 0);
+		feed(3 * 86400000LL + 7200000, 10 * STEP, 100);
+
+		const bitec_energy_record_t * day = record(ENERGY_DAY, 1);
+		const bitec_energy_record_t * next = record(ENERGY_DAY, 2);
+
+		/* The hours and quarters in between are whole, of the uptime and not of the local time */
+		passed = energy.state.rings[ENERGY_DAY].count == 3 && next->start - day->start == hours[i] * 3600U &&
+				near(day->energy, 100.0 * 1000 * hours[i]) && day->start == local(days[i][0], days[i][1], days[i][2] + 1, 0, 0, 0) && conserved();
+
+		for(int j = 0; j < energy.state.rings[ENERGY_HOUR].count && passed; j++)
+			passed = near(record(ENERGY_HOUR, j)->energy, 100.0 * 1000);
+	}
+
+	*note = "days of 23 and 25 hours, every hour whole";
+
+	return passed;
+}
+
+/* The clock stepped an hour ahead in the middle of a quarter */
+static bool run_jump_forward(const char * * note)
+{
+	bool passed;
+
+	start(UTC, 2026, 10, 19, 10, 0, 0);
+	feed(450000, STEP, LOAD);
+	now += 3600000;
+	feed(1350000, STEP, LOAD);
+
+	const bitec_energy_record_t * before = record(ENERGY_QUARTER, 0);
+	const bitec_energy_record_t * after = record(ENERGY_QUARTER, 1);
+
+	passed = energy.jumps == 1 && (before->flags & ENERGY_CLOCK_JUMP) && before->start == local(2026, 10, 19, 10, 0, 0) &&
+			near(before->energy, LOAD * 125.0) && after->start == local(2026, 10, 19, 11, 0, 0) &&
+			(after->flags & (ENERGY_CLOCK_JUMP | ENERGY_PARTIAL)) == (ENERGY_CLOCK_JUMP | ENERGY_PARTIAL) &&
+			near(after->energy, LOAD * 125.0) && (record(ENERGY_HOUR, 0)->flags & ENERGY_CLOCK_JUMP) && conserved();
+	*note = "open records closed on the step, the next ones partial, no energy lost";
+
+	return passed;
+}
+
+/* The clock stepped an hour back, as a wrong time corrected */
+static bool run_jump_backward(const char * * note)
+{
+	bool passed;
+
+	start(UTC, 2026, 10, 19, 10, 0, 0);
+	feed(450000, STEP, LOAD);
+	now -= 3600000;
+	feed(1350000, STEP, LOAD);
+
+	const bitec_energy_record_t * before = record(ENERGY_QUARTER, 0);
+	const bitec_energy_record_t * after = record(ENERGY_QUARTER, 1);
+
+	passed = energy.jumps == 1 && (before->flags & ENERGY_CLOCK_JUMP) && after->start == local(2026, 10, 19, 9, 0, 0) &&
+			(after->flags & ENERGY_CLOCK_JUMP) && near(before->energy + after->energy + record(ENERGY_QUARTER, 2)->energy,
+			LOAD * 500.0) && conserved();
+	*note = "open records closed on the step, an earlier start again, no energy lost";
+
+	return passed;
+}
+
+/* A minute measured before the clock was set, it goes to the first records */
+static bool run_unsynced(const char * * note)
+{
+	bool passed;
+
+	start(UTC, 2026, 10, 19, 10, 5, 0);
+	now = -1;
+	feed(60000, STEP, LOAD);
+	now = (int64_t)local(2026, 10, 19, 10, 5, 0) * 1000;
+	feed(STEP, STEP, LOAD);
+	feed(1800000, STEP, LOAD);
+
+	const bitec_energy_record_t * first = record(ENERGY_QUARTER, 0);
+
+	passed = energy.jumps == 0 && first->flags == (ENERGY_UNSYNCED | ENERGY_PARTIAL) && near(first->energy, LOAD * 660 / 3.6) &&
+			record(ENERGY_QUARTER, 1)->flags == 0 && conserved();
+	*note = "energy before the clock was set kept in the first records, flagged";
+
+	return passed;
+}
+
+/* Restarted four minutes after a save and off for two, the next quarter is partial */
+static bool run_restart(const char * * note)
+{
+	bool passed;
+
+	start(UTC, 2026, 10, 19, 10, 0, 0);
+	feed(600000, STEP, LOAD);
+	passed = bitec_energy_save(&energy) == ESP_OK;
+	feed(240000, STEP, LOAD);
+
+	/* Off for two minutes, the uptime starts again */
+	bitec_energy_init(&energy);
+	passed = passed && bitec_energy_restore(&energy) == ESP_OK;
+	now += 120000;
+	uptime = 0;
+	feed(STEP, STEP, LOAD);
+	feed(900000, STEP, LOAD);
+
+	const bitec_energy_record_t * quarter = record(ENERGY_QUARTER, 0);
+	const bitec_energy_record_t * next = record(ENERGY_QUARTER, 1);
+
+	passed = passed && quarter->flags == (ENERGY_PARTIAL | ENERGY_RESTART) && near(quarter->energy, LOAD * 600 / 3.6) &&
+			next->flags == ENERGY_PARTIAL && energy.state.rings[ENERGY_HOUR].count == 0 &&
+			fabs(bitec_energy_total(&energy) * 1000 + energy.fraction - (fed - LOAD * 240 / 3.6)) < 1;
+	*note = "open records restored and flagged, the energy since the save lost";
+
+	return passed;
+}
+
+/* A weekday and a weekend day at the default schedules */
+static bool run_tariffs(const char * * note)
+{
+	static const double weekday[ENERGY_TARIFFS] = { 8, 12, 4, 0 };
+	static const double weekend[ENERGY_TARIFFS] = { 10, 14, 0, 0 };
+	bool passed = true;
+
+	start(UTC, 2026, 10, 23, 0, 0, 0);
+	feed(86400000, 10 * STEP, 100);
+
+	for(int i = 0; i < ENERGY_TARIFFS; i++)
+		passed = passed && near(energy.state.totals[i], weekday[i] * 100 * 1000);
+
+	memset(energy.state.totals, 0, sizeof(energy.state.totals));
+	feed(86400000, 10 * STEP, 100);
+
+	for(int i = 0; i < ENERGY_TARIFFS; i++)
+		passed = passed && near(energy.state.totals[i], weekend[i] * 100 * 1000);
+
+	*note = "totals of the hours of every tariff, Friday and Saturday";
+
+	return passed;
+}
+
+/* 30 hours not published, then every record published in batches */
+static bool run_overflow(const char * * note)
+{
+	static char buf[PRINT_SIZE];
+	bitec_energy_batch_t batch;
+	uint32_t printed[ENERGY_REGISTER_MAX] = { 0 };
+	int batches = 0;
+	bool passed = true;
+
+	start(UTC, 2026, 10, 19, 0, 0, 0);
+	feed(30 * 3600000LL + STEP, 10 * STEP, LOAD);
+
+	passed = energy.dropped == 30 * 4 - ENERGY_QUARTERS && bitec_energy_unsent(&energy, ENERGY_QUARTER) == ENERGY_QUARTERS &&
+			bitec_energy_unsent(&energy, ENERGY_HOUR) == 30 && bitec_energy_unsent(&energy, ENERGY_DAY) == 1;
+
+	/* The oldest record not overwritten first */
+	int len = bitec_energy_print(&energy, buf, sizeof(buf), &batch);
+	char * quarter = strstr(buf, "\"quarter\":[[");
+
+	passed = passed && len > 0 && quarter != NULL && strtoul(quarter + 12, NULL, 10) == local(2026, 10, 19, 6, 0, 0);
+
+	while(passed && len > 0 && batch.counts[ENERGY_QUARTER] + batch.counts[ENERGY_HOUR] + batch.counts[ENERGY_DAY] > 0)
+	{
+		passed = (size_t)len == strlen(buf) && (size_t)len < sizeof(buf) && buf[len - 1] == '}';
+		bitec_energy_sent(&energy, &batch);
+		batches++;
+
+		for(int i = 0; i < ENERGY_REGISTER_MAX; i++)
+			printed[i] += batch.counts[i];
+
+		len = bitec_energy_print(&energy, buf, sizeof(buf), &batch);
+	}
+
+	passed = passed && len > 0 && printed[ENERGY_QUARTER] == ENERGY_QUARTERS && printed[ENERGY_HOUR] == 30 && printed[ENERGY_DAY] == 1;
+	*note = test_note("%" PRIu32 " oldest quarters dropped, %" PRIu32 " records in %d batches of %d bytes", energy.dropped,
+			printed[ENERGY_QUARTER] + printed[ENERGY_HOUR] + printed[ENERGY_DAY], batches, PRINT_SIZE);
+
+	return passed;
+}
+
+/* Registers cleared, no state stored and the clock at a local time */
+static void start(const char * tz, int year, int month, int day, int hour, int minute, int second)
+{
+	setenv("TZ", tz, 1);
+	tzset();
+	hal_linux_reset();
+	hal_nvs_init("settings");
+	bitec_energy_init(&energy);
+
+	now = (int64_t)local(year, month, day, hour, minute, second) * 1000;
+	uptime = 0;
+	fed = 0;
+}
+
+/* Readings of a constant load every step for a duration, the uptime follows */
+static void feed(int64_t duration, int64_t step, double watts)
+{
+	for(int64_t elapsed = 0; elapsed < duration; elapsed += step)
+	{
+		double mwh = watts * step / 3600.0;
+
+		if(now >= 0)
+			now += step;
+
+		uptime += step * 1000;
+		fed += mwh;
+		bitec_energy_update(&energy, now, uptime, mwh);
+	}
+}
+
+/* Unix time of a local time, of the TZ in use */
+static uint32_t local(int year, int month, int day, int hour, int minute, int second)
+{
+	struct tm timeinfo =
+	{
+		.tm_year = year - 1900, .tm_mon = month - 1, .tm_mday = day,
+		.tm_hour = hour, .tm_min = minute, .tm_sec = second, .tm_isdst = -1
+	};
+
+	return (uint32_t)mktime(&timeinfo);
+}
+
+/* Closed record of a register, the oldest one kept is 0 */
+static const bitec_energy_record_t * record(bitec_energy_register_e reg, int index)
+{
+	static const uint16_t sizes[ENERGY_REGISTER_MAX] = { ENERGY_QUARTERS, ENERGY_HOURS, ENERGY_DAYS };
+	static const uint16_t offsets[ENERGY_REGISTER_MAX] = { 0, ENERGY_QUARTERS, ENERGY_QUARTERS + ENERGY_HOURS };
+	const bitec_energy_ring_t * ring = &energy.state.rings[reg];
+
+	return &energy.state.records[offsets[reg] + (ring->head + sizes[reg] - ring->count + index) % sizes[reg]];
+}
+
+/* The totals hold the energy of every update but the fraction of 1 mWh carried */
+static bool conserved(void)
+{
+	return fabs(bitec_energy_total(&energy) * 1000 + energy.fraction - fed) < 0.01;
+}
+
+/* Within the 1 mWh rounding of the records */
+static bool near(uint32_t value, double expected)
+{
+	return fabs(value - expected) <= 1;
+}
+
+/* end of file ---------------------------------------------------------------*/
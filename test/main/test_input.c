@@ -0,0 +1,294 @@
+/*
+ * test_input.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ *
+ * Filtered inputs of bitec_input, edges driven on the GPIO fakes of the linux
+ * port at virtual times and dispatched as the input task does, without it. A
+ * level is delivered once it holds for the filter time, stamped with the edge
+ * it started on, even when the edges wait in the queue past that time, and a
+ * pulse or a bounce shorter than the filter is counted as a glitch. Edges dropped by a full
+ * edges queue leave the level wrong until the next edge that fits, and events
+ * dropped by a full events queue are counted with the level kept in step with
+ * the pin:
+ *
+ *     smartLight_test.elf input
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "bitec_input.h"
+#include "bitec_hal.h"
+#include "bitec_hal_linux.h"
+#include "test.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define PIR_PIN				8
+#define DOOR_PIN			9
+#define FILTER				50000		/*!< Of the PIR input in us */
+#define EDGES_LEN			8			/*!< Short queues to fill them */
+#define QUEUE_LEN			8
+#define EVENTS_MAX			16
+#define MS					1000
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static bitec_input_t input;
+static bitec_input_event_t events[EVENTS_MAX];
+static size_t events_num;
+static int pir_arg;
+static int door_arg;
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static bool run_filter(const char * * note);
+static bool run_queued(const char * * note);
+static bool run_glitches(const char * * note);
+static bool run_unfiltered(const char * * note);
+static bool run_dropped(const char * * note);
+static bool run_overflow(const char * * note);
+static bool start(uint32_t filter);
+static void drive(int64_t time, int pin, uint32_t level);
+static size_t dispatch(int64_t time);
+static bool event_check(size_t i, int pin, uint32_t level, int64_t time);
+
+/* internal data definition --------------------------------------------------*/
+
+static const test_case_t cases[] =
+{
+	{ "filter", run_filter },
+	{ "queued", run_queued },
+	{ "glitches", run_glitches },
+	{ "unfiltered", run_unfiltered },
+	{ "dropped", run_dropped },
+	{ "overflow", run_overflow },
+};
+
+/* external functions definition ---------------------------------------------*/
+
+int test_input(int argc, char * argv[])
+{
+	return test_run("input", cases, sizeof(cases) / sizeof(cases[0]));
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* A bouncing press and release, each delivered a filter time after its last bounce */
+static bool run_filter(const char * * note)
+{
+	bool passed = start(FILTER);
+
+	drive(0, PIR_PIN, 1);
+	drive(1 * MS, PIR_PIN, 0);
+	drive(2 * MS, PIR_PIN, 1);
+	passed = passed && dispatch(10 * MS) == 0 && dispatch(2 * MS + FILTER - 1) == 0 && bitec_input_get_level(&input, PIR_PIN) == 0;
+	passed = passed && dispatch(2 * MS + FILTER) == 1 && event_check(0, PIR_PIN, 1, 2 * MS) && events[0].arg == &pir_arg;
+
+	drive(1000 * MS, PIR_PIN, 0);
+	drive(1003 * MS, PIR_PIN, 1);
+	drive(1004 * MS, PIR_PIN, 0);
+	passed = passed && dispatch(1004 * MS + FILTER - 1) == 0;
+	passed = passed && dispatch(1004 * MS + FILTER) == 1 && event_check(1, PIR_PIN, 0, 1004 * MS);
+	passed = passed && bitec_input_get_level(&input, PIR_PIN) == 0 && bitec_input_get_level(&input, 3) == -1;
+	passed = passed && input.glitches == 2 && input.dropped == 0 && input.overflows == 0;
+
+	*note = test_note("press and release bouncing for 4 ms delivered %d ms after their last bounce, the bounces as glitches",
+			FILTER / MS);
+
+	return passed;
+}
+
+/* Edges dispatched long after they came, as when the input task was kept from running */
+static bool run_queued(const char * * note)
+{
+	bool passed = start(FILTER);
+
+	drive(0, PIR_PIN, 1);
+	drive(60 * MS, PIR_PIN, 0);
+	drive(80 * MS, PIR_PIN, 1);
+	drive(100 * MS, PIR_PIN, 0);
+
+	/* The first level held past the filter before the next edge, the second one did not and the
+	 * last one is still held */
+	passed = passed && dispatch(500 * MS) == 2 && event_check(0, PIR_PIN, 1, 0) && event_check(1, PIR_PIN, 0, 100 * MS);
+	passed = passed && input.glitches == 1 && bitec_input_get_level(&input, PIR_PIN) == 0;
+
+	*note = "levels taken at the times of their edges, not at the time of the dispatch";
+
+	return passed;
+}
+
+/* Pulses shorter than the filter, one on each level */
+static bool run_glitches(const char * * note)
+{
+	bool passed = start(FILTER);
+	int64_t time = 0;
+
+	for(int i = 0; i < 10; i++)
+	{
+		drive(time, PIR_PIN, 1);
+		drive(time + FILTER - 1, PIR_PIN, 0);
+		time += 200 * MS;
+		passed = passed && dispatch(time) == 0;
+	}
+
+	passed = passed && input.glitches == 10 && bitec_input_get_level(&input, PIR_PIN) == 0;
+
+	/* Dropouts of a level delivered */
+	drive(time, PIR_PIN, 1);
+	passed = passed && dispatch(time + FILTER) == 1;
+
+	for(int i = 0; i < 5; i++)
+	{
+		time += 200 * MS;
+		drive(time, PIR_PIN, 0);
+		drive(time + 10 * MS, PIR_PIN, 1);
+		passed = passed && dispatch(time + 100 * MS) == 0;
+	}
+
+	passed = passed && input.glitches == 15 && bitec_input_get_level(&input, PIR_PIN) == 1;
+	*note = test_note("%" PRIu32 " pulses 1 us short of the filter and dropouts counted as glitches, none delivered", input.glitches);
+
+	return passed;
+}
+
+/* A pin without filter next to the filtered one, every edge delivered at once */
+static bool run_unfiltered(const char * * note)
+{
+	bool passed = start(FILTER) && bitec_input_add(&input, DOOR_PIN, HAL_GPIO_PULL_DOWN, 0, &door_arg) == ESP_OK;
+
+	drive(0, PIR_PIN, 1);
+	drive(10 * MS, DOOR_PIN, 1);
+	drive(10 * MS + 1, DOOR_PIN, 0);
+	passed = passed && dispatch(20 * MS) == 2 && event_check(0, DOOR_PIN, 1, 10 * MS) && event_check(1, DOOR_PIN, 0, 10 * MS + 1);
+	passed = passed && events[0].arg == &door_arg;
+	passed = passed && dispatch(FILTER) == 1 && event_check(2, PIR_PIN, 1, 0) && input.glitches == 0;
+
+	*note = "a 1 us pulse of an input without filter delivered, the filtered one on its own time";
+
+	return passed;
+}
+
+/* More edges than the queue holds before a dispatch, the level is right again after the next edge */
+static bool run_dropped(const char * * note)
+{
+	bool passed = start(0);
+	int64_t time = 0;
+
+	/* The pin ends high, the last edge queued is low */
+	for(int i = 0; i < EDGES_LEN * 2 + 1; i++, time += MS)
+		drive(time, PIR_PIN, i % 2 == 0);
+
+	passed = passed && input.dropped == EDGES_LEN + 1 && dispatch(time) == EDGES_LEN;
+	passed = passed && bitec_input_get_level(&input, PIR_PIN) == 0 && hal_gpio_get_level(PIR_PIN) == 1;
+
+	/* The next edge carries its level */
+	drive(time, PIR_PIN, 0);
+	passed = passed && dispatch(time + MS) == 0 && bitec_input_get_level(&input, PIR_PIN) == 0;
+	drive(time + 2 * MS, PIR_PIN, 1);
+	passed = passed && dispatch(time + 3 * MS) == 1 && event_check(EDGES_LEN, PIR_PIN, 1, time + 2 * MS);
+
+	*note = test_note("%" PRIu32 " edges dropped, the level in step with the pin again on the next edge", input.dropped);
+
+	return passed;
+}
+
+/* More events than the queue holds before they are read */
+static bool run_overflow(const char * * note)
+{
+	bitec_input_event_t event;
+	size_t delivered = 0;
+	size_t read = 0;
+	bool passed = start(0);
+
+	for(int i = 0; i < QUEUE_LEN + 3; i++)
+	{
+		hal_linux_time_set(i * MS);
+		hal_linux_gpio_drive(PIR_PIN, i % 2 == 0);
+		hal_linux_time_set(i * MS + 1);
+		delivered += bitec_input_dispatch(&input, 0);
+	}
+
+	while(xQueueReceive(input.queue, &event, 0) == pdTRUE)
+		read++;
+
+	/* The lost events still moved the level */
+	passed = passed && delivered == QUEUE_LEN && read == QUEUE_LEN && input.overflows == 3;
+	passed = passed && bitec_input_get_level(&input, PIR_PIN) == hal_gpio_get_level(PIR_PIN);
+
+	*note = test_note("%d events for a queue of %d, %" PRIu32 " counted as lost, the level kept", QUEUE_LEN + 3, QUEUE_LEN, input.overflows);
+
+	return passed;
+}
+
+/* The service with short queues and the PIR input, as bitec_input_init() without its task */
+static bool start(uint32_t filter)
+{
+	static bool created = false;
+
+	hal_linux_reset();
+
+	if(!created)
+	{
+		input.edges = xQueueCreate(EDGES_LEN, sizeof(bitec_input_edge_t));
+		input.queue = xQueueCreate(QUEUE_LEN, sizeof(bitec_input_event_t));
+		created = input.edges != NULL && input.queue != NULL;
+	}
+
+	xQueueReset(input.edges);
+	xQueueReset(input.queue);
+	input.pins_num = 0;
+	input.dropped = 0;
+	input.glitches = 0;
+	input.overflows = 0;
+	events_num = 0;
+
+	return created && bitec_input_add(&input, PIR_PIN, HAL_GPIO_PULL_DOWN, filter, &pir_arg) == ESP_OK;
+}
+
+static void drive(int64_t time, int pin, uint32_t level)
+{
+	hal_linux_time_set(time);
+	hal_linux_gpio_drive(pin, level);
+}
+
+/* Dispatch at a time and keep the events. Returns the number of them */
+static size_t dispatch(int64_t time)
+{
+	size_t num;
+	size_t read = 0;
+
+	hal_linux_time_set(time);
+	num = bitec_input_dispatch(&input, 0);
+
+	while(events_num < EVENTS_MAX && xQueueReceive(input.queue, &events[events_num], 0) == pdTRUE)
+	{
+		events_num++;
+		read++;
+	}
+
+	return num == read ? num : (size_t)-1;
+}
+
+static bool event_check(size_t i, int pin, uint32_t level, int64_t time)
+{
+	if(i >= events_num || events[i].pin != pin || events[i].level != level || events[i].time != time)
+	{
+		printf("input: event %zu not on pin %d to %" PRIu32 " at %" PRId64 " us\n", i, pin, level, time);
+		return false;
+	}
+
+	return true;
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,216 @@
+/*
+ * test_latency.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ *
+ * Log2 histograms of bitec_latency. Every case checks what the firmware
+ * publishes: the bucket of the values on the edges, from 0 and 1 through every
+ * power of two to the last bucket taking the overflow, the count, max and mean
+ * of a histogram and its JSON, the intervals of the stages stamped on the fake
+ * uptime with the acknowledge of the right message only, and the -1 returned
+ * when the buffer is short of the whole export:
+ *
+ *     smartLight_test.elf latency
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "bitec_latency.h"
+#include "bitec_hal_linux.h"
+#include "test.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define START				1000000		/*!< Uptime of the first stamp in us, 0 is never stamped */
+#define PRINT_SIZE			2048		/*!< As the latency messages of the firmware */
+#define MSG_ID				7
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static bitec_latency_t latency;
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static bool run_buckets(const char * * note);
+static bool run_histogram(const char * * note);
+static bool run_stages(const char * * note);
+static bool run_print_short(const char * * note);
+
+/* internal data definition --------------------------------------------------*/
+
+static const test_case_t cases[] =
+{
+	{ "buckets", run_buckets },
+	{ "histogram", run_histogram },
+	{ "stages", run_stages },
+	{ "print_short", run_print_short },
+};
+
+/* external functions definition ---------------------------------------------*/
+
+int test_latency(int argc, char * argv[])
+{
+	return test_run("latency", cases, sizeof(cases) / sizeof(cases[0]));
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* Bucket n holds [2^(n-1), 2^n), the last one everything above */
+static bool run_buckets(const char * * note)
+{
+	bool passed = bitec_latency_bucket(0) == 0 && bitec_latency_bucket(1) == 1;
+
+	for(int n = 1; n < 32 && passed; n++)
+	{
+		uint32_t power = (uint32_t)1 << n;
+		uint8_t expected = n + 1 < LATENCY_BUCKETS ? n + 1 : LATENCY_BUCKETS - 1;
+
+		passed = bitec_latency_bucket(power) == expected && bitec_latency_bucket(power - 1) == (n < LATENCY_BUCKETS ? n : LATENCY_BUCKETS - 1);
+	}
+
+	passed = passed && bitec_latency_bucket(UINT32_MAX) == LATENCY_BUCKETS - 1;
+	*note = test_note("0 and 1 alone, every power of two opens a bucket up to the overflow one, %d", LATENCY_BUCKETS - 1);
+
+	return passed;
+}
+
+/* Count, max and truncated mean of a few values, then the JSON with the trailing empty buckets left out */
+static bool run_histogram(const char * * note)
+{
+	static const uint32_t values[] = { 0, 1, 2, 3, 1000 };
+	bitec_latency_histogram_t histogram = { 0 };
+	char buf[PRINT_SIZE];
+	char expected[PRINT_SIZE];
+	bool passed;
+
+	int len = bitec_latency_histogram_print(&histogram, buf, sizeof(buf));
+	passed = len > 0 && !strcmp(buf, "{\"count\":0,\"max\":0,\"mean\":0,\"buckets\":[]}");
+
+	for(size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+		bitec_latency_histogram_add(&histogram, values[i]);
+
+	passed = passed && histogram.count == 5 && histogram.max == 1000 && histogram.sum == 1006;
+	len = bitec_latency_histogram_print(&histogram, buf, sizeof(buf));
+	passed = passed && len == (int)strlen(buf) && !strcmp(buf, "{\"count\":5,\"max\":1000,\"mean\":201,\"buckets\":[1,1,2,0,0,0,0,0,0,0,1]}");
+
+	/* An overflow goes to the last bucket and the sum does not wrap */
+	bitec_latency_histogram_add(&histogram, UINT32_MAX);
+	len = snprintf(expected, sizeof(expected), "{\"count\":6,\"max\":%" PRIu32 ",\"mean\":%" PRIu32 ",\"buckets\":[1,1,2,0,0,0,0,0,0,0,1",
+			UINT32_MAX, (uint32_t)((1006 + (uint64_t)UINT32_MAX) / 6));
+
+	for(int i = 11; i < LATENCY_BUCKETS; i++)
+		len += snprintf(expected + len, sizeof(expected) - len, ",%d", i == LATENCY_BUCKETS - 1);
+
+	snprintf(expected + len, sizeof(expected) - len, "]}");
+	bitec_latency_histogram_print(&histogram, buf, sizeof(buf));
+	passed = passed && histogram.buckets[LATENCY_BUCKETS - 1] == 1 && !strcmp(buf, expected);
+	*note = test_note("count %" PRIu32 ", max %" PRIu32 " and mean %" PRIu32 " us exported with %d buckets", histogram.count,
+			histogram.max, (uint32_t)(histogram.sum / histogram.count), LATENCY_BUCKETS);
+
+	return passed;
+}
+
+/* The stages of a publish on the fake uptime, every one from the previous and the first to the acknowledge */
+static bool run_stages(const char * * note)
+{
+	static const int64_t steps[LATENCY_STAGE_MAX] = { 0, 150, 2300, 40, 85000 };
+	bool passed = true;
+
+	bitec_latency_init(&latency);
+	hal_linux_time_set(START);
+
+	/* Two publishes, the acknowledge of another message is not taken */
+	for(int j = 0; j < 2; j++)
+	{
+		for(int i = LATENCY_STAGE_SAMPLE; i < LATENCY_STAGE_ENQUEUE; i++)
+		{
+			hal_linux_time_advance(steps[i] * (j + 1));
+			bitec_latency_stamp(&latency, i);
+		}
+
+		hal_linux_time_advance(steps[LATENCY_STAGE_ENQUEUE] * (j + 1));
+		bitec_latency_enqueued(&latency, MSG_ID + j);
+		hal_linux_time_advance(steps[LATENCY_STAGE_ACK] * (j + 1));
+		bitec_latency_ack(&latency, MSG_ID);
+		bitec_latency_ack(&latency, MSG_ID + j);
+		bitec_latency_ack(&latency, MSG_ID + j);
+		hal_linux_time_advance(1000000);
+	}
+
+	for(int i = LATENCY_STAGE_NOTIFY; i < LATENCY_STAGE_MAX && passed; i++)
+	{
+		const bitec_latency_histogram_t * stage = &latency.stages[i];
+
+		passed = stage->count == 2 && stage->max == steps[i] * 2 && stage->sum == (uint64_t)steps[i] * 3;
+	}
+
+	const bitec_latency_histogram_t * e2e = &latency.stages[LATENCY_STAGE_SAMPLE];
+	int64_t total = steps[1] + steps[2] + steps[3] + steps[4];
+
+	passed = passed && e2e->count == 2 && e2e->max == total * 2 && e2e->sum == (uint64_t)total * 3 && latency.msg_id == LATENCY_NO_MSG_ID;
+
+	/* A QoS 0 publish is never acknowledged */
+	bitec_latency_stamp(&latency, LATENCY_STAGE_SAMPLE);
+	bitec_latency_enqueued(&latency, 0);
+	bitec_latency_ack(&latency, 0);
+	passed = passed && latency.msg_id == LATENCY_NO_MSG_ID && e2e->count == 2;
+	*note = test_note("%" PRIu32 " publishes of %" PRIu32 " us mean, acknowledged once by their own message", e2e->count,
+			(uint32_t)(e2e->sum / e2e->count));
+
+	/* Nothing left once reset */
+	bitec_latency_overrun(&latency, 12);
+	bitec_latency_reset(&latency);
+
+	for(int i = 0; i < LATENCY_STAGE_MAX && passed; i++)
+		passed = latency.stages[i].count == 0;
+
+	passed = passed && latency.overrun.count == 0;
+
+	return passed;
+}
+
+/* Every buffer short of the export by even one byte fails whole, the one that fits takes it */
+static bool run_print_short(const char * * note)
+{
+	static char buf[PRINT_SIZE];
+	bool passed = true;
+
+	bitec_latency_init(&latency);
+
+	for(uint32_t i = 0; i < 1000; i++)
+	{
+		bitec_latency_histogram_add(&latency.stages[i % LATENCY_STAGE_MAX], i * 997);
+		bitec_latency_overrun(&latency, i);
+	}
+
+	int len = bitec_latency_print(&latency, buf, sizeof(buf));
+	passed = len > 0 && len == (int)strlen(buf);
+
+	for(int size = 0; size <= len && passed; size++)
+		passed = bitec_latency_print(&latency, buf, size) == -1;
+
+	passed = passed && bitec_latency_print(&latency, buf, len + 1) == len;
+
+	/* A histogram alone */
+	int histogram_len = bitec_latency_histogram_print(&latency.overrun, buf, sizeof(buf));
+
+	for(int size = 0; size <= histogram_len && passed; size++)
+		passed = bitec_latency_histogram_print(&latency.overrun, buf, size) == -1;
+
+	passed = passed && bitec_latency_histogram_print(&latency.overrun, buf, histogram_len + 1) == histogram_len;
+	*note = test_note("-1 below %d bytes for the export, %d for a histogram", len + 1, histogram_len + 1);
+
+	return passed;
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,112 @@
+/*
+ * test_main.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ *
+ * Host tests of the components, a suite per component. Every suite checks the
+ * component against its requirements and prints the measures behind them, the
+ * program fails if any case does. Without arguments every suite runs, a suite
+ * name runs that one alone and passes it the arguments left:
+ *
+ *     smartLight_test.elf [suite [arguments]]
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "bitec_hal_linux.h"
+#include "test.h"
+
+/* macros --------------------------------------------------------------------*/
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static int suite_run(const test_suite_t * suite, int argc, char * argv[]);
+
+/* internal data definition --------------------------------------------------*/
+
+/* Run in this order */
+static const test_suite_t suites[] =
+{
+	{ "latency", test_latency, false },
+	{ "ws2812_led", test_ws2812_led, false },
+	{ "button", test_button, false },
+	{ "input", test_input, false },
+	{ "relay", test_relay, false },
+	{ "rules", test_rules, false },
+	{ "monitor", test_monitor, false },
+	{ "ota", test_ota, false },
+	{ "delta", test_delta, true },
+	{ "fleet", test_fleet, false },
+	{ "settings", test_settings, false },
+	{ "meter", test_meter, false },
+	{ "energy", test_energy, false },
+	{ "series", test_series, false },
+	{ "clock", test_clock, false },
+};
+
+#define SUITE_MAX			(sizeof(suites) / sizeof(suites[0]))
+
+/* main ----------------------------------------------------------------------*/
+
+int main(int argc, char * argv[])
+{
+	int failures = 0;
+
+	if(argc > 1)
+	{
+		for(size_t i = 0; i < SUITE_MAX; i++)
+		{
+			if(!strcmp(argv[1], suites[i].name))
+				return suite_run(&suites[i], argc - 2, argv + 2) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+
+		fprintf(stderr, "usage: %s [suite [arguments]], suites:", argv[0]);
+
+		for(size_t i = 0; i < SUITE_MAX; i++)
+			fprintf(stderr, " %s", suites[i].name);
+
+		fprintf(stderr, "\n");
+
+		return EXIT_FAILURE;
+	}
+
+	for(size_t i = 0; i < SUITE_MAX; i++)
+	{
+		if(!suites[i].tool && suite_run(&suites[i], 0, NULL) != 0)
+			failures++;
+	}
+
+	printf("test: %s\n", failures == 0 ? "PASS" : "FAIL");
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static int suite_run(const test_suite_t * suite, int argc, char * argv[])
+{
+	/* Every suite starts from the fakes and logs as after a boot */
+	hal_linux_reset();
+	esp_log_level_set("*", ESP_LOG_INFO);
+
+	int failures = suite->run(argc, argv);
+
+	if(!suite->tool)
+		printf("%s: %s\n", suite->name, failures == 0 ? "PASS" : "FAIL");
+
+	return failures;
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,310 @@
+/*
+ * test_monitor.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ *
+ * Replay of synthetic power readings through the anomaly detector. Every fault
+ * is replayed many times with its own noise and fault time to measure the
+ * detection rate and latency, and a long trace with no fault gives the false
+ * positives per hour of every anomaly:
+ *
+ *     smartLight_test.elf monitor
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <math.h>
+
+#include "bitec_monitor.h"
+#include "test.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#ifdef CONFIG_REPLAY_RUNS
+#define REPLAY_RUNS			CONFIG_REPLAY_RUNS
+#else
+#define REPLAY_RUNS			200
+#endif
+
+#ifdef CONFIG_REPLAY_CLEAN_TIME
+#define REPLAY_CLEAN_TIME	CONFIG_REPLAY_CLEAN_TIME
+#else
+#define REPLAY_CLEAN_TIME	168
+#endif
+
+#ifdef CONFIG_REPLAY_SEED
+#define REPLAY_SEED			CONFIG_REPLAY_SEED
+#else
+#define REPLAY_SEED			1
+#endif
+
+/* Same values as the firmware */
+#define PERIOD				500			/*!< Time between two readings in ms */
+
+/* Mains and load of a street light */
+#define VOLTAGE				220.0		/*!< Nominal mains voltage in V */
+#define VOLTAGE_WANDER		5.0			/*!< Slow mains voltage changes around the nominal in V */
+#define VOLTAGE_NOISE		1.5			/*!< Standard deviation of a voltage reading in V */
+#define CURRENT				0.45		/*!< Lamp current in A */
+#define CURRENT_NOISE		0.03		/*!< Relative standard deviation of a current reading */
+
+#define FAULT_MIN			60000		/*!< Earliest fault time in ms, after the load is learnt */
+#define FAULT_MAX			120000		/*!< Latest fault time in ms */
+#define FAULT_TIMEOUT		60000		/*!< A fault not flagged after this time in ms is missed */
+#define ON_MAX				600000		/*!< Longest on time of the clean trace in ms */
+#define OFF_MAX				1800000		/*!< Longest off time of the clean trace in ms */
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef struct
+{
+	double voltage;			/*!< V */
+	double current;			/*!< A, through the closed contacts */
+	bool relay;
+	bool welded;			/*!< Current flows with the relay off */
+} load_t;
+
+typedef struct
+{
+	const char * name;
+	bitec_monitor_anomaly_e anomaly;	/*!< Anomaly the fault must raise */
+	void (* fault)(load_t * load);		/*!< Applied to every reading from the fault time */
+} scenario_t;
+
+/* internal data declaration -------------------------------------------------*/
+
+static uint32_t seed = REPLAY_SEED;
+
+/* internal functions declaration --------------------------------------------*/
+
+static bool replay_fault(const scenario_t * scenario, uint32_t * latency, uint32_t * false_positives);
+static void replay_clean(uint32_t hours);
+static bitec_monitor_sample_t read_load(const load_t * load);
+static double uniform(void);
+static double gaussian(void);
+static void fault_short(load_t * load);
+static void fault_overload(load_t * load);
+static void fault_sag(load_t * load);
+static void fault_swell(load_t * load);
+static void fault_stuck(load_t * load);
+static void fault_step_up(load_t * load);
+static void fault_step_down(load_t * load);
+
+/* Faults replayed in this order */
+static const scenario_t scenarios[] =
+{
+	{ "short_circuit", MONITOR_OVERCURRENT, fault_short },
+	{ "overload", MONITOR_OVERPOWER, fault_overload },
+	{ "sag", MONITOR_SAG, fault_sag },
+	{ "swell", MONITOR_SWELL, fault_swell },
+	{ "stuck", MONITOR_STUCK, fault_stuck },
+	{ "step_up", MONITOR_LOAD_STEP, fault_step_up },
+	{ "step_down", MONITOR_LOAD_STEP, fault_step_down },
+};
+
+/* external functions definition ---------------------------------------------*/
+
+/* Returns the number of faults with missed runs */
+int test_monitor(int argc, char * argv[])
+{
+	int failures = 0;
+
+	printf("monitor: %d runs per fault, a reading every %d ms\n", REPLAY_RUNS, PERIOD);
+	printf("monitor: %-14s %9s %11s %11s %8s\n", "fault", "detected", "mean ms", "max ms", "early");
+
+	for(size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+	{
+		uint32_t detected = 0;
+		uint32_t early = 0;
+		uint64_t latency_sum = 0;
+		uint32_t latency_max = 0;
+
+		for(uint32_t run = 0; run < REPLAY_RUNS; run++)
+		{
+			uint32_t latency;
+
+			if(replay_fault(&scenarios[i], &latency, &early))
+			{
+				detected++;
+				latency_sum += latency;
+
+				if(latency > latency_max)
+					latency_max = latency;
+			}
+		}
+
+		printf("monitor: %-14s %8.1f%% %11.0f %11" PRIu32 " %8" PRIu32 "\n", scenarios[i].name, 100.0 * detected / REPLAY_RUNS,
+				detected ? (double)latency_sum / detected : 0.0, latency_max, early);
+
+		if(detected < REPLAY_RUNS)
+			failures++;
+	}
+
+	replay_clean(REPLAY_CLEAN_TIME);
+
+	return failures;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* Replay one trace of a fault. Returns true if its anomaly was raised in time, with the latency in
+ * ms from the fault time. Anomalies raised before the fault are added to false_positives */
+static bool replay_fault(const scenario_t * scenario, uint32_t * latency, uint32_t * false_positives)
+{
+	bitec_monitor_t monitor;
+	load_t load = { .voltage = VOLTAGE, .current = CURRENT, .relay = true, .welded = false };
+	uint32_t fault = FAULT_MIN + (uint32_t)(uniform() * (FAULT_MAX - FAULT_MIN));
+
+	bitec_monitor_init(&monitor);
+	load.voltage += (uniform() * 2 - 1) * VOLTAGE_WANDER;
+
+	for(uint32_t time = 0; time < fault + FAULT_TIMEOUT; time += PERIOD)
+	{
+		load_t now = load;
+
+		if(time >= fault)
+			scenario->fault(&now);
+
+		bitec_monitor_sample_t sample = read_load(&now);
+		uint32_t raised = bitec_monitor_update(&monitor, &sample);
+
+		if(time < fault)
+		{
+			for(uint32_t bits = raised; bits != 0; bits &= bits - 1)
+				(* false_positives)++;
+		}
+		else if(raised & (1UL << scenario->anomaly))
+		{
+			* latency = time - fault;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Replay hours of a lamp switched on and off with no fault and print the false positives */
+static void replay_clean(uint32_t hours)
+{
+	bitec_monitor_t monitor;
+	load_t load = { .voltage = VOLTAGE, .current = CURRENT, .relay = false, .welded = false };
+	uint64_t end = (uint64_t)hours * 3600000;
+	uint64_t toggle = 0;
+	uint32_t counts[MONITOR_MAX] = { 0 };
+	double wander = 0;
+
+	bitec_monitor_init(&monitor);
+
+	for(uint64_t time = 0; time < end; time += PERIOD)
+	{
+		/* Presence switching the lamp for random times */
+		if(time >= toggle)
+		{
+			load.relay = !load.relay;
+			toggle = time + PERIOD + (uint64_t)(uniform() * (load.relay ? ON_MAX : OFF_MAX));
+		}
+
+		/* Mains voltage following the grid load, a slow random walk */
+		wander += gaussian() * 0.05;
+		wander = wander > VOLTAGE_WANDER ? VOLTAGE_WANDER : wander < -VOLTAGE_WANDER ? -VOLTAGE_WANDER : wander;
+		load.voltage = VOLTAGE + wander;
+
+		bitec_monitor_sample_t sample = read_load(&load);
+		uint32_t raised = bitec_monitor_update(&monitor, &sample);
+
+		for(int i = 0; i < MONITOR_MAX; i++)
+		{
+			if(raised & (1UL << i))
+				counts[i]++;
+		}
+	}
+
+	printf("monitor: %" PRIu32 " h with no fault, false positives per hour\n", hours);
+
+	for(int i = 0; i < MONITOR_MAX; i++)
+		printf("monitor: %-14s %11.4f\n", bitec_monitor_name(i), (double)counts[i] / hours);
+}
+
+/* Readings as the firmware gets them, with noise and the BL0937 resolution */
+static bitec_monitor_sample_t read_load(const load_t * load)
+{
+	bitec_monitor_sample_t sample;
+	double voltage = load->voltage + gaussian() * VOLTAGE_NOISE;
+	double current = load->relay || load->welded ? load->current * (1 + gaussian() * CURRENT_NOISE) : 0;
+
+	sample.voltage = voltage > 0 ? (uint16_t)voltage : 0;
+	sample.current = current > 0 ? (uint32_t)(current * 100) * 10 : 0;
+	sample.power = sample.voltage * sample.current / 1000;
+	sample.relay = load->relay;
+
+	return sample;
+}
+
+/* xorshift32, the same sequence on every machine */
+static double uniform(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return seed / 4294967296.0;
+}
+
+/* Box-Muller */
+static double gaussian(void)
+{
+	double u = uniform();
+
+	while(u == 0)
+		u = uniform();
+
+	return sqrt(-2 * log(u)) * cos(2 * M_PI * uniform());
+}
+
+static void fault_short(load_t * load)
+{
+	load->current = 40;
+}
+
+static void fault_overload(load_t * load)
+{
+	/* A load too big for the circuit, a little above the limits */
+	load->current = 12;
+}
+
+static void fault_sag(load_t * load)
+{
+	load->voltage = 180;
+}
+
+static void fault_swell(load_t * load)
+{
+	load->voltage = 260;
+}
+
+static void fault_stuck(load_t * load)
+{
+	/* Welded contacts, the relay is switched off and the lamp stays on */
+	load->relay = false;
+	load->welded = true;
+}
+
+static void fault_step_up(load_t * load)
+{
+	/* A second lamp on the same circuit */
+	load->current += CURRENT;
+}
+
+static void fault_step_down(load_t * load)
+{
+	/* A failed lamp, the driver alone */
+	load->current = 0.1;
+}
+
+/* end of file ---------------------------------------------------------------*/
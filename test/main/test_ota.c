@@ -0,0 +1,1322 @@
+/*
+ * test_ota.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ *
+ * Firmware updates of a synthetic signed image served by a local HTTP server
+ * stand-in. The server can cut connections, ignore range requests or serve
+ * something else than the image, to check that interrupted downloads resume
+ * and wrong images never boot. Every case reports its throughput and the peak
+ * heap taken by the update, then the self test rollback is checked. Last,
+ * releases of a code-like image are patched from the running one, with the
+ * patch sizes and the rate the new images are rebuilt at, and rollout
+ * descriptors are taken through to the state they end in:
+ *
+ *     smartLight_test.elf ota
+ *
+ * The delta tool builds the patch turning the app image a device runs into a
+ * new one, then applies it in memory the way the device does to check it
+ * before it is published:
+ *
+ *     smartLight_test.elf delta old.bin new.bin patch.bin
+ *
+ * The fleet suite is the download curve of a rollout over a simulated fleet.
+ * Every device takes the descriptor and picks its slot with bitec_ota_rollout,
+ * defers while its relay is on and retries when the server turns it away, as
+ * the firmware does. The server shares its bandwidth between the downloads in
+ * progress and turns away the connections beyond its limit. Each case reports
+ * the peak downloads and bandwidth and the time the fleet takes to update, the
+ * curve per minute is written to a CSV file if one is given:
+ *
+ *     smartLight_test.elf fleet [curve.csv]
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "esp_log.h"
+#include "bitec_ota.h"
+#include "bitec_ota_rollout.h"
+#include "bitec_ota_diff.h"
+#include "bitec_hal_linux.h"
+#include "test.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#ifdef CONFIG_OTA_HARNESS_IMAGE_SIZE
+#define IMAGE_SIZE			CONFIG_OTA_HARNESS_IMAGE_SIZE
+#else
+#define IMAGE_SIZE			983040
+#endif
+
+#ifdef CONFIG_OTA_HARNESS_DROP_SIZE
+#define DROP_SIZE			CONFIG_OTA_HARNESS_DROP_SIZE
+#else
+#define DROP_SIZE			100000
+#endif
+
+#define IMAGE_VERSION		"1.0.1"
+#define DELTA_DROP_SIZE		2048		/*!< Patch bytes per cut connection, patches are small */
+#define PAGE_SIZE			12288		/*!< Error page served in place of the image */
+#define SEND_SIZE			16384		/*!< Bytes sent by the server at a time */
+#define REQUEST_SIZE		1024		/*!< Maximum request size in bytes */
+#define URL_SIZE			64
+#define DESCRIPTOR_SIZE		512
+#define CUT_ALL				UINT32_MAX	/*!< Every connection is cut */
+
+#define CODE_OFFSET			256			/*!< Functions start after the headers and the app description */
+#define CODE_ADDRESS		0x40080000	/*!< Instruction bus address of the image */
+#define DATA_ADDRESS		0x3FFB0000	/*!< Data referenced by literals, it does not move */
+#define ELF_SHA_OFFSET		144			/*!< esp_app_desc_t app_elf_sha256, different on every build */
+#define FUNCTION_MAX		4096
+#define FUNCTION_CALLEES	1500		/*!< Functions called, all of them in every release */
+#define OPCODES				48
+#define FIX_FUNCTION		900			/*!< Function fixed, 48 bytes become 64 others */
+#define FEATURE_AT			600			/*!< Functions added before it */
+#define FEATURE_FUNCTIONS	30
+#define FEATURE_ID			3000		/*!< First id of the added functions */
+#define CHECK_OUT_SIZE		4096		/*!< As CONFIG_BITEC_OTA_CHUNK_SIZE */
+#define CHECK_FEED_SIZE		4096		/*!< Patch bytes fed at a time, as downloaded */
+
+#ifdef CONFIG_FLEET_DEVICES
+#define DEVICES				CONFIG_FLEET_DEVICES
+#else
+#define DEVICES				10000
+#endif
+
+#ifdef CONFIG_FLEET_SERVER_RATE
+#define SERVER_RATE			(CONFIG_FLEET_SERVER_RATE * 1000.0)
+#else
+#define SERVER_RATE			12500000.0
+#endif
+
+#ifdef CONFIG_FLEET_SERVER_CONNECTIONS
+#define SERVER_CONNECTIONS	CONFIG_FLEET_SERVER_CONNECTIONS
+#else
+#define SERVER_CONNECTIONS	1000
+#endif
+
+#ifdef CONFIG_FLEET_DEVICE_RATE
+#define DEVICE_RATE			(CONFIG_FLEET_DEVICE_RATE * 1000.0)
+#else
+#define DEVICE_RATE			100000.0
+#endif
+
+#define WINDOW				3600		/*!< Rollout window in s */
+#define START_TIME			1792000000	/*!< Unix time the descriptor is published at */
+#define DELIVERY_TIME		10000		/*!< The broker reaches the whole fleet within it in ms */
+#define OUTAGE_TIME			7200000		/*!< Offline devices come back together after it in ms */
+#define LOAD_ON_TIME		3600.0		/*!< Mean time a relay stays on in s */
+#define LOAD_OFF_TIME		10800.0		/*!< Mean time a relay stays off in s */
+#define FLEET_STEP			1000		/*!< Simulation step in ms */
+#define TIME_MAX			(48 * 3600 * 1000)
+#define CURVE_MAX			(TIME_MAX / 60000 + 1)
+#define SUMMARY_STEP		10			/*!< Minutes between the lines of the printed curve */
+#define SUMMARY_MAX			180			/*!< Minutes of the printed curve */
+#define ID_SIZE				16
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef enum
+{
+	BODY_IMAGE = 0,
+	BODY_CORRUPTED,			/*!< The image with a byte changed in its middle */
+	BODY_PAGE,				/*!< An HTML page answered with 200 */
+	BODY_NONE,				/*!< Nothing listens on the port */
+	BODY_PATCH,				/*!< Patch from the base image to the release */
+	BODY_PATCH_OTHER,		/*!< Patch from another image than the running one */
+	BODY_PATCH_CORRUPTED	/*!< The patch with a byte changed in its middle */
+} body_e;
+
+/* Synthetic releases, the way code changes between builds */
+typedef enum
+{
+	RELEASE_BASE = 0,
+	RELEASE_VERSION,		/*!< Same code, only the version and the build change */
+	RELEASE_FIX,			/*!< One function fixed and grown, the code after it moves */
+	RELEASE_FEATURE,		/*!< New functions in the middle, called from the old ones */
+	RELEASE_MAX
+} release_e;
+
+typedef struct
+{
+	const char * name;
+	uint32_t chunk_size;
+	uint32_t drop;			/*!< Bytes sent before a connection is cut */
+	uint32_t cuts;			/*!< Connections cut, the following ones are served whole */
+	bool ignore_range;		/*!< Resumes are answered with the whole body */
+	body_e body;
+	esp_err_t expected;
+	release_e release;		/*!< Image a patch rebuilds */
+} scenario_t;
+
+typedef struct
+{
+	const char * name;
+	const char * version;
+	bool digest;			/*!< The descriptor has the digest of the served image */
+	bool busy;				/*!< The server turns every connection away */
+	bitec_ota_rollout_state_e expected;
+} rollout_case_t;
+
+typedef struct
+{
+	pthread_mutex_t mutex;
+	int fd;
+	uint16_t port;
+	const uint8_t * body;
+	size_t body_len;
+	uint32_t drop;
+	uint32_t cuts;
+	bool ignore_range;
+	bool busy;				/*!< Every request is answered 429 */
+	uint32_t requests;
+} server_t;
+
+typedef struct
+{
+	const uint8_t * old;
+	uint32_t old_size;
+	const uint8_t * new;
+	uint32_t new_size;
+	uint32_t offset;		/*!< New image bytes checked */
+} check_t;
+
+typedef enum
+{
+	DEVICE_OFFLINE = 0,		/*!< The descriptor has not reached it yet */
+	DEVICE_WAITING,			/*!< For its slot or a deferral */
+	DEVICE_CONNECTING,
+	DEVICE_DOWNLOADING,
+	DEVICE_DONE				/*!< Updated, or the rollout ended otherwise */
+} device_phase_e;
+
+typedef struct
+{
+	bitec_ota_rollout_t rollout;
+	device_phase_e phase;
+	int64_t online;			/*!< Time the descriptor reaches it in ms */
+	int64_t next;			/*!< Time of the next check or connection in ms */
+	uint32_t attempts;		/*!< Connections turned away in a row */
+	double left;			/*!< Image bytes left to download */
+	bool load;				/*!< Relay on, the update is deferred */
+	int64_t load_next;		/*!< Time the relay switches in ms */
+} device_t;
+
+typedef struct
+{
+	const char * name;
+	bool window;			/*!< Spread over WINDOW, otherwise start equals end */
+	bool loads;				/*!< Relays switch on and off, deferring the update */
+	uint32_t offline;		/*!< Percent of the fleet offline until OUTAGE_TIME */
+} fleet_scenario_t;
+
+typedef struct
+{
+	uint32_t peak;			/*!< Downloads at once */
+	double peak_rate;		/*!< Server bandwidth in B/s */
+	uint32_t turned_away;	/*!< Connections refused as busy */
+	uint32_t defers;
+	uint32_t updated;
+	uint32_t ended;			/*!< Rollouts given up or refused */
+	int64_t times[3];		/*!< 50 %, 90 % and 100 % of the fleet updated in ms, -1 if never */
+	uint32_t active[CURVE_MAX];	/*!< Peak downloads of every minute */
+	uint32_t done[CURVE_MAX];	/*!< Devices updated at the end of every minute */
+} result_t;
+
+/* internal data declaration -------------------------------------------------*/
+
+static server_t server = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+static uint8_t * image;
+static uint8_t * corrupted;
+static uint8_t * page;
+static uint8_t * releases[RELEASE_MAX];
+static uint8_t * patches[RELEASE_MAX];
+static size_t patch_sizes[RELEASE_MAX];
+static uint8_t * patch_other;
+static size_t patch_other_size;
+static uint8_t * patch_corrupted;
+static const char * const release_names[RELEASE_MAX] = { "base", "version", "fix", "feature" };
+static const char * const release_versions[RELEASE_MAX] = { IMAGE_VERSION, "1.0.2", "1.0.2", "1.1.0" };
+static uint32_t function_starts[FUNCTION_MAX];
+
+/* Cases run in this order */
+static const scenario_t scenarios[] =
+{
+	{ "chunk_1k", 1024, 0, 0, false, BODY_IMAGE, ESP_OK },
+	{ "chunk_4k", 4096, 0, 0, false, BODY_IMAGE, ESP_OK },
+	{ "chunk_16k", 16384, 0, 0, false, BODY_IMAGE, ESP_OK },
+	{ "cut", 4096, DROP_SIZE, CUT_ALL, false, BODY_IMAGE, ESP_OK },
+	{ "cut_no_range", 4096, DROP_SIZE * 3, 1, true, BODY_IMAGE, ESP_OK },
+	{ "corrupted", 4096, 0, 0, false, BODY_CORRUPTED, ESP_ERR_INVALID_CRC },
+	{ "error_page", 4096, 0, 0, false, BODY_PAGE, ESP_ERR_INVALID_RESPONSE },
+	{ "server_down", 4096, 0, 0, false, BODY_NONE, ESP_FAIL },
+};
+
+/* Patches of the running base image, run once it is kept */
+static const scenario_t deltas[] =
+{
+	{ "delta_version", 4096, 0, 0, false, BODY_PATCH, ESP_OK, RELEASE_VERSION },
+	{ "delta_fix", 4096, 0, 0, false, BODY_PATCH, ESP_OK, RELEASE_FIX },
+	{ "delta_feature", 4096, 0, 0, false, BODY_PATCH, ESP_OK, RELEASE_FEATURE },
+	{ "delta_1k", 1024, 0, 0, false, BODY_PATCH, ESP_OK, RELEASE_FEATURE },
+	{ "delta_cut", 4096, DELTA_DROP_SIZE, CUT_ALL, false, BODY_PATCH, ESP_OK, RELEASE_FEATURE },
+	{ "delta_other", 4096, 0, 0, false, BODY_PATCH_OTHER, ESP_ERR_INVALID_VERSION, RELEASE_FIX },
+	{ "delta_corrupt", 4096, 0, 0, false, BODY_PATCH_CORRUPTED, ESP_ERR_INVALID_CRC, RELEASE_FEATURE },
+};
+
+/* Rollouts of the feature release while the base image runs */
+static const rollout_case_t rollouts[] =
+{
+	{ "rollout", "1.1.0", true, false, BITEC_OTA_ROLLOUT_READY },
+	{ "rollout_hash", "1.1.0", false, false, BITEC_OTA_ROLLOUT_FAILED },
+	{ "rollout_busy", "1.1.0", true, true, BITEC_OTA_ROLLOUT_DEFERRED },
+	{ "rollout_same", IMAGE_VERSION, true, false, BITEC_OTA_ROLLOUT_CURRENT },
+};
+
+static const fleet_scenario_t fleet_scenarios[] =
+{
+	{ "at_once", false, false, 0 },
+	{ "window", true, false, 0 },
+	{ "window_load", true, true, 0 },
+	{ "outage", true, true, 20 },
+};
+
+#define FLEET_SCENARIO_MAX	(sizeof(fleet_scenarios) / sizeof(fleet_scenarios[0]))
+
+static device_t * devices;
+static result_t results[FLEET_SCENARIO_MAX];
+static uint32_t fleet_seed;
+
+/* internal functions declaration --------------------------------------------*/
+
+static bool run_scenario(const scenario_t * scenario);
+static bool run_rollback(void);
+static bool run_rollout(const rollout_case_t * rollout_case);
+static void rollout_report(const bitec_ota_rollout_t * const me, void * arg);
+static bool patches_build(void);
+static void image_build(uint8_t * data, uint32_t size, release_e release);
+static uint32_t function_id(release_e release, uint32_t index);
+static uint32_t function_size(release_e release, uint32_t id);
+static void function_build(uint8_t * data, uint32_t offset, uint32_t size, release_e release, uint32_t id);
+static uint32_t random_next(uint32_t * seed);
+static void server_start(void);
+static void * server_task(void * arg);
+static void server_reply(int fd);
+static bool send_all(int fd, const uint8_t * data, size_t len);
+static void fleet_run(const fleet_scenario_t * scenario, result_t * result);
+static void device_wait(device_t * device, int64_t t, result_t * result);
+static void curve_write(const char * path);
+static double exp_random(double mean);
+static uint8_t * file_read(const char * path, uint32_t * size);
+static esp_err_t patch_check(const uint8_t * patch, size_t patch_size, check_t * check);
+static esp_err_t check_read(uint32_t offset, void * data, size_t size, void * arg);
+static esp_err_t check_write(const uint8_t * data, size_t size, void * arg);
+static void store_le32(uint8_t * p, uint32_t value);
+static double now_s(void);
+
+/* external functions definition ---------------------------------------------*/
+
+int test_ota(int argc, char * argv[])
+{
+	int failures = 0;
+	hal_ota_handle_t handle;
+
+	for(int i = 0; i < RELEASE_MAX; i++)
+	{
+		releases[i] = malloc(IMAGE_SIZE);
+
+		if(releases[i] == NULL)
+			return 1;
+
+		image_build(releases[i], IMAGE_SIZE, i);
+	}
+
+	image = releases[RELEASE_BASE];
+	corrupted = malloc(IMAGE_SIZE);
+	page = malloc(PAGE_SIZE);
+
+	if(corrupted == NULL || page == NULL || !patches_build())
+		return 1;
+
+	memcpy(corrupted, image, IMAGE_SIZE);
+	corrupted[IMAGE_SIZE / 2] ^= 0x01;
+
+	for(size_t i = 0; i < PAGE_SIZE; i++)
+		page[i] = "<html><body>Not found</body></html>\n"[i % 36];
+
+	server_start();
+
+	/* The fake flash is allocated on its first use, out of the measured heap */
+	if(hal_ota_begin(IMAGE_SIZE, &handle) == ESP_OK)
+		hal_ota_abort(handle);
+
+	printf("ota: %u byte image, %u bytes per cut connection\n", IMAGE_SIZE, DROP_SIZE);
+	printf("ota: %-13s %-26s %8s %8s %9s %8s %8s\n", "case", "result", "bytes", "ms", "MB/s", "heap", "resumes");
+
+	for(size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+	{
+		if(!run_scenario(&scenarios[i]))
+			failures++;
+	}
+
+	if(!run_rollback())
+		failures++;
+
+	/* The base image runs and is kept, the patches rebuild the releases into the other slot */
+	for(size_t i = 0; i < sizeof(deltas) / sizeof(deltas[0]); i++)
+	{
+		if(!run_scenario(&deltas[i]))
+			failures++;
+	}
+
+	for(size_t i = 0; i < sizeof(rollouts) / sizeof(rollouts[0]); i++)
+	{
+		if(!run_rollout(&rollouts[i]))
+			failures++;
+	}
+
+	return failures;
+}
+
+int test_delta(int argc, char * argv[])
+{
+	check_t check = { 0 };
+	uint8_t * patch = NULL;
+	size_t patch_size = 0;
+
+	if(argc != 3)
+	{
+		fprintf(stderr, "usage: delta old.bin new.bin patch.bin\n");
+		return 1;
+	}
+
+	check.old = file_read(argv[0], &check.old_size);
+	check.new = file_read(argv[1], &check.new_size);
+
+	if(check.old == NULL || check.new == NULL)
+		return 1;
+
+	double start = now_s();
+	esp_err_t ret = bitec_ota_diff(check.old, check.old_size, check.new, check.new_size, &patch, &patch_size);
+	double diff_time = now_s() - start;
+
+	if(ret != ESP_OK)
+	{
+		fprintf(stderr, "delta: diff failed: %s\n", esp_err_to_name(ret));
+		return 1;
+	}
+
+	start = now_s();
+	ret = patch_check(patch, patch_size, &check);
+	double apply_time = now_s() - start;
+
+	if(ret != ESP_OK)
+	{
+		fprintf(stderr, "delta: the patch does not rebuild %s: %s\n", argv[1], esp_err_to_name(ret));
+		return 1;
+	}
+
+	FILE * file = fopen(argv[2], "wb");
+
+	if(file == NULL || fwrite(patch, 1, patch_size, file) != patch_size || fclose(file) != 0)
+	{
+		perror(argv[2]);
+		return 1;
+	}
+
+	printf("delta: %" PRIu32 " -> %" PRIu32 " bytes, patch %zu bytes (%.1f%% of the image), diff %.0f ms, apply %.1f MB/s\n",
+			check.old_size, check.new_size, patch_size, 100.0 * patch_size / check.new_size, diff_time * 1000,
+			apply_time > 0 ? check.new_size / apply_time / 1e6 : 0.0);
+
+	free(patch);
+
+	return 0;
+}
+
+int test_fleet(int argc, char * argv[])
+{
+	if(argc > 1)
+	{
+		fprintf(stderr, "usage: fleet [curve.csv]\n");
+		return 1;
+	}
+
+	devices = calloc(DEVICES, sizeof(device_t));
+
+	if(devices == NULL)
+		return 1;
+
+	/* Every device logs its slot and deferrals */
+	esp_log_level_set("*", ESP_LOG_WARN);
+
+	printf("fleet: %u devices, %u byte image, server %.1f MB/s and %u connections, %.0f kB/s per device, %u s window\n",
+			DEVICES, IMAGE_SIZE, SERVER_RATE / 1e6, SERVER_CONNECTIONS, DEVICE_RATE / 1e3, WINDOW);
+	printf("fleet: %-12s %6s %8s %12s %8s %8s %8s %8s %8s\n", "case", "peak", "MB/s", "turned away", "defers",
+			"50% min", "90% min", "all min", "ended");
+
+	for(size_t i = 0; i < FLEET_SCENARIO_MAX; i++)
+	{
+		result_t * result = &results[i];
+
+		fleet_run(&fleet_scenarios[i], result);
+
+		printf("fleet: %-12s %6" PRIu32 " %8.2f %12" PRIu32 " %8" PRIu32, fleet_scenarios[i].name, result->peak,
+				result->peak_rate / 1e6, result->turned_away, result->defers);
+
+		for(int j = 0; j < 3; j++)
+		{
+			if(result->times[j] < 0)
+				printf(" %8s", "-");
+			else
+				printf(" %8.1f", result->times[j] / 60000.0);
+		}
+
+		printf(" %8" PRIu32 "\n", result->ended);
+	}
+
+	/* Downloads at once along the first hours */
+	printf("fleet: %-12s", "minute");
+
+	for(size_t i = 0; i < FLEET_SCENARIO_MAX; i++)
+		printf(" %12s", fleet_scenarios[i].name);
+
+	printf("\n");
+
+	for(int minute = 0; minute < SUMMARY_MAX; minute += SUMMARY_STEP)
+	{
+		printf("fleet: %-12d", minute);
+
+		for(size_t i = 0; i < FLEET_SCENARIO_MAX; i++)
+		{
+			uint32_t peak = 0;
+
+			for(int j = minute; j < minute + SUMMARY_STEP; j++)
+				peak = results[i].active[j] > peak ? results[i].active[j] : peak;
+
+			printf(" %12" PRIu32, peak);
+		}
+
+		printf("\n");
+	}
+
+	if(argc == 1)
+		curve_write(argv[0]);
+
+	free(devices);
+
+	return 0;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static bool run_scenario(const scenario_t * scenario)
+{
+	bitec_ota_t ota;
+	char url[URL_SIZE];
+	uint16_t port = server.port;
+
+	bool delta = scenario->body >= BODY_PATCH;
+	const uint8_t * expected = delta ? releases[scenario->release] : image;
+	const char * version = delta ? release_versions[scenario->release] : IMAGE_VERSION;
+
+	pthread_mutex_lock(&server.mutex);
+
+	switch(scenario->body)
+	{
+		case BODY_CORRUPTED:
+			server.body = corrupted;
+			server.body_len = IMAGE_SIZE;
+			break;
+
+		case BODY_PAGE:
+			server.body = page;
+			server.body_len = PAGE_SIZE;
+			break;
+
+		case BODY_PATCH:
+			server.body = patches[scenario->release];
+			server.body_len = patch_sizes[scenario->release];
+			break;
+
+		case BODY_PATCH_OTHER:
+			server.body = patch_other;
+			server.body_len = patch_other_size;
+			break;
+
+		case BODY_PATCH_CORRUPTED:
+			server.body = patch_corrupted;
+			server.body_len = patch_sizes[scenario->release];
+			break;
+
+		default:
+			server.body = image;
+			server.body_len = IMAGE_SIZE;
+			break;
+	}
+
+	server.drop = scenario->drop;
+	server.cuts = scenario->cuts;
+	server.ignore_range = scenario->ignore_range;
+	server.requests = 0;
+	pthread_mutex_unlock(&server.mutex);
+
+	/* A port nobody listens on, the one of a socket closed at once */
+	if(scenario->body == BODY_NONE)
+	{
+		int fd = socket(AF_INET, SOCK_STREAM, 0);
+		struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+		socklen_t len = sizeof(addr);
+
+		bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+		getsockname(fd, (struct sockaddr *)&addr, &len);
+		port = ntohs(addr.sin_port);
+		close(fd);
+	}
+
+	snprintf(url, sizeof(url), "http://127.0.0.1:%u/firmware.bin", port);
+
+	bitec_ota_init(&ota);
+	ota.chunk_size = scenario->chunk_size;
+	ota.retry_time = 0;
+
+	double start = now_s();
+	esp_err_t ret = delta ? bitec_ota_update_delta(&ota, url) : bitec_ota_update(&ota, url);
+	double time = now_s() - start;
+
+	bool passed = ret == scenario->expected;
+
+	/* A completed update must have written the image as served or as the patch rebuilds it */
+	if(ret == ESP_OK)
+	{
+		const uint8_t * data;
+		int slot = hal_linux_ota_running() == 0 ? 1 : 0;
+
+		passed = passed && hal_linux_ota_slot(slot, &data) == IMAGE_SIZE && !memcmp(data, expected, IMAGE_SIZE) &&
+				!strcmp(ota.image.version, version);
+	}
+
+	/* Downloaded bytes, and the rate the image is written at */
+	printf("ota: %-13s %-26s %8" PRIu32 " %8.1f %9.1f %8u %8" PRIu32 "%s\n", scenario->name, esp_err_to_name(ret), ota.offset,
+			time * 1000, time > 0 ? ota.image.offset / time / 1e6 : 0.0, (unsigned)ota.heap, ota.resumes, passed ? "" : "  FAIL");
+
+	return passed;
+}
+
+/* A new image is rolled back if restarted before its self test passes and kept once it passed */
+static bool run_rollback(void)
+{
+	bitec_ota_t ota;
+	char url[URL_SIZE];
+	bool passed = true;
+
+	pthread_mutex_lock(&server.mutex);
+	server.body = image;
+	server.body_len = IMAGE_SIZE;
+	server.cuts = 0;
+	server.ignore_range = false;
+	pthread_mutex_unlock(&server.mutex);
+
+	snprintf(url, sizeof(url), "http://127.0.0.1:%u/firmware.bin", server.port);
+
+	/* Restarted during its self test, as after a crash */
+	bitec_ota_init(&ota);
+	ota.retry_time = 0;
+	passed = passed && bitec_ota_update(&ota, url) == ESP_OK;
+	hal_linux_ota_restart();
+	bitec_ota_init(&ota);
+	passed = passed && hal_linux_ota_running() == 0 && ota.pending;
+	hal_linux_ota_restart();
+	passed = passed && hal_linux_ota_running() == -1 && !hal_ota_pending();
+	printf("ota: %-13s %s\n", "rollback", passed ? "image restarted during its self test rolled back" : "FAIL");
+
+	/* Self test passed, kept over restarts */
+	bitec_ota_init(&ota);
+	ota.retry_time = 0;
+	passed = passed && bitec_ota_update(&ota, url) == ESP_OK;
+	hal_linux_ota_restart();
+	bitec_ota_init(&ota);
+	bitec_ota_self_test(&ota, true);
+	hal_linux_ota_restart();
+	passed = passed && hal_linux_ota_running() == 0 && !ota.pending && !hal_ota_pending();
+
+	/* The next update goes to the other slot and rolls back to this one */
+	passed = passed && bitec_ota_update(&ota, url) == ESP_OK;
+	hal_linux_ota_restart();
+	passed = passed && hal_linux_ota_running() == 1 && hal_ota_pending();
+	hal_linux_ota_restart();
+	passed = passed && hal_linux_ota_running() == 0;
+	printf("ota: %-13s %s\n", "self_test", passed ? "image passing its self test kept, the next one rolls back to it" : "FAIL");
+
+	return passed;
+}
+
+/* A rollout descriptor from its reception to the state it ends in, the slot is not waited for */
+static bool run_rollout(const rollout_case_t * rollout_case)
+{
+	bitec_ota_t ota;
+	bitec_ota_rollout_t rollout;
+	bitec_ota_sha256_t sha;
+	uint8_t digest[OTA_IMAGE_DIGEST_SIZE];
+	char hex[OTA_IMAGE_DIGEST_SIZE * 2 + 1];
+	char descriptor[DESCRIPTOR_SIZE];
+	uint32_t reports = 0;
+
+	pthread_mutex_lock(&server.mutex);
+	server.body = releases[RELEASE_FEATURE];
+	server.body_len = IMAGE_SIZE;
+	server.cuts = 0;
+	server.ignore_range = false;
+	server.busy = rollout_case->busy;
+	pthread_mutex_unlock(&server.mutex);
+
+	/* Digest of the signed bytes */
+	bitec_ota_sha256_init(&sha);
+	bitec_ota_sha256_update(&sha, releases[RELEASE_FEATURE], IMAGE_SIZE - OTA_IMAGE_SECTOR_SIZE);
+	bitec_ota_sha256_finish(&sha, digest);
+
+	if(!rollout_case->digest)
+		digest[0] ^= 0x01;
+
+	for(int i = 0; i < OTA_IMAGE_DIGEST_SIZE; i++)
+		sprintf(hex + 2 * i, "%02x", digest[i]);
+
+	int len = snprintf(descriptor, sizeof(descriptor), "{\"version\":\"%s\",\"url\":\"http://127.0.0.1:%u/firmware.bin\",\"sha256\":\"%s\"}",
+			rollout_case->version, server.port, hex);
+
+	bitec_ota_init(&ota);
+	ota.retry_time = 0;
+	bitec_ota_rollout_init(&rollout);
+	rollout.report = rollout_report;
+	rollout.arg = (void *)&reports;
+
+	bool passed = bitec_ota_rollout_parse(&rollout, descriptor, len) == ESP_OK;
+	bitec_ota_rollout_schedule(&rollout, "ota-harness", hal_ota_running_version(), -1);
+
+	if(bitec_ota_rollout_check(&rollout, true))
+		bitec_ota_rollout_update(&rollout, &ota);
+
+	passed = passed && rollout.state == rollout_case->expected;
+
+	/* The same descriptor again is not taken, it would restart the rollout */
+	passed = passed && bitec_ota_rollout_parse(&rollout, descriptor, len) == ESP_ERR_INVALID_STATE;
+
+	pthread_mutex_lock(&server.mutex);
+	server.busy = false;
+	pthread_mutex_unlock(&server.mutex);
+
+	printf("ota: %-13s %-26s %8s %2" PRIu32 " reports%s\n", rollout_case->name, bitec_ota_rollout_name(rollout.state),
+			esp_err_to_name(rollout.error), reports, passed ? "" : "  FAIL");
+
+	return passed;
+}
+
+static void rollout_report(const bitec_ota_rollout_t * const me, void * arg)
+{
+	(* (uint32_t *)arg)++;
+}
+
+/* Patches of the releases from the base image, one from another image and a corrupted one */
+static bool patches_build(void)
+{
+	printf("ota: %-13s %8s %8s %8s %8s\n", "release", "image", "patch", "%", "diff ms");
+
+	for(int i = RELEASE_VERSION; i < RELEASE_MAX; i++)
+	{
+		double start = now_s();
+
+		if(bitec_ota_diff(image, IMAGE_SIZE, releases[i], IMAGE_SIZE, &patches[i], &patch_sizes[i]) != ESP_OK)
+			return false;
+
+		printf("ota: %-13s %8u %8zu %8.2f %8.0f\n", release_names[i], IMAGE_SIZE, patch_sizes[i],
+				100.0 * patch_sizes[i] / IMAGE_SIZE, (now_s() - start) * 1000);
+	}
+
+	if(bitec_ota_diff(releases[RELEASE_VERSION], IMAGE_SIZE, releases[RELEASE_FIX], IMAGE_SIZE, &patch_other,
+			&patch_other_size) != ESP_OK)
+		return false;
+
+	patch_corrupted = malloc(patch_sizes[RELEASE_FEATURE]);
+
+	if(patch_corrupted == NULL)
+		return false;
+
+	memcpy(patch_corrupted, patches[RELEASE_FEATURE], patch_sizes[RELEASE_FEATURE]);
+	patch_corrupted[patch_sizes[RELEASE_FEATURE] / 2] ^= 0x01;
+
+	return true;
+}
+
+/* App image header, app description with its version and build, code and the signature sector. The
+ * code is functions of instructions drawn from a few opcodes, with literal pools and calls holding
+ * the addresses of other functions, so code that grows or is inserted moves the addresses after it
+ * as the linker does */
+static void image_build(uint8_t * data, uint32_t size, release_e release)
+{
+	uint32_t signed_size = size - OTA_IMAGE_SECTOR_SIZE;
+	uint32_t count = 0;
+	uint32_t seed = release + 1;
+
+	memset(data, 0, CODE_OFFSET);
+	data[0] = 0xE9;
+	store_le32(data + 32, 0xABCD5432);
+	strncpy((char *)data + 48, release_versions[release], OTA_IMAGE_VERSION_SIZE - 1);
+
+	for(int i = 0; i < OTA_IMAGE_DIGEST_SIZE; i++)
+		data[ELF_SHA_OFFSET + i] = (uint8_t)random_next(&seed);
+
+	/* Laid out first, calls need the addresses of the functions after them */
+	memset(function_starts, 0, sizeof(function_starts));
+
+	for(uint32_t offset = CODE_OFFSET; offset < signed_size && count < FUNCTION_MAX; count++)
+	{
+		uint32_t id = function_id(release, count);
+
+		function_starts[id] = offset;
+		offset += function_size(release, id);
+	}
+
+	for(uint32_t i = 0; i < count; i++)
+	{
+		uint32_t id = function_id(release, i);
+		uint32_t offset = function_starts[id];
+		uint32_t fsize = function_size(release, id);
+		uint8_t code[1024 + 16];
+
+		if(release == RELEASE_FIX && id == FIX_FUNCTION)
+		{
+			/* 48 bytes in the middle become 64 others */
+			uint32_t at = (fsize - 16) / 2 - 24;
+
+			function_build(code, offset, fsize - 16, release, id);
+			memmove(code + at + 64, code + at + 48, fsize - 16 - at - 48);
+
+			for(uint32_t j = at; j < at + 64; j++)
+				code[j] = (uint8_t)random_next(&seed);
+		}
+		else
+			function_build(code, offset, fsize, release, id);
+
+		memcpy(data + offset, code, offset + fsize < signed_size ? fsize : signed_size - offset);
+	}
+
+	/* Signature block with the digest of the image, no key on the host. The rest is erased flash */
+	uint8_t * block = data + signed_size;
+	bitec_ota_sha256_t sha;
+
+	memset(block, 0xFF, OTA_IMAGE_SECTOR_SIZE);
+	memset(block, 0, OTA_IMAGE_BLOCK_SIZE);
+	block[0] = 0xE7;
+	block[1] = 0x02;
+	bitec_ota_sha256_init(&sha);
+	bitec_ota_sha256_update(&sha, data, signed_size);
+	bitec_ota_sha256_finish(&sha, block + 4);
+	store_le32(block + 1196, bitec_ota_crc32(block, 1196));
+}
+
+/* Function at index of the layout of a release */
+static uint32_t function_id(release_e release, uint32_t index)
+{
+	if(release != RELEASE_FEATURE || index < FEATURE_AT)
+		return index;
+
+	if(index < FEATURE_AT + FEATURE_FUNCTIONS)
+		return FEATURE_ID + index - FEATURE_AT;
+
+	return index - FEATURE_FUNCTIONS;
+}
+
+static uint32_t function_size(release_e release, uint32_t id)
+{
+	uint32_t seed = id * 0x9E3779B9 + 1;
+	uint32_t size = (64 + random_next(&seed) % 960) & ~3;
+
+	return release == RELEASE_FIX && id == FIX_FUNCTION ? size + 16 : size;
+}
+
+/* The same bytes in every release but for the addresses of the functions it refers to */
+static void function_build(uint8_t * data, uint32_t offset, uint32_t size, release_e release, uint32_t id)
+{
+	uint32_t seed = id * 0x85EBCA6B + 7;
+	uint32_t literals = 1 + random_next(&seed) % 6;
+	uint32_t pos = 0;
+
+	/* Literal pool, addresses of functions called and of data */
+	for(uint32_t i = 0; i < literals && pos + 4 <= size; i++, pos += 4)
+	{
+		uint32_t r = random_next(&seed);
+		uint32_t value = r & 0x80000000 ? CODE_ADDRESS + function_starts[r % FUNCTION_CALLEES] : DATA_ADDRESS + (r >> 8 & 0x7FFC);
+
+		/* Some old functions call the new ones */
+		if(release == RELEASE_FEATURE && i == 0 && id % 100 == 0 && id < FEATURE_ID)
+			value = CODE_ADDRESS + function_starts[FEATURE_ID + id / 100 % FEATURE_FUNCTIONS];
+
+		store_le32(data + pos, value);
+	}
+
+	while(pos < size)
+	{
+		uint32_t r = random_next(&seed);
+		uint8_t ins[3];
+
+		if((r >> 24) % 8 == 0)
+		{
+			/* Call, its offset is relative to the instruction */
+			int32_t rel = ((int32_t)function_starts[(r >> 4) % FUNCTION_CALLEES] - (int32_t)(offset + pos)) >> 2;
+
+			ins[0] = 0x25 | (rel & 3) << 6;
+			ins[1] = (uint8_t)(rel >> 2);
+			ins[2] = (uint8_t)(rel >> 10);
+		}
+		else
+		{
+			/* Few opcodes are common, registers vary */
+			uint32_t op = ((r % OPCODES < (r >> 8) % OPCODES ? r % OPCODES : (r >> 8) % OPCODES) + 1) * 0x9E3779B9;
+
+			ins[0] = (uint8_t)(op >> 24);
+			ins[1] = (uint8_t)(op >> 16);
+			ins[2] = (uint8_t)(op >> 8) ^ (r >> 20 & 1 ? (r >> 16 & 0x0F) : 0);
+		}
+
+		for(int i = 0; i < 3 && pos < size; i++)
+			data[pos++] = ins[i];
+	}
+}
+
+static uint32_t random_next(uint32_t * seed)
+{
+	* seed ^= * seed << 13;
+	* seed ^= * seed >> 17;
+	* seed ^= * seed << 5;
+
+	return * seed;
+}
+
+static void server_start(void)
+{
+	struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+	socklen_t len = sizeof(addr);
+	pthread_t thread;
+
+	server.fd = socket(AF_INET, SOCK_STREAM, 0);
+
+	if(server.fd < 0 || bind(server.fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(server.fd, 4) != 0)
+	{
+		perror("ota: server");
+		exit(EXIT_FAILURE);
+	}
+
+	getsockname(server.fd, (struct sockaddr *)&addr, &len);
+	server.port = ntohs(addr.sin_port);
+	pthread_create(&thread, NULL, server_task, NULL);
+	pthread_detach(thread);
+}
+
+/* One request per connection, as the client asks */
+static void * server_task(void * arg)
+{
+	for(;;)
+	{
+		int fd = accept(server.fd, NULL, NULL);
+
+		if(fd < 0)
+			continue;
+
+		server_reply(fd);
+		close(fd);
+	}
+
+	return NULL;
+}
+
+static void server_reply(int fd)
+{
+	char request[REQUEST_SIZE];
+	size_t len = 0;
+
+	while(len < sizeof(request) - 1)
+	{
+		ssize_t n = recv(fd, request + len, sizeof(request) - 1 - len, 0);
+
+		if(n <= 0)
+			return;
+
+		len += n;
+		request[len] = '\0';
+
+		if(strstr(request, "\r\n\r\n") != NULL)
+			break;
+	}
+
+	pthread_mutex_lock(&server.mutex);
+	const uint8_t * body = server.body;
+	size_t body_len = server.body_len;
+	uint32_t drop = server.drop;
+	bool cut = server.requests++ < server.cuts;
+	bool ignore_range = server.ignore_range;
+	bool busy = server.busy;
+	pthread_mutex_unlock(&server.mutex);
+
+	/* Turned away as a server at its limit does */
+	if(busy)
+	{
+		const char * reply = "HTTP/1.1 429 Too Many Requests\r\nContent-Length: 0\r\n\r\n";
+		send_all(fd, (const uint8_t *)reply, strlen(reply));
+		return;
+	}
+
+	unsigned long offset = 0;
+	char * range = strstr(request, "Range: bytes=");
+
+	if(range != NULL && !ignore_range)
+		offset = strtoul(range + 13, NULL, 10);
+
+	if(offset > body_len)
+		offset = body_len;
+
+	char header[256];
+	int header_len = snprintf(header, sizeof(header), "HTTP/1.1 %s\r\nContent-Type: application/octet-stream\r\nContent-Length: %lu\r\n\r\n",
+			offset > 0 ? "206 Partial Content" : "200 OK", (unsigned long)(body_len - offset));
+
+	if(!send_all(fd, (const uint8_t *)header, header_len))
+		return;
+
+	size_t end = cut && offset + drop < body_len ? offset + drop : body_len;
+
+	send_all(fd, body + offset, end - offset);
+}
+
+static bool send_all(int fd, const uint8_t * data, size_t len)
+{
+	while(len > 0)
+	{
+		ssize_t n = send(fd, data, len < SEND_SIZE ? len : SEND_SIZE, MSG_NOSIGNAL);
+
+		if(n <= 0)
+			return false;
+
+		data += n;
+		len -= n;
+	}
+
+	return true;
+}
+
+static void fleet_run(const fleet_scenario_t * scenario, result_t * result)
+{
+	char descriptor[DESCRIPTOR_SIZE];
+	char id[ID_SIZE];
+	uint32_t active = 0;
+
+	memset(result, 0, sizeof(result_t));
+	fleet_seed = 0x2545F491;
+
+	int len = snprintf(descriptor, sizeof(descriptor), "{\"version\":\"1.1.0\",\"url\":\"https://firmware.example/smartLight.bin\","
+			"\"sha256\":\"9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08\",\"start\":%u,\"end\":%u}",
+			START_TIME, START_TIME + (scenario->window ? WINDOW : 0));
+
+	for(uint32_t i = 0; i < DEVICES; i++)
+	{
+		device_t * device = &devices[i];
+
+		memset(device, 0, sizeof(device_t));
+		bitec_ota_rollout_init(&device->rollout);
+		device->phase = DEVICE_OFFLINE;
+		device->online = random_next(&fleet_seed) % DELIVERY_TIME;
+
+		if(random_next(&fleet_seed) % 100 < scenario->offline)
+			device->online += OUTAGE_TIME;
+
+		/* Relays on a quarter of the time, as lamps lit in the evening */
+		if(scenario->loads)
+		{
+			device->load = random_next(&fleet_seed) % 4 == 0;
+			device->load_next = (int64_t)(exp_random(device->load ? LOAD_ON_TIME : LOAD_OFF_TIME) * 1000);
+		}
+	}
+
+	for(int64_t t = 0; t <= TIME_MAX && result->updated + result->ended < DEVICES; t += FLEET_STEP)
+	{
+		int64_t now = (int64_t)START_TIME * 1000 + t;
+		uint32_t downloads = active;
+		double rate = downloads > 0 && SERVER_RATE / downloads < DEVICE_RATE ? SERVER_RATE / downloads : DEVICE_RATE;
+
+		for(uint32_t i = 0; i < DEVICES; i++)
+		{
+			device_t * device = &devices[i];
+
+			if(scenario->loads && t >= device->load_next)
+			{
+				device->load = !device->load;
+				device->load_next = t + (int64_t)(exp_random(device->load ? LOAD_ON_TIME : LOAD_OFF_TIME) * 1000);
+			}
+
+			switch(device->phase)
+			{
+				case DEVICE_OFFLINE:
+					if(t < device->online)
+						break;
+
+					snprintf(id, sizeof(id), "fleet-%05" PRIu32, i);
+
+					if(bitec_ota_rollout_parse(&device->rollout, descriptor, len) != ESP_OK)
+					{
+						device->phase = DEVICE_DONE;
+						result->ended++;
+						break;
+					}
+
+					bitec_ota_rollout_schedule(&device->rollout, id, "1.0.1", now);
+					device_wait(device, t, result);
+					break;
+
+				case DEVICE_WAITING:
+					if(t < device->next)
+						break;
+
+					if(bitec_ota_rollout_check(&device->rollout, !device->load))
+					{
+						device->phase = DEVICE_CONNECTING;
+						device->attempts = 0;
+						device->next = t;
+					}
+					else
+						result->defers++;
+
+					device_wait(device, t, result);
+					break;
+
+				case DEVICE_CONNECTING:
+					if(t < device->next)
+						break;
+
+					if(active < SERVER_CONNECTIONS)
+					{
+						device->phase = DEVICE_DOWNLOADING;
+						device->left = IMAGE_SIZE;
+						active++;
+						break;
+					}
+
+					/* As bitec_ota, a refused connection is tried again until retries are spent */
+					result->turned_away++;
+
+					if(++device->attempts <= CONFIG_BITEC_OTA_RETRIES)
+					{
+						device->next = t + CONFIG_BITEC_OTA_RETRY_TIME;
+						break;
+					}
+
+					bitec_ota_rollout_end(&device->rollout, ESP_FAIL);
+					result->defers++;
+					device_wait(device, t, result);
+					break;
+
+				case DEVICE_DOWNLOADING:
+					device->left -= rate * FLEET_STEP / 1000;
+
+					if(device->left > 0)
+						break;
+
+					bitec_ota_rollout_end(&device->rollout, ESP_OK);
+					device->phase = DEVICE_DONE;
+					active--;
+					result->updated++;
+
+					for(int j = 0; j < 3; j++)
+					{
+						static const uint32_t shares[3] = { 50, 90, 100 };
+
+						if(result->times[j] == 0 && (uint64_t)result->updated * 100 >= (uint64_t)DEVICES * shares[j])
+							result->times[j] = t;
+					}
+					break;
+
+				default:
+					break;
+			}
+		}
+
+		if(downloads > result->peak)
+			result->peak = downloads;
+
+		if(downloads * rate > result->peak_rate)
+			result->peak_rate = downloads * rate;
+
+		int minute = t / 60000;
+
+		if(downloads > result->active[minute])
+			result->active[minute] = downloads;
+
+		result->done[minute] = result->updated;
+	}
+
+	for(int j = 0; j < 3; j++)
+	{
+		if(result->times[j] == 0)
+			result->times[j] = -1;
+	}
+}
+
+/* Wait for what the rollout tells, or leave it once it ended without an update */
+static void device_wait(device_t * device, int64_t t, result_t * result)
+{
+	switch(device->rollout.state)
+	{
+		case BITEC_OTA_ROLLOUT_SCHEDULED:
+		case BITEC_OTA_ROLLOUT_DEFERRED:
+			device->phase = DEVICE_WAITING;
+			device->next = t + device->rollout.wait;
+			break;
+
+		case BITEC_OTA_ROLLOUT_DOWNLOADING:
+			break;
+
+		default:
+			device->phase = DEVICE_DONE;
+			result->ended++;
+			break;
+	}
+}
+
+static void curve_write(const char * path)
+{
+	FILE * file = fopen(path, "w");
+
+	if(file == NULL)
+	{
+		perror(path);
+		return;
+	}
+
+	fprintf(file, "minute");
+
+	for(size_t i = 0; i < FLEET_SCENARIO_MAX; i++)
+		fprintf(file, ",%s_downloads,%s_updated", fleet_scenarios[i].name, fleet_scenarios[i].name);
+
+	fprintf(file, "\n");
+
+	for(int minute = 0; minute < CURVE_MAX; minute++)
+	{
+		fprintf(file, "%d", minute);
+
+		for(size_t i = 0; i < FLEET_SCENARIO_MAX; i++)
+			fprintf(file, ",%" PRIu32 ",%" PRIu32, results[i].active[minute], results[i].done[minute]);
+
+		fprintf(file, "\n");
+	}
+
+	fclose(file);
+}
+
+static double exp_random(double mean)
+{
+	/* Never 0, the logarithm stays finite */
+	return -mean * log((random_next(&fleet_seed) + 1.0) / 4294967296.0);
+}
+
+static uint8_t * file_read(const char * path, uint32_t * size)
+{
+	FILE * file = fopen(path, "rb");
+
+	if(file == NULL)
+	{
+		perror(path);
+		return NULL;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long len = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	uint8_t * data = len > 0 ? malloc(len) : NULL;
+
+	if(data == NULL || fread(data, 1, len, file) != (size_t)len)
+	{
+		fprintf(stderr, "delta: can not read %s\n", path);
+		free(data);
+		fclose(file);
+		return NULL;
+	}
+
+	fclose(file);
+	* size = len;
+
+	return data;
+}
+
+/* Apply the patch in downloaded sized pieces and compare what it writes with the new image */
+static esp_err_t patch_check(const uint8_t * patch, size_t patch_size, check_t * check)
+{
+	static bitec_ota_delta_t delta;
+	static uint8_t out[CHECK_OUT_SIZE];
+	esp_err_t ret = ESP_OK;
+
+	bitec_ota_delta_init(&delta, out, sizeof(out), check_read, check_write, check);
+
+	for(size_t i = 0; i < patch_size && ret == ESP_OK; i += CHECK_FEED_SIZE)
+		ret = bitec_ota_delta_feed(&delta, patch + i, patch_size - i < CHECK_FEED_SIZE ? patch_size - i : CHECK_FEED_SIZE);
+
+	if(ret == ESP_OK)
+		ret = bitec_ota_delta_finish(&delta);
+
+	if(ret == ESP_OK && check->offset != check->new_size)
+		ret = ESP_ERR_INVALID_SIZE;
+
+	return ret;
+}
+
+static esp_err_t check_read(uint32_t offset, void * data, size_t size, void * arg)
+{
+	check_t * check = (check_t *)arg;
+
+	if(offset + size > check->old_size)
+		return ESP_ERR_INVALID_SIZE;
+
+	memcpy(data, check->old + offset, size);
+
+	return ESP_OK;
+}
+
+static esp_err_t check_write(const uint8_t * data, size_t size, void * arg)
+{
+	check_t * check = (check_t *)arg;
+
+	if(size > check->new_size - check->offset || memcmp(data, check->new + check->offset, size))
+		return ESP_ERR_INVALID_CRC;
+
+	check->offset += size;
+
+	return ESP_OK;
+}
+
+static void store_le32(uint8_t * p, uint32_t value)
+{
+	p[0] = (uint8_t)value;
+	p[1] = (uint8_t)(value >> 8);
+	p[2] = (uint8_t)(value >> 16);
+	p[3] = (uint8_t)(value >> 24);
+}
+
+static double now_s(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,290 @@
+/*
+ * test_relay.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ *
+ * Decisions of bitec_relay_logic_update() on input sequences, with the times
+ * of the Kconfig defaults. Every case checks the output and the wait asked for
+ * after each update, and the counters the relay publishes: the illumination
+ * hysteresis between the dark and bright levels, the presence hold after the
+ * sensor clears, switches deferred during the minimum on and off times and
+ * cancelled when the request goes back, a trip overriding them, and random
+ * requests that never break a dwell time:
+ *
+ *     smartLight_test.elf relay
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "bitec_relay_logic.h"
+#include "test.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define DARK_LEVEL			2000		/*!< As the Kconfig defaults, the expected decisions depend on them */
+#define BRIGHT_LEVEL		4000
+#define MIN_ON_TIME			5000
+#define MIN_OFF_TIME		2000
+#define HOLD_TIME			30000
+#define TRIP_TIME			60000
+#define START				0xFFFF0000	/*!< Times wrap during the cases */
+#define RANDOM_TIME			3600000		/*!< Length of the random requests in ms */
+#define RANDOM_STEP			100			/*!< Between their updates in ms */
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static bitec_relay_logic_t logic;
+static uint32_t wait;
+static uint32_t seed;
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static bool run_hysteresis(const char * * note);
+static bool run_hold(const char * * note);
+static bool run_dwell(const char * * note);
+static bool run_trip(const char * * note);
+static bool run_random(const char * * note);
+static void start(void);
+static bool update(uint32_t time);
+static uint32_t random_next(void);
+
+/* internal data definition --------------------------------------------------*/
+
+static const test_case_t cases[] =
+{
+	{ "hysteresis", run_hysteresis },
+	{ "hold", run_hold },
+	{ "dwell", run_dwell },
+	{ "trip", run_trip },
+	{ "random", run_random },
+};
+
+/* external functions definition ---------------------------------------------*/
+
+int test_relay(int argc, char * argv[])
+{
+	return test_run("relay", cases, sizeof(cases) / sizeof(cases[0]));
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* A presence in the band between the levels keeps the last state, the lamp light does not switch it off */
+static bool run_hysteresis(const char * * note)
+{
+	bool passed;
+
+	start();
+	bitec_relay_logic_presence(&logic, true, START);
+	bitec_relay_logic_illumination(&logic, 3000);
+	passed = !update(0);
+	bitec_relay_logic_illumination(&logic, DARK_LEVEL);
+	passed = passed && !update(1000);
+	bitec_relay_logic_illumination(&logic, DARK_LEVEL - 1);
+	passed = passed && update(2000) && wait == 0;
+
+	/* The lamp lights the sensor up to the bright level */
+	bitec_relay_logic_illumination(&logic, 3999);
+	passed = passed && update(10000);
+	bitec_relay_logic_illumination(&logic, BRIGHT_LEVEL);
+	passed = passed && update(11000);
+	bitec_relay_logic_illumination(&logic, BRIGHT_LEVEL + 1);
+	passed = passed && !update(12000);
+
+	/* And back down from it */
+	bitec_relay_logic_illumination(&logic, 2500);
+	passed = passed && !update(20000);
+	bitec_relay_logic_illumination(&logic, DARK_LEVEL);
+	passed = passed && !update(21000);
+	bitec_relay_logic_illumination(&logic, DARK_LEVEL - 1);
+	passed = passed && update(22000);
+
+	passed = passed && logic.switches == 3 && logic.deferred == 0 && logic.cancelled == 0;
+	*note = test_note("on below %d, off above %d, %" PRIu32 " switches and the band between kept", DARK_LEVEL, BRIGHT_LEVEL,
+			logic.switches);
+
+	return passed;
+}
+
+/* On until the hold time after the sensor clears, a presence within it keeps the relay on */
+static bool run_hold(const char * * note)
+{
+	bool passed;
+
+	start();
+	bitec_relay_logic_illumination(&logic, DARK_LEVEL - 1);
+	bitec_relay_logic_presence(&logic, true, START);
+	passed = update(0);
+
+	bitec_relay_logic_presence(&logic, false, START + 10000);
+	passed = passed && update(10000) && wait == HOLD_TIME;
+	passed = passed && update(10000 + HOLD_TIME - 1) && wait == 1;
+	passed = passed && !update(10000 + HOLD_TIME) && wait == 0;
+
+	/* Back within the hold */
+	bitec_relay_logic_presence(&logic, true, START + 45000);
+	passed = passed && update(45000);
+	bitec_relay_logic_presence(&logic, false, START + 50000);
+	passed = passed && update(50000);
+	bitec_relay_logic_presence(&logic, true, START + 50000 + HOLD_TIME - 1000);
+	passed = passed && update(50000 + HOLD_TIME - 1000) && wait == 0;
+	passed = passed && update(50000 + 2 * HOLD_TIME);
+
+	/* Light in the room ends the hold with the relay */
+	bitec_relay_logic_presence(&logic, false, START + 200000);
+	bitec_relay_logic_illumination(&logic, BRIGHT_LEVEL + 1);
+	passed = passed && !update(200000);
+
+	passed = passed && logic.switches == 4 && logic.deferred == 0;
+	*note = test_note("on for %d ms after the sensor clears, a presence within it keeps it on", HOLD_TIME);
+
+	return passed;
+}
+
+/* Requests within the minimum times wait for them once, going back cancels them */
+static bool run_dwell(const char * * note)
+{
+	bool passed;
+
+	start();
+	bitec_relay_logic_force(&logic, 1);
+	passed = update(0) && logic.switches == 1;
+
+	/* Off within the minimum on time */
+	bitec_relay_logic_force(&logic, 0);
+	passed = passed && update(1000) && wait == MIN_ON_TIME - 1000 && logic.deferred == 1;
+	passed = passed && update(3000) && wait == MIN_ON_TIME - 3000 && logic.deferred == 1;
+	passed = passed && !update(MIN_ON_TIME) && wait == 0 && logic.switches == 2;
+
+	/* On within the minimum off time, withdrawn and asked again */
+	bitec_relay_logic_force(&logic, 1);
+	passed = passed && !update(MIN_ON_TIME + 500) && wait == MIN_OFF_TIME - 500 && logic.deferred == 2;
+	bitec_relay_logic_force(&logic, 0);
+	passed = passed && !update(MIN_ON_TIME + 1000) && wait == 0 && logic.cancelled == 1;
+	bitec_relay_logic_force(&logic, 1);
+	passed = passed && !update(MIN_ON_TIME + 1500) && wait == MIN_OFF_TIME - 1500 && logic.deferred == 3;
+	passed = passed && update(MIN_ON_TIME + MIN_OFF_TIME) && wait == 0 && logic.switches == 3;
+
+	/* The automatic output back in place of the rule waits as well */
+	bitec_relay_logic_force(&logic, -1);
+	passed = passed && update(MIN_ON_TIME + MIN_OFF_TIME + 1000) && logic.deferred == 4;
+	passed = passed && !update(2 * MIN_ON_TIME + MIN_OFF_TIME) && logic.switches == 4 && logic.cancelled == 1;
+
+	*note = test_note("%" PRIu32 " switches, %" PRIu32 " deferred by %d/%d ms and %" PRIu32 " cancelled", logic.switches,
+			logic.deferred, MIN_ON_TIME, MIN_OFF_TIME, logic.cancelled);
+
+	return passed;
+}
+
+/* A trip switches off within the minimum on time and keeps off for the trip time */
+static bool run_trip(const char * * note)
+{
+	bool passed;
+
+	start();
+	bitec_relay_logic_force(&logic, 1);
+	passed = update(0);
+
+	bitec_relay_logic_trip(&logic, START + 1000);
+	passed = passed && !update(1000) && wait == TRIP_TIME && logic.switches == 2 && logic.deferred == 0;
+	passed = passed && !update(1000 + TRIP_TIME - 1) && wait == 1;
+	passed = passed && update(1000 + TRIP_TIME) && wait == 0 && logic.switches == 3 && logic.trips == 1;
+
+	/* Time on up to the last update */
+	passed = passed && logic.on_time == 1000 && update(2000 + TRIP_TIME) && logic.on_time == 2000;
+	*note = test_note("off at once for %d ms whatever the dwell times, then on again", TRIP_TIME);
+
+	return passed;
+}
+
+/* Random requests, updated on a period and when the wait asks for it */
+static bool run_random(const char * * note)
+{
+	bool passed = true;
+	uint32_t next_change = 0;
+	uint32_t next_update = 0;
+	uint32_t changes = 0;
+	uint64_t on_time = 0;
+	uint32_t last_switch = 0;
+	uint32_t last_update = 0;
+	bool output = false;
+
+	start();
+	seed = 0x2545F491;
+
+	for(uint32_t time = 0; time <= RANDOM_TIME && passed; time++)
+	{
+		if(time == next_change)
+		{
+			bitec_relay_logic_force(&logic, (int8_t)(random_next() % 3) - 1);
+			bitec_relay_logic_presence(&logic, random_next() % 2, START + time);
+			bitec_relay_logic_illumination(&logic, random_next() % 6000);
+			next_change = time + 1 + random_next() % 4000;
+			next_update = time;
+		}
+
+		if(time != next_update)
+			continue;
+
+		bool previous = output;
+
+		output = update(time);
+		next_update = time + (wait > 0 && wait < RANDOM_STEP ? wait : RANDOM_STEP);
+		on_time += previous ? time - last_update : 0;
+		last_update = time;
+
+		if(output == previous)
+			continue;
+
+		/* The first switch has no dwell time to keep */
+		passed = changes == 0 || time - last_switch >= (previous ? MIN_ON_TIME : MIN_OFF_TIME);
+		changes++;
+		last_switch = time;
+	}
+
+	passed = passed && logic.switches == changes && logic.cancelled <= logic.deferred && logic.deferred > 0 &&
+			logic.cancelled > 0 && logic.on_time == on_time;
+	*note = test_note("%" PRIu32 " switches, %" PRIu32 " deferred and %" PRIu32 " cancelled in an hour, no dwell time broken",
+			logic.switches, logic.deferred, logic.cancelled);
+
+	return passed;
+}
+
+static void start(void)
+{
+	memset(&logic, 0, sizeof(logic));
+	logic.dark_level = DARK_LEVEL;
+	logic.bright_level = BRIGHT_LEVEL;
+	logic.min_on_time = MIN_ON_TIME;
+	logic.min_off_time = MIN_OFF_TIME;
+	logic.hold_time = HOLD_TIME;
+	logic.trip_time = TRIP_TIME;
+	bitec_relay_logic_init(&logic, START);
+}
+
+/* Update at time ms from the start */
+static bool update(uint32_t time)
+{
+	return bitec_relay_logic_update(&logic, START + time, &wait);
+}
+
+/* xorshift32 */
+static uint32_t random_next(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return seed;
+}
+
+/* end of file ---------------------------------------------------------------*/
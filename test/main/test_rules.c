@@ -0,0 +1,720 @@
+/*
+ * test_rules.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ *
+ * Loading and evaluation of bitec_rules programs. The check of a program when
+ * it is loaded is the only guard on the bytecode received over MQTT, every
+ * case but the last ones feeds it programs one fault away from a valid one:
+ * skips past the end or onto an operand, paths reaching an instruction with
+ * other stack depths, stack underflows and overflows, variables and events
+ * out of their tables, a missing or early END and a wrong rule count. Every
+ * single byte change of the sample program and random instruction streams
+ * are then cross checked against a walk of all their paths, a rejected
+ * program keeps the loaded one, and the outputs of the evaluation and the
+ * stored program are checked:
+ *
+ *     smartLight_test.elf rules
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "bitec_rules.h"
+#include "bitec_hal.h"
+#include "esp_log.h"
+#include "test.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define V					RULES_VERSION
+#define PROGRAM(...)		{ (const uint8_t[]){ __VA_ARGS__ }, sizeof((const uint8_t[]){ __VA_ARGS__ }) }
+#define PROGRAMS_NUM(p)		(sizeof(p) / sizeof(p[0]))
+#define PUBLISH_MAX			32			/*!< Events of a program, as bitec_rules */
+#define RANDOM_PROGRAMS		200000
+#define RANDOM_LENGTH		24			/*!< Instructions of a random program at most */
+#define WALK_STATES			(RULES_SIZE * (RULES_STACK + 1))
+#define NVS_PARTITION		"settings"	/*!< Where bitec_rules stores its program */
+#define NVS_NAMESPACE		"rules"
+#define NVS_KEY				"program"
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef struct
+{
+	const uint8_t * code;
+	size_t size;
+} program_t;
+
+/* Operands and stack effect of an instruction, as documented in bitec_rules.h */
+typedef struct
+{
+	bool valid;
+	uint8_t operands;
+	uint8_t pops;
+	uint8_t pushes;
+} op_info_t;
+
+/* internal data declaration -------------------------------------------------*/
+
+static bitec_rules_t rules;
+static uint32_t seed;
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static bool run_jumps(const char * * note);
+static bool run_stack(const char * * note);
+static bool run_operands(const char * * note);
+static bool run_structure(const char * * note);
+static bool run_mutations(const char * * note);
+static bool run_random(const char * * note);
+static bool run_kept(const char * * note);
+static bool run_eval(const char * * note);
+static bool run_operators(const char * * note);
+static bool run_store(const char * * note);
+static bool programs_check(const program_t * accepted, size_t accepted_num, const program_t * rejected, size_t rejected_num);
+static bool load(const uint8_t * code, size_t size);
+static op_info_t op_info(uint8_t op);
+static bool walk(const uint8_t * code, size_t size);
+static int32_t eval_relay(const uint8_t * code, size_t size, const int32_t * vars);
+static uint32_t random_next(void);
+
+/* internal data definition --------------------------------------------------*/
+
+/* The program of sim/profiles/rules.txt: power above 100 VA raises event 1, the relay follows a
+ * presence below 3500 of light, and the LED is blue while the light is on */
+static const uint8_t sample[] =
+{
+	V, 3,
+	RULES_OP_RULE, RULES_OP_LOAD, RULES_VAR_POWER, RULES_OP_PUSH16, 100, 0, RULES_OP_GT, RULES_OP_SKIPZ, 2, RULES_OP_PUBLISH, 1,
+	RULES_OP_RULE, RULES_OP_LOAD, RULES_VAR_PRESENCE, RULES_OP_LOAD, RULES_VAR_ILLUMINATION, RULES_OP_PUSH16, 0xAC, 0x0D,
+	RULES_OP_LT, RULES_OP_AND, RULES_OP_RELAY,
+	RULES_OP_RULE, RULES_OP_LOAD, RULES_VAR_LIGHT, RULES_OP_SKIPZ, 4, RULES_OP_LED, 0, 0, 64,
+	RULES_OP_END,
+};
+
+static const program_t jumps_accepted[] =
+{
+	/* To the next instruction and to END */
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUSH8, 1, RULES_OP_SKIPZ, 0, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUSH8, 1, RULES_OP_SKIPZ, 3, RULES_OP_PUSH8, 1, RULES_OP_RELAY, RULES_OP_END),
+	/* Two skips to the same instruction at the same depth */
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUSH8, 1, RULES_OP_SKIPZ, 4, RULES_OP_PUSH8, 0, RULES_OP_SKIPZ, 0,
+			RULES_OP_PUBLISH, 3, RULES_OP_END),
+};
+
+static const program_t jumps_rejected[] =
+{
+	/* One past the end */
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUSH8, 1, RULES_OP_SKIPZ, 1, RULES_OP_END),
+	/* 255, a jump back by one if the offset were signed */
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUSH8, 1, RULES_OP_SKIPZ, 0xFF, RULES_OP_END),
+	/* Onto the operand of a PUSH8, of a PUSH32 and of a LED */
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUSH8, 1, RULES_OP_SKIPZ, 1, RULES_OP_PUSH8, RULES_OP_END, RULES_OP_RELAY, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUSH8, 1, RULES_OP_SKIPZ, 3, RULES_OP_PUSH32, 0, 0, 0, 0, RULES_OP_RELAY, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUSH8, 1, RULES_OP_SKIPZ, 1, RULES_OP_LED, 0, 0, 0, RULES_OP_END),
+	/* Skipped and run paths at other depths, where they meet and at END */
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUSH8, 1, RULES_OP_SKIPZ, 2, RULES_OP_PUSH8, 1, RULES_OP_RELAY, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUSH8, 1, RULES_OP_SKIPZ, 2, RULES_OP_PUSH8, 1, RULES_OP_END),
+	/* Two skips to the same instruction at other depths */
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUSH8, 1, RULES_OP_PUSH8, 1, RULES_OP_SKIPZ, 4, RULES_OP_SKIPZ, 2, RULES_OP_PUSH8, 1,
+			RULES_OP_RELAY, RULES_OP_END),
+};
+
+static const program_t stack_accepted[] =
+{
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUSH8, 5, RULES_OP_PUSH8, 1, RULES_OP_PUSH8, 9, RULES_OP_WITHIN, RULES_OP_NOT,
+			RULES_OP_RELAY, RULES_OP_END),
+};
+
+static const program_t stack_rejected[] =
+{
+	/* Underflows of every stack effect */
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_RELAY, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_NOT, RULES_OP_RELAY, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUSH8, 1, RULES_OP_AND, RULES_OP_RELAY, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUSH8, 1, RULES_OP_PUSH8, 1, RULES_OP_WITHIN, RULES_OP_RELAY, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_SKIPZ, 0, RULES_OP_END),
+	/* Values left at a rule and at END */
+	PROGRAM(V, 2, RULES_OP_RULE, RULES_OP_PUSH8, 1, RULES_OP_RULE, RULES_OP_RELAY, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUSH8, 1, RULES_OP_END),
+};
+
+static const program_t operands_accepted[] =
+{
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_LOAD, RULES_VAR_MAX - 1, RULES_OP_RELAY, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUBLISH, PUBLISH_MAX - 1, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUSH32, 0xFF, 0xFF, 0xFF, 0x7F, RULES_OP_RELAY, RULES_OP_END),
+};
+
+static const program_t operands_rejected[] =
+{
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_LOAD, RULES_VAR_MAX, RULES_OP_RELAY, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_LOAD, 0xFF, RULES_OP_RELAY, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUBLISH, PUBLISH_MAX, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUBLISH, 0xFF, RULES_OP_END),
+	/* Operands running into END or past the end */
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUSH32, 1, 2, 3, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_LED, 1, 2, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUSH16, 1),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUBLISH),
+};
+
+static const program_t structure_accepted[] =
+{
+	PROGRAM(V, 0, RULES_OP_END),
+	PROGRAM(V, 2, RULES_OP_RULE, RULES_OP_RULE, RULES_OP_END),
+};
+
+static const program_t structure_rejected[] =
+{
+	/* Empty, header alone, other version */
+	PROGRAM(V),
+	PROGRAM(V, 0),
+	PROGRAM(V + 1, 0, RULES_OP_END),
+	PROGRAM(0, 0, RULES_OP_END),
+	/* No END, bytes after it */
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUSH8, 1, RULES_OP_RELAY),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_END, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_END, RULES_OP_RULE),
+	/* More and fewer rules than the header tells */
+	PROGRAM(V, 2, RULES_OP_RULE, RULES_OP_END),
+	PROGRAM(V, 0, RULES_OP_RULE, RULES_OP_END),
+	PROGRAM(V, 255, RULES_OP_RULE, RULES_OP_END),
+	/* Unknown instructions */
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_LOAD + 1, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_WITHIN + 1, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_SKIPZ + 1, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, RULES_OP_PUBLISH + 1, RULES_OP_END),
+	PROGRAM(V, 1, RULES_OP_RULE, 0xFF, RULES_OP_END),
+};
+
+static const test_case_t cases[] =
+{
+	{ "jumps", run_jumps },
+	{ "stack", run_stack },
+	{ "operands", run_operands },
+	{ "structure", run_structure },
+	{ "mutations", run_mutations },
+	{ "random", run_random },
+	{ "kept", run_kept },
+	{ "eval", run_eval },
+	{ "operators", run_operators },
+	{ "store", run_store },
+};
+
+/* external functions definition ---------------------------------------------*/
+
+int test_rules(int argc, char * argv[])
+{
+	/* Every accepted program logs its size */
+	esp_log_level_set("*", ESP_LOG_WARN);
+
+	return test_run("rules", cases, sizeof(cases) / sizeof(cases[0]));
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static bool run_jumps(const char * * note)
+{
+	*note = "skips past the end, onto operands or meeting other depths rejected";
+
+	return programs_check(jumps_accepted, PROGRAMS_NUM(jumps_accepted), jumps_rejected, PROGRAMS_NUM(jumps_rejected));
+}
+
+/* The fixed programs, then RULES_STACK values taken and one more */
+static bool run_stack(const char * * note)
+{
+	bool passed = programs_check(stack_accepted, PROGRAMS_NUM(stack_accepted), stack_rejected, PROGRAMS_NUM(stack_rejected));
+
+	for(int values = RULES_STACK; values <= RULES_STACK + 1; values++)
+	{
+		uint8_t code[3 * (RULES_STACK + 1) + 4];
+		size_t size = 0;
+
+		code[size++] = V;
+		code[size++] = 1;
+		code[size++] = RULES_OP_RULE;
+
+		for(int i = 0; i < values; i++)
+		{
+			code[size++] = RULES_OP_PUSH8;
+			code[size++] = 1;
+		}
+
+		/* Folded into one value for RELAY */
+		memset(code + size, RULES_OP_AND, values - 1);
+		size += values - 1;
+		code[size++] = RULES_OP_RELAY;
+		code[size++] = RULES_OP_END;
+		passed = passed && load(code, size) == (values <= RULES_STACK);
+	}
+
+	*note = test_note("underflows of every instruction, %d values taken and %d rejected", RULES_STACK, RULES_STACK + 1);
+
+	return passed;
+}
+static bool run_operands(const char * * note)
+{
+	*note = test_note("variables up to %d and events up to %d, operands cut by END or the end rejected", RULES_VAR_MAX - 1,
+			PUBLISH_MAX - 1);
+
+	return programs_check(operands_accepted, PROGRAMS_NUM(operands_accepted), operands_rejected, PROGRAMS_NUM(operands_rejected));
+}
+
+/* The fixed programs, then one of RULES_SIZE bytes and one longer */
+static bool run_structure(const char * * note)
+{
+	static uint8_t code[RULES_SIZE + 2];
+	size_t size = 0;
+	bool passed = programs_check(structure_accepted, PROGRAMS_NUM(structure_accepted), structure_rejected,
+			PROGRAMS_NUM(structure_rejected));
+
+	code[size++] = V;
+	code[size++] = 1;
+	code[size++] = RULES_OP_RULE;
+
+	while(RULES_SIZE - 1 - size >= 2)
+	{
+		code[size++] = RULES_OP_PUBLISH;
+		code[size++] = 0;
+	}
+
+	if(RULES_SIZE - 1 - size == 1)
+	{
+		code[size++] = RULES_OP_RULE;
+		code[1]++;
+	}
+
+	code[size++] = RULES_OP_END;
+	passed = passed && size == RULES_SIZE && load(code, size);
+
+	code[size - 1] = RULES_OP_PUBLISH;
+	code[size++] = 0;
+	code[size++] = RULES_OP_END;
+	passed = passed && !load(code, size);
+
+	*note = test_note("headers, END, rule counts and unknown instructions, %d bytes taken and %d rejected", RULES_SIZE,
+			RULES_SIZE + 2);
+
+	return passed;
+}
+
+/* Every program a byte away from the sample one, the accepted ones are safe on every path */
+static bool run_mutations(const char * * note)
+{
+	uint8_t code[sizeof(sample)];
+	uint32_t accepted = 0;
+	uint32_t total = 0;
+	bool passed = true;
+
+	for(size_t i = 0; i < sizeof(sample) && passed; i++)
+	{
+		for(int value = 0; value < 256 && passed; value++)
+		{
+			if(value == sample[i])
+				continue;
+
+			memcpy(code, sample, sizeof(sample));
+			code[i] = value;
+			total++;
+
+			if(load(code, sizeof(code)))
+			{
+				accepted++;
+				passed = walk(code, sizeof(code));
+
+				if(!passed)
+					printf("rules: byte %zu set to 0x%02x accepted, unsafe\n", i, value);
+			}
+		}
+	}
+
+	*note = test_note("%" PRIu32 " of %" PRIu32 " single byte changes accepted, all of them safe", accepted, total);
+
+	return passed;
+}
+
+/* Streams of random instructions, mostly with the values they take on the stack and with operands
+ * in range, the accepted ones are safe on every path */
+static bool run_random(const char * * note)
+{
+	static const uint8_t ops[] =
+	{
+		RULES_OP_END, RULES_OP_RULE, RULES_OP_PUSH8, RULES_OP_PUSH16, RULES_OP_PUSH32, RULES_OP_LOAD, RULES_OP_LT, RULES_OP_LE,
+		RULES_OP_GT, RULES_OP_GE, RULES_OP_EQ, RULES_OP_NE, RULES_OP_AND, RULES_OP_OR, RULES_OP_NOT, RULES_OP_WITHIN, RULES_OP_SKIPZ,
+		RULES_OP_RELAY, RULES_OP_LED, RULES_OP_PUBLISH,
+	};
+	uint8_t code[RULES_SIZE];
+	uint32_t accepted = 0;
+	bool passed = true;
+
+	seed = 0x9E3779B9;
+
+	for(uint32_t n = 0; n < RANDOM_PROGRAMS && passed; n++)
+	{
+		size_t size = 2;
+		int length = 1 + random_next() % RANDOM_LENGTH;
+		int depth = 0;
+		uint8_t count = 1;
+
+		code[0] = V;
+		code[size++] = RULES_OP_RULE;
+
+		for(int i = 0; i < length && size + RULES_STACK + 6 < sizeof(code); i++)
+		{
+			uint8_t op = ops[random_next() % sizeof(ops)];
+			op_info_t info = op_info(op);
+
+			if(depth < info.pops && random_next() % 16 != 0)
+				continue;
+
+			if(op == RULES_OP_END && random_next() % 16 != 0)
+				continue;
+
+			code[size++] = op;
+			count += op == RULES_OP_RULE;
+			depth += info.pushes - info.pops;
+
+			for(int j = 0; j < info.operands; j++)
+			{
+				uint32_t r = random_next();
+
+				code[size++] = (r & 0x300) == 0 ? (uint8_t)r : (uint8_t)(r % (op == RULES_OP_LOAD ? RULES_VAR_MAX + 1 : 12));
+			}
+		}
+
+		/* The values left taken by the relay */
+		while(depth-- > 0 && random_next() % 16 != 0)
+			code[size++] = RULES_OP_RELAY;
+
+		code[size++] = RULES_OP_END;
+		code[1] = random_next() % 16 == 0 ? count + 1 : count;
+
+		if(load(code, size))
+		{
+			accepted++;
+			passed = walk(code, size);
+
+			if(!passed)
+				printf("rules: random program %" PRIu32 " accepted, unsafe\n", n);
+		}
+	}
+
+	passed = passed && accepted > RANDOM_PROGRAMS / 10;
+	*note = test_note("%" PRIu32 " of %d random programs accepted, all of them safe", accepted, RANDOM_PROGRAMS);
+
+	return passed;
+}
+
+/* A rejected program leaves the loaded one running */
+static bool run_kept(const char * * note)
+{
+	int32_t vars[RULES_VAR_MAX] = { [RULES_VAR_PRESENCE] = 1, [RULES_VAR_ILLUMINATION] = 1000 };
+	bitec_rules_output_t output;
+	bool passed;
+
+	bitec_rules_clear(&rules);
+	passed = load(sample, sizeof(sample)) && bitec_rules_count(&rules) == 3;
+
+	for(size_t i = 0; i < PROGRAMS_NUM(jumps_rejected) && passed; i++)
+		passed = bitec_rules_load(&rules, jumps_rejected[i].code, jumps_rejected[i].size) == ESP_ERR_INVALID_ARG;
+
+	bitec_rules_eval(&rules, vars, &output);
+	passed = passed && bitec_rules_count(&rules) == 3 && rules.size == sizeof(sample) && output.relay == 1;
+	*note = "the sample program still runs after every rejected load";
+
+	return passed;
+}
+
+/* The sample program on a few readings, the event is published once per raise */
+static bool run_eval(const char * * note)
+{
+	int32_t vars[RULES_VAR_MAX] = { 0 };
+	bitec_rules_output_t output;
+	uint32_t evaluations = rules.evaluations;
+	bool passed;
+
+	/* Nothing acts without a program */
+	bitec_rules_clear(&rules);
+	bitec_rules_eval(&rules, vars, &output);
+	passed = output.relay == -1 && !output.led && output.publish == 0;
+
+	passed = passed && load(sample, sizeof(sample));
+	vars[RULES_VAR_PRESENCE] = 1;
+	vars[RULES_VAR_ILLUMINATION] = 3499;
+	bitec_rules_eval(&rules, vars, &output);
+	passed = passed && output.relay == 1 && !output.led && output.publish == 0;
+
+	vars[RULES_VAR_ILLUMINATION] = 3500;
+	vars[RULES_VAR_LIGHT] = 1;
+	bitec_rules_eval(&rules, vars, &output);
+	passed = passed && output.relay == 0 && output.led && output.red == 0 && output.green == 0 && output.blue == 64;
+
+	/* Raised, kept, cleared and raised again */
+	vars[RULES_VAR_POWER] = 101;
+	bitec_rules_eval(&rules, vars, &output);
+	passed = passed && output.publish == 1UL << 1;
+	bitec_rules_eval(&rules, vars, &output);
+	passed = passed && output.publish == 0;
+	vars[RULES_VAR_POWER] = 100;
+	bitec_rules_eval(&rules, vars, &output);
+	passed = passed && output.publish == 0;
+	vars[RULES_VAR_POWER] = 150;
+	bitec_rules_eval(&rules, vars, &output);
+	passed = passed && output.publish == 1UL << 1 && rules.evaluations - evaluations == 6;
+
+	*note = "relay on presence below 3500, LED while on, event once per raise above 100 VA";
+
+	return passed;
+}
+
+/* Every comparison and logic instruction on the edges of int32, immediates sign extended and WITHIN
+ * across midnight */
+static bool run_operators(const char * * note)
+{
+	static const int32_t values[] = { INT32_MIN, -1, 0, 1, INT32_MAX };
+	static const uint8_t binary[] =
+	{
+		RULES_OP_LT, RULES_OP_LE, RULES_OP_GT, RULES_OP_GE, RULES_OP_EQ, RULES_OP_NE, RULES_OP_AND, RULES_OP_OR,
+	};
+	static const struct
+	{
+		int32_t lo;
+		int32_t hi;
+		int32_t minute;
+		int32_t within;
+	} ranges[] =
+	{
+		{ 1320, 360, 1319, 0 }, { 1320, 360, 1320, 1 }, { 1320, 360, 0, 1 }, { 1320, 360, 360, 1 }, { 1320, 360, 361, 0 },
+		{ 480, 1080, 479, 0 }, { 480, 1080, 480, 1 }, { 480, 1080, 1080, 1 }, { 480, 1080, 1081, 0 }, { 480, 1080, -1, 0 },
+	};
+	int32_t vars[RULES_VAR_MAX] = { 0 };
+	uint32_t checked = 0;
+	bool passed = true;
+
+	for(size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+	{
+		for(size_t j = 0; j < sizeof(values) / sizeof(values[0]); j++)
+		{
+			int32_t a = values[i];
+			int32_t b = values[j];
+			const int32_t expected[] = { a < b, a <= b, a > b, a >= b, a == b, a != b, a && b, a || b };
+
+			for(size_t k = 0; k < sizeof(binary) && passed; k++)
+			{
+				uint8_t code[] =
+				{
+					V, 1, RULES_OP_RULE, RULES_OP_PUSH32, a, a >> 8, a >> 16, a >> 24, RULES_OP_PUSH32, b, b >> 8, b >> 16, b >> 24,
+					binary[k], RULES_OP_RELAY, RULES_OP_END,
+				};
+
+				passed = eval_relay(code, sizeof(code), vars) == expected[k];
+				checked++;
+			}
+
+			uint8_t not[] = { V, 1, RULES_OP_RULE, RULES_OP_PUSH32, a, a >> 8, a >> 16, a >> 24, RULES_OP_NOT, RULES_OP_RELAY, RULES_OP_END };
+
+			passed = passed && eval_relay(not, sizeof(not), vars) == !a;
+		}
+	}
+
+	/* -1 of a PUSH8 and a PUSH16 */
+	uint8_t extend[] =
+	{
+		V, 1, RULES_OP_RULE, RULES_OP_PUSH8, 0xFF, RULES_OP_PUSH16, 0xFF, 0xFF, RULES_OP_EQ, RULES_OP_PUSH8, 0xFF, RULES_OP_PUSH8, 0,
+		RULES_OP_LT, RULES_OP_AND, RULES_OP_RELAY, RULES_OP_END,
+	};
+
+	passed = passed && eval_relay(extend, sizeof(extend), vars) == 1;
+
+	for(size_t i = 0; i < sizeof(ranges) / sizeof(ranges[0]) && passed; i++)
+	{
+		uint8_t code[] =
+		{
+			V, 1, RULES_OP_RULE, RULES_OP_LOAD, RULES_VAR_MINUTE, RULES_OP_PUSH16, ranges[i].lo, ranges[i].lo >> 8, RULES_OP_PUSH16,
+			ranges[i].hi, ranges[i].hi >> 8, RULES_OP_WITHIN, RULES_OP_RELAY, RULES_OP_END,
+		};
+
+		vars[RULES_VAR_MINUTE] = ranges[i].minute;
+		passed = eval_relay(code, sizeof(code), vars) == ranges[i].within;
+
+		if(!passed)
+			printf("rules: minute %" PRId32 " within %" PRId32 "-%" PRId32 " wrong\n", ranges[i].minute, ranges[i].lo, ranges[i].hi);
+	}
+
+	*note = test_note("%" PRIu32 " comparisons and logic operations, sign extension and WITHIN across midnight", checked);
+
+	return passed;
+}
+
+/* A saved program is restored, an erased one is not found and a stored one failing the check is dropped */
+static bool run_store(const char * * note)
+{
+	static const uint8_t bad[] = { V, 1, RULES_OP_RULE, RULES_OP_PUSH8, 1, RULES_OP_SKIPZ, 1, RULES_OP_END };
+	hal_nvs_handle_t handle;
+	bool passed;
+
+	hal_nvs_init(NVS_PARTITION);
+	passed = load(sample, sizeof(sample)) && bitec_rules_save(&rules) == ESP_OK;
+	bitec_rules_clear(&rules);
+	passed = passed && bitec_rules_restore(&rules) == ESP_OK && rules.size == sizeof(sample) &&
+			!memcmp(rules.code, sample, sizeof(sample));
+
+	bitec_rules_clear(&rules);
+	passed = passed && bitec_rules_save(&rules) == ESP_OK && bitec_rules_restore(&rules) == ESP_ERR_NOT_FOUND && rules.size == 0;
+
+	/* Written around the check, as a build with other limits could */
+	passed = passed && hal_nvs_open(NVS_PARTITION, NVS_NAMESPACE, true, &handle) == ESP_OK;
+	passed = passed && hal_nvs_set_blob(handle, NVS_KEY, bad, sizeof(bad)) == ESP_OK && hal_nvs_commit(handle) == ESP_OK;
+	hal_nvs_close(handle);
+	passed = passed && load(sample, sizeof(sample)) && bitec_rules_restore(&rules) == ESP_ERR_INVALID_ARG && rules.size == 0;
+
+	*note = "saved program restored, erased one not found, stored one failing the check dropped";
+
+	return passed;
+}
+
+/* Load the accepted programs and reject the others */
+static bool programs_check(const program_t * accepted, size_t accepted_num, const program_t * rejected, size_t rejected_num)
+{
+	bool passed = true;
+
+	for(size_t i = 0; i < accepted_num; i++)
+	{
+		if(!load(accepted[i].code, accepted[i].size) || !walk(accepted[i].code, accepted[i].size))
+		{
+			printf("rules: program %zu rejected\n", i);
+			passed = false;
+		}
+	}
+
+	for(size_t i = 0; i < rejected_num; i++)
+	{
+		if(load(rejected[i].code, rejected[i].size))
+		{
+			printf("rules: program %zu accepted\n", i);
+			passed = false;
+		}
+	}
+
+	return passed;
+}
+
+static bool load(const uint8_t * code, size_t size)
+{
+	return bitec_rules_load(&rules, code, size) == ESP_OK;
+}
+
+static op_info_t op_info(uint8_t op)
+{
+	switch(op)
+	{
+		case RULES_OP_END:
+		case RULES_OP_RULE: return (op_info_t){ true, 0, 0, 0 };
+		case RULES_OP_PUSH8: return (op_info_t){ true, 1, 0, 1 };
+		case RULES_OP_PUSH16: return (op_info_t){ true, 2, 0, 1 };
+		case RULES_OP_PUSH32: return (op_info_t){ true, 4, 0, 1 };
+		case RULES_OP_LOAD: return (op_info_t){ true, 1, 0, 1 };
+		case RULES_OP_LT:
+		case RULES_OP_LE:
+		case RULES_OP_GT:
+		case RULES_OP_GE:
+		case RULES_OP_EQ:
+		case RULES_OP_NE:
+		case RULES_OP_AND:
+		case RULES_OP_OR: return (op_info_t){ true, 0, 2, 1 };
+		case RULES_OP_NOT: return (op_info_t){ true, 0, 1, 1 };
+		case RULES_OP_WITHIN: return (op_info_t){ true, 0, 3, 1 };
+		case RULES_OP_SKIPZ: return (op_info_t){ true, 1, 1, 0 };
+		case RULES_OP_RELAY: return (op_info_t){ true, 0, 1, 0 };
+		case RULES_OP_LED: return (op_info_t){ true, 3, 0, 0 };
+		case RULES_OP_PUBLISH: return (op_info_t){ true, 1, 0, 0 };
+		default: return (op_info_t){ false, 0, 0, 0 };
+	}
+}
+
+/* Follow every path of a program as the evaluation would, both ways at each skip. False if one runs
+ * an unknown instruction, reads past the end, pops an empty stack, overflows it, or indexes the
+ * variables or the events out of their tables */
+static bool walk(const uint8_t * code, size_t size)
+{
+	static bool seen[RULES_SIZE][RULES_STACK + 1];
+	static struct { size_t pc; int depth; } pending[2 * WALK_STATES];
+	int pending_num = 0;
+
+	memset(seen, 0, sizeof(seen));
+	pending[pending_num++].pc = RULES_HEADER_SIZE;
+	pending[0].depth = 0;
+
+	while(pending_num > 0)
+	{
+		pending_num--;
+		size_t pc = pending[pending_num].pc;
+		int depth = pending[pending_num].depth;
+
+		if(pc >= size)
+			return false;
+
+		if(seen[pc][depth])
+			continue;
+
+		seen[pc][depth] = true;
+
+		uint8_t op = code[pc];
+		op_info_t info = op_info(op);
+
+		if(!info.valid || pc + 1 + info.operands > size || depth < info.pops || depth - info.pops + info.pushes > RULES_STACK)
+			return false;
+
+		if((op == RULES_OP_LOAD && code[pc + 1] >= RULES_VAR_MAX) || (op == RULES_OP_PUBLISH && code[pc + 1] >= PUBLISH_MAX))
+			return false;
+
+		if(op == RULES_OP_END)
+			continue;
+
+		depth += info.pushes - info.pops;
+		pending[pending_num].pc = pc + 1 + info.operands;
+		pending[pending_num++].depth = depth;
+
+		if(op == RULES_OP_SKIPZ)
+		{
+			pending[pending_num].pc = pc + 2 + code[pc + 1];
+			pending[pending_num++].depth = depth;
+		}
+	}
+
+	return true;
+}
+
+/* The relay request of a program, -2 if it is rejected */
+static int32_t eval_relay(const uint8_t * code, size_t size, const int32_t * vars)
+{
+	bitec_rules_output_t output;
+
+	if(!load(code, size))
+		return -2;
+
+	bitec_rules_eval(&rules, vars, &output);
+
+	return output.relay;
+}
+
+/* xorshift32 */
+static uint32_t random_next(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return seed;
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,441 @@
+/*
+ * test_series.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ *
+ * Recent readings store of bitec_series with the channels and precisions of
+ * the firmware, fed a reading every sensors period. Three loads are stored a
+ * day each, constant, noisy and a daily profile, and every case checks that
+ * the samples paged out as the MQTT queries do are the ones added, rounded to
+ * their precision. The notes give the compression, the hours kept in RAM and
+ * in flash and the query throughput. Last, the store is restored from flash
+ * after a restart, the flash ring wraps and the RAM ring evicts without it:
+ *
+ *     smartLight_test.elf series
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+#include <time.h>
+
+#include "bitec_series.h"
+#include "bitec_hal.h"
+#include "bitec_hal_linux.h"
+#include "esp_log.h"
+#include "test.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define CHANNELS			8			/*!< As the firmware, voltage to presence */
+#define PERIOD				5000		/*!< Sensors period in ms */
+#define DAY					(86400000 / PERIOD)	/*!< Samples of a day */
+#define START				1792368000000LL	/*!< Oct 19, 2026 00:00 UTC */
+#define PARTITION			"series"
+#define PAGE_SIZE			4096		/*!< As the series pages of the firmware */
+#define PAGE_LIMIT			100
+#define ROUNDS				20			/*!< Queries of the last hour timed */
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef struct
+{
+	int64_t time;
+	float values[CHANNELS];
+} sample_t;
+
+typedef void (* load_t)(uint32_t index, sample_t * sample);
+
+/* Samples of a range paged out, with the time spent */
+typedef struct
+{
+	uint32_t samples;
+	uint32_t pages;
+	uint32_t mismatches;		/*!< Samples not the expected ones */
+	double seconds;
+} pages_t;
+
+/* internal data declaration -------------------------------------------------*/
+
+static bitec_series_t series;
+static sample_t * samples;				/*!< Added, in time order */
+static uint32_t added;
+static uint32_t seed;
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static bool run_constant(const char * * note);
+static bool run_noisy(const char * * note);
+static bool run_daily(const char * * note);
+static bool run_restore(const char * * note);
+static bool run_wrap(const char * * note);
+static bool run_ram(const char * * note);
+static bool run_load(load_t load, const char * * note);
+static void load_constant(uint32_t index, sample_t * sample);
+static void load_noisy(uint32_t index, sample_t * sample);
+static void load_daily(uint32_t index, sample_t * sample);
+static void start(bool spill);
+static void feed(load_t load, uint32_t count);
+static pages_t query(int64_t from, int64_t to, uint32_t first);
+static bool matches(const char * * page, const sample_t * sample);
+static double hours_per_block(void);
+static double now_s(void);
+static double uniform_random(double range);
+static double gauss_random(void);
+static uint32_t random_next(void);
+
+/* internal data definition --------------------------------------------------*/
+
+static const int8_t precisions[CHANNELS] = { 3, 10, 2, 2, 7, 0, 0, 0 };
+
+static const test_case_t cases[] =
+{
+	{ "constant", run_constant },
+	{ "noisy", run_noisy },
+	{ "daily", run_daily },
+	{ "restore", run_restore },
+	{ "wrap", run_wrap },
+	{ "ram", run_ram },
+};
+
+/* external functions definition ---------------------------------------------*/
+
+int test_series(int argc, char * argv[])
+{
+	int failures;
+
+	/* Every restore logs the blocks found */
+	esp_log_level_set("*", ESP_LOG_WARN);
+
+	samples = malloc(12 * DAY * sizeof(sample_t));
+
+	if(samples == NULL)
+		return 1;
+
+	printf("series: %u channels, a sample every %u ms, %u blocks of %u bytes in RAM\n", CHANNELS, PERIOD, SERIES_BLOCKS,
+			SERIES_BLOCK_SIZE);
+
+	failures = test_run("series", cases, sizeof(cases) / sizeof(cases[0]));
+	free(samples);
+
+	return failures;
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+static bool run_constant(const char * * note)
+{
+	return run_load(load_constant, note);
+}
+
+static bool run_noisy(const char * * note)
+{
+	return run_load(load_noisy, note);
+}
+
+static bool run_daily(const char * * note)
+{
+	return run_load(load_daily, note);
+}
+
+/* A day of a load spilled to flash, paged out whole and the last hour of it again and again */
+static bool run_load(load_t load, const char * * note)
+{
+	size_t stored;
+	size_t raw;
+
+	start(true);
+	feed(load, DAY);
+	bitec_series_usage(&series, &stored, &raw);
+
+	pages_t all = query(START, INT64_MAX, 0);
+	pages_t hour = { 0 };
+
+	for(int i = 0; i < ROUNDS; i++)
+	{
+		pages_t round = query(samples[added - 3600000 / PERIOD].time, INT64_MAX, added - 3600000 / PERIOD);
+
+		hour.samples += round.samples;
+		hour.pages += round.pages;
+		hour.mismatches += round.mismatches;
+		hour.seconds += round.seconds;
+	}
+
+	bool passed = all.samples == added && all.mismatches == 0 && hour.samples == ROUNDS * 3600000 / PERIOD &&
+			hour.mismatches == 0 && series.spill_errors == 0;
+
+	*note = test_note("%.1fx, %.2f B/sample, %.1f h in RAM, %.0f h in flash, %.0f/%.0f ksamples/s flash/RAM",
+			(double)raw / stored, (double)stored / (raw / (8 + 4 * CHANNELS)), hours_per_block() * SERIES_BLOCKS,
+			hours_per_block() * (series.slots - HAL_PARTITION_SECTOR / SERIES_BLOCK_SIZE), all.samples / all.seconds / 1000,
+			hour.samples / hour.seconds / 1000);
+
+	return passed;
+}
+
+/* Restarted after a day, the open block flushed, every sample is back and the next ones go on */
+static bool run_restore(const char * * note)
+{
+	bool passed;
+	float values[CHANNELS] = { 0 };
+
+	start(true);
+	feed(load_daily, DAY);
+	bitec_series_flush(&series);
+
+	uint32_t spilled = series.spilled;
+
+	bitec_series_init(&series, CHANNELS, precisions);
+	passed = bitec_series_spill(&series, PARTITION) == ESP_OK && series.flash_count == spilled;
+	passed = passed && bitec_series_oldest(&series) == samples[0].time && series.last == samples[added - 1].time;
+	passed = passed && bitec_series_add(&series, samples[added - 1].time, values) == ESP_ERR_INVALID_ARG;
+
+	feed(load_daily, 3600000 / PERIOD);
+
+	pages_t all = query(START, INT64_MAX, 0);
+
+	passed = passed && all.samples == added && all.mismatches == 0;
+	*note = "every sample read back from flash, the next ones after them";
+
+	return passed;
+}
+
+/* Longer than the flash holds, the oldest sectors are erased and the rest pages out in order */
+static bool run_wrap(const char * * note)
+{
+	uint32_t per_sector = HAL_PARTITION_SECTOR / SERIES_BLOCK_SIZE;
+	bool passed;
+
+	start(true);
+	feed(load_noisy, 12 * DAY);
+
+	int64_t oldest = bitec_series_oldest(&series);
+	uint32_t first = 0;
+
+	while(first < added && samples[first].time < oldest)
+		first++;
+
+	pages_t all = query(START, INT64_MAX, first);
+
+	passed = first > 0 && series.flash_count >= series.slots - per_sector && series.flash_count <= series.slots &&
+			all.samples == added - first && all.mismatches == 0 && series.spill_errors == 0;
+
+	/* A sector is erased before the first block written to it */
+	passed = passed && hal_linux_partition_erases() == (series.spilled + per_sector - 1) / per_sector;
+	*note = test_note("%.0f h kept of %.0f h, %" PRIu32 " sector erases for %" PRIu32 " blocks",
+			(double)(added - first) * PERIOD / 3600000, (double)added * PERIOD / 3600000, hal_linux_partition_erases(), series.spilled);
+
+	return passed;
+}
+
+/* Without flash, the oldest blocks are evicted and the rest are the newest samples */
+static bool run_ram(const char * * note)
+{
+	bool passed;
+
+	start(false);
+	feed(load_noisy, DAY);
+
+	int64_t oldest = bitec_series_oldest(&series);
+	uint32_t first = 0;
+
+	while(first < added && samples[first].time < oldest)
+		first++;
+
+	pages_t all = query(START, INT64_MAX, first);
+
+	passed = series.evicted > 0 && series.count == SERIES_BLOCKS && all.samples == added - first && all.mismatches == 0;
+	*note = test_note("%" PRIu32 " blocks evicted, the last %.1f h kept", series.evicted,
+			(double)(added - first) * PERIOD / 3600000);
+
+	return passed;
+}
+
+/* Idle lamp on a steady supply */
+static void load_constant(uint32_t index, sample_t * sample)
+{
+	sample->time = START + (int64_t)(index + 1) * PERIOD;
+	sample->values[0] = 230.0;
+	sample->values[1] = 0.435;
+	sample->values[2] = 100.0;
+	sample->values[3] = 100.0;
+	sample->values[4] = 1.0;
+	sample->values[5] = 300;
+	sample->values[6] = 1;
+	sample->values[7] = 0;
+}
+
+/* As the readings of a lamp on, noise on every channel and on the period */
+static void load_noisy(uint32_t index, sample_t * sample)
+{
+	sample->time = START + (int64_t)(index + 1) * PERIOD + (int64_t)uniform_random(10);
+	sample->values[0] = 230.0 + 0.8 * gauss_random();
+	sample->values[1] = 0.435 + 0.004 * gauss_random();
+	sample->values[2] = sample->values[0] * sample->values[1] * 0.98;
+	sample->values[3] = sample->values[0] * sample->values[1];
+	sample->values[4] = 0.98 + 0.005 * gauss_random();
+	sample->values[5] = roundf(300 + 5 * gauss_random());
+	sample->values[6] = 1;
+	sample->values[7] = random_next() % 4 == 0;
+}
+
+/* On from the evening to the night and with presence, off and daylight otherwise */
+static void load_daily(uint32_t index, sample_t * sample)
+{
+	double hour = fmod((index + 1) * (double)PERIOD / 3600000, 24);
+	bool on = hour >= 18.5 && hour < 23.5;
+	bool presence = on && random_next() % 8 != 0;
+
+	sample->time = START + (int64_t)(index + 1) * PERIOD + (int64_t)uniform_random(2);
+	sample->values[0] = 228.0 + 3 * sin(hour * M_PI / 12) + 0.3 * gauss_random();
+	sample->values[1] = on ? 0.435 + 0.002 * gauss_random() : 0.0;
+	sample->values[2] = on ? sample->values[0] * sample->values[1] * 0.98 : 0.0;
+	sample->values[3] = sample->values[0] * sample->values[1];
+	sample->values[4] = on ? 0.98 : 0.0;
+	sample->values[5] = roundf(fmax(0, 800 * sin((hour - 6) * M_PI / 12)) + (on ? 300 : 0));
+	sample->values[6] = on;
+	sample->values[7] = presence;
+}
+
+/* Empty store, spilled to an erased partition or in RAM only, and the same random numbers */
+static void start(bool spill)
+{
+	hal_linux_reset();
+	bitec_series_init(&series, CHANNELS, precisions);
+
+	if(spill)
+		bitec_series_spill(&series, PARTITION);
+
+	added = 0;
+	seed = 0x2545F491;
+}
+
+/* Samples of a load after the ones added, the load goes on from its index */
+static void feed(load_t load, uint32_t count)
+{
+	for(uint32_t i = 0; i < count; i++)
+	{
+		sample_t * sample = &samples[added];
+
+		load(added, sample);
+
+		if(bitec_series_add(&series, sample->time, sample->values) == ESP_OK)
+			added++;
+	}
+}
+
+/* Page a range out as series_receive() does, the samples have to be the added ones from first on */
+static pages_t query(int64_t from, int64_t to, uint32_t first)
+{
+	pages_t result = { 0 };
+	char * page = malloc(PAGE_SIZE);
+	int64_t next = from;
+	double begin = now_s();
+
+	while(page != NULL && next >= 0 && bitec_series_print(&series, next, to, PAGE_LIMIT, page, PAGE_SIZE, &next) > 0)
+	{
+		const char * p = strstr(page, "\"samples\":[");
+
+		result.pages++;
+
+		for(p = (p != NULL) ? p + 11 : NULL; p != NULL && * p == '['; result.samples++)
+		{
+			uint32_t index = first + result.samples;
+
+			if(index >= added || !matches(&p, &samples[index]))
+			{
+				result.mismatches++;
+				break;
+			}
+
+			if(* p == ',')
+				p++;
+		}
+	}
+
+	result.seconds = now_s() - begin;
+	free(page);
+
+	return result;
+}
+
+/* A printed sample against an added one, its values rounded to their precision. Moves page past it */
+static bool matches(const char * * page, const sample_t * sample)
+{
+	char * end;
+	const char * p = * page + 1;
+
+	if(strtoll(p, &end, 10) != sample->time)
+		return false;
+
+	for(int i = 0; i < CHANNELS; i++)
+	{
+		double expected = ldexp(round(ldexp(sample->values[i], precisions[i])), -precisions[i]);
+		double value;
+
+		if(* end != ',')
+			return false;
+
+		value = strtod(end + 1, &end);
+
+		/* %.7g of the float stored */
+		if(fabs(value - expected) > fabs(expected) * 1e-6)
+			return false;
+	}
+
+	if(* end != ']')
+		return false;
+
+	* page = end + 1;
+
+	return true;
+}
+
+/* Hours of samples a block holds, from the ones sealed */
+static double hours_per_block(void)
+{
+	uint32_t sealed = series.spilled > 0 ? series.spilled : series.count - 1;
+
+	return sealed > 0 ? (double)added / sealed * PERIOD / 3600000 : 0;
+}
+
+static double now_s(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double uniform_random(double range)
+{
+	return range * (2.0 * random_next() / 4294967295.0 - 1);
+}
+
+/* Box-Muller, never 0 in the logarithm */
+static double gauss_random(void)
+{
+	double u = (random_next() + 1.0) / 4294967296.0;
+	double v = random_next() / 4294967296.0;
+
+	return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+/* xorshift32 */
+static uint32_t random_next(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return seed;
+}
+
+/* end of file ---------------------------------------------------------------*/
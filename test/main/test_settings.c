@@ -0,0 +1,396 @@
+/*
+ * test_settings.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ *
+ * Settings of bitec_settings on the NVS of the linux port. Tables with a bad
+ * key or default are refused. A settings message with one bad value among
+ * good ones sets none of them, a null value resets its setting and erases its
+ * key on the next commit. Changed values are stored with a single commit and
+ * restored by the next start, defaults are not stored and the settings read
+ * once at start ask for a restart. Stored values out of the limits of the
+ * running build are replaced by their defaults, and a schema upgrade calls
+ * the migration once with the stored version:
+ *
+ *     smartLight_test.elf settings
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "bitec_settings.h"
+#include "bitec_hal.h"
+#include "bitec_hal_linux.h"
+#include "esp_log.h"
+#include "test.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define NVS_PARTITION		"settings"	/*!< Where bitec_settings stores the values */
+#define NVS_NAMESPACE		"settings"
+#define NVS_VERSION			"_version"
+#define VERSION				2
+#define PRINT_SIZE			256
+
+/* typedef -------------------------------------------------------------------*/
+
+typedef enum
+{
+	ID = 0,
+	INTERVAL,
+	NIGHT,
+	DARK,
+	NAME,
+	ENTRY_MAX
+} entry_e;
+
+/* internal data declaration -------------------------------------------------*/
+
+static bitec_settings_t settings;
+static uint32_t migrations;
+static uint32_t migrated_from;
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static bool run_table(const char * * note);
+static bool run_parse(const char * * note);
+static bool run_reject(const char * * note);
+static bool run_reset(const char * * note);
+static bool run_commit(const char * * note);
+static bool run_discard(const char * * note);
+static bool run_migrate(const char * * note);
+static void start(void);
+static bool parse(const char * data);
+static bool stored(const char * key);
+static bool store(const char * key, const void * value, size_t size);
+static bool is_default(void);
+static void migrate(bitec_settings_t * const me, uint32_t version, void * arg);
+
+/* internal data definition --------------------------------------------------*/
+
+/* As the table of the firmware, a setting of each type and one read once at start */
+static const bitec_settings_entry_t entries[] =
+{
+	[ID] = { "id", SETTINGS_STRING, 0, 36, 0, "device", SETTINGS_RESTART },
+	[INTERVAL] = { "interval", SETTINGS_INT, 1, 3600, 60, NULL, 0 },
+	[NIGHT] = { "night", SETTINGS_BOOL, 0, 0, 0, NULL, 0 },
+	[DARK] = { "dark", SETTINGS_INT, -100, 4095, 300, NULL, 0 },
+	[NAME] = { "name", SETTINGS_STRING, 0, 8, 0, "lamp", 0 },
+};
+
+/* Each with one value that cannot be set, the others can */
+static const char * rejected[] =
+{
+	"{\"interval\":120,\"unknown\":1}",
+	"{\"interval\":0,\"night\":true}",
+	"{\"night\":true,\"interval\":3601}",
+	"{\"night\":true,\"interval\":12.5}",
+	"{\"night\":true,\"interval\":\"120\"}",
+	"{\"interval\":120,\"night\":1}",
+	"{\"interval\":120,\"name\":\"desk lamp\"}",
+	"{\"interval\":120,\"name\":\"a\\\"b\"}",
+	"{\"interval\":120,\"name\":7}",
+	"{\"interval\":120,\"dark\":-101}",
+	"[{\"interval\":120}]",
+	"{\"interval\":120",
+	"120",
+	"",
+};
+
+static const test_case_t cases[] =
+{
+	{ "table", run_table },
+	{ "parse", run_parse },
+	{ "reject", run_reject },
+	{ "reset", run_reset },
+	{ "commit", run_commit },
+	{ "discard", run_discard },
+	{ "migrate", run_migrate },
+};
+
+/* external functions definition ---------------------------------------------*/
+
+int test_settings(int argc, char * argv[])
+{
+	/* Every restore logs the values found */
+	esp_log_level_set("*", ESP_LOG_WARN);
+
+	return test_run("settings", cases, sizeof(cases) / sizeof(cases[0]));
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* Tables the cache cannot take */
+static bool run_table(const char * * note)
+{
+	bitec_settings_entry_t table[ENTRY_MAX];
+	static bitec_settings_entry_t many[SETTINGS_ENTRIES + 1];
+	bool passed = bitec_settings_init(&settings, entries, ENTRY_MAX, VERSION) == ESP_OK && is_default();
+
+	/* A key too long for NVS, one taken by the version, defaults out of their ranges or too long */
+	memcpy(table, entries, sizeof(table));
+	table[INTERVAL].key = "interval_seconds";
+	passed = passed && bitec_settings_init(&settings, table, ENTRY_MAX, VERSION) == ESP_ERR_INVALID_ARG;
+	memcpy(table, entries, sizeof(table));
+	table[INTERVAL].key = NVS_VERSION;
+	passed = passed && bitec_settings_init(&settings, table, ENTRY_MAX, VERSION) == ESP_ERR_INVALID_ARG;
+	memcpy(table, entries, sizeof(table));
+	table[INTERVAL].value = 0;
+	passed = passed && bitec_settings_init(&settings, table, ENTRY_MAX, VERSION) == ESP_ERR_INVALID_ARG;
+	memcpy(table, entries, sizeof(table));
+	table[NIGHT].value = 2;
+	passed = passed && bitec_settings_init(&settings, table, ENTRY_MAX, VERSION) == ESP_ERR_INVALID_ARG;
+	memcpy(table, entries, sizeof(table));
+	table[NAME].string = "desk lamp";
+	passed = passed && bitec_settings_init(&settings, table, ENTRY_MAX, VERSION) == ESP_ERR_INVALID_ARG;
+
+	/* More entries or longer strings than the cache holds */
+	for(int i = 0; i < SETTINGS_ENTRIES + 1; i++)
+		many[i] = (bitec_settings_entry_t){ "n", SETTINGS_INT, 0, 1, 0, NULL, 0 };
+
+	passed = passed && bitec_settings_init(&settings, many, SETTINGS_ENTRIES + 1, VERSION) == ESP_ERR_INVALID_SIZE;
+	memcpy(table, entries, sizeof(table));
+	table[NAME].max = SETTINGS_STRINGS_SIZE;
+	passed = passed && bitec_settings_init(&settings, table, ENTRY_MAX, VERSION) == ESP_ERR_INVALID_SIZE;
+
+	*note = test_note("keys too long or reserved, defaults out of range, more than %d entries or %d bytes of strings refused",
+			SETTINGS_ENTRIES, SETTINGS_STRINGS_SIZE);
+
+	return passed;
+}
+
+/* A message of every type sets them all */
+static bool run_parse(const char * * note)
+{
+	char buf[PRINT_SIZE];
+	bool passed;
+
+	start();
+	passed = parse("{\"interval\":120,\"night\":true,\"dark\":-100,\"name\":\"desk\",\"id\":\"lamp-2\"}");
+	passed = passed && bitec_settings_get(&settings, INTERVAL) == 120 && bitec_settings_get(&settings, NIGHT) == 1 &&
+			bitec_settings_get(&settings, DARK) == -100 && !strcmp(bitec_settings_get_string(&settings, NAME), "desk") &&
+			!strcmp(bitec_settings_get_string(&settings, ID), "lamp-2");
+	passed = passed && settings.dirty == (1UL << ENTRY_MAX) - 1;
+
+	/* The same values again change nothing */
+	settings.dirty = 0;
+	passed = passed && parse("{\"interval\":120,\"name\":\"desk\"}") && settings.dirty == 0;
+	passed = passed && bitec_settings_print(&settings, buf, sizeof(buf)) > 0 &&
+			!strcmp(buf, "{\"version\":2,\"id\":\"lamp-2\",\"interval\":120,\"night\":true,\"dark\":-100,\"name\":\"desk\",\"restart\":false}");
+
+	*note = "a value of every type set, the same values again leave nothing to commit";
+
+	return passed;
+}
+
+/* A bad value anywhere in a message sets none of the good ones */
+static bool run_reject(const char * * note)
+{
+	bool passed = true;
+
+	for(size_t i = 0; i < sizeof(rejected) / sizeof(rejected[0]); i++)
+	{
+		start();
+
+		if(parse(rejected[i]) || !is_default() || settings.dirty != 0)
+		{
+			printf("settings: %s taken\n", rejected[i]);
+			passed = false;
+		}
+	}
+
+	*note = test_note("%zu messages with an unknown key, a value out of range, of another type or not JSON, none set",
+			sizeof(rejected) / sizeof(rejected[0]));
+
+	return passed;
+}
+
+/* A null value is the default, its key is erased so a later default applies */
+static bool run_reset(const char * * note)
+{
+	bool passed;
+
+	start();
+	passed = parse("{\"interval\":120,\"name\":\"desk\"}") && bitec_settings_commit(&settings) == ESP_OK;
+	passed = passed && stored("interval") && stored("name");
+
+	passed = passed && parse("{\"interval\":null,\"name\":null}") && bitec_settings_get(&settings, INTERVAL) == 60 &&
+			!strcmp(bitec_settings_get_string(&settings, NAME), "lamp");
+	passed = passed && bitec_settings_commit(&settings) == ESP_OK && !stored("interval") && !stored("name");
+
+	/* A null value is checked as the others, with a bad one it is not taken either */
+	passed = passed && parse("{\"dark\":10}") && !parse("{\"dark\":null,\"night\":3}") && bitec_settings_get(&settings, DARK) == 10;
+
+	*note = "null values back to their defaults and their keys erased, not taken along a bad value";
+
+	return passed;
+}
+
+/* Changes stored with one commit and restored by the next start */
+static bool run_commit(const char * * note)
+{
+	char buf[PRINT_SIZE];
+	uint32_t commits;
+	bool passed;
+
+	start();
+	passed = bitec_settings_restore(&settings) == ESP_ERR_NOT_FOUND && is_default();
+
+	commits = hal_linux_nvs_commits();
+	passed = passed && parse("{\"interval\":300,\"night\":true,\"id\":\"lamp-2\"}") && bitec_settings_commit(&settings) == ESP_OK;
+	passed = passed && hal_linux_nvs_commits() - commits == 1 && settings.writes == 3 && settings.dirty == 0;
+	passed = passed && !stored("dark") && !stored("name") && settings.restart == 1UL << ID;
+	passed = passed && bitec_settings_print(&settings, buf, sizeof(buf)) > 0 && strstr(buf, "\"restart\":true}") != NULL;
+
+	/* Nothing changed, only the version is written */
+	passed = passed && bitec_settings_commit(&settings) == ESP_OK && settings.writes == 3;
+
+	/* The next start */
+	passed = passed && bitec_settings_init(&settings, entries, ENTRY_MAX, VERSION) == ESP_OK;
+	commits = hal_linux_nvs_commits();
+	passed = passed && bitec_settings_restore(&settings) == ESP_OK && hal_linux_nvs_commits() == commits;
+	passed = passed && bitec_settings_get(&settings, INTERVAL) == 300 && bitec_settings_get(&settings, NIGHT) == 1 &&
+			bitec_settings_get(&settings, DARK) == 300 && !strcmp(bitec_settings_get_string(&settings, ID), "lamp-2");
+	passed = passed && settings.restart == 0 && settings.dirty == 0;
+
+	/* Unset restored from the default of the running build */
+	passed = passed && !strcmp(bitec_settings_get_string(&settings, NAME), "lamp");
+
+	*note = "three changes in one commit, defaults not stored, restart asked for the id, restored as set";
+
+	return passed;
+}
+
+/* Values stored by a build with other limits */
+static bool run_discard(const char * * note)
+{
+	int32_t version = VERSION;
+	int32_t interval = 7200;
+	int32_t night = 2;
+	int16_t dark = 10;
+	bool passed;
+
+	start();
+	passed = store(NVS_VERSION, &version, sizeof(version)) && store("interval", &interval, sizeof(interval)) &&
+			store("night", &night, sizeof(night)) && store("dark", &dark, sizeof(dark)) &&
+			store("name", "desk lamp", sizeof("desk lamp")) && store("id", "a\"b", sizeof("a\"b"));
+	passed = passed && bitec_settings_restore(&settings) == ESP_OK && is_default();
+
+	/* Committed by the restore, the stored values erased */
+	passed = passed && settings.dirty == 0 && !stored("interval") && !stored("night") && !stored("dark") && !stored("name") &&
+			!stored("id");
+
+	*note = "out of range, of another size, too long or unprintable stored values replaced by their defaults and erased";
+
+	return passed;
+}
+
+/* The migration is called once for an older schema, and not for the same or a newer one */
+static bool run_migrate(const char * * note)
+{
+	uint32_t old = VERSION - 1;
+	uint32_t newer = VERSION + 1;
+	uint32_t version = 0;
+	size_t size = sizeof(version);
+	int32_t interval = 30;
+	hal_nvs_handle_t handle;
+	bool passed;
+
+	start();
+	passed = store(NVS_VERSION, &old, sizeof(old)) && store("interval", &interval, sizeof(interval));
+	settings.migrate = migrate;
+	passed = passed && bitec_settings_restore(&settings) == ESP_OK && migrations == 1 && migrated_from == VERSION - 1;
+
+	/* Set from the value restored, committed with the version */
+	passed = passed && bitec_settings_get(&settings, INTERVAL) == 60 && bitec_settings_get(&settings, DARK) == 30 && settings.dirty == 0;
+	passed = passed && hal_nvs_open(NVS_PARTITION, NVS_NAMESPACE, false, &handle) == ESP_OK &&
+			hal_nvs_get_blob(handle, NVS_VERSION, &version, &size) == ESP_OK && version == VERSION;
+	hal_nvs_close(handle);
+
+	/* The next start has nothing to migrate */
+	passed = passed && bitec_settings_init(&settings, entries, ENTRY_MAX, VERSION) == ESP_OK;
+	settings.migrate = migrate;
+	passed = passed && bitec_settings_restore(&settings) == ESP_OK && migrations == 1 && bitec_settings_get(&settings, DARK) == 30;
+
+	/* Nor a rollback to an older build */
+	passed = passed && store(NVS_VERSION, &newer, sizeof(newer));
+	passed = passed && bitec_settings_init(&settings, entries, ENTRY_MAX, VERSION) == ESP_OK;
+	settings.migrate = migrate;
+	passed = passed && bitec_settings_restore(&settings) == ESP_OK && migrations == 1;
+
+	*note = test_note("called once from version %d to %d, not again nor from version %d", VERSION - 1, VERSION, VERSION + 1);
+
+	return passed;
+}
+
+/* Nothing stored and the defaults set */
+static void start(void)
+{
+	hal_linux_reset();
+	hal_nvs_init(NVS_PARTITION);
+	bitec_settings_init(&settings, entries, ENTRY_MAX, VERSION);
+	migrations = 0;
+}
+
+static bool parse(const char * data)
+{
+	return bitec_settings_parse(&settings, data, strlen(data)) == ESP_OK;
+}
+
+static bool stored(const char * key)
+{
+	hal_nvs_handle_t handle;
+	size_t size = 0;
+	bool found;
+
+	if(hal_nvs_open(NVS_PARTITION, NVS_NAMESPACE, false, &handle) != ESP_OK)
+		return false;
+
+	found = hal_nvs_get_blob(handle, key, NULL, &size) == ESP_OK;
+	hal_nvs_close(handle);
+
+	return found;
+}
+
+/* Written around the checks, as another build could */
+static bool store(const char * key, const void * value, size_t size)
+{
+	hal_nvs_handle_t handle;
+	bool passed;
+
+	if(hal_nvs_open(NVS_PARTITION, NVS_NAMESPACE, true, &handle) != ESP_OK)
+		return false;
+
+	passed = hal_nvs_set_blob(handle, key, value, size) == ESP_OK && hal_nvs_commit(handle) == ESP_OK;
+	hal_nvs_close(handle);
+
+	return passed;
+}
+
+static bool is_default(void)
+{
+	return bitec_settings_get(&settings, INTERVAL) == 60 && bitec_settings_get(&settings, NIGHT) == 0 &&
+			bitec_settings_get(&settings, DARK) == 300 && !strcmp(bitec_settings_get_string(&settings, ID), "device") &&
+			!strcmp(bitec_settings_get_string(&settings, NAME), "lamp");
+}
+
+/* Version 2 moved the interval of version 1 to the dark level */
+static void migrate(bitec_settings_t * const me, uint32_t version, void * arg)
+{
+	migrations++;
+	migrated_from = version;
+
+	if(version < 2)
+	{
+		bitec_settings_set(me, DARK, bitec_settings_get(me, INTERVAL));
+		bitec_settings_reset(me, INTERVAL);
+	}
+}
+
+/* end of file ---------------------------------------------------------------*/
@@ -0,0 +1,191 @@
+/*
+ * test_ws2812_led.c
+ *
+ * Created on: Oct 18, 2026
+ * Author: Mauricio Barroso Benavides
+ *
+ * Integer HSV to RGB conversion of ws2812_led_hsv2rgb_batch() against the
+ * rounded floating point one. Every hue, saturation and value is converted a
+ * frame at a time and every channel must be within 1 of the reference, the
+ * hues past 359 must wrap, the gamma pass must only look the colors up in its
+ * table and the table must hold the rounded gamma 2.2 curve:
+ *
+ *     smartLight_test.elf ws2812_led
+ */
+
+/* inclusions ----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+
+#include "ws2812_led.h"
+#include "test.h"
+
+/* macros --------------------------------------------------------------------*/
+
+#define HUES				360
+#define TOLERANCE			1			/*!< Largest error of a channel to the rounded reference */
+#define GAMMA				2.2
+
+/* typedef -------------------------------------------------------------------*/
+
+/* internal data declaration -------------------------------------------------*/
+
+static ws2812_led_hsv_t hsv[HUES];
+static ws2812_led_rgb_t rgb[HUES];
+static ws2812_led_rgb_t corrected[HUES];
+
+/* external data declaration -------------------------------------------------*/
+
+/* internal functions declaration --------------------------------------------*/
+
+static bool run_exhaustive(const char * * note);
+static bool run_wrap(const char * * note);
+static bool run_gamma(const char * * note);
+static void reference(const ws2812_led_hsv_t * color, double channels[3]);
+
+/* internal data definition --------------------------------------------------*/
+
+static const test_case_t cases[] =
+{
+	{ "exhaustive", run_exhaustive },
+	{ "wrap", run_wrap },
+	{ "gamma", run_gamma },
+};
+
+/* external functions definition ---------------------------------------------*/
+
+int test_ws2812_led(int argc, char * argv[])
+{
+	return test_run("ws2812_led", cases, sizeof(cases) / sizeof(cases[0]));
+}
+
+/* internal functions definition ---------------------------------------------*/
+
+/* Every color, a frame of all the hues for each saturation and value */
+static bool run_exhaustive(const char * * note)
+{
+	uint32_t errors[TOLERANCE + 2] = { 0 };
+	uint32_t worst = 0;
+	ws2812_led_hsv_t worst_color = { 0 };
+
+	for(uint32_t s = 0; s < 256; s++)
+	{
+		for(uint32_t v = 0; v < 256; v++)
+		{
+			for(uint32_t h = 0; h < HUES; h++)
+				hsv[h] = (ws2812_led_hsv_t){ .hue = h, .saturation = s, .value = v };
+
+			ws2812_led_hsv2rgb_batch(hsv, rgb, HUES, false);
+
+			for(uint32_t h = 0; h < HUES; h++)
+			{
+				const uint8_t channels[3] = { rgb[h].red, rgb[h].green, rgb[h].blue };
+				double expected[3];
+
+				reference(&hsv[h], expected);
+
+				for(int k = 0; k < 3; k++)
+				{
+					uint32_t error = abs((int)channels[k] - (int)lround(expected[k]));
+
+					errors[error <= TOLERANCE ? error : TOLERANCE + 1]++;
+
+					if(error > worst)
+					{
+						worst = error;
+						worst_color = hsv[h];
+					}
+				}
+			}
+		}
+	}
+
+	if(worst > TOLERANCE)
+		printf("ws2812_led: %" PRIu32 " off at hue %u saturation %u value %u\n", worst, worst_color.hue, worst_color.saturation,
+				worst_color.value);
+
+	*note = test_note("%u colors, %" PRIu32 " channels exact and %" PRIu32 " within %d of the rounded float", HUES * 256 * 256,
+			errors[0], errors[1], TOLERANCE);
+
+	return worst <= TOLERANCE;
+}
+
+/* Hues of a second turn give the colors of the first */
+static bool run_wrap(const char * * note)
+{
+	ws2812_led_hsv_t turn[HUES];
+	bool passed = true;
+
+	for(uint32_t h = 0; h < HUES; h++)
+	{
+		hsv[h] = (ws2812_led_hsv_t){ .hue = h, .saturation = 200, .value = 180 };
+		turn[h] = (ws2812_led_hsv_t){ .hue = h + HUES, .saturation = 200, .value = 180 };
+	}
+
+	ws2812_led_hsv2rgb_batch(hsv, rgb, HUES, false);
+	ws2812_led_hsv2rgb_batch(turn, corrected, HUES, false);
+	passed = !memcmp(rgb, corrected, sizeof(rgb));
+	*note = "hues 360 to 719 convert as 0 to 359";
+
+	return passed;
+}
+
+/* The gamma pass is the table applied to the plain conversion, the table is the rounded curve */
+static bool run_gamma(const char * * note)
+{
+	bool passed = true;
+	uint32_t table = 0;
+
+	for(uint32_t i = 0; i < 256; i++)
+	{
+		long expected = lround(255 * pow(i / 255.0, GAMMA));
+
+		table += ws2812_led_gamma_lut[i] == expected;
+		passed = passed && labs(ws2812_led_gamma_lut[i] - expected) <= TOLERANCE;
+	}
+
+	for(uint32_t v = 0; v < 256 && passed; v += 15)
+	{
+		for(uint32_t h = 0; h < HUES; h++)
+			hsv[h] = (ws2812_led_hsv_t){ .hue = h, .saturation = 255 - v, .value = v };
+
+		ws2812_led_hsv2rgb_batch(hsv, rgb, HUES, false);
+		ws2812_led_hsv2rgb_batch(hsv, corrected, HUES, true);
+
+		for(uint32_t h = 0; h < HUES && passed; h++)
+		{
+			passed = corrected[h].red == ws2812_led_gamma_lut[rgb[h].red] && corrected[h].green == ws2812_led_gamma_lut[rgb[h].green] &&
+					corrected[h].blue == ws2812_led_gamma_lut[rgb[h].blue];
+		}
+	}
+
+	*note = test_note("%" PRIu32 " of 256 table entries exact, the corrected frames looked up in it", table);
+
+	return passed;
+}
+
+/* HSV of 8 bit saturation and value to RGB, unrounded */
+static void reference(const ws2812_led_hsv_t * color, double channels[3])
+{
+	double h = color->hue % HUES / 60.0;
+	double s = color->saturation / 255.0;
+	double v = color->value;
+	int i = (int)h;
+	double f = h - i;
+
+	double p = v * (1 - s);
+	double q = v * (1 - s * f);
+	double t = v * (1 - s * (1 - f));
+
+	static const int order[6][3] = { { 0, 3, 1 }, { 2, 0, 1 }, { 1, 0, 3 }, { 1, 2, 0 }, { 3, 1, 0 }, { 0, 1, 2 } };
+	const double values[4] = { v, p, q, t };
+
+	for(int k = 0; k < 3; k++)
+		channels[k] = values[order[i][k]];
+}
+
+/* end of file ---------------------------------------------------------------*/